@@ -24,6 +24,7 @@
 
 #include "asset_loading/Sheet.h"
 #include "asset_loading/Animations.h"
+#include "asset_loading/CompiledAssets.h"
 #include "asset_loading/AnimationUpdater.h"
 
 
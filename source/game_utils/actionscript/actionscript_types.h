@@ -24,6 +24,7 @@
 
 #include "../../types.h"
 #include "../../utils/smartptr/csmartptr.h"
+#include "../../utils/string/cnameid.h"
 
 namespace as { 
 
@@ -31,6 +32,7 @@ namespace as {
 	typedef double			Number;
 	typedef std::string		String;
 	typedef types::vector2	Point;
+	typedef ceng::CNameId	NameId;
 	
 	#define _Ptr( x ) ceng::CSmartPtr< x >
 	#define _PtrRef( x ) const ceng::CSmartPtr< x >&
@@ -21,6 +21,8 @@
 
 #include "Animations.h"
 
+#include <algorithm>
+
 namespace as {
 //-----------------------------------------------------------------------------
 namespace impl  {
@@ -188,7 +190,12 @@ void Animation::Clear()
 	markers.clear();
 
 	for( std::size_t i = 0; i < parts.size(); ++i )
+	{
+		if( parts[ i ] && framesBorrowed )
+			parts[ i ]->frames.clear();
+
 		delete parts[ i ];
+	}
 
 	parts.clear();
 }
@@ -239,32 +246,106 @@ Marker* Animation::FindMarkerForFrame( int frame )
 
 void Animations::Clear()
 {
+	for( std::size_t i = 0; i < animations.size(); ++i )
+		delete animations[ i ];
+
+	animations.clear();
+	mFrameStorage.clear();
+	RebuildIndex();
 }
 
 void Animations::Serialize( ceng::CXmlFileSys* filesys )
 {
+	if( filesys->IsReading() )
+		Clear();
 
 	impl::VectorSerializer< impl::Animation > serialize_helper( animations, "Animation" );
 	serialize_helper.Serialize( filesys );
+
+	if( filesys->IsReading() )
+		RebuildIndex();
 }
 
 void Animations::BitSerialize( network_utils::ISerializer* serializer )
 {
+	if( serializer->IsLoading() )
+		Clear();
+
 	impl::VectorBitSerializer< impl::Animation > serialize_helper( animations, "Animation" );
 	serialize_helper.BitSerialize( serializer );
+
+	if( serializer->IsLoading() )
+		RebuildIndex();
 }
 
 
 impl::Animation* Animations::GetAnimation( const std::string& name )
 {
+	if( mIndexedCount != animations.size() )
+		RebuildIndex();
+
+	const NameId id = NameId::Find( name );
+	return id.Empty() ? NULL : GetAnimation( id );
+}
+
+impl::Animation* Animations::GetAnimation( const NameId& name )
+{
+	if( mIndexedCount != animations.size() )
+		RebuildIndex();
+
+	impl::Animation** result = mIndex.FindValue( name );
+	return result ? *result : NULL;
+}
+
+void Animations::AddAnimation( impl::Animation* animation )
+{
+	if( animation == NULL )
+		return;
+
+	if( mIndexedCount != animations.size() )
+		RebuildIndex();
+
+	animations.push_back( animation );
+	mIndex.Insert( NameId( animation->name ), animation );
+	mIndexedCount = animations.size();
+}
+
+bool Animations::RemoveAnimation( const NameId& name )
+{
+	impl::Animation* animation = GetAnimation( name );
+	if( animation == NULL )
+		return false;
+
+	animations.erase( std::find( animations.begin(), animations.end(), animation ) );
+
+	// the frames of a compiled one stay in mFrameStorage until Clear()
+	delete animation;
+	RebuildIndex();
+	return true;
+}
+
+bool Animations::RenameAnimation( const NameId& name, const NameId& new_name )
+{
+	impl::Animation* animation = GetAnimation( name );
+	if( animation == NULL )
+		return false;
+
+	animation->name = new_name.GetString();
+	RebuildIndex();
+	return true;
+}
+
+void Animations::RebuildIndex()
+{
+	mIndex.Clear();
+	mIndex.Reserve( (unsigned int)animations.size() );
 	for( std::size_t i = 0; i < animations.size(); ++i )
 	{
-		if( animations[ i ] && 
-			animations[ i ]->name == name )
-			return animations[i];
+		if( animations[ i ] )
+			mIndex.Insert( NameId( animations[ i ]->name ), animations[ i ] );
 	}
 
-	return NULL;
+	mIndexedCount = animations.size();
 }
 
 //=============================================================================
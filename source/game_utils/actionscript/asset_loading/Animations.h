@@ -131,7 +131,8 @@ struct Animation
 		name(),
 		mask(),
 		frameCount( 0 ),
-		loopStartIndex( -1 )
+		loopStartIndex( -1 ),
+		framesBorrowed( false )
 	{ }
 
 	Animation( const std::string& name, int frameCount, int loopStartIndex ) : 
@@ -140,7 +141,8 @@ struct Animation
 		name( name ), 
 		mask(),
 		frameCount( frameCount ), 
-		loopStartIndex( loopStartIndex ) 
+		loopStartIndex( loopStartIndex ),
+		framesBorrowed( false )
 	{ }
 
 	~Animation() { Clear(); }
@@ -167,6 +169,10 @@ struct Animation
 	std::string mask;
 	int frameCount;
 	int loopStartIndex;
+
+	// the frames of the parts point into Animations::mFrameStorage, so they
+	// aren't deleted with the parts
+	bool framesBorrowed;
 };
 
 }
@@ -177,7 +183,7 @@ class Animations
 {
 public:
 
-	Animations() { }
+	Animations() : animations(), mFrameStorage(), mIndex(), mIndexedCount( 0 ) { }
 	~Animations() { Clear(); }
 
 	void Clear();
@@ -185,10 +191,30 @@ public:
 	void Serialize( ceng::CXmlFileSys* filesys );
 	void BitSerialize( network_utils::ISerializer* serializer );
 
+	// doesn't intern the name, one that isn't interned can't be in the index
 	impl::Animation* GetAnimation( const std::string& name );
+	impl::Animation* GetAnimation( const NameId& name );
+
+	// these keep the name index up to date. If you change animations directly
+	// call RebuildIndex() afterwards. Adding or removing is noticed anyway,
+	// renaming or replacing isn't
+	void AddAnimation( impl::Animation* animation );
+	bool RemoveAnimation( const NameId& name );
+	bool RenameAnimation( const NameId& name, const NameId& new_name );
+	void RebuildIndex();
 
 
 	std::vector< impl::Animation* > animations;
+
+	// when loaded from a compiled file all the frames live here in one block
+	// and the parts of those animations only point into it. Has to stay
+	// around until they're gone, Clear() frees it
+	std::vector< impl::Frame > mFrameStorage;
+
+private:
+	// the first one wins on duplicates
+	ceng::CFlatHashMap< NameId, impl::Animation* >	mIndex;
+	std::size_t										mIndexedCount;
 };
 
 //-----------------------------------------------------------------------------
@@ -0,0 +1,658 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include "CompiledAssets.h"
+#include "Sheet.h"
+#include "Animations.h"
+
+#include <fstream>
+#include <string.h>
+
+#include "../../../utils/filesystem/filesystem.h"
+#include "../../../utils/filesystem/cmemorymappedfile.h"
+
+namespace as {
+namespace impl {
+namespace {
+
+// bump this when any of the records below change, the old files will then
+// be treated as stale
+const unsigned int COMPILED_VERSION = 2;
+const unsigned int COMPILED_BYTE_ORDER = 0x01020304;
+
+// the records are written as they are, so all the fields have to be 4 bytes
+typedef char CompiledIntSizeCheck[ ( sizeof( int ) == 4 && sizeof( float ) == 4 ) ? 1 : -1 ];
+
+//-----------------------------------------------------------------------------
+
+struct SectionRecord
+{
+	unsigned int offset;
+	unsigned int count;
+};
+
+enum
+{
+	SECTION_STRINGS = 0,
+	SECTION_1,
+	SECTION_2,
+	SECTION_3,
+	SECTION_4,
+	SECTION_COUNT
+};
+
+struct HeaderRecord
+{
+	char			magic[ 4 ];
+	unsigned int	version;
+	unsigned int	byte_order;
+	unsigned int	source_size;
+	unsigned int	source_time;
+	unsigned int	file_size;
+	SectionRecord	sections[ SECTION_COUNT ];
+};
+
+struct StringRecord
+{
+	unsigned int offset;
+	unsigned int length;
+};
+
+// sheets.xml
+struct SheetRecord
+{
+	StringRecord	name;
+	unsigned int	first_texture;
+	unsigned int	texture_count;
+};
+
+struct TextureRecord
+{
+	StringRecord	filename;
+	StringRecord	name;
+	StringRecord	atlas;
+	float			registration_x;
+	float			registration_y;
+	int				frame_count;
+	int				columns;
+	int				frame_height;
+	int				frame_width;
+	int				mask;
+	int				width;
+	int				height;
+	float			left;
+	float			top;
+	float			right;
+	float			bottom;
+	float			x;
+	float			y;
+};
+
+// animations.xml
+struct AnimationRecord
+{
+	StringRecord	name;
+	StringRecord	mask;
+	int				frame_count;
+	int				loop_start_index;
+	unsigned int	first_marker;
+	unsigned int	marker_count;
+	unsigned int	first_part;
+	unsigned int	part_count;
+};
+
+struct MarkerRecord
+{
+	StringRecord	name;
+	int				frame;
+};
+
+struct PartRecord
+{
+	StringRecord	name;
+	unsigned int	first_frame;
+	unsigned int	frame_count;
+};
+
+// the frames of a part are in index order, holes have index -1
+struct FrameRecord
+{
+	int		index;
+	int		visible;
+	float	x;
+	float	y;
+	float	scale_x;
+	float	scale_y;
+	float	rotation;
+	float	alpha;
+};
+
+const char SHEET_MAGIC[ 4 ] = { 'P', 'S', 'H', 'T' };
+const char ANIMATIONS_MAGIC[ 4 ] = { 'P', 'A', 'N', 'M' };
+
+enum { SHEET_SHEETS = SECTION_1, SHEET_TEXTURES = SECTION_2 };
+enum { ANIMATIONS_ANIMATIONS = SECTION_1, ANIMATIONS_MARKERS = SECTION_2, ANIMATIONS_PARTS = SECTION_3, ANIMATIONS_FRAMES = SECTION_4 };
+
+//=============================================================================
+
+void GetSourceStamp( const std::string& xml_file, unsigned int& size, unsigned int& time )
+{
+	size = 0;
+	time = 0;
+	if( xml_file.empty() || ceng::DoesExist( xml_file ) == false )
+		return;
+
+	size = (unsigned int)ceng::ReadFileSize( xml_file );
+	time = ceng::GetFileModificationTime( xml_file );
+}
+
+//=============================================================================
+
+class CCompiledWriter
+{
+public:
+	CCompiledWriter( const char* magic ) : mStrings(), mSections()
+	{
+		memset( &mHeader, 0, sizeof( mHeader ) );
+		memcpy( mHeader.magic, magic, sizeof( mHeader.magic ) );
+		mHeader.version = COMPILED_VERSION;
+		mHeader.byte_order = COMPILED_BYTE_ORDER;
+	}
+
+	StringRecord AddString( const std::string& str )
+	{
+		StringRecord result;
+		result.offset = (unsigned int)mStrings.size();
+		result.length = (unsigned int)str.size();
+		mStrings += str;
+		return result;
+	}
+
+	template< class T >
+	void SetSection( int section, const std::vector< T >& records )
+	{
+		mHeader.sections[ section ].count = (unsigned int)records.size();
+		if( records.empty() == false )
+			mSections[ section ].assign( (const char*)&records[ 0 ], records.size() * sizeof( T ) );
+	}
+
+	bool Write( const std::string& xml_file, const std::string& compiled_file )
+	{
+		GetSourceStamp( xml_file, mHeader.source_size, mHeader.source_time );
+
+		mHeader.sections[ SECTION_STRINGS ].count = (unsigned int)mStrings.size();
+		mSections[ SECTION_STRINGS ] = mStrings;
+
+		// the strings are last so the records stay aligned
+		unsigned int offset = sizeof( HeaderRecord );
+		for( int i = SECTION_1; i < SECTION_COUNT; ++i )
+		{
+			mHeader.sections[ i ].offset = offset;
+			offset += (unsigned int)mSections[ i ].size();
+		}
+		mHeader.sections[ SECTION_STRINGS ].offset = offset;
+		offset += (unsigned int)mSections[ SECTION_STRINGS ].size();
+		mHeader.file_size = offset;
+
+		std::ofstream file( compiled_file.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+		if( file.is_open() == false )
+			return false;
+
+		file.write( (const char*)&mHeader, sizeof( mHeader ) );
+		for( int i = SECTION_1; i < SECTION_COUNT; ++i )
+			file.write( mSections[ i ].data(), mSections[ i ].size() );
+		file.write( mSections[ SECTION_STRINGS ].data(), mSections[ SECTION_STRINGS ].size() );
+
+		return file.good();
+	}
+
+private:
+	HeaderRecord	mHeader;
+	std::string		mStrings;
+	std::string		mSections[ SECTION_COUNT ];
+};
+
+//=============================================================================
+
+class CCompiledReader
+{
+public:
+	CCompiledReader() : mFile(), mHeader( NULL ) { }
+
+	// record_sizes has the size of one record for each section after the strings
+	bool Open( const char* magic, const unsigned int* record_sizes, const std::string& compiled_file, const std::string& xml_file )
+	{
+		if( mFile.Open( compiled_file ) == false )
+			return false;
+
+		if( mFile.GetSize() < sizeof( HeaderRecord ) )
+			return false;
+
+		mHeader = (const HeaderRecord*)mFile.GetData();
+		if( memcmp( mHeader->magic, magic, sizeof( mHeader->magic ) ) != 0 ||
+			mHeader->version != COMPILED_VERSION ||
+			mHeader->byte_order != COMPILED_BYTE_ORDER ||
+			mHeader->file_size != mFile.GetSize() )
+			return false;
+
+		if( xml_file.empty() == false && ceng::DoesExist( xml_file ) )
+		{
+			unsigned int size = 0;
+			unsigned int time = 0;
+			GetSourceStamp( xml_file, size, time );
+			if( size != mHeader->source_size || time != mHeader->source_time )
+				return false;
+		}
+
+		// every section has to be inside the file, after this only the
+		// indexes have to be checked against the counts
+		for( int i = 0; i < SECTION_COUNT; ++i )
+		{
+			const unsigned int record_size = ( i == SECTION_STRINGS ) ? 1 : record_sizes[ i - 1 ];
+			const SectionRecord& section = mHeader->sections[ i ];
+			if( section.offset > mFile.GetSize() )
+				return false;
+
+			if( section.count > 0 &&
+				( record_size == 0 || section.count > ( mFile.GetSize() - section.offset ) / record_size ) )
+				return false;
+		}
+
+		return true;
+	}
+
+	unsigned int GetCount( int section ) const { return mHeader->sections[ section ].count; }
+
+	template< class T >
+	const T* GetSection( int section ) const
+	{
+		return (const T*)( mFile.GetData() + mHeader->sections[ section ].offset );
+	}
+
+	bool IsValid( const StringRecord& str ) const
+	{
+		const unsigned int size = GetCount( SECTION_STRINGS );
+		return str.offset <= size && str.length <= size - str.offset;
+	}
+
+	bool IsValid( unsigned int first, unsigned int count, int section ) const
+	{
+		const unsigned int size = GetCount( section );
+		return first <= size && count <= size - first;
+	}
+
+	void GetString( const StringRecord& str, std::string& result ) const
+	{
+		result.assign( GetSection< char >( SECTION_STRINGS ) + str.offset, str.length );
+	}
+
+private:
+	ceng::CMemoryMappedFile	mFile;
+	const HeaderRecord*		mHeader;
+};
+
+} // end of anonymous namespace
+} // end of namespace impl
+
+//=============================================================================
+
+std::string GetCompiledAssetFilename( const std::string& xml_file )
+{
+	return xml_file + ".bin";
+}
+
+//-----------------------------------------------------------------------------
+
+bool CompileSheet( const Sheet& sheet, const std::string& xml_file, const std::string& compiled_file )
+{
+	using namespace impl;
+
+	CCompiledWriter writer( SHEET_MAGIC );
+	std::vector< SheetRecord > sheets( sheet.mTextureSheets.size() );
+	std::vector< TextureRecord > textures;
+
+	for( std::size_t i = 0; i < sheet.mTextureSheets.size(); ++i )
+	{
+		const impl::TextureSheet& s = sheet.mTextureSheets[ i ];
+		sheets[ i ].name = writer.AddString( s.name );
+		sheets[ i ].first_texture = (unsigned int)textures.size();
+		sheets[ i ].texture_count = (unsigned int)s.mTextures.size();
+
+		for( std::size_t j = 0; j < s.mTextures.size(); ++j )
+		{
+			const impl::Texture& t = s.mTextures[ j ];
+			TextureRecord r;
+			r.filename = writer.AddString( t.filename );
+			r.name = writer.AddString( t.name );
+			r.atlas = writer.AddString( t.atlas );
+			r.registration_x = t.registrationPoint.x;
+			r.registration_y = t.registrationPoint.y;
+			r.frame_count = t.frameCount;
+			r.columns = t.columns;
+			r.frame_height = t.frameHeight;
+			r.frame_width = t.frameWidth;
+			r.mask = t.mask ? 1 : 0;
+			r.width = t.width;
+			r.height = t.height;
+			r.left = t.left;
+			r.top = t.top;
+			r.right = t.right;
+			r.bottom = t.bottom;
+			r.x = t.x;
+			r.y = t.y;
+			textures.push_back( r );
+		}
+	}
+
+	writer.SetSection( SHEET_SHEETS, sheets );
+	writer.SetSection( SHEET_TEXTURES, textures );
+	return writer.Write( xml_file, compiled_file );
+}
+
+//-----------------------------------------------------------------------------
+
+bool CompileAnimations( const Animations& animations, const std::string& xml_file, const std::string& compiled_file )
+{
+	using namespace impl;
+
+	CCompiledWriter writer( ANIMATIONS_MAGIC );
+	std::vector< AnimationRecord > anims;
+	std::vector< MarkerRecord > markers;
+	std::vector< PartRecord > parts;
+	std::vector< FrameRecord > frames;
+
+	for( std::size_t i = 0; i < animations.animations.size(); ++i )
+	{
+		const impl::Animation* a = animations.animations[ i ];
+		if( a == NULL )
+			continue;
+
+		AnimationRecord ar;
+		ar.name = writer.AddString( a->name );
+		ar.mask = writer.AddString( a->mask );
+		ar.frame_count = a->frameCount;
+		ar.loop_start_index = a->loopStartIndex;
+		ar.first_marker = (unsigned int)markers.size();
+		ar.first_part = (unsigned int)parts.size();
+
+		for( std::size_t j = 0; j < a->markers.size(); ++j )
+		{
+			if( a->markers[ j ] == NULL )
+				continue;
+
+			MarkerRecord mr;
+			mr.name = writer.AddString( a->markers[ j ]->name );
+			mr.frame = a->markers[ j ]->frame;
+			markers.push_back( mr );
+		}
+
+		for( std::size_t j = 0; j < a->parts.size(); ++j )
+		{
+			const impl::Part* p = a->parts[ j ];
+			if( p == NULL )
+				continue;
+
+			PartRecord pr;
+			pr.name = writer.AddString( p->name );
+			pr.first_frame = (unsigned int)frames.size();
+			pr.frame_count = (unsigned int)p->frames.size();
+			parts.push_back( pr );
+
+			for( std::size_t k = 0; k < p->frames.size(); ++k )
+			{
+				const impl::Frame* f = p->frames[ k ];
+				FrameRecord fr;
+				memset( &fr, 0, sizeof( fr ) );
+				fr.index = -1;
+				if( f )
+				{
+					fr.index = (int)k;
+					fr.visible = f->visible ? 1 : 0;
+					fr.x = f->pos.x;
+					fr.y = f->pos.y;
+					fr.scale_x = f->scale.x;
+					fr.scale_y = f->scale.y;
+					fr.rotation = f->rotation;
+					fr.alpha = f->alpha;
+				}
+				frames.push_back( fr );
+			}
+		}
+
+		ar.marker_count = (unsigned int)markers.size() - ar.first_marker;
+		ar.part_count = (unsigned int)parts.size() - ar.first_part;
+		anims.push_back( ar );
+	}
+
+	writer.SetSection( ANIMATIONS_ANIMATIONS, anims );
+	writer.SetSection( ANIMATIONS_MARKERS, markers );
+	writer.SetSection( ANIMATIONS_PARTS, parts );
+	writer.SetSection( ANIMATIONS_FRAMES, frames );
+	return writer.Write( xml_file, compiled_file );
+}
+
+//=============================================================================
+
+bool LoadCompiledSheet( Sheet& sheet, const std::string& compiled_file, const std::string& xml_file )
+{
+	using namespace impl;
+
+	const unsigned int record_sizes[] = { sizeof( SheetRecord ), sizeof( TextureRecord ), 0, 0 };
+	CCompiledReader reader;
+	if( reader.Open( SHEET_MAGIC, record_sizes, compiled_file, xml_file ) == false )
+		return false;
+
+	const unsigned int sheet_count = reader.GetCount( SHEET_SHEETS );
+	const unsigned int texture_count = reader.GetCount( SHEET_TEXTURES );
+	const SheetRecord* sheets = reader.GetSection< SheetRecord >( SHEET_SHEETS );
+	const TextureRecord* textures = reader.GetSection< TextureRecord >( SHEET_TEXTURES );
+
+	// everything is checked first, so a broken file doesn't leave a half
+	// loaded sheet behind
+	for( unsigned int i = 0; i < sheet_count; ++i )
+	{
+		if( reader.IsValid( sheets[ i ].name ) == false ||
+			reader.IsValid( sheets[ i ].first_texture, sheets[ i ].texture_count, SHEET_TEXTURES ) == false )
+			return false;
+	}
+
+	for( unsigned int i = 0; i < texture_count; ++i )
+	{
+		if( reader.IsValid( textures[ i ].filename ) == false ||
+			reader.IsValid( textures[ i ].name ) == false ||
+			reader.IsValid( textures[ i ].atlas ) == false )
+			return false;
+	}
+
+	std::vector< impl::TextureSheet > result( sheet_count );
+	for( unsigned int i = 0; i < sheet_count; ++i )
+	{
+		reader.GetString( sheets[ i ].name, result[ i ].name );
+		result[ i ].mTextures.resize( sheets[ i ].texture_count );
+
+		for( unsigned int j = 0; j < sheets[ i ].texture_count; ++j )
+		{
+			const TextureRecord& r = textures[ sheets[ i ].first_texture + j ];
+			impl::Texture& t = result[ i ].mTextures[ j ];
+			reader.GetString( r.filename, t.filename );
+			reader.GetString( r.name, t.name );
+			reader.GetString( r.atlas, t.atlas );
+			t.registrationPoint.x = r.registration_x;
+			t.registrationPoint.y = r.registration_y;
+			t.frameCount = r.frame_count;
+			t.columns = r.columns;
+			t.frameHeight = r.frame_height;
+			t.frameWidth = r.frame_width;
+			t.mask = ( r.mask != 0 );
+			t.width = r.width;
+			t.height = r.height;
+			t.left = r.left;
+			t.top = r.top;
+			t.right = r.right;
+			t.bottom = r.bottom;
+			t.x = r.x;
+			t.y = r.y;
+		}
+	}
+
+	sheet.mTextureSheets.swap( result );
+	sheet.RebuildIndex();
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool LoadCompiledAnimations( Animations& animations, const std::string& compiled_file, const std::string& xml_file )
+{
+	using namespace impl;
+
+	const unsigned int record_sizes[] = { sizeof( AnimationRecord ), sizeof( MarkerRecord ), sizeof( PartRecord ), sizeof( FrameRecord ) };
+	CCompiledReader reader;
+	if( reader.Open( ANIMATIONS_MAGIC, record_sizes, compiled_file, xml_file ) == false )
+		return false;
+
+	const unsigned int animation_count = reader.GetCount( ANIMATIONS_ANIMATIONS );
+	const unsigned int marker_count = reader.GetCount( ANIMATIONS_MARKERS );
+	const unsigned int part_count = reader.GetCount( ANIMATIONS_PARTS );
+	const unsigned int frame_count = reader.GetCount( ANIMATIONS_FRAMES );
+	const AnimationRecord* anims = reader.GetSection< AnimationRecord >( ANIMATIONS_ANIMATIONS );
+	const MarkerRecord* markers = reader.GetSection< MarkerRecord >( ANIMATIONS_MARKERS );
+	const PartRecord* parts = reader.GetSection< PartRecord >( ANIMATIONS_PARTS );
+	const FrameRecord* frames = reader.GetSection< FrameRecord >( ANIMATIONS_FRAMES );
+
+	for( unsigned int i = 0; i < animation_count; ++i )
+	{
+		if( reader.IsValid( anims[ i ].name ) == false ||
+			reader.IsValid( anims[ i ].mask ) == false ||
+			reader.IsValid( anims[ i ].first_marker, anims[ i ].marker_count, ANIMATIONS_MARKERS ) == false ||
+			reader.IsValid( anims[ i ].first_part, anims[ i ].part_count, ANIMATIONS_PARTS ) == false )
+			return false;
+	}
+
+	for( unsigned int i = 0; i < marker_count; ++i )
+	{
+		if( reader.IsValid( markers[ i ].name ) == false )
+			return false;
+	}
+
+	for( unsigned int i = 0; i < part_count; ++i )
+	{
+		if( reader.IsValid( parts[ i ].name ) == false ||
+			reader.IsValid( parts[ i ].first_frame, parts[ i ].frame_count, ANIMATIONS_FRAMES ) == false )
+			return false;
+	}
+
+	animations.Clear();
+
+	// all the frames go to one block, the parts point into it
+	animations.mFrameStorage.resize( frame_count );
+	for( unsigned int i = 0; i < frame_count; ++i )
+	{
+		impl::Frame& f = animations.mFrameStorage[ i ];
+		f.index = frames[ i ].index;
+		f.visible = ( frames[ i ].visible != 0 );
+		f.pos.x = frames[ i ].x;
+		f.pos.y = frames[ i ].y;
+		f.scale.x = frames[ i ].scale_x;
+		f.scale.y = frames[ i ].scale_y;
+		f.rotation = frames[ i ].rotation;
+		f.alpha = frames[ i ].alpha;
+	}
+
+	std::string name;
+	animations.animations.resize( animation_count );
+	for( unsigned int i = 0; i < animation_count; ++i )
+	{
+		const AnimationRecord& ar = anims[ i ];
+		reader.GetString( ar.name, name );
+
+		impl::Animation* a = new impl::Animation( name, ar.frame_count, ar.loop_start_index );
+		a->framesBorrowed = true;
+		reader.GetString( ar.mask, a->mask );
+
+		a->markers.resize( ar.marker_count );
+		for( unsigned int j = 0; j < ar.marker_count; ++j )
+		{
+			const MarkerRecord& mr = markers[ ar.first_marker + j ];
+			reader.GetString( mr.name, name );
+			a->markers[ j ] = new impl::Marker( name, mr.frame );
+		}
+
+		a->parts.resize( ar.part_count );
+		for( unsigned int j = 0; j < ar.part_count; ++j )
+		{
+			const PartRecord& pr = parts[ ar.first_part + j ];
+			reader.GetString( pr.name, name );
+
+			impl::Part* p = new impl::Part( name );
+			p->frames.resize( pr.frame_count );
+			for( unsigned int k = 0; k < pr.frame_count; ++k )
+			{
+				impl::Frame* f = &animations.mFrameStorage[ pr.first_frame + k ];
+				p->frames[ k ] = ( f->index < 0 ) ? NULL : f;
+			}
+
+			a->parts[ j ] = p;
+		}
+
+		animations.animations[ i ] = a;
+	}
+
+	animations.RebuildIndex();
+	return true;
+}
+
+//=============================================================================
+
+void LoadSheet( Sheet& sheet, const std::string& xml_file, bool compile )
+{
+	const std::string compiled_file = GetCompiledAssetFilename( xml_file );
+	if( LoadCompiledSheet( sheet, compiled_file, xml_file ) )
+		return;
+
+	ceng::XmlLoadFromFile( sheet, xml_file, "Sheets" );
+
+	if( compile && ceng::DoesExist( xml_file ) )
+	{
+		if( CompileSheet( sheet, xml_file, compiled_file ) == false )
+			logger << "LoadSheet() - Couldn't write compiled file: " << compiled_file << std::endl;
+	}
+}
+
+void LoadAnimations( Animations& animations, const std::string& xml_file, bool compile )
+{
+	const std::string compiled_file = GetCompiledAssetFilename( xml_file );
+	if( LoadCompiledAnimations( animations, compiled_file, xml_file ) )
+		return;
+
+	ceng::XmlLoadFromFile( animations, xml_file, "Animations" );
+
+	if( compile && ceng::DoesExist( xml_file ) )
+	{
+		if( CompileAnimations( animations, xml_file, compiled_file ) == false )
+			logger << "LoadAnimations() - Couldn't write compiled file: " << compiled_file << std::endl;
+	}
+}
+
+//=============================================================================
+
+} // end of namespace as
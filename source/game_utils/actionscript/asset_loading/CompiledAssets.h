@@ -0,0 +1,78 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Compiled assets
+// ===============
+//
+// Binary versions of the sheets.xml and animations.xml files. Parsing the
+// xml is most of the load time for the big sheets, so the build step writes
+// the same data out as flat records: a header, arrays of fixed size records
+// that refer to each other by index, and a string table.
+//
+// At runtime the compiled file is memory mapped and copied into arrays that
+// are sized from the header, so there's no growing or per node parsing.
+//
+// The header remembers the size and the modification time of the xml it was
+// compiled from. If the xml has changed since, or the format version doesn't
+// match, the compiled file is considered stale and LoadSheet() /
+// LoadAnimations() fall back to the xml (and recompile it, if asked to).
+// If the xml file is not there at all, the compiled one is trusted, so a
+// release build can ship without the xml.
+//
+//.............................................................................
+//=============================================================================
+#ifndef INC_COMPILEDASSETS_H
+#define INC_COMPILEDASSETS_H
+
+#include <string>
+
+namespace as {
+
+class Sheet;
+class Animations;
+
+//-----------------------------------------------------------------------------
+
+// "data/sheets.xml" -> "data/sheets.xml.bin"
+std::string GetCompiledAssetFilename( const std::string& xml_file );
+
+// the build step, writes a compiled file stamped with the xml_file
+bool CompileSheet( const Sheet& sheet, const std::string& xml_file, const std::string& compiled_file );
+bool CompileAnimations( const Animations& animations, const std::string& xml_file, const std::string& compiled_file );
+
+// returns false if the compiled file is missing, broken or older than the
+// xml_file. xml_file can be empty, then the staleness check is skipped
+bool LoadCompiledSheet( Sheet& sheet, const std::string& compiled_file, const std::string& xml_file );
+bool LoadCompiledAnimations( Animations& animations, const std::string& compiled_file, const std::string& xml_file );
+
+// loads the compiled version if it's up to date, otherwise parses the xml
+// and if compile is set writes out a fresh compiled file for the next time
+void LoadSheet( Sheet& sheet, const std::string& xml_file, bool compile = true );
+void LoadAnimations( Animations& animations, const std::string& xml_file, bool compile = true );
+
+//-----------------------------------------------------------------------------
+
+} // end of namespace as
+
+#endif
@@ -195,6 +195,7 @@ namespace impl {
 class Sheet
 {
 public:
+	Sheet() : mDataPath(), mTextureSheets(), mIndex(), mIndexedCount( 0 ) { }
 
 
 	Sprite* LoadSprite( const std::string& name, bool use_atlas )
@@ -229,6 +230,8 @@ public:
 					mTextureSheets.push_back( texture );
 				}
 			}
+
+			RebuildIndex();
 		}
 	}
 
@@ -246,22 +249,83 @@ public:
 		{
 			mTextureSheets[ i ].BitSerialize( serializer );
 		}
+
+		if( serializer->IsLoading() )
+			RebuildIndex();
 	}
 
+	// this is probably bad idea to return a reference to a container object, but...
 	impl::TextureSheet* FindTextureSheet( const std::string& name )
 	{
-		// this is probably bad idea to return a reference to a container object, but...
+		// doesn't intern the name, one that isn't interned can't be in the index
+		if( mIndexedCount != mTextureSheets.size() )
+			RebuildIndex();
+
+		const NameId id = NameId::Find( name );
+		return id.Empty() ? NULL : FindTextureSheet( id );
+	}
+
+	impl::TextureSheet* FindTextureSheet( const NameId& name )
+	{
+		if( mIndexedCount != mTextureSheets.size() )
+			RebuildIndex();
+
+		const int* i = mIndex.FindValue( name );
+		return i ? &( mTextureSheets[ *i ] ) : NULL;
+	}
+
+	// these keep the name index up to date. If you change mTextureSheets
+	// directly call RebuildIndex() afterwards. Adding or removing sheets is
+	// noticed anyway, renaming or replacing them isn't
+	void AddTextureSheet( const impl::TextureSheet& sheet )
+	{
+		if( mIndexedCount != mTextureSheets.size() )
+			RebuildIndex();
+
+		mTextureSheets.push_back( sheet );
+		mIndex.Insert( NameId( sheet.name ), (int)mTextureSheets.size() - 1 );
+		mIndexedCount = mTextureSheets.size();
+	}
+
+	bool RemoveTextureSheet( const NameId& name )
+	{
+		impl::TextureSheet* sheet = FindTextureSheet( name );
+		if( sheet == NULL )
+			return false;
+
+		mTextureSheets.erase( mTextureSheets.begin() + ( sheet - &mTextureSheets[ 0 ] ) );
+		RebuildIndex();
+		return true;
+	}
+
+	bool RenameTextureSheet( const NameId& name, const NameId& new_name )
+	{
+		impl::TextureSheet* sheet = FindTextureSheet( name );
+		if( sheet == NULL )
+			return false;
+
+		sheet->name = new_name.GetString();
+		RebuildIndex();
+		return true;
+	}
+
+	void RebuildIndex()
+	{
+		mIndex.Clear();
+		mIndex.Reserve( (unsigned int)mTextureSheets.size() );
 		for( std::size_t i = 0; i < mTextureSheets.size(); ++i )
-		{
-			if( mTextureSheets[i].name == name ) 
-				return &(mTextureSheets[i]);
-		}
+			mIndex.Insert( NameId( mTextureSheets[ i ].name ), (int)i );
 
-		return NULL;
+		mIndexedCount = mTextureSheets.size();
 	}
 
 	std::string mDataPath;
 	std::vector< impl::TextureSheet > mTextureSheets;
+
+private:
+	// name -> position in mTextureSheets, the first one wins on duplicates
+	ceng::CFlatHashMap< NameId, int >	mIndex;
+	std::size_t							mIndexedCount;
 };
 
 //=============================================================================
@@ -19,6 +19,8 @@
  ***************************************************************************/
 
 
+#include <sstream>
+
 #include "../Animations.h"
 #include "../../../../utils/debug.h"
 
@@ -37,6 +39,48 @@ int AnimationsTest()
 
 TEST_REGISTER( AnimationsTest );
 
+int AnimationsIndexTest()
+{
+	Animations test;
+	for( int i = 0; i < 100; ++i )
+	{
+		std::stringstream ss;
+		ss << "anim_" << i;
+		test.AddAnimation( new impl::Animation( ss.str(), 1, -1 ) );
+	}
+
+	test_assert( test.GetAnimation( "anim_0" ) == test.animations[ 0 ] );
+	test_assert( test.GetAnimation( "anim_99" ) == test.animations[ 99 ] );
+	test_assert( test.GetAnimation( "anim_100" ) == NULL );
+
+	// looking up a name that was never seen doesn't intern it
+	const unsigned int interned = ceng::CNameId::GetInternedCount();
+	test_assert( test.GetAnimation( "never_an_animation_name" ) == NULL );
+	test_assert( ceng::CNameId::GetInternedCount() == interned );
+
+	test_assert( test.RemoveAnimation( NameId( "anim_10" ) ) );
+	test_assert( test.RemoveAnimation( NameId( "anim_10" ) ) == false );
+	test_assert( test.GetAnimation( "anim_10" ) == NULL );
+	test_assert( test.animations.size() == 99 );
+
+	test_assert( test.RenameAnimation( NameId( "anim_11" ), NameId( "renamed" ) ) );
+	test_assert( test.GetAnimation( "anim_11" ) == NULL );
+	test_assert( test.GetAnimation( "renamed" ) != NULL );
+	test_assert( test.GetAnimation( "renamed" )->name == "renamed" );
+
+	// pushing straight into the vector is noticed
+	impl::Animation* pushed = new impl::Animation( "pushed", 1, -1 );
+	test.animations.push_back( pushed );
+	test_assert( test.GetAnimation( "pushed" ) == pushed );
+
+	test.Clear();
+	test_assert( test.GetAnimation( "pushed" ) == NULL );
+
+	return 0;
+}
+
+TEST_REGISTER( AnimationsIndexTest );
+
 
 } // end of namespace test
 } // end of namespace as
@@ -0,0 +1,150 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include <fstream>
+#include <stdio.h>
+
+#include "../CompiledAssets.h"
+#include "../Sheet.h"
+#include "../Animations.h"
+#include "../../../../utils/debug.h"
+#include "../../../../tester/tester_benchmark.h"
+
+#ifdef PORO_TESTER_ENABLED
+namespace as {
+namespace test {
+
+namespace {
+
+	const int bench_sheets = 50;
+	const int bench_textures_per_sheet = 20;
+
+	const int bench_animations = 20;
+	const int bench_parts_per_animation = 10;
+	const int bench_frames_per_part = 60;
+
+	// XmlSaveToFile is way too slow for files this big, so the xml is
+	// written by hand
+	void WriteBigSheet( const std::string& filename )
+	{
+		std::ofstream file( filename.c_str(), std::ios::out | std::ios::trunc );
+		file << "<Sheets>" << std::endl;
+		for( int i = 0; i < bench_sheets; ++i )
+		{
+			file << "  <TextureSheet name=\"sheet_" << i << "\">" << std::endl;
+			for( int j = 0; j < bench_textures_per_sheet; ++j )
+			{
+				file << "    <Texture name=\"texture_" << j << "\" path=\"sheet_" << i << "/texture_" << j << ".png\" "
+					<< "atlas=\"atlas.png\" registrationPointX=\"" << j << "\" registrationPointY=\"" << i << "\" "
+					<< "width=\"" << 32 + j << "\" height=\"" << 32 + i << "\" right=\"0.5\" bottom=\"0.5\" />" << std::endl;
+			}
+			file << "  </TextureSheet>" << std::endl;
+		}
+		file << "</Sheets>" << std::endl;
+	}
+
+	void WriteBigAnimations( const std::string& filename )
+	{
+		std::ofstream file( filename.c_str(), std::ios::out | std::ios::trunc );
+		file << "<Animations>" << std::endl;
+		for( int i = 0; i < bench_animations; ++i )
+		{
+			file << "  <Animation name=\"animation_" << i << "\" frameCount=\"" << bench_frames_per_part << "\" loopAt=\"0\">" << std::endl;
+			file << "    <Marker name=\"end\" frame=\"" << bench_frames_per_part - 1 << "\" />" << std::endl;
+			for( int j = 0; j < bench_parts_per_animation; ++j )
+			{
+				file << "    <Part name=\"part_" << j << "\">" << std::endl;
+				for( int k = 0; k < bench_frames_per_part; ++k )
+				{
+					file << "      <Frame index=\"" << k << "\" visible=\"1\" x=\"" << k << ".5\" y=\"" << j << "\" "
+						<< "scaleX=\"1\" scaleY=\"1\" rotation=\"" << k * 6 << "\" alpha=\"1\" />" << std::endl;
+				}
+				file << "    </Part>" << std::endl;
+			}
+			file << "  </Animation>" << std::endl;
+		}
+		file << "</Animations>" << std::endl;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int CompiledAssetsBenchmark()
+{
+	const std::string sheet_xml = "temp/compiled_sheet_benchmark.xml";
+	const std::string animations_xml = "temp/compiled_animations_benchmark.xml";
+
+	test_logger << "Loading " << bench_sheets * bench_textures_per_sheet << " textures" << std::endl;
+	{
+		WriteBigSheet( sheet_xml );
+		remove( GetCompiledAssetFilename( sheet_xml ).c_str() );
+
+		// the first load parses the xml and compiles it
+		poro::tester::CBenchmarkTimer timer;
+		Sheet from_xml;
+		LoadSheet( from_xml, sheet_xml );
+		poro::tester::BenchmarkReport( "xml + compile", timer.GetSeconds(), 0 );
+
+		timer.Reset();
+		Sheet compiled;
+		LoadSheet( compiled, sheet_xml );
+		poro::tester::BenchmarkReport( "compiled", timer.GetSeconds(), 0 );
+
+		test_assert( from_xml.mTextureSheets.size() == bench_sheets );
+		test_assert( compiled.mTextureSheets.size() == from_xml.mTextureSheets.size() );
+
+		remove( sheet_xml.c_str() );
+		remove( GetCompiledAssetFilename( sheet_xml ).c_str() );
+	}
+
+	test_logger << "Loading " << bench_animations * bench_parts_per_animation * bench_frames_per_part << " frames" << std::endl;
+	{
+		WriteBigAnimations( animations_xml );
+		remove( GetCompiledAssetFilename( animations_xml ).c_str() );
+
+		poro::tester::CBenchmarkTimer timer;
+		Animations from_xml;
+		LoadAnimations( from_xml, animations_xml );
+		poro::tester::BenchmarkReport( "xml + compile", timer.GetSeconds(), 0 );
+
+		timer.Reset();
+		Animations compiled;
+		LoadAnimations( compiled, animations_xml );
+		poro::tester::BenchmarkReport( "compiled", timer.GetSeconds(), 0 );
+
+		test_assert( from_xml.animations.size() == bench_animations );
+		test_assert( compiled.animations.size() == from_xml.animations.size() );
+		test_assert( compiled.mFrameStorage.size() == bench_animations * bench_parts_per_animation * bench_frames_per_part );
+
+		remove( animations_xml.c_str() );
+		remove( GetCompiledAssetFilename( animations_xml ).c_str() );
+	}
+
+	return 0;
+}
+
+BENCHMARK_REGISTER( CompiledAssetsBenchmark );
+
+} // end of namespace test
+} // end of namespace as
+
+#endif
@@ -0,0 +1,198 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include <fstream>
+#include <stdio.h>
+
+#include "../CompiledAssets.h"
+#include "../Sheet.h"
+#include "../Animations.h"
+#include "../../../../utils/debug.h"
+
+#ifdef PORO_TESTER_ENABLED
+namespace as {
+namespace test {
+
+namespace {
+
+	void WriteFile( const std::string& filename, const std::string& contents )
+	{
+		std::ofstream file( filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+		file << contents;
+	}
+
+	void MakeTestSheet( Sheet& sheet )
+	{
+		sheet.mTextureSheets.resize( 2 );
+		sheet.mTextureSheets[ 0 ].name = "player";
+		sheet.mTextureSheets[ 0 ].mTextures.resize( 2 );
+		sheet.mTextureSheets[ 0 ].mTextures[ 0 ].name = "head";
+		sheet.mTextureSheets[ 0 ].mTextures[ 0 ].filename = "player/head.png";
+		sheet.mTextureSheets[ 0 ].mTextures[ 0 ].atlas = "atlas.png";
+		sheet.mTextureSheets[ 0 ].mTextures[ 0 ].registrationPoint.Set( 3.5f, -2.f );
+		sheet.mTextureSheets[ 0 ].mTextures[ 0 ].frameCount = 4;
+		sheet.mTextureSheets[ 0 ].mTextures[ 0 ].columns = 2;
+		sheet.mTextureSheets[ 0 ].mTextures[ 0 ].mask = true;
+		sheet.mTextureSheets[ 0 ].mTextures[ 0 ].right = 0.25f;
+		sheet.mTextureSheets[ 0 ].mTextures[ 1 ].name = "body";
+		sheet.mTextureSheets[ 0 ].mTextures[ 1 ].width = 64;
+		sheet.mTextureSheets[ 0 ].mTextures[ 1 ].y = 12.f;
+		sheet.mTextureSheets[ 1 ].name = "empty";
+	}
+
+	void MakeTestAnimations( Animations& animations )
+	{
+		impl::Animation* walk = new impl::Animation( "walk", 3, 1 );
+		walk->mask = "walk_mask";
+		walk->markers.push_back( new impl::Marker( "step", 2 ) );
+
+		impl::Part* leg = new impl::Part( "leg" );
+		leg->frames.push_back( new impl::Frame( true, 1, 2, 1, 1, 0.5, 1 ) );
+		leg->frames.push_back( NULL );
+		leg->frames.push_back( new impl::Frame( false, 3, 4, 2, 2, 0, 0.5 ) );
+		leg->frames[ 0 ]->index = 0;
+		leg->frames[ 2 ]->index = 2;
+		walk->parts.push_back( leg );
+
+		animations.animations.push_back( walk );
+		animations.animations.push_back( new impl::Animation( "idle", 1, -1 ) );
+	}
+}
+
+int CompiledAssetsTest()
+{
+	const std::string sheet_xml = "temp/compiled_sheet_test.xml";
+	const std::string animations_xml = "temp/compiled_animations_test.xml";
+
+	// round trip of a sheet
+	{
+		WriteFile( sheet_xml, "<Sheets/>" );
+
+		Sheet original;
+		MakeTestSheet( original );
+		test_assert( CompileSheet( original, sheet_xml, GetCompiledAssetFilename( sheet_xml ) ) );
+
+		Sheet loaded;
+		test_assert( LoadCompiledSheet( loaded, GetCompiledAssetFilename( sheet_xml ), sheet_xml ) );
+		test_assert( loaded.mTextureSheets.size() == 2 );
+		test_assert( loaded.FindTextureSheet( "player" ) != NULL );
+		test_assert( loaded.FindTextureSheet( "empty" )->mTextures.empty() );
+
+		const impl::Texture& head = loaded.mTextureSheets[ 0 ].mTextures[ 0 ];
+		test_assert( head.name == "head" );
+		test_assert( head.filename == "player/head.png" );
+		test_assert( head.atlas == "atlas.png" );
+		test_assert( head.registrationPoint.x == 3.5f );
+		test_assert( head.registrationPoint.y == -2.f );
+		test_assert( head.frameCount == 4 );
+		test_assert( head.columns == 2 );
+		test_assert( head.mask == true );
+		test_assert( head.right == 0.25f );
+		test_assert( loaded.mTextureSheets[ 0 ].mTextures[ 1 ].width == 64 );
+		test_assert( loaded.mTextureSheets[ 0 ].mTextures[ 1 ].y == 12.f );
+
+		// the xml changes, so the compiled file is stale
+		WriteFile( sheet_xml, "<Sheets></Sheets>" );
+		test_assert( LoadCompiledSheet( loaded, GetCompiledAssetFilename( sheet_xml ), sheet_xml ) == false );
+		test_assert( loaded.mTextureSheets.size() == 2 );
+
+		// with no xml to compare to, it's trusted
+		test_assert( LoadCompiledSheet( loaded, GetCompiledAssetFilename( sheet_xml ), "" ) );
+
+		// a missing file
+		test_assert( LoadCompiledSheet( loaded, "temp/does_not_exist.bin", "" ) == false );
+
+		// a broken file
+		WriteFile( GetCompiledAssetFilename( sheet_xml ), "PSHT and then some garbage" );
+		test_assert( LoadCompiledSheet( loaded, GetCompiledAssetFilename( sheet_xml ), "" ) == false );
+
+		remove( sheet_xml.c_str() );
+		remove( GetCompiledAssetFilename( sheet_xml ).c_str() );
+	}
+
+	// round trip of animations
+	{
+		WriteFile( animations_xml, "<Animations/>" );
+
+		Animations original;
+		MakeTestAnimations( original );
+		test_assert( CompileAnimations( original, animations_xml, GetCompiledAssetFilename( animations_xml ) ) );
+
+		// the sheet magic doesn't match
+		Sheet sheet;
+		test_assert( LoadCompiledSheet( sheet, GetCompiledAssetFilename( animations_xml ), "" ) == false );
+
+		Animations loaded;
+		test_assert( LoadCompiledAnimations( loaded, GetCompiledAssetFilename( animations_xml ), animations_xml ) );
+		test_assert( loaded.animations.size() == 2 );
+		test_assert( loaded.GetAnimation( "idle" ) != NULL );
+		test_assert( loaded.GetAnimation( "idle" )->getLoops() == false );
+
+		impl::Animation* walk = loaded.GetAnimation( "walk" );
+		test_assert( walk );
+		test_assert( walk->mask == "walk_mask" );
+		test_assert( walk->frameCount == 3 );
+		test_assert( walk->loopStartIndex == 1 );
+		test_assert( walk->FindMarkerForFrame( 2 ) != NULL );
+		test_assert( walk->FindMarkerForFrame( 2 )->name == "step" );
+		test_assert( walk->parts.size() == 1 );
+
+		impl::Part* leg = walk->parts[ 0 ];
+		test_assert( leg->name == "leg" );
+		test_assert( leg->frames.size() == 3 );
+		test_assert( leg->GetFrame( 1 ) == NULL );
+		test_assert( leg->GetFrame( 0 )->visible );
+		test_assert( leg->GetFrame( 0 )->pos.y == 2.f );
+		test_assert( leg->GetFrame( 0 )->rotation == 0.5f );
+		test_assert( leg->GetFrame( 2 )->visible == false );
+		test_assert( leg->GetFrame( 2 )->alpha == 0.5f );
+		test_assert( leg->GetFrame( 2 )->index == 2 );
+
+		// loading over the frame storage
+		test_assert( LoadCompiledAnimations( loaded, GetCompiledAssetFilename( animations_xml ), animations_xml ) );
+		test_assert( loaded.animations.size() == 2 );
+
+		// added by hand after a compiled load, these frames belong to the part
+		impl::Animation* run = new impl::Animation( "run", 1, -1 );
+		run->parts.push_back( new impl::Part( "leg" ) );
+		run->parts[ 0 ]->frames.push_back( new impl::Frame );
+		loaded.AddAnimation( run );
+		test_assert( run->framesBorrowed == false );
+		test_assert( loaded.GetAnimation( "walk" )->framesBorrowed );
+		test_assert( loaded.RemoveAnimation( NameId( "walk" ) ) );
+		loaded.Clear();
+		test_assert( loaded.animations.empty() );
+
+		remove( animations_xml.c_str() );
+		remove( GetCompiledAssetFilename( animations_xml ).c_str() );
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( CompiledAssetsTest );
+
+
+} // end of namespace test
+} // end of namespace as
+
+#endif
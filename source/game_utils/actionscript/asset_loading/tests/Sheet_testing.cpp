@@ -19,6 +19,8 @@
  ***************************************************************************/
 
 
+#include <sstream>
+
 #include "../Sheet.h"
 #include "../../../../utils/debug.h"
 
@@ -37,6 +39,52 @@ int SheetTest()
 
 TEST_REGISTER( SheetTest );
 
+int SheetIndexTest()
+{
+	Sheet test;
+	for( int i = 0; i < 100; ++i )
+	{
+		impl::TextureSheet sheet;
+		std::stringstream ss;
+		ss << "sheet_" << i;
+		sheet.name = ss.str();
+		test.AddTextureSheet( sheet );
+	}
+
+	test_assert( test.FindTextureSheet( "sheet_0" ) == &test.mTextureSheets[ 0 ] );
+	test_assert( test.FindTextureSheet( "sheet_99" ) == &test.mTextureSheets[ 99 ] );
+	test_assert( test.FindTextureSheet( "sheet_100" ) == NULL );
+
+	const unsigned int interned = ceng::CNameId::GetInternedCount();
+	test_assert( test.FindTextureSheet( "never_a_sheet_name" ) == NULL );
+	test_assert( ceng::CNameId::GetInternedCount() == interned );
+
+	test_assert( test.RemoveTextureSheet( NameId( "sheet_10" ) ) );
+	test_assert( test.RemoveTextureSheet( NameId( "sheet_10" ) ) == false );
+	test_assert( test.FindTextureSheet( "sheet_10" ) == NULL );
+	test_assert( test.FindTextureSheet( "sheet_11" ) == &test.mTextureSheets[ 10 ] );
+
+	test_assert( test.RenameTextureSheet( NameId( "sheet_11" ), NameId( "renamed" ) ) );
+	test_assert( test.FindTextureSheet( "sheet_11" ) == NULL );
+	test_assert( test.FindTextureSheet( "renamed" ) == &test.mTextureSheets[ 10 ] );
+
+	// pushing straight into the vector is noticed
+	impl::TextureSheet sheet;
+	sheet.name = "pushed";
+	test.mTextureSheets.push_back( sheet );
+	test_assert( test.FindTextureSheet( "pushed" ) == &test.mTextureSheets.back() );
+
+	// renaming by hand needs a rebuild
+	test.mTextureSheets[ 0 ].name = "by_hand";
+	test.RebuildIndex();
+	test_assert( test.FindTextureSheet( "by_hand" ) == &test.mTextureSheets[ 0 ] );
+	test_assert( test.FindTextureSheet( "sheet_0" ) == NULL );
+
+	return 0;
+}
+
+TEST_REGISTER( SheetIndexTest );
+
 
 } // end of namespace test
 } // end of namespace as
@@ -50,6 +50,7 @@ void DisplayObjectContainer::addChildAt( DisplayObjectContainer* child, int inde
 	cassert( child != this );
 
 	child->SetFather( this );
+	AddChildName( child );
 
 	int pos = 0;
 	for( ChildList::iterator i = mChildren.begin(); i != mChildren.end(); ++i )
@@ -65,10 +66,62 @@ void DisplayObjectContainer::addChildAt( DisplayObjectContainer* child, int inde
 	mChildren.push_back( child );
 }
 
-std::list< DisplayObjectContainer* >& DisplayObjectContainer::GetRawChildren(){
+const std::list< DisplayObjectContainer* >& DisplayObjectContainer::GetRawChildren() const {
 	return mChildren;
 }
 
+//----
+
+DisplayObjectContainer* DisplayObjectContainer::FindChildByName( const NameId& name ) const
+{
+	if( name.Empty() )
+		return NULL;
+
+	const ceng::CFlatHashMultiMap< NameId, DisplayObjectContainer*, 1 >::List* list = mChildrenByName.Find( name );
+	if( list == NULL || list->empty() )
+		return NULL;
+
+	if( list->size() == 1 )
+		return list->front();
+
+	// more than one with the same name, the first one in the child order wins
+	for( ChildList::const_iterator i = mChildren.begin(); i != mChildren.end(); ++i )
+	{
+		if( (*i)->GetNameId() == name )
+			return *i;
+	}
+
+	return NULL;
+}
+
+void DisplayObjectContainer::SetNameId( const NameId& name )
+{
+	if( mName == name )
+		return;
+
+	if( mFather )
+		mFather->RemoveChildName( this );
+
+	mName = name;
+
+	if( mFather )
+		mFather->AddChildName( this );
+}
+
+void DisplayObjectContainer::AddChildName( DisplayObjectContainer* child )
+{
+	cassert( child );
+	if( child->GetNameId().Empty() == false )
+		mChildrenByName.Insert( child->GetNameId(), child );
+}
+
+void DisplayObjectContainer::RemoveChildName( DisplayObjectContainer* child )
+{
+	cassert( child );
+	if( child->GetNameId().Empty() == false )
+		mChildrenByName.Remove( child->GetNameId(), child );
+}
+
 //----
 void DisplayObjectContainer::getParentTree( std::vector< const DisplayObjectContainer* >& parents_tree ) const
 {
@@ -26,6 +26,7 @@
 #include <algorithm>
 
 #include "../../utils/debug.h"
+#include "../../utils/maphelper/cflathashmultimap.h"
 
 #include "eventdispatcher.h"
 
@@ -40,7 +41,7 @@ class DisplayObjectContainer : public EventDispatcher
 public:
 	typedef std::list< DisplayObjectContainer* > ChildList;
 
-	DisplayObjectContainer() : mFather( NULL ) { }
+	DisplayObjectContainer() : mFather( NULL ), mName(), mChildrenByName() { }
 	virtual ~DisplayObjectContainer() 
 	{ 
 		// this is the only case where we go up the ladder
@@ -56,7 +57,9 @@ public:
 	
 	int GetChildCount() const { return (int)mChildren.size(); }
 	
-	ChildList& GetRawChildren();
+	// read only, adding and removing goes through addChild() and removeChild()
+	// so that the name index stays in sync
+	const ChildList& GetRawChildren() const;
 
 	// warning this is a super slow method of iterationg though 
 	// children and should not be used in time critical places
@@ -77,6 +80,7 @@ public:
 		cassert( child != this );
 
 		mChildren.push_back( child );
+		AddChildName( child );
 		child->SetFather( this );
 	}
 
@@ -92,6 +96,7 @@ public:
 		
 		cassert( i != mChildren.end() );
 		mChildren.erase( i );
+		RemoveChildName( child );
 		
 		// this triggers RemoveAllChildren in the removed child
 		child->SetFather( NULL );
@@ -105,6 +110,7 @@ public:
 		
 		cassert( i != mChildren.end() );
 		mChildren.erase( i );
+		RemoveChildName( child );
 		
 		// this triggers RemoveAllChildren in the removed child
 		// child->SetFather( NULL );
@@ -133,6 +139,12 @@ public:
 	DisplayObjectContainer* GetFather() const { return mFather; }
 	DisplayObjectContainer* getParent() const { return mFather; }
 
+	const NameId& GetNameId() const { return mName; }
+
+	// the first child with the name, from a hash index that follows adds,
+	// removes and renames. Returns NULL if there's no such child
+	DisplayObjectContainer* FindChildByName( const NameId& name ) const;
+
 
 	bool dispatchEvent( const ceng::CSmartPtr< Event >& event );
 
@@ -148,6 +160,14 @@ public:
 
 protected:
 
+	// only the classes that have a public SetName() call this
+	void SetNameId( const NameId& name );
+
+	// these keep mChildrenByName in sync, call them if you touch mChildren
+	// directly
+	void AddChildName( DisplayObjectContainer* child );
+	void RemoveChildName( DisplayObjectContainer* child );
+
 	virtual void RemoveAllChildren()
 	{
 		while( mChildren.empty() == false )
@@ -159,6 +179,9 @@ protected:
 
 	DisplayObjectContainer* mFather;
 	ChildList mChildren;
+
+	NameId mName;
+	ceng::CFlatHashMultiMap< NameId, DisplayObjectContainer*, 1 > mChildrenByName;
 };
 
 //-----------------------------------------------------------------------------
@@ -43,10 +43,10 @@ bool EventDispatcher::dispatchEvent( const ceng::CSmartPtr< Event >& event )
 	{
 		int debug_count = 0;
 		int debug_size = 0;
-		std::list< FunctionPointer* > list = mData.Get( event->type );
+		ListenerList list = mData.Get( event->type );
 		debug_size = list.size();
 
-		std::list< FunctionPointer* >::iterator i;
+		ListenerList::iterator i;
 		for( i = list.begin(); i != list.end(); ++i )
 		{
 			debug_count++;
@@ -73,8 +73,8 @@ void EventDispatcher::removeEventListener( const std::string& name, const ceng::
 	if( mData.Find( name ) == false )
 		return;
 
-	std::list< FunctionPointer* >& list = mData.Get( name );
-	std::list< FunctionPointer* >::iterator i;
+	ListenerList& list = mData.Get( name );
+	ListenerList::iterator i;
 	for( i = list.begin(); i != list.end(); ++i )
 	{
 		if( (*i)->Cmpr( func_pointer.Get() ) )
@@ -98,11 +98,11 @@ bool EventDispatcher::willTrigger( const std::string& name )
 
 void EventDispatcher::Clear()
 {
-	ceng::CMapHelper< std::string, FunctionPointer* >::Iterator i;
+	ListenerMap::Iterator i;
 	for( i = mData.Begin(); i != mData.End(); ++i )
 	{
-		std::list< FunctionPointer* >& list = i->second;
-		for( std::list< FunctionPointer* >::iterator j = list.begin(); j != list.end(); ++j )
+		ListenerList& list = i->second;
+		for( ListenerList::iterator j = list.begin(); j != list.end(); ++j )
 		{
 			delete (*j);
 		}
@@ -71,7 +71,10 @@ public:
 	virtual void Clear();
 
 protected:
-	ceng::CMapHelper< std::string, FunctionPointer* > mData;
+	typedef ceng::CMapHelper< std::string, FunctionPointer* >	ListenerMap;
+	typedef ListenerMap::List									ListenerList;
+
+	ListenerMap mData;
 
 };
 
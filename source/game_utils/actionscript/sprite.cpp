@@ -120,7 +120,6 @@ Sprite::Sprite() :
 	mAlphaMask( NULL ),
 	mAlphaBuffer( NULL ),
 	mBlendMode( poro::IGraphics::BLEND_MODE_NORMAL ),
-	mName( "" ),
 	mTexture( NULL ),
 	mSize( 0, 0 ),
 	mCenterOffset( 0, 0 ),
@@ -161,16 +160,17 @@ Sprite::~Sprite()
 
 Sprite* Sprite::GetChildByName( const std::string& name )
 {
-	ChildList::iterator i;
-	for( i = mChildren.begin(); i != mChildren.end(); ++i )
-	{
-		Sprite* sprite = dynamic_cast< Sprite* >(*i);
-		if( sprite &&
-			sprite->GetName() == name )
-			return sprite;
-	}
+	// the names are interned by SetName(), so no child has one that isn't
+	const NameId id = NameId::Find( name );
+	return id.Empty() ? NULL : GetChildByName( id );
+}
 
-	return NULL;
+Sprite* Sprite::GetChildByName( const NameId& name )
+{
+	// only sprites can be named, so whatever has a name is a sprite
+	DisplayObjectContainer* result = FindChildByName( name );
+	cassert( result == NULL || dynamic_cast< Sprite* >( result ) );
+	return static_cast< Sprite* >( result );
 }
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -182,6 +182,7 @@ void Sprite::Clear()
 	
 
 	mChildren.clear();
+	mChildrenByName.Clear();
 }
 
 //-----------------------------------------------------------------------------
@@ -331,6 +332,7 @@ bool Sprite::DrawChildren( poro::IGraphics* graphics, types::camera* camera, Tra
 				std::list< DisplayObjectContainer* >::iterator remove = i;
 				++i;
 				mChildren.erase( remove );
+				RemoveChildName( current );
 				// current->SetFather( NULL );
 				delete current;
 			}
@@ -558,11 +560,24 @@ void Sprite::PlayAnimation( const std::string& animation_name )
 		return;
 	}
 
-	if( mAnimationUpdater.get() == NULL )
-		mAnimationUpdater.reset( new SpriteAnimationUpdater );
+	StartAnimation( mAnimations->GetAnimation( animation_name ), animation_name );
+}
 
+void Sprite::PlayAnimation( const NameId& animation_name )
+{
+	if( mAnimations == NULL )
+	{
+		logger << "Error trying to play animation before AnimationsSheet has been added: " << animation_name.GetString() << std::endl;
+		return;
+	}
 
-	impl::Animation* a = mAnimations->GetAnimation( animation_name );
+	StartAnimation( mAnimations->GetAnimation( animation_name ), animation_name.GetString() );
+}
+
+void Sprite::StartAnimation( impl::Animation* a, const std::string& animation_name )
+{
+	if( mAnimationUpdater.get() == NULL )
+		mAnimationUpdater.reset( new SpriteAnimationUpdater );
 
 	if( a == NULL )
 	{
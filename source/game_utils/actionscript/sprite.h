@@ -44,6 +44,7 @@ namespace as {
 struct Transform;
 class Animations;
 class SpriteAnimationUpdater;
+namespace impl { struct Animation; }
 
 // ----------------------------------------------------------------------------
 
@@ -126,9 +127,11 @@ public:
 	
 	void Clear();
 
-	Sprite*		GetChildByName( const std::string& name );
-	void		SetName( const std::string& name )	{ mName = name; }
-	std::string	GetName() const						{ return mName; }
+	Sprite*				GetChildByName( const std::string& name );
+	Sprite*				GetChildByName( const NameId& name );
+	void				SetName( const std::string& name )	{ SetNameId( NameId( name ) ); }
+	void				SetName( const NameId& name )		{ SetNameId( name ); }
+	const std::string&	GetName() const						{ return mName.GetString(); }
 
 	void	SetAlphaMask( Sprite* alpha_mask )	{ mAlphaMask = alpha_mask; }
 	Sprite*	GetAlphaMask()						{ return mAlphaMask; }
@@ -172,6 +175,7 @@ public:
 
 	// if SetAnimationsSheet has not been called before this will do nothing
 	void PlayAnimation( const std::string& animation_name );
+	void PlayAnimation( const NameId& animation_name );
 	bool IsAnimationPlaying() const;
 	void SetAnimationFrame( int frame );
 
@@ -182,6 +186,9 @@ public:
 protected:
 
 	types::vector2 MultiplyByParentXForm( const types::vector2& p ) const;
+
+	// the name is only for the error if the animation wasn't found
+	void StartAnimation( impl::Animation* a, const std::string& animation_name );
 	
 
 	poro::IGraphicsBuffer*		GetAlphaBuffer( poro::IGraphics* graphics );
@@ -192,7 +199,6 @@ protected:
 
 	poro::types::Int8			mBlendMode;
 
-	std::string					mName;
 	Image*						mTexture;
 	types::vector2				mSize;
 	types::vector2				mCenterOffset;
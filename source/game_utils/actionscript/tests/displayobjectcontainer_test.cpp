@@ -35,6 +35,7 @@ namespace {
 	{
 	public:
 		int GetSpriteType() const { return -1; }
+		void SetName( const std::string& name ) { SetNameId( NameId( name ) ); }
 	};
 } // end of anonymouns namespace
 
@@ -275,6 +276,50 @@ int DisplayObjectContainerTest()
 
 	}
 
+	// children by name
+	{
+		SpriteContainer* test_father = new SpriteContainer;
+		SpriteContainer* test_child1 = new SpriteContainer;
+		SpriteContainer* test_child2 = new SpriteContainer;
+		SpriteContainer* test_child3 = new SpriteContainer;
+
+		test_child1->SetName( "child1" );
+		test_child2->SetName( "child2" );
+
+		test_father->addChild( test_child1 );
+		test_father->addChildAt( test_child2, 0 );
+		test_father->addChild( test_child3 );
+
+		test_assert( test_father->FindChildByName( NameId( "child1" ) ) == test_child1 );
+		test_assert( test_father->FindChildByName( NameId( "child2" ) ) == test_child2 );
+		test_assert( test_father->FindChildByName( NameId( "child3" ) ) == NULL );
+		test_assert( test_father->FindChildByName( NameId() ) == NULL );
+
+		// renaming while in the father
+		test_child3->SetName( "child3" );
+		test_child1->SetName( "renamed" );
+		test_assert( test_father->FindChildByName( NameId( "child3" ) ) == test_child3 );
+		test_assert( test_father->FindChildByName( NameId( "renamed" ) ) == test_child1 );
+		test_assert( test_father->FindChildByName( NameId( "child1" ) ) == NULL );
+
+		// same name twice, the first in the child order wins
+		test_child3->SetName( "child2" );
+		test_assert( test_father->FindChildByName( NameId( "child2" ) ) == test_child2 );
+		test_father->removeChild( test_child2 );
+		test_assert( test_father->FindChildByName( NameId( "child2" ) ) == test_child3 );
+
+		// the name doesn't follow to the old father
+		test_child2->SetName( "child3" );
+		test_assert( test_father->FindChildByName( NameId( "child3" ) ) == NULL );
+
+		delete test_child3;
+		test_assert( test_father->FindChildByName( NameId( "child2" ) ) == NULL );
+
+		delete test_father;
+		delete test_child1;
+		delete test_child2;
+	}
+
 	return 0;
 }
 
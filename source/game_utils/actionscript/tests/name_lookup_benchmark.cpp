@@ -0,0 +1,153 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include <sstream>
+#include <vector>
+
+#include "../displayobjectcontainer.h"
+#include "../asset_loading/Animations.h"
+#include "../../../utils/debug.h"
+#include "../../../tester/tester_benchmark.h"
+
+#ifdef PORO_TESTER_ENABLED
+namespace as {
+namespace test {
+
+namespace {
+
+	const int bench_names = 10000;
+	const int bench_rounds = 10;
+
+	class NamedContainer : public DisplayObjectContainer
+	{
+	public:
+		int GetSpriteType() const { return -1; }
+		void SetName( const std::string& name ) { SetNameId( NameId( name ) ); }
+	};
+
+	std::string BenchmarkName( int i )
+	{
+		std::stringstream ss;
+		ss << "some_long_prefix_like_in_the_real_data_" << i;
+		return ss.str();
+	}
+
+	// the way GetChildByName used to do it
+	DisplayObjectContainer* LinearFindChild( DisplayObjectContainer& father, const std::string& name )
+	{
+		const DisplayObjectContainer::ChildList& children = father.GetRawChildren();
+		for( DisplayObjectContainer::ChildList::const_iterator i = children.begin(); i != children.end(); ++i )
+		{
+			if( (*i)->GetNameId().GetString() == name )
+				return *i;
+		}
+		return NULL;
+	}
+
+	impl::Animation* LinearFindAnimation( Animations& animations, const std::string& name )
+	{
+		for( std::size_t i = 0; i < animations.animations.size(); ++i )
+		{
+			if( animations.animations[ i ]->name == name )
+				return animations.animations[ i ];
+		}
+		return NULL;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int NameLookupBenchmark()
+{
+	std::vector< std::string > names( bench_names );
+	std::vector< NameId > ids( bench_names );
+	for( int i = 0; i < bench_names; ++i )
+	{
+		names[ i ] = BenchmarkName( i );
+		ids[ i ] = NameId( names[ i ] );
+	}
+
+	// looked up in a different order than added
+	const int lookups = bench_names * bench_rounds;
+	int found = 0;
+
+	{
+		NamedContainer father;
+		for( int i = 0; i < bench_names; ++i )
+		{
+			NamedContainer* child = new NamedContainer;
+			child->SetName( names[ i ] );
+			father.addChild( child );
+		}
+
+		test_logger << "Children by name, " << bench_names << " children" << std::endl;
+
+		// the linear one is so slow it only does one round
+		poro::tester::CBenchmarkTimer linear_timer;
+		for( int i = 0; i < bench_names; ++i )
+			found += LinearFindChild( father, names[ ( i * 7919 ) % bench_names ] ) != NULL;
+		poro::tester::BenchmarkReport( "linear string compare", linear_timer.GetSeconds(), bench_names );
+
+		poro::tester::CBenchmarkTimer string_timer;
+		for( int i = 0; i < lookups; ++i )
+			found += father.FindChildByName( NameId( names[ ( i * 7919 ) % bench_names ] ) ) != NULL;
+		poro::tester::BenchmarkReport( "hashed, from string", string_timer.GetSeconds(), lookups );
+
+		poro::tester::CBenchmarkTimer id_timer;
+		for( int i = 0; i < lookups; ++i )
+			found += father.FindChildByName( ids[ ( i * 7919 ) % bench_names ] ) != NULL;
+		poro::tester::BenchmarkReport( "hashed, from NameId", id_timer.GetSeconds(), lookups );
+	}
+
+	{
+		Animations animations;
+		for( int i = 0; i < bench_names; ++i )
+			animations.AddAnimation( new impl::Animation( names[ i ], 1, -1 ) );
+
+		test_logger << "Animations by name, " << bench_names << " animations" << std::endl;
+
+		poro::tester::CBenchmarkTimer linear_timer;
+		for( int i = 0; i < bench_names; ++i )
+			found += LinearFindAnimation( animations, names[ ( i * 7919 ) % bench_names ] ) != NULL;
+		poro::tester::BenchmarkReport( "linear string compare", linear_timer.GetSeconds(), bench_names );
+
+		poro::tester::CBenchmarkTimer string_timer;
+		for( int i = 0; i < lookups; ++i )
+			found += animations.GetAnimation( names[ ( i * 7919 ) % bench_names ] ) != NULL;
+		poro::tester::BenchmarkReport( "hashed, from string", string_timer.GetSeconds(), lookups );
+
+		poro::tester::CBenchmarkTimer id_timer;
+		for( int i = 0; i < lookups; ++i )
+			found += animations.GetAnimation( ids[ ( i * 7919 ) % bench_names ] ) != NULL;
+		poro::tester::BenchmarkReport( "hashed, from NameId", id_timer.GetSeconds(), lookups );
+	}
+
+	test_assert( found == 2 * ( bench_names + 2 * lookups ) );
+	return 0;
+}
+
+BENCHMARK_REGISTER( NameLookupBenchmark );
+
+} // end of namespace test
+} // end of namespace as
+
+#endif
@@ -45,7 +45,9 @@ TextSprite::TextSprite() :
 	mText(),
 	mInRects(),
 	mOutRects(),
-	mTextBox( 0, 0, -1, -1 )
+	mTextBox( 0, 0, -1, -1 ),
+	mQuadVertices(),
+	mQuadTexCoords()
 { 
 }
 
@@ -84,47 +86,16 @@ void TextSprite::RecalcuateRects()
 {
 	if( mFont ) 
 	{
-		mInRects = mFont->GetRectsForText( mText );
-		mOutRects.clear();
-
-		if( mFontAlign == NULL || mTextBox.w < 0 )
-		{
-			types::vector2 f_pos( 0, 0 );
-			for( std::size_t i = 0; i < mInRects.size(); ++i )
-			{
-				types::rect font_rect = mInRects[ i ];
-				font_rect.x = f_pos.x;
-				font_rect.y = f_pos.y;
-
-				mOutRects.push_back( font_rect );
-
-				f_pos.x += ( font_rect.w + mFont->GetCharSpace() );  /* GetScale().x;*/
-			}
-
-			// figure out mRealSize.x && mRealSize.y
-			types::vector2 min_p( 100000.f, 100000.f );
-			types::vector2 max_p( -100000.f, -100000.f );
-			for( std::size_t i = 0; i < mOutRects.size(); ++i )
-			{
-				if( mOutRects[ i ].w >= 0 &&
-					mOutRects[ i ].h >= 0 )
-				{
-					min_p.x = ceng::math::Min( min_p.x, mOutRects[ i ].x );
-					min_p.y = ceng::math::Min( min_p.y, mOutRects[ i ].y );
-					max_p.x = ceng::math::Max( max_p.x, mOutRects[ i ].x + mOutRects[ i ].w );
-					max_p.y = ceng::math::Max( max_p.y, mOutRects[ i ].y + mOutRects[ i ].h );
-				}
-
-				mRealSize.x = max_p.x - min_p.x;
-				mRealSize.y = max_p.y - min_p.y;
-			}
-		}
-		else if( mFontAlign )
-		{
-			mOutRects = mFontAlign->GetRectPositions( mInRects, mText, types::rect( 0, 0, mTextBox.w, mTextBox.h ), mFont );
-			mRealSize.x = mTextBox.w;
-			mRealSize.y = mTextBox.h;
-		}
+		// the font caches the layouts, so texts that keep coming back (score
+		// counters and such) are only laid out once
+		const bool aligned = ( mFontAlign && mTextBox.w >= 0 );
+		const CFontLayout& layout = aligned ?
+			mFont->GetLayout( mText, mFontAlign->GetAlignmentType(), mTextBox.w, mTextBox.h ) :
+			mFont->GetLayout( mText );
+
+		mInRects = layout.in_rects;
+		mOutRects = layout.out_rects;
+		mRealSize = layout.size;
 	}
 }
 
@@ -143,6 +114,39 @@ bool TextSprite::DrawRect( const types::rect& rect, poro::IGraphics* graphics, t
 	return Sprite::DrawRect( rect, graphics, camera, transform );
 }
 
+// the same quad Sprite::DrawRect() would draw
+void TextSprite::GetGlyphQuad( const types::rect& rect, types::camera* camera, const Transform& transform, poro::types::vec2* vertices, poro::types::vec2* tex_coords )
+{
+	const types::xform& matrix = transform.GetXForm();
+
+	vertices[ 0 ].x = 0;
+	vertices[ 0 ].y = 0;
+	vertices[ 1 ].x = 0;
+	vertices[ 1 ].y = rect.h;
+	vertices[ 2 ].x = rect.w;
+	vertices[ 2 ].y = rect.h;
+	vertices[ 3 ].x = rect.w;
+	vertices[ 3 ].y = 0;
+
+	tex_coords[ 0 ].x = rect.x;
+	tex_coords[ 0 ].y = rect.y;
+	tex_coords[ 1 ].x = rect.x;
+	tex_coords[ 1 ].y = rect.y + rect.h;
+	tex_coords[ 2 ].x = rect.x + rect.w;
+	tex_coords[ 2 ].y = rect.y + rect.h;
+	tex_coords[ 3 ].x = rect.x + rect.w;
+	tex_coords[ 3 ].y = rect.y;
+
+	for( int i = 0; i < 4; ++i )
+	{
+		vertices[ i ] = ceng::math::Mul( mXForm, vertices[ i ] );
+		vertices[ i ] = ceng::math::Mul( matrix, vertices[ i ] );
+
+		if( camera )
+			vertices[ i ] = camera->Transform( vertices[ i ] );
+	}
+}
+
 //-----------------------------------------------------------------------------
 namespace {
 types::rect MultiRect( const types::xform& xform, types::rect r, const types::vector2& center_pos )
@@ -189,6 +193,15 @@ bool TextSprite::Draw( poro::IGraphics* graphics, types::camera* camera, Transfo
 	{
 		mCenterOffset.Set( 0, 0 );
 
+		// all the glyphs with one call, unless there's an alpha mask
+		const bool batched = ( mAlphaBuffer == NULL && mTexture != NULL && graphics != NULL );
+		if( batched )
+		{
+			mQuadVertices.resize( mOutRects.size() * 4 );
+			mQuadTexCoords.resize( mOutRects.size() * 4 );
+		}
+		int quad_count = 0;
+
 		for( std::size_t i = 0; i < mOutRects.size(); ++i )
 		{
 			cassert( i < mInRects.size() );
@@ -206,9 +219,35 @@ bool TextSprite::Draw( poro::IGraphics* graphics, types::camera* camera, Transfo
 				mXForm.position.x = r.x;
 				mXForm.position.y = r.y;
 				
-				DrawRect( mInRects[ i ], graphics, camera, transform );
+				if( batched )
+				{
+					GetGlyphQuad( mInRects[ i ], camera, transform, &mQuadVertices[ quad_count * 4 ], &mQuadTexCoords[ quad_count * 4 ] );
+					quad_count++;
+				}
+				else
+				{
+					DrawRect( mInRects[ i ], graphics, camera, transform );
+				}
 			}
 		}
+
+		if( batched && quad_count > 0 )
+		{
+			const std::vector< float >& tcolor = transform.GetColor();
+			poro::types::fcolor color_me = poro::GetFColor( 
+				mColor[ 0 ] * tcolor[ 0 ], 
+				mColor[ 1 ] * tcolor[ 1 ], 
+				mColor[ 2 ] * tcolor[ 2 ], 
+				mColor[ 3 ] * tcolor[ 3 ] );
+
+			if( mBlendMode != poro::IGraphics::BLEND_MODE_NORMAL )
+				graphics->PushBlendMode( mBlendMode );
+
+			graphics->DrawTextureQuads( mTexture, &mQuadVertices[ 0 ], &mQuadTexCoords[ 0 ], quad_count * 4, color_me );
+
+			if( mBlendMode != poro::IGraphics::BLEND_MODE_NORMAL )
+				graphics->PopBlendMode();
+		}
 	}
 
 	mXForm = m_xform;
@@ -81,6 +81,7 @@ public:
 	virtual bool Draw( poro::IGraphics* graphics, types::camera* camera, Transform& transform );
 protected:
 	virtual bool DrawRect( const types::rect& rect, poro::IGraphics* graphics, types::camera* camera, const Transform& transform );
+	void GetGlyphQuad( const types::rect& rect, types::camera* camera, const Transform& transform, poro::types::vec2* vertices, poro::types::vec2* tex_coords );
 
 protected:
 
@@ -98,6 +99,10 @@ protected:
 	std::vector< types::rect > mInRects;
 	std::vector< types::rect > mOutRects;
 	types::rect mTextBox;
+
+	// the glyph quads for drawing them all with one call
+	std::vector< poro::types::vec2 > mQuadVertices;
+	std::vector< poro::types::vec2 > mQuadTexCoords;
 };
 
 // ----------------------------------------------------------------------------
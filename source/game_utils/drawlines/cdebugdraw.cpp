@@ -0,0 +1,226 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+#include "cdebugdraw.h"
+
+#include "../../poro/igraphics.h"
+//-----------------------------------------------------------------------------
+
+namespace {
+
+	bool SameColor( const poro::types::fcolor& a, const poro::types::fcolor& b )
+	{
+		return a[ 0 ] == b[ 0 ] && a[ 1 ] == b[ 1 ] && a[ 2 ] == b[ 2 ] && a[ 3 ] == b[ 3 ];
+	}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+
+CDebugDraw::CDebugDraw() :
+	myBatches(),
+	myLastBatch( -1 ),
+	myTransformed(),
+	myStats()
+{
+}
+
+//-----------------------------------------------------------------------------
+
+CDebugDraw::Batch& CDebugDraw::GetBatch( const poro::types::fcolor& color, float width )
+{
+	if( width <= 0 )
+		width = GetLineWidth();
+
+	// debug drawing usually comes in runs of the same color
+	if( myLastBatch >= 0 )
+	{
+		Batch& last = myBatches[ myLastBatch ];
+		if( last.width == width && SameColor( last.color, color ) )
+			return last;
+	}
+
+	for( std::size_t i = 0; i < myBatches.size(); ++i )
+	{
+		if( myBatches[ i ].width == width && SameColor( myBatches[ i ].color, color ) )
+		{
+			myLastBatch = (int)i;
+			return myBatches[ i ];
+		}
+	}
+
+	myBatches.push_back( Batch() );
+	Batch& result = myBatches.back();
+	result.color = color;
+	result.width = width;
+	result.timed_count = 0;
+
+	myLastBatch = (int)myBatches.size() - 1;
+	return result;
+}
+
+void CDebugDraw::AddSegment( Batch& batch, const types::vector2& p1, const types::vector2& p2, float lifetime )
+{
+	batch.vertices.push_back( poro::types::vec2( p1.x, p1.y ) );
+	batch.vertices.push_back( poro::types::vec2( p2.x, p2.y ) );
+	batch.time_left.push_back( lifetime );
+	if( lifetime > 0 )
+		batch.timed_count++;
+}
+
+//-----------------------------------------------------------------------------
+
+void CDebugDraw::AddLine( const types::vector2& p1, const types::vector2& p2, const poro::types::fcolor& color, float lifetime, float width )
+{
+	AddSegment( GetBatch( color, width ), p1, p2, lifetime );
+}
+
+void CDebugDraw::AddBox( const types::vector2& min_pos, const types::vector2& max_pos, const poro::types::fcolor& color, float lifetime, float width )
+{
+	Batch& batch = GetBatch( color, width );
+	AddSegment( batch, types::vector2( min_pos.x, min_pos.y ), types::vector2( max_pos.x, min_pos.y ), lifetime );
+	AddSegment( batch, types::vector2( max_pos.x, min_pos.y ), types::vector2( max_pos.x, max_pos.y ), lifetime );
+	AddSegment( batch, types::vector2( max_pos.x, max_pos.y ), types::vector2( min_pos.x, max_pos.y ), lifetime );
+	AddSegment( batch, types::vector2( min_pos.x, max_pos.y ), types::vector2( min_pos.x, min_pos.y ), lifetime );
+}
+
+void CDebugDraw::AddCircle( const types::vector2& position, float r, const poro::types::fcolor& color, float lifetime, float width )
+{
+	Batch& batch = GetBatch( color, width );
+
+	types::vector2 previous = position + GetUnitCirclePoint( DrawCircleSegments - 1 ) * r;
+	for( int i = 0; i < DrawCircleSegments; ++i )
+	{
+		const types::vector2 p = position + GetUnitCirclePoint( i ) * r;
+		AddSegment( batch, previous, p, lifetime );
+		previous = p;
+	}
+}
+
+void CDebugDraw::AddArrow( const types::vector2& p1, const types::vector2& p2, const poro::types::fcolor& color, float arrow_size, float lifetime, float width )
+{
+	types::vector2 delta = p2 - p1;
+
+	types::vector2 a1 = p2 + types::vector2( -arrow_size, -arrow_size ).Rotate( delta.Angle() );
+	types::vector2 a2 = p2 + types::vector2( -arrow_size, arrow_size ).Rotate( delta.Angle() );
+
+	Batch& batch = GetBatch( color, width );
+	AddSegment( batch, p1, p2, lifetime );
+	AddSegment( batch, p2, a1, lifetime );
+	AddSegment( batch, p2, a2, lifetime );
+}
+
+//-----------------------------------------------------------------------------
+
+void CDebugDraw::Update( float dt )
+{
+	for( std::size_t i = 0; i < myBatches.size(); ++i )
+	{
+		Batch& batch = myBatches[ i ];
+		if( batch.timed_count == 0 )
+			continue;
+
+		for( std::size_t j = 0; j < batch.time_left.size(); ++j )
+			batch.time_left[ j ] -= dt;
+	}
+}
+
+void CDebugDraw::RemoveDead( Batch& batch )
+{
+	if( batch.timed_count == 0 )
+	{
+		batch.vertices.clear();
+		batch.time_left.clear();
+		return;
+	}
+
+	std::size_t count = 0;
+	for( std::size_t i = 0; i < batch.time_left.size(); ++i )
+	{
+		if( batch.time_left[ i ] <= 0 )
+			continue;
+
+		batch.time_left[ count ] = batch.time_left[ i ];
+		batch.vertices[ count * 2 ] = batch.vertices[ i * 2 ];
+		batch.vertices[ count * 2 + 1 ] = batch.vertices[ i * 2 + 1 ];
+		count++;
+	}
+
+	batch.timed_count = (int)count;
+	batch.time_left.resize( count );
+	batch.vertices.resize( count * 2 );
+}
+
+void CDebugDraw::Draw( poro::IGraphics* graphics, types::camera* camera )
+{
+	cassert( graphics );
+
+	myStats = Stats();
+
+	const bool smooth = GetLineSmoothing();
+	for( std::size_t i = 0; i < myBatches.size(); ++i )
+	{
+		Batch& batch = myBatches[ i ];
+		if( batch.vertices.empty() )
+			continue;
+
+		if( camera )
+		{
+			myTransformed.resize( batch.vertices.size() );
+			for( std::size_t j = 0; j < batch.vertices.size(); ++j )
+			{
+				const types::vector2 p = camera->Transform( types::vector2( batch.vertices[ j ].x, batch.vertices[ j ].y ) );
+				myTransformed[ j ].x = p.x;
+				myTransformed[ j ].y = p.y;
+			}
+			graphics->DrawLineSegments( myTransformed, batch.color, smooth, batch.width );
+		}
+		else
+		{
+			graphics->DrawLineSegments( batch.vertices, batch.color, smooth, batch.width );
+		}
+
+		myStats.batches++;
+		myStats.segments += (int)batch.time_left.size();
+
+		RemoveDead( batch );
+	}
+}
+
+void CDebugDraw::Clear()
+{
+	for( std::size_t i = 0; i < myBatches.size(); ++i )
+	{
+		myBatches[ i ].vertices.clear();
+		myBatches[ i ].time_left.clear();
+		myBatches[ i ].timed_count = 0;
+	}
+}
+
+int CDebugDraw::GetSegmentCount() const
+{
+	int result = 0;
+	for( std::size_t i = 0; i < myBatches.size(); ++i )
+		result += (int)myBatches[ i ].time_left.size();
+	return result;
+}
+
+//-----------------------------------------------------------------------------
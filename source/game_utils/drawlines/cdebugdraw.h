@@ -0,0 +1,100 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CDebugDraw
+// ==========
+//
+// Collects debug lines, boxes, circles and arrows over the frame and draws
+// them with one IGraphics::DrawLineSegments() call per color and line width,
+// instead of one DrawLines() call per line like the Draw* functions do.
+//
+// Everything is stored as line segments in world coordinates, the camera is
+// applied when drawing. A primitive with lifetime 0 is drawn once by the
+// next Draw(), one with a lifetime keeps getting drawn until Update() has
+// used it up.
+//
+// The batches and their vertex arrays are reused from frame to frame, so
+// after the first few frames adding primitives doesn't allocate anything.
+//
+//.............................................................................
+//=============================================================================
+#ifndef INC_CDEBUGDRAW_H
+#define INC_CDEBUGDRAW_H
+
+#include <vector>
+#include "drawlines.h"
+
+class CDebugDraw
+{
+public:
+	struct Stats
+	{
+		Stats() : batches( 0 ), segments( 0 ) { }
+
+		//! of the last Draw(), batches is also the number of draw calls
+		int batches;
+		int segments;
+	};
+
+	CDebugDraw();
+
+	//! width 0 uses GetLineWidth()
+	void AddLine( const types::vector2& p1, const types::vector2& p2, const poro::types::fcolor& color, float lifetime = 0, float width = 0 );
+	void AddBox( const types::vector2& min_pos, const types::vector2& max_pos, const poro::types::fcolor& color, float lifetime = 0, float width = 0 );
+	void AddCircle( const types::vector2& position, float r, const poro::types::fcolor& color, float lifetime = 0, float width = 0 );
+	void AddArrow( const types::vector2& p1, const types::vector2& p2, const poro::types::fcolor& color, float arrow_size = 10, float lifetime = 0, float width = 0 );
+
+	//! counts down the lifetimes
+	void Update( float dt );
+
+	//! draws everything and drops what has lived its life
+	void Draw( poro::IGraphics* graphics, types::camera* camera = NULL );
+
+	void Clear();
+
+	//! the segments waiting to be drawn
+	int				GetSegmentCount() const;
+	const Stats&	GetStats() const { return myStats; }
+
+private:
+	struct Batch
+	{
+		poro::types::fcolor					color;
+		float								width;
+		std::vector< poro::types::vec2 >	vertices;
+		//! one per segment
+		std::vector< float >				time_left;
+		int									timed_count;
+	};
+
+	Batch&	GetBatch( const poro::types::fcolor& color, float width );
+	void	AddSegment( Batch& batch, const types::vector2& p1, const types::vector2& p2, float lifetime );
+	void	RemoveDead( Batch& batch );
+
+	std::vector< Batch >				myBatches;
+	int									myLastBatch;
+	std::vector< poro::types::vec2 >	myTransformed;
+	Stats								myStats;
+};
+
+#endif
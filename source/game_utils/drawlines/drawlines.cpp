@@ -38,6 +38,21 @@ namespace {
 		return result;
 	}
 
+	struct UnitCircle
+	{
+		UnitCircle()
+		{
+			const float increment = 2.0f * ceng::math::pi / (float)DrawCircleSegments;
+			for( int i = 0; i < DrawCircleSegments; ++i )
+			{
+				points[ i ].x = cosf( increment * (float)i );
+				points[ i ].y = sinf( increment * (float)i );
+			}
+		}
+
+		types::vector2 points[ DrawCircleSegments ];
+	};
+
 } // end of anonymous namespace
 
 //-----------------------------------------------------------------------------
@@ -91,48 +106,56 @@ void DrawLines( poro::IGraphics* graphics, const std::vector< poro::types::vec2
 
 void DrawArrow( poro::IGraphics* graphics, const types::vector2& p1, const types::vector2& p2, const poro::types::fcolor& color, float arrow_size, types::camera* camera  )
 {
-	DrawLine( graphics, p1, p2, color, camera );
+	static std::vector< poro::types::vec2 > lines( 6 );
 
 	types::vector2 delta = p2 - p1;
 
 	types::vector2 a1 = p2 + types::vector2( -arrow_size, -arrow_size ).Rotate( delta.Angle() );
 	types::vector2 a2 = p2 + types::vector2( -arrow_size, arrow_size ).Rotate( delta.Angle() );
 
-	DrawLine( graphics, p2, a1, color, camera );
-	DrawLine( graphics, p2, a2, color, camera );
+	if( camera ) {
+		lines[ 0 ] = ToPoro( camera->Transform( p1 ) );
+		lines[ 1 ] = ToPoro( camera->Transform( p2 ) );
+		lines[ 3 ] = ToPoro( camera->Transform( a1 ) );
+		lines[ 5 ] = ToPoro( camera->Transform( a2 ) );
+	} else {
+		lines[ 0 ] = ToPoro( p1 );
+		lines[ 1 ] = ToPoro( p2 );
+		lines[ 3 ] = ToPoro( a1 );
+		lines[ 5 ] = ToPoro( a2 );
+	}
+	lines[ 2 ] = lines[ 1 ];
+	lines[ 4 ] = lines[ 1 ];
+
+	graphics->DrawLineSegments( lines, color, smooth_lines, line_width );
+}
+
+//-----------------------------------------------------------------------------
+
+const types::vector2& GetUnitCirclePoint( int i )
+{
+	static UnitCircle circle;
+	cassert( i >= 0 && i < DrawCircleSegments );
+	return circle.points[ i ];
 }
 
 //-----------------------------------------------------------------------------
 
 void DrawCircle( poro::IGraphics* graphics, const types::vector2& position, float r, const poro::types::fcolor& color, types::camera* camera )
 {
-	std::vector< poro::types::vec2 > debug_drawing;
-	const float k_segments = 16.0f;
-	const float k_increment = 2.0f * ceng::math::pi / k_segments;
+	// the first one again as the last to close the loop
+	static std::vector< poro::types::vec2 > debug_drawing( DrawCircleSegments + 1 );
 
-	float theta = 0.0f;
-	for( int i = 0; i < k_segments; ++i )
+	for( int i = 0; i < DrawCircleSegments; ++i )
 	{
-		types::vector2 d(r * cosf(theta), r * sinf(theta));
-		types::vector2 v = position + d;
+		types::vector2 v = position + GetUnitCirclePoint( i ) * r;
 
 		if( camera )
 			v = camera->Transform( v );
 
-		// types::vector2 p = types::vector2( v.x, v.y );
-
-		debug_drawing.push_back( ToPoro( v ) );
-
-		theta += k_increment;
+		debug_drawing[ i ] = ToPoro( v );
 	}
-
-
-	// adding the first as the last (aka closing the loop)
-	debug_drawing.push_back( debug_drawing[ 0 ] );
-
-	// return debug_drawing;
-	// AddDebugLineDrawing( debug_drawing );
-
+	debug_drawing[ DrawCircleSegments ] = debug_drawing[ 0 ];
 
 	cassert( graphics );
 	graphics->DrawLines( debug_drawing, color, smooth_lines, line_width );
@@ -142,10 +165,18 @@ void DrawCircle( poro::IGraphics* graphics, const types::vector2& position, floa
 
 void DrawBox( poro::IGraphics* graphics, const types::vector2& min_pos, const types::vector2& max_pos, const poro::types::fcolor& color, types::camera* camera )
 {
-	DrawLine( graphics, types::vector2( min_pos.x, min_pos.y ), types::vector2( max_pos.x, min_pos.y ), color, camera );
-	DrawLine( graphics, types::vector2( max_pos.x, min_pos.y ), types::vector2( max_pos.x, max_pos.y ), color, camera );
-	DrawLine( graphics, types::vector2( max_pos.x, max_pos.y ), types::vector2( min_pos.x, max_pos.y ), color, camera );
-	DrawLine( graphics, types::vector2( min_pos.x, max_pos.y ), types::vector2( min_pos.x, min_pos.y ), color, camera );
+	static std::vector< poro::types::vec2 > box( 4 );
+
+	types::vector2 corners[ 4 ] = { 
+		types::vector2( min_pos.x, min_pos.y ), 
+		types::vector2( max_pos.x, min_pos.y ), 
+		types::vector2( max_pos.x, max_pos.y ), 
+		types::vector2( min_pos.x, max_pos.y ) };
+
+	for( int i = 0; i < 4; ++i )
+		box[ i ] = ToPoro( camera ? camera->Transform( corners[ i ] ) : corners[ i ] );
+
+	graphics->DrawLines( box, color, smooth_lines, line_width, true );
 }
 
 //-----------------------------------------------------------------------------
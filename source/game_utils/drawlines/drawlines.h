@@ -49,9 +49,17 @@ void DrawArrow( poro::IGraphics* graphics, const types::vector2& p1, const types
 // draws a circle with lines
 void DrawCircle( poro::IGraphics* graphics, const types::vector2& position, float r, const poro::types::fcolor& color = poro::GetFColor( 1, 1, 1, 1 ), types::camera* camera = NULL );
 
-// draws a box with DrawLine method
+// draws a box with one DrawLines call
 void DrawBox( poro::IGraphics* graphics, const types::vector2& min_pos, const types::vector2& max_pos, const poro::types::fcolor& color, types::camera* camera = NULL );
 
+//-----------------------------------------------------------------------------
+
+// circles are drawn with this many lines
+const int DrawCircleSegments = 16;
+
+// the points of a circle with the radius of 1, so there's no need for sin and cos
+const types::vector2& GetUnitCirclePoint( int i );
+
 
 //-----------------------------------------------------------------------------
 
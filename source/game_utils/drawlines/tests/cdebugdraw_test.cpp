@@ -0,0 +1,188 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+#include <math.h>
+#include "../cdebugdraw.h"
+#include "../../../poro/igraphics.h"
+#include "../../../utils/debug.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	// counts the draw calls instead of drawing
+	class DebugDrawTestGraphics : public poro::IGraphics
+	{
+	public:
+		DebugDrawTestGraphics() : line_calls( 0 ), segment_calls( 0 ), segments( 0 ) { }
+
+		bool				Init( int, int, bool, const poro::types::string& ) { return true; }
+		poro::ITexture*		LoadTexture( const poro::types::string& ) { return NULL; }
+		void				ReleaseTexture( poro::ITexture* ) { }
+		void				BeginRendering() { }
+		void				EndRendering() { }
+		void				DrawTexture( poro::ITexture*, poro::types::Float32, poro::types::Float32, poro::types::Float32, poro::types::Float32, const poro::types::fcolor&, poro::types::Float32 ) { }
+		void				DrawTexture( poro::ITexture*, poro::types::vec2*, poro::types::vec2*, int, const poro::types::fcolor& ) { }
+
+		void DrawLines( const std::vector< poro::types::vec2 >& /*vertices*/, const poro::types::fcolor& /*color*/, bool /*smooth*/, float /*width*/, bool /*loop*/ )
+		{
+			line_calls++;
+		}
+
+		void DrawLineSegments( const std::vector< poro::types::vec2 >& vertices, const poro::types::fcolor& /*color*/, bool /*smooth*/, float width )
+		{
+			segment_calls++;
+			segments += (int)vertices.size() / 2;
+			last_vertices = vertices;
+			last_width = width;
+		}
+
+		int line_calls;
+		int segment_calls;
+		int segments;
+		float last_width;
+		std::vector< poro::types::vec2 > last_vertices;
+	};
+
+	class DebugDrawTestCamera : public types::camera
+	{
+	public:
+		bool IsNull() const { return false; }
+		types::vector2 Transform( const types::vector2& p ) { return types::vector2( p.x + 100.f, p.y * 2.f ); }
+	};
+
+}
+
+int CDebugDrawTest()
+{
+	const poro::types::fcolor red = poro::GetFColor( 1, 0, 0, 1 );
+	const poro::types::fcolor green = poro::GetFColor( 0, 1, 0, 1 );
+
+	// one call per color and width
+	{
+		DebugDrawTestGraphics graphics;
+		CDebugDraw debug_draw;
+
+		for( int i = 0; i < 100; ++i )
+		{
+			debug_draw.AddLine( types::vector2( 0, 0 ), types::vector2( (float)i, 10 ), red );
+			debug_draw.AddBox( types::vector2( 0, 0 ), types::vector2( 10, 10 ), green );
+			debug_draw.AddCircle( types::vector2( 0, 0 ), 5.f, red );
+			debug_draw.AddArrow( types::vector2( 0, 0 ), types::vector2( 10, 0 ), red, 2.f, 0, 3.f );
+		}
+
+		test_assert( debug_draw.GetSegmentCount() == 100 * ( 1 + 4 + DrawCircleSegments + 3 ) );
+
+		debug_draw.Draw( &graphics );
+		test_assert( graphics.line_calls == 0 );
+		test_assert( graphics.segment_calls == 3 );
+		test_assert( graphics.segments == 100 * ( 1 + 4 + DrawCircleSegments + 3 ) );
+		test_assert( debug_draw.GetStats().batches == 3 );
+		test_assert( graphics.last_width == 3.f );
+
+		// drawn once and gone
+		test_assert( debug_draw.GetSegmentCount() == 0 );
+		graphics.segment_calls = 0;
+		debug_draw.Draw( &graphics );
+		test_assert( graphics.segment_calls == 0 );
+	}
+
+	// the circle is closed and the points are on it
+	{
+		DebugDrawTestGraphics graphics;
+		CDebugDraw debug_draw;
+		debug_draw.AddCircle( types::vector2( 10, 20 ), 5.f, red );
+		debug_draw.Draw( &graphics );
+
+		const std::vector< poro::types::vec2 >& v = graphics.last_vertices;
+		test_assert( (int)v.size() == DrawCircleSegments * 2 );
+		for( std::size_t i = 0; i < v.size(); ++i )
+		{
+			const float dx = v[ i ].x - 10.f;
+			const float dy = v[ i ].y - 20.f;
+			test_assert( fabsf( dx * dx + dy * dy - 25.f ) < 0.01f );
+		}
+		test_assert( v[ 0 ].x == v[ v.size() - 1 ].x && v[ 0 ].y == v[ v.size() - 1 ].y );
+	}
+
+	// lifetimes
+	{
+		DebugDrawTestGraphics graphics;
+		CDebugDraw debug_draw;
+		debug_draw.AddLine( types::vector2( 0, 0 ), types::vector2( 1, 1 ), red, 1.f );
+		debug_draw.AddLine( types::vector2( 0, 0 ), types::vector2( 2, 2 ), red );
+
+		debug_draw.Draw( &graphics );
+		test_assert( graphics.segments == 2 );
+		test_assert( debug_draw.GetSegmentCount() == 1 );
+
+		debug_draw.Update( 0.5f );
+		debug_draw.Draw( &graphics );
+		test_assert( graphics.segments == 3 );
+		test_assert( graphics.last_vertices[ 1 ].x == 1.f );
+
+		debug_draw.Update( 0.5f );
+		debug_draw.Draw( &graphics );
+		test_assert( graphics.segments == 4 );
+		test_assert( debug_draw.GetSegmentCount() == 0 );
+	}
+
+	// the camera is applied when drawing
+	{
+		DebugDrawTestGraphics graphics;
+		DebugDrawTestCamera camera;
+		CDebugDraw debug_draw;
+		debug_draw.AddLine( types::vector2( 1, 2 ), types::vector2( 3, 4 ), red, 1.f );
+
+		debug_draw.Draw( &graphics, &camera );
+		test_assert( graphics.last_vertices[ 0 ].x == 101.f );
+		test_assert( graphics.last_vertices[ 1 ].y == 8.f );
+
+		debug_draw.Draw( &graphics );
+		test_assert( graphics.last_vertices[ 0 ].x == 1.f );
+
+		debug_draw.Clear();
+		test_assert( debug_draw.GetSegmentCount() == 0 );
+	}
+
+	// the old functions take one call per shape
+	{
+		DebugDrawTestGraphics graphics;
+		DrawBox( &graphics, types::vector2( 0, 0 ), types::vector2( 1, 1 ), red );
+		DrawCircle( &graphics, types::vector2( 0, 0 ), 1.f, red );
+		test_assert( graphics.line_calls == 2 );
+
+		DrawArrow( &graphics, types::vector2( 0, 0 ), types::vector2( 1, 1 ), red );
+		test_assert( graphics.line_calls == 2 );
+		test_assert( graphics.segment_calls == 1 );
+		test_assert( graphics.segments == 3 );
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( CDebugDrawTest );
+
+} // end of namespace test
+
+#endif
@@ -20,21 +20,46 @@
 
 
 #include "cfont.h"
+#include "ifontalign.h"
 #include "../../utils/debug.h"
 
 #include <limits>
 #include <cstdio>
+#include <cstring>
 
+namespace {
+
+	const types::rect empty_glyph;
+
+	unsigned int HashLayoutKey( const std::string& text, int align, float box_w, float box_h )
+	{
+		unsigned int result = ceng::CHash< std::string >()( text );
+		result = result * 31 + ceng::CHash< int >()( align );
+		result = result * 31 + ceng::CHash< int >()( (int)box_w );
+		result = result * 31 + ceng::CHash< int >()( (int)box_h );
+		return result;
+	}
+
+} // end of anonymous namespace
 
 ///////////////////////////////////////////////////////////////////////////////
 
 CFont::CFont() : 
-	myCharPositions(),
+	myGlyphTotal( 0 ),
+	myFallback( -1 ),
+	myKerning(),
 	myLineHeight( 0 ),
 	myCharSpace( 0 ),
 	myWordSpace( 0 ),
-	myTextureFilename()
+	myTextureFilename(),
+	myLayouts(),
+	myLayoutIndex(),
+	myNewestLayout( -1 ),
+	myOldestLayout( -1 ),
+	myLayoutHits( 0 ),
+	myLayoutMisses( 0 )
 {
+	Clear();
 }
 
 //.............................................................................
@@ -44,6 +69,95 @@ CFont::~CFont()
 	Clear();
 }
 
+//.............................................................................
+
+void CFont::Clear()
+{
+	for( int i = 0; i < GlyphCount; ++i )
+	{
+		myGlyphs[ i ] = types::rect();
+		myHasGlyph[ i ] = false;
+		myHasKerning[ i ] = false;
+	}
+
+	myGlyphTotal = 0;
+	myFallback = -1;
+	myKerning.Clear();
+	myTextureFilename.clear();
+	myLineHeight = 0;
+	myCharSpace = 0;
+	myWordSpace = 0;
+
+	ClearLayoutCache();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void CFont::SetCharPosition( CharType c, const types::rect& r )
+{
+	const int i = Index( c );
+	if( myHasGlyph[ i ] == false )
+		myGlyphTotal++;
+
+	myGlyphs[ i ] = r;
+	myHasGlyph[ i ] = true;
+	ClearLayoutCache();
+}
+
+types::rect	CFont::GetCharPosition( CharType c ) const
+{ 
+	return myGlyphs[ Index( c ) ];
+}
+
+const types::rect& CFont::GetGlyph( CharType c ) const
+{
+	const int i = Index( c );
+	if( myHasGlyph[ i ] )
+		return myGlyphs[ i ];
+
+	if( myFallback >= 0 )
+		return myGlyphs[ myFallback ];
+
+	return empty_glyph;
+}
+
+void CFont::SetFallbackChar( CharType c )
+{
+	myFallback = Index( c );
+	ClearLayoutCache();
+}
+
+void CFont::ClearFallbackChar()
+{
+	myFallback = -1;
+	ClearLayoutCache();
+}
+
+//.............................................................................
+
+float CFont::GetKerning( CharType first, CharType second ) const
+{
+	if( myHasKerning[ Index( first ) ] == false )
+		return 0;
+
+	const float* result = myKerning.FindValue( ( Index( first ) << 8 ) | Index( second ) );
+	return result ? *result : 0;
+}
+
+void CFont::SetKerning( CharType first, CharType second, float amount )
+{
+	myKerning[ ( Index( first ) << 8 ) | Index( second ) ] = amount;
+	myHasKerning[ Index( first ) ] = true;
+	ClearLayoutCache();
+}
+
+//.............................................................................
+
+float CFont::GetLineHeight() const	
+{ 
+	return myLineHeight; 
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 float CFont::GetWidth( const std::string& text )
@@ -52,11 +166,13 @@ float CFont::GetWidth( const std::string& text )
 	float space = 0;
 	for( i = 0; i < text.size(); i++ )
 	{
-
-		CharType c = (CharType)text[ i ];
-		// cassert( !myCharPositions[ c ].empty() );
-		if( !myCharPositions[ c ].empty() ) 
-			space += ( myCharPositions[ c ].w + myCharSpace );
+		const types::rect& glyph = GetGlyph( text[ i ] );
+		if( !glyph.empty() ) 
+		{
+			space += ( glyph.w + myCharSpace );
+			if( i + 1 < text.size() )
+				space += GetKerning( text[ i ], text[ i + 1 ] );
+		}
 	}
 
 	float scale = 1.f;
@@ -67,35 +183,154 @@ float CFont::GetWidth( const std::string& text )
 std::vector< types::rect > CFont::GetRectsForText( const std::string& text )
 {
 	std::vector< types::rect > result;
+	GetRectsForText( text, result );
+	return result;
+}
 
-	std::size_t i;
-	for( i = 0; i < text.size(); i++ )
+void CFont::GetRectsForText( const std::string& text, std::vector< types::rect >& result )
+{
+	result.resize( text.size() );
+	for( std::size_t i = 0; i < text.size(); i++ )
+		result[ i ] = GetGlyph( text[ i ] );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void CFont::LayoutText( const std::string& text, int align, float box_w, float box_h, CFontLayout& layout )
+{
+	GetRectsForText( text, layout.in_rects );
+
+	IFontAlign* font_align = align >= 0 ? IFontAlign::GetAlign( align ) : NULL;
+	if( font_align )
 	{
-		CharType c = (CharType)text[ i ];
-		// cassert( !myCharPositions[ c ].empty() );
-		//if( !myCharPositions[ c ].empty() ) 
-		result.push_back( myCharPositions[ c ] );
+		layout.out_rects = font_align->GetRectPositions( layout.in_rects, text, types::rect( 0, 0, box_w, box_h ), this );
+		layout.size.x = box_w;
+		layout.size.y = box_h;
+		return;
 	}
 
-	return result;
+	layout.out_rects.resize( layout.in_rects.size() );
+
+	types::vector2 f_pos( 0, 0 );
+	for( std::size_t i = 0; i < layout.in_rects.size(); ++i )
+	{
+		types::rect font_rect = layout.in_rects[ i ];
+		font_rect.x = f_pos.x;
+		font_rect.y = f_pos.y;
+
+		layout.out_rects[ i ] = font_rect;
+
+		f_pos.x += font_rect.w + myCharSpace;
+		if( i + 1 < text.size() )
+			f_pos.x += GetKerning( text[ i ], text[ i + 1 ] );
+	}
+
+	// figure out the size
+	types::vector2 min_p( 100000.f, 100000.f );
+	types::vector2 max_p( -100000.f, -100000.f );
+	layout.size.Set( 0, 0 );
+	for( std::size_t i = 0; i < layout.out_rects.size(); ++i )
+	{
+		const types::rect& r = layout.out_rects[ i ];
+		if( r.w >= 0 && r.h >= 0 )
+		{
+			min_p.x = ceng::math::Min( min_p.x, r.x );
+			min_p.y = ceng::math::Min( min_p.y, r.y );
+			max_p.x = ceng::math::Max( max_p.x, r.x + r.w );
+			max_p.y = ceng::math::Max( max_p.y, r.y + r.h );
+		}
+
+		layout.size.x = max_p.x - min_p.x;
+		layout.size.y = max_p.y - min_p.y;
+	}
 }
-//.............................................................................
 
-float CFont::GetLineHeight() const	
-{ 
-	return myLineHeight; 
+const CFontLayout& CFont::GetLayout( const std::string& text, int align, float box_w, float box_h )
+{
+	const unsigned int hash = HashLayoutKey( text, align, box_w, box_h );
+	const ceng::CSmallVector< int, 1 >* candidates = myLayoutIndex.Find( hash );
+	if( candidates )
+	{
+		for( std::size_t i = 0; i < candidates->size(); ++i )
+		{
+			const int slot = (*candidates)[ i ];
+			LayoutCacheEntry& entry = myLayouts[ slot ];
+			if( entry.align == align && entry.box_w == box_w && entry.box_h == box_h && entry.text == text )
+			{
+				myLayoutHits++;
+				UnlinkLayout( slot );
+				LinkNewestLayout( slot );
+				return entry.layout;
+			}
+		}
+	}
+
+	myLayoutMisses++;
+
+	// a new entry or the one that has gone unused the longest
+	int slot = (int)myLayouts.size();
+	if( slot < LayoutCacheSize )
+	{
+		myLayouts.push_back( LayoutCacheEntry() );
+	}
+	else
+	{
+		slot = myOldestLayout;
+		UnlinkLayout( slot );
+		myLayoutIndex.Remove( myLayouts[ slot ].hash, slot );
+	}
+
+	LayoutCacheEntry& entry = myLayouts[ slot ];
+	entry.text = text;
+	entry.align = align;
+	entry.box_w = box_w;
+	entry.box_h = box_h;
+	entry.hash = hash;
+	LayoutText( text, align, box_w, box_h, entry.layout );
+
+	LinkNewestLayout( slot );
+	myLayoutIndex.Insert( hash, slot );
+	return entry.layout;
 }
 
-///////////////////////////////////////////////////////////////////////////////
+void CFont::ClearLayoutCache()
+{
+	myLayouts.clear();
+	myLayoutIndex.Clear();
+	myNewestLayout = -1;
+	myOldestLayout = -1;
+}
 
-types::rect	CFont::GetCharPosition( CharType c ) const
-{ 
-	MapType::const_iterator i = myCharPositions.find( c );
-	if( i != myCharPositions.end() )
-		return i->second;
+void CFont::UnlinkLayout( int slot )
+{
+	LayoutCacheEntry& entry = myLayouts[ slot ];
+	if( entry.newer >= 0 )
+		myLayouts[ entry.newer ].older = entry.older;
+	else
+		myNewestLayout = entry.older;
+
+	if( entry.older >= 0 )
+		myLayouts[ entry.older ].newer = entry.newer;
 	else
-		return types::rect();
+		myOldestLayout = entry.newer;
+
+	entry.newer = -1;
+	entry.older = -1;
 }
+
+void CFont::LinkNewestLayout( int slot )
+{
+	LayoutCacheEntry& entry = myLayouts[ slot ];
+	entry.newer = -1;
+	entry.older = myNewestLayout;
+	if( myNewestLayout >= 0 )
+		myLayouts[ myNewestLayout ].newer = slot;
+	else
+		myOldestLayout = slot;
+
+	myNewestLayout = slot;
+}
+
 //-----------------------------------------------------------------------------
 
 namespace
@@ -121,6 +356,29 @@ namespace
 		types::rect recto;
 		CFont::CharType id;
 	};
+
+	struct KerningSerializeHelper
+	{
+		KerningSerializeHelper() : first( 0 ), second( 0 ), amount( 0 ) { }
+		KerningSerializeHelper( CFont::CharType first, CFont::CharType second, float amount ) : first( first ), second( second ), amount( amount ) { }
+
+		void Serialize( ceng::CXmlFileSys* filesys )
+		{
+			int i_first = (int)first;
+			int i_second = (int)second;
+
+			XML_BindAttributeAlias( filesys, i_first, "first" );
+			XML_BindAttributeAlias( filesys, i_second, "second" );
+			XML_BindAttributeAlias( filesys, amount, "amount" );
+
+			first = (CFont::CharType)i_first;
+			second = (CFont::CharType)i_second;
+		}
+
+		CFont::CharType first;
+		CFont::CharType second;
+		float amount;
+	};
 } // end of anonymous namespace
 
 void CFont::Serialize( ceng::CXmlFileSys* filesys )
@@ -135,12 +393,26 @@ void CFont::Serialize( ceng::CXmlFileSys* filesys )
 
 	if( filesys->IsWriting() )
 	{
-		MapType::iterator i = myCharPositions.begin();
-		for( i = myCharPositions.begin(); i != myCharPositions.end(); ++i )
+		for( int i = 0; i < GlyphCount; ++i )
 		{
-			FontSerializeHelper helper( i->first, i->second );
+			if( myHasGlyph[ i ] == false )
+				continue;
+
+			FontSerializeHelper helper( (CharType)i, myGlyphs[ i ] );
 			XML_BindAlias( filesys, helper, "Char" );
 		}
+
+		for( ceng::CFlatHashMap< unsigned int, float >::Iterator i = myKerning.Begin(); i != myKerning.End(); ++i )
+		{
+			KerningSerializeHelper helper( (CharType)( i->first >> 8 ), (CharType)( i->first & 0xFF ), i->second );
+			XML_BindAlias( filesys, helper, "Kerning" );
+		}
+
+		if( myFallback >= 0 )
+		{
+			int fallback = myFallback;
+			XML_BindAlias( filesys, fallback, "Fallback" );
+		}
 	}
 	else if( filesys->IsReading() )
 	{
@@ -150,9 +422,20 @@ void CFont::Serialize( ceng::CXmlFileSys* filesys )
 			{
 				FontSerializeHelper helper;
 				XmlConvertTo( filesys->GetNode()->GetChild( i ), helper );
-				myCharPositions[ helper.id ] = helper.recto;
+				SetCharPosition( helper.id, helper.recto );
+			}
+			else if( filesys->GetNode()->GetChild( i )->GetName() == "Kerning" ) 
+			{
+				KerningSerializeHelper helper;
+				XmlConvertTo( filesys->GetNode()->GetChild( i ), helper );
+				SetKerning( helper.first, helper.second, helper.amount );
 			}
 		}
+
+		int fallback = -1;
+		XML_BindAlias( filesys, fallback, "Fallback" );
+		if( fallback >= 0 && fallback < GlyphCount )
+			myFallback = fallback;
 	}
 }
 //-----------------------------------------------------------------------------
@@ -55,32 +55,73 @@
 #include <map>
 
 #include "../../types.h"
+#include "../../utils/maphelper/cflathashmap.h"
+#include "../../utils/maphelper/cflathashmultimap.h"
 
+class IFontAlign;
+
+// The glyphs of a text and where they go. in_rects are the rects in the
+// font texture, out_rects the positions relative to the top left corner of
+// the text. Line breaks get a ( 0, 0, -1, -1 ) out_rect
+struct CFontLayout
+{
+	std::vector< types::rect >	in_rects;
+	std::vector< types::rect >	out_rects;
+	types::vector2				size;
+};
 
 // CFont is a class that only contains data about the font texture
 // someone else has to do all the hard work of drawing the font on
 // screen
+//
+// The glyphs are in a flat table indexed by the character. A fallback
+// character can be set for the ones the font doesn't have. The layouts
+// returned by GetLayout() are cached, the same text with the same align
+// and box is only laid out once.
 class CFont
 {
 public:
 	typedef char CharType;
 
+	enum 
+	{ 
+		GlyphCount = 256,
+		LayoutCacheSize = 256
+	};
+
 	CFont();
 	virtual ~CFont();
 
 	std::vector< types::rect > GetRectsForText( const std::string& text );
+	void GetRectsForText( const std::string& text, std::vector< types::rect >& result );
+
+	// align is one of the IFontAlign::FONT_ALIGN values, or -1 for the text
+	// on one line ignoring the box. The reference is only good until the
+	// next GetLayout(), so copy what you need
+	const CFontLayout& GetLayout( const std::string& text, int align = -1, float box_w = -1, float box_h = -1 );
 
 	types::rect		GetCharPosition( CharType c ) const;
-	void			SetCharPosition( CharType c, const types::rect& r )	{ myCharPositions[ c ] = r; }
+	void			SetCharPosition( CharType c, const types::rect& r );
+	bool			HasChar( CharType c ) const		{ return myHasGlyph[ Index( c ) ]; }
+
+	// the glyph of c, or the fallback glyph if there's no c
+	const types::rect& GetGlyph( CharType c ) const;
+
+	void	SetFallbackChar( CharType c );
+	void	ClearFallbackChar();
+
+	// added to the space between first and second
+	float	GetKerning( CharType first, CharType second ) const;
+	void	SetKerning( CharType first, CharType second, float amount );
 
 	float   GetLineHeight() const;
-	void	SetLineHeight( float lh )		{ myLineHeight = lh; }
+	void	SetLineHeight( float lh )		{ myLineHeight = lh; ClearLayoutCache(); }
 
 	float   GetCharSpace() const			{ return myCharSpace; }
-	void	SetCharSpace( float cs )		{ myCharSpace = cs; }
+	void	SetCharSpace( float cs )		{ myCharSpace = cs; ClearLayoutCache(); }
 
 	float	GetWordSpace() const			{ return myWordSpace; }
-	void	SetWordSpace( float ws )		{ myWordSpace = ws; }
+	void	SetWordSpace( float ws )		{ myWordSpace = ws; ClearLayoutCache(); }
 
 	void		SetTextureFilename( const std::string& filename ) { myTextureFilename = filename; }
 	std::string GetTextureFilename() const { return myTextureFilename; }
@@ -88,10 +129,13 @@ public:
 	void		SetFilename( const std::string& filename ) { myFilename = filename; }
 	std::string GetFilename() const { return myFilename; }
 
-	bool	IsEmpty() const { return myCharPositions.empty(); }
+	bool	IsEmpty() const { return myGlyphTotal == 0; }
 
 	virtual float GetWidth( const std::string& text );
 
+	void	ClearLayoutCache();
+	int		GetLayoutCacheHits() const		{ return myLayoutHits; }
+	int		GetLayoutCacheMisses() const	{ return myLayoutMisses; }
 
 	void Serialize( ceng::CXmlFileSys* filesys );
 
@@ -99,17 +143,24 @@ public:
 
 protected:
 
-	void Clear()
-	{
-		myCharPositions.clear();
-		myTextureFilename.clear();
-		myLineHeight = 0;
-		myCharSpace = 0;
-		myWordSpace = 0;
-	}
+	static int Index( CharType c ) { return (unsigned char)c; }
+
+	void Clear();
+
+	void LayoutText( const std::string& text, int align, float box_w, float box_h, CFontLayout& layout );
 
-	typedef std::map< CharType, types::rect > MapType;
-	MapType	myCharPositions;
+	// the list of the cached layouts from the newest to the oldest
+	void UnlinkLayout( int slot );
+	void LinkNewestLayout( int slot );
+
+	types::rect	myGlyphs[ GlyphCount ];
+	bool		myHasGlyph[ GlyphCount ];
+	int			myGlyphTotal;
+	int			myFallback;
+
+	// ( first << 8 ) | second, myHasKerning tells if first has any pairs
+	ceng::CFlatHashMap< unsigned int, float > myKerning;
+	bool		myHasKerning[ GlyphCount ];
 
 	float	myLineHeight;
 	float	myCharSpace;
@@ -117,6 +168,25 @@ protected:
 
 	std::string myTextureFilename;
 	std::string myFilename;
+
+	struct LayoutCacheEntry
+	{
+		std::string		text;
+		int				align;
+		float			box_w;
+		float			box_h;
+		unsigned int	hash;
+		int				newer;
+		int				older;
+		CFontLayout		layout;
+	};
+
+	std::vector< LayoutCacheEntry >						myLayouts;
+	ceng::CFlatHashMultiMap< unsigned int, int, 1 >		myLayoutIndex;
+	int													myNewestLayout;
+	int													myOldestLayout;
+	int													myLayoutHits;
+	int													myLayoutMisses;
 };
 
 #endif
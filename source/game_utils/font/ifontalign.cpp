@@ -133,6 +133,8 @@ public:
 					result.push_back( r );
 
 					f_pos.x += w;
+					if( i + 1 < (int)text.size() )
+						f_pos.x += font->GetKerning( text[ i ], text[ i + 1 ] );
 				}
 			}
 
@@ -269,6 +271,8 @@ class CFontAlignJustify : public IFontAlignImpl
 					result.push_back( r );
 
 					f_pos.x += w;
+					if( i + 1 < (int)text.size() )
+						f_pos.x += font->GetKerning( text[ i ], text[ i + 1 ] );
 				}
 			}
 			
@@ -0,0 +1,101 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include <sstream>
+#include <vector>
+
+#include "../cfont.h"
+#include "../../../utils/debug.h"
+#include "../../../tester/tester_benchmark.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	const int bench_sprites = 500;
+	const int bench_frames = 200;
+
+	// every sprite gets a new text every frame, but like timers and
+	// counters they keep cycling through the same values
+	std::string BenchmarkText( int sprite, int frame )
+	{
+		std::stringstream ss;
+		ss << "time left " << ( sprite + frame ) % 100;
+		return ss.str();
+	}
+
+	double RunFrames( CFont& font, bool cached, int& glyphs )
+	{
+		std::vector< std::string > texts( bench_sprites );
+		poro::tester::CBenchmarkTimer timer;
+		glyphs = 0;
+		for( int f = 0; f < bench_frames; ++f )
+		{
+			for( int i = 0; i < bench_sprites; ++i )
+			{
+				// this is what CTextSprite::SetText() used to cost every time
+				if( cached == false )
+					font.ClearLayoutCache();
+
+				texts[ i ] = BenchmarkText( i, f );
+				glyphs += (int)font.GetLayout( texts[ i ] ).out_rects.size();
+			}
+		}
+		return timer.GetSeconds();
+	}
+}
+
+int CFontBenchmark()
+{
+	CFont font;
+	for( int c = 32; c < 127; ++c )
+		font.SetCharPosition( (char)c, types::rect( (float)( c % 16 ) * 10.f, (float)( c / 16 ) * 20.f, 10, 20 ) );
+	font.SetKerning( 'a', 'b', -1.f );
+	font.SetLineHeight( 20 );
+
+	const int layouts = bench_sprites * bench_frames;
+	int glyphs = 0;
+
+	test_logger << "CFont layouts, " << bench_sprites << " text sprites x " << bench_frames << " frames" << std::endl;
+	poro::tester::BenchmarkReport( "layout every time", RunFrames( font, false, glyphs ), layouts );
+
+	const int hits = font.GetLayoutCacheHits();
+	const int misses = font.GetLayoutCacheMisses();
+	poro::tester::BenchmarkReport( "cached layout", RunFrames( font, true, glyphs ), layouts );
+
+	test_logger << "  cache hits: " << font.GetLayoutCacheHits() - hits
+		<< ", misses: " << font.GetLayoutCacheMisses() - misses << std::endl;
+
+	// CTextSprite used to draw every glyph on its own
+	test_logger << "  draw calls per frame, one per glyph: " << glyphs / bench_frames
+		<< ", batched: " << bench_sprites << std::endl;
+
+	return 0;
+}
+
+BENCHMARK_REGISTER( CFontBenchmark );
+
+} // end of namespace test
+
+#endif
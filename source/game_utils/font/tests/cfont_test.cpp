@@ -0,0 +1,226 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+#include "../cfont.h"
+#include "../ifontalign.h"
+#include "../../sprite/csprite.h"
+#include "../../../poro/igraphics.h"
+#include "../../../utils/debug.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	// every char is 10 wide, except the ones that aren't there
+	void SetupTestFont( CFont& font )
+	{
+		for( char c = 'a'; c <= 'z'; ++c )
+			font.SetCharPosition( c, types::rect( (float)( c - 'a' ) * 10.f, 0, 10, 20 ) );
+		font.SetCharPosition( ' ', types::rect( 0, 20, 5, 20 ) );
+		font.SetCharPosition( '?', types::rect( 0, 40, 8, 20 ) );
+		font.SetLineHeight( 20 );
+	}
+
+	// keeps the quads of the last DrawTextureQuads()
+	class FontTestGraphics : public poro::IGraphics
+	{
+	public:
+		bool				Init( int, int, bool, const poro::types::string& ) { return true; }
+		poro::ITexture*		LoadTexture( const poro::types::string& ) { return NULL; }
+		void				ReleaseTexture( poro::ITexture* ) { }
+		void				BeginRendering() { }
+		void				EndRendering() { }
+		void				DrawTexture( poro::ITexture*, poro::types::Float32, poro::types::Float32, poro::types::Float32, poro::types::Float32, const poro::types::fcolor&, poro::types::Float32 ) { }
+		void				DrawTexture( poro::ITexture*, poro::types::vec2*, poro::types::vec2*, int, const poro::types::fcolor& ) { }
+
+		void DrawTextureQuads( poro::ITexture*, poro::types::vec2* vertices, poro::types::vec2*, int count, const poro::types::fcolor& )
+		{
+			quads.assign( vertices, vertices + count );
+		}
+
+		std::vector< poro::types::vec2 > quads;
+	};
+
+	// without a sprite factory, the font is the test's
+	class FontTestTextSprite : public CTextSprite
+	{
+	public:
+		explicit FontTestTextSprite( CFont* font ) { myFont = font; }
+		~FontTestTextSprite() { myFont = NULL; }
+	};
+
+}
+
+int CFontTest()
+{
+	// the glyph table
+	{
+		CFont font;
+		test_assert( font.IsEmpty() );
+		SetupTestFont( font );
+		test_assert( font.IsEmpty() == false );
+
+		test_assert( font.HasChar( 'b' ) );
+		test_assert( font.HasChar( 'B' ) == false );
+		test_assert( font.GetCharPosition( 'b' ).x == 10.f );
+		test_assert( font.GetCharPosition( 'B' ).empty() );
+
+		// chars over 127 work too
+		font.SetCharPosition( (char)0xE4, types::rect( 0, 60, 12, 20 ) );
+		test_assert( font.HasChar( (char)0xE4 ) );
+		test_assert( font.GetWidth( "\xE4" ) == 12.f );
+
+		// no fallback, the missing ones are empty
+		std::vector< types::rect > rects = font.GetRectsForText( "aB" );
+		test_assert( rects.size() == 2 );
+		test_assert( rects[ 1 ].empty() );
+		test_assert( font.GetWidth( "aB" ) == 10.f );
+
+		font.SetFallbackChar( '?' );
+		rects = font.GetRectsForText( "aB" );
+		test_assert( rects[ 1 ].y == 40.f );
+		test_assert( font.GetWidth( "aB" ) == 18.f );
+		test_assert( font.GetCharPosition( 'B' ).empty() );
+
+		font.ClearFallbackChar();
+		test_assert( font.GetWidth( "aB" ) == 10.f );
+	}
+
+	// kerning
+	{
+		CFont font;
+		SetupTestFont( font );
+		font.SetCharSpace( 1 );
+		test_assert( font.GetWidth( "av" ) == 22.f );
+
+		font.SetKerning( 'a', 'v', -3 );
+		test_assert( font.GetKerning( 'a', 'v' ) == -3.f );
+		test_assert( font.GetKerning( 'v', 'a' ) == 0 );
+		test_assert( font.GetKerning( 'b', 'v' ) == 0 );
+		test_assert( font.GetWidth( "av" ) == 19.f );
+		test_assert( font.GetWidth( "va" ) == 22.f );
+
+		const CFontLayout& layout = font.GetLayout( "ava" );
+		test_assert( layout.out_rects.size() == 3 );
+		test_assert( layout.out_rects[ 1 ].x == 8.f );
+		test_assert( layout.out_rects[ 2 ].x == 19.f );
+		test_assert( layout.size.x == 29.f );
+		test_assert( layout.size.y == 20.f );
+	}
+
+	// the layout cache
+	{
+		CFont font;
+		SetupTestFont( font );
+
+		const CFontLayout& layout = font.GetLayout( "abc" );
+		test_assert( layout.in_rects.size() == 3 );
+		test_assert( layout.in_rects[ 2 ].x == 20.f );
+		test_assert( layout.out_rects[ 2 ].x == 20.f );
+		test_assert( font.GetLayoutCacheMisses() == 1 );
+
+		font.GetLayout( "abc" );
+		test_assert( font.GetLayoutCacheHits() == 1 );
+
+		// the align and the box are a part of the key
+		font.GetLayout( "abc", IFontAlign::FONT_ALIGN_RIGHT, 100, 50 );
+		font.GetLayout( "abc", IFontAlign::FONT_ALIGN_RIGHT, 200, 50 );
+		test_assert( font.GetLayoutCacheMisses() == 3 );
+
+		const CFontLayout& right = font.GetLayout( "abc", IFontAlign::FONT_ALIGN_RIGHT, 100, 50 );
+		test_assert( font.GetLayoutCacheHits() == 2 );
+		test_assert( right.size.x == 100.f );
+
+		// the same as asking the align directly
+		std::vector< types::rect > expected = IFontAlign::GetAlign( IFontAlign::FONT_ALIGN_RIGHT )->GetRectPositions( 
+			font.GetRectsForText( "abc" ), "abc", types::rect( 0, 0, 100, 50 ), &font );
+		test_assert( expected.size() == right.out_rects.size() );
+		for( std::size_t i = 0; i < expected.size(); ++i )
+			test_assert( expected[ i ].x == right.out_rects[ i ].x && expected[ i ].y == right.out_rects[ i ].y );
+
+		// changing the font throws the layouts away
+		font.SetCharPosition( 'a', types::rect( 0, 0, 30, 20 ) );
+		test_assert( font.GetLayout( "abc" ).out_rects[ 1 ].x == 30.f );
+		test_assert( font.GetLayoutCacheMisses() == 4 );
+
+		// the oldest goes when it's full
+		for( int i = 0; i < CFont::LayoutCacheSize + 10; ++i )
+		{
+			std::string text( 1, (char)( 'a' + i % 26 ) );
+			text += (char)( 'a' + i / 26 );
+			font.GetLayout( text );
+		}
+		const int misses = font.GetLayoutCacheMisses();
+		font.GetLayout( "ya" );
+		test_assert( font.GetLayoutCacheMisses() == misses );
+		font.GetLayout( "abc" );
+		test_assert( font.GetLayoutCacheMisses() == misses + 1 );
+
+		// using one makes it the newest, "la" would have been the next to go
+		font.GetLayout( "la" );
+		font.GetLayout( "new" );
+		font.GetLayout( "la" );
+		test_assert( font.GetLayoutCacheMisses() == misses + 2 );
+		test_assert( font.GetLayoutCacheHits() == 5 );
+		font.GetLayout( "ma" );
+		test_assert( font.GetLayoutCacheMisses() == misses + 3 );
+	}
+
+	// a scaled text sprite scales the glyphs but not their positions, like
+	// it did before the layouts were cached
+	{
+		CFont font;
+		SetupTestFont( font );
+		font.SetCharSpace( 2 );
+
+		FontTestTextSprite sprite( &font );
+		sprite.SetText( "ab c" );
+		sprite.MoveTo( types::vector2( 100, 50 ) );
+		sprite.SetScale( 2, 2 );
+
+		FontTestGraphics graphics;
+		sprite.Draw( &graphics );
+		test_assert( graphics.quads.size() == 4 * 4 );
+
+		const std::vector< types::rect > rects = font.GetRectsForText( "ab c" );
+		float x = 0;
+		for( std::size_t i = 0; i < rects.size(); ++i )
+		{
+			const poro::types::vec2* quad = &graphics.quads[ i * 4 ];
+			test_assert( quad[ 0 ].x == 100.f + x );
+			test_assert( quad[ 0 ].y == 50.f );
+			test_assert( quad[ 2 ].x == 100.f + x + rects[ i ].w * 2.f );
+			test_assert( quad[ 2 ].y == 50.f + rects[ i ].h * 2.f );
+
+			x += rects[ i ].w + font.GetCharSpace();
+		}
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( CFontTest );
+
+} // end of namespace test
+
+#endif
@@ -26,6 +26,8 @@
 #include "../font/cfont.h"
 #include "../font/ifontalign.h"
 
+#include <algorithm>
+
 
 
 namespace ceng {
@@ -158,6 +160,8 @@ CSprite::CSprite() :
 	myTextures( 1 ),
 	myHidden( false ),
 	myAnimations(),
+	myAnimationIndex(),
+	myIndexedAnimations( 0 ),
 	myAnimation( NULL ),
 	myAnimationPaused( false ),
 	myW( 0 ),
@@ -200,76 +204,95 @@ CSprite::~CSprite()
 
 bool CSprite::DrawRect( const types::rect& rect, poro::IGraphics* graphics )
 {
+	if( graphics ) 
 	{
+		static poro::types::vec2 temp_verts[ 4 ];
+		static poro::types::vec2 tex_coords[ 4 ];
 
-		types::rect d3d_rect_dest(rect.x, rect.y, rect.w, rect.h );
-		types::rect d3d_rect_trgt( myX, myY, rect.w * myScale.x, rect.h * myScale.y );
-
-		ceng::CCameraResult result;
-		/*if ( global_camera ) 
-		{
-			result = global_camera->Transform( 
-			ceng::CRect< float >( (float)d3d_rect_trgt.x, (float)d3d_rect_trgt.y, (float)(d3d_rect_trgt.w), (float)(d3d_rect_trgt.h)  ),
-				myRotation );
-		}
-		else */
-		{
-			result.rect.x = (float)d3d_rect_trgt.x;
-			result.rect.y = (float)d3d_rect_trgt.y;
-			result.rect.w = (float)d3d_rect_trgt.w;
-			result.rect.h = (float)d3d_rect_trgt.h;
-			result.rotation = myRotation;
-		}
+		GetRectQuad( rect, temp_verts, tex_coords );
 
 		poro::types::fcolor color_me = poro::GetFColor( myColor[ 0 ], myColor[ 1 ], myColor[ 2 ], myColor[ 3 ] );
-	
-		if( graphics ) 
-		{
 
-			static poro::types::vec2 temp_verts[ 4 ];
-			static poro::types::vec2 tex_coords[ 4 ];
-
-			temp_verts[ 0 ].x = (float)result.rect.x;
-			temp_verts[ 0 ].y = (float)result.rect.y;
-			temp_verts[ 2 ].x = (float)(result.rect.x + result.rect.w);
-			temp_verts[ 2 ].y = (float)result.rect.y;
-			temp_verts[ 1 ].x = (float)result.rect.x;
-			temp_verts[ 1 ].y = (float)(result.rect.y + result.rect.h);
-			temp_verts[ 3 ].x = (float)(result.rect.x + result.rect.w);
-			temp_verts[ 3 ].y = (float)(result.rect.y + result.rect.h);
-
-			tex_coords[ 0 ].x = d3d_rect_dest.x;
-			tex_coords[ 0 ].y = d3d_rect_dest.y;
-			tex_coords[ 1 ].x = d3d_rect_dest.x;
-			tex_coords[ 1 ].y = d3d_rect_dest.y + d3d_rect_dest.h;
-			tex_coords[ 2 ].x = d3d_rect_dest.x + d3d_rect_dest.w;
-			tex_coords[ 2 ].y = d3d_rect_dest.y;
-			tex_coords[ 3 ].x = d3d_rect_dest.x + d3d_rect_dest.w;
-			tex_coords[ 3 ].y = d3d_rect_dest.y + d3d_rect_dest.h;
-
-			if( result.rotation != 0 )
-			{
-				types::vector2 center_p;
-				center_p.x = temp_verts[ 0 ].x + ( ( temp_verts[ 3 ].x - temp_verts[ 0 ].x ) * 0.5f );
-				center_p.y = temp_verts[ 0 ].y + ( ( temp_verts[ 3 ].y - temp_verts[ 0 ].y ) * 0.5f );
+		graphics->PushVertexMode(poro::IGraphics::VERTEX_MODE_TRIANGLE_FAN);
+		graphics->DrawTexture( myTexture, temp_verts, tex_coords, 4, color_me );
+		graphics->PopVertexMode();
+	}
 
-				for( int i = 0; i < 4; ++i )
-				{
-					types::vector2 p( temp_verts[ i ] );
-					p = p.Rotate( center_p, result.rotation );
-					temp_verts[ i ].x = p.x;
-					temp_verts[ i ].y = p.y;
-				}
-			}
-			
-			graphics->PushVertexMode(poro::IGraphics::VERTEX_MODE_TRIANGLE_STRIP);
-			graphics->DrawTexture( myTexture, temp_verts, tex_coords, 4, color_me );
-			graphics->PopVertexMode();
+	return true;
+}
+
+void CSprite::GetRectQuad( const types::rect& rect, poro::types::vec2* temp_verts, poro::types::vec2* tex_coords ) const
+{
+	types::rect d3d_rect_dest(rect.x, rect.y, rect.w, rect.h );
+	types::rect d3d_rect_trgt( myX, myY, rect.w * myScale.x, rect.h * myScale.y );
+
+	ceng::CCameraResult result;
+	{
+		result.rect.x = (float)d3d_rect_trgt.x;
+		result.rect.y = (float)d3d_rect_trgt.y;
+		result.rect.w = (float)d3d_rect_trgt.w;
+		result.rect.h = (float)d3d_rect_trgt.h;
+		result.rotation = myRotation;
+	}
+
+	temp_verts[ 0 ].x = (float)result.rect.x;
+	temp_verts[ 0 ].y = (float)result.rect.y;
+	temp_verts[ 1 ].x = (float)result.rect.x;
+	temp_verts[ 1 ].y = (float)(result.rect.y + result.rect.h);
+	temp_verts[ 2 ].x = (float)(result.rect.x + result.rect.w);
+	temp_verts[ 2 ].y = (float)(result.rect.y + result.rect.h);
+	temp_verts[ 3 ].x = (float)(result.rect.x + result.rect.w);
+	temp_verts[ 3 ].y = (float)result.rect.y;
+
+	tex_coords[ 0 ].x = d3d_rect_dest.x;
+	tex_coords[ 0 ].y = d3d_rect_dest.y;
+	tex_coords[ 1 ].x = d3d_rect_dest.x;
+	tex_coords[ 1 ].y = d3d_rect_dest.y + d3d_rect_dest.h;
+	tex_coords[ 2 ].x = d3d_rect_dest.x + d3d_rect_dest.w;
+	tex_coords[ 2 ].y = d3d_rect_dest.y + d3d_rect_dest.h;
+	tex_coords[ 3 ].x = d3d_rect_dest.x + d3d_rect_dest.w;
+	tex_coords[ 3 ].y = d3d_rect_dest.y;
+
+	if( result.rotation != 0 )
+	{
+		types::vector2 center_p;
+		center_p.x = temp_verts[ 0 ].x + ( ( temp_verts[ 2 ].x - temp_verts[ 0 ].x ) * 0.5f );
+		center_p.y = temp_verts[ 0 ].y + ( ( temp_verts[ 2 ].y - temp_verts[ 0 ].y ) * 0.5f );
+
+		for( int i = 0; i < 4; ++i )
+		{
+			types::vector2 p( temp_verts[ i ] );
+			p = p.Rotate( center_p, result.rotation );
+			temp_verts[ i ].x = p.x;
+			temp_verts[ i ].y = p.y;
 		}
+	}
+}
 
-		return true;
+types::rect CSprite::GetBounds() const
+{
+	return GetQuadBounds( types::rect( 0, 0, myW, myH ) );
+}
+
+types::rect CSprite::GetQuadBounds( const types::rect& rect ) const
+{
+	poro::types::vec2 verts[ 4 ];
+	poro::types::vec2 tex_coords[ 4 ];
+	GetRectQuad( rect, verts, tex_coords );
+
+	types::vector2 min_p( verts[ 0 ].x, verts[ 0 ].y );
+	types::vector2 max_p( min_p );
+	for( int i = 1; i < 4; ++i )
+	{
+		min_p.x = std::min( min_p.x, verts[ i ].x );
+		min_p.y = std::min( min_p.y, verts[ i ].y );
+		max_p.x = std::max( max_p.x, verts[ i ].x );
+		max_p.y = std::max( max_p.y, verts[ i ].y );
 	}
+
+	return types::rect( min_p.x, min_p.y, max_p.x - min_p.x, max_p.y - min_p.y );
 }
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void DrawSprite( CSprite* sprite, poro::IGraphics* graphics )
@@ -318,21 +341,56 @@ void CSprite::Update( unsigned int delta_time )
 }
 //=============================================================================
 
+CAnimation* CSprite::FindAnimation( const ceng::CNameId& name )
+{
+	if( myIndexedAnimations != myAnimations.size() )
+		RebuildAnimationIndex();
+
+	CAnimation** result = myAnimationIndex.FindValue( name );
+	return result ? *result : NULL;
+}
+
+void CSprite::RebuildAnimationIndex()
+{
+	myAnimationIndex.Clear();
+	for( unsigned int i = 0; i < myAnimations.size(); ++i )
+	{
+		if( myAnimations[ i ] )
+			myAnimationIndex.Insert( ceng::CNameId( myAnimations[ i ]->myName ), myAnimations[ i ] );
+	}
+
+	myIndexedAnimations = myAnimations.size();
+}
+
+ceng::CNameId CSprite::FindAnimationName( const std::string& name )
+{
+	if( myIndexedAnimations != myAnimations.size() )
+		RebuildAnimationIndex();
+
+	return ceng::CNameId::Find( name );
+}
+
 void CSprite::PlayAnimation( const std::string& name )
 {
+	const ceng::CNameId id = FindAnimationName( name );
+	if( id.Empty() == false )
+		PlayAnimation( id );
+	else if( name == "death" )
+		Kill();
+}
+
+void CSprite::PlayAnimation( const ceng::CNameId& name )
+{
+	CAnimation* animation = FindAnimation( name );
 	if( myAnimation &&
-		myAnimation->myName == name )
+		myAnimation == animation )
 		return;
 
 	bool found = false;
-	for( unsigned int i = 0; i < myAnimations.size(); ++i )
+	if( animation )
 	{
-		if( myAnimations[ i ]->myName == name )
-		{
-			myAnimation = myAnimations[ i ];
-			found = true;
-			break;
-		}
+		myAnimation = animation;
+		found = true;
 	}
 
 	if( found )
@@ -349,7 +407,7 @@ void CSprite::PlayAnimation( const std::string& name )
 			myH = (float)myTexture->GetHeight();
 		}
 	}
-	else if( name == "death" )
+	else if( name.GetString() == "death" )
 	{
 		Kill();
 	}
@@ -386,73 +444,55 @@ void CTextSprite::SetText( const std::string& text )
 
 	if( myFont && myText != text )
 	{
-		
 		myText = text;
 
-		myInRects = myFont->GetRectsForText( text );
-		myOutRects.clear();
-
-		if( myFontAlign == NULL )
-		{
-			types::vector2 f_pos( 0, 0 );
-			for( std::size_t i = 0; i < myInRects.size(); ++i )
-			{
-				types::rect font_rect = myInRects[ i ];
-				font_rect.x = f_pos.x;
-				font_rect.y = f_pos.y;
-
-				myOutRects.push_back( font_rect );
-
-				f_pos.x += ( font_rect.w + myFont->GetCharSpace() )* myScale.x;
-			}
-
-			// figure out myRealW && myRealH
-			types::vector2 min_p( 100000.f, 100000.f );
-			types::vector2 max_p( -100000.f, -100000.f );
-			for( std::size_t i = 0; i < myOutRects.size(); ++i )
-			{
-				if( myOutRects[ i ].w >= 0 &&
-					myOutRects[ i ].h >= 0 )
-				{
-					min_p.x = ceng::math::Min( min_p.x, myOutRects[ i ].x );
-					min_p.y = ceng::math::Min( min_p.y, myOutRects[ i ].y );
-					max_p.x = ceng::math::Max( max_p.x, myOutRects[ i ].x + myOutRects[ i ].w );
-					max_p.y = ceng::math::Max( max_p.y, myOutRects[ i ].y + myOutRects[ i ].h );
-				}
-
-				myRealW = max_p.x - min_p.x;
-				myRealH = max_p.y - min_p.y;
-			}
-		}
-		else if( myFontAlign )
-		{
-			myOutRects = myFontAlign->GetRectPositions( myInRects, myText, types::rect( 0, 0, myTextBox.w, myTextBox.h ), myFont );
-			myRealW = myTextBox.w;
-			myRealH = myTextBox.h;
-		}
-
+		// score counters and such set the same few texts over and over again,
+		// so the font keeps the layouts around
+		const CFontLayout& layout = myFontAlign ?
+			myFont->GetLayout( myText, myFontAlign->GetAlignmentType(), myTextBox.w, myTextBox.h ) :
+			myFont->GetLayout( myText );
 
+		myInRects = layout.in_rects;
+		myOutRects = layout.out_rects;
+		myRealW = layout.size.x;
+		myRealH = layout.size.y;
 	}
 }
 
 bool CTextSprite::Draw( poro::IGraphics* graphics )
 { 
+	if( graphics == NULL )
+		return true;
+
+	cassert( myOutRects.size() <= myInRects.size() );
+
+	myQuadVertices.resize( myOutRects.size() * 4 );
+	myQuadTexCoords.resize( myOutRects.size() * 4 );
+
+	// SetText() has always laid the text out unscaled, so only the glyphs
+	// are scaled (by GetRectQuad()), not the positions
 	float temp_x = myX;
 	float temp_y = myY;
+	int count = 0;
 	for( std::size_t i = 0; i < myOutRects.size(); ++i )
 	{
-		cassert( i < myInRects.size() );
-
 		if( myOutRects[ i ].w > 0 && myOutRects[ i ].h > 0 )
 		{
-			
 			myX = myOutRects[ i ].x + temp_x;
 			myY = myOutRects[ i ].y + temp_y;
-			DrawRect( myInRects[ i ], graphics );
+			GetRectQuad( myInRects[ i ], &myQuadVertices[ count ], &myQuadTexCoords[ count ] );
+			count += 4;
 		}
 	}
 	myX = temp_x;
 	myY = temp_y;
+
+	if( count > 0 )
+	{
+		poro::types::fcolor color_me = poro::GetFColor( myColor[ 0 ], myColor[ 1 ], myColor[ 2 ], myColor[ 3 ] );
+		graphics->DrawTextureQuads( myTexture, &myQuadVertices[ 0 ], &myQuadTexCoords[ 0 ], count, color_me );
+	}
+
 	return true;
 }
 
@@ -661,6 +701,7 @@ void CSprite::SerializeImpl( ceng::CXmlFileSys* filesys, bool serialize_textures
 		myDeleteAnimations = true;
 		PointerVectorSerializeHelper< CAnimation > helper(myAnimations,"Animation");
 		XML_BindAlias( filesys, helper, "Animations" );
+		RebuildAnimationIndex();
 	}
 	
 	
@@ -787,19 +828,23 @@ bool CSpriteSheet::Draw( poro::IGraphics* graphics )
 
 void CSpriteSheet::PlayAnimation( const std::string& name )
 {
+	const ceng::CNameId id = FindAnimationName( name );
+	if( id.Empty() == false )
+		PlayAnimation( id );
+}
+
+void CSpriteSheet::PlayAnimation( const ceng::CNameId& name )
+{
+	CAnimation* animation = FindAnimation( name );
 	if( myAnimation &&
-	   myAnimation->myName == name )
+	   myAnimation == animation )
 		return;
 	
 	bool found = false;
-	for( unsigned int i = 0; i < myAnimations.size(); ++i )
+	if( animation )
 	{
-		if( myAnimations[ i ]->myName == name )
-		{
-			myAnimation = myAnimations[ i ];
-			found = true;
-			break;
-		}
+		myAnimation = animation;
+		found = true;
 	}
 	
 	if( found )
@@ -924,6 +969,15 @@ void CSpriteSheet::Serialize( ceng::CXmlFileSys* filesys )
 	
 }
 
+types::rect CSpriteSheet::GetBounds() const
+{
+	std::map< int, types::rect >::const_iterator i = mRects.find( mSelectedRect );
+	if( i == mRects.end() )
+		return CSprite::GetBounds();
+
+	return GetQuadBounds( i->second );
+}
+
 void CSpriteSheet::Resize( float w, float h ) { 
 	if( myW == 0 || myH == 0 ) {
 		myScale.Set( 0, 0 ); 
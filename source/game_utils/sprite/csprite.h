@@ -27,6 +27,7 @@
 #include "../../types.h"
 #include "utils/math/math_utils.h"
 #include "utils/string/enum.h"
+#include "utils/string/cnameid.h"
 
 #include <vector>
 #include <map>
@@ -120,9 +121,17 @@ public:
 	virtual bool Draw( poro::IGraphics* graphics );
 	bool DrawRect( const types::rect& rect, poro::IGraphics* graphics );
 
+	// the quad DrawRect() would draw, the vertices go around it the way
+	// IGraphics::DrawTextureQuads() wants them
+	void GetRectQuad( const types::rect& rect, poro::types::vec2* vertices, poro::types::vec2* tex_coords ) const;
+
+	// the area of the screen Draw() touches, rotation included
+	virtual types::rect GetBounds() const;
+
 	virtual void Update( unsigned int delta_time );
 
 	virtual void PlayAnimation( const std::string& name );
+	virtual void PlayAnimation( const ceng::CNameId& name );
 	void AddAnimation( CAnimation* ani );
 	void PauseAnimation();
 	void ResumeAnimation();
@@ -136,11 +145,23 @@ public:
 protected:
 
 	void SerializeImpl( ceng::CXmlFileSys* filesys, bool serialize_textures, bool serialize_animations=false );
+	types::rect GetQuadBounds( const types::rect& rect ) const;
+
+	// the first animation with the name. The index follows AddAnimation() and
+	// the size of myAnimations, call RebuildAnimationIndex() after renaming
+	CAnimation*	FindAnimation( const ceng::CNameId& name );
+	void		RebuildAnimationIndex();
+
+	// the id of the name without interning it. The index interns the names
+	// of the animations, so if this is empty there's no such animation
+	ceng::CNameId FindAnimationName( const std::string& name );
 
 	Image*						myTexture;
 	std::vector< Image* >		myTextures;
 	bool						myHidden;
 	std::vector< CAnimation* >	myAnimations;
+	ceng::CFlatHashMap< ceng::CNameId, CAnimation* > myAnimationIndex;
+	std::size_t					myIndexedAnimations;
 	CAnimation*					myAnimation;
 	bool						myAnimationPaused;
 	bool						myMirrored;
@@ -159,6 +180,8 @@ protected:
 	CSpriteFactory*				myFactory;
 	int							myZ;
 	bool						myDeleteAnimations;
+	// GetBounds() from the last time the factory was told about a change
+	types::rect					myDirtyBounds;
 
 	friend class CSpriteFactory;
 };
@@ -182,6 +205,7 @@ public:
 	virtual bool Draw( poro::IGraphics* graphics );
 
 	virtual types::vector2 GetSize() const { return types::vector2( myRealW * myScale.x, myRealH * myScale.y ); }
+	virtual types::rect GetBounds() const { return types::rect( myX, myY, myRealW * myScale.x, myRealH * myScale.y ); }
 
 	void SetAlign( int align_type );
 	void SetTextBox( const types::rect& text_box );
@@ -212,6 +236,10 @@ protected:
 	std::vector< types::rect > myOutRects;
 	types::rect myTextBox;
 
+	// the glyph quads for drawing them all with one call
+	std::vector< poro::types::vec2 > myQuadVertices;
+	std::vector< poro::types::vec2 > myQuadTexCoords;
+
 	friend class CSpriteFactory;
 };
 
@@ -235,7 +263,9 @@ public:
 	virtual void Update( unsigned int delta_time );
 	virtual bool Draw( poro::IGraphics* graphics );
 	virtual void PlayAnimation( const std::string& name );
+	virtual void PlayAnimation( const ceng::CNameId& name );
 	virtual void Resize( float w, float h );
+	virtual types::rect GetBounds() const;
 	
 	virtual int GetType() const { return sprite_sheet; }
 	virtual void Serialize( ceng::CXmlFileSys* filesys );
@@ -376,8 +406,14 @@ inline bool CSprite::Draw( poro::IGraphics* graphics ) {
 }
 
 inline void CSprite::AddAnimation( CAnimation* ani ) { 
-	if( ani ) 
+	if( ani ) {
+		if( myIndexedAnimations != myAnimations.size() )
+			RebuildAnimationIndex();
+
 		myAnimations.push_back( ani ); 
+		myAnimationIndex.Insert( ceng::CNameId( ani->myName ), ani );
+		myIndexedAnimations = myAnimations.size();
+	}
 }
 
 inline void CSprite::PauseAnimation() { 
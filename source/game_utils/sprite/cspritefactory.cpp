@@ -21,12 +21,16 @@
 
 #include "cspritefactory.h"
 #include "../font/cfont.h"
+#include "../../utils/rect/crect_functions.h"
+#include "../../utils/memorypool/callocationtracker.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 
 CSpriteFactory::CSpriteFactory( poro::IGraphics* graphics ) : 
 	mySprites(), 
-	myGraphics( graphics ) 
+	myGraphics( graphics ),
+	myTrackChanges( false ),
+	myChangedRects()
 { 
 }
 
@@ -65,7 +69,10 @@ CSprite* CSpriteFactory::LoadSprite( const std::string& filename )
 	}	
 
 	if( result )
+	{
 		mySprites.push_back( result );
+		InvalidateSprite( result );
+	}
 
 	return result;
 }
@@ -91,15 +98,69 @@ CSprite* CSpriteFactory::LoadSpriteFromImage( const std::string& filename )
 
 void CSpriteFactory::Update( unsigned int delta_time )
 {
+	CENG_ALLOCATION_TAG( ceng::ALLOCATION_TAG_RENDER );
+
 	for( std::list< CSprite* >::iterator i = mySprites.begin(); 
 		i != mySprites.end(); ++i )
 	{
-		(*i)->Update( delta_time );
+		if( myTrackChanges && (*i)->myAnimation )
+		{
+			CSprite* sprite = (*i);
+			const Image* texture = sprite->myTexture;
+			const unsigned int frame = sprite->myCurrentFrame;
+
+			sprite->Update( delta_time );
+
+			if( sprite->myTexture != texture || sprite->myCurrentFrame != frame )
+				InvalidateSprite( sprite );
+		}
+		else
+		{
+			(*i)->Update( delta_time );
+		}
 	}
 }
 //-----------------------------------------------------------------------------
 
 void CSpriteFactory::Draw( poro::IGraphics* graphics )
+{
+	CENG_ALLOCATION_TAG( ceng::ALLOCATION_TAG_RENDER );
+	DrawAndRelease( graphics );
+}
+//-----------------------------------------------------------------------------
+
+int CSpriteFactory::Draw( poro::IGraphics* graphics, const types::rect& area )
+{
+	CENG_ALLOCATION_TAG( ceng::ALLOCATION_TAG_RENDER );
+
+	int drawn = 0;
+	for( std::list< CSprite* >::iterator i = mySprites.begin(); 
+		i != mySprites.end(); ++i )
+	{
+		CSprite* current = (*i);
+		if( current->IsDead() || current->IsHidden() )
+			continue;
+
+		// while tracking the bounds are kept up to date, no need to go 
+		// through the quads for every area
+		if( ceng::RectHit( myTrackChanges ? current->myDirtyBounds : current->GetBounds(), area ) )
+		{
+			DrawSprite( current, graphics );
+			++drawn;
+		}
+	}
+
+	return drawn;
+}
+//-----------------------------------------------------------------------------
+
+void CSpriteFactory::ReleaseDeadSprites()
+{
+	DrawAndRelease( NULL );
+}
+//-----------------------------------------------------------------------------
+
+void CSpriteFactory::DrawAndRelease( poro::IGraphics* graphics )
 {
 	std::list< CSprite* > move_to_back;
 	CSprite* current = NULL;
@@ -109,14 +170,18 @@ void CSpriteFactory::Draw( poro::IGraphics* graphics )
 		current = (*i);
 		if( current->IsDead() == false && (current)->myMoveToBack == false )
 		{
-			if( current->IsHidden() == false ) DrawSprite( current, graphics );
+			if( graphics && current->IsHidden() == false ) DrawSprite( current, graphics );
 			++i;
 		}
 		else 
 		{
-			if( current->myMoveToBack )
+			if( graphics && current->myMoveToBack )
 				DrawSprite( current, graphics );
 
+			// gone or drawn in a different order
+			if( myTrackChanges )
+				Invalidate( current->myDirtyBounds );
+
 			std::list< CSprite* >::iterator remove = i;
 			++i;
 			mySprites.erase( remove );
@@ -128,6 +193,8 @@ void CSpriteFactory::Draw( poro::IGraphics* graphics )
 			}
 			else
 			{
+				// already out of the list, RemoveSprite() would assert
+				current->myFactory = NULL;
 				delete current;
 			}
 		}
@@ -166,6 +233,45 @@ void CSpriteFactory::RemoveSprite( CSprite* sprite )
 	}
 
 	cassert( count == 1 && "This should not happen" );
+
+	if( myTrackChanges )
+		Invalidate( sprite->myDirtyBounds );
+}
+//-----------------------------------------------------------------------------
+
+void CSpriteFactory::SetTrackChanges( bool value )
+{
+	if( value && myTrackChanges == false )
+	{
+		// nobody has told us about the changes so far
+		for( std::list< CSprite* >::iterator i = mySprites.begin(); i != mySprites.end(); ++i )
+			(*i)->myDirtyBounds = (*i)->GetBounds();
+	}
+
+	myTrackChanges = value;
+	myChangedRects.clear();
+}
+
+void CSpriteFactory::InvalidateSprite( CSprite* sprite )
+{
+	if( myTrackChanges == false || sprite == NULL )
+		return;
+
+	Invalidate( sprite->myDirtyBounds );
+	sprite->myDirtyBounds = sprite->GetBounds();
+	Invalidate( sprite->myDirtyBounds );
+}
+
+void CSpriteFactory::Invalidate( const types::rect& area )
+{
+	if( myTrackChanges && area.w > 0 && area.h > 0 )
+		myChangedRects.push_back( area );
+}
+
+void CSpriteFactory::TakeChangedRects( std::vector< types::rect >& result )
+{
+	result.clear();
+	result.swap( myChangedRects );
 }
 //-----------------------------------------------------------------------------
 
@@ -203,6 +309,7 @@ CTextSprite* CSpriteFactory::LoadTextSprite( const std::string& font_filename )
 	// result->mySpriteFactory = this;
 	
 	mySprites.push_back( result );
+	InvalidateSprite( result );
 	// InsertSpriteToZPosition( mySprites, result, z_value );
 	
 	Image* image = GetImage( image_filename );
@@ -25,6 +25,7 @@
 #include <map>
 #include <list>
 #include <string>
+#include <vector>
 
 #include "poro/igraphics.h"
 #include "poro/iplatform.h"
@@ -63,8 +64,33 @@ public:
 
 	void			Draw( poro::IGraphics* graphics );
 
+	//-------------------------------------------------------------------------
+	// Dirty rectangles. While tracking changes the factory collects the areas
+	// that need to be redrawn: sprites that were invalidated, changed their
+	// animation frame, died or were removed. Changes made straight to a
+	// sprite aren't seen, call InvalidateSprite() after them.
+
+	void			SetTrackChanges( bool value );
+	bool			GetTrackChanges() const { return myTrackChanges; }
+
+	// adds the old and the new bounds of the sprite
+	void			InvalidateSprite( CSprite* sprite );
+	void			Invalidate( const types::rect& area );
+
+	// swaps the collected rects into result
+	void			TakeChangedRects( std::vector< types::rect >& result );
+
+	// draws only the sprites that overlap the area, in the same order Draw()
+	// would. Returns how many were drawn. Doesn't release the dead sprites.
+	int				Draw( poro::IGraphics* graphics, const types::rect& area );
+	void			ReleaseDeadSprites();
+
+	int				GetSpriteCount() const { return (int)mySprites.size(); }
+
 
 private:
+	// releases the dead sprites, draws the others if graphics isn't NULL
+	void			DrawAndRelease( poro::IGraphics* graphics );
 	
 	CSprite* NewSprite( int type );
 	CSprite* LoadSpriteFromXmlNode( ceng::CXmlNode* root_element );
@@ -73,6 +99,9 @@ private:
 
 	std::list< CSprite* >			mySprites;
 	poro::IGraphics*				myGraphics;
+
+	bool							myTrackChanges;
+	std::vector< types::rect >		myChangedRects;
 };
 
 //------------------------------------------------------------------------------
@@ -46,6 +46,9 @@ public:
 	virtual std::string		GetName() const { return mName; }
 
 	virtual bool UsesPointer( void* pointer ) { return false; } 
+
+	// the pointers UsesPointer() is true for, so the users can be indexed
+	virtual int GetPointers( void* pointers[ 2 ] ) const { return 0; }
 protected:
 	std::string mName;
 };
@@ -94,6 +97,12 @@ public:
 		return ( (void*)(myTarget) == pointer );
 	}
 
+	virtual int GetPointers( void* pointers[ 2 ] ) const
+	{
+		pointers[ 0 ] = (void*)myTarget;
+		return 1;
+	}
+
 	bool myDead;
 	T* myTarget;
 	T myStartValue;
@@ -146,6 +155,16 @@ public:
 		return false;
 	}
 
+	virtual int GetPointers( void* pointers[ 2 ] ) const
+	{
+		int count = 0;
+		if( myGetter.GetPointer() ) 
+			pointers[ count++ ] = myGetter.GetPointer();
+		if( mySetter.GetPointer() && mySetter.GetPointer() != myGetter.GetPointer() ) 
+			pointers[ count++ ] = mySetter.GetPointer();
+		return count;
+	}
+
 
 	bool myDead;
 	ceng::CFunctionPtr<> myGetter;
@@ -26,89 +26,147 @@
 // updates all gtweens and removes the dead gtweens from the list as well
 void UpdateGTweens( float dt )
 {
-	std::list< GTween* > release_us;
-	std::list< GTween* >& update_list = ceng::CAutoList< GTween >::GetList();
-
-
-	for( std::list< GTween* >::iterator i = update_list.begin();
-		i != update_list.end(); ++i )
-	{
-		GTween* tween = *i;
-		cassert( tween );
-		tween->Update( dt );
-		if( tween->IsDead() )
-			release_us.push_back( tween );
-		
-	}
-
-	// release the dead tweens
-	for( std::list< GTween* >::iterator i = release_us.begin();
-		i != release_us.end(); ++i )
-	{
-		GTween* tween = *i;
-		delete tween;
-	}
+	GTweenManager::GetInstance().Update( dt );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 GTween::GTween() :
-	ceng::CAutoList< GTween >(),
 	mDirty( false ),
 	mDelay( 0 ),
 	mDuration( 1.f ),
 	mTimer( 0 ),
 	mDead( false ),
-	mCompleted( false ),
 	mKillMeAutomatically( false ),
-	mMathFunc( NULL )
+	mCompleted( false ),
+	mMathFunc( NULL ),
+	mManagerIndex( -1 )
 {
+	GTweenManager::GetInstance().AddTween( this );
 }
 
 //-----------------------------------------------------------------------------
 
 GTween::GTween( float duration, bool auto_kill ) :
-	ceng::CAutoList< GTween >(),
 	mDirty( false ),
 	mDelay( 0 ),
 	mDuration( duration ),
 	mTimer( 0 ),
 	mDead( false ),
-	mCompleted( false ),
 	mKillMeAutomatically( auto_kill ),
-	mMathFunc( NULL )
+	mCompleted( false ),
+	mMathFunc( NULL ),
+	mManagerIndex( -1 )
 {
+	GTweenManager::GetInstance().AddTween( this );
 }
 //-----------------------------------------------------------------------------
 
 GTween::~GTween()
 {
-	for( std::size_t i = 0; i <  mInterpolators.size(); ++i ) 
-	{
-		delete mInterpolators[ i ];
-	}
+	while( mInterpolators.empty() == false )
+		RemoveInterpolator( mInterpolators.size() - 1 );
+
+	while( mFloatTracks.empty() == false )
+		RemoveFloatTrack( mFloatTracks.size() - 1 );
 
-	mInterpolators.clear();
+	GTweenManager::GetInstance().RemoveTween( this );
+}
+
+//-----------------------------------------------------------------------------
+
+void GTween::AddInterpolator( ceng::IInterpolator* in, const std::string& name )
+{
+	cassert( in );
+
+	mDirty = true;
+	in->SetName( name );
+	
+	RemoveDuplicateInterpolators( name );
+	
+	mInterpolators.push_back( in );
+
+	void* pointers[ 2 ];
+	const int count = in->GetPointers( pointers );
+	for( int i = 0; i < count; ++i )
+		GTweenManager::GetInstance().AddTarget( pointers[ i ], this );
+}
+
+void GTween::AddVariable( float& reference, const float& target_value, const std::string& name )
+{
+	AddFloatProperty( &reference, NULL, NULL, target_value, name );
+}
+
+void GTween::AddFloatProperty( 
+		void* object,
+		GTweenManager::FloatGetter getter,
+		GTweenManager::FloatSetter setter,
+		float target_value, const std::string& name )
+{
+	cassert( object );
+	cassert( ( getter == NULL ) == ( setter == NULL ) );
+
+	mDirty = true;
+	RemoveDuplicateInterpolators( name );
+
+	GTweenManager& manager = GTweenManager::GetInstance();
+	mFloatTracks.push_back( manager.AddFloatTrack( this, object, getter, setter, target_value ) );
+	mFloatTrackNames.push_back( name );
+	manager.AddTarget( object, this );
 }
 
 //-----------------------------------------------------------------------------
 
 // iterates over the list of interpolators and drops any interpolator that has the same name
-void GTween::RemoveDuplicateInterpolators(std::string name){
-	// sets the iterator to the first item in the vector
-	std::vector< ceng::IInterpolator* >::iterator it = mInterpolators.begin();
-	while(it != mInterpolators.end()){
-
-		if((*it)->GetName() == name) {
-			// erase the interpolator and set the iterator to the return value
-			// the iterator breaks on erase, so that's needed
-			it = mInterpolators.erase(it);
-		} else {
-			++it;
-		}
+void GTween::RemoveDuplicateInterpolators( const std::string& name )
+{
+	for( std::size_t i = 0; i < mInterpolators.size(); )
+	{
+		if( mInterpolators[ i ]->GetName() == name ) 
+			RemoveInterpolator( i );
+		else 
+			++i;
+	}
+
+	for( std::size_t i = 0; i < mFloatTracks.size(); )
+	{
+		if( mFloatTrackNames[ i ] == name ) 
+			RemoveFloatTrack( i );
+		else 
+			++i;
 	}
 }
 
+// the order isn't kept
+void GTween::RemoveInterpolator( std::size_t i )
+{
+	cassert( i < mInterpolators.size() );
+	ceng::IInterpolator* in = mInterpolators[ i ];
+
+	void* pointers[ 2 ];
+	const int count = in->GetPointers( pointers );
+	for( int j = 0; j < count; ++j )
+		GTweenManager::GetInstance().RemoveTarget( pointers[ j ], this );
+
+	delete in;
+	mInterpolators[ i ] = mInterpolators.back();
+	mInterpolators.pop_back();
+}
+
+void GTween::RemoveFloatTrack( std::size_t i )
+{
+	cassert( i < mFloatTracks.size() );
+	GTweenManager& manager = GTweenManager::GetInstance();
+
+	manager.RemoveTarget( manager.GetFloatTrackObject( mFloatTracks[ i ] ), this );
+	manager.RemoveFloatTrack( mFloatTracks[ i ] );
+
+	mFloatTracks[ i ] = mFloatTracks.back();
+	mFloatTracks.pop_back();
+	mFloatTrackNames[ i ] = mFloatTrackNames.back();
+	mFloatTrackNames.pop_back();
+}
+
 //-----------------------------------------------------------------------------
 	
 bool GTween::IsDead() const							{ return mDead; }
@@ -157,6 +215,22 @@ bool GTween::GetIsRunning() const
 
 void GTween::Update( float dt ) 
 {
+	float t = -1.f;
+	if( Step( dt, t ) == false )
+		return;
+
+	if( t >= 0 )
+		WriteValues( t );
+
+	CheckCompletion();
+}
+
+//-----------------------------------------------------------------------------
+
+bool GTween::Step( float dt, float& t )
+{
+	t = -1.f;
+
 	if( mDirty )
 	{
 		Reset();
@@ -167,7 +241,7 @@ void GTween::Update( float dt )
 			OnStart();
 	}
 	
-	if(mCompleted) return;
+	if(mCompleted) return false;
 	
 	if( mDelay > 0 )
 	{
@@ -182,24 +256,42 @@ void GTween::Update( float dt )
 	{
 		cassert( mDuration != 0 );
 		if( mDuration == 0 )
-			return;
+			return false;
 
 		OnStep();
 
 		mTimer += dt;
-		float t = mTimer / mDuration;
+		t = mTimer / mDuration;
 
 		t = ceng::math::Clamp( t, 0.f, 1.f );
 		
 		if( mMathFunc )
 			t = mMathFunc->f( t );
+	}
 
-		for( std::size_t i = 0; i < mInterpolators.size(); ++i )
-		{
-			mInterpolators[ i ]->Update( t );
-		}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void GTween::WriteValues( float t )
+{
+	for( std::size_t i = 0; i < mInterpolators.size(); ++i )
+	{
+		mInterpolators[ i ]->Update( t );
 	}
-	
+
+	GTweenManager& manager = GTweenManager::GetInstance();
+	for( std::size_t i = 0; i < mFloatTracks.size(); ++i )
+	{
+		manager.UpdateFloatTrack( mFloatTracks[ i ], t );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void GTween::CheckCompletion()
+{
 	if( mTimer >= mDuration )
 	{
 		mCompleted = true;
@@ -242,9 +334,19 @@ bool GTween::ClearPointer( void* pointer )
 		if( mInterpolators[ i ]->UsesPointer( pointer ) )
 		{
 			result = true;
-			delete mInterpolators[ i ];
-			mInterpolators[ i ] = mInterpolators[ mInterpolators.size() - 1 ];
-			mInterpolators.pop_back();
+			RemoveInterpolator( i );
+		} else {
+			++i;
+		}
+	}
+
+	GTweenManager& manager = GTweenManager::GetInstance();
+	for( std::size_t i = 0; i < mFloatTracks.size();  )
+	{
+		if( manager.GetFloatTrackObject( mFloatTracks[ i ] ) == pointer )
+		{
+			result = true;
+			RemoveFloatTrack( i );
 		} else {
 			++i;
 		}
@@ -284,6 +386,10 @@ void GTween::Reset()
 	for( std::size_t i = 0; i < mInterpolators.size(); ++i )
 		mInterpolators[ i ]->Reset();
 
+	GTweenManager& manager = GTweenManager::GetInstance();
+	for( std::size_t i = 0; i < mFloatTracks.size(); ++i )
+		manager.ResetFloatTrack( mFloatTracks[ i ] );
+
 	mTimer = 0.f;
 
 }
@@ -36,10 +36,10 @@
 
 #include "../../utils/math/math_utils.h"
 #include "../../utils/functionptr/cfunctionptr.h"
-#include "../../utils/autolist/cautolist.h"
 #include "../../utils/easing/easing.h"
 #include "cinterpolator.h"
 #include "gtween_listener.h"
+#include "gtween_manager.h"
 
 //-----------------------------------------------------------------------------
 // updates all gtweens and removes the dead gtweens from the list as well
@@ -48,9 +48,8 @@ void UpdateGTweens( float dt );
 //-----------------------------------------------------------------------------
 
 
-// autolist?
-// the auto updating thing has to be implemented
-class GTween : public ceng::CAutoList< GTween >
+// all the tweens are updated by the GTweenManager
+class GTween
 {
 public:
 
@@ -58,9 +57,18 @@ public:
 	GTween( float duration, bool auto_kill );
 
 	template< typename T >
-	GTween( T& variable, const T& target, float duration = 1.f, ceng::easing::IEasingFunc& math_func = ceng::easing::Linear::easeNone, bool autokill = true ) 
+	GTween( T& variable, const T& target, float duration = 1.f, ceng::easing::IEasingFunc& math_func = ceng::easing::Linear::easeNone, bool autokill = true ) :
+		mDirty( false ),
+		mDelay( 0 ),
+		mDuration( duration ),
+		mTimer( 0 ),
+		mDead( false ),
+		mKillMeAutomatically( autokill ),
+		mCompleted( false ),
+		mMathFunc( NULL ),
+		mManagerIndex( -1 )
 	{
-		GTween( duration, autokill );
+		GTweenManager::GetInstance().AddTween( this );
 
 		SetFunction( math_func );
 		AddVariable( variable, target, "variable" );
@@ -81,16 +89,20 @@ public:
 		cassert( in );
 
 		if( in )
-		{
-			mDirty = true;
-			in->SetName( name );
-			
-			RemoveDuplicateInterpolators( name );
-			
-			mInterpolators.push_back( in );
-		}
+			AddInterpolator( in, name );
 	}
 
+	// floats go to the batched update of GTweenManager
+	void AddVariable( float& reference, const float& target_value, const std::string& name );
+
+	// a float that can only be reached through functions, without the cost
+	// of CFunctionPtr. The object is what ClearPointer() matches
+	void AddFloatProperty( 
+			void* object,
+			GTweenManager::FloatGetter getter,
+			GTweenManager::FloatSetter setter,
+			float target_value, const std::string& name );
+
 	template< class T >
 	void AddGetterSetter( 
 			const ceng::CFunctionPtr<>& getter,
@@ -101,14 +113,7 @@ public:
 		cassert( in );
 
 		if( in )
-		{
-			mDirty = true;
-			in->SetName( name );
-			
-			RemoveDuplicateInterpolators( name );
-			
-			mInterpolators.push_back( in );
-		}
+			AddInterpolator( in, name );
 	}
 
 	void SetFunction( ceng::easing::IEasingFunc& math_func );
@@ -132,7 +137,19 @@ public:
 	bool ClearPointer( void* pointer );
 
 private:
-	void RemoveDuplicateInterpolators( std::string name );
+	friend class GTweenManager;
+
+	void AddInterpolator( ceng::IInterpolator* in, const std::string& name );
+	void RemoveDuplicateInterpolators( const std::string& name );
+	void RemoveInterpolator( std::size_t i );
+	void RemoveFloatTrack( std::size_t i );
+
+	// advances the timers and does the start and step callbacks. t is where
+	// the values should be written, or negative if they shouldn't be. Returns
+	// false if the tween shouldn't be checked for completion
+	bool Step( float dt, float& t );
+	void WriteValues( float t );
+	void CheckCompletion();
 	
 	// callbacks
 	void OnStart();
@@ -144,6 +161,10 @@ private:
 
 	std::vector< ceng::IInterpolator* > mInterpolators;
 	std::vector< GTweenListener* > mListeners;
+
+	// indexes to the float tracks in GTweenManager
+	std::vector< int > mFloatTracks;
+	std::vector< std::string > mFloatTrackNames;
 	
 	bool mDirty;
 	float mDelay;
@@ -154,6 +175,7 @@ private:
 	bool mCompleted;
 	ceng::easing::IEasingFunc* mMathFunc;
 
+	int mManagerIndex;
 };
 
 //-----------------------------------------------------------------------------
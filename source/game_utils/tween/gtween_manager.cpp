@@ -0,0 +1,294 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include "gtween_manager.h"
+#include "gtween.h"
+#include "../../utils/memorypool/callocationtracker.h"
+
+//-----------------------------------------------------------------------------
+
+GTweenManager& GTweenManager::GetInstance()
+{
+	static GTweenManager* instance = new GTweenManager;
+	return *instance;
+}
+
+//-----------------------------------------------------------------------------
+
+GTweenManager::GTweenManager() :
+	mTweens(),
+	mTweenTime(),
+	mHoles( 0 ),
+	mUpdating( false ),
+	mTrackObject(),
+	mTrackGetter(),
+	mTrackSetter(),
+	mTrackStart(),
+	mTrackEnd(),
+	mTrackOwner(),
+	mFreeTracks(),
+	mTargets(),
+	mClearBuffer()
+{
+}
+
+GTweenManager::~GTweenManager()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GTweenManager::Update( float dt )
+{
+	CENG_ALLOCATION_TAG( ceng::ALLOCATION_TAG_TWEEN );
+
+	cassert( mUpdating == false );
+	mUpdating = true;
+
+	// timers and callbacks. Tweens that have something besides floats or
+	// somebody listening are done one by one, the rest just leave their time
+	// for the batch. Tweens created in the callbacks get updated this round,
+	// deleted ones leave a hole
+	for( std::size_t i = 0; i < mTweens.size(); ++i )
+	{
+		GTween* tween = mTweens[ i ];
+		mTweenTime[ i ] = -1.f;
+		if( tween == NULL )
+			continue;
+
+		if( tween->mListeners.empty() && tween->mInterpolators.empty() )
+		{
+			float t = -1.f;
+			if( tween->Step( dt, t ) )
+			{
+				mTweenTime[ i ] = t;
+				// nobody is listening so completing before the write is fine
+				tween->CheckCompletion();
+			}
+		}
+		else
+		{
+			tween->Update( dt );
+		}
+	}
+
+	// the batch
+	const std::size_t track_count = mTrackOwner.size();
+	for( std::size_t i = 0; i < track_count; ++i )
+	{
+		const int owner = mTrackOwner[ i ];
+		if( owner < 0 )
+			continue;
+
+		const float t = mTweenTime[ owner ];
+		if( t < 0 )
+			continue;
+
+		const float value = mTrackStart[ i ] + t * ( mTrackEnd[ i ] - mTrackStart[ i ] );
+		if( mTrackSetter[ i ] )
+			mTrackSetter[ i ]( mTrackObject[ i ], value );
+		else
+			*static_cast< float* >( mTrackObject[ i ] ) = value;
+	}
+
+	// release the dead tweens, their destructors are free to delete others
+	for( std::size_t i = 0; i < mTweens.size(); ++i )
+	{
+		GTween* tween = mTweens[ i ];
+		if( tween && tween->IsDead() )
+			delete tween;
+	}
+
+	mUpdating = false;
+	Compact();
+}
+
+//-----------------------------------------------------------------------------
+
+void GTweenManager::ClearPointer( void* pointer )
+{
+	const ceng::CFlatHashMultiMap< void*, GTween*, 1 >::List* list = mTargets.Find( pointer );
+	if( list == NULL )
+		return;
+
+	// the tweens remove themselves from the list while clearing
+	mClearBuffer.assign( list->begin(), list->end() );
+	for( std::size_t i = 0; i < mClearBuffer.size(); ++i )
+		mClearBuffer[ i ]->ClearPointer( pointer );
+
+	mClearBuffer.clear();
+	cassert( mTargets.HasKey( pointer ) == false );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GTweenManager::AddTween( GTween* tween )
+{
+	cassert( tween );
+	cassert( tween->mManagerIndex == -1 );
+
+	tween->mManagerIndex = (int)mTweens.size();
+	mTweens.push_back( tween );
+	mTweenTime.push_back( -1.f );
+}
+
+void GTweenManager::RemoveTween( GTween* tween )
+{
+	const int index = tween->mManagerIndex;
+	cassert( index >= 0 && index < (int)mTweens.size() );
+	cassert( mTweens[ index ] == tween );
+	tween->mManagerIndex = -1;
+
+	// can't move things around in the middle of an update
+	if( mUpdating )
+	{
+		mTweens[ index ] = NULL;
+		mHoles++;
+		return;
+	}
+
+	GTween* moved = mTweens.back();
+	mTweens[ index ] = moved;
+	mTweens.pop_back();
+	mTweenTime.pop_back();
+
+	if( moved != tween )
+	{
+		moved->mManagerIndex = index;
+		for( std::size_t i = 0; i < moved->mFloatTracks.size(); ++i )
+			mTrackOwner[ moved->mFloatTracks[ i ] ] = index;
+	}
+}
+
+// fills the holes left by the tweens deleted during the update, keeps the order
+void GTweenManager::Compact()
+{
+	if( mHoles == 0 )
+		return;
+
+	std::size_t write = 0;
+	for( std::size_t read = 0; read < mTweens.size(); ++read )
+	{
+		GTween* tween = mTweens[ read ];
+		if( tween == NULL )
+			continue;
+
+		if( write != read )
+		{
+			mTweens[ write ] = tween;
+			tween->mManagerIndex = (int)write;
+			for( std::size_t i = 0; i < tween->mFloatTracks.size(); ++i )
+				mTrackOwner[ tween->mFloatTracks[ i ] ] = (int)write;
+		}
+		++write;
+	}
+
+	mTweens.resize( write );
+	mTweenTime.resize( write );
+	mHoles = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+void GTweenManager::AddTarget( void* pointer, GTween* tween )
+{
+	mTargets.Insert( pointer, tween );
+}
+
+// removes just one, the tween can use the same pointer more than once
+void GTweenManager::RemoveTarget( void* pointer, GTween* tween )
+{
+	ceng::CFlatHashMultiMap< void*, GTween*, 1 >::List* list = mTargets.Find( pointer );
+	cassert( list );
+	if( list == NULL )
+		return;
+
+	list->remove_one_unordered( tween );
+	if( list->empty() )
+		mTargets.Remove( pointer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int GTweenManager::AddFloatTrack( GTween* owner, void* object, FloatGetter getter, FloatSetter setter, float end_value )
+{
+	cassert( owner && owner->mManagerIndex >= 0 );
+
+	int track = 0;
+	if( mFreeTracks.empty() )
+	{
+		track = (int)mTrackOwner.size();
+		mTrackObject.push_back( NULL );
+		mTrackGetter.push_back( NULL );
+		mTrackSetter.push_back( NULL );
+		mTrackStart.push_back( 0 );
+		mTrackEnd.push_back( 0 );
+		mTrackOwner.push_back( -1 );
+	}
+	else
+	{
+		track = mFreeTracks.back();
+		mFreeTracks.pop_back();
+	}
+
+	mTrackObject[ track ] = object;
+	mTrackGetter[ track ] = getter;
+	mTrackSetter[ track ] = setter;
+	mTrackEnd[ track ] = end_value;
+	mTrackOwner[ track ] = owner->mManagerIndex;
+	ResetFloatTrack( track );
+
+	// added from a callback, the tween is dirty anyway so it sits this one out
+	if( mUpdating )
+		mTweenTime[ owner->mManagerIndex ] = -1.f;
+
+	return track;
+}
+
+void GTweenManager::RemoveFloatTrack( int track )
+{
+	cassert( track >= 0 && track < (int)mTrackOwner.size() );
+	cassert( mTrackOwner[ track ] >= 0 );
+
+	mTrackOwner[ track ] = -1;
+	mTrackObject[ track ] = NULL;
+	mFreeTracks.push_back( track );
+}
+
+void GTweenManager::ResetFloatTrack( int track )
+{
+	if( mTrackGetter[ track ] )
+		mTrackStart[ track ] = mTrackGetter[ track ]( mTrackObject[ track ] );
+	else
+		mTrackStart[ track ] = *static_cast< float* >( mTrackObject[ track ] );
+}
+
+void GTweenManager::UpdateFloatTrack( int track, float t )
+{
+	const float value = mTrackStart[ track ] + t * ( mTrackEnd[ track ] - mTrackStart[ track ] );
+	if( mTrackSetter[ track ] )
+		mTrackSetter[ track ]( mTrackObject[ track ], value );
+	else
+		*static_cast< float* >( mTrackObject[ track ] ) = value;
+}
+
+///////////////////////////////////////////////////////////////////////////////
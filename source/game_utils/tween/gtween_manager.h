@@ -0,0 +1,112 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// GTweenManager
+// =============
+//
+// Keeps track of every GTween and does the updating for UpdateGTweens().
+//
+// Tweens are kept in one array and remove themselves in O(1) when deleted.
+// The float values (AddVariable( float& ... ) and AddFloatProperty()) don't
+// get an IInterpolator of their own, they live here in pooled arrays and
+// are written in one go after all the tweens have advanced their timers.
+// Tweens with listeners or other kinds of interpolators still update one by
+// one, so the callbacks see the same order of things as before.
+//
+// Everything a tween writes to is indexed by pointer, so clearing the tweens
+// of a sprite (which every as::Sprite does when it dies) only touches the
+// tweens that actually point to it.
+//
+//.............................................................................
+//=============================================================================
+#ifndef INC_GTWEEN_MANAGER_H
+#define INC_GTWEEN_MANAGER_H
+
+#include <vector>
+
+#include "../../utils/maphelper/cflathashmultimap.h"
+
+class GTween;
+
+class GTweenManager
+{
+public:
+	typedef float	(*FloatGetter)( void* object );
+	typedef void	(*FloatSetter)( void* object, float value );
+
+	//! The one and only. Never deleted, so tweens can die in static destructors
+	static GTweenManager& GetInstance();
+
+	//! updates all the tweens and deletes the dead ones
+	void Update( float dt );
+
+	//! kills every value of every tween that uses the pointer
+	void ClearPointer( void* pointer );
+
+	int	GetTweenCount() const		{ return (int)mTweens.size() - mHoles; }
+	int	GetFloatTrackCount() const	{ return (int)( mTrackOwner.size() - mFreeTracks.size() ); }
+
+private:
+	friend class GTween;
+
+	GTweenManager();
+	~GTweenManager();
+
+	void	AddTween( GTween* tween );
+	void	RemoveTween( GTween* tween );
+	void	Compact();
+
+	void	AddTarget( void* pointer, GTween* tween );
+	void	RemoveTarget( void* pointer, GTween* tween );
+
+	// if getter and setter are NULL object is the float itself
+	int		AddFloatTrack( GTween* owner, void* object, FloatGetter getter, FloatSetter setter, float end_value );
+	void	RemoveFloatTrack( int track );
+	void	ResetFloatTrack( int track );
+	void	UpdateFloatTrack( int track, float t );
+	void*	GetFloatTrackObject( int track ) const { return mTrackObject[ track ]; }
+
+	std::vector< GTween* >	mTweens;
+	std::vector< float >	mTweenTime;
+	int						mHoles;
+	bool					mUpdating;
+
+	// float tracks as a struct of arrays, owner -1 is a free slot
+	std::vector< void* >		mTrackObject;
+	std::vector< FloatGetter >	mTrackGetter;
+	std::vector< FloatSetter >	mTrackSetter;
+	std::vector< float >		mTrackStart;
+	std::vector< float >		mTrackEnd;
+	std::vector< int >			mTrackOwner;
+	std::vector< int >			mFreeTracks;
+
+	ceng::CFlatHashMultiMap< void*, GTween*, 1 >	mTargets;
+	std::vector< GTween* >							mClearBuffer;
+
+	// can't be copied
+	GTweenManager( const GTweenManager& );
+	GTweenManager& operator=( const GTweenManager& );
+};
+
+#endif
@@ -0,0 +1,146 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include <vector>
+
+#include "../gtween.h"
+#include "../../../utils/debug.h"
+#include "../../../tester/tester_benchmark.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test
+{
+
+namespace {
+
+	const int bench_tweens = 20000;
+	const int bench_frames = 60;
+	const int bench_clears = 1000;
+
+	struct BenchTarget
+	{
+		BenchTarget() : x( 0 ), y( 0 ) { }
+
+		float GetX() { return x; }
+		float GetY() { return y; }
+		void SetX( float v ) { x = v; }
+		void SetY( float v ) { y = v; }
+
+		float x;
+		float y;
+	};
+
+	float GetBenchX( void* t )			{ return static_cast< BenchTarget* >( t )->GetX(); }
+	float GetBenchY( void* t )			{ return static_cast< BenchTarget* >( t )->GetY(); }
+	void SetBenchX( void* t, float v )	{ static_cast< BenchTarget* >( t )->SetX( v ); }
+	void SetBenchY( void* t, float v )	{ static_cast< BenchTarget* >( t )->SetY( v ); }
+
+	void CreateTweens( std::vector< BenchTarget >& targets, std::vector< GTween* >& tweens, bool function_ptrs )
+	{
+		for( int i = 0; i < bench_tweens; ++i )
+		{
+			BenchTarget* target = &targets[ i ];
+			GTween* tween = new GTween( 100.f, false );
+			if( function_ptrs )
+			{
+				tween->AddGetterSetter( 
+					ceng::CFunctionPtr<>( target, &BenchTarget::GetX ), 
+					ceng::CFunctionPtr<>( target, &BenchTarget::SetX ), 
+					100.f, "x" );
+				tween->AddGetterSetter( 
+					ceng::CFunctionPtr<>( target, &BenchTarget::GetY ), 
+					ceng::CFunctionPtr<>( target, &BenchTarget::SetY ), 
+					100.f, "y" );
+			}
+			else
+			{
+				tween->AddFloatProperty( target, GetBenchX, SetBenchX, 100.f, "x" );
+				tween->AddFloatProperty( target, GetBenchY, SetBenchY, 100.f, "y" );
+			}
+			tweens.push_back( tween );
+		}
+	}
+
+	void DeleteTweens( std::vector< GTween* >& tweens )
+	{
+		for( std::size_t i = 0; i < tweens.size(); ++i )
+			delete tweens[ i ];
+		tweens.clear();
+	}
+
+	void RunUpdates( const std::string& name, bool function_ptrs )
+	{
+		std::vector< BenchTarget > targets( bench_tweens );
+		std::vector< GTween* > tweens;
+		CreateTweens( targets, tweens, function_ptrs );
+
+		poro::tester::CBenchmarkTimer timer;
+		for( int i = 0; i < bench_frames; ++i )
+			UpdateGTweens( 1.f / 60.f );
+		poro::tester::BenchmarkReport( name, timer.GetSeconds(), bench_frames );
+
+		DeleteTweens( tweens );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int GTweenBenchmark()
+{
+	test_logger << "UpdateGTweens, " << bench_tweens << " tweens with x and y, per frame" << std::endl;
+	RunUpdates( "CFunctionPtr getters and setters", true );
+	RunUpdates( "batched float properties", false );
+
+	test_logger << "Clearing the tweens of " << bench_clears << " targets out of " << bench_tweens << std::endl;
+	{
+		std::vector< BenchTarget > targets( bench_tweens );
+		std::vector< GTween* > tweens;
+		CreateTweens( targets, tweens, false );
+
+		// what GTweenClearPointerOfTweens used to do
+		poro::tester::CBenchmarkTimer scan_timer;
+		for( int i = 0; i < bench_clears; ++i )
+		{
+			void* pointer = &targets[ ( i * 7 ) % bench_tweens ];
+			for( std::size_t j = 0; j < tweens.size(); ++j )
+				tweens[ j ]->ClearPointer( pointer );
+		}
+		poro::tester::BenchmarkReport( "scan every tween", scan_timer.GetSeconds(), bench_clears );
+
+		poro::tester::CBenchmarkTimer index_timer;
+		for( int i = 0; i < bench_clears; ++i )
+			GTweenManager::GetInstance().ClearPointer( &targets[ ( i * 7 + 1 ) % bench_tweens ] );
+		poro::tester::BenchmarkReport( "indexed", index_timer.GetSeconds(), bench_clears );
+
+		DeleteTweens( tweens );
+	}
+
+	test_assert( GTweenManager::GetInstance().GetTweenCount() == 0 );
+	return 0;
+}
+
+BENCHMARK_REGISTER( GTweenBenchmark );
+
+} // end of namespace test
+
+#endif
@@ -45,6 +45,18 @@ protected:
 	float value;
 };
 
+float GetTestingValue( void* t )			{ return static_cast< TestingThings* >( t )->GetValue(); }
+void SetTestingValue( void* t, float v )	{ static_cast< TestingThings* >( t )->SetValue( v ); }
+
+struct GTweenDeleter : public GTweenListener
+{
+	GTweenDeleter( GTween* victim ) : victim( victim ) { }
+
+	virtual void GTween_OnComplete( GTween* tweener ) { delete victim; victim = NULL; }
+
+	GTween* victim;
+};
+
 struct GTweenListenerTest : public GTweenListener
 {
 	GTweenListenerTest() : 
@@ -148,9 +160,9 @@ int GTween_Test()
 		tween->SetDuration( 1.f );
 		tween->SetAutoKill( true );
 
-		test_assert( ceng::CAutoList< GTween >::GetList().size() == 1 );
+		test_assert( GTweenManager::GetInstance().GetTweenCount() == 1 );
 		UpdateGTweens( 2.f );
-		test_assert( ceng::CAutoList< GTween >::GetList().size() == 0 );
+		test_assert( GTweenManager::GetInstance().GetTweenCount() == 0 );
 	}
 
 	// compare pointers
@@ -249,6 +261,91 @@ int GTween_Test()
 		test_assert( listener.on_start == 1 );
 
 	}
+
+	// floats go through the batch
+	{
+		float variable_to_tween = 0;
+		TestingThings t;
+		const int track_count = GTweenManager::GetInstance().GetFloatTrackCount();
+		std::auto_ptr< GTween > tween( new GTween );
+
+		tween->AddVariable( variable_to_tween, 10.f, "v" );
+		tween->AddFloatProperty( &t, GetTestingValue, SetTestingValue, 1.f, "test" );
+		tween->SetDuration( 1.f );
+		test_assert( GTweenManager::GetInstance().GetFloatTrackCount() == track_count + 2 );
+
+		UpdateGTweens( 0.5f );
+		test_assert( variable_to_tween == 5.f );
+		test_assert( t.GetValue() == 0.5f );
+
+		// same name replaces the old one and starts over
+		tween->AddVariable( variable_to_tween, 0.f, "v" );
+		test_assert( GTweenManager::GetInstance().GetFloatTrackCount() == track_count + 2 );
+
+		UpdateGTweens( 0.5f );
+		test_assert( variable_to_tween == 2.5f );
+		test_assert( t.GetValue() == 0.75f );
+
+		tween.reset( NULL );
+		test_assert( GTweenManager::GetInstance().GetFloatTrackCount() == track_count );
+	}
+
+	// clearing by pointer only touches the tweens using it
+	{
+		float a = 0;
+		float b = 0;
+		TestingThings t;
+		std::auto_ptr< GTween > tween1( new GTween );
+		std::auto_ptr< GTween > tween2( new GTween );
+		std::auto_ptr< GTween > tween3( new GTween );
+
+		tween1->AddVariable( a, 1.f, "a" );
+		tween1->AddFloatProperty( &t, GetTestingValue, SetTestingValue, 1.f, "t" );
+		tween2->AddVariable( b, 1.f, "b" );
+		tween3->AddGetterSetter( 
+			ceng::CFunctionPtr<>( &t, &TestingThings::GetValue ),
+			ceng::CFunctionPtr<>( &t, &TestingThings::SetValue ), 
+			1.f, "t" );
+
+		GTweenManager::GetInstance().ClearPointer( &t );
+		test_assert( tween1->ClearPointer( &t ) == false );
+		test_assert( tween3->ClearPointer( &t ) == false );
+
+		UpdateGTweens( 0.5f );
+		test_assert( a == 0.5f );
+		test_assert( b == 0.5f );
+		test_assert( t.GetValue() == 0 );
+
+		GTweenManager::GetInstance().ClearPointer( &b );
+		UpdateGTweens( 0.25f );
+		test_assert( a == 0.75f );
+		test_assert( b == 0.5f );
+	}
+
+	// deleting tweens from the callbacks
+	{
+		const int tween_count = GTweenManager::GetInstance().GetTweenCount();
+		float a = 0;
+		float b = 0;
+		GTween* victim = new GTween( 1.f, false );
+		victim->AddVariable( b, 1.f, "b" );
+
+		GTweenDeleter deleter( victim );
+		GTween* tween = new GTween( 0.5f, true );
+		tween->AddListener( &deleter );
+		tween->AddVariable( a, 1.f, "a" );
+
+		GTween* later = new GTween( 1.f, true );
+		later->AddVariable( a, 1.f, "later" );
+
+		test_assert( GTweenManager::GetInstance().GetTweenCount() == tween_count + 3 );
+		UpdateGTweens( 1.f );
+		test_assert( deleter.victim == NULL );
+		test_assert( a == 1.f );
+		test_assert( b == 0 );
+		test_assert( GTweenManager::GetInstance().GetTweenCount() == tween_count );
+	}
+
 	return 0;
 }
 
@@ -27,20 +27,7 @@
 
 void GTweenClearPointerOfTweens( void* pointer )
 {
-	std::list< GTween* >& list_of_gtweens = ceng::CAutoList< GTween >::GetList();
-
-
-	for( std::list< GTween* >::iterator i = list_of_gtweens.begin();
-		i != list_of_gtweens.end(); ++i )
-	{
-		GTween* tween = *i;
-		cassert( tween );
-		bool value = tween->ClearPointer( pointer );
-		if( value ) 
-		{
-			// std::cout << "Found a bastard" << std::endl;
-		}
-	}
+	GTweenManager::GetInstance().ClearPointer( pointer );
 }
 
 void GTweenClearSpriteOfTweens( as::Sprite* sprite )
@@ -50,20 +37,34 @@ void GTweenClearSpriteOfTweens( as::Sprite* sprite )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+	// straight accessors for the batched float update, CFunctionPtr goes
+	// through CAnyContainer for every get and set
+	float GetSpriteX( void* sprite )				{ return static_cast< as::Sprite* >( sprite )->GetX(); }
+	float GetSpriteY( void* sprite )				{ return static_cast< as::Sprite* >( sprite )->GetY(); }
+	float GetSpriteRotation( void* sprite )			{ return static_cast< as::Sprite* >( sprite )->GetRotation(); }
+	float GetSpriteScaleX( void* sprite )			{ return static_cast< as::Sprite* >( sprite )->GetScaleX(); }
+	float GetSpriteScaleY( void* sprite )			{ return static_cast< as::Sprite* >( sprite )->GetScaleY(); }
+	float GetSpriteAlpha( void* sprite )			{ return static_cast< as::Sprite* >( sprite )->GetAlpha(); }
+
+	void SetSpriteX( void* sprite, float v )		{ static_cast< as::Sprite* >( sprite )->SetX( v ); }
+	void SetSpriteY( void* sprite, float v )		{ static_cast< as::Sprite* >( sprite )->SetY( v ); }
+	void SetSpriteRotation( void* sprite, float v )	{ static_cast< as::Sprite* >( sprite )->SetRotation( v ); }
+	void SetSpriteScaleX( void* sprite, float v )	{ static_cast< as::Sprite* >( sprite )->SetScaleX( v ); }
+	void SetSpriteScaleY( void* sprite, float v )	{ static_cast< as::Sprite* >( sprite )->SetScaleY( v ); }
+	void SetSpriteAlpha( void* sprite, float v )	{ static_cast< as::Sprite* >( sprite )->SetAlpha( v ); }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 GTween* GTweenSpriteTo( as::Sprite* sprite, const types::vector2& pos, float time, ceng::easing::IEasingFunc& math_func, bool autokill )
 {
 	GTween* new_tween = new GTween( time, autokill );
 
 	new_tween->SetFunction( math_func );
-	new_tween->AddGetterSetter(
-		ceng::CFunctionPtr<>( sprite, &as::Sprite::GetX ), 
-		ceng::CFunctionPtr<>( sprite, &as::Sprite::SetX ), 
-		pos.x, "x" );
-
-	new_tween->AddGetterSetter(
-		ceng::CFunctionPtr<>( sprite, &as::Sprite::GetY ), 
-		ceng::CFunctionPtr<>( sprite, &as::Sprite::SetY ), 
-		pos.y, "y" );
+	new_tween->AddFloatProperty( sprite, GetSpriteX, SetSpriteX, pos.x, "x" );
+	new_tween->AddFloatProperty( sprite, GetSpriteY, SetSpriteY, pos.y, "y" );
 
 	return new_tween;
 }
@@ -75,10 +76,7 @@ GTween* GTweenSpriteRotationTo( as::Sprite* sprite, float rotation, float time,
 	GTween* new_tween = new GTween( time, autokill );
 
 	new_tween->SetFunction( math_func );
-	new_tween->AddGetterSetter(
-		ceng::CFunctionPtr<>( sprite, &as::Sprite::GetRotation ), 
-		ceng::CFunctionPtr<>( sprite, &as::Sprite::SetRotation ), 
-		rotation, "rotation" );
+	new_tween->AddFloatProperty( sprite, GetSpriteRotation, SetSpriteRotation, rotation, "rotation" );
 
 	return new_tween;
 }
@@ -90,15 +88,8 @@ GTween* GTweenSpriteScaleTo( as::Sprite* sprite, const types::vector2& scale, fl
 	GTween* new_tween = new GTween( time, autokill );
 
 	new_tween->SetFunction( math_func );
-	new_tween->AddGetterSetter(
-		ceng::CFunctionPtr<>( sprite, &as::Sprite::GetScaleX ), 
-		ceng::CFunctionPtr<>( sprite, &as::Sprite::SetScaleX ), 
-		scale.x, "scale_x" );
-
-	new_tween->AddGetterSetter(
-		ceng::CFunctionPtr<>( sprite, &as::Sprite::GetScaleY ), 
-		ceng::CFunctionPtr<>( sprite, &as::Sprite::SetScaleY ), 
-		scale.y, "scale_y" );
+	new_tween->AddFloatProperty( sprite, GetSpriteScaleX, SetSpriteScaleX, scale.x, "scale_x" );
+	new_tween->AddFloatProperty( sprite, GetSpriteScaleY, SetSpriteScaleY, scale.y, "scale_y" );
 
 	return new_tween;
 }
@@ -110,10 +101,7 @@ GTween* GTweenSpriteAlphaTo( as::Sprite* sprite, float alpha, float time, ceng::
 	GTween* new_tween = new GTween( time, autokill );
 
 	new_tween->SetFunction( math_func );
-	new_tween->AddGetterSetter(
-		ceng::CFunctionPtr<>( sprite, &as::Sprite::GetAlpha ), 
-		ceng::CFunctionPtr<>( sprite, &as::Sprite::SetAlpha ), 
-		alpha, "alpha" );
+	new_tween->AddFloatProperty( sprite, GetSpriteAlpha, SetSpriteAlpha, alpha, "alpha" );
 
 	return new_tween;
 }
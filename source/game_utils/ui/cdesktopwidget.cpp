@@ -176,6 +176,9 @@ void CDesktopWidget::Update()
 {
 	if( impl )
 		impl->Update();
+
+	// everything that got resized during the frame gets laid out once
+	CWidget::Layout();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
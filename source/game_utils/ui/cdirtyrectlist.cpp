@@ -0,0 +1,163 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2009 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include "cdirtyrectlist.h"
+#include "../../utils/rect/crect_functions.h"
+
+#include <algorithm>
+
+namespace ceng {
+namespace ui {
+
+namespace {
+
+	bool IsEmpty( const ::types::rect& rect ) { return rect.w <= 0 || rect.h <= 0; }
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+CDirtyRectList::CDirtyRectList() :
+	myRects(),
+	myBounds(),
+	myMaxRects( 16 ),
+	myCollapseCount( 0 )
+{
+}
+
+//=============================================================================
+
+void CDirtyRectList::SetBounds( const ::types::rect& bounds )
+{
+	myBounds = bounds;
+	myRects.clear();
+}
+
+//=============================================================================
+
+void CDirtyRectList::Add( const ::types::rect& rect )
+{
+	::types::rect added( rect );
+	RectKeepInside( added, myBounds );
+	if( IsEmpty( added ) )
+		return;
+
+	// the old ones that are covered by the new one
+	for( std::list< ::types::rect >::iterator i = myRects.begin(); i != myRects.end(); )
+	{
+		if( RectIsInside( *i, added ) )
+			i = myRects.erase( i );
+		else
+			++i;
+	}
+
+	// chops the new one into the pieces that aren't covered yet
+	std::list< ::types::rect > pieces;
+	pieces.push_back( added );
+
+	std::list< ::types::rect > left_overs;
+	for( std::list< ::types::rect >::const_iterator old = myRects.begin(); old != myRects.end() && pieces.empty() == false; ++old )
+	{
+		for( std::list< ::types::rect >::iterator i = pieces.begin(); i != pieces.end(); )
+		{
+			if( RectHit( *old, *i ) == false )
+			{
+				++i;
+				continue;
+			}
+
+			if( RectIsInside( *i, *old ) == false )
+			{
+				left_overs.clear();
+				RectBooleanConst( *old, *i, left_overs );
+				for( std::list< ::types::rect >::iterator j = left_overs.begin(); j != left_overs.end(); ++j )
+				{
+					if( IsEmpty( *j ) == false )
+						pieces.insert( i, *j );
+				}
+			}
+
+			i = pieces.erase( i );
+		}
+	}
+
+	myRects.splice( myRects.end(), pieces );
+
+	if( (int)myRects.size() > myMaxRects )
+		Collapse();
+}
+
+//=============================================================================
+
+void CDirtyRectList::AddAll()
+{
+	myRects.clear();
+	if( IsEmpty( myBounds ) == false )
+		myRects.push_back( myBounds );
+}
+
+//=============================================================================
+
+void CDirtyRectList::Clear()
+{
+	myRects.clear();
+}
+
+//=============================================================================
+
+float CDirtyRectList::GetArea() const
+{
+	float result = 0;
+	for( std::list< ::types::rect >::const_iterator i = myRects.begin(); i != myRects.end(); ++i )
+		result += i->w * i->h;
+
+	return result;
+}
+
+//=============================================================================
+
+void CDirtyRectList::Collapse()
+{
+	if( myRects.empty() )
+		return;
+
+	float left = myRects.front().x;
+	float top = myRects.front().y;
+	float right = left + myRects.front().w;
+	float bottom = top + myRects.front().h;
+
+	for( std::list< ::types::rect >::const_iterator i = myRects.begin(); i != myRects.end(); ++i )
+	{
+		left = std::min( left, i->x );
+		top = std::min( top, i->y );
+		right = std::max( right, i->x + i->w );
+		bottom = std::max( bottom, i->y + i->h );
+	}
+
+	myRects.clear();
+	myRects.push_back( ::types::rect( left, top, right - left, bottom - top ) );
+	myCollapseCount++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} // end of namespace ui
+} // end of namespace ceng
@@ -0,0 +1,114 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2009 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CDirtyRectList
+// ==============
+//
+// The parts of the screen that have to be redrawn. The rects in the list
+// never overlap: a new rect is chopped with RectBooleanConst() around the
+// ones already there, and the old ones it covers completely are dropped. 
+// When the list gets too long the rects are collapsed into their bounding
+// box, drawing a bit more is cheaper than going through the sprites once 
+// per tiny rect.
+//
+// CGfxHandler uses this for its dirty rectangle mode.
+//
+//.............................................................................
+//=============================================================================
+#ifndef INC_UI_CDIRTYRECTLIST_H
+#define INC_UI_CDIRTYRECTLIST_H
+
+#include <list>
+#include "../../types.h"
+
+namespace ceng {
+namespace ui {
+
+//! Numbers for the dirty rectangle mode of CGfxHandler
+struct CDirtyRectStats
+{
+	CDirtyRectStats() :
+		frames( 0 ),
+		redrawn_frames( 0 ),
+		rects( 0 ),
+		sprites_drawn( 0 ),
+		sprites_total( 0 ),
+		area_redrawn( 0 ),
+		area_total( 0 )
+	{
+	}
+
+	int		frames;
+	//! frames where something had changed
+	int		redrawn_frames;
+	int		rects;
+	//! sprites drawn vs. what drawing everything every frame would have drawn
+	int		sprites_drawn;
+	int		sprites_total;
+	//! in pixels of the internal size
+	float	area_redrawn;
+	float	area_total;
+};
+
+//-----------------------------------------------------------------------------
+
+class CDirtyRectList
+{
+public:
+	CDirtyRectList();
+
+	//! Everything outside the bounds is cut off
+	void					SetBounds( const ::types::rect& bounds );
+	const ::types::rect&	GetBounds() const { return myBounds; }
+
+	//! More rects than this are collapsed into one
+	void					SetMaxRects( int count ) { myMaxRects = count; }
+	int						GetMaxRects() const { return myMaxRects; }
+
+	void					Add( const ::types::rect& rect );
+	//! The whole bounds
+	void					AddAll();
+	void					Clear();
+
+	bool					Empty() const { return myRects.empty(); }
+	const std::list< ::types::rect >& GetRects() const { return myRects; }
+
+	//! The rects don't overlap, so this is the area that gets redrawn
+	float					GetArea() const;
+	//! Times the list got too long and was turned into one rect
+	int						GetCollapseCount() const { return myCollapseCount; }
+
+private:
+	void					Collapse();
+
+	std::list< ::types::rect >	myRects;
+	::types::rect				myBounds;
+	int							myMaxRects;
+	int							myCollapseCount;
+};
+
+} // end of namespace ui
+} // end of namespace ceng
+
+#endif
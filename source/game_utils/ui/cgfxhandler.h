@@ -31,6 +31,12 @@
 // different sprites. The use of templated methods is to help with the ease of 
 // porting.
 // 
+// In the dirty rectangle mode the sprites are drawn to a buffer that is kept
+// from frame to frame, and only the parts of it that have changed are drawn
+// again. The changes come from the calls made through the handler and from
+// the sprite factory (animation frames, dead and removed sprites). Anything
+// else, like a sprite changed straight from the game, has to be reported 
+// with Invalidate().
 // 
 // Created 17.12.2005 by Pete
 //
@@ -41,6 +47,10 @@
 
 #include "ui_utils.h"
 #include "ui_types.h"
+#include "cdirtyrectlist.h"
+
+#include <vector>
+#include "poro/igraphics_buffer.h"
 
 
 namespace ceng {
@@ -54,7 +64,13 @@ public:
 
 	CGfxHandler() : 
 		myExtraZ( 0 ), 
-		mySpriteFactory( NULL ) 
+		mySpriteFactory( NULL ),
+		myDirtyRectMode( false ),
+		myDirtyRects(),
+		myDirtyRectStats(),
+		myChangedRects(),
+		myBuffer( NULL ),
+		myBufferOwner( NULL )
 	{ 
 		myIsFixedCamera = config::IsFixedCamera(); 
 		mySpriteFactory = new CSpriteFactory( poro::IPlatform::Instance()->GetGraphics() );
@@ -62,6 +78,8 @@ public:
 
 	~CGfxHandler() 
 	{ 
+		ReleaseBuffer();
+
 		delete mySpriteFactory;
 		mySpriteFactory = NULL;
 	}
@@ -76,10 +94,49 @@ public:
 
 	void Draw( poro::IGraphics* graphics )
 	{
-		if( mySpriteFactory )
+		if( mySpriteFactory == NULL )
+			return;
+
+		if( myDirtyRectMode && graphics )
+			DrawDirtyRects( graphics );
+		else
 			mySpriteFactory->Draw( graphics );
 	}
 
+	//-------------------------------------------------------------------------
+	// Dirty rectangles
+
+	void SetDirtyRectMode( bool value )
+	{
+		if( value == myDirtyRectMode )
+			return;
+
+		myDirtyRectMode = value;
+		if( mySpriteFactory )
+			mySpriteFactory->SetTrackChanges( value );
+
+		// the buffer missed everything while we were drawing straight
+		myDirtyRects.AddAll();
+	}
+
+	bool GetDirtyRectMode() const { return myDirtyRectMode; }
+
+	// the area is in the same coordinates the sprites are in
+	void Invalidate( const types::rect& area )
+	{
+		if( myDirtyRectMode )
+			myDirtyRects.Add( area );
+	}
+
+	void InvalidateAll()
+	{
+		myDirtyRects.AddAll();
+	}
+
+	const CDirtyRectStats&	GetDirtyRectStats() const	{ return myDirtyRectStats; }
+	void					ResetDirtyRectStats()		{ myDirtyRectStats = CDirtyRectStats(); }
+	CDirtyRectList&			GetDirtyRects()				{ return myDirtyRects; }
+
 	//-------------------------------------------------------------------------
 
 	sprite_handle LoadSprite( const std::string& file )
@@ -92,6 +149,7 @@ public:
 	{
 		ui_assert( who );
 		who->MoveTo( ::types::vector2( x, y ) );		
+		mySpriteFactory->InvalidateSprite( who.Get() );
 		// who->MoveTo( x, y );
 	}
 
@@ -99,6 +157,7 @@ public:
 	{
 		ui_assert( who );
 		who->Resize( w, h );
+		mySpriteFactory->InvalidateSprite( who.Get() );
 		/*
 		if( who->GetType() != ceng::CSprite::sprite_animated )
 			who->Resize( w, h );
@@ -130,6 +189,7 @@ public:
 	{
 		ui_assert( who );
 		who->PlayAnimation( animation_name );
+		mySpriteFactory->InvalidateSprite( who.Get() );
 	}
 
 	void SetSliderValue( const sprite_handle& who, float value )
@@ -150,6 +210,7 @@ public:
 	{
 		ui_assert( who );
 		who->SetText( text );
+		mySpriteFactory->InvalidateSprite( who.Get() );
 	}
 
 	int GetTextLength( const sprite_handle& who, const std::string& text )
@@ -174,6 +235,7 @@ public:
 		if( who->GetType() == CSprite::sprite_text )
 		{
 			((CTextSprite*)who.Get())->SetSingleLine( single_line );
+			mySpriteFactory->InvalidateSprite( who.Get() );
 		}
 	}
 
@@ -182,6 +244,7 @@ public:
 		if( who->GetType() == CSprite::sprite_text )
 		{
 			((CTextSprite*)who.Get())->SetCursorPosition( position );
+			mySpriteFactory->InvalidateSprite( who.Get() );
 		}
 	}
 
@@ -214,9 +277,79 @@ public:
 	static types::point ConvertMousePosition( const types::point& p ) { return p; }
 
 protected:
+	void DrawDirtyRects( poro::IGraphics* graphics )
+	{
+		const float width = (float)poro::IPlatform::Instance()->GetInternalWidth();
+		const float height = (float)poro::IPlatform::Instance()->GetInternalHeight();
+
+		if( myBuffer == NULL || myBufferOwner != graphics )
+		{
+			ReleaseBuffer();
+			myBuffer = graphics->CreateGraphicsBuffer( (int)width, (int)height );
+			if( myBuffer == NULL )
+			{
+				mySpriteFactory->Draw( graphics );
+				return;
+			}
+
+			myBufferOwner = graphics;
+			myDirtyRects.SetBounds( types::rect( 0, 0, width, height ) );
+			myDirtyRects.AddAll();
+		}
+
+		mySpriteFactory->ReleaseDeadSprites();
+		mySpriteFactory->TakeChangedRects( myChangedRects );
+		for( std::size_t i = 0; i < myChangedRects.size(); ++i )
+			myDirtyRects.Add( myChangedRects[ i ] );
+
+		myDirtyRectStats.frames++;
+		myDirtyRectStats.sprites_total += mySpriteFactory->GetSpriteCount();
+		myDirtyRectStats.area_total += width * height;
+
+		if( myDirtyRects.Empty() == false )
+		{
+			myBuffer->SetClearBackground( false );
+			myBuffer->BeginRendering();
+
+			const std::list< types::rect >& rects = myDirtyRects.GetRects();
+			for( std::list< types::rect >::const_iterator i = rects.begin(); i != rects.end(); ++i )
+			{
+				myBuffer->SetClipRect( i->x, i->y, i->w, i->h );
+				myBuffer->Clear();
+				myDirtyRectStats.sprites_drawn += mySpriteFactory->Draw( myBuffer, *i );
+			}
+
+			myBuffer->ResetClipRect();
+			myBuffer->EndRendering();
+
+			myDirtyRectStats.redrawn_frames++;
+			myDirtyRectStats.rects += (int)rects.size();
+			myDirtyRectStats.area_redrawn += myDirtyRects.GetArea();
+			myDirtyRects.Clear();
+		}
+
+		graphics->DrawTexture( myBuffer->GetTexture(), 0, 0, width, height );
+	}
+
+	void ReleaseBuffer()
+	{
+		if( myBuffer && myBufferOwner )
+			myBufferOwner->DestroyGraphicsBuffer( myBuffer );
+
+		myBuffer = NULL;
+		myBufferOwner = NULL;
+	}
+
 	types::ztype	myExtraZ;
 	bool			myIsFixedCamera;
 	CSpriteFactory*	mySpriteFactory;
+
+	bool						myDirtyRectMode;
+	CDirtyRectList				myDirtyRects;
+	CDirtyRectStats				myDirtyRectStats;
+	std::vector< types::rect >	myChangedRects;
+	poro::IGraphicsBuffer*		myBuffer;
+	poro::IGraphics*			myBufferOwner;
 };
 
 } // end of namespace ui
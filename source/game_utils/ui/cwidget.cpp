@@ -47,6 +47,10 @@ static const types::ztype Z_STARTPOS = 25;
 //! This is used by Calculate() to ease on the copy-paste code
 void CalculateStringReplace( const std::string& what, types::mesurs whit, std::string& in_here )
 {
+	// stringstreams aren't cheap
+	if( in_here.find( what ) == in_here.npos )
+		return;
+
 	std::stringstream ss;
 	ss << whit;
 	in_here = StringReplace( what, ss.str(), in_here );
@@ -54,29 +58,96 @@ void CalculateStringReplace( const std::string& what, types::mesurs whit, std::s
 
 //=============================================================================
 
-//! This is used to calculate "complex" arithmetic shit 
-types::mesurs Calculate( const std::string& iline, CWidget* who, CWidget* parent = NULL )
+//! This is used by Calculate() to replace all the parent.x, this.w etc.
+void CalculateRectReplace( const std::string& name, const types::rect& rect, std::string& in_here )
+{
+	if( in_here.find( name ) == in_here.npos )
+		return;
+
+	CalculateStringReplace( name + ".x", rect.x, in_here );
+	CalculateStringReplace( name + ".y", rect.y, in_here );
+	CalculateStringReplace( name + ".w", rect.w, in_here );
+	CalculateStringReplace( name + ".h", rect.h, in_here );
+}
+
+//=============================================================================
+
+//! Finds the "name" in "sibling.name.x" starting from pos, returns false if
+//! the line doesn't have any more sibling references
+bool FindSiblingReference( const std::string& line, std::string::size_type& pos, std::string::size_type& end, std::string& name )
+{
+	const std::string prefix = "sibling.";
+	pos = line.find( prefix, pos );
+	if( pos == line.npos )
+		return false;
+
+	const std::string::size_type name_begin = pos + prefix.size();
+	const std::string::size_type name_end = line.find( '.', name_begin );
+	if( name_end == line.npos || name_end + 1 >= line.size() )
+		return false;
+
+	name = line.substr( name_begin, name_end - name_begin );
+	end = name_end + 2;
+	return true;
+}
+
+//=============================================================================
+
+//! This is used to calculate "complex" arithmetic shit. Parsing is the slow
+//! part, so if the line ends up the same as the last time (the rects it uses
+//! haven't changed) the last result is returned.
+types::mesurs Calculate( const std::string& iline, CWidget* who, CWidget* parent, CWidget* screen, const std::vector< CWidget* >& siblings, std::string& last_line, types::mesurs& last_result )
 {
 	static CCalculator< double > calculator;
 	std::string line( iline );
 
-	if( parent )
+	// siblings first, so their names can't mess up the parent.x and such.
+	// The ones that can't be found are replaced with 0
+	std::string::size_type pos = 0;
+	std::string::size_type end = 0;
+	std::string name;
+	while( FindSiblingReference( line, pos, end, name ) )
 	{
-		CalculateStringReplace( "parent.x", parent->GetRect().x, line );
-		CalculateStringReplace( "parent.y", parent->GetRect().y, line );
-		CalculateStringReplace( "parent.w", parent->GetRect().w, line );
-		CalculateStringReplace( "parent.h", parent->GetRect().h, line );
+		types::rect r;
+		for( std::size_t i = 0; i < siblings.size(); ++i )
+		{
+			if( siblings[ i ] && siblings[ i ]->GetId() == name )
+			{
+				r = siblings[ i ]->GetRect();
+				break;
+			}
+		}
+
+		types::mesurs value = 0;
+		switch( line[ end - 1 ] )
+		{
+			case 'x': value = r.x; break;
+			case 'y': value = r.y; break;
+			case 'w': value = r.w; break;
+			case 'h': value = r.h; break;
+		}
+
+		std::stringstream ss;
+		ss << value;
+		line.replace( pos, end - pos, ss.str() );
 	}
 
+	if( parent )
+		CalculateRectReplace( "parent", parent->GetRect(), line );
+
 	if( who )
+		CalculateRectReplace( "this", who->GetRect(), line );
+
+	if( screen )
+		CalculateRectReplace( "screen", screen->GetRect(), line );
+
+	if( line != last_line )
 	{
-		CalculateStringReplace( "this.x", who->GetRect().x, line );
-		CalculateStringReplace( "this.y", who->GetRect().y, line );
-		CalculateStringReplace( "this.w", who->GetRect().w, line );
-		CalculateStringReplace( "this.h", who->GetRect().h, line );
+		last_result = ( types::mesurs )calculator( line );
+		last_line.swap( line );
 	}
 
-	return ( types::mesurs )calculator( line );
+	return last_result;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -116,35 +187,111 @@ bool IsASpecialPositionThing( std::string line )
 class CWidgetPositionHandler
 {
 public:
-	CWidgetPositionHandler() { }
+	CWidgetPositionHandler() : myScreen( NULL ), myUsesParent( false ), myUsesScreen( false )
+	{
+		// an empty line calculates to 0
+		for( int i = 0; i < 4; ++i )
+			myLastResults[ i ] = 0;
+	}
+
 	~CWidgetPositionHandler() { }
 
-	void SetX( const std::string& x ) { myX = x; }
-	void SetY( const std::string& y ) { myY = y; }
-	void SetW( const std::string& w ) { myW = w; }
-	void SetH( const std::string& h ) { myH = h; }
+	void SetX( const std::string& x ) { myX = x; myLastLines[ 0 ].clear(); }
+	void SetY( const std::string& y ) { myY = y; myLastLines[ 1 ].clear(); }
+	void SetW( const std::string& w ) { myW = w; myLastLines[ 2 ].clear(); }
+	void SetH( const std::string& h ) { myH = h; myLastLines[ 3 ].clear(); }
 
-	types::rect GetRect( CWidget* who, CWidget* parent )
+	types::rect GetRect( CWidget* who, CWidget* parent, CWidget* screen )
 	{
 		types::rect result;
 
-		result.x = Calculate( myX, who, parent );
-		result.y = Calculate( myY, who, parent );
-		result.w = Calculate( myW, who, parent );
-		result.h = Calculate( myH, who, parent );
+		result.x = Calculate( myX, who, parent, screen, mySiblings, myLastLines[ 0 ], myLastResults[ 0 ] );
+		result.y = Calculate( myY, who, parent, screen, mySiblings, myLastLines[ 1 ], myLastResults[ 1 ] );
+		result.w = Calculate( myW, who, parent, screen, mySiblings, myLastLines[ 2 ], myLastResults[ 2 ] );
+		result.h = Calculate( myH, who, parent, screen, mySiblings, myLastLines[ 3 ], myLastResults[ 3 ] );
 
 		return result;
 	}
 
+	//! Goes through the strings once to find out what they depend on, the
+	//! siblings are searched from the children of the parent
+	void FindDependencies( CWidget* who, const std::list< CWidget* >& parent_children )
+	{
+		const std::string all = myX + " " + myY + " " + myW + " " + myH;
+
+		myUsesParent = ( all.find( "parent." ) != all.npos );
+		myUsesScreen = ( all.find( "screen." ) != all.npos );
+
+		mySiblings.clear();
+		std::string::size_type pos = 0;
+		std::string::size_type end = 0;
+		std::string name;
+		while( FindSiblingReference( all, pos, end, name ) )
+		{
+			pos = end;
+			std::list< CWidget* >::const_iterator i;
+			for( i = parent_children.begin(); i != parent_children.end(); ++i )
+			{
+				CWidget* sibling = *i;
+				if( sibling != who && sibling->GetId() == name )
+				{
+					if( std::find( mySiblings.begin(), mySiblings.end(), sibling ) == mySiblings.end() )
+						mySiblings.push_back( sibling );
+					break;
+				}
+			}
+		}
+	}
+
+	bool UsesParent() const { return myUsesParent; }
+	bool UsesScreen() const { return myUsesScreen; }
+
+	//! the widgets this has registered itself to as a dependent
+	std::vector< CWidget* >	mySiblings;
+	CWidget*				myScreen;
+
 private:
 	std::string myX;
 	std::string myY;
 	std::string myW;
 	std::string myH;
+
+	std::string		myLastLines[ 4 ];
+	types::mesurs	myLastResults[ 4 ];
+
+	bool myUsesParent;
+	bool myUsesScreen;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/*!
+	The widgets that have to be recalculated in the next CWidget::Layout(). 
+	The widgets know their own index, so deleting a dirty widget just clears 
+	its slot.
+*/
+namespace {
+
+	std::vector< CWidget* >	layout_queue;
+	CWidgetLayoutStats		layout_stats;
+	int						layout_pass = 0;
+	int						layout_dirtied = 0;
+	bool					layout_running = false;
+
+	// MoveBy() and Resize() are moving the children along, GetRect() of a
+	// dirty child mustn't lay it out in the middle of that
+	int						children_following = 0;
+
+	struct CChildrenFollowing
+	{
+		CChildrenFollowing() { children_following++; }
+		~CChildrenFollowing() { children_following--; }
+	};
+
+} // end of anonymous namespace
+
+///////////////////////////////////////////////////////////////////////////////
+
 /*!
 	A class that handles all the z handling of the CWidget. Moved to its own 
 	class because I dont want the children to end up having a bloated interface.
@@ -366,7 +513,12 @@ CWidget::CWidget() :
 	myPositionHandler( NULL ),
 	myZHandler( NULL ),
 	mySprite(),
-	myResizeType( types::resize_all )
+	myResizeType( types::resize_all ),
+	myLayoutDependents(),
+	myLayoutQueueIndex( -1 ),
+	myLayoutPass( -1 ),
+	myLayoutCyclePass( -1 ),
+	myLayoutVisiting( false )
 {
 	myZHandler = new CWidgetZHandler( *this );
 
@@ -385,7 +537,12 @@ CWidget::CWidget( CWidget* parent, const types::rect& rect, bool relative, const
 	myPositionHandler( NULL ),
 	myZHandler( NULL ),
 	mySprite( NULL ), 
-	myResizeType( types::resize_all )
+	myResizeType( types::resize_all ),
+	myLayoutDependents(),
+	myLayoutQueueIndex( -1 ),
+	myLayoutPass( -1 ),
+	myLayoutCyclePass( -1 ),
+	myLayoutVisiting( false )
 {
 	mySprite = mySpriteHandler->LoadSprite( sprite_img );
 	types::rect foo_rect( rect );
@@ -436,6 +593,26 @@ CWidget::~CWidget()
 	if( myParent )
 		myParent->RemoveChild( this );
 
+	// the ones using this get a 0 for it from now on
+	for( std::size_t i = 0; i < myLayoutDependents.size(); ++i )
+	{
+		CWidget* dependent = myLayoutDependents[ i ];
+		CWidgetPositionHandler* handler = dependent->myPositionHandler;
+		ui_assert( handler );
+
+		std::replace( handler->mySiblings.begin(), handler->mySiblings.end(), this, (CWidget*)NULL );
+		if( handler->myScreen == this )
+			handler->myScreen = NULL;
+
+		dependent->InvalidateLayout();
+	}
+	myLayoutDependents.clear();
+
+	UnregisterLayoutSources();
+
+	if( myLayoutQueueIndex >= 0 )
+		layout_queue[ myLayoutQueueIndex ] = NULL;
+
 	delete myPositionHandler;
 	myPositionHandler = NULL;
 
@@ -816,6 +993,10 @@ void CWidget::SetEventIgnore( types::event event, bool ignore )
 
 types::rect	CWidget::GetRect() const
 {
+	// a dirty widget gets its layout done now, so the rect is never stale
+	if( myLayoutQueueIndex >= 0 && children_following == 0 )
+		Layout();
+
 	return myRect;
 }
 
@@ -823,10 +1004,11 @@ types::rect	CWidget::GetRect() const
 
 types::rect	CWidget::GetRelativeRect() const
 {
+	const types::rect rect = GetRect();
 	if( myParent == NULL )
-		return myRect;
+		return rect;
 
-	return types::rect( myRect.x - myParent->GetRect().x, myRect.y - myParent->GetRect().y, myRect.w, myRect.h );	
+	return types::rect( rect.x - myParent->GetRect().x, rect.y - myParent->GetRect().y, rect.w, rect.h );
 }
 
 //=============================================================================
@@ -857,8 +1039,14 @@ types::rect	CWidget::GetRelativeRect() const
 */
 void CWidget::SetRect( const types::rect& rect )
 {
+	const bool changed = !( rect == myRect );
+	const bool resized = ( rect.w != myRect.w || rect.h != myRect.h );
+
 	myRect = rect;
 	RectChanged();
+
+	if( changed )
+		LayoutDependentsChanged( resized );
 }
 
 //=============================================================================
@@ -874,6 +1062,8 @@ void CWidget::SetPosition( const std::string& x, const std::string& y, const std
 
 	if( special )
 	{
+		UnregisterLayoutSources();
+
 		if( myPositionHandler == NULL )
 		{
 			myPositionHandler = new CWidgetPositionHandler;
@@ -884,12 +1074,15 @@ void CWidget::SetPosition( const std::string& x, const std::string& y, const std
 		myPositionHandler->SetW( w );
 		myPositionHandler->SetH( h );
 
-		SetRect( myPositionHandler->GetRect( this, myParent ) );
+		RegisterLayoutSources();
+
+		SetRect( myPositionHandler->GetRect( this, myParent, GetRoot() ) );
 	}
 	else
 	{
 		if( myPositionHandler )
 		{
+			UnregisterLayoutSources();
 			delete myPositionHandler;
 			myPositionHandler = NULL;
 		}
@@ -909,6 +1102,8 @@ void CWidget::SetPosition( const std::string& x, const std::string& y, const std
 
 void CWidget::SetParent( CWidget* parent )
 {
+	UnregisterLayoutSources();
+
 	if( myParent )
 		myParent->RemoveChild( this );
 
@@ -925,6 +1120,9 @@ void CWidget::SetParent( CWidget* parent )
 
 	if( myParent )
 		myParent->AddChild( this );
+
+	RegisterLayoutSources();
+	InvalidateLayout();
 }
 
 //.............................................................................
@@ -1002,6 +1200,7 @@ void CWidget::MoveBy( const types::point& offset )
 
 	SetRect( reference_rect );
 
+	CChildrenFollowing following;
 	std::list< CWidget* >::iterator i;
 	
 	for( i = myChildren.begin(); i != myChildren.end(); ++i )
@@ -1039,6 +1238,7 @@ void CWidget::Resize( const types::point& size )
 	types::rect ex_rect = GetRect();
 	SetRect( reference_rect );
 
+	CChildrenFollowing following;
 	std::list< CWidget* >::iterator i;
 	
 	for( i = myChildren.begin(); i != myChildren.end(); ++i )
@@ -1094,9 +1294,8 @@ void CWidget::OnParentRectChange( const types::rect& ex_rect )
 
 	if( myPositionHandler )
 	{
-		types::rect r = myPositionHandler->GetRect( this, myParent );
-		MoveBy( r.x - GetRect().x, r.y - GetRect().y );
-		Resize( r.w, r.h );
+		// SetRect() of the parent has already marked this dirty, if it has to
+		// be, so this gets done in the next Layout()
 	}
 	else if( GetResizeType() == types::resize_all )
 	{
@@ -1132,6 +1331,205 @@ void CWidget::OnParentRectChange( const types::rect& ex_rect )
 	
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// Incremental layout
+//
+// Only the widgets with an arithmetic position take part. A widget is a 
+// dependent of its parent implicitly (it's one of the children) and of its 
+// siblings and the screen explicitly through myLayoutDependents. When a rect 
+// changes the dependents are put in the layout queue, and Layout() resolves 
+// the queue in topological order. Every source of a widget is visited
+// before the widget, dirty or not, since a clean source can still have a
+// dirty source of its own that's about to change it.
+//
+// Moving is not a reason to recalculate the children, since MoveBy() moves
+// them along already. Asking for the rect of a dirty widget runs Layout()
+// right away, so nobody outside sees a stale rect.
+
+void CWidget::InvalidateLayout()
+{
+	if( myPositionHandler == NULL || myLayoutQueueIndex >= 0 )
+		return;
+
+	myLayoutQueueIndex = (int)layout_queue.size();
+	layout_queue.push_back( this );
+	layout_dirtied++;
+}
+
+//=============================================================================
+
+void CWidget::Layout()
+{
+	if( layout_running )
+		return;
+
+	layout_running = true;
+	layout_pass++;
+	layout_stats.recomputed = 0;
+
+	// The queue can grow while this goes through it. A widget that was found
+	// to be in a cycle and gets dirty again after it was done is left in the
+	// queue for the next Layout(), so this can't go on forever.
+	for( std::size_t i = 0; i < layout_queue.size(); ++i )
+	{
+		if( layout_queue[ i ] )
+			layout_queue[ i ]->ResolveLayout();
+	}
+
+	std::size_t deferred = 0;
+	for( std::size_t i = 0; i < layout_queue.size(); ++i )
+	{
+		if( layout_queue[ i ] )
+		{
+			layout_queue[ deferred ] = layout_queue[ i ];
+			layout_queue[ deferred ]->myLayoutQueueIndex = (int)deferred;
+			deferred++;
+		}
+	}
+	layout_queue.resize( deferred );
+
+	layout_stats.dirtied = layout_dirtied;
+	layout_stats.deferred = (int)deferred;
+	layout_dirtied = 0;
+
+	layout_stats.layouts++;
+	layout_stats.total_recomputed += layout_stats.recomputed;
+	layout_stats.max_recomputed = std::max( layout_stats.max_recomputed, layout_stats.recomputed );
+
+	layout_running = false;
+}
+
+//=============================================================================
+
+const CWidgetLayoutStats& CWidget::GetLayoutStats()
+{
+	return layout_stats;
+}
+
+//=============================================================================
+
+void CWidget::ResolveLayout()
+{
+	// came back to a widget whose sources are still being visited
+	if( myLayoutVisiting )
+	{
+		myLayoutCyclePass = layout_pass;
+		return;
+	}
+
+	if( myPositionHandler == NULL )
+		return;
+
+	if( myLayoutPass == layout_pass && ( myLayoutQueueIndex < 0 || myLayoutCyclePass == layout_pass ) )
+		return;
+
+	// the sources have to be done first
+	myLayoutVisiting = true;
+
+	if( myParent && myPositionHandler->UsesParent() )
+		myParent->ResolveLayout();
+
+	if( myPositionHandler->myScreen )
+		myPositionHandler->myScreen->ResolveLayout();
+
+	for( std::size_t i = 0; i < myPositionHandler->mySiblings.size(); ++i )
+	{
+		if( myPositionHandler->mySiblings[ i ] )
+			myPositionHandler->mySiblings[ i ]->ResolveLayout();
+	}
+
+	myLayoutVisiting = false;
+	myLayoutPass = layout_pass;
+
+	// the sources didn't change this one
+	if( myLayoutQueueIndex < 0 )
+		return;
+
+	layout_queue[ myLayoutQueueIndex ] = NULL;
+	myLayoutQueueIndex = -1;
+	layout_stats.recomputed++;
+
+	types::rect r = myPositionHandler->GetRect( this, myParent, GetRoot() );
+	MoveBy( r.x - GetRect().x, r.y - GetRect().y );
+	Resize( r.w, r.h );
+}
+
+//=============================================================================
+
+void CWidget::LayoutDependentsChanged( bool resized )
+{
+	if( resized )
+	{
+		std::list< CWidget* >::iterator i;
+		for( i = myChildren.begin(); i != myChildren.end(); ++i )
+		{
+			if( (*i)->myPositionHandler && (*i)->myPositionHandler->UsesParent() )
+				(*i)->InvalidateLayout();
+		}
+	}
+
+	for( std::size_t i = 0; i < myLayoutDependents.size(); ++i )
+		myLayoutDependents[ i ]->InvalidateLayout();
+}
+
+//=============================================================================
+
+void CWidget::RegisterLayoutSources()
+{
+	if( myPositionHandler == NULL )
+		return;
+
+	if( myParent )
+		myPositionHandler->FindDependencies( this, myParent->myChildren );
+
+	for( std::size_t i = 0; i < myPositionHandler->mySiblings.size(); ++i )
+		myPositionHandler->mySiblings[ i ]->myLayoutDependents.push_back( this );
+
+	CWidget* root = GetRoot();
+	if( myPositionHandler->UsesScreen() && root != this )
+	{
+		myPositionHandler->myScreen = root;
+		root->myLayoutDependents.push_back( this );
+	}
+}
+
+//.............................................................................
+
+void CWidget::UnregisterLayoutSources()
+{
+	if( myPositionHandler == NULL )
+		return;
+
+	std::vector< CWidget* >& sources = myPositionHandler->mySiblings;
+	if( myPositionHandler->myScreen )
+		sources.push_back( myPositionHandler->myScreen );
+
+	for( std::size_t i = 0; i < sources.size(); ++i )
+	{
+		if( sources[ i ] == NULL )
+			continue;
+
+		std::vector< CWidget* >& dependents = sources[ i ]->myLayoutDependents;
+		std::vector< CWidget* >::iterator j = std::find( dependents.begin(), dependents.end(), this );
+		if( j != dependents.end() )
+			dependents.erase( j );
+	}
+
+	sources.clear();
+	myPositionHandler->myScreen = NULL;
+}
+
+//.............................................................................
+
+CWidget* CWidget::GetRoot()
+{
+	CWidget* root = this;
+	while( root->myParent )
+		root = root->myParent;
+	return root;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // GFX Handling
@@ -1184,6 +1582,14 @@ void CWidget::SetSpriteHandler( types::sprite_handler* sprite_handler )
 	SetSprite( mySprite );
 }
 
+//=============================================================================
+
+void CWidget::Invalidate()
+{
+	if( mySpriteHandler )
+		mySpriteHandler->Invalidate( GetRect() );
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 } // end of namespace ui
 } // end of namespace ceng
\ No newline at end of file
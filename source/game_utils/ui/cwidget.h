@@ -47,6 +47,7 @@
 #include "ievent.h"
 
 #include <list>
+#include <vector>
 
 namespace ceng {
 
@@ -57,6 +58,32 @@ namespace ui {
 class CWidgetZHandler;
 class CWidgetPositionHandler;
 
+//! Numbers from CWidget::Layout(). The first three are for the last Layout()
+//! call, the rest are totals.
+struct CWidgetLayoutStats
+{
+	CWidgetLayoutStats() :
+		dirtied( 0 ),
+		recomputed( 0 ),
+		deferred( 0 ),
+		layouts( 0 ),
+		total_recomputed( 0 ),
+		max_recomputed( 0 )
+	{
+	}
+
+	//! widgets marked dirty since the previous Layout()
+	int dirtied;
+	//! position expressions evaluated
+	int recomputed;
+	//! found in a cycle and dirtied again after they were done, left for the
+	//! next Layout()
+	int deferred;
+
+	int layouts;
+	int total_recomputed;
+	int max_recomputed;
+};
 
 
 //! A Base class for ui objects
@@ -118,7 +145,8 @@ public:
 	//! Looks for a child with the name id, returns null if not found
 	CWidget*	FindChild( const types::id& id );
 
-	//! Returns the (real) rect of the widget
+	//! Returns the (real) rect of the widget, runs Layout() first if this
+	//! widget is waiting for it
 	types::rect	GetRect() const;
 
 	//! Returns the relative rect (relative to the parent)
@@ -181,8 +209,30 @@ public:
 	virtual void SetFocusTo( CWidget* target );
 
 	//! Sets the rect as string, used mainly by serialization
+	/*!
+		The strings can be arithmetic, using the rects of other widgets:
+			parent.x			the parent
+			this.w				this widget, as it is before the change
+			screen.h			the root of the tree, usually the desktop
+			sibling.name.y		the child of the same parent with the id "name"
+		
+		A sibling has to exist before it can be used. The rect is calculated
+		right away, after that the widget is marked dirty when the parent is
+		resized or a screen or a sibling rect changes, and is recalculated in 
+		the next Layout(), or when its GetRect() is called before that.
+	*/
 	void SetPosition( const std::string& x, const std::string& y, const std::string& w, const std::string& h );
 
+	//! Marks the widget to be recalculated in the next Layout(), does nothing
+	//! if the widget doesn't have an arithmetic position
+	void InvalidateLayout();
+
+	//! Recalculates all the dirty widgets, sources before the widgets that use
+	//! them. CDesktopWidget::Update() calls this once a frame.
+	static void Layout();
+
+	static const CWidgetLayoutStats& GetLayoutStats();
+
 	//! This is called when the childs rect is changed and it returns what ever
 	//! it wants the child to be uses( real rects )
 	virtual types::rect ClampChildRect( const types::rect& rect );
@@ -194,6 +244,11 @@ public:
 	//! Sets sprite handler to the following (does not enable it to children). 
 	void SetSpriteHandler( types::sprite_handler* sprite_handler );
 
+	//! Tells the sprite handler that the area of the widget has to be redrawn
+	//! in the dirty rectangle mode. The changes that go through the handler 
+	//! are seen without this.
+	void Invalidate();
+
 protected:
 
 	//! Sets the parent
@@ -235,6 +290,23 @@ private:
 	CWidgetPositionHandler*	myPositionHandler;
 	CWidgetZHandler*		myZHandler;
 
+	// incremental layout
+	void ResolveLayout();
+	void LayoutDependentsChanged( bool resized );
+	void RegisterLayoutSources();
+	void UnregisterLayoutSources();
+	CWidget* GetRoot();
+
+	//! widgets whose position uses this as a sibling or as the screen
+	std::vector< CWidget* >	myLayoutDependents;
+	//! index in the layout queue, -1 if not dirty
+	int						myLayoutQueueIndex;
+	//! the last Layout() that visited this, and the last one that found it
+	//! in a cycle
+	int						myLayoutPass;
+	int						myLayoutCyclePass;
+	bool					myLayoutVisiting;
+
 	
 	friend class CWidgetZHandler;
 };
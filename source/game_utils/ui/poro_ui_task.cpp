@@ -23,6 +23,7 @@
 #include "ikeyboard.h"
 #include "imouse.h"
 #include "cwidgetfactory.h"
+#include "../../utils/memorypool/callocationtracker.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -212,6 +213,8 @@ void UiPoroTask::Exit()
 
 void UiPoroTask::Update( int deltaTime )
 {
+	CENG_ALLOCATION_TAG( ceng::ALLOCATION_TAG_UI );
+
 	if( mySpriteHandler )
 		mySpriteHandler->Update( (unsigned)deltaTime );
 
@@ -221,6 +224,8 @@ void UiPoroTask::Update( int deltaTime )
 
 void UiPoroTask::Draw( poro::IGraphics* graphics )
 {
+	CENG_ALLOCATION_TAG( ceng::ALLOCATION_TAG_UI );
+
 	if( mySpriteHandler )
 		mySpriteHandler->Draw( graphics );
 }
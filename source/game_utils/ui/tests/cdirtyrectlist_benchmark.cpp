@@ -0,0 +1,171 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2009 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include <vector>
+
+#include "../../../utils/debug.h"
+#include "../../../tester/tester_benchmark.h"
+#include "../../../poro/igraphics.h"
+#include "../../sprite/cspritefactory.h"
+#include "../cdirtyrectlist.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace ceng {
+namespace ui {
+namespace test {
+
+namespace {
+
+	const int bench_columns = 40;
+	const int bench_rows = 30;
+	const int bench_frames = 200;
+	const int bench_moves_per_frame = 3;
+
+	class DirtyRectBenchTexture : public poro::ITexture
+	{
+	public:
+		int GetWidth() const { return 24; }
+		int GetHeight() const { return 24; }
+		poro::types::string GetFilename() const { return "icon"; }
+	};
+
+	// doesn't draw, but adds up what would be filled
+	class DirtyRectBenchGraphics : public poro::IGraphics
+	{
+	public:
+		DirtyRectBenchGraphics() : draw_calls( 0 ), filled( 0 ) { }
+
+		bool				Init( int, int, bool, const poro::types::string& ) { return true; }
+		poro::ITexture*		LoadTexture( const poro::types::string& ) { return &texture; }
+		void				ReleaseTexture( poro::ITexture* ) { }
+		void				BeginRendering() { }
+		void				EndRendering() { }
+		void				DrawTexture( poro::ITexture*, poro::types::Float32, poro::types::Float32, poro::types::Float32 w, poro::types::Float32 h, const poro::types::fcolor&, poro::types::Float32 ) { draw_calls++; filled += w * h; }
+		void				DrawTexture( poro::ITexture*, poro::types::vec2* v, poro::types::vec2*, int, const poro::types::fcolor& ) 
+		{ 
+			draw_calls++; 
+			filled += ( v[ 2 ].x - v[ 0 ].x ) * ( v[ 2 ].y - v[ 0 ].y );
+		}
+
+		int draw_calls;
+		double filled;
+		DirtyRectBenchTexture texture;
+	};
+
+	// an inventory screen full of icons, a few of them get dragged around
+	// every frame
+	void MoveIcons( std::vector< CSprite* >& icons, CSpriteFactory& factory, int frame )
+	{
+		for( int i = 0; i < bench_moves_per_frame; ++i )
+		{
+			CSprite* icon = icons[ ( frame * 7 + i * 131 ) % icons.size() ];
+			icon->MoveBy( ::types::vector2( ( frame % 2 ) ? 3.f : -3.f, 1.f ) );
+			factory.InvalidateSprite( icon );
+		}
+	}
+
+	double RunFull( std::vector< CSprite* >& icons, CSpriteFactory& factory, DirtyRectBenchGraphics& graphics )
+	{
+		poro::tester::CBenchmarkTimer timer;
+		for( int f = 0; f < bench_frames; ++f )
+		{
+			MoveIcons( icons, factory, f );
+			factory.Draw( &graphics );
+		}
+		return timer.GetSeconds();
+	}
+
+	// what CGfxHandler does in the dirty rectangle mode
+	double RunDirty( std::vector< CSprite* >& icons, CSpriteFactory& factory, DirtyRectBenchGraphics& graphics, int& rects, double& area )
+	{
+		CDirtyRectList dirty_rects;
+		dirty_rects.SetBounds( ::types::rect( 0, 0, 1024, 768 ) );
+		std::vector< ::types::rect > changed;
+		rects = 0;
+		area = 0;
+
+		poro::tester::CBenchmarkTimer timer;
+		factory.SetTrackChanges( true );
+		for( int f = 0; f < bench_frames; ++f )
+		{
+			MoveIcons( icons, factory, f );
+
+			factory.ReleaseDeadSprites();
+			factory.TakeChangedRects( changed );
+			for( std::size_t i = 0; i < changed.size(); ++i )
+				dirty_rects.Add( changed[ i ] );
+
+			const std::list< ::types::rect >& dirty = dirty_rects.GetRects();
+			for( std::list< ::types::rect >::const_iterator i = dirty.begin(); i != dirty.end(); ++i )
+				factory.Draw( &graphics, *i );
+
+			rects += (int)dirty.size();
+			area += dirty_rects.GetArea();
+			dirty_rects.Clear();
+		}
+		factory.SetTrackChanges( false );
+		return timer.GetSeconds();
+	}
+}
+
+int CDirtyRectListBenchmark()
+{
+	DirtyRectBenchGraphics graphics;
+	CSpriteFactory factory( &graphics );
+
+	std::vector< CSprite* > icons;
+	for( int y = 0; y < bench_rows; ++y )
+	{
+		for( int x = 0; x < bench_columns; ++x )
+		{
+			icons.push_back( factory.LoadSprite( "icon.png" ) );
+			icons.back()->MoveTo( ::types::vector2( x * 25.f + 10.f, y * 25.f + 10.f ) );
+		}
+	}
+
+	test_logger << "UI redraw, " << icons.size() << " sprites, " << bench_moves_per_frame << " move a frame" << std::endl;
+
+	poro::tester::BenchmarkReport( "full redraw", RunFull( icons, factory, graphics ), bench_frames );
+	test_logger << "  sprites drawn per frame: " << graphics.draw_calls / bench_frames
+		<< ", pixels: " << (int)( graphics.filled / bench_frames ) << std::endl;
+
+	graphics.draw_calls = 0;
+	graphics.filled = 0;
+	int rects = 0;
+	double area = 0;
+	poro::tester::BenchmarkReport( "dirty rects", RunDirty( icons, factory, graphics, rects, area ), bench_frames );
+	// the sprites are clipped to the rects, so that's what gets filled
+	test_logger << "  sprites drawn per frame: " << graphics.draw_calls / bench_frames
+		<< ", pixels: " << (int)( area / bench_frames )
+		<< ", rects: " << rects / bench_frames << std::endl;
+
+	return 0;
+}
+
+BENCHMARK_REGISTER( CDirtyRectListBenchmark );
+
+} // end of namespace test
+} // end of namespace ui
+} // end of namespace ceng
+
+#endif
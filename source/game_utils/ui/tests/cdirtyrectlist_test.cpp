@@ -0,0 +1,245 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2009 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include "../../../utils/debug.h"
+#include "../../../poro/igraphics.h"
+#include "../../sprite/cspritefactory.h"
+#include "../cdirtyrectlist.h"
+#include "../../../utils/rect/crect_functions.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace ceng {
+namespace ui {
+namespace test {
+
+namespace {
+
+	class DirtyRectTestTexture : public poro::ITexture
+	{
+	public:
+		int GetWidth() const { return 10; }
+		int GetHeight() const { return 10; }
+		poro::types::string GetFilename() const { return "test"; }
+	};
+
+	// counts the sprites instead of drawing them
+	class DirtyRectTestGraphics : public poro::IGraphics
+	{
+	public:
+		DirtyRectTestGraphics() : draw_calls( 0 ) { }
+
+		bool				Init( int, int, bool, const poro::types::string& ) { return true; }
+		poro::ITexture*		LoadTexture( const poro::types::string& ) { return &texture; }
+		void				ReleaseTexture( poro::ITexture* ) { }
+		void				BeginRendering() { }
+		void				EndRendering() { }
+		void				DrawTexture( poro::ITexture*, poro::types::Float32, poro::types::Float32, poro::types::Float32, poro::types::Float32, const poro::types::fcolor&, poro::types::Float32 ) { draw_calls++; }
+		void				DrawTexture( poro::ITexture*, poro::types::vec2*, poro::types::vec2*, int, const poro::types::fcolor& ) { draw_calls++; }
+
+		int draw_calls;
+		DirtyRectTestTexture texture;
+	};
+
+	bool Overlap( const std::list< ::types::rect >& rects )
+	{
+		for( std::list< ::types::rect >::const_iterator i = rects.begin(); i != rects.end(); ++i )
+		{
+			std::list< ::types::rect >::const_iterator j = i;
+			for( ++j; j != rects.end(); ++j )
+			{
+				if( RectHit( *i, *j ) )
+					return true;
+			}
+		}
+		return false;
+	}
+
+	bool Covered( const std::list< ::types::rect >& rects, float x, float y )
+	{
+		for( std::list< ::types::rect >::const_iterator i = rects.begin(); i != rects.end(); ++i )
+		{
+			if( RectIsInside( *i, x, y ) )
+				return true;
+		}
+		return false;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int CDirtyRectListTest()
+{
+	// merging
+	{
+		CDirtyRectList list;
+		list.SetBounds( ::types::rect( 0, 0, 100, 100 ) );
+		test_assert( list.Empty() );
+
+		list.Add( ::types::rect( 10, 10, 20, 20 ) );
+		test_assert( list.GetRects().size() == 1 );
+		test_assert( list.GetArea() == 400.f );
+
+		list.Add( ::types::rect( 10, 10, 20, 20 ) );
+		list.Add( ::types::rect( 15, 15, 5, 5 ) );
+		test_assert( list.GetRects().size() == 1 );
+		test_assert( list.GetArea() == 400.f );
+
+		list.Add( ::types::rect( 20, 20, 20, 20 ) );
+		test_assert( list.GetArea() == 700.f );
+		test_assert( Overlap( list.GetRects() ) == false );
+
+		// swallows the old ones
+		list.Add( ::types::rect( 0, 0, 50, 50 ) );
+		test_assert( list.GetRects().size() == 1 );
+		test_assert( list.GetArea() == 2500.f );
+
+		list.Clear();
+		test_assert( list.Empty() );
+	}
+
+	// the bounds
+	{
+		CDirtyRectList list;
+		list.SetBounds( ::types::rect( 0, 0, 100, 100 ) );
+
+		list.Add( ::types::rect( -10, -10, 20, 20 ) );
+		test_assert( list.GetArea() == 100.f );
+
+		list.Add( ::types::rect( 200, 0, 20, 20 ) );
+		list.Add( ::types::rect( 50, 50, 0, 20 ) );
+		test_assert( list.GetRects().size() == 1 );
+
+		list.AddAll();
+		test_assert( list.GetRects().size() == 1 );
+		test_assert( list.GetArea() == 10000.f );
+	}
+
+	// too many rects become one
+	{
+		CDirtyRectList list;
+		list.SetBounds( ::types::rect( 0, 0, 100, 100 ) );
+		list.SetMaxRects( 4 );
+
+		for( int i = 0; i < 5; ++i )
+			list.Add( ::types::rect( (float)i * 20, (float)i * 10, 5, 5 ) );
+
+		test_assert( list.GetCollapseCount() == 1 );
+		test_assert( list.GetRects().size() == 1 );
+		test_assert( list.GetRects().front() == ::types::rect( 0, 0, 85, 45 ) );
+	}
+
+	// whatever goes in is covered, and nothing is covered twice
+	{
+		CDirtyRectList list;
+		list.SetBounds( ::types::rect( 0, 0, 640, 480 ) );
+		list.SetMaxRects( 1000 );
+
+		std::vector< ::types::rect > added;
+		unsigned int seed = 1234;
+		for( int i = 0; i < 60; ++i )
+		{
+			seed = seed * 1103515245 + 12345;
+			const float x = (float)( ( seed >> 8 ) % 600 );
+			seed = seed * 1103515245 + 12345;
+			const float y = (float)( ( seed >> 8 ) % 440 );
+			seed = seed * 1103515245 + 12345;
+			const float w = (float)( 1 + ( seed >> 8 ) % 80 );
+			seed = seed * 1103515245 + 12345;
+			const float h = (float)( 1 + ( seed >> 8 ) % 80 );
+
+			added.push_back( ::types::rect( x, y, w, h ) );
+			list.Add( added.back() );
+		}
+
+		test_assert( Overlap( list.GetRects() ) == false );
+		for( std::size_t i = 0; i < added.size(); ++i )
+		{
+			::types::rect r = added[ i ];
+			RectKeepInside( r, list.GetBounds() );
+			test_assert( Covered( list.GetRects(), r.x, r.y ) );
+			test_assert( Covered( list.GetRects(), r.x + r.w - 0.5f, r.y + r.h - 0.5f ) );
+			test_assert( Covered( list.GetRects(), r.x + r.w * 0.5f, r.y + r.h * 0.5f ) );
+		}
+	}
+
+	// the sprite factory draws only what hits the area and tells what changed
+	{
+		DirtyRectTestGraphics graphics;
+		CSpriteFactory factory( &graphics );
+
+		std::vector< CSprite* > sprites;
+		for( int i = 0; i < 10; ++i )
+		{
+			sprites.push_back( factory.LoadSprite( "test.png" ) );
+			sprites.back()->MoveTo( ::types::vector2( (float)i * 20, 0 ) );
+		}
+
+		factory.Draw( &graphics );
+		test_assert( graphics.draw_calls == 10 );
+
+		graphics.draw_calls = 0;
+		test_assert( factory.Draw( &graphics, ::types::rect( 15, 0, 30, 10 ) ) == 2 );
+		test_assert( graphics.draw_calls == 2 );
+
+		sprites[ 5 ]->SetHidden( true );
+		test_assert( factory.Draw( &graphics, ::types::rect( 95, 0, 10, 10 ) ) == 0 );
+		sprites[ 5 ]->SetHidden( false );
+
+		std::vector< ::types::rect > changed;
+		factory.InvalidateSprite( sprites[ 0 ] );
+		factory.TakeChangedRects( changed );
+		test_assert( changed.empty() );
+
+		factory.SetTrackChanges( true );
+		sprites[ 0 ]->MoveTo( ::types::vector2( 0, 50 ) );
+		factory.InvalidateSprite( sprites[ 0 ] );
+		factory.TakeChangedRects( changed );
+		test_assert( changed.size() == 2 );
+		test_assert( changed[ 0 ] == ::types::rect( 0, 0, 10, 10 ) );
+		test_assert( changed[ 1 ] == ::types::rect( 0, 50, 10, 10 ) );
+
+		factory.TakeChangedRects( changed );
+		test_assert( changed.empty() );
+
+		// dead ones go away at the next release and leave a hole behind
+		sprites[ 3 ]->Kill();
+		factory.ReleaseDeadSprites();
+		factory.TakeChangedRects( changed );
+		test_assert( changed.size() == 1 );
+		test_assert( changed[ 0 ] == ::types::rect( 60, 0, 10, 10 ) );
+		test_assert( factory.GetSpriteCount() == 9 );
+
+		factory.SetTrackChanges( false );
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( CDirtyRectListTest );
+
+///////////////////////////////////////////////////////////////////////////////
+} // end of namespace test
+} // end of namespace ui
+} // end of namespace ceng
+
+#endif
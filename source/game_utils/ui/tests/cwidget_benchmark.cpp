@@ -0,0 +1,131 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2009 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include <sstream>
+
+#include "../../../utils/debug.h"
+#include "../../../tester/tester_benchmark.h"
+
+#include "../cwidget.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace ceng {
+namespace ui {
+namespace test {
+
+namespace {
+
+	const int bench_slots = 3000;
+	const int bench_columns = 10;
+	const int bench_frames = 20;
+	const int bench_resizes_per_frame = 4;
+
+	// an inventory screen, a grid of slots that are positioned relative to
+	// the screen, and a label and an icon on every slot
+	CWidget* CreateInventory()
+	{
+		CWidget* screen = new CWidget( NULL, types::rect( 0, 0, 1024, 768 ) );
+		CWidget* grid = new CWidget( screen, types::rect() );
+		grid->SetPosition( "screen.w * 0.1", "screen.h * 0.1", "screen.w * 0.8", "screen.h * 0.8" );
+
+		for( int i = 0; i < bench_slots / 3; ++i )
+		{
+			std::stringstream x, y, w;
+			x << "parent.x + parent.w / " << bench_columns << " * " << ( i % bench_columns );
+			y << "parent.y + 40 * " << ( i / bench_columns );
+			w << "parent.w / " << bench_columns;
+
+			CWidget* slot = new CWidget( grid, types::rect() );
+			slot->SetPosition( x.str(), y.str(), w.str(), "40" );
+
+			CWidget* icon = new CWidget( slot, types::rect() );
+			icon->SetPosition( "parent.x + 2", "parent.y + 2", "parent.h - 4", "parent.h - 4" );
+
+			CWidget* label = new CWidget( slot, types::rect() );
+			label->SetPosition( "parent.x + parent.h", "parent.y", "parent.w - parent.h", "parent.h" );
+		}
+
+		CWidget::Layout();
+		return screen;
+	}
+
+	// every Resize() laid out right away, like it used to be
+	double RunImmediate( CWidget* screen, int& recomputed )
+	{
+		poro::tester::CBenchmarkTimer timer;
+		recomputed = 0;
+		for( int f = 0; f < bench_frames; ++f )
+		{
+			for( int r = 0; r < bench_resizes_per_frame; ++r )
+			{
+				screen->Resize( (types::mesurs)( 1024 + f * 10 + r ), 768 );
+				CWidget::Layout();
+				recomputed += CWidget::GetLayoutStats().recomputed;
+			}
+		}
+		return timer.GetSeconds();
+	}
+
+	double RunBatched( CWidget* screen, int& recomputed )
+	{
+		poro::tester::CBenchmarkTimer timer;
+		recomputed = 0;
+		for( int f = 0; f < bench_frames; ++f )
+		{
+			for( int r = 0; r < bench_resizes_per_frame; ++r )
+				screen->Resize( (types::mesurs)( 1024 + f * 10 + r ), 768 );
+
+			CWidget::Layout();
+			recomputed += CWidget::GetLayoutStats().recomputed;
+		}
+		return timer.GetSeconds();
+	}
+}
+
+int CWidgetLayoutBenchmark()
+{
+	CWidget* screen = CreateInventory();
+	int recomputed = 0;
+
+	test_logger << "CWidget layout, " << bench_slots << " widgets, " << bench_resizes_per_frame << " resizes a frame" << std::endl;
+
+	poro::tester::BenchmarkReport( "layout on every resize", RunImmediate( screen, recomputed ), bench_frames );
+	test_logger << "  recomputed per frame: " << recomputed / bench_frames << std::endl;
+
+	poro::tester::BenchmarkReport( "one layout a frame", RunBatched( screen, recomputed ), bench_frames );
+	test_logger << "  recomputed per frame: " << recomputed / bench_frames << std::endl;
+
+	delete screen;
+	CWidget::Layout();
+
+	ceng::CSingletonPtr< types::sprite_handler >::Delete();
+	return 0;
+}
+
+BENCHMARK_REGISTER( CWidgetLayoutBenchmark );
+
+} // end of namespace test
+} // end of namespace ui
+} // end of namespace ceng
+
+#endif
@@ -558,16 +558,18 @@ int CWidgetArithmeticRectTest()
 		test_assert( child->GetRect() == types::rect( 11, 12, 97, 96 ) );
 
 
+		// GetRect() doesn't wait for the next Layout()
 		parent->Resize( 10, 10 );
 		test_assert( child->GetRect() == types::rect( 11, 12, 7, 6 ) );
 
 		parent->Resize( 100, 10 );
-		test_assert( child->GetRect() == types::rect( 11, 12, 97, 6 ) );
+		test_assert( child->GetRelativeRect() == types::rect( 1, 2, 97, 6 ) );
 
 		parent->Resize( 10, 100 );
 		test_assert( child->GetRect() == types::rect( 11, 12, 7, 96 ) );
 		
 		parent->Resize( 100, 100 );
+		CWidget::Layout();
 		test_assert( child->GetRect() == types::rect( 11, 12, 97, 96 ) );
 
 		delete parent;
@@ -577,6 +579,140 @@ int CWidgetArithmeticRectTest()
 	return 0;
 }
 
+// Testing the incremental layout of the arithmetic positions
+int CWidgetLayoutTest()
+{
+	CWidget::Layout();
+
+	// a column, every row below the previous one and as wide as the parent
+	{
+		CWidget* parent = new CWidget( NULL, types::rect( 0, 0, 100, 100 ) );
+		CWidget* row1 = new CWidget( parent, types::rect(), false, "row1" );
+		CWidget* row2 = new CWidget( parent, types::rect(), false, "row2" );
+		CWidget* row3 = new CWidget( parent, types::rect(), false, "row3" );
+
+		row1->SetPosition( "parent.x", "parent.y", "parent.w", "parent.h / 10" );
+		row3->SetPosition( "parent.x", "sibling.row2.y + sibling.row2.h", "parent.w", "sibling.row2.h" );
+		row2->SetPosition( "parent.x", "sibling.row1.y + sibling.row1.h", "parent.w", "sibling.row1.h * 2" );
+
+		// row3 was set before row2 had a position
+		CWidget::Layout();
+		test_assert( row1->GetRect() == types::rect( 0, 0, 100, 10 ) );
+		test_assert( row2->GetRect() == types::rect( 0, 10, 100, 20 ) );
+		test_assert( row3->GetRect() == types::rect( 0, 30, 100, 20 ) );
+
+		// nothing has changed, nothing to do
+		CWidget::Layout();
+		test_assert( CWidget::GetLayoutStats().recomputed == 0 );
+
+		// resizing a bunch of times in a frame only lays out once
+		parent->Resize( 50, 50 );
+		parent->Resize( 300, 300 );
+		parent->Resize( 200, 200 );
+		CWidget::Layout();
+		test_assert( CWidget::GetLayoutStats().recomputed == 3 );
+		test_assert( CWidget::GetLayoutStats().deferred == 0 );
+		test_assert( row1->GetRect() == types::rect( 0, 0, 200, 20 ) );
+		test_assert( row2->GetRect() == types::rect( 0, 20, 200, 40 ) );
+		test_assert( row3->GetRect() == types::rect( 0, 60, 200, 40 ) );
+
+		// asking for the rect of a dirty widget doesn't wait for Layout()
+		parent->Resize( 100, 100 );
+		test_assert( row3->GetRect() == types::rect( 0, 30, 100, 20 ) );
+		test_assert( CWidget::GetLayoutStats().recomputed == 3 );
+		parent->Resize( 200, 200 );
+		CWidget::Layout();
+
+		// moving moves the children along, no layout needed
+		parent->MoveTo( 10, 10 );
+		test_assert( row3->GetRect() == types::rect( 10, 70, 200, 40 ) );
+		CWidget::Layout();
+		test_assert( row3->GetRect() == types::rect( 10, 70, 200, 40 ) );
+
+		// a sibling changing on its own
+		row1->SetPosition( "parent.x", "parent.y", "parent.w", "5" );
+		CWidget::Layout();
+		test_assert( row2->GetRect() == types::rect( 10, 15, 200, 10 ) );
+		test_assert( row3->GetRect() == types::rect( 10, 25, 200, 10 ) );
+
+		// the ones using a deleted sibling get 0 for it
+		delete row2;
+		CWidget::Layout();
+		test_assert( row3->GetRect() == types::rect( 10, 0, 200, 0 ) );
+
+		delete parent;
+		CWidget::Layout();
+	}
+
+	// screen
+	{
+		CWidget* screen = new CWidget( NULL, types::rect( 0, 0, 800, 600 ) );
+		CWidget* window = new CWidget( screen, types::rect( 100, 100, 200, 200 ) );
+		CWidget* corner = new CWidget( window, types::rect() );
+		corner->SetPosition( "screen.w - 10", "screen.h - 10", "10", "10" );
+		test_assert( corner->GetRect() == types::rect( 790, 590, 10, 10 ) );
+
+		screen->Resize( 1024, 768 );
+		CWidget::Layout();
+		test_assert( corner->GetRect() == types::rect( 1014, 758, 10, 10 ) );
+
+		// the window isn't a source
+		window->Resize( 100, 100 );
+		CWidget::Layout();
+		test_assert( CWidget::GetLayoutStats().recomputed == 0 );
+
+		delete screen;
+	}
+
+	// A uses S, S uses the parent P. A is dirtied before P in the same frame,
+	// P still has to go first
+	{
+		CWidget* grand = new CWidget( NULL, types::rect( 0, 0, 100, 100 ) );
+		CWidget* parent = new CWidget( grand, types::rect() );
+		CWidget* s = new CWidget( parent, types::rect(), false, "s" );
+		CWidget* t = new CWidget( parent, types::rect( 0, 0, 10, 10 ), false, "t" );
+		CWidget* a = new CWidget( parent, types::rect(), false, "a" );
+		parent->SetPosition( "0", "0", "parent.w", "parent.h" );
+		s->SetPosition( "0", "0", "parent.w / 2", "10" );
+		a->SetPosition( "0", "20", "sibling.s.w + sibling.t.w", "10" );
+		CWidget::Layout();
+		test_assert( a->GetRect() == types::rect( 0, 20, 60, 10 ) );
+
+		t->Resize( 20, 10 );
+		grand->Resize( 200, 200 );
+		CWidget::Layout();
+		test_assert( s->GetRect() == types::rect( 0, 0, 100, 10 ) );
+		// t is scaled along with the parent
+		test_assert( t->GetRect().w == 40 );
+		test_assert( a->GetRect() == types::rect( 0, 20, 140, 10 ) );
+		test_assert( CWidget::GetLayoutStats().recomputed == 3 );
+		test_assert( CWidget::GetLayoutStats().deferred == 0 );
+
+		delete grand;
+		CWidget::Layout();
+	}
+
+	// a cycle can't hang
+	{
+		CWidget* parent = new CWidget( NULL, types::rect( 0, 0, 100, 100 ) );
+		CWidget* a = new CWidget( parent, types::rect(), false, "a" );
+		CWidget* b = new CWidget( parent, types::rect(), false, "b" );
+		a->SetPosition( "0", "0", "10", "10" );
+		b->SetPosition( "0", "0", "sibling.a.w + 1", "10" );
+		a->SetPosition( "0", "0", "sibling.b.w + 1", "10" );
+
+		CWidget::Layout();
+		test_assert( CWidget::GetLayoutStats().recomputed <= 2 );
+		test_assert( CWidget::GetLayoutStats().deferred == 1 );
+
+		delete parent;
+		CWidget::Layout();
+		test_assert( CWidget::GetLayoutStats().deferred == 0 );
+	}
+
+	return 0;
+}
+
 int CWidgetEventTest()
 {
 	// mouse event tests
@@ -745,6 +881,7 @@ int CWidgetTest()
 	CWidgetPositionTest();
 	CWidgetZTest();
 	CWidgetArithmeticRectTest();
+	CWidgetLayoutTest();
 	CWidgetEventTest();
 
 	// ceng::Gfx::ReportErrors_WhenLoadFailed = report_error_value_before;
@@ -23,8 +23,11 @@
 #define INC_START_CLIENT_H
 
 #include "multiplayer_data.h"
-#include "lag_simulator.h"
+#include "network_conditioner.h"
 
 int StartClient( float update_freq, const MultiplayerData& m_data );
 
+// once a frame if MultiplayerData::handle_in_game_thread is set
+int HandleMultiplayerMessages();
+
 #endif
\ No newline at end of file
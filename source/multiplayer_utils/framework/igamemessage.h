@@ -23,9 +23,14 @@
 #define INC_IGAMEMESSAGE_H
 
 #include "../../utils/network/network_serializer.h"
+#include "itransport.h"
 
 class IPacketHandler;
 
+// The messages of a network tick are packed together into datagrams that
+// start with this id, so the game message ids have to stay below it.
+enum { GAME_MESSAGE_BATCH_ID = 255 };
+
 class IGameMessage
 {
 public:
@@ -33,14 +38,30 @@ public:
 
 	virtual int GetType() const = 0;
 
-	// if the packet is important it's sent immediately
+	// if the packet is important it's sent immediately, otherwise it goes
+	// out with the rest of the messages at the end of the network tick
 	virtual bool IsImportant() const { return false; }
 
+	// State updates that are sent again every tick anyway don't need to be
+	// reliable. Reliable is what everything used to be sent with.
+	virtual TransportDelivery GetDelivery() const { return TRANSPORT_RELIABLE; }
+
+	// the channel for the ordered and sequenced deliveries
+	virtual int GetChannel() const { return 0; }
+
+	// The entity the message is about, CInterestPacketHandler sends it only
+	// to the clients that can see the entity. -1 is for everyone.
+	virtual int GetEntity() const { return -1; }
+
 	// most packets are sent through the GameMessage structure
 	// some are not, sometimes they're used to respond to system messages
 	// if this is the case, then they should not be serialized
 	virtual bool IsSerialized() const { return true; }
 
+	// Received messages that say yes are reused by the factory instead of
+	// deleted, so BitSerialize has to set everything the handlers read.
+	virtual bool IsPooled() const { return false; }
+
 	virtual void BitSerialize( network_utils::ISerializer* serializer )
 	{
 	}
@@ -0,0 +1,118 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include "igamemessagefactory.h"
+#include "igamemessage.h"
+
+namespace {
+
+	// enough for the messages of a tick, the free lists don't shrink
+	const int DEFAULT_MAX_POOLED_MESSAGES = 64;
+
+}
+
+//-----------------------------------------------------------------------------
+
+IGameMessageFactory::IGameMessageFactory() :
+	mMaxPooledMessages( DEFAULT_MAX_POOLED_MESSAGES )
+{
+}
+
+IGameMessageFactory::~IGameMessageFactory()
+{
+	ReleasePooledMessages();
+}
+
+//-----------------------------------------------------------------------------
+
+IGameMessage* IGameMessageFactory::GetPooledMessage( int type )
+{
+	if( type >= 0 && type < (int)mFreeLists.size() && mFreeLists[ type ].empty() == false )
+	{
+		IGameMessage* result = mFreeLists[ type ].back();
+		mFreeLists[ type ].pop_back();
+		return result;
+	}
+
+	return GetNewMessage( type );
+}
+
+void IGameMessageFactory::ReleaseMessage( IGameMessage* message )
+{
+	if( message == NULL )
+		return;
+
+	const int type = message->GetType();
+	if( message->IsPooled() == false || type < 0 || type >= GAME_MESSAGE_BATCH_ID )
+	{
+		delete message;
+		return;
+	}
+
+	if( type >= (int)mFreeLists.size() )
+		mFreeLists.resize( type + 1 );
+
+	if( (int)mFreeLists[ type ].size() >= mMaxPooledMessages )
+	{
+		delete message;
+		return;
+	}
+
+	mFreeLists[ type ].push_back( message );
+}
+
+//-----------------------------------------------------------------------------
+
+void IGameMessageFactory::SetMaxPooledMessages( int count )
+{
+	mMaxPooledMessages = count;
+
+	for( std::size_t i = 0; i < mFreeLists.size(); ++i )
+	{
+		while( (int)mFreeLists[ i ].size() > mMaxPooledMessages )
+		{
+			delete mFreeLists[ i ].back();
+			mFreeLists[ i ].pop_back();
+		}
+	}
+}
+
+void IGameMessageFactory::ReleasePooledMessages()
+{
+	for( std::size_t i = 0; i < mFreeLists.size(); ++i )
+	{
+		for( std::size_t j = 0; j < mFreeLists[ i ].size(); ++j )
+			delete mFreeLists[ i ][ j ];
+	}
+	mFreeLists.clear();
+}
+
+int IGameMessageFactory::GetPooledMessageCount() const
+{
+	int result = 0;
+	for( std::size_t i = 0; i < mFreeLists.size(); ++i )
+		result += (int)mFreeLists[ i ].size();
+	return result;
+}
+
+//-----------------------------------------------------------------------------
@@ -22,18 +22,35 @@
 #ifndef INC_IGAMEMESSAGEFACTORY_H
 #define INC_IGAMEMESSAGEFACTORY_H
 
+#include <vector>
+
 class IGameMessage;
 
 class IGameMessageFactory
 {
 public:
-
-	virtual ~IGameMessageFactory() { }
+	IGameMessageFactory();
+	virtual ~IGameMessageFactory();
 
 	virtual IGameMessage* GetNewMessage( int type )  = 0;
 
 	virtual int GetGameMessageID_First() const = 0;
 	virtual int GetGameMessageID_Last() const = 0;
+
+	// The received messages come from here. There's a free list for every
+	// type, the messages that say IsPooled() go back to it once they've been
+	// handled and the rest are deleted.
+	IGameMessage*	GetPooledMessage( int type );
+	void			ReleaseMessage( IGameMessage* message );
+
+	// how many are kept per type, 0 turns the pooling off
+	void			SetMaxPooledMessages( int count );
+	void			ReleasePooledMessages();
+	int				GetPooledMessageCount() const;
+
+private:
+	std::vector< std::vector< IGameMessage* > >	mFreeLists;
+	int											mMaxPooledMessages;
 };
 
 #endif
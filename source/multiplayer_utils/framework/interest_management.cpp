@@ -0,0 +1,605 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include "interest_management.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../../utils/debug.h"
+#include "igamemessage.h"
+
+namespace {
+
+	// The cells are found by their coordinates packed to 16 bits each. Far
+	// away cells can end up with the same key, which only costs a few
+	// more distance checks.
+	unsigned int GetCellKey( int x, int y )
+	{
+		return ( ( (unsigned int)x & 0xFFFF ) << 16 ) | ( (unsigned int)y & 0xFFFF );
+	}
+
+	void EraseValue( std::vector< int >& values, int value )
+	{
+		std::vector< int >::iterator i = std::find( values.begin(), values.end(), value );
+		cassert( i != values.end() );
+		if( i == values.end() )
+			return;
+
+		*i = values.back();
+		values.pop_back();
+	}
+
+}
+
+//=============================================================================
+
+CInterestManager::CInterestManager( float cell_size ) :
+	mCellSize( cell_size ),
+	mTick( 0 ),
+	mQuery( 0 )
+{
+	cassert( cell_size > 0 );
+
+	AddUpdateRate( 0.5f, 2 );
+	AddUpdateRate( 0.8f, 4 );
+}
+
+//-----------------------------------------------------------------------------
+
+void CInterestManager::AddEntity( int id, float x, float y, float radius )
+{
+	cassert( mEntityIndex.HasKey( id ) == false && "The entity is already there" );
+	if( mEntityIndex.HasKey( id ) )
+	{
+		MoveEntity( id, x, y );
+		SetEntityRadius( id, radius );
+		return;
+	}
+
+	int index = 0;
+	if( mFreeEntities.empty() == false )
+	{
+		index = mFreeEntities.back();
+		mFreeEntities.pop_back();
+	}
+	else
+	{
+		index = (int)mEntities.size();
+		mEntities.push_back( Entity() );
+	}
+
+	Entity& entity = mEntities[ index ];
+	entity.id = id;
+	entity.x = x;
+	entity.y = y;
+	entity.radius = radius;
+	entity.active = true;
+	entity.removed = false;
+	entity.dirty = true;
+	mDirtyEntities.push_back( index );
+
+	mEntityIndex.Insert( id, index );
+}
+
+void CInterestManager::MoveEntity( int id, float x, float y )
+{
+	const int* index = mEntityIndex.FindValue( id );
+	cassert( index );
+	if( index == NULL )
+		return;
+
+	Entity& entity = mEntities[ *index ];
+	entity.x = x;
+	entity.y = y;
+
+	if( entity.dirty == false )
+	{
+		entity.dirty = true;
+		mDirtyEntities.push_back( *index );
+	}
+}
+
+void CInterestManager::SetEntityRadius( int id, float radius )
+{
+	const int* index = mEntityIndex.FindValue( id );
+	cassert( index );
+	if( index == NULL )
+		return;
+
+	Entity& entity = mEntities[ *index ];
+	entity.radius = radius;
+
+	if( entity.dirty == false )
+	{
+		entity.dirty = true;
+		mDirtyEntities.push_back( *index );
+	}
+}
+
+void CInterestManager::RemoveEntity( int id )
+{
+	const int* index = mEntityIndex.FindValue( id );
+	if( index == NULL )
+		return;
+
+	// the clients that see it find out in the next Update(), the id can be
+	// used again right away
+	Entity& entity = mEntities[ *index ];
+	entity.removed = true;
+
+	if( entity.dirty == false )
+	{
+		entity.dirty = true;
+		mDirtyEntities.push_back( *index );
+	}
+
+	mEntityIndex.Erase( id );
+}
+
+bool CInterestManager::HasEntity( int id ) const
+{
+	return mEntityIndex.HasKey( id );
+}
+
+//-----------------------------------------------------------------------------
+
+void CInterestManager::SetClient( const TransportAddress& address, float x, float y, float view_radius )
+{
+	int index = 0;
+	if( const int* found = mClientIndex.FindValue( address ) )
+	{
+		index = *found;
+	}
+	else if( mFreeClients.empty() == false )
+	{
+		index = mFreeClients.back();
+		mFreeClients.pop_back();
+		mClientIndex.Insert( address, index );
+	}
+	else
+	{
+		index = (int)mClients.size();
+		mClients.push_back( Client() );
+		mClientIndex.Insert( address, index );
+	}
+
+	Client& client = mClients[ index ];
+	if( client.active && client.x == x && client.y == y && client.view_radius == view_radius )
+		return;
+
+	client.address = address;
+	client.x = x;
+	client.y = y;
+	client.view_radius = view_radius;
+	client.active = true;
+	client.dirty = true;
+	client.cells = GetCells( x, y, view_radius );
+}
+
+void CInterestManager::RemoveClient( const TransportAddress& address )
+{
+	const int* found = mClientIndex.FindValue( address );
+	if( found == NULL )
+		return;
+
+	const int index = *found;
+	Client& client = mClients[ index ];
+	for( std::size_t i = 0; i < client.visible.size(); ++i )
+		RemoveObserver( mEntities[ client.visible[ i ] ], index );
+
+	mClients[ index ] = Client();
+	mFreeClients.push_back( index );
+	mClientIndex.Erase( address );
+}
+
+int CInterestManager::GetClientCount() const
+{
+	return (int)mClientIndex.Size();
+}
+
+//-----------------------------------------------------------------------------
+
+void CInterestManager::AddUpdateRate( float distance_fraction, int interval )
+{
+	cassert( interval > 0 );
+	cassert( mUpdateRates.empty() || mUpdateRates.back().distance_fraction < distance_fraction );
+
+	UpdateRate rate;
+	rate.distance_fraction = distance_fraction;
+	rate.interval = interval;
+	mUpdateRates.push_back( rate );
+}
+
+void CInterestManager::ClearUpdateRates()
+{
+	mUpdateRates.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+void CInterestManager::Update()
+{
+	++mTick;
+
+	// the cells of everything that moved have changed
+	for( std::size_t i = 0; i < mDirtyEntities.size(); ++i )
+	{
+		Entity& entity = mEntities[ mDirtyEntities[ i ] ];
+		entity.dirty = false;
+		MoveInGrid( mDirtyEntities[ i ], entity.removed ? CellRange() : GetCells( entity.x, entity.y, entity.radius ) );
+	}
+
+	for( std::size_t i = 0; i < mClients.size(); ++i )
+	{
+		Client& client = mClients[ i ];
+		if( client.active == false )
+			continue;
+
+		if( client.dirty || HasChanged( client.cells ) )
+		{
+			UpdateVisible( (int)i );
+		}
+		else
+		{
+			client.entered.clear();
+			client.left.clear();
+		}
+	}
+
+	// everyone who saw the removed ones has let go of them by now
+	for( std::size_t i = 0; i < mDirtyEntities.size(); ++i )
+	{
+		const int index = mDirtyEntities[ i ];
+		if( mEntities[ index ].removed == false )
+			continue;
+
+		cassert( mEntities[ index ].observers.empty() );
+		mEntities[ index ] = Entity();
+		mFreeEntities.push_back( index );
+	}
+
+	mDirtyEntities.clear();
+}
+
+void CInterestManager::UpdateVisible( int client_index )
+{
+	Client& client = mClients[ client_index ];
+	client.dirty = false;
+
+	// everything in the cells the client sees, each one once
+	++mQuery;
+	mQueryBuffer.clear();
+	for( int y = client.cells.y0; y <= client.cells.y1; ++y )
+	{
+		for( int x = client.cells.x0; x <= client.cells.x1; ++x )
+		{
+			const Cell* cell = FindCell( x, y );
+			if( cell == NULL )
+				continue;
+
+			for( std::size_t i = 0; i < cell->entities.size(); ++i )
+			{
+				Entity& entity = mEntities[ cell->entities[ i ] ];
+				if( entity.seen == mQuery )
+					continue;
+
+				entity.seen = mQuery;
+
+				const float dx = entity.x - client.x;
+				const float dy = entity.y - client.y;
+				const float reach = entity.radius + client.view_radius;
+				if( dx * dx + dy * dy <= reach * reach )
+					mQueryBuffer.push_back( cell->entities[ i ] );
+			}
+		}
+	}
+
+	std::sort( mQueryBuffer.begin(), mQueryBuffer.end() );
+
+	// the difference to what was seen before
+	client.entered.clear();
+	client.left.clear();
+
+	std::size_t before = 0;
+	std::size_t now = 0;
+	while( before < client.visible.size() || now < mQueryBuffer.size() )
+	{
+		if( now == mQueryBuffer.size() || ( before < client.visible.size() && client.visible[ before ] < mQueryBuffer[ now ] ) )
+		{
+			Entity& entity = mEntities[ client.visible[ before++ ] ];
+			RemoveObserver( entity, client_index );
+			client.left.push_back( entity.id );
+		}
+		else
+		{
+			Entity& entity = mEntities[ mQueryBuffer[ now ] ];
+			const bool entered = ( before == client.visible.size() || mQueryBuffer[ now ] < client.visible[ before ] );
+			if( entered )
+				client.entered.push_back( entity.id );
+			else
+				++before;
+
+			// the distance may have changed either way
+			SetObserver( entity, client_index, GetInterval( entity, client ) );
+			++now;
+		}
+	}
+
+	client.visible.swap( mQueryBuffer );
+
+	client.visible_ids.resize( client.visible.size() );
+	for( std::size_t i = 0; i < client.visible.size(); ++i )
+		client.visible_ids[ i ] = mEntities[ client.visible[ i ] ].id;
+	std::sort( client.visible_ids.begin(), client.visible_ids.end() );
+
+	mStats.visibility_updates++;
+	mStats.entered += (unsigned int)client.entered.size();
+	mStats.left += (unsigned int)client.left.size();
+}
+
+int CInterestManager::GetInterval( const Entity& entity, const Client& client ) const
+{
+	const float reach = entity.radius + client.view_radius;
+	if( mUpdateRates.empty() || reach <= 0 )
+		return 1;
+
+	const float dx = entity.x - client.x;
+	const float dy = entity.y - client.y;
+	const float fraction = std::sqrt( dx * dx + dy * dy ) / reach;
+
+	int result = 1;
+	for( std::size_t i = 0; i < mUpdateRates.size() && fraction > mUpdateRates[ i ].distance_fraction; ++i )
+		result = mUpdateRates[ i ].interval;
+
+	return result;
+}
+
+void CInterestManager::SetObserver( Entity& entity, int client, int interval )
+{
+	for( std::size_t i = 0; i < entity.observers.size(); ++i )
+	{
+		if( entity.observers[ i ].client == client )
+		{
+			entity.observers[ i ].interval = interval;
+			return;
+		}
+	}
+
+	entity.observers.push_back( Observer( client, interval ) );
+}
+
+void CInterestManager::RemoveObserver( Entity& entity, int client )
+{
+	for( std::size_t i = 0; i < entity.observers.size(); ++i )
+	{
+		if( entity.observers[ i ].client == client )
+		{
+			entity.observers[ i ] = entity.observers.back();
+			entity.observers.pop_back();
+			return;
+		}
+	}
+
+	cassert( false && "The client didn't see the entity" );
+}
+
+//-----------------------------------------------------------------------------
+
+CInterestManager::CellRange CInterestManager::GetCells( float x, float y, float radius ) const
+{
+	CellRange result;
+	result.x0 = (int)std::floor( ( x - radius ) / mCellSize );
+	result.y0 = (int)std::floor( ( y - radius ) / mCellSize );
+	result.x1 = (int)std::floor( ( x + radius ) / mCellSize );
+	result.y1 = (int)std::floor( ( y + radius ) / mCellSize );
+	return result;
+}
+
+CInterestManager::Cell& CInterestManager::GetCell( int x, int y )
+{
+	const unsigned int key = GetCellKey( x, y );
+	if( const int* index = mCellIndex.FindValue( key ) )
+		return mCells[ *index ];
+
+	mCellIndex.Insert( key, (int)mCells.size() );
+	mCells.push_back( Cell() );
+	return mCells.back();
+}
+
+const CInterestManager::Cell* CInterestManager::FindCell( int x, int y ) const
+{
+	const int* index = mCellIndex.FindValue( GetCellKey( x, y ) );
+	return index ? &mCells[ *index ] : NULL;
+}
+
+void CInterestManager::MoveInGrid( int entity_index, const CellRange& cells )
+{
+	Entity& entity = mEntities[ entity_index ];
+
+	// the distances change even if the cells don't
+	MarkChanged( entity.cells );
+
+	if( cells != entity.cells )
+	{
+		for( int y = entity.cells.y0; y <= entity.cells.y1; ++y )
+		{
+			for( int x = entity.cells.x0; x <= entity.cells.x1; ++x )
+				EraseValue( GetCell( x, y ).entities, entity_index );
+		}
+
+		for( int y = cells.y0; y <= cells.y1; ++y )
+		{
+			for( int x = cells.x0; x <= cells.x1; ++x )
+				GetCell( x, y ).entities.push_back( entity_index );
+		}
+
+		entity.cells = cells;
+		MarkChanged( cells );
+	}
+}
+
+void CInterestManager::MarkChanged( const CellRange& cells )
+{
+	for( int y = cells.y0; y <= cells.y1; ++y )
+	{
+		for( int x = cells.x0; x <= cells.x1; ++x )
+			GetCell( x, y ).changed = mTick;
+	}
+}
+
+bool CInterestManager::HasChanged( const CellRange& cells ) const
+{
+	for( int y = cells.y0; y <= cells.y1; ++y )
+	{
+		for( int x = cells.x0; x <= cells.x1; ++x )
+		{
+			const Cell* cell = FindCell( x, y );
+			if( cell && cell->changed == mTick )
+				return true;
+		}
+	}
+
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+
+const CInterestManager::Client* CInterestManager::FindClient( const TransportAddress& address ) const
+{
+	const int* index = mClientIndex.FindValue( address );
+	return index ? &mClients[ *index ] : NULL;
+}
+
+const std::vector< int >* CInterestManager::GetVisible( const TransportAddress& address ) const
+{
+	const Client* client = FindClient( address );
+	return client ? &client->visible_ids : NULL;
+}
+
+const std::vector< int >* CInterestManager::GetEntered( const TransportAddress& address ) const
+{
+	const Client* client = FindClient( address );
+	return client ? &client->entered : NULL;
+}
+
+const std::vector< int >* CInterestManager::GetLeft( const TransportAddress& address ) const
+{
+	const Client* client = FindClient( address );
+	return client ? &client->left : NULL;
+}
+
+bool CInterestManager::IsVisible( int id, const TransportAddress& address ) const
+{
+	const Client* client = FindClient( address );
+	return client && std::binary_search( client->visible_ids.begin(), client->visible_ids.end(), id );
+}
+
+bool CInterestManager::GetReceivers( int id, bool rate_limited, std::vector< TransportAddress >& receivers )
+{
+	receivers.clear();
+
+	const int* index = mEntityIndex.FindValue( id );
+	if( index == NULL )
+		return false;
+
+	const Entity& entity = mEntities[ *index ];
+	for( std::size_t i = 0; i < entity.observers.size(); ++i )
+	{
+		const Observer& observer = entity.observers[ i ];
+
+		// spread over the ticks by the id
+		if( rate_limited && observer.interval > 1 && ( mTick + (unsigned int)id ) % observer.interval != 0 )
+		{
+			mStats.copies_skipped++;
+			continue;
+		}
+
+		receivers.push_back( mClients[ observer.client ].address );
+	}
+
+	return true;
+}
+
+//=============================================================================
+
+CInterestPacketHandler::CInterestPacketHandler( CNetworkPeer* peer, CInterestManager* interest ) :
+	mPeer( peer ),
+	mInterest( interest )
+{
+	cassert( mPeer && mPeer->IsServer() );
+	cassert( mInterest );
+}
+
+void* CInterestPacketHandler::GetUserData()
+{
+	return mPeer->GetPacketHandler()->GetUserData();
+}
+
+IPacketHandler* CInterestPacketHandler::GetBufferedPacketHandler( Uint32 wait_for )
+{
+	// the delayed messages go to everyone
+	return mPeer->GetPacketHandler()->GetBufferedPacketHandler( wait_for );
+}
+
+PlayerAddress* CInterestPacketHandler::GetCurrentPacketAddress()
+{
+	return mPeer->GetPacketHandler()->GetCurrentPacketAddress();
+}
+
+void CInterestPacketHandler::SendGameMessage( IGameMessage* message )
+{
+	cassert( message );
+
+	InterestStats& stats = mInterest->GetStats();
+	stats.messages++;
+
+	// only the unreliable ones can wait for the next update
+	const bool rate_limited = ( message->GetDelivery() == TRANSPORT_UNRELIABLE || message->GetDelivery() == TRANSPORT_UNRELIABLE_SEQUENCED );
+
+	const int entity = message->GetEntity();
+	if( entity < 0 || mInterest->GetReceivers( entity, rate_limited, mReceivers ) == false )
+	{
+		stats.messages_to_everyone++;
+		stats.copies += mPeer->GetServerManagement().GetPlayerCount();
+		mPeer->GetPacketHandler()->SendGameMessage( message );
+		return;
+	}
+
+	mPlayers.clear();
+	for( std::size_t i = 0; i < mReceivers.size(); ++i )
+	{
+		if( PlayerAddress* player = mPeer->GetServerManagement().FindPlayer( mReceivers[ i ] ) )
+			mPlayers.push_back( player );
+	}
+
+	stats.copies += (unsigned int)mPlayers.size();
+
+	if( mPlayers.empty() )
+	{
+		delete message;
+		return;
+	}
+
+	mPeer->SendGameMessageToPlayers( message, mPlayers );
+}
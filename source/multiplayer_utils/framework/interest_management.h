@@ -0,0 +1,267 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#ifndef INC_INTEREST_MANAGEMENT_H
+#define INC_INTEREST_MANAGEMENT_H
+
+#include <vector>
+
+#include "../../utils/maphelper/cflathashmap.h"
+#include "ipackethandler.h"
+#include "network_peer.h"
+
+//-----------------------------------------------------------------------------
+// Who needs to hear about what. The entities have a position and a radius
+// they're relevant in, the clients see from where their player is, with a
+// view radius of their own on top. An entity is visible to a client when
+// they're at most the two radii apart.
+//
+// The entities are kept in a grid, in every cell their circle overlaps.
+// Update() is called once a tick after the entities have moved. It works
+// out the visible sets again only for the clients that moved or that see
+// a cell where something changed, and tells which entities came into
+// view and which went out of it.
+//
+// The further away an entity is, the less often its unreliable updates
+// need to go out. The default rates send every tick up to half of the
+// distance, every second tick up to 80% of it and every fourth tick after
+// that. The reliable messages go to everyone who sees the entity.
+//
+// The entity ids are the game's, the same ones IGameMessage::GetEntity()
+// gives. The positions are in whatever units the game uses, the cell size
+// should be about the usual relevance radius.
+//-----------------------------------------------------------------------------
+
+struct InterestStats
+{
+	InterestStats() :
+		messages( 0 ),
+		messages_to_everyone( 0 ),
+		copies( 0 ),
+		copies_skipped( 0 ),
+		visibility_updates( 0 ),
+		entered( 0 ),
+		left( 0 )
+	{
+	}
+
+	// Messages sent through CInterestPacketHandler, the ones that went to
+	// everyone, and how many copies went out. copies_skipped are the copies
+	// that waited for the next update of their rate.
+	unsigned int messages;
+	unsigned int messages_to_everyone;
+	unsigned int copies;
+	unsigned int copies_skipped;
+
+	// the visible sets worked out again and what came and went
+	unsigned int visibility_updates;
+	unsigned int entered;
+	unsigned int left;
+};
+
+//-----------------------------------------------------------------------------
+
+class CInterestManager
+{
+public:
+	explicit CInterestManager( float cell_size = 64.f );
+
+	//.........................................................................
+	// the entities, the changes show up in the next Update()
+
+	void	AddEntity( int id, float x, float y, float radius );
+	void	MoveEntity( int id, float x, float y );
+	void	SetEntityRadius( int id, float radius );
+	void	RemoveEntity( int id );
+	bool	HasEntity( int id ) const;
+
+	//.........................................................................
+	// adds the client if it's not there yet
+
+	void	SetClient( const TransportAddress& address, float x, float y, float view_radius = 0 );
+	void	RemoveClient( const TransportAddress& address );
+	int		GetClientCount() const;
+
+	//.........................................................................
+
+	// Entities further than the fraction of the distance they're seen at
+	// get an update every interval ticks. The fractions have to be added in
+	// order, ClearUpdateRates() sends everything every tick.
+	void	AddUpdateRate( float distance_fraction, int interval );
+	void	ClearUpdateRates();
+
+	// once a tick, before the sending
+	void	Update();
+	unsigned int GetTick() const { return mTick; }
+
+	//.........................................................................
+
+	// The ids of what the client sees, sorted. Entered and left are the
+	// changes of the last Update(). NULL for the clients that aren't there.
+	const std::vector< int >* GetVisible( const TransportAddress& address ) const;
+	const std::vector< int >* GetEntered( const TransportAddress& address ) const;
+	const std::vector< int >* GetLeft( const TransportAddress& address ) const;
+
+	bool	IsVisible( int id, const TransportAddress& address ) const;
+
+	// The clients the entity's message goes to this tick. Returns false if
+	// the entity isn't known, then it's up to the caller.
+	bool	GetReceivers( int id, bool rate_limited, std::vector< TransportAddress >& receivers );
+
+	const InterestStats& GetStats() const { return mStats; }
+	InterestStats& GetStats() { return mStats; }
+
+private:
+	struct CellRange
+	{
+		CellRange() : x0( 0 ), y0( 0 ), x1( -1 ), y1( -1 ) { }
+
+		bool operator==( const CellRange& other ) const { return x0 == other.x0 && y0 == other.y0 && x1 == other.x1 && y1 == other.y1; }
+		bool operator!=( const CellRange& other ) const { return ( *this == other ) == false; }
+
+		int x0, y0, x1, y1;
+	};
+
+	struct Observer
+	{
+		Observer() : client( 0 ), interval( 1 ) { }
+		Observer( int client, int interval ) : client( client ), interval( interval ) { }
+
+		int client;
+		int interval;
+	};
+
+	struct Entity
+	{
+		Entity() : id( 0 ), x( 0 ), y( 0 ), radius( 0 ), active( false ), removed( false ), dirty( false ), seen( 0 ) { }
+
+		int						id;
+		float					x;
+		float					y;
+		float					radius;
+		bool					active;
+		bool					removed;
+		bool					dirty;
+
+		// the last query it was found in, so it's looked at only once
+		unsigned int			seen;
+		CellRange				cells;
+		std::vector< Observer >	observers;
+	};
+
+	struct Client
+	{
+		Client() : x( 0 ), y( 0 ), view_radius( 0 ), active( false ), dirty( false ) { }
+
+		TransportAddress		address;
+		float					x;
+		float					y;
+		float					view_radius;
+		bool					active;
+		bool					dirty;
+		CellRange				cells;
+
+		// entity indices, sorted, and the ids of the changes
+		std::vector< int >		visible;
+		std::vector< int >		visible_ids;
+		std::vector< int >		entered;
+		std::vector< int >		left;
+	};
+
+	struct Cell
+	{
+		Cell() : changed( 0 ) { }
+
+		std::vector< int >		entities;
+		unsigned int			changed;
+	};
+
+	struct UpdateRate
+	{
+		float	distance_fraction;
+		int		interval;
+	};
+
+	CellRange	GetCells( float x, float y, float radius ) const;
+	Cell&		GetCell( int x, int y );
+	const Cell*	FindCell( int x, int y ) const;
+	void		MoveInGrid( int entity, const CellRange& cells );
+	void		MarkChanged( const CellRange& cells );
+	bool		HasChanged( const CellRange& cells ) const;
+
+	void		UpdateVisible( int client );
+	int			GetInterval( const Entity& entity, const Client& client ) const;
+	void		SetObserver( Entity& entity, int client, int interval );
+	void		RemoveObserver( Entity& entity, int client );
+
+	const Client* FindClient( const TransportAddress& address ) const;
+
+	float									mCellSize;
+	unsigned int							mTick;
+	unsigned int							mQuery;
+
+	std::vector< Entity >					mEntities;
+	std::vector< int >						mFreeEntities;
+	std::vector< int >						mDirtyEntities;
+	ceng::CFlatHashMap< int, int >			mEntityIndex;
+
+	std::vector< Client >					mClients;
+	std::vector< int >						mFreeClients;
+	ceng::CFlatHashMap< TransportAddress, int, TransportAddressHash >	mClientIndex;
+
+	std::vector< Cell >						mCells;
+	ceng::CFlatHashMap< unsigned int, int >	mCellIndex;
+
+	std::vector< UpdateRate >				mUpdateRates;
+	std::vector< int >						mQueryBuffer;
+	InterestStats							mStats;
+};
+
+//-----------------------------------------------------------------------------
+// Plugs the interest management in front of the peer. The messages about
+// an entity go to the clients that see it, the rest go to everyone like
+// through the peer's own handler. For the network thread, like
+// CNetworkPeer::GetPacketHandler().
+//-----------------------------------------------------------------------------
+
+class CInterestPacketHandler : public IPacketHandler
+{
+public:
+	// neither is owned
+	CInterestPacketHandler( CNetworkPeer* peer, CInterestManager* interest );
+
+	virtual void* GetUserData();
+	virtual void SendGameMessage( IGameMessage* message );
+	virtual IPacketHandler* GetBufferedPacketHandler( Uint32 wait_for );
+	virtual PlayerAddress* GetCurrentPacketAddress();
+
+private:
+	CNetworkPeer*					mPeer;
+	CInterestManager*				mInterest;
+	std::vector< TransportAddress >	mReceivers;
+	std::vector< PlayerAddress* >	mPlayers;
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -22,14 +22,17 @@
 #ifndef INC_IPACKETHANDLER_H
 #define INC_IPACKETHANDLER_H
 
-#include "multiplayer_utils.h"
+#include <SDL.h>
+
+#include "../../types.h"
+#include "itransport.h"
 
 class IGameMessage;
 
 struct PlayerAddress
 {
 	types::uint8			mTeam;
-	RakNet::SystemAddress	mAddress;
+	TransportAddress		mAddress;
 };
 
 
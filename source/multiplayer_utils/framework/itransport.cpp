@@ -0,0 +1,80 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include "itransport.h"
+
+#include <cstring>
+#include <sstream>
+
+const TransportAddress UNASSIGNED_TRANSPORT_ADDRESS;
+
+//-----------------------------------------------------------------------------
+
+TransportAddress TransportAddress::FromIP( unsigned char a, unsigned char b, unsigned char c, unsigned char d, unsigned short port )
+{
+	// the bytes go to memory in the order they're written
+	const unsigned char bytes[ 4 ] = { a, b, c, d };
+	unsigned int host = 0;
+	std::memcpy( &host, bytes, 4 );
+	return TransportAddress( host, port );
+}
+
+std::string TransportAddress::ToString() const
+{
+	if( IsUnassigned() )
+		return "UNASSIGNED_TRANSPORT_ADDRESS";
+
+	unsigned char bytes[ 4 ];
+	std::memcpy( bytes, &mHost, 4 );
+
+	std::stringstream ss;
+	ss << (int)bytes[ 0 ] << "." << (int)bytes[ 1 ] << "." << (int)bytes[ 2 ] << "." << (int)bytes[ 3 ] << ":" << mPort;
+	return ss.str();
+}
+
+//-----------------------------------------------------------------------------
+
+TransportPacket* NewTransportPacket( const TransportAddress& address, TransportEvent event, const unsigned char* data, unsigned int length )
+{
+	TransportPacket* result = new TransportPacket;
+	result->mAddress = address;
+	result->mEvent = event;
+	result->mLength = length;
+	if( length > 0 )
+	{
+		result->mData = new unsigned char[ length ];
+		std::memcpy( result->mData, data, length );
+	}
+	return result;
+}
+
+void DeleteTransportPacket( TransportPacket* packet )
+{
+	if( packet == NULL )
+		return;
+
+	delete [] packet->mData;
+	delete packet;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,154 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#ifndef INC_ITRANSPORT_H
+#define INC_ITRANSPORT_H
+
+#include <string>
+
+//-----------------------------------------------------------------------------
+// The transport is what moves the bytes for the packet handlers. The game
+// protocol only talks to ITransport, so the same code runs on RakNet
+// (CRakNetTransport), over UDP on localhost (CUdpTransport) or completely
+// inside one process (CLoopbackNetwork), which is what the tests and the
+// benchmarks use to run a server and N clients in one thread.
+//-----------------------------------------------------------------------------
+
+struct TransportAddress
+{
+	TransportAddress() : mHost( 0xFFFFFFFF ), mPort( 0xFFFF ) { }
+	TransportAddress( unsigned int host, unsigned short port ) : mHost( host ), mPort( port ) { }
+
+	// a.b.c.d:port
+	static TransportAddress FromIP( unsigned char a, unsigned char b, unsigned char c, unsigned char d, unsigned short port );
+
+	bool IsUnassigned() const { return mHost == 0xFFFFFFFF && mPort == 0xFFFF; }
+
+	std::string ToString() const;
+
+	bool operator==( const TransportAddress& other ) const { return mHost == other.mHost && mPort == other.mPort; }
+	bool operator!=( const TransportAddress& other ) const { return !operator==( other ); }
+	bool operator< ( const TransportAddress& other ) const { return mHost < other.mHost || ( mHost == other.mHost && mPort < other.mPort ); }
+
+	// IPv4 address in network byte order, like in sockaddr_in and RakNet's
+	// SystemAddress. The port is in host byte order.
+	unsigned int	mHost;
+	unsigned short	mPort;
+};
+
+extern const TransportAddress UNASSIGNED_TRANSPORT_ADDRESS;
+
+//-----------------------------------------------------------------------------
+
+enum TransportEvent
+{
+	TRANSPORT_DATA = 0,
+	TRANSPORT_CONNECTED,
+	TRANSPORT_DISCONNECTED
+};
+
+enum TransportPriority
+{
+	TRANSPORT_PRIORITY_HIGH = 0,
+	TRANSPORT_PRIORITY_IMMEDIATE
+};
+
+// The same classes RakNet has. The sequenced ones drop anything older than
+// what has already arrived on the channel, the ordered ones wait for the
+// missing ones. The loopback and udp transports never reorder anything, so
+// for them these only matter to the stats.
+enum TransportDelivery
+{
+	TRANSPORT_UNRELIABLE = 0,
+	TRANSPORT_UNRELIABLE_SEQUENCED,
+	TRANSPORT_RELIABLE,
+	TRANSPORT_RELIABLE_ORDERED,
+	TRANSPORT_DELIVERY_COUNT
+};
+
+// ordered and sequenced deliveries are kept in order per channel
+const int TRANSPORT_CHANNEL_COUNT = 32;
+
+// Received packets are owned by the transport that returned them. The data
+// of a TRANSPORT_DATA packet starts with the message id. Connection events
+// can carry the transport's own message id (RakNet does) or no data at all.
+struct TransportPacket
+{
+	TransportPacket() : mEvent( TRANSPORT_DATA ), mData( NULL ), mLength( 0 ), mImpl( NULL ) { }
+
+	TransportAddress	mAddress;
+	TransportEvent		mEvent;
+	unsigned char*		mData;
+	unsigned int		mLength;
+
+	// whatever the transport needs to release the packet
+	void*				mImpl;
+};
+
+// for the transports that copy the data into a packet of their own
+TransportPacket*	NewTransportPacket( const TransportAddress& address, TransportEvent event, const unsigned char* data, unsigned int length );
+void				DeleteTransportPacket( TransportPacket* packet );
+
+// what the transport knows about a connection, -1 for what it doesn't know
+struct TransportConnectionStats
+{
+	TransportConnectionStats() : rtt( -1 ), loss( -1 ), send_queue( -1 ) { }
+
+	// milliseconds, percent of the packets and messages waiting to be sent
+	float	rtt;
+	float	loss;
+	int		send_queue;
+};
+
+//-----------------------------------------------------------------------------
+
+class ITransport
+{
+public:
+	virtual ~ITransport() { }
+
+	virtual const char* GetName() const = 0;
+
+	// Sends the data to the address, or to everyone connected if the address
+	// is unassigned. Like with RakNet, broadcast with an address sends to
+	// everyone but that address. Returns false if nothing could be sent.
+	virtual bool Send( const unsigned char* data, unsigned int length, const TransportAddress& address, bool broadcast, TransportDelivery delivery, int channel, TransportPriority priority ) = 0;
+
+	// NULL when there's nothing left. Every packet has to be given back
+	// with DeallocatePacket, but they don't have to be given back in order.
+	virtual TransportPacket*	Receive() = 0;
+	virtual void				DeallocatePacket( TransportPacket* packet ) = 0;
+
+	// called once per network tick, before the packets are received
+	virtual void Update() { }
+
+	virtual TransportAddress	GetLocalAddress() const = 0;
+	virtual int					GetConnectionCount() const = 0;
+
+	// false if the transport doesn't keep track of the connection
+	virtual bool GetConnectionStats( const TransportAddress& /*address*/, TransportConnectionStats& /*stats*/ ) const { return false; }
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
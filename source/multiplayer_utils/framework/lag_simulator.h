@@ -1,10 +0,0 @@
-
-
-#ifndef INC_LAG_SIMULATOR_H
-#define INC_LAG_SIMULATOR_H
-
-bool IsLagSimulationOn();
-void SetLagSimulation(int delay);
-int  GetLagSimulation();
-
-#endif
\ No newline at end of file
@@ -25,16 +25,19 @@
 #include "RakPeerInterface.h"
 class Game;
 class IGameMessageFactory;
+class ITransport;
 
 struct MultiplayerData
 {
-	MultiplayerData() : userdata( NULL ), message_factory( NULL ), peer( NULL ), is_server( false ), run_natpunchthrough( false ) { }
+	MultiplayerData() : userdata( NULL ), message_factory( NULL ), peer( NULL ), is_server( false ), run_natpunchthrough( false ), transport( NULL ), handle_in_game_thread( false ) { }
 	MultiplayerData( void* userdata, IGameMessageFactory*	message_factory, RakNet::RakPeerInterface* peer, bool is_server, bool nat_punchthrough ) : 
 		userdata( userdata ), 
 		message_factory( message_factory ),
 		peer( peer ), 
 		is_server( is_server ), 
-		run_natpunchthrough( nat_punchthrough ) 
+		run_natpunchthrough( nat_punchthrough ),
+		transport( NULL ),
+		handle_in_game_thread( false )
 	{ 
 	}
 
@@ -43,6 +46,14 @@ struct MultiplayerData
 	RakNet::RakPeerInterface* peer;
 	bool is_server;
 	bool run_natpunchthrough;
+
+	// if set, this is used instead of the RakNet peer
+	ITransport* transport;
+
+	// The network thread only receives and sends, the game calls
+	// HandleMultiplayerMessages() every frame to run the handlers. Otherwise
+	// the handlers are run on the network thread.
+	bool handle_in_game_thread;
 };
 
 #endif
@@ -0,0 +1,603 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include "network_conditioner.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <SDL.h>
+
+#include "../../utils/debug.h"
+
+namespace {
+
+	unsigned int GetTicks()
+	{
+		return SDL_GetTicks();
+	}
+
+	unsigned int MixBits( unsigned int x )
+	{
+		x ^= x >> 16;
+		x *= 0x85EBCA6B;
+		x ^= x >> 13;
+		x *= 0xC2B2AE35;
+		x ^= x >> 16;
+		return x;
+	}
+
+	// The same minimal standard generator as ceng::LGMRandom, but with the
+	// state in the link so every link has a sequence of its own. The state
+	// is between 1 and 2^31 - 2.
+	double NextRandom( unsigned int& state )
+	{
+		long seed = (long)state;
+		const long hi = seed / 127773L;
+		const long lo = seed - hi * 127773L;
+		seed = 16807 * lo - 2836 * hi;
+		if( seed <= 0 )
+			seed += 2147483647L;
+		state = (unsigned int)seed;
+		return seed * 4.656612875e-10;
+	}
+
+	bool IsChance( unsigned int& state, float chance )
+	{
+		return chance > 0 && NextRandom( state ) < chance;
+	}
+
+	double GetJitter( unsigned int& state, const NetworkConditions& conditions )
+	{
+		if( conditions.jitter <= 0 )
+			return 0;
+
+		switch( conditions.jitter_distribution )
+		{
+		case JITTER_NORMAL:
+			{
+				// Box-Muller
+				const double u1 = NextRandom( state );
+				const double u2 = NextRandom( state );
+				return std::sqrt( -2.0 * std::log( u1 ) ) * std::cos( 6.283185307179586 * u2 ) * conditions.jitter;
+			}
+
+		case JITTER_EXPONENTIAL:
+			return -std::log( NextRandom( state ) ) * conditions.jitter;
+
+		case JITTER_UNIFORM:
+		default:
+			return ( NextRandom( state ) * 2.0 - 1.0 ) * conditions.jitter;
+		}
+	}
+
+	bool IsReliable( TransportDelivery delivery )
+	{
+		return delivery == TRANSPORT_RELIABLE || delivery == TRANSPORT_RELIABLE_ORDERED;
+	}
+
+}
+
+//=============================================================================
+
+bool NetworkConditions::IsOff() const
+{
+	return latency <= 0 && jitter <= 0 && loss <= 0 && burst_chance <= 0 &&
+		duplicate <= 0 && reorder <= 0 && bandwidth == 0;
+}
+
+void NetworkConditionerStats::Add( const NetworkConditionerStats& other )
+{
+	packets += other.packets;
+	bytes += other.bytes;
+	delivered += other.delivered;
+	lost += other.lost;
+	lost_in_burst += other.lost_in_burst;
+	queue_drops += other.queue_drops;
+	resent += other.resent;
+	duplicated += other.duplicated;
+	reordered += other.reordered;
+	total_delay += other.total_delay;
+	max_delay = std::max( max_delay, other.max_delay );
+	max_queue_bytes = std::max( max_queue_bytes, other.max_queue_bytes );
+}
+
+//=============================================================================
+
+CNetworkConditioner::CNetworkConditioner( ITransport* transport, unsigned int seed ) :
+	mTransport( transport ),
+	mSeed( seed ),
+	mClock( GetTicks ),
+	mEpoch( 0 ),
+	mIncomingDelivery( TRANSPORT_RELIABLE_ORDERED )
+{
+	cassert( mTransport );
+	mEpoch = mClock();
+
+	for( int i = 0; i < NETWORK_DIRECTION_COUNT; ++i )
+		mOff[ i ] = true;
+}
+
+CNetworkConditioner::~CNetworkConditioner()
+{
+	mWheel.Clear( mDue );
+	for( std::size_t i = 0; i < mDue.size(); ++i )
+		delete mDue[ i ];
+	mDue.clear();
+
+	for( std::size_t i = 0; i < mFreePending.size(); ++i )
+		delete mFreePending[ i ];
+	mFreePending.clear();
+
+	while( mReady.empty() == false )
+	{
+		DeallocatePacket( mReady.front() );
+		mReady.pop_front();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void CNetworkConditioner::SetConditions( NetworkDirection direction, const NetworkConditions& conditions )
+{
+	cassert( direction >= 0 && direction < NETWORK_DIRECTION_COUNT );
+	mDefaults[ direction ] = conditions;
+	UpdateIsOff( direction );
+}
+
+void CNetworkConditioner::SetConditions( NetworkDirection direction, const TransportAddress& address, const NetworkConditions& conditions )
+{
+	cassert( direction >= 0 && direction < NETWORK_DIRECTION_COUNT );
+	Link& link = GetLink( direction, address );
+	link.custom = true;
+	link.conditions = conditions;
+	UpdateIsOff( direction );
+}
+
+void CNetworkConditioner::ClearConditions( const TransportAddress& address )
+{
+	for( int i = 0; i < NETWORK_DIRECTION_COUNT; ++i )
+	{
+		std::map< TransportAddress, Link >::iterator link = mLinks[ i ].find( address );
+		if( link != mLinks[ i ].end() )
+		{
+			link->second.custom = false;
+			UpdateIsOff( (NetworkDirection)i );
+		}
+	}
+}
+
+NetworkConditions CNetworkConditioner::GetConditions( NetworkDirection direction, const TransportAddress& address ) const
+{
+	cassert( direction >= 0 && direction < NETWORK_DIRECTION_COUNT );
+	std::map< TransportAddress, Link >::const_iterator link = mLinks[ direction ].find( address );
+	if( link != mLinks[ direction ].end() && link->second.custom )
+		return link->second.conditions;
+
+	return mDefaults[ direction ];
+}
+
+void CNetworkConditioner::Reset()
+{
+	for( int i = 0; i < NETWORK_DIRECTION_COUNT; ++i )
+	{
+		mDefaults[ i ] = NetworkConditions();
+		for( std::map< TransportAddress, Link >::iterator link = mLinks[ i ].begin(); link != mLinks[ i ].end(); ++link )
+			link->second.custom = false;
+
+		mOff[ i ] = true;
+	}
+}
+
+void CNetworkConditioner::SetSeed( unsigned int seed )
+{
+	mSeed = seed;
+	for( int i = 0; i < NETWORK_DIRECTION_COUNT; ++i )
+	{
+		for( std::map< TransportAddress, Link >::iterator link = mLinks[ i ].begin(); link != mLinks[ i ].end(); ++link )
+			ResetLink( (NetworkDirection)i, link->first, link->second );
+	}
+}
+
+void CNetworkConditioner::SetIncomingDelivery( TransportDelivery delivery )
+{
+	mIncomingDelivery = delivery;
+}
+
+void CNetworkConditioner::SetClock( Clock clock )
+{
+	cassert( clock );
+	cassert( mWheel.IsEmpty() && "The clock can't be changed while packets are held back" );
+
+	// the wheel goes on from where it was
+	mClock = clock;
+	mEpoch = mClock() - mWheel.GetCurrentTime();
+
+	for( int i = 0; i < NETWORK_DIRECTION_COUNT; ++i )
+	{
+		for( std::map< TransportAddress, Link >::iterator link = mLinks[ i ].begin(); link != mLinks[ i ].end(); ++link )
+		{
+			link->second.busy_until = 0;
+			link->second.last_time = 0;
+		}
+	}
+}
+
+NetworkConditionerStats CNetworkConditioner::GetStats( NetworkDirection direction ) const
+{
+	cassert( direction >= 0 && direction < NETWORK_DIRECTION_COUNT );
+	NetworkConditionerStats result;
+	for( std::map< TransportAddress, Link >::const_iterator link = mLinks[ direction ].begin(); link != mLinks[ direction ].end(); ++link )
+		result.Add( link->second.stats );
+
+	return result;
+}
+
+NetworkConditionerStats CNetworkConditioner::GetStats( NetworkDirection direction, const TransportAddress& address ) const
+{
+	cassert( direction >= 0 && direction < NETWORK_DIRECTION_COUNT );
+	std::map< TransportAddress, Link >::const_iterator link = mLinks[ direction ].find( address );
+	return ( link == mLinks[ direction ].end() ) ? NetworkConditionerStats() : link->second.stats;
+}
+
+//-----------------------------------------------------------------------------
+
+bool CNetworkConditioner::Send( const unsigned char* data, unsigned int length, const TransportAddress& address, bool broadcast, TransportDelivery delivery, int channel, TransportPriority priority )
+{
+	if( mOff[ NETWORK_OUTGOING ] )
+		return mTransport->Send( data, length, address, broadcast, delivery, channel, priority );
+
+	if( broadcast || address.IsUnassigned() )
+	{
+		// before any connection has been seen the transport knows better
+		if( mConnections.empty() )
+			return mTransport->Send( data, length, address, broadcast, delivery, channel, priority );
+
+		bool sent = false;
+		for( std::size_t i = 0; i < mConnections.size(); ++i )
+		{
+			if( address.IsUnassigned() == false && mConnections[ i ] == address )
+				continue;
+
+			Condition( NETWORK_OUTGOING, mConnections[ i ], data, length, delivery, channel, priority );
+			sent = true;
+		}
+		return sent;
+	}
+
+	if( IsConnectedTo( address ) == false )
+		return mTransport->Send( data, length, address, broadcast, delivery, channel, priority );
+
+	Condition( NETWORK_OUTGOING, address, data, length, delivery, channel, priority );
+	return true;
+}
+
+TransportPacket* CNetworkConditioner::Receive()
+{
+	if( mReady.empty() )
+	{
+		ReceiveFromTransport();
+		ReleaseDue();
+	}
+
+	if( mReady.empty() )
+		return NULL;
+
+	TransportPacket* result = mReady.front();
+	mReady.pop_front();
+	return result;
+}
+
+void CNetworkConditioner::DeallocatePacket( TransportPacket* packet )
+{
+	// the ones that were held back are copies of our own
+	if( packet && packet->mImpl == this )
+		DeleteTransportPacket( packet );
+	else
+		mTransport->DeallocatePacket( packet );
+}
+
+void CNetworkConditioner::Update()
+{
+	mTransport->Update();
+	ReleaseDue();
+}
+
+bool CNetworkConditioner::GetConnectionStats( const TransportAddress& address, TransportConnectionStats& stats ) const
+{
+	if( mTransport->GetConnectionStats( address, stats ) == false && IsConnectedTo( address ) == false )
+		return false;
+
+	float rtt = std::max( stats.rtt, 0.f );
+	float delivered = 1.f - std::max( stats.loss, 0.f ) / 100.f;
+	for( int i = 0; i < NETWORK_DIRECTION_COUNT; ++i )
+	{
+		std::map< TransportAddress, Link >::const_iterator link = mLinks[ i ].find( address );
+		if( link == mLinks[ i ].end() || link->second.stats.packets == 0 )
+			continue;
+
+		const NetworkConditionerStats& link_stats = link->second.stats;
+		if( link_stats.delivered > 0 )
+			rtt += (float)( link_stats.total_delay / link_stats.delivered );
+
+		const unsigned int lost = link_stats.lost + link_stats.lost_in_burst + link_stats.queue_drops;
+		delivered *= 1.f - (float)lost / link_stats.packets;
+
+		if( i == NETWORK_OUTGOING )
+			stats.send_queue = std::max( stats.send_queue, 0 ) + link->second.pending;
+	}
+
+	stats.rtt = rtt;
+	stats.loss = ( 1.f - delivered ) * 100.f;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+CNetworkConditioner::Link& CNetworkConditioner::GetLink( NetworkDirection direction, const TransportAddress& address )
+{
+	std::map< TransportAddress, Link >::iterator i = mLinks[ direction ].find( address );
+	if( i != mLinks[ direction ].end() )
+		return i->second;
+
+	Link& result = mLinks[ direction ][ address ];
+	ResetLink( direction, address, result );
+	return result;
+}
+
+void CNetworkConditioner::ResetLink( NetworkDirection direction, const TransportAddress& address, Link& link )
+{
+	const unsigned int hash = MixBits( mSeed ^ MixBits( address.mHost ^ MixBits( address.mPort | ( direction << 16 ) ) ) );
+	link.random = 1 + hash % 2147483646u;
+	link.in_burst = false;
+}
+
+void CNetworkConditioner::UpdateIsOff( NetworkDirection direction )
+{
+	mOff[ direction ] = mDefaults[ direction ].IsOff();
+	for( std::map< TransportAddress, Link >::const_iterator link = mLinks[ direction ].begin(); link != mLinks[ direction ].end() && mOff[ direction ]; ++link )
+	{
+		if( link->second.custom && link->second.conditions.IsOff() == false )
+			mOff[ direction ] = false;
+	}
+}
+
+bool CNetworkConditioner::IsConnectedTo( const TransportAddress& address ) const
+{
+	return std::find( mConnections.begin(), mConnections.end(), address ) != mConnections.end();
+}
+
+//-----------------------------------------------------------------------------
+
+bool CNetworkConditioner::Condition( NetworkDirection direction, const TransportAddress& address, const unsigned char* data, unsigned int length, TransportDelivery delivery, int channel, TransportPriority priority )
+{
+	Link& link = GetLink( direction, address );
+	const NetworkConditions& conditions = link.custom ? link.conditions : mDefaults[ direction ];
+	NetworkConditionerStats& stats = link.stats;
+	const unsigned int now = GetTime();
+
+	stats.packets++;
+	stats.bytes += length;
+
+	// Gilbert-Elliott, once in a burst every packet is lost until it ends
+	bool lost = false;
+	bool lost_in_burst = false;
+	if( link.in_burst && NextRandom( link.random ) * conditions.burst_length >= 1.0 )
+	{
+		lost = lost_in_burst = true;
+	}
+	else
+	{
+		link.in_burst = false;
+		if( IsChance( link.random, conditions.burst_chance ) )
+			link.in_burst = lost = lost_in_burst = true;
+		else
+			lost = IsChance( link.random, conditions.loss );
+	}
+
+	const bool reliable = IsReliable( delivery );
+	double delay = 0;
+	if( lost )
+	{
+		if( reliable == false )
+		{
+			if( lost_in_burst )
+				stats.lost_in_burst++;
+			else
+				stats.lost++;
+			return false;
+		}
+
+		stats.resent++;
+		delay += conditions.resend_delay;
+	}
+
+	// the bandwidth, the packet goes when the ones before it have gone
+	double departure = now;
+	if( conditions.bandwidth > 0 )
+	{
+		const double start = std::max( (double)now, link.busy_until );
+		const double queued = ( start - now ) * conditions.bandwidth / 1000.0 + length;
+		if( reliable == false && conditions.queue_size > 0 && queued > conditions.queue_size )
+		{
+			stats.queue_drops++;
+			return false;
+		}
+
+		stats.max_queue_bytes = std::max( stats.max_queue_bytes, (unsigned int)queued );
+		link.busy_until = start + length * 1000.0 / conditions.bandwidth;
+		departure = link.busy_until;
+	}
+
+	delay += conditions.latency + GetJitter( link.random, conditions );
+	unsigned int time = (unsigned int)( departure + std::max( delay, 0.0 ) + 0.5 );
+
+	// only the unreliable ones get past the others
+	if( delivery == TRANSPORT_UNRELIABLE && IsChance( link.random, conditions.reorder ) )
+	{
+		time += (unsigned int)( conditions.reorder_delay + 0.5 );
+		stats.reordered++;
+	}
+	else
+	{
+		time = std::max( time, link.last_time );
+		link.last_time = time;
+	}
+
+	Pending* pending = NewPending();
+	pending->direction = direction;
+	pending->address = address;
+	pending->data.assign( (const char*)data, length );
+	pending->delivery = delivery;
+	pending->channel = channel;
+	pending->priority = priority;
+	pending->time_in = now;
+
+	const bool duplicate = delivery == TRANSPORT_UNRELIABLE && IsChance( link.random, conditions.duplicate );
+	Pending* copy = NULL;
+	if( duplicate )
+	{
+		copy = NewPending();
+		*copy = *pending;
+		stats.duplicated++;
+	}
+
+	Schedule( link, pending, time );
+	if( copy )
+		Schedule( link, copy, time );
+
+	return true;
+}
+
+void CNetworkConditioner::Schedule( Link& link, Pending* pending, unsigned int time )
+{
+	pending->time_out = time;
+
+	// nothing to wait for, saves a tick on the way out
+	if( pending->direction == NETWORK_OUTGOING && link.pending == 0 && (int)( time - GetTime() ) <= 0 )
+	{
+		Deliver( link, pending );
+		return;
+	}
+
+	link.pending++;
+	mWheel.Add( pending, time );
+}
+
+void CNetworkConditioner::Deliver( Link& link, Pending* pending )
+{
+	if( pending->direction == NETWORK_OUTGOING )
+	{
+		mTransport->Send( (const unsigned char*)pending->data.data(), (unsigned int)pending->data.size(), pending->address, false, pending->delivery, pending->channel, pending->priority );
+	}
+	else if( link.disconnected && (int)( pending->time_in - link.disconnect_time ) <= 0 )
+	{
+		DeletePending( pending );
+		return;
+	}
+	else
+	{
+		TransportPacket* packet = NewTransportPacket( pending->address, TRANSPORT_DATA, (const unsigned char*)pending->data.data(), (unsigned int)pending->data.size() );
+		packet->mImpl = this;
+		mReady.push_back( packet );
+	}
+
+	const unsigned int delay = pending->time_out - pending->time_in;
+	link.stats.delivered++;
+	link.stats.total_delay += delay;
+	link.stats.max_delay = std::max( link.stats.max_delay, delay );
+
+	DeletePending( pending );
+}
+
+void CNetworkConditioner::ReleaseDue()
+{
+	mWheel.Advance( GetTime(), mDue );
+	for( std::size_t i = 0; i < mDue.size(); ++i )
+	{
+		Link& link = GetLink( mDue[ i ]->direction, mDue[ i ]->address );
+		cassert( link.pending > 0 );
+		link.pending--;
+		Deliver( link, mDue[ i ] );
+	}
+	mDue.clear();
+}
+
+void CNetworkConditioner::ReceiveFromTransport()
+{
+	for( TransportPacket* packet = mTransport->Receive(); packet; packet = mTransport->Receive() )
+	{
+		switch( packet->mEvent )
+		{
+		case TRANSPORT_CONNECTED:
+			if( IsConnectedTo( packet->mAddress ) == false )
+				mConnections.push_back( packet->mAddress );
+			mReady.push_back( packet );
+			break;
+
+		case TRANSPORT_DISCONNECTED:
+			{
+				mConnections.erase( std::remove( mConnections.begin(), mConnections.end(), packet->mAddress ), mConnections.end() );
+
+				// the ones from a peer that has already gone are lost
+				Link& link = GetLink( NETWORK_INCOMING, packet->mAddress );
+				link.disconnected = true;
+				link.disconnect_time = GetTime();
+			}
+			mReady.push_back( packet );
+			break;
+
+		case TRANSPORT_DATA:
+		default:
+			if( mOff[ NETWORK_INCOMING ] )
+			{
+				mReady.push_back( packet );
+			}
+			else
+			{
+				Condition( NETWORK_INCOMING, packet->mAddress, packet->mData, packet->mLength, mIncomingDelivery, 0, TRANSPORT_PRIORITY_HIGH );
+				mTransport->DeallocatePacket( packet );
+			}
+			break;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+CNetworkConditioner::Pending* CNetworkConditioner::NewPending()
+{
+	if( mFreePending.empty() )
+		return new Pending;
+
+	Pending* result = mFreePending.back();
+	mFreePending.pop_back();
+	return result;
+}
+
+void CNetworkConditioner::DeletePending( Pending* pending )
+{
+	mFreePending.push_back( pending );
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,303 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#ifndef INC_NETWORK_CONDITIONER_H
+#define INC_NETWORK_CONDITIONER_H
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "itransport.h"
+#include "timing_wheel.h"
+
+//-----------------------------------------------------------------------------
+// Makes a transport behave like a bad network. CNetworkConditioner wraps
+// another transport and holds the packets back, loses, duplicates and
+// reorders them on the way in and on the way out, so the game can be tried
+// on a bad Wi-Fi without one. The conditions can be set for everyone or for
+// one peer at a time, separately for both directions.
+//
+// Everything random comes from the seed, every peer and direction has its
+// own sequence, so the same seed and the same traffic do the same thing.
+//
+// The reliable deliveries aren't lost, a lost one comes late as if it had
+// been resent, and the ordered and sequenced ones stay in order. The
+// receiving end can't see how a packet was sent, so the incoming packets are
+// handled as SetIncomingDelivery() says, TRANSPORT_RELIABLE_ORDERED unless
+// told otherwise.
+//
+// The conditioner learns the connections from the events it receives, so
+// broadcasts reach the peers it has seen connecting. Not thread safe, it's
+// used from the thread that runs the peer.
+//-----------------------------------------------------------------------------
+
+enum NetworkDirection
+{
+	NETWORK_OUTGOING = 0,
+	NETWORK_INCOMING,
+	NETWORK_DIRECTION_COUNT
+};
+
+enum JitterDistribution
+{
+	// latency +- jitter
+	JITTER_UNIFORM = 0,
+	// jitter is the standard deviation
+	JITTER_NORMAL,
+	// only ever late, jitter is the average, with a long tail like on Wi-Fi
+	JITTER_EXPONENTIAL
+};
+
+struct NetworkConditions
+{
+	NetworkConditions() :
+		latency( 0 ),
+		jitter( 0 ),
+		jitter_distribution( JITTER_UNIFORM ),
+		loss( 0 ),
+		burst_chance( 0 ),
+		burst_length( 1 ),
+		duplicate( 0 ),
+		reorder( 0 ),
+		reorder_delay( 0 ),
+		bandwidth( 0 ),
+		queue_size( 0 ),
+		resend_delay( 100 )
+	{
+	}
+
+	bool IsOff() const;
+
+	// milliseconds
+	float				latency;
+	float				jitter;
+	JitterDistribution	jitter_distribution;
+
+	// the chance of losing any one packet, 0 - 1
+	float				loss;
+
+	// The chance of a packet starting a burst of losses and the average
+	// number of packets lost in a burst.
+	float				burst_chance;
+	float				burst_length;
+
+	// the chances of an unreliable packet coming twice, or reorder_delay
+	// milliseconds later than it should, after the ones sent after it
+	float				duplicate;
+	float				reorder;
+	float				reorder_delay;
+
+	// Bytes per second, 0 has no limit. The packets wait for their turn in a
+	// queue of queue_size bytes, the unreliable ones that don't fit in are
+	// dropped. With queue_size 0 the queue is as long as it needs to be.
+	unsigned int		bandwidth;
+	unsigned int		queue_size;
+
+	// how much later a lost reliable packet comes
+	float				resend_delay;
+};
+
+struct NetworkConditionerStats
+{
+	NetworkConditionerStats() :
+		packets( 0 ),
+		bytes( 0 ),
+		delivered( 0 ),
+		lost( 0 ),
+		lost_in_burst( 0 ),
+		queue_drops( 0 ),
+		resent( 0 ),
+		duplicated( 0 ),
+		reordered( 0 ),
+		total_delay( 0 ),
+		max_delay( 0 ),
+		max_queue_bytes( 0 )
+	{
+	}
+
+	void Add( const NetworkConditionerStats& other );
+
+	// the packets that came in to be conditioned and the ones let through,
+	// the duplicates included
+	unsigned int	packets;
+	unsigned int	bytes;
+	unsigned int	delivered;
+
+	// lost randomly, lost in a burst and dropped because the queue was full
+	unsigned int	lost;
+	unsigned int	lost_in_burst;
+	unsigned int	queue_drops;
+
+	// reliable packets that were lost and came later
+	unsigned int	resent;
+
+	unsigned int	duplicated;
+	unsigned int	reordered;
+
+	// milliseconds the packets were held back, not counting the wait for
+	// the next Update()
+	double			total_delay;
+	unsigned int	max_delay;
+
+	unsigned int	max_queue_bytes;
+};
+
+//-----------------------------------------------------------------------------
+
+class CNetworkConditioner : public ITransport
+{
+public:
+	// milliseconds, SDL_GetTicks() by default
+	typedef unsigned int (*Clock)();
+
+	// The transport isn't owned, it has to live longer than the conditioner.
+	// Whatever is still held back when the conditioner is deleted is lost.
+	explicit CNetworkConditioner( ITransport* transport, unsigned int seed = 1 );
+	~CNetworkConditioner();
+
+	ITransport* GetTransport() const { return mTransport; }
+
+	// for everyone who doesn't have conditions of their own
+	void SetConditions( NetworkDirection direction, const NetworkConditions& conditions );
+	void SetConditions( NetworkDirection direction, const TransportAddress& address, const NetworkConditions& conditions );
+
+	// back to the conditions of everyone, in both directions
+	void ClearConditions( const TransportAddress& address );
+
+	NetworkConditions GetConditions( NetworkDirection direction, const TransportAddress& address ) const;
+
+	// turns everything off, the packets that are held back still come
+	void Reset();
+
+	// starts the random sequences over
+	void SetSeed( unsigned int seed );
+
+	void SetIncomingDelivery( TransportDelivery delivery );
+	void SetClock( Clock clock );
+
+	// the totals of a direction and of one peer
+	NetworkConditionerStats GetStats( NetworkDirection direction ) const;
+	NetworkConditionerStats GetStats( NetworkDirection direction, const TransportAddress& address ) const;
+
+	// the packets held back in both directions
+	int GetPendingCount() const { return (int)mWheel.GetSize(); }
+
+	//.........................................................................
+
+	virtual const char* GetName() const { return mTransport->GetName(); }
+
+	virtual bool Send( const unsigned char* data, unsigned int length, const TransportAddress& address, bool broadcast, TransportDelivery delivery, int channel, TransportPriority priority );
+
+	virtual TransportPacket*	Receive();
+	virtual void				DeallocatePacket( TransportPacket* packet );
+
+	// sends the outgoing packets that are due
+	virtual void Update();
+
+	virtual TransportAddress	GetLocalAddress() const { return mTransport->GetLocalAddress(); }
+	virtual int					GetConnectionCount() const { return mTransport->GetConnectionCount(); }
+
+	// what the transport says, with the delays and the losses that were
+	// added on top of it so far
+	virtual bool GetConnectionStats( const TransportAddress& address, TransportConnectionStats& stats ) const;
+
+private:
+	struct Link
+	{
+		Link() : custom( false ), random( 1 ), in_burst( false ), busy_until( 0 ), last_time( 0 ), pending( 0 ), disconnected( false ), disconnect_time( 0 ) { }
+
+		bool					custom;
+		NetworkConditions		conditions;
+		NetworkConditionerStats	stats;
+
+		unsigned int			random;
+		bool					in_burst;
+
+		// when the bandwidth is free again and when the last packet that
+		// had to stay in order goes
+		double					busy_until;
+		unsigned int			last_time;
+		int						pending;
+
+		// what came in before the peer disconnected is lost
+		bool					disconnected;
+		unsigned int			disconnect_time;
+	};
+
+	struct Pending
+	{
+		NetworkDirection	direction;
+		TransportAddress	address;
+		std::string			data;
+		TransportDelivery	delivery;
+		int					channel;
+		TransportPriority	priority;
+		unsigned int		time_in;
+		unsigned int		time_out;
+	};
+
+	// milliseconds on the wheel
+	unsigned int GetTime() const { return mClock() - mEpoch; }
+
+	Link&	GetLink( NetworkDirection direction, const TransportAddress& address );
+	void	ResetLink( NetworkDirection direction, const TransportAddress& address, Link& link );
+	void	UpdateIsOff( NetworkDirection direction );
+	bool	IsConnectedTo( const TransportAddress& address ) const;
+
+	// false if the packet was lost
+	bool	Condition( NetworkDirection direction, const TransportAddress& address, const unsigned char* data, unsigned int length, TransportDelivery delivery, int channel, TransportPriority priority );
+	void	Schedule( Link& link, Pending* pending, unsigned int time );
+	void	Deliver( Link& link, Pending* pending );
+	void	ReleaseDue();
+	void	ReceiveFromTransport();
+
+	Pending*	NewPending();
+	void		DeletePending( Pending* pending );
+
+	ITransport*								mTransport;
+	unsigned int							mSeed;
+	Clock									mClock;
+	unsigned int							mEpoch;
+	TransportDelivery						mIncomingDelivery;
+
+	NetworkConditions						mDefaults[ NETWORK_DIRECTION_COUNT ];
+	bool									mOff[ NETWORK_DIRECTION_COUNT ];
+	std::map< TransportAddress, Link >		mLinks[ NETWORK_DIRECTION_COUNT ];
+
+	CTimingWheel< Pending* >				mWheel;
+	std::vector< Pending* >					mDue;
+	std::vector< Pending* >					mFreePending;
+
+	std::vector< TransportAddress >			mConnections;
+	std::deque< TransportPacket* >			mReady;
+
+	// can't be copied
+	CNetworkConditioner( const CNetworkConditioner& );
+	CNetworkConditioner& operator=( const CNetworkConditioner& );
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,1403 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include "network_peer.h"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+
+#include <SDL.h>
+
+#include "../../utils/memorypool/callocationtracker.h"
+#include "../../utils/memorypool/cmemorypool.h"
+#include "igamemessagefactory.h"
+#include "igamemessage.h"
+#include "multiplayer_config.h"
+#include "spsc_queue.h"
+#include "timing_wheel.h"
+
+#if defined(_MSC_VER)
+#	include <intrin.h>
+#endif
+
+
+namespace {
+
+	class CMutexLock
+	{
+	public:
+		CMutexLock( SDL_mutex* mutex ) : mMutex( mutex ) { SDL_mutexP( mMutex ); }
+		~CMutexLock() { SDL_mutexV( mMutex ); }
+
+	private:
+		SDL_mutex* mMutex;
+	};
+
+	// message id, the size of the data and the data
+	const unsigned int MESSAGE_HEADER_SIZE = 5;
+
+	// leaves room for RakNet's and UDP's headers in a 1492 byte MTU
+	const unsigned int DEFAULT_MAX_DATAGRAM_SIZE = 1200;
+
+	// Appends the message to the end of the buffer. The layout is the same
+	// RakNet's BitStream used to write: message id, the size of the data as a
+	// big endian int and the serialized data.
+	void SerializeMessage( IGameMessage* message, network_utils::types::ustring& buffer )
+	{
+		cassert( message );
+		cassert( message->GetType() >= 0 && message->GetType() < GAME_MESSAGE_BATCH_ID );
+
+		network_utils::CSerialSaver saver;
+		message->BitSerialize( &saver );
+
+		const network_utils::types::ustring& data = saver.GetData();
+		buffer += (char)message->GetType();
+		buffer += network_utils::ConvertUint32ToHex( (network_utils::uint32)data.size() );
+		buffer += data;
+	}
+
+	// what the outgoing queues are found with
+	struct OutgoingKey
+	{
+		OutgoingKey() : broadcast( true ), delivery( TRANSPORT_RELIABLE ), channel( 0 ) { }
+		OutgoingKey( const TransportAddress& address, bool broadcast, TransportDelivery delivery, int channel ) :
+			address( address ), broadcast( broadcast ), delivery( delivery ), channel( channel ) { }
+
+		bool operator==( const OutgoingKey& other ) const
+		{
+			return address == other.address && broadcast == other.broadcast &&
+				delivery == other.delivery && channel == other.channel;
+		}
+
+		TransportAddress	address;
+		bool				broadcast;
+		TransportDelivery	delivery;
+		int					channel;
+	};
+
+	struct OutgoingKeyHash
+	{
+		unsigned int operator()( const OutgoingKey& key ) const
+		{
+			const unsigned int extra = ( key.broadcast ? 1 : 0 ) | ( key.delivery << 1 ) | ( key.channel << 4 );
+			return TransportAddressHash()( key.address ) ^ ceng::impl::HashInteger( extra );
+		}
+	};
+
+	// gives the message back to the factory however the handling ends
+	class CReleaseMessage
+	{
+	public:
+		CReleaseMessage( IGameMessageFactory* factory, IGameMessage* message ) : mFactory( factory ), mMessage( message ) { }
+		~CReleaseMessage() { mFactory->ReleaseMessage( mMessage ); }
+
+		// someone else takes care of it
+		IGameMessage* Take() { IGameMessage* result = mMessage; mMessage = NULL; return result; }
+
+	private:
+		IGameMessageFactory*	mFactory;
+		IGameMessage*			mMessage;
+	};
+
+	// compare and swap on a pointer, returns what was there before
+	void* AtomicCompareExchange( void* volatile* value, void* candidate, void* current )
+	{
+#if defined(_MSC_VER) && defined(_WIN64)
+		return (void*)_InterlockedCompareExchange64( (volatile __int64*)value, (__int64)candidate, (__int64)current );
+#elif defined(_MSC_VER)
+		return (void*)_InterlockedCompareExchange( (volatile long*)value, (long)candidate, (long)current );
+#else
+		return __sync_val_compare_and_swap( value, current, candidate );
+#endif
+	}
+
+}
+
+//=============================================================================
+// What the network thread and the game thread share in the threaded mode.
+// The network thread pushes the decoded messages to mToGame, the game thread
+// pushes what it sends and the messages it has handled to mToNetwork. When
+// a queue is full the messages wait on the side of the thread that pushed
+// them, and go in before anything else the next time.
+
+class CNetworkThread
+{
+public:
+	struct ReceivedMessage
+	{
+		ReceivedMessage() : message( NULL ) { }
+		ReceivedMessage( IGameMessage* message, const PlayerAddress& player ) : message( message ), player( player ) { }
+
+		IGameMessage*	message;
+
+		// a copy, the player can be gone by the time the game gets to it
+		PlayerAddress	player;
+	};
+
+	struct GameMessage
+	{
+		GameMessage() : message( NULL ), handled( false ) { }
+		GameMessage( IGameMessage* message, bool handled ) : message( message ), handled( handled ) { }
+
+		// handled ones go back to the factory, the rest are sent
+		IGameMessage*	message;
+		bool			handled;
+	};
+
+	explicit CNetworkThread( unsigned int queue_size ) :
+		mThread( NULL ),
+		mMutex( SDL_CreateMutex() ),
+		mRunning( true ),
+		mToGame( queue_size ),
+		mToNetwork( queue_size )
+	{
+	}
+
+	~CNetworkThread()
+	{
+		SDL_DestroyMutex( mMutex );
+		mMutex = NULL;
+	}
+
+	bool IsRunning() const
+	{
+		CMutexLock lock( mMutex );
+		return mRunning;
+	}
+
+	void Stop()
+	{
+		CMutexLock lock( mMutex );
+		mRunning = false;
+	}
+
+	// The network thread's counters are copied for the game thread after
+	// every round, the game thread's own ones are added on top.
+	NetworkThreadStats GetStats() const
+	{
+		NetworkThreadStats result;
+		{
+			CMutexLock lock( mMutex );
+			result = mPublishedStats;
+		}
+
+		result.to_network = mGameStats.to_network;
+		result.to_network_waits = mGameStats.to_network_waits;
+		result.max_to_network = mGameStats.max_to_network;
+		return result;
+	}
+
+	//.........................................................................
+	// the network thread
+
+	void ToGame( IGameMessage* message, const PlayerAddress& player )
+	{
+		const ReceivedMessage received( message, player );
+		if( mToGameWaiting.empty() == false || mToGame.Push( received ) == false )
+		{
+			mToGameWaiting.push_back( received );
+			mNetworkStats.to_game_waits++;
+			return;
+		}
+
+		mNetworkStats.to_game++;
+		mNetworkStats.max_to_game = std::max( mNetworkStats.max_to_game, mToGame.GetSize() );
+	}
+
+	// true if nothing is waiting for the game anymore
+	bool PushWaitingToGame()
+	{
+		while( mToGameWaiting.empty() == false && mToGame.Push( mToGameWaiting.front() ) )
+		{
+			mToGameWaiting.pop_front();
+			mNetworkStats.to_game++;
+		}
+
+		return mToGameWaiting.empty();
+	}
+
+	bool IsGameBehind() const { return mToGameWaiting.empty() == false; }
+
+	void PublishStats()
+	{
+		mNetworkStats.updates++;
+
+		CMutexLock lock( mMutex );
+		mPublishedStats = mNetworkStats;
+	}
+
+	//.........................................................................
+	// the game thread
+
+	void ToNetwork( IGameMessage* message, bool handled )
+	{
+		const GameMessage game_message( message, handled );
+		if( mToNetworkWaiting.empty() == false || mToNetwork.Push( game_message ) == false )
+		{
+			mToNetworkWaiting.push_back( game_message );
+			mGameStats.to_network_waits++;
+			return;
+		}
+
+		mGameStats.to_network++;
+		mGameStats.max_to_network = std::max( mGameStats.max_to_network, mToNetwork.GetSize() );
+	}
+
+	void PushWaitingToNetwork()
+	{
+		while( mToNetworkWaiting.empty() == false && mToNetwork.Push( mToNetworkWaiting.front() ) )
+		{
+			mToNetworkWaiting.pop_front();
+			mGameStats.to_network++;
+		}
+	}
+
+	//.........................................................................
+
+	SDL_Thread*						mThread;
+
+	// mRunning and mPublishedStats are behind the mutex, mNetworkStats is
+	// only touched by the network thread and mGameStats by the game thread
+	SDL_mutex*						mMutex;
+	bool							mRunning;
+	NetworkThreadStats				mNetworkStats;
+	NetworkThreadStats				mGameStats;
+	NetworkThreadStats				mPublishedStats;
+
+	CSpscQueue< ReceivedMessage >	mToGame;
+	CSpscQueue< GameMessage >		mToNetwork;
+	std::deque< ReceivedMessage >	mToGameWaiting;
+	std::deque< GameMessage >		mToNetworkWaiting;
+};
+
+//=============================================================================
+
+class CPacketHandlerForClient : public IPacketHandler
+{
+public:
+	CPacketHandlerForClient() :
+		mMessageBufferMutex( SDL_CreateMutex() ),
+		mUserData( NULL ),
+		mThread( NULL ),
+		mParent( NULL ),
+		mCurrentPacketAddress( NULL )
+	{
+	}
+
+	~CPacketHandlerForClient()
+	{
+		while( mMessageBuffer.empty() == false )
+		{
+			delete mMessageBuffer.front();
+			mMessageBuffer.pop_front();
+		}
+
+		SDL_DestroyMutex( mMessageBufferMutex );
+	}
+
+	void*	GetUserData() { return mUserData; }
+	void	SetUserData( void* userdata ) { mUserData = userdata; }
+
+	virtual void SendGameMessage( IGameMessage* message )
+	{
+		// in the threaded mode straight to the network thread
+		if( mThread )
+		{
+			mThread->ToNetwork( message, false );
+			return;
+		}
+
+		CMutexLock lock( mMessageBufferMutex );
+		mMessageBuffer.push_back( message );
+	}
+
+	virtual IPacketHandler* GetBufferedPacketHandler( Uint32 wait_for )
+	{
+		return mParent ? mParent->GetBufferedPacketHandler( wait_for ) : NULL;
+	}
+
+	virtual PlayerAddress* GetCurrentPacketAddress() { return mCurrentPacketAddress; }
+
+	void SendAllMessagesFromBuffer( IPacketHandler* parent )
+	{
+		CMutexLock lock( mMessageBufferMutex );
+
+		while( mMessageBuffer.empty() == false )
+		{
+			IGameMessage* message = mMessageBuffer.front();
+			mMessageBuffer.pop_front();
+
+			cassert( message );
+			parent->SendGameMessage( message );
+		}
+	}
+
+
+	SDL_mutex*					mMessageBufferMutex;
+	std::list< IGameMessage* >	mMessageBuffer;
+	void*						mUserData;
+
+	// only in the threaded mode, where the game thread runs the handlers
+	CNetworkThread*				mThread;
+	IPacketHandler*				mParent;
+	PlayerAddress*				mCurrentPacketAddress;
+};
+
+//=============================================================================
+
+CSlotTeamPolicy::CSlotTeamPolicy( int team_count ) :
+	mTeamCount( team_count )
+{
+	cassert( team_count > 0 && team_count < TEAM_ALL );
+}
+
+types::uint8 CSlotTeamPolicy::GetTeam( int slot, const std::vector< int >& /*team_sizes*/ )
+{
+	// more players than teams, the rest don't have one
+	if( slot >= mTeamCount )
+		return TEAM_UNKNOWN;
+
+	return (types::uint8)( TEAM_1 + slot );
+}
+
+CRoundRobinTeamPolicy::CRoundRobinTeamPolicy( int team_count ) :
+	mTeamCount( team_count ),
+	mNext( 0 )
+{
+	cassert( team_count > 0 && team_count < TEAM_ALL );
+}
+
+types::uint8 CRoundRobinTeamPolicy::GetTeam( int /*slot*/, const std::vector< int >& /*team_sizes*/ )
+{
+	const types::uint8 result = (types::uint8)( TEAM_1 + mNext );
+	mNext = ( mNext + 1 ) % mTeamCount;
+	return result;
+}
+
+CBalancedTeamPolicy::CBalancedTeamPolicy( int team_count ) :
+	mTeamCount( team_count )
+{
+	cassert( team_count > 0 && team_count < TEAM_ALL );
+}
+
+types::uint8 CBalancedTeamPolicy::GetTeam( int /*slot*/, const std::vector< int >& team_sizes )
+{
+	int result = TEAM_1;
+	for( int team = TEAM_1 + 1; team < TEAM_1 + mTeamCount; ++team )
+	{
+		if( team_sizes[ team ] < team_sizes[ result ] )
+			result = team;
+	}
+	return (types::uint8)result;
+}
+
+//-----------------------------------------------------------------------------
+
+CServerManagement::CServerManagement() :
+	mTeamSizes( 256, 0 ),
+	mTeamPolicy( new CSlotTeamPolicy )
+{
+}
+
+CServerManagement::~CServerManagement()
+{
+	for( std::size_t i = 0; i < mPlayers.size(); ++i )
+		delete mPlayers[ i ];
+	mPlayers.clear();
+}
+
+void CServerManagement::SetTeamPolicy( ITeamPolicy* policy )
+{
+	cassert( policy );
+	mTeamPolicy.reset( policy );
+}
+
+void CServerManagement::Reserve( int player_count )
+{
+	mPlayers.reserve( player_count );
+	mConnected.reserve( player_count );
+	mConnectedSlots.reserve( player_count );
+	mConnectedIndex.reserve( player_count );
+	mFreeSlots.reserve( player_count );
+	mAddressToSlot.Reserve( player_count );
+}
+
+PlayerAddress* CServerManagement::NewConnection( const TransportAddress& address )
+{
+	std::cout << "ServerManager::NewConnection(): " << address.ToString() << std::endl;
+
+	int pos = -1;
+
+	if( mFreeSlots.empty() == false )
+	{
+		std::pop_heap( mFreeSlots.begin(), mFreeSlots.end(), std::greater< int >() );
+		pos = mFreeSlots.back();
+		mFreeSlots.pop_back();
+	}
+	else
+	{
+		pos = (int)mPlayers.size();
+		mPlayers.push_back( NULL );
+		mConnectedIndex.push_back( -1 );
+	}
+
+	cassert( mPlayers[ pos ] == NULL );
+
+	PlayerAddress* result = new PlayerAddress;
+	result->mAddress = address;
+	result->mTeam = mTeamPolicy->GetTeam( pos, mTeamSizes );
+	mPlayers[ pos ] = result;
+	mTeamSizes[ result->mTeam ]++;
+
+	mConnectedIndex[ pos ] = (int)mConnected.size();
+	mConnected.push_back( result );
+	mConnectedSlots.push_back( pos );
+
+	mAddressToSlot[ address ] = pos;
+
+	return result;
+}
+
+PlayerAddress* CServerManagement::FindPlayer( const TransportAddress& address ) const
+{
+	const int* slot = mAddressToSlot.FindValue( address );
+	if( slot == NULL )
+		return NULL;
+
+	return mPlayers[ *slot ];
+}
+
+PlayerAddress* CServerManagement::GetPlayerForAddress( const TransportAddress& address )
+{
+	PlayerAddress* result = FindPlayer( address );
+	if( result )
+		return result;
+
+	return NewConnection( address );
+}
+
+void CServerManagement::PlayerDroppedOut( const TransportAddress& address )
+{
+	const int* found = mAddressToSlot.FindValue( address );
+	if( found == NULL )
+		return;
+
+	const int slot = *found;
+	mAddressToSlot.Erase( address );
+
+	PlayerAddress* player = mPlayers[ slot ];
+	cassert( player );
+	mTeamSizes[ player->mTeam ]--;
+
+	// the last one takes its place in the connected ones
+	const int index = mConnectedIndex[ slot ];
+	const int last_slot = mConnectedSlots.back();
+	mConnected[ index ] = mConnected.back();
+	mConnectedSlots[ index ] = last_slot;
+	mConnectedIndex[ last_slot ] = index;
+	mConnected.pop_back();
+	mConnectedSlots.pop_back();
+	mConnectedIndex[ slot ] = -1;
+
+	delete player;
+	mPlayers[ slot ] = NULL;
+
+	mFreeSlots.push_back( slot );
+	std::push_heap( mFreeSlots.begin(), mFreeSlots.end(), std::greater< int >() );
+}
+
+int CServerManagement::GetPlayerCount() const
+{
+	return (int)mConnected.size();
+}
+
+int CServerManagement::GetTeamSize( types::uint8 team ) const
+{
+	return mTeamSizes[ team ];
+}
+
+//=============================================================================
+
+class CBufferedPacketHandler;
+
+class CPacketHandler : public IPacketHandler
+{
+public:
+
+	CPacketHandler( bool server, ITransport* transport, IGameMessageFactory* factory );
+	~CPacketHandler();
+
+	void*	GetUserData() { return mUserData; }
+	void	SetUserData( void* userdata ) { mUserData = userdata; }
+
+	virtual IPacketHandler* GetBufferedPacketHandler( Uint32 wait_for );
+
+	void HandleGamePackets( TransportPacket* packet )
+	{
+		CENG_ALLOCATION_TAG( ceng::ALLOCATION_TAG_NETWORK );
+
+		cassert( mMessageFactory.get() );
+		cassert( packet );
+
+		// connection events of the transports that don't have message ids
+		// for them
+		if( packet->mLength == 0 )
+			return;
+
+		cassert( packet->mData );
+
+		mStats.OnPacketReceived( packet->mAddress, packet->mLength );
+
+		mCurrentPacketAddress = mServerManager.GetPlayerForAddress( packet->mAddress );
+
+		if( packet->mData[ 0 ] != GAME_MESSAGE_BATCH_ID )
+		{
+			HandleMessage( packet->mData, packet->mLength, false );
+			return;
+		}
+
+		unsigned int position = 1;
+		while( position < packet->mLength )
+		{
+			const unsigned int used = HandleMessage( packet->mData + position, packet->mLength - position, true );
+			if( used == 0 )
+				break;
+
+			position += used;
+		}
+	}
+
+	// returns the number of bytes the message took, 0 if it was broken
+	unsigned int HandleMessage( const unsigned char* data, unsigned int length, bool in_batch )
+	{
+		// RakNet's own packets don't have the size
+		unsigned int size = 0;
+		if( length >= MESSAGE_HEADER_SIZE )
+		{
+			size = network_utils::ReadUint32( (const char*)data + 1 );
+
+			// std::cout << "Read size: " << size << std::endl;
+		}
+
+		// whatever the remote peer sends, it mustn't take us down
+		if( in_batch && ( length < MESSAGE_HEADER_SIZE || size > length - MESSAGE_HEADER_SIZE ) )
+		{
+			DropBrokenPacket( "broken message in a batch" );
+			return 0;
+		}
+
+		unsigned char uc_message_id = data[ 0 ];
+		int message_id = (int)uc_message_id;
+
+		mStats.OnMessageReceived( message_id, ( length >= MESSAGE_HEADER_SIZE ) ? MESSAGE_HEADER_SIZE + size : length );
+
+		IGameMessage* message = mMessageFactory->GetPooledMessage( message_id );
+		CReleaseMessage release_message( mMessageFactory.get(), message );
+
+		if( message )
+		{
+			if( message->IsSerialized() )
+			{
+				if( length < MESSAGE_HEADER_SIZE || size > length - MESSAGE_HEADER_SIZE )
+				{
+					DropBrokenPacket( "packet is shorter than its message" );
+					return 0;
+				}
+
+				// straight from the packet
+				network_utils::CSerialLoaderView loader( (const char*)data + MESSAGE_HEADER_SIZE, size );
+				if( mStats.ShouldTime() )
+				{
+					const double start = GetNetworkStatsTime();
+					message->BitSerialize( &loader );
+					mStats.OnDeserialized( (float)( GetNetworkStatsTime() - start ) );
+				}
+				else
+				{
+					message->BitSerialize( &loader );
+				}
+			}
+
+			// the game thread runs the handlers in the threaded mode
+			if( mThread )
+			{
+				mThread->ToGame( release_message.Take(), *mCurrentPacketAddress );
+				return MESSAGE_HEADER_SIZE + size;
+			}
+
+			if( mServer )
+				message->HandleServer( this );
+			else
+				message->HandleClient( this );
+		}
+
+		return MESSAGE_HEADER_SIZE + size;
+	}
+
+	// the rest of the packet is dropped. Only the first one is logged, so
+	// that a peer sending garbage can't flood the log
+	void DropBrokenPacket( const char* reason )
+	{
+		mStats.OnBrokenPacket();
+		if( mLoggedBrokenPacket )
+			return;
+
+		mLoggedBrokenPacket = true;
+		std::cout << "Dropped a broken packet, " << reason << ". The next ones aren't logged" << std::endl;
+	}
+
+	void SendGameMessage( IGameMessage* message )
+	{
+		cassert( message );
+
+		SendMessageImpl( message, UNASSIGNED_TRANSPORT_ADDRESS, true );
+
+		// take care of the message
+		delete message;
+		message = NULL;
+	}
+
+	// only to the one address
+	void SendGameMessageTo( IGameMessage* message, const TransportAddress& address )
+	{
+		cassert( message );
+
+		SendMessageImpl( message, address, false );
+
+		// take care of the message
+		delete message;
+		message = NULL;
+	}
+
+	virtual PlayerAddress* GetCurrentPacketAddress() { return mCurrentPacketAddress; }
+
+	void SendAllMessagesFromBuffer();
+
+	//.........................................................................
+
+	// the messages of one tick that go to the same place the same way
+	struct OutgoingQueue
+	{
+		OutgoingQueue() : broadcast( true ), delivery( TRANSPORT_RELIABLE ), channel( 0 ), priority( TRANSPORT_PRIORITY_HIGH ), count( 0 ), current_count( 0 ) { }
+
+		TransportAddress	address;
+		bool				broadcast;
+		TransportDelivery	delivery;
+		int					channel;
+		TransportPriority	priority;
+
+		// the full datagrams go to the list, the last one is still filling
+		std::vector< network_utils::types::ustring >	full;
+		std::vector< int >								full_counts;
+		network_utils::types::ustring					current;
+		int												count;
+		int												current_count;
+	};
+
+	// serializes the message and queues it, or sends it right away if it's
+	// important or the coalescing is off
+	// doesn't release the message or anything like that
+	void SendMessageImpl( IGameMessage* message, const TransportAddress& address, bool broadcast )
+	{
+		CENG_ALLOCATION_TAG( ceng::ALLOCATION_TAG_NETWORK );
+
+		cassert( message );
+		cassert( mTransport );
+
+		Serialize( message );
+		mStats.OnMessageSent( message->GetType(), (unsigned int)mSerializeBuffer.size() );
+
+		QueueSerialized( message, address, broadcast );
+	}
+
+	// the same bytes to every one of the players
+	void SendMessageToPlayers( IGameMessage* message, const std::vector< PlayerAddress* >& players )
+	{
+		CENG_ALLOCATION_TAG( ceng::ALLOCATION_TAG_NETWORK );
+
+		cassert( message );
+		cassert( mTransport );
+
+		Serialize( message );
+		mStats.OnMessageSent( message->GetType(), (unsigned int)mSerializeBuffer.size(), (unsigned int)players.size() );
+
+		for( std::size_t i = 0; i < players.size(); ++i )
+		{
+			cassert( players[ i ] );
+			QueueSerialized( message, players[ i ]->mAddress, false );
+		}
+	}
+
+	// to mSerializeBuffer, now and then timed
+	void Serialize( IGameMessage* message )
+	{
+		mSerializeBuffer.clear();
+
+		if( mStats.ShouldTime() )
+		{
+			const double start = GetNetworkStatsTime();
+			SerializeMessage( message, mSerializeBuffer );
+			mStats.OnSerialized( (float)( GetNetworkStatsTime() - start ) );
+		}
+		else
+		{
+			SerializeMessage( message, mSerializeBuffer );
+		}
+	}
+
+	// what's in mSerializeBuffer goes to the queue of the address
+	void QueueSerialized( IGameMessage* message, const TransportAddress& address, bool broadcast )
+	{
+		const TransportDelivery delivery = message->GetDelivery();
+		const int channel = message->GetChannel();
+		const TransportPriority priority = message->IsImportant() ? TRANSPORT_PRIORITY_IMMEDIATE : TRANSPORT_PRIORITY_HIGH;
+
+		if( mCoalesce == false )
+		{
+			SendDatagram( mSerializeBuffer, 1, address, broadcast, delivery, channel, priority );
+			return;
+		}
+
+		OutgoingQueue& queue = GetQueue( address, broadcast, delivery, channel );
+
+		if( queue.count > 0 && queue.current.size() + mSerializeBuffer.size() > mMaxDatagramSize )
+		{
+			queue.full.push_back( network_utils::types::ustring() );
+			queue.full.back().swap( queue.current );
+			queue.full_counts.push_back( queue.current_count );
+			queue.current_count = 0;
+		}
+
+		if( queue.current.empty() )
+			queue.current += (char)GAME_MESSAGE_BATCH_ID;
+
+		queue.current += mSerializeBuffer;
+		queue.count++;
+		queue.current_count++;
+
+		if( priority == TRANSPORT_PRIORITY_IMMEDIATE )
+		{
+			queue.priority = priority;
+			FlushQueue( queue );
+		}
+	}
+
+	OutgoingQueue& GetQueue( const TransportAddress& address, bool broadcast, TransportDelivery delivery, int channel )
+	{
+		const OutgoingKey key( address, broadcast, delivery, channel );
+		const int* index = mOutgoingIndex.FindValue( key );
+		if( index )
+			return mOutgoing[ *index ];
+
+		mOutgoingIndex.Insert( key, (int)mOutgoing.size() );
+		mOutgoing.push_back( OutgoingQueue() );
+		mOutgoing.back().address = address;
+		mOutgoing.back().broadcast = broadcast;
+		mOutgoing.back().delivery = delivery;
+		mOutgoing.back().channel = channel;
+		return mOutgoing.back();
+	}
+
+	void FlushQueue( OutgoingQueue& queue )
+	{
+		for( std::size_t i = 0; i < queue.full.size(); ++i )
+			SendDatagram( queue.full[ i ], queue.full_counts[ i ], queue.address, queue.broadcast, queue.delivery, queue.channel, queue.priority );
+
+		if( queue.count > 0 )
+			SendDatagram( queue.current, queue.current_count, queue.address, queue.broadcast, queue.delivery, queue.channel, queue.priority );
+
+		queue.full.clear();
+		queue.full_counts.clear();
+		queue.current.clear();
+		queue.count = 0;
+		queue.current_count = 0;
+		queue.priority = TRANSPORT_PRIORITY_HIGH;
+	}
+
+	void FlushMessages()
+	{
+		unsigned int queued = 0;
+		for( std::size_t i = 0; i < mOutgoing.size(); ++i )
+		{
+			queued += mOutgoing[ i ].count;
+			FlushQueue( mOutgoing[ i ] );
+		}
+
+		mStats.OnSendQueue( queued );
+	}
+
+	// the queues of someone who has left, what's still in them is dropped
+	void RemoveQueues( const TransportAddress& address )
+	{
+		for( std::size_t i = 0; i < mOutgoing.size(); )
+		{
+			if( mOutgoing[ i ].address != address || mOutgoing[ i ].broadcast )
+			{
+				++i;
+				continue;
+			}
+
+			const OutgoingQueue& queue = mOutgoing[ i ];
+			mOutgoingIndex.Erase( OutgoingKey( queue.address, queue.broadcast, queue.delivery, queue.channel ) );
+
+			if( i + 1 < mOutgoing.size() )
+			{
+				OutgoingQueue& last = mOutgoing.back();
+				mOutgoing[ i ] = last;
+				*mOutgoingIndex.FindValue( OutgoingKey( last.address, last.broadcast, last.delivery, last.channel ) ) = (int)i;
+			}
+			mOutgoing.pop_back();
+		}
+	}
+
+	void SendDatagram( const network_utils::types::ustring& data, int message_count, const TransportAddress& address, bool broadcast, TransportDelivery delivery, int channel, TransportPriority priority )
+	{
+		mTransport->Send( (const unsigned char*)data.data(), (unsigned int)data.size(), address, broadcast, delivery, channel, priority );
+
+		mStats.OnPacketSent( broadcast ? UNASSIGNED_TRANSPORT_ADDRESS : address, (unsigned int)data.size(), message_count );
+	}
+
+	//.........................................................................
+
+	bool									mServer;
+	std::auto_ptr< IGameMessageFactory >	mMessageFactory;
+	ITransport*								mTransport;
+	CServerManagement						mServerManager;
+	PlayerAddress*							mCurrentPacketAddress;
+	void*									mUserData;
+	CBufferedPacketHandler*					mBufferPacketHandler;
+	CNetworkStats							mStats;
+	bool									mLoggedBrokenPacket;
+	CNetworkThread*							mThread;
+
+	bool									mCoalesce;
+	unsigned int							mMaxDatagramSize;
+	std::vector< OutgoingQueue >			mOutgoing;
+	ceng::CFlatHashMap< OutgoingKey, int, OutgoingKeyHash >	mOutgoingIndex;
+	network_utils::types::ustring			mSerializeBuffer;
+};
+
+//-------------------------------------------------------------------------------------------------
+
+// Holds the messages until their time has come. SendGameMessage() can be
+// called from any thread, it just pushes the message to a lock free stack.
+// SendAllMessagesFromBuffer() is called from the network thread, it takes the
+// whole stack in one go, puts the messages to a timing wheel and sends the
+// ones that are due. The messages used to be in a list that was sorted on
+// every push, under a mutex. The stack nodes come from the thread safe size
+// class allocator, they're allocated on the sending thread and freed on the
+// network thread.
+class CBufferedPacketHandler : public IPacketHandler
+{
+public:
+	CBufferedPacketHandler() : mPending( NULL ), mWaitTime( 0 ), mParent( 0 ), mMessageWheel( SDL_GetTicks() ) { }
+
+	~CBufferedPacketHandler()
+	{
+		for( PendingMessage* pending = TakePending(); pending; )
+		{
+			PendingMessage* next = pending->next;
+			delete pending->message;
+			delete pending;
+			pending = next;
+		}
+
+		std::vector< IGameMessage* > messages;
+		mMessageWheel.Clear( messages );
+		for( std::size_t i = 0; i < messages.size(); ++i )
+			delete messages[ i ];
+	}
+
+	struct PendingMessage : public ceng::CMemoryPoolObject< PendingMessage, 50, true >
+	{
+		PendingMessage( IGameMessage* message, Uint32 t ) : message( message ), time_to_fire( t ), next( NULL ) { }
+
+		IGameMessage*	message;
+		Uint32			time_to_fire;
+		PendingMessage*	next;
+	};
+
+	virtual void* GetUserData() { return mParent->GetUserData(); }
+	virtual PlayerAddress* GetCurrentPacketAddress() { return mParent->GetCurrentPacketAddress(); }
+
+
+
+	void SetWaitTime( Uint32 t ) { mWaitTime = t; }
+
+	virtual void SendGameMessage( IGameMessage* message )
+	{
+		Uint32 t = SDL_GetTicks() + mWaitTime;
+
+		PendingMessage* pending = new PendingMessage( message, t );
+		void* head = mPending;
+		while( true )
+		{
+			pending->next = (PendingMessage*)head;
+			void* before = AtomicCompareExchange( &mPending, pending, head );
+			if( before == head )
+				break;
+			head = before;
+		}
+	}
+
+	void SendAllMessagesFromBuffer()
+	{
+		// the stack is newest first, the wheel wants them in the order they
+		// were sent so the ones with the same time keep their order
+		PendingMessage* pending = NULL;
+		for( PendingMessage* p = TakePending(); p; )
+		{
+			PendingMessage* next = p->next;
+			p->next = pending;
+			pending = p;
+			p = next;
+		}
+
+		while( pending )
+		{
+			PendingMessage* next = pending->next;
+			mMessageWheel.Add( pending->message, pending->time_to_fire );
+			delete pending;
+			pending = next;
+		}
+
+		// the ones that were due before this tick, like it has always been
+		mFiredMessages.clear();
+		mMessageWheel.Advance( SDL_GetTicks() - 1, mFiredMessages );
+
+		for( std::size_t i = 0; i < mFiredMessages.size(); ++i )
+		{
+			cassert( mFiredMessages[ i ] );
+			mParent->SendGameMessage( mFiredMessages[ i ] );
+		}
+	}
+
+	PendingMessage* TakePending()
+	{
+		void* head = mPending;
+		while( true )
+		{
+			void* before = AtomicCompareExchange( &mPending, NULL, head );
+			if( before == head )
+				return (PendingMessage*)head;
+			head = before;
+		}
+	}
+
+	void* volatile					mPending;
+	Uint32							mWaitTime;
+	CPacketHandler*					mParent;
+	CTimingWheel< IGameMessage* >	mMessageWheel;
+	std::vector< IGameMessage* >	mFiredMessages;
+};
+
+//-------------------------------------------------------------------------------------------------
+
+CPacketHandler::CPacketHandler( bool server, ITransport* transport, IGameMessageFactory* factory ) :
+	mServer( server ),
+	mMessageFactory( factory ),
+	mTransport( transport ),
+	mCurrentPacketAddress( NULL ),
+	mUserData( NULL ),
+	mBufferPacketHandler( new CBufferedPacketHandler  ),
+	mLoggedBrokenPacket( false ),
+	mThread( NULL ),
+	mCoalesce( true ),
+	mMaxDatagramSize( DEFAULT_MAX_DATAGRAM_SIZE )
+{
+	mBufferPacketHandler->mParent = this;
+}
+
+CPacketHandler::~CPacketHandler()
+{
+	delete mBufferPacketHandler;
+	mBufferPacketHandler = NULL;
+}
+
+IPacketHandler* CPacketHandler::GetBufferedPacketHandler( Uint32 wait_for )
+{
+	mBufferPacketHandler->SetWaitTime( wait_for );
+	return mBufferPacketHandler;
+}
+
+void CPacketHandler::SendAllMessagesFromBuffer() { mBufferPacketHandler->SendAllMessagesFromBuffer(); }
+
+namespace {
+
+	// what the game thread pushed to the network thread
+	void HandleFromGame( CPacketHandler* packet_handler, const CNetworkThread::GameMessage& from_game )
+	{
+		cassert( from_game.message );
+
+		if( from_game.handled )
+			packet_handler->mMessageFactory->ReleaseMessage( from_game.message );
+		else
+			packet_handler->SendGameMessage( from_game.message );
+	}
+
+}
+
+//=============================================================================
+
+CNetworkPeer::CNetworkPeer( bool server, ITransport* transport, IGameMessageFactory* factory ) :
+	mTransport( transport ),
+	mPacketHandler( new CPacketHandler( server, transport, factory ) ),
+	mPacketHandlerForGame( new CPacketHandlerForClient ),
+	mStatsMutex( SDL_CreateMutex() ),
+	mThread( NULL )
+{
+	cassert( mTransport );
+}
+
+CNetworkPeer::~CNetworkPeer()
+{
+	StopThread();
+
+	if( IPacketHandler::mInstanceForGame == mPacketHandlerForGame )
+		IPacketHandler::mInstanceForGame = NULL;
+
+	delete mPacketHandlerForGame;
+	mPacketHandlerForGame = NULL;
+
+	delete mPacketHandler;
+	mPacketHandler = NULL;
+
+	SDL_DestroyMutex( mStatsMutex );
+	mStatsMutex = NULL;
+}
+
+bool CNetworkPeer::IsServer() const
+{
+	return mPacketHandler->mServer;
+}
+
+void CNetworkPeer::SetUserData( void* userdata )
+{
+	mPacketHandler->SetUserData( userdata );
+	mPacketHandlerForGame->SetUserData( userdata );
+}
+
+IPacketHandler* CNetworkPeer::GetPacketHandlerForGame()
+{
+	return mPacketHandlerForGame;
+}
+
+IPacketHandler* CNetworkPeer::GetPacketHandler()
+{
+	return mPacketHandler;
+}
+
+IGameMessageFactory* CNetworkPeer::GetMessageFactory()
+{
+	return mPacketHandler->mMessageFactory.get();
+}
+
+CServerManagement& CNetworkPeer::GetServerManagement()
+{
+	return mPacketHandler->mServerManager;
+}
+
+const NetworkPeerStats& CNetworkPeer::GetStats() const
+{
+	return mPacketHandler->mStats.GetTotals();
+}
+
+CNetworkStats& CNetworkPeer::GetNetworkStats()
+{
+	return mPacketHandler->mStats;
+}
+
+void CNetworkPeer::CopyNetworkStats( CNetworkStats& stats ) const
+{
+	CMutexLock lock( mStatsMutex );
+	stats = mPublishedStats;
+}
+
+void CNetworkPeer::SendGameMessageTo( IGameMessage* message, const TransportAddress& address )
+{
+	mPacketHandler->SendGameMessageTo( message, address );
+}
+
+void CNetworkPeer::SendGameMessageToPlayers( IGameMessage* message, const std::vector< PlayerAddress* >& players )
+{
+	cassert( IsServer() );
+	mPacketHandler->SendMessageToPlayers( message, players );
+	delete message;
+}
+
+void CNetworkPeer::SendGameMessageToTeam( IGameMessage* message, types::uint8 team )
+{
+	cassert( IsServer() );
+
+	const std::vector< PlayerAddress* >& players = mPacketHandler->mServerManager.GetPlayers();
+	mTeamPlayers.clear();
+	for( std::size_t i = 0; i < players.size(); ++i )
+	{
+		if( players[ i ]->mTeam == team )
+			mTeamPlayers.push_back( players[ i ] );
+	}
+
+	SendGameMessageToPlayers( message, mTeamPlayers );
+}
+
+void CNetworkPeer::FlushMessages()
+{
+	mPacketHandler->FlushMessages();
+}
+
+void CNetworkPeer::SetCoalescing( bool coalesce )
+{
+	mPacketHandler->FlushMessages();
+	mPacketHandler->mCoalesce = coalesce;
+}
+
+void CNetworkPeer::SetMaxDatagramSize( unsigned int size )
+{
+	cassert( size > MESSAGE_HEADER_SIZE );
+	mPacketHandler->mMaxDatagramSize = size;
+}
+
+//-----------------------------------------------------------------------------
+
+void CNetworkPeer::Update()
+{
+	cassert( mThread == NULL && "The network thread does this" );
+
+	mTransport->Update();
+
+	mPacketHandlerForGame->SendAllMessagesFromBuffer( mPacketHandler );
+	mPacketHandler->SendAllMessagesFromBuffer();
+
+	ReceivePackets();
+
+	// everything this tick sent, including the answers
+	mPacketHandler->FlushMessages();
+
+	PublishStats();
+}
+
+void CNetworkPeer::ReceivePackets()
+{
+	for( TransportPacket* packet = mTransport->Receive(); packet; packet = mTransport->Receive() )
+	{
+		HandlePacket( packet );
+		mTransport->DeallocatePacket( packet );
+
+		// the game can't keep up, the rest stay in the transport for now
+		if( mThread && mThread->IsGameBehind() )
+			break;
+	}
+}
+
+void CNetworkPeer::PublishStats()
+{
+	// the other threads get a copy once a second
+	if( mPacketHandler->mStats.Update( SDL_GetTicks(), mTransport ) )
+	{
+		CMutexLock lock( mStatsMutex );
+		mPublishedStats = mPacketHandler->mStats;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+bool CNetworkPeer::StartThread( unsigned int queue_size )
+{
+	cassert( mThread == NULL );
+	if( mThread )
+		return false;
+
+	// what the game had buffered before goes out first
+	mPacketHandlerForGame->SendAllMessagesFromBuffer( mPacketHandler );
+
+	mThread = new CNetworkThread( queue_size );
+	mPacketHandler->mThread = mThread;
+	mPacketHandlerForGame->mThread = mThread;
+	mPacketHandlerForGame->mParent = mPacketHandler;
+
+	mThread->mThread = SDL_CreateThread( &CNetworkPeer::RunThread, this );
+	if( mThread->mThread == NULL )
+	{
+		StopThread();
+		return false;
+	}
+
+	return true;
+}
+
+void CNetworkPeer::StopThread()
+{
+	if( mThread == NULL )
+		return;
+
+	mThread->Stop();
+	if( mThread->mThread )
+		SDL_WaitThread( mThread->mThread, NULL );
+
+	// the network thread is gone, so the queues can be emptied from here
+	CNetworkThread::GameMessage from_game;
+	while( mThread->mToNetwork.Pop( from_game ) )
+		HandleFromGame( mPacketHandler, from_game );
+
+	for( std::size_t i = 0; i < mThread->mToNetworkWaiting.size(); ++i )
+		HandleFromGame( mPacketHandler, mThread->mToNetworkWaiting[ i ] );
+
+	CNetworkThread::ReceivedMessage received;
+	while( mThread->mToGame.Pop( received ) )
+		GetMessageFactory()->ReleaseMessage( received.message );
+
+	for( std::size_t i = 0; i < mThread->mToGameWaiting.size(); ++i )
+		GetMessageFactory()->ReleaseMessage( mThread->mToGameWaiting[ i ].message );
+
+	mPacketHandler->FlushMessages();
+
+	mPacketHandler->mThread = NULL;
+	mPacketHandlerForGame->mThread = NULL;
+	mPacketHandlerForGame->mParent = NULL;
+
+	delete mThread;
+	mThread = NULL;
+}
+
+bool CNetworkPeer::IsThreaded() const
+{
+	return mThread != NULL;
+}
+
+int CNetworkPeer::HandleMessages()
+{
+	cassert( mThread );
+	if( mThread == NULL )
+		return 0;
+
+	// what didn't fit in the queue the last time
+	mThread->PushWaitingToNetwork();
+
+	const bool server = IsServer();
+	int result = 0;
+
+	// only what's there now, the network thread keeps adding more
+	CNetworkThread::ReceivedMessage received;
+	for( unsigned int count = mThread->mToGame.GetSize(); count > 0 && mThread->mToGame.Pop( received ); --count )
+	{
+		cassert( received.message );
+
+		mPacketHandlerForGame->mCurrentPacketAddress = &received.player;
+		if( server )
+			received.message->HandleServer( mPacketHandlerForGame );
+		else
+			received.message->HandleClient( mPacketHandlerForGame );
+		mPacketHandlerForGame->mCurrentPacketAddress = NULL;
+
+		// the factory is the network thread's
+		mThread->ToNetwork( received.message, true );
+		++result;
+	}
+
+	return result;
+}
+
+NetworkThreadStats CNetworkPeer::GetThreadStats() const
+{
+	return mThread ? mThread->GetStats() : NetworkThreadStats();
+}
+
+int CNetworkPeer::RunThread( void* data )
+{
+	CNetworkPeer* peer = static_cast< CNetworkPeer* >( data );
+	cassert( peer && peer->mThread );
+
+	while( peer->mThread->IsRunning() )
+	{
+		peer->UpdateThread();
+
+		SDL_Delay( 1 );
+	}
+
+	return 0;
+}
+
+void CNetworkPeer::UpdateThread()
+{
+	mTransport->Update();
+
+	// what the game sent and the messages it's done with, only what's there
+	// now so the game can't keep the thread here
+	CNetworkThread::GameMessage from_game;
+	for( unsigned int count = mThread->mToNetwork.GetSize(); count > 0 && mThread->mToNetwork.Pop( from_game ); --count )
+		HandleFromGame( mPacketHandler, from_game );
+
+	mPacketHandler->SendAllMessagesFromBuffer();
+
+	// while the game is behind the packets wait in the transport
+	if( mThread->PushWaitingToGame() )
+		ReceivePackets();
+
+	mPacketHandler->FlushMessages();
+
+	PublishStats();
+	mThread->PublishStats();
+}
+
+void CNetworkPeer::HandlePacket( TransportPacket* packet )
+{
+	cassert( packet );
+
+	switch( packet->mEvent )
+	{
+	case TRANSPORT_CONNECTED:
+		std::cout << "A connection is incoming: " << packet->mAddress.ToString() << std::endl;
+		if( IsServer() )
+			mPacketHandler->mServerManager.GetPlayerForAddress( packet->mAddress );
+
+		mPacketHandler->HandleGamePackets( packet );
+		break;
+
+	case TRANSPORT_DISCONNECTED:
+		if( IsServer() )
+			std::cout << "A client has disconnected: " << packet->mAddress.ToString() << std::endl;
+		else
+			std::cout << "Connection lost." << std::endl;
+
+		// the game gets to see the disconnection before the player is gone
+		mPacketHandler->HandleGamePackets( packet );
+
+		if( IsServer() )
+		{
+			mPacketHandler->mServerManager.PlayerDroppedOut( packet->mAddress );
+			mPacketHandler->RemoveQueues( packet->mAddress );
+		}
+		break;
+
+	case TRANSPORT_DATA:
+	default:
+		mPacketHandler->HandleGamePackets( packet );
+		break;
+	}
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,296 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#ifndef INC_NETWORK_PEER_H
+#define INC_NETWORK_PEER_H
+
+#include <memory>
+#include <vector>
+
+#include "../../utils/maphelper/cflathashmap.h"
+#include "ipackethandler.h"
+#include "itransport.h"
+#include "network_stats.h"
+
+class IGameMessageFactory;
+class CPacketHandler;
+class CPacketHandlerForClient;
+class CNetworkThread;
+struct SDL_mutex;
+
+//-----------------------------------------------------------------------------
+
+// Picks the team for a player that joins the server. The default one is how
+// it has always been, the first four slots are TEAM_1 - TEAM_4 and the rest
+// of the players don't get a team.
+//-----------------------------------------------------------------------------
+
+class ITeamPolicy
+{
+public:
+	virtual ~ITeamPolicy() { }
+
+	// team_sizes has the number of players in each team, by the team
+	virtual types::uint8 GetTeam( int slot, const std::vector< int >& team_sizes ) = 0;
+};
+
+// slot 0 is TEAM_1 and so on, after the last team it's TEAM_UNKNOWN
+class CSlotTeamPolicy : public ITeamPolicy
+{
+public:
+	explicit CSlotTeamPolicy( int team_count = 4 );
+	types::uint8 GetTeam( int slot, const std::vector< int >& team_sizes );
+
+private:
+	int mTeamCount;
+};
+
+// TEAM_1, TEAM_2 ... and then around again
+class CRoundRobinTeamPolicy : public ITeamPolicy
+{
+public:
+	explicit CRoundRobinTeamPolicy( int team_count );
+	types::uint8 GetTeam( int slot, const std::vector< int >& team_sizes );
+
+private:
+	int mTeamCount;
+	int mNext;
+};
+
+// to the team with the fewest players, the first one of those on a tie
+class CBalancedTeamPolicy : public ITeamPolicy
+{
+public:
+	explicit CBalancedTeamPolicy( int team_count );
+	types::uint8 GetTeam( int slot, const std::vector< int >& team_sizes );
+
+private:
+	int mTeamCount;
+};
+
+//-----------------------------------------------------------------------------
+
+struct TransportAddressHash
+{
+	unsigned int operator()( const TransportAddress& address ) const
+	{
+		return ceng::impl::HashInteger( address.mHost ^ ceng::impl::HashInteger( address.mPort ) );
+	}
+};
+
+//-----------------------------------------------------------------------------
+// The players of the server. Finding a player by address is a hash lookup,
+// the players keep their slot for as long as they're connected and the
+// lowest free slot goes to the next one who joins.
+//-----------------------------------------------------------------------------
+
+class CServerManagement
+{
+public:
+	CServerManagement();
+	~CServerManagement();
+
+	PlayerAddress*	NewConnection( const TransportAddress& address );
+	PlayerAddress*	GetPlayerForAddress( const TransportAddress& address );
+	void			PlayerDroppedOut( const TransportAddress& address );
+
+	// NULL if there's no player with the address, doesn't add one
+	PlayerAddress*	FindPlayer( const TransportAddress& address ) const;
+
+	int				GetPlayerCount() const;
+	int				GetTeamSize( types::uint8 team ) const;
+
+	// the connected players without the empty slots, in no particular order
+	const std::vector< PlayerAddress* >& GetPlayers() const { return mConnected; }
+
+	// takes the ownership, the players that are already in keep their teams
+	void			SetTeamPolicy( ITeamPolicy* policy );
+
+	// makes room for that many players up front
+	void			Reserve( int player_count );
+
+	// by slot, the empty slots are NULL
+	std::vector< PlayerAddress* > mPlayers;
+
+private:
+	typedef ceng::CFlatHashMap< TransportAddress, int, TransportAddressHash > AddressToSlot;
+
+	AddressToSlot					mAddressToSlot;
+	std::vector< PlayerAddress* >	mConnected;
+	std::vector< int >				mConnectedSlots;
+	std::vector< int >				mConnectedIndex;
+	std::vector< int >				mFreeSlots;
+	std::vector< int >				mTeamSizes;
+	std::auto_ptr< ITeamPolicy >	mTeamPolicy;
+
+	// can't be copied
+	CServerManagement( const CServerManagement& );
+	CServerManagement& operator=( const CServerManagement& );
+};
+
+//-----------------------------------------------------------------------------
+// How the queues between the network thread and the game thread are doing.
+// The network thread's counters are as they were after its last round.
+
+struct NetworkThreadStats
+{
+	NetworkThreadStats() :
+		updates( 0 ),
+		to_game( 0 ),
+		to_game_waits( 0 ),
+		max_to_game( 0 ),
+		to_network( 0 ),
+		to_network_waits( 0 ),
+		max_to_network( 0 )
+	{
+	}
+
+	// rounds of the network thread
+	unsigned int updates;
+
+	// The messages that went through the queue and the ones that found it
+	// full and had to wait on the side, and the most that were in the queue
+	// at once. While messages wait for the game the network thread doesn't
+	// receive more.
+	unsigned int to_game;
+	unsigned int to_game_waits;
+	unsigned int max_to_game;
+
+	// what the game sent and the messages it had handled, on their way back
+	// to the factory
+	unsigned int to_network;
+	unsigned int to_network_waits;
+	unsigned int max_to_network;
+};
+
+//-----------------------------------------------------------------------------
+// One end of the game protocol, the server or a client, on top of a
+// transport. RunServer() runs one of these in a thread over RakNet. The tests
+// and benchmarks run a server and N clients in one process over a
+// CLoopbackNetwork, calling Update() on each of them in turn.
+//
+// The messages sent during a tick are queued per destination, delivery and
+// channel, and at the end of Update() each queue goes out packed into as few
+// datagrams as fit in the max datagram size. Important messages flush their
+// queue right away.
+//
+// In the threaded mode the peer has a thread of its own that receives,
+// decodes the messages and sends the batches, and the game thread runs the
+// handlers with HandleMessages(). A long frame then doesn't hold up the
+// network, and a slow network doesn't make the frame longer.
+//-----------------------------------------------------------------------------
+
+class CNetworkPeer
+{
+public:
+	// takes the ownership of the factory but not of the transport
+	CNetworkPeer( bool server, ITransport* transport, IGameMessageFactory* factory );
+	~CNetworkPeer();
+
+	bool			IsServer() const;
+	ITransport*		GetTransport() { return mTransport; }
+
+	void			SetUserData( void* userdata );
+
+	// For the game's thread. The messages are buffered and sent on the next
+	// Update(), this is what IPacketHandler::mInstanceForGame points to.
+	IPacketHandler*	GetPacketHandlerForGame();
+
+	// the one the messages are handled with, only for the network thread
+	IPacketHandler*	GetPacketHandler();
+
+	// sends the buffered messages and handles everything that was received
+	void			Update();
+
+	// Starts the network thread, from then on it does what Update() does
+	// except for running the handlers. The game thread and the network
+	// thread talk through two lock free queues of queue_size messages, so
+	// only the one game thread may call HandleMessages() and send with
+	// GetPacketHandlerForGame(). The rest of the methods belong to the
+	// network thread until StopThread().
+	bool			StartThread( unsigned int queue_size = 4096 );
+
+	// waits for the thread, sends what the game had sent and drops what it
+	// didn't handle yet
+	void			StopThread();
+	bool			IsThreaded() const;
+
+	// For the game thread. Runs the handlers of the messages the network
+	// thread has decoded, the handlers get GetPacketHandlerForGame().
+	// Returns the number of messages handled.
+	int				HandleMessages();
+
+	// for the game thread
+	NetworkThreadStats			GetThreadStats() const;
+
+	// to one peer only, for the network thread like GetPacketHandler()
+	void			SendGameMessageTo( IGameMessage* message, const TransportAddress& address );
+
+	// The message is serialized once and queued for each of the players,
+	// instead of serializing it again for every SendGameMessageTo(). Only
+	// for the server, from the network thread.
+	void			SendGameMessageToPlayers( IGameMessage* message, const std::vector< PlayerAddress* >& players );
+	void			SendGameMessageToTeam( IGameMessage* message, types::uint8 team );
+
+	// sends the queued messages now instead of at the end of Update()
+	void			FlushMessages();
+
+	// With coalescing off every message is a datagram of its own, which is
+	// how it used to be. The datagram size doesn't include the transport's
+	// headers, a message bigger than it is sent alone.
+	void			SetCoalescing( bool coalesce );
+	void			SetMaxDatagramSize( unsigned int size );
+
+	IGameMessageFactory*		GetMessageFactory();
+	CServerManagement&			GetServerManagement();
+	const NetworkPeerStats&		GetStats() const;
+
+	// Everything the peer has counted. CopyNetworkStats() can be called from
+	// any thread, it gives the stats as they were at the last full second.
+	CNetworkStats&				GetNetworkStats();
+	void						CopyNetworkStats( CNetworkStats& stats ) const;
+
+private:
+	void HandlePacket( TransportPacket* packet );
+	void ReceivePackets();
+	void PublishStats();
+
+	static int	RunThread( void* data );
+	void		UpdateThread();
+
+	ITransport*					mTransport;
+	CPacketHandler*				mPacketHandler;
+	CPacketHandlerForClient*	mPacketHandlerForGame;
+	std::vector< PlayerAddress* >	mTeamPlayers;
+	SDL_mutex*					mStatsMutex;
+	CNetworkStats				mPublishedStats;
+	CNetworkThread*				mThread;
+
+	// can't be copied
+	CNetworkPeer( const CNetworkPeer& );
+	CNetworkPeer& operator=( const CNetworkPeer& );
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,520 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include "network_stats.h"
+
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#ifdef _WIN32
+#	include <windows.h>
+#else
+#	include <sys/time.h>
+#endif
+
+#include "../../utils/debug.h"
+
+namespace {
+
+	const unsigned int SAMPLE_INTERVAL = 1000;
+
+	const char* const COUNTER_NAMES[] = {
+		"messages_sent", "bytes_sent", "packets_sent",
+		"messages_received", "bytes_received", "packets_received" };
+
+	void GetCounters( const NetworkPeerStats& stats, unsigned int values[ 6 ] )
+	{
+		values[ 0 ] = stats.messages_sent;
+		values[ 1 ] = stats.bytes_sent;
+		values[ 2 ] = stats.packets_sent;
+		values[ 3 ] = stats.messages_received;
+		values[ 4 ] = stats.bytes_received;
+		values[ 5 ] = stats.packets_received;
+	}
+
+	bool IsEmpty( const NetworkPeerStats& stats )
+	{
+		return stats.messages_sent == 0 && stats.packets_sent == 0 &&
+			stats.messages_received == 0 && stats.packets_received == 0;
+	}
+
+	std::string GetAddressName( const TransportAddress& address )
+	{
+		return address.IsUnassigned() ? "broadcast" : address.ToString();
+	}
+
+	//.........................................................................
+
+	void WriteCountersCSV( std::ostream& stream, const char* kind, const std::string& name, const NetworkPeerStats& stats )
+	{
+		unsigned int values[ 6 ];
+		GetCounters( stats, values );
+
+		stream << kind << "," << name;
+		for( int i = 0; i < 6; ++i )
+			stream << "," << values[ i ];
+		stream << "\n";
+	}
+
+	void WriteWindowCSV( std::ostream& stream, const std::string& name, const CRollingWindow& window )
+	{
+		stream << name << "," << window.GetCount()
+			<< "," << window.GetAverage()
+			<< "," << window.GetMin()
+			<< "," << window.GetPercentile( 50 )
+			<< "," << window.GetPercentile( 90 )
+			<< "," << window.GetPercentile( 99 )
+			<< "," << window.GetMax() << "\n";
+	}
+
+	void WriteCountersJSON( std::ostream& stream, const NetworkPeerStats& stats )
+	{
+		unsigned int values[ 6 ];
+		GetCounters( stats, values );
+
+		for( int i = 0; i < 6; ++i )
+			stream << ( i ? ", " : "" ) << "\"" << COUNTER_NAMES[ i ] << "\": " << values[ i ];
+	}
+
+	void WriteWindowJSON( std::ostream& stream, const char* name, const CRollingWindow& window )
+	{
+		stream << "\"" << name << "\": { \"count\": " << window.GetCount()
+			<< ", \"average\": " << window.GetAverage()
+			<< ", \"min\": " << window.GetMin()
+			<< ", \"p50\": " << window.GetPercentile( 50 )
+			<< ", \"p90\": " << window.GetPercentile( 90 )
+			<< ", \"p99\": " << window.GetPercentile( 99 )
+			<< ", \"max\": " << window.GetMax() << " }";
+	}
+
+}
+
+//=============================================================================
+
+void NetworkPeerStats::Add( const NetworkPeerStats& other )
+{
+	messages_sent += other.messages_sent;
+	packets_sent += other.packets_sent;
+	bytes_sent += other.bytes_sent;
+	messages_received += other.messages_received;
+	packets_received += other.packets_received;
+	bytes_received += other.bytes_received;
+	broken_packets += other.broken_packets;
+}
+
+//=============================================================================
+
+CRollingWindow::CRollingWindow( int size ) :
+	mSamples( size > 0 ? size : 1, 0.f ),
+	mNext( 0 ),
+	mCount( 0 )
+{
+}
+
+void CRollingWindow::Add( float value )
+{
+	mSamples[ mNext ] = value;
+	mNext = ( mNext + 1 ) % (int)mSamples.size();
+	if( mCount < (int)mSamples.size() )
+		++mCount;
+}
+
+void CRollingWindow::Clear()
+{
+	mNext = 0;
+	mCount = 0;
+}
+
+float CRollingWindow::GetLast() const
+{
+	if( mCount == 0 )
+		return 0;
+
+	return mSamples[ ( mNext + mSamples.size() - 1 ) % mSamples.size() ];
+}
+
+float CRollingWindow::GetAverage() const
+{
+	if( mCount == 0 )
+		return 0;
+
+	double sum = 0;
+	for( int i = 0; i < mCount; ++i )
+		sum += mSamples[ i ];
+	return (float)( sum / mCount );
+}
+
+float CRollingWindow::GetMin() const
+{
+	if( mCount == 0 )
+		return 0;
+
+	return *std::min_element( mSamples.begin(), mSamples.begin() + mCount );
+}
+
+float CRollingWindow::GetMax() const
+{
+	if( mCount == 0 )
+		return 0;
+
+	return *std::max_element( mSamples.begin(), mSamples.begin() + mCount );
+}
+
+float CRollingWindow::GetPercentile( float percentile ) const
+{
+	if( mCount == 0 )
+		return 0;
+
+	// the samples that are in use are always the first mCount
+	mSorted.assign( mSamples.begin(), mSamples.begin() + mCount );
+
+	int rank = (int)( percentile / 100.f * mCount + 0.999f ) - 1;
+	rank = std::max( 0, std::min( rank, mCount - 1 ) );
+
+	std::nth_element( mSorted.begin(), mSorted.begin() + rank, mSorted.end() );
+	return mSorted[ rank ];
+}
+
+//=============================================================================
+
+CNetworkStats::CNetworkStats() :
+	mEnabled( true ),
+	mTimingInterval( 16 ),
+	mTimingCounter( 0 ),
+	mLastConnection( -1 ),
+	mReceiveConnection( -1 ),
+	mSerializeTime( 256 ),
+	mDeserializeTime( 256 ),
+	mSendQueue( 256 ),
+	mBytesSentPerSecond( 60 ),
+	mBytesReceivedPerSecond( 60 ),
+	mSampled( false ),
+	mLastSampleTime( 0 )
+{
+}
+
+void CNetworkStats::SetTimingInterval( unsigned int interval )
+{
+	mTimingInterval = std::max( interval, 1u );
+	mTimingCounter = 0;
+}
+
+void CNetworkStats::Clear()
+{
+	mTotals = NetworkPeerStats();
+	for( int i = 0; i < MESSAGE_TYPE_COUNT; ++i )
+		mMessageTypes[ i ] = NetworkPeerStats();
+
+	mConnections.clear();
+	mConnectionIndex.clear();
+	mLastConnection = -1;
+	mReceiveConnection = -1;
+
+	mSerializeTime.Clear();
+	mDeserializeTime.Clear();
+	mSendQueue.Clear();
+	mBytesSentPerSecond.Clear();
+	mBytesReceivedPerSecond.Clear();
+
+	mSampled = false;
+	mLastSampleTotals = NetworkPeerStats();
+}
+
+//-----------------------------------------------------------------------------
+
+void CNetworkStats::OnMessageSent( int type, unsigned int bytes, unsigned int copies )
+{
+	if( mEnabled == false )
+		return;
+
+	cassert( type >= 0 && type < MESSAGE_TYPE_COUNT );
+	NetworkPeerStats& stats = mMessageTypes[ type & ( MESSAGE_TYPE_COUNT - 1 ) ];
+	stats.messages_sent += copies;
+	stats.bytes_sent += bytes * copies;
+	mTotals.messages_sent += copies;
+}
+
+void CNetworkStats::OnMessageReceived( int type, unsigned int bytes )
+{
+	if( mEnabled == false )
+		return;
+
+	cassert( type >= 0 && type < MESSAGE_TYPE_COUNT );
+	NetworkPeerStats& stats = mMessageTypes[ type & ( MESSAGE_TYPE_COUNT - 1 ) ];
+	stats.messages_received++;
+	stats.bytes_received += bytes;
+	mTotals.messages_received++;
+
+	// the packet that came last is the one the message is from
+	if( mReceiveConnection >= 0 )
+		mConnections[ mReceiveConnection ].counters.messages_received++;
+}
+
+void CNetworkStats::OnPacketSent( const TransportAddress& address, unsigned int bytes, unsigned int messages )
+{
+	if( mEnabled == false )
+		return;
+
+	mTotals.packets_sent++;
+	mTotals.bytes_sent += bytes;
+
+	NetworkPeerStats& stats = GetConnectionFor( address ).counters;
+	stats.packets_sent++;
+	stats.bytes_sent += bytes;
+	stats.messages_sent += messages;
+}
+
+void CNetworkStats::OnPacketReceived( const TransportAddress& address, unsigned int bytes )
+{
+	if( mEnabled == false )
+		return;
+
+	mTotals.packets_received++;
+	mTotals.bytes_received += bytes;
+
+	NetworkPeerStats& stats = GetConnectionFor( address ).counters;
+	stats.packets_received++;
+	stats.bytes_received += bytes;
+	mReceiveConnection = mLastConnection;
+}
+
+void CNetworkStats::OnBrokenPacket()
+{
+	if( mEnabled == false )
+		return;
+
+	mTotals.broken_packets++;
+	if( mReceiveConnection >= 0 )
+		mConnections[ mReceiveConnection ].counters.broken_packets++;
+}
+
+bool CNetworkStats::ShouldTime()
+{
+	if( mEnabled == false )
+		return false;
+
+	if( ++mTimingCounter < mTimingInterval )
+		return false;
+
+	mTimingCounter = 0;
+	return true;
+}
+
+bool CNetworkStats::Update( unsigned int time_ms, const ITransport* transport )
+{
+	if( mEnabled == false )
+		return false;
+
+	if( mSampled == false )
+	{
+		mSampled = true;
+		mLastSampleTime = time_ms;
+		mLastSampleTotals = mTotals;
+		return false;
+	}
+
+	const unsigned int elapsed = time_ms - mLastSampleTime;
+	if( elapsed < SAMPLE_INTERVAL )
+		return false;
+
+	const float seconds = elapsed / 1000.f;
+	mBytesSentPerSecond.Add( ( mTotals.bytes_sent - mLastSampleTotals.bytes_sent ) / seconds );
+	mBytesReceivedPerSecond.Add( ( mTotals.bytes_received - mLastSampleTotals.bytes_received ) / seconds );
+	mLastSampleTime = time_ms;
+	mLastSampleTotals = mTotals;
+
+	if( transport == NULL )
+		return true;
+
+	for( std::size_t i = 0; i < mConnections.size(); ++i )
+	{
+		NetworkConnectionStats& connection = mConnections[ i ];
+		TransportConnectionStats stats;
+		if( connection.address.IsUnassigned() || transport->GetConnectionStats( connection.address, stats ) == false )
+			continue;
+
+		if( stats.rtt >= 0 )
+			connection.rtt.Add( stats.rtt );
+		if( stats.loss >= 0 )
+			connection.loss.Add( stats.loss );
+		if( stats.send_queue >= 0 )
+			connection.send_queue.Add( (float)stats.send_queue );
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+const NetworkPeerStats& CNetworkStats::GetMessageTypeStats( int type ) const
+{
+	cassert( type >= 0 && type < MESSAGE_TYPE_COUNT );
+	return mMessageTypes[ type & ( MESSAGE_TYPE_COUNT - 1 ) ];
+}
+
+const NetworkConnectionStats* CNetworkStats::GetConnectionStats( const TransportAddress& address ) const
+{
+	std::map< TransportAddress, int >::const_iterator i = mConnectionIndex.find( address );
+	return ( i == mConnectionIndex.end() ) ? NULL : &mConnections[ i->second ];
+}
+
+NetworkConnectionStats& CNetworkStats::GetConnectionFor( const TransportAddress& address )
+{
+	// usually it's the same one as the last time
+	if( mLastConnection >= 0 && mConnections[ mLastConnection ].address == address )
+		return mConnections[ mLastConnection ];
+
+	std::map< TransportAddress, int >::iterator i = mConnectionIndex.find( address );
+	if( i != mConnectionIndex.end() )
+	{
+		mLastConnection = i->second;
+	}
+	else
+	{
+		mLastConnection = (int)mConnections.size();
+		mConnectionIndex[ address ] = mLastConnection;
+		mConnections.push_back( NetworkConnectionStats() );
+		mConnections.back().address = address;
+	}
+
+	return mConnections[ mLastConnection ];
+}
+
+//-----------------------------------------------------------------------------
+
+void CNetworkStats::Export( std::ostream& stream, NetworkStatsFormat format ) const
+{
+	if( format == NETWORK_STATS_JSON )
+		ExportJSON( stream );
+	else
+		ExportCSV( stream );
+}
+
+void CNetworkStats::ExportCSV( std::ostream& stream ) const
+{
+	stream << "kind,name";
+	for( int i = 0; i < 6; ++i )
+		stream << "," << COUNTER_NAMES[ i ];
+	stream << "\n";
+
+	WriteCountersCSV( stream, "total", "", mTotals );
+
+	for( int i = 0; i < MESSAGE_TYPE_COUNT; ++i )
+	{
+		if( IsEmpty( mMessageTypes[ i ] ) == false )
+		{
+			std::ostringstream name;
+			name << i;
+			WriteCountersCSV( stream, "message_type", name.str(), mMessageTypes[ i ] );
+		}
+	}
+
+	for( std::size_t i = 0; i < mConnections.size(); ++i )
+		WriteCountersCSV( stream, "connection", GetAddressName( mConnections[ i ].address ), mConnections[ i ].counters );
+
+	stream << "\nwindow,count,average,min,p50,p90,p99,max\n";
+	WriteWindowCSV( stream, "serialize_us", mSerializeTime );
+	WriteWindowCSV( stream, "deserialize_us", mDeserializeTime );
+	WriteWindowCSV( stream, "send_queue", mSendQueue );
+	WriteWindowCSV( stream, "bytes_sent_per_second", mBytesSentPerSecond );
+	WriteWindowCSV( stream, "bytes_received_per_second", mBytesReceivedPerSecond );
+
+	for( std::size_t i = 0; i < mConnections.size(); ++i )
+	{
+		const NetworkConnectionStats& connection = mConnections[ i ];
+		if( connection.rtt.IsEmpty() && connection.loss.IsEmpty() && connection.send_queue.IsEmpty() )
+			continue;
+
+		const std::string name = GetAddressName( connection.address );
+		WriteWindowCSV( stream, "rtt_ms " + name, connection.rtt );
+		WriteWindowCSV( stream, "loss_percent " + name, connection.loss );
+		WriteWindowCSV( stream, "send_queue " + name, connection.send_queue );
+	}
+}
+
+void CNetworkStats::ExportJSON( std::ostream& stream ) const
+{
+	stream << "{\n\t\"totals\": { ";
+	WriteCountersJSON( stream, mTotals );
+	stream << " },\n\t\"message_types\": [";
+
+	bool first = true;
+	for( int i = 0; i < MESSAGE_TYPE_COUNT; ++i )
+	{
+		if( IsEmpty( mMessageTypes[ i ] ) )
+			continue;
+
+		stream << ( first ? "\n" : ",\n" ) << "\t\t{ \"type\": " << i << ", ";
+		WriteCountersJSON( stream, mMessageTypes[ i ] );
+		stream << " }";
+		first = false;
+	}
+
+	stream << "\n\t],\n\t\"connections\": [";
+	for( std::size_t i = 0; i < mConnections.size(); ++i )
+	{
+		const NetworkConnectionStats& connection = mConnections[ i ];
+		stream << ( i ? ",\n" : "\n" ) << "\t\t{ \"address\": \"" << GetAddressName( connection.address ) << "\", ";
+		WriteCountersJSON( stream, connection.counters );
+		stream << ",\n\t\t\t";
+		WriteWindowJSON( stream, "rtt_ms", connection.rtt );
+		stream << ",\n\t\t\t";
+		WriteWindowJSON( stream, "loss_percent", connection.loss );
+		stream << ",\n\t\t\t";
+		WriteWindowJSON( stream, "send_queue", connection.send_queue );
+		stream << " }";
+	}
+
+	stream << "\n\t],\n\t";
+	WriteWindowJSON( stream, "serialize_us", mSerializeTime );
+	stream << ",\n\t";
+	WriteWindowJSON( stream, "deserialize_us", mDeserializeTime );
+	stream << ",\n\t";
+	WriteWindowJSON( stream, "send_queue", mSendQueue );
+	stream << ",\n\t";
+	WriteWindowJSON( stream, "bytes_sent_per_second", mBytesSentPerSecond );
+	stream << ",\n\t";
+	WriteWindowJSON( stream, "bytes_received_per_second", mBytesReceivedPerSecond );
+	stream << "\n}\n";
+}
+
+//=============================================================================
+
+double GetNetworkStatsTime()
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency( &frequency );
+	QueryPerformanceCounter( &counter );
+	return (double)counter.QuadPart * 1000000.0 / (double)frequency.QuadPart;
+#else
+	timeval time;
+	gettimeofday( &time, NULL );
+	return (double)time.tv_sec * 1000000.0 + (double)time.tv_usec;
+#endif
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,224 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#ifndef INC_NETWORK_STATS_H
+#define INC_NETWORK_STATS_H
+
+#include <iosfwd>
+#include <map>
+#include <vector>
+
+#include "itransport.h"
+
+//-----------------------------------------------------------------------------
+// What the network has been up to. CNetworkPeer keeps one of these and
+// counts everything that goes through it, in total, per message type and per
+// connection. The broadcasts are counted to UNASSIGNED_TRANSPORT_ADDRESS,
+// the connections only get what was sent to them alone. The connections
+// keep their counters after they've gone.
+//
+// The rest are rolling windows of the last samples: the round trip time,
+// the loss and the send queue of every connection as the transport sees
+// them, how long the messages took to serialize and deserialize, how many
+// messages were queued at the end of the tick and the bytes per second both
+// ways. The connections and the bytes per second are sampled once a second.
+//
+// Counting is a few additions, only one message in GetTimingInterval() is
+// timed, so it can be left on in release builds. Not thread safe, the peer
+// hands out copies to the other threads.
+//-----------------------------------------------------------------------------
+
+struct NetworkPeerStats
+{
+	NetworkPeerStats() :
+		messages_sent( 0 ),
+		packets_sent( 0 ),
+		bytes_sent( 0 ),
+		messages_received( 0 ),
+		packets_received( 0 ),
+		bytes_received( 0 ),
+		broken_packets( 0 )
+	{
+	}
+
+	void Add( const NetworkPeerStats& other );
+
+	// the bytes are what's given to and what comes from the transport
+	unsigned int messages_sent;
+	unsigned int packets_sent;
+	unsigned int bytes_sent;
+	unsigned int messages_received;
+	unsigned int packets_received;
+	unsigned int bytes_received;
+	// received packets that didn't parse, what was left of them was dropped
+	unsigned int broken_packets;
+};
+
+//-----------------------------------------------------------------------------
+// the last GetSize() samples, the percentiles are worked out when asked
+
+class CRollingWindow
+{
+public:
+	explicit CRollingWindow( int size = 128 );
+
+	void	Add( float value );
+	void	Clear();
+
+	int		GetSize() const { return (int)mSamples.size(); }
+	int		GetCount() const { return mCount; }
+	bool	IsEmpty() const { return mCount == 0; }
+
+	// 0 if there's nothing yet
+	float	GetLast() const;
+	float	GetAverage() const;
+	float	GetMin() const;
+	float	GetMax() const;
+
+	// percentile between 0 and 100, nearest rank
+	float	GetPercentile( float percentile ) const;
+
+private:
+	std::vector< float >			mSamples;
+	int								mNext;
+	int								mCount;
+	mutable std::vector< float >	mSorted;
+};
+
+//-----------------------------------------------------------------------------
+
+struct NetworkConnectionStats
+{
+	NetworkConnectionStats() : rtt( 60 ), loss( 60 ), send_queue( 60 ) { }
+
+	TransportAddress	address;
+	NetworkPeerStats	counters;
+
+	// milliseconds, percents and messages, once a second
+	CRollingWindow		rtt;
+	CRollingWindow		loss;
+	CRollingWindow		send_queue;
+};
+
+enum NetworkStatsFormat
+{
+	NETWORK_STATS_CSV = 0,
+	NETWORK_STATS_JSON
+};
+
+//-----------------------------------------------------------------------------
+
+class CNetworkStats
+{
+public:
+	enum { MESSAGE_TYPE_COUNT = 256 };
+
+	CNetworkStats();
+
+	void	SetEnabled( bool enabled ) { mEnabled = enabled; }
+	bool	IsEnabled() const { return mEnabled; }
+
+	// every n:th message is timed, 1 times them all
+	void	SetTimingInterval( unsigned int interval );
+	unsigned int GetTimingInterval() const { return mTimingInterval; }
+
+	void	Clear();
+
+	//.........................................................................
+	// what the peer calls, the bytes of a message include its header
+
+	void	OnMessageSent( int type, unsigned int bytes, unsigned int copies = 1 );
+	void	OnMessageReceived( int type, unsigned int bytes );
+	void	OnPacketSent( const TransportAddress& address, unsigned int bytes, unsigned int messages );
+	void	OnPacketReceived( const TransportAddress& address, unsigned int bytes );
+	// for the packet that was received last
+	void	OnBrokenPacket();
+
+	// true if the next one should be timed, the time is in microseconds
+	bool	ShouldTime();
+	void	OnSerialized( float microseconds ) { mSerializeTime.Add( microseconds ); }
+	void	OnDeserialized( float microseconds ) { mDeserializeTime.Add( microseconds ); }
+
+	void	OnSendQueue( unsigned int messages ) { mSendQueue.Add( (float)messages ); }
+
+	// called every tick, samples the connections from the transport once a
+	// second and returns true when it did
+	bool	Update( unsigned int time_ms, const ITransport* transport );
+
+	//.........................................................................
+
+	const NetworkPeerStats&	GetTotals() const { return mTotals; }
+	const NetworkPeerStats&	GetMessageTypeStats( int type ) const;
+
+	// NULL if nothing has gone to or come from the address
+	const NetworkConnectionStats* GetConnectionStats( const TransportAddress& address ) const;
+	int		GetConnectionCount() const { return (int)mConnections.size(); }
+	const NetworkConnectionStats& GetConnection( int i ) const { return mConnections[ i ]; }
+
+	const CRollingWindow&	GetSerializeTime() const { return mSerializeTime; }
+	const CRollingWindow&	GetDeserializeTime() const { return mDeserializeTime; }
+	const CRollingWindow&	GetSendQueue() const { return mSendQueue; }
+	const CRollingWindow&	GetBytesSentPerSecond() const { return mBytesSentPerSecond; }
+	const CRollingWindow&	GetBytesReceivedPerSecond() const { return mBytesReceivedPerSecond; }
+
+	// Everything in one go. The CSV has a line per message type and per
+	// connection, the rolling windows are in their own lines at the end.
+	void	Export( std::ostream& stream, NetworkStatsFormat format ) const;
+
+private:
+	NetworkConnectionStats& GetConnectionFor( const TransportAddress& address );
+
+	void	ExportCSV( std::ostream& stream ) const;
+	void	ExportJSON( std::ostream& stream ) const;
+
+	bool									mEnabled;
+	unsigned int							mTimingInterval;
+	unsigned int							mTimingCounter;
+
+	NetworkPeerStats						mTotals;
+	NetworkPeerStats						mMessageTypes[ MESSAGE_TYPE_COUNT ];
+
+	std::vector< NetworkConnectionStats >	mConnections;
+	std::map< TransportAddress, int >		mConnectionIndex;
+	int										mLastConnection;
+	int										mReceiveConnection;
+
+	CRollingWindow							mSerializeTime;
+	CRollingWindow							mDeserializeTime;
+	CRollingWindow							mSendQueue;
+	CRollingWindow							mBytesSentPerSecond;
+	CRollingWindow							mBytesReceivedPerSecond;
+
+	bool									mSampled;
+	unsigned int							mLastSampleTime;
+	NetworkPeerStats						mLastSampleTotals;
+};
+
+//-----------------------------------------------------------------------------
+// microseconds from some point, for timing the serialization
+
+double GetNetworkStatsTime();
+
+//-----------------------------------------------------------------------------
+
+#endif
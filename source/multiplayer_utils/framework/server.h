@@ -23,10 +23,19 @@
 #define INC_START_SERVER_H
 
 #include "multiplayer_data.h"
-#include "lag_simulator.h"
+#include "network_conditioner.h"
+#include "network_stats.h"
 
 int StartServer( float update_freq, const MultiplayerData& m_data );
 
 void KillMultiplayer();
 
+// a copy of the running peer's stats as they were at the last full second,
+// false if nothing is running
+bool GetMultiplayerStats( CNetworkStats& stats );
+
+// with MultiplayerData::handle_in_game_thread, runs the handlers of what has
+// been received, returns how many messages there were
+int HandleMultiplayerMessages();
+
 #endif
\ No newline at end of file
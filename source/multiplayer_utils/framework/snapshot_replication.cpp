@@ -0,0 +1,482 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include "snapshot_replication.h"
+
+#include <algorithm>
+
+#include "../../utils/memorypool/callocationtracker.h"
+
+using namespace network_utils;
+
+namespace {
+
+	void SwapFields( SnapshotFields& a, SnapshotFields& b )
+	{
+		a.field_types.swap( b.field_types );
+		a.values.swap( b.values );
+		a.strings.swap( b.strings );
+	}
+
+	// Layout: the sequence, how far back the baseline is (0 for none), the
+	// removed entities and then the changed ones until the end. The ids are
+	// written as the difference to the previous one, for the changed ones the
+	// lowest bit tells if the entity is in full.
+	void EncodeSnapshot( const WorldSnapshot* baseline, const WorldSnapshot& snapshot, types::ustring& out )
+	{
+		out.clear();
+		WriteVarUint32( snapshot.sequence, out );
+		WriteVarUint32( baseline ? snapshot.sequence - baseline->sequence : 0, out );
+
+		const int count = snapshot.GetCount();
+		const int baseline_count = baseline ? baseline->GetCount() : 0;
+
+		// the removed ones
+		{
+			unsigned int removed = 0;
+			int j = 0;
+			for( int i = 0; i < baseline_count; ++i )
+			{
+				while( j < count && snapshot.ids[ j ] < baseline->ids[ i ] )
+					++j;
+				if( j >= count || snapshot.ids[ j ] != baseline->ids[ i ] )
+					++removed;
+			}
+
+			WriteVarUint32( removed, out );
+
+			unsigned int previous = 0;
+			j = 0;
+			for( int i = 0; i < baseline_count && removed > 0; ++i )
+			{
+				while( j < count && snapshot.ids[ j ] < baseline->ids[ i ] )
+					++j;
+				if( j >= count || snapshot.ids[ j ] != baseline->ids[ i ] )
+				{
+					WriteVarUint32( baseline->ids[ i ] - previous, out );
+					previous = baseline->ids[ i ];
+				}
+			}
+		}
+
+		unsigned int previous = 0;
+		int j = 0;
+		for( int i = 0; i < count; ++i )
+		{
+			const unsigned int id = snapshot.ids[ i ];
+			const unsigned int difference = id - previous;
+			cassert( difference < 0x80000000 );
+
+			while( j < baseline_count && baseline->ids[ j ] < id )
+				++j;
+
+			if( j < baseline_count && baseline->ids[ j ] == id )
+			{
+				const std::size_t start = out.size();
+				WriteVarUint32( difference << 1, out );
+
+				bool unchanged = false;
+				if( WriteSnapshotDelta( baseline->entities[ j ], snapshot.entities[ i ], out, &unchanged ) )
+				{
+					previous = id;
+					continue;
+				}
+
+				out.resize( start );
+				if( unchanged )
+					continue;
+			}
+
+			WriteVarUint32( ( difference << 1 ) | 1, out );
+			WriteSnapshotFields( snapshot.entities[ i ], out );
+			previous = id;
+		}
+	}
+
+	bool IsNewer( unsigned int a, unsigned int b ) { return (int)( a - b ) > 0; }
+}
+
+//-----------------------------------------------------------------------------
+
+void WorldSnapshot::Clear( unsigned int new_sequence )
+{
+	sequence = new_sequence;
+	ids.clear();
+}
+
+SnapshotFields& WorldSnapshot::Add( unsigned int id )
+{
+	const std::size_t index = ids.size();
+	ids.push_back( id );
+	if( entities.size() <= index )
+		entities.resize( index + 1 );
+	return entities[ index ];
+}
+
+int WorldSnapshot::Find( unsigned int id ) const
+{
+	std::vector< unsigned int >::const_iterator i = std::lower_bound( ids.begin(), ids.end(), id );
+	if( i == ids.end() || *i != id )
+		return -1;
+	return (int)( i - ids.begin() );
+}
+
+void WorldSnapshot::Swap( WorldSnapshot& other )
+{
+	std::swap( sequence, other.sequence );
+	ids.swap( other.ids );
+	entities.swap( other.entities );
+}
+
+//=============================================================================
+
+CSnapshotServer::CSnapshotServer( int history ) :
+	mHistory( history ),
+	mSequence( 0 ),
+	mBuilding( false ),
+	mDeltaCompression( true ),
+	mWritten( history + 1 ),
+	mWrittenCount( 0 )
+{
+	cassert( history > 1 );
+}
+
+int CSnapshotServer::AddClient()
+{
+	for( std::size_t i = 0; i < mClients.size(); ++i )
+	{
+		if( mClients[ i ].active == false )
+		{
+			mClients[ i ] = Client();
+			mClients[ i ].active = true;
+			return (int)i;
+		}
+	}
+
+	mClients.push_back( Client() );
+	mClients.back().active = true;
+	return (int)mClients.size() - 1;
+}
+
+void CSnapshotServer::RemoveClient( int client )
+{
+	cassert( client >= 0 && client < (int)mClients.size() );
+	mClients[ client ].active = false;
+}
+
+//-----------------------------------------------------------------------------
+
+void CSnapshotServer::BeginSnapshot()
+{
+	cassert( mBuilding == false );
+	mBuilding = true;
+
+	unsigned int sequence = mSequence + 1;
+	if( sequence == 0 )
+		sequence = 1;
+
+	mHistory[ sequence % mHistory.size() ].Clear( sequence );
+}
+
+SnapshotFields& CSnapshotServer::AddEntityFields( unsigned int id )
+{
+	cassert( mBuilding );
+
+	unsigned int sequence = mSequence + 1;
+	if( sequence == 0 )
+		sequence = 1;
+
+	return mHistory[ sequence % mHistory.size() ].Add( id );
+}
+
+void CSnapshotServer::EndSnapshot()
+{
+	CENG_ALLOCATION_TAG( ceng::ALLOCATION_TAG_NETWORK );
+
+	cassert( mBuilding );
+	mBuilding = false;
+
+	++mSequence;
+	if( mSequence == 0 )
+		mSequence = 1;
+
+	WorldSnapshot& snapshot = mHistory[ mSequence % mHistory.size() ];
+	const int count = snapshot.GetCount();
+
+	// the entities can be added in any order, the deltas want them sorted
+	bool sorted = true;
+	for( int i = 1; i < count && sorted; ++i )
+		sorted = snapshot.ids[ i - 1 ] < snapshot.ids[ i ];
+
+	if( sorted == false )
+	{
+		mSortBuffer.resize( count );
+		for( int i = 0; i < count; ++i )
+			mSortBuffer[ i ] = std::make_pair( snapshot.ids[ i ], i );
+		std::sort( mSortBuffer.begin(), mSortBuffer.end() );
+
+		if( (int)mSortEntities.size() < count )
+			mSortEntities.resize( count );
+
+		for( int i = 0; i < count; ++i )
+		{
+			cassert( i == 0 || mSortBuffer[ i - 1 ].first != mSortBuffer[ i ].first );
+			snapshot.ids[ i ] = mSortBuffer[ i ].first;
+			SwapFields( mSortEntities[ i ], snapshot.entities[ mSortBuffer[ i ].second ] );
+		}
+
+		for( int i = 0; i < count; ++i )
+			SwapFields( mSortEntities[ i ], snapshot.entities[ i ] );
+	}
+
+	mWrittenCount = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+const WorldSnapshot* CSnapshotServer::GetBaseline( unsigned int sequence ) const
+{
+	if( sequence == 0 || mDeltaCompression == false )
+		return NULL;
+
+	if( mSequence - sequence >= mHistory.size() )
+		return NULL;
+
+	const WorldSnapshot& result = mHistory[ sequence % mHistory.size() ];
+	if( result.sequence != sequence )
+		return NULL;
+
+	return &result;
+}
+
+const CSnapshotServer::Written& CSnapshotServer::GetWritten( unsigned int baseline )
+{
+	for( int i = 0; i < mWrittenCount; ++i )
+	{
+		if( mWritten[ i ].baseline == baseline )
+			return mWritten[ i ];
+	}
+
+	CENG_ALLOCATION_TAG( ceng::ALLOCATION_TAG_NETWORK );
+
+	// there can't be more baselines than the history and the full one, so
+	// the references stay valid for the tick
+	cassert( mWrittenCount < (int)mWritten.size() );
+
+	Written& result = mWritten[ mWrittenCount++ ];
+	result.baseline = baseline;
+	EncodeSnapshot( GetBaseline( baseline ), mHistory[ mSequence % mHistory.size() ], result.data );
+	return result;
+}
+
+const types::ustring& CSnapshotServer::WriteSnapshot( int client )
+{
+	cassert( client >= 0 && client < (int)mClients.size() );
+	cassert( mClients[ client ].active );
+	cassert( mSequence != 0 && "WriteSnapshot() before the first EndSnapshot()" );
+
+	Client& c = mClients[ client ];
+	const unsigned int baseline = GetBaseline( c.acked ) ? c.acked : 0;
+
+	const Written& written = GetWritten( baseline );
+	const Written& full = GetWritten( 0 );
+
+	c.stats.snapshots++;
+	if( baseline == 0 )
+		c.stats.full_snapshots++;
+	c.stats.bytes += (unsigned int)written.data.size();
+	c.stats.full_bytes += (unsigned int)full.data.size();
+	c.stats.last_snapshot_bytes = (unsigned int)written.data.size();
+
+	return written.data;
+}
+
+void CSnapshotServer::Acknowledge( int client, unsigned int sequence )
+{
+	cassert( client >= 0 && client < (int)mClients.size() );
+
+	Client& c = mClients[ client ];
+	c.stats.acks++;
+
+	// the acks can come out of order, only the newest one matters
+	if( c.acked == 0 || IsNewer( sequence, c.acked ) )
+		c.acked = sequence;
+}
+
+const SnapshotClientStats& CSnapshotServer::GetClientStats( int client ) const
+{
+	cassert( client >= 0 && client < (int)mClients.size() );
+	return mClients[ client ].stats;
+}
+
+//=============================================================================
+
+CSnapshotClient::CSnapshotClient( int history ) :
+	mHistory( history ),
+	mSequence( 0 )
+{
+	cassert( history > 1 );
+}
+
+const WorldSnapshot* CSnapshotClient::GetSnapshot() const
+{
+	if( mSequence == 0 )
+		return NULL;
+	return &mHistory[ mSequence % mHistory.size() ];
+}
+
+bool CSnapshotClient::ReadSnapshot( const char* data, unsigned int length )
+{
+	CENG_ALLOCATION_TAG( ceng::ALLOCATION_TAG_NETWORK );
+
+	unsigned int position = 0;
+	unsigned int sequence = 0;
+	unsigned int back = 0;
+	if( ReadVarUint32( data, length, position, sequence ) == false ||
+		ReadVarUint32( data, length, position, back ) == false ||
+		sequence == 0 )
+	{
+		mStats.broken_snapshots++;
+		return false;
+	}
+
+	if( mSequence != 0 && IsNewer( sequence, mSequence ) == false )
+	{
+		mStats.old_snapshots++;
+		return false;
+	}
+
+	const WorldSnapshot* baseline = &mEmpty;
+	if( back != 0 )
+	{
+		const unsigned int baseline_sequence = sequence - back;
+		const WorldSnapshot& candidate = mHistory[ baseline_sequence % mHistory.size() ];
+		if( back >= mHistory.size() ||
+			baseline_sequence == 0 ||
+			candidate.sequence != baseline_sequence )
+		{
+			mStats.missing_baselines++;
+			return false;
+		}
+		baseline = &candidate;
+	}
+
+	// decoded aside so a broken one doesn't ruin what's in the history
+	mDecoded.Clear( sequence );
+	if( Decode( data, length, position, *baseline, mDecoded ) == false )
+	{
+		mStats.broken_snapshots++;
+		return false;
+	}
+
+	mHistory[ sequence % mHistory.size() ].Swap( mDecoded );
+	mSequence = sequence;
+
+	mStats.snapshots++;
+	if( back == 0 )
+		mStats.full_snapshots++;
+	mStats.bytes += length;
+
+	return true;
+}
+
+bool CSnapshotClient::Decode( const char* data, unsigned int length, unsigned int& position, const WorldSnapshot& baseline, WorldSnapshot& result )
+{
+	unsigned int removed_count = 0;
+	if( ReadVarUint32( data, length, position, removed_count ) == false ||
+		removed_count > length - position )
+		return false;
+
+	mRemoved.clear();
+	unsigned int previous = 0;
+	for( unsigned int i = 0; i < removed_count; ++i )
+	{
+		unsigned int difference = 0;
+		if( ReadVarUint32( data, length, position, difference ) == false )
+			return false;
+		previous += difference;
+		mRemoved.push_back( previous );
+	}
+
+	const int baseline_count = baseline.GetCount();
+	std::size_t r = 0;
+	int b = 0;
+	previous = 0;
+	bool first = true;
+
+	while( true )
+	{
+		// the last id is past everything, the rest of the baseline is copied
+		bool done = ( position >= length );
+		unsigned int header = 0;
+		unsigned int id = 0;
+		if( done == false )
+		{
+			if( ReadVarUint32( data, length, position, header ) == false )
+				return false;
+
+			id = previous + ( header >> 1 );
+			if( first == false && id <= previous )
+				return false;
+			previous = id;
+			first = false;
+		}
+
+		// the unchanged ones from the baseline, except for the removed ones
+		for( ; b < baseline_count && ( done || baseline.ids[ b ] < id ); ++b )
+		{
+			const unsigned int baseline_id = baseline.ids[ b ];
+			while( r < mRemoved.size() && mRemoved[ r ] < baseline_id )
+				++r;
+			if( r < mRemoved.size() && mRemoved[ r ] == baseline_id )
+				continue;
+
+			result.Add( baseline_id ) = baseline.entities[ b ];
+		}
+
+		if( done )
+			break;
+
+		const bool in_baseline = ( b < baseline_count && baseline.ids[ b ] == id );
+		SnapshotFields& fields = result.Add( id );
+
+		if( header & 1 )
+		{
+			if( ReadSnapshotFields( data, length, position, fields ) == false )
+				return false;
+		}
+		else
+		{
+			if( in_baseline == false ||
+				ReadSnapshotDelta( baseline.entities[ b ], data, length, position, fields ) == false )
+				return false;
+		}
+
+		if( in_baseline )
+			++b;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,241 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#ifndef INC_SNAPSHOT_REPLICATION_H
+#define INC_SNAPSHOT_REPLICATION_H
+
+#include <vector>
+
+#include "../../utils/network/network_snapshot.h"
+
+//-----------------------------------------------------------------------------
+// Replicated game state as snapshots. Every tick the server adds the
+// entities to a new snapshot, each writing itself through its BitSerialize(),
+// and writes the snapshot for each client against the newest snapshot that
+// client has acknowledged. Only the entities that changed, and only their
+// changed fields, go out. A client that hasn't acknowledged any of the
+// snapshots the server still keeps gets a full one, that's how the losses are
+// recovered from.
+//
+// The server keeps the last snapshots for everyone, a client just remembers
+// the newest one it has acknowledged. Clients with the same baseline get the
+// same bytes, so they're written once per baseline a tick.
+//
+// How the bytes and the acks are carried is up to the game, the bytes are
+// meant to go unreliable.
+//-----------------------------------------------------------------------------
+
+struct WorldSnapshot
+{
+	WorldSnapshot() : sequence( 0 ) { }
+
+	// empties it for reuse
+	void Clear( unsigned int new_sequence );
+
+	// the fields to write the entity to
+	network_utils::SnapshotFields& Add( unsigned int id );
+
+	int GetCount() const { return (int)ids.size(); }
+
+	// index of the entity, -1 if it's not there
+	int Find( unsigned int id ) const;
+
+	void Swap( WorldSnapshot& other );
+
+	unsigned int								sequence;
+
+	// sorted, the entities past the ids are kept around to be written over
+	std::vector< unsigned int >					ids;
+	std::vector< network_utils::SnapshotFields >	entities;
+};
+
+//-----------------------------------------------------------------------------
+
+struct SnapshotClientStats
+{
+	SnapshotClientStats() :
+		snapshots( 0 ),
+		full_snapshots( 0 ),
+		bytes( 0 ),
+		full_bytes( 0 ),
+		last_snapshot_bytes( 0 ),
+		acks( 0 )
+	{
+	}
+
+	// the full ones had no baseline, full_bytes is what all of them would
+	// have taken as full snapshots
+	unsigned int snapshots;
+	unsigned int full_snapshots;
+	unsigned int bytes;
+	unsigned int full_bytes;
+	unsigned int last_snapshot_bytes;
+	unsigned int acks;
+};
+
+//-----------------------------------------------------------------------------
+
+class CSnapshotServer
+{
+public:
+	enum { DEFAULT_HISTORY = 32 };
+
+	explicit CSnapshotServer( int history = DEFAULT_HISTORY );
+
+	int				AddClient();
+	void			RemoveClient( int client );
+
+	//.........................................................................
+
+	// the entities of a tick go between these two
+	void			BeginSnapshot();
+	void			EndSnapshot();
+
+	template< class T >
+	void AddEntity( unsigned int id, T& entity )
+	{
+		network_utils::CSnapshotWriter writer( AddEntityFields( id ) );
+		entity.BitSerialize( &writer );
+	}
+
+	// for writing the fields without an object
+	network_utils::SnapshotFields& AddEntityFields( unsigned int id );
+
+	// the last one that was ended
+	unsigned int	GetSequence() const { return mSequence; }
+
+	//.........................................................................
+
+	// the latest snapshot for the client, the data is valid until the next
+	// EndSnapshot()
+	const network_utils::types::ustring& WriteSnapshot( int client );
+
+	void			Acknowledge( int client, unsigned int sequence );
+
+	// off writes everything in full, for comparing and debugging
+	void			SetDeltaCompression( bool enabled ) { mDeltaCompression = enabled; }
+
+	const SnapshotClientStats& GetClientStats( int client ) const;
+
+private:
+	struct Client
+	{
+		Client() : active( false ), acked( 0 ) { }
+
+		bool				active;
+		unsigned int		acked;
+		SnapshotClientStats	stats;
+	};
+
+	struct Written
+	{
+		Written() : baseline( 0 ) { }
+
+		unsigned int					baseline;
+		network_utils::types::ustring	data;
+	};
+
+	const WorldSnapshot*	GetBaseline( unsigned int sequence ) const;
+	const Written&			GetWritten( unsigned int baseline );
+
+	std::vector< WorldSnapshot >	mHistory;
+	std::vector< Client >			mClients;
+	unsigned int					mSequence;
+	bool							mBuilding;
+	bool							mDeltaCompression;
+
+	// what was written this tick, per baseline
+	std::vector< Written >			mWritten;
+	int								mWrittenCount;
+	std::vector< std::pair< unsigned int, int > >		mSortBuffer;
+	std::vector< network_utils::SnapshotFields >		mSortEntities;
+};
+
+//-----------------------------------------------------------------------------
+
+struct SnapshotReceiveStats
+{
+	SnapshotReceiveStats() :
+		snapshots( 0 ),
+		full_snapshots( 0 ),
+		bytes( 0 ),
+		old_snapshots( 0 ),
+		missing_baselines( 0 ),
+		broken_snapshots( 0 )
+	{
+	}
+
+	unsigned int snapshots;
+	unsigned int full_snapshots;
+	unsigned int bytes;
+
+	// the ones that couldn't be used
+	unsigned int old_snapshots;
+	unsigned int missing_baselines;
+	unsigned int broken_snapshots;
+};
+
+//-----------------------------------------------------------------------------
+
+class CSnapshotClient
+{
+public:
+	explicit CSnapshotClient( int history = CSnapshotServer::DEFAULT_HISTORY );
+
+	// False if the snapshot couldn't be used: it was older than the latest
+	// one, it was broken or its baseline has been written over.
+	bool					ReadSnapshot( const char* data, unsigned int length );
+
+	// the latest snapshot, this is what is acknowledged to the server
+	unsigned int			GetSequence() const { return mSequence; }
+	const WorldSnapshot*	GetSnapshot() const;
+
+	template< class T >
+	bool ReadEntity( unsigned int id, T& entity ) const
+	{
+		const WorldSnapshot* snapshot = GetSnapshot();
+		const int index = snapshot ? snapshot->Find( id ) : -1;
+		if( index < 0 )
+			return false;
+
+		network_utils::CSnapshotReader reader( snapshot->entities[ index ] );
+		entity.BitSerialize( &reader );
+		return reader.HasOverflowed() == false;
+	}
+
+	const SnapshotReceiveStats& GetStats() const { return mStats; }
+
+private:
+	bool Decode( const char* data, unsigned int length, unsigned int& position, const WorldSnapshot& baseline, WorldSnapshot& result );
+
+	std::vector< WorldSnapshot >	mHistory;
+	WorldSnapshot					mDecoded;
+	WorldSnapshot					mEmpty;
+	unsigned int					mSequence;
+	SnapshotReceiveStats			mStats;
+	std::vector< unsigned int >		mRemoved;
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,164 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#ifndef INC_SPSC_QUEUE_H
+#define INC_SPSC_QUEUE_H
+
+#include <vector>
+
+#include "../../utils/debug.h"
+
+#if defined(_MSC_VER)
+#	include <intrin.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Bounded lock free queue from one thread to another. One thread pushes, one
+// thread pops, and neither ever waits for the other: Push() returns false
+// when the queue is full and Pop() when it's empty, what to do then is up to
+// the caller.
+//
+// The items are in a ring of a power of two slots. The head and the tail
+// run freely and wrap around, each side only writes its own and keeps a
+// copy of the other one, which it reads again only when the queue looks
+// full or empty, so the two threads don't fight over the cache lines.
+//-----------------------------------------------------------------------------
+
+template< class T >
+class CSpscQueue
+{
+public:
+	// the capacity is rounded up to a power of two
+	explicit CSpscQueue( unsigned int capacity ) :
+		mItems( RoundUpToPowerOfTwo( capacity ) ),
+		mMask( (unsigned int)mItems.size() - 1 ),
+		mHead( 0 ),
+		mTailCopy( 0 ),
+		mTail( 0 ),
+		mHeadCopy( 0 )
+	{
+		cassert( capacity > 0 );
+	}
+
+	// for the pushing thread, false if the queue is full
+	bool Push( const T& item )
+	{
+		const unsigned int tail = mTail;
+		if( tail - mHeadCopy > mMask )
+		{
+			mHeadCopy = LoadAcquire( &mHead );
+			if( tail - mHeadCopy > mMask )
+				return false;
+		}
+
+		mItems[ tail & mMask ] = item;
+		StoreRelease( &mTail, tail + 1 );
+		return true;
+	}
+
+	// for the popping thread, false if the queue is empty
+	bool Pop( T& item )
+	{
+		const unsigned int head = mHead;
+		if( head == mTailCopy )
+		{
+			mTailCopy = LoadAcquire( &mTail );
+			if( head == mTailCopy )
+				return false;
+		}
+
+		item = mItems[ head & mMask ];
+		mItems[ head & mMask ] = T();
+		StoreRelease( &mHead, head + 1 );
+		return true;
+	}
+
+	// from either thread, may be out of date by the time it returns
+	unsigned int GetSize() const	{ return LoadAcquire( &mTail ) - LoadAcquire( &mHead ); }
+	bool IsEmpty() const			{ return GetSize() == 0; }
+	unsigned int GetCapacity() const { return mMask + 1; }
+
+private:
+	enum { CACHE_LINE_SIZE = 64 };
+
+	// The other thread sees the writes made before a StoreRelease() once
+	// its LoadAcquire() sees the stored value. A volatile access with a
+	// compiler barrier isn't enough for that on ARM, so msvc uses the
+	// interlocked functions, which are full barriers everywhere.
+	static unsigned int LoadAcquire( const volatile unsigned int* value )
+	{
+#if defined(_MSC_VER)
+		return (unsigned int)_InterlockedCompareExchange( (volatile long*)value, 0, 0 );
+#elif defined(__ATOMIC_ACQUIRE)
+		return __atomic_load_n( value, __ATOMIC_ACQUIRE );
+#elif defined(__GNUC__)
+		const unsigned int result = *value;
+		__sync_synchronize();
+		return result;
+#else
+#	error "CSpscQueue needs atomics for this compiler"
+#endif
+	}
+
+	static void StoreRelease( volatile unsigned int* value, unsigned int new_value )
+	{
+#if defined(_MSC_VER)
+		_InterlockedExchange( (volatile long*)value, (long)new_value );
+#elif defined(__ATOMIC_RELEASE)
+		__atomic_store_n( value, new_value, __ATOMIC_RELEASE );
+#elif defined(__GNUC__)
+		__sync_synchronize();
+		*value = new_value;
+#else
+#	error "CSpscQueue needs atomics for this compiler"
+#endif
+	}
+
+	static unsigned int RoundUpToPowerOfTwo( unsigned int value )
+	{
+		unsigned int result = 1;
+		while( result < value )
+			result <<= 1;
+		return result;
+	}
+
+	std::vector< T >		mItems;
+	unsigned int			mMask;
+
+	// the popping thread's
+	char					mPadding0[ CACHE_LINE_SIZE ];
+	volatile unsigned int	mHead;
+	unsigned int			mTailCopy;
+
+	// the pushing thread's
+	char					mPadding1[ CACHE_LINE_SIZE ];
+	volatile unsigned int	mTail;
+	unsigned int			mHeadCopy;
+	char					mPadding2[ CACHE_LINE_SIZE ];
+
+	// can't be copied
+	CSpscQueue( const CSpscQueue& );
+	CSpscQueue& operator=( const CSpscQueue& );
+};
+
+#endif
@@ -0,0 +1,239 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include <stdlib.h>
+#include <vector>
+
+#include "../../../utils/debug.h"
+#include "../../../tester/tester_benchmark.h"
+#include "../igamemessage.h"
+#include "../igamemessagefactory.h"
+#include "../interest_management.h"
+#include "../network_peer.h"
+#include "../transport_loopback.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	enum { PLAYER_STATE_MESSAGE_ID = 100 };
+
+	const int bench_players = 100;
+	const int bench_ticks = 200;
+	const int bench_tick_rate = 20;
+	const float bench_world_size = 2000.f;
+	const float bench_relevance = 300.f;
+
+	class CPlayerStateMessage : public IGameMessage
+	{
+	public:
+		CPlayerStateMessage( int entity = -1, float x = 0, float y = 0 ) : mEntity( entity ), mX( x ), mY( y ), mHealth( 100 ) { }
+
+		int GetType() const { return PLAYER_STATE_MESSAGE_ID; }
+		int GetEntity() const { return mEntity; }
+		bool IsPooled() const { return true; }
+		TransportDelivery GetDelivery() const { return TRANSPORT_UNRELIABLE_SEQUENCED; }
+
+		void BitSerialize( network_utils::ISerializer* serializer )
+		{
+			serializer->IO( mEntity );
+			serializer->IO( mX );
+			serializer->IO( mY );
+			serializer->IO( mHealth );
+		}
+
+		void HandleClient( IPacketHandler* packet_handler )
+		{
+			( *static_cast< int* >( packet_handler->GetUserData() ) )++;
+		}
+
+		network_utils::int32	mEntity;
+		network_utils::float32	mX;
+		network_utils::float32	mY;
+		network_utils::int32	mHealth;
+	};
+
+	class CPlayerStateMessageFactory : public IGameMessageFactory
+	{
+	public:
+		IGameMessage* GetNewMessage( int type ) { return ( type == PLAYER_STATE_MESSAGE_ID ) ? new CPlayerStateMessage : NULL; }
+		int GetGameMessageID_First() const { return PLAYER_STATE_MESSAGE_ID; }
+		int GetGameMessageID_Last() const { return PLAYER_STATE_MESSAGE_ID; }
+	};
+
+	struct BenchPlayer
+	{
+		float x;
+		float y;
+		float dx;
+		float dy;
+	};
+
+	// everyone runs around in a straight line and bounces off the edges of
+	// the world, some faster than others. Same every run.
+	void MovePlayers( std::vector< BenchPlayer >& players )
+	{
+		for( std::size_t i = 0; i < players.size(); ++i )
+		{
+			BenchPlayer& player = players[ i ];
+			player.x += player.dx;
+			player.y += player.dy;
+			if( player.x < 0 || player.x > bench_world_size )
+				player.dx = -player.dx;
+			if( player.y < 0 || player.y > bench_world_size )
+				player.dy = -player.dy;
+		}
+	}
+
+	enum BenchMode
+	{
+		BENCH_EVERYONE,
+		BENCH_INTEREST,
+		BENCH_INTEREST_AND_RATES
+	};
+
+	struct BenchResult
+	{
+		BenchResult() : seconds( 0 ), bytes( 0 ), received( 0 ), visible( 0 ) { }
+
+		double			seconds;
+		unsigned int	bytes;
+		unsigned int	received;
+		unsigned int	visible;
+	};
+
+	BenchResult RunPlayers( BenchMode mode )
+	{
+		srand( 1 );
+
+		CLoopbackNetwork network;
+		ITransport* server_transport = network.CreateTransport();
+		CNetworkPeer* server = new CNetworkPeer( true, server_transport, new CPlayerStateMessageFactory );
+
+		CInterestManager interest( 128.f );
+		if( mode == BENCH_INTEREST )
+			interest.ClearUpdateRates();
+		CInterestPacketHandler interest_handler( server, &interest );
+		IPacketHandler* packet_handler = ( mode == BENCH_EVERYONE ) ? server->GetPacketHandler() : &interest_handler;
+
+		std::vector< BenchPlayer > players( bench_players );
+		std::vector< CLoopbackTransport* > client_transports;
+		std::vector< CNetworkPeer* > clients;
+		std::vector< int > received( bench_players, 0 );
+
+		for( int i = 0; i < bench_players; ++i )
+		{
+			BenchPlayer& player = players[ i ];
+			player.x = bench_world_size * (float)( rand() % 1000 ) / 1000.f;
+			player.y = bench_world_size * (float)( rand() % 1000 ) / 1000.f;
+			player.dx = (float)( rand() % 21 - 10 );
+			player.dy = (float)( rand() % 21 - 10 );
+
+			CLoopbackTransport* transport = network.CreateTransport();
+			transport->Connect( server_transport->GetLocalAddress() );
+			client_transports.push_back( transport );
+			clients.push_back( new CNetworkPeer( false, transport, new CPlayerStateMessageFactory ) );
+			clients.back()->SetUserData( &received[ i ] );
+
+			interest.AddEntity( i, player.x, player.y, bench_relevance );
+			interest.SetClient( transport->GetLocalAddress(), player.x, player.y );
+		}
+
+		server->Update();
+		for( int i = 0; i < bench_players; ++i )
+			clients[ i ]->Update();
+
+		const unsigned int bytes_before = network.GetBytesSent();
+
+		BenchResult result;
+		poro::tester::CBenchmarkTimer timer;
+		for( int tick = 0; tick < bench_ticks; ++tick )
+		{
+			MovePlayers( players );
+			for( int i = 0; i < bench_players; ++i )
+			{
+				interest.MoveEntity( i, players[ i ].x, players[ i ].y );
+				interest.SetClient( client_transports[ i ]->GetLocalAddress(), players[ i ].x, players[ i ].y );
+			}
+			interest.Update();
+
+			for( int i = 0; i < bench_players; ++i )
+				packet_handler->SendGameMessage( new CPlayerStateMessage( i, players[ i ].x, players[ i ].y ) );
+
+			server->Update();
+			for( int i = 0; i < bench_players; ++i )
+			{
+				clients[ i ]->Update();
+				result.visible += (unsigned int)interest.GetVisible( client_transports[ i ]->GetLocalAddress() )->size();
+			}
+		}
+
+		result.seconds = timer.GetSeconds();
+		result.bytes = network.GetBytesSent() - bytes_before;
+
+		for( int i = 0; i < bench_players; ++i )
+		{
+			result.received += received[ i ];
+			delete clients[ i ];
+			delete client_transports[ i ];
+		}
+
+		delete server;
+		delete server_transport;
+
+		return result;
+	}
+
+	void Report( const std::string& name, const BenchResult& result )
+	{
+		const double seconds_simulated = (double)bench_ticks / bench_tick_rate;
+		const double per_client = (double)result.bytes / bench_players / seconds_simulated;
+
+		poro::tester::BenchmarkReport( name + ", ticks", result.seconds, bench_ticks );
+		test_logger << "  " << (int)per_client << " bytes per client per second at " << bench_tick_rate << " Hz"
+			<< ", " << result.received / bench_ticks / bench_players << " updates per client per tick"
+			<< ", " << result.visible / bench_ticks / bench_players << " players in view" << std::endl;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int InterestManagementBenchmark()
+{
+	test_logger << "Interest management over loopback, " << bench_players << " players in a "
+		<< (int)bench_world_size << "x" << (int)bench_world_size << " world, relevant up to " << (int)bench_relevance << std::endl;
+
+	Report( "everyone", RunPlayers( BENCH_EVERYONE ) );
+	Report( "interest", RunPlayers( BENCH_INTEREST ) );
+	Report( "interest and update rates", RunPlayers( BENCH_INTEREST_AND_RATES ) );
+
+	return 0;
+}
+
+BENCHMARK_REGISTER( InterestManagementBenchmark );
+
+} // end of namespace test
+
+#endif
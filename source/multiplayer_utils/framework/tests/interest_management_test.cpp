@@ -0,0 +1,385 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "../../../utils/debug.h"
+#include "../igamemessage.h"
+#include "../igamemessagefactory.h"
+#include "../interest_management.h"
+#include "../network_peer.h"
+#include "../transport_loopback.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	enum { ENTITY_MESSAGE_ID = 100 };
+
+	class CEntityMessage : public IGameMessage
+	{
+	public:
+		explicit CEntityMessage( int entity = -1 ) : mEntity( entity ) { }
+
+		int GetType() const { return ENTITY_MESSAGE_ID; }
+		int GetEntity() const { return mEntity; }
+		bool IsPooled() const { return true; }
+
+		void BitSerialize( network_utils::ISerializer* serializer )
+		{
+			serializer->IO( mEntity );
+		}
+
+		void HandleClient( IPacketHandler* packet_handler )
+		{
+			static_cast< std::vector< int >* >( packet_handler->GetUserData() )->push_back( mEntity );
+		}
+
+		network_utils::int32 mEntity;
+	};
+
+	class CEntityMessageFactory : public IGameMessageFactory
+	{
+	public:
+		IGameMessage* GetNewMessage( int type ) { return ( type == ENTITY_MESSAGE_ID ) ? new CEntityMessage : NULL; }
+		int GetGameMessageID_First() const { return ENTITY_MESSAGE_ID; }
+		int GetGameMessageID_Last() const { return ENTITY_MESSAGE_ID; }
+	};
+
+	struct TestEntity
+	{
+		int		id;
+		float	x;
+		float	y;
+		float	radius;
+		bool	exists;
+	};
+
+	struct TestClient
+	{
+		TransportAddress	address;
+		float				x;
+		float				y;
+		float				view_radius;
+	};
+
+	float RandomFloat( float max ) { return max * (float)( rand() % 10000 ) / 10000.f; }
+
+	std::vector< int > BruteForceVisible( const std::vector< TestEntity >& entities, const TestClient& client )
+	{
+		std::vector< int > result;
+		for( std::size_t i = 0; i < entities.size(); ++i )
+		{
+			const TestEntity& entity = entities[ i ];
+			const float dx = entity.x - client.x;
+			const float dy = entity.y - client.y;
+			const float reach = entity.radius + client.view_radius;
+			if( entity.exists && dx * dx + dy * dy <= reach * reach )
+				result.push_back( entity.id );
+		}
+		std::sort( result.begin(), result.end() );
+		return result;
+	}
+
+	bool Contains( const std::vector< int >& values, int value )
+	{
+		return std::find( values.begin(), values.end(), value ) != values.end();
+	}
+
+	int CountReceived( const std::vector< int >& received, int entity )
+	{
+		return (int)std::count( received.begin(), received.end(), entity );
+	}
+
+}
+
+int InterestManagementTest()
+{
+	const TransportAddress a( 0x7F000001, 1000 );
+	const TransportAddress b( 0x7F000001, 1001 );
+
+	// coming into view and going out of it
+	{
+		CInterestManager interest( 100.f );
+		interest.SetClient( a, 0, 0 );
+		interest.SetClient( b, 1000, 0, 50 );
+		interest.AddEntity( 1, 50, 0, 100 );
+		interest.AddEntity( 2, -500, -500, 10 );
+		test_assert( interest.GetVisible( a )->empty() );
+
+		interest.Update();
+		test_assert( interest.GetVisible( a )->size() == 1 && interest.IsVisible( 1, a ) );
+		test_assert( interest.GetEntered( a )->size() == 1 && interest.GetEntered( a )->at( 0 ) == 1 );
+		test_assert( interest.GetVisible( b )->empty() );
+		test_assert( interest.GetVisible( TransportAddress( 0x7F000001, 999 ) ) == NULL );
+
+		// in b's view radius but not in its own
+		interest.MoveEntity( 1, 1120, 0 );
+		interest.Update();
+		test_assert( interest.GetLeft( a )->size() == 1 && interest.GetLeft( a )->at( 0 ) == 1 );
+		test_assert( interest.GetVisible( a )->empty() );
+		test_assert( interest.GetEntered( b )->size() == 1 && interest.IsVisible( 1, b ) );
+
+		// nothing moves, nothing is worked out again
+		const unsigned int updates = interest.GetStats().visibility_updates;
+		interest.Update();
+		test_assert( interest.GetStats().visibility_updates == updates );
+		test_assert( interest.GetEntered( b )->empty() && interest.GetLeft( b )->empty() );
+
+		// something that far away doesn't bother anyone
+		interest.MoveEntity( 2, -600, -600 );
+		interest.Update();
+		test_assert( interest.GetStats().visibility_updates == updates );
+
+		interest.RemoveEntity( 1 );
+		test_assert( interest.HasEntity( 1 ) == false );
+		interest.Update();
+		test_assert( interest.GetLeft( b )->size() == 1 && interest.GetVisible( b )->empty() );
+
+		// the client comes to the entity
+		interest.SetClient( a, -595, -595 );
+		interest.Update();
+		test_assert( interest.IsVisible( 2, a ) );
+
+		interest.RemoveClient( a );
+		test_assert( interest.GetClientCount() == 1 );
+		test_assert( interest.GetVisible( a ) == NULL );
+		interest.RemoveEntity( 2 );
+		interest.Update();
+	}
+
+	// the same as checking everything against everything, while things move
+	// around, come and go
+	{
+		srand( 1234 );
+
+		CInterestManager interest( 128.f );
+		std::vector< TestEntity > entities( 300 );
+		for( std::size_t i = 0; i < entities.size(); ++i )
+		{
+			TestEntity& entity = entities[ i ];
+			entity.id = (int)i * 3 + 1;
+			entity.x = RandomFloat( 2000 ) - 1000;
+			entity.y = RandomFloat( 2000 ) - 1000;
+			entity.radius = 20 + RandomFloat( 300 );
+			entity.exists = true;
+			interest.AddEntity( entity.id, entity.x, entity.y, entity.radius );
+		}
+
+		std::vector< TestClient > clients( 20 );
+		for( std::size_t i = 0; i < clients.size(); ++i )
+		{
+			TestClient& client = clients[ i ];
+			client.address = TransportAddress( 0x7F000001, (unsigned short)( 2000 + i ) );
+			client.x = RandomFloat( 2000 ) - 1000;
+			client.y = RandomFloat( 2000 ) - 1000;
+			client.view_radius = ( i % 2 ) ? RandomFloat( 100 ) : 0;
+			interest.SetClient( client.address, client.x, client.y, client.view_radius );
+		}
+
+		std::vector< std::vector< int > > seen( clients.size() );
+		for( int round = 0; round < 50; ++round )
+		{
+			for( std::size_t i = 0; i < entities.size(); ++i )
+			{
+				TestEntity& entity = entities[ i ];
+				const int what = rand() % 20;
+				if( entity.exists && what < 6 )
+				{
+					entity.x += RandomFloat( 100 ) - 50;
+					entity.y += RandomFloat( 100 ) - 50;
+					interest.MoveEntity( entity.id, entity.x, entity.y );
+				}
+				else if( entity.exists && what == 6 )
+				{
+					entity.radius = 20 + RandomFloat( 300 );
+					interest.SetEntityRadius( entity.id, entity.radius );
+				}
+				else if( entity.exists && what == 7 )
+				{
+					entity.exists = false;
+					interest.RemoveEntity( entity.id );
+				}
+				else if( entity.exists == false && what == 8 )
+				{
+					entity.exists = true;
+					interest.AddEntity( entity.id, entity.x, entity.y, entity.radius );
+				}
+			}
+
+			for( std::size_t i = 0; i < clients.size(); ++i )
+			{
+				if( rand() % 4 == 0 )
+				{
+					clients[ i ].x += RandomFloat( 200 ) - 100;
+					clients[ i ].y += RandomFloat( 200 ) - 100;
+					interest.SetClient( clients[ i ].address, clients[ i ].x, clients[ i ].y, clients[ i ].view_radius );
+				}
+			}
+
+			interest.Update();
+
+			for( std::size_t i = 0; i < clients.size(); ++i )
+			{
+				const std::vector< int > expected = BruteForceVisible( entities, clients[ i ] );
+				test_assert( *interest.GetVisible( clients[ i ].address ) == expected );
+
+				// the changes take the client from what it saw to what it sees
+				const std::vector< int >& entered = *interest.GetEntered( clients[ i ].address );
+				const std::vector< int >& left = *interest.GetLeft( clients[ i ].address );
+				std::vector< int > applied = seen[ i ];
+				for( std::size_t j = 0; j < left.size(); ++j )
+				{
+					test_assert( Contains( applied, left[ j ] ) );
+					applied.erase( std::find( applied.begin(), applied.end(), left[ j ] ) );
+				}
+				for( std::size_t j = 0; j < entered.size(); ++j )
+				{
+					test_assert( Contains( applied, entered[ j ] ) == false );
+					applied.push_back( entered[ j ] );
+				}
+				std::sort( applied.begin(), applied.end() );
+				test_assert( applied == expected );
+				seen[ i ] = expected;
+			}
+		}
+
+		test_assert( interest.GetStats().entered > 0 && interest.GetStats().left > 0 );
+	}
+
+	// the further away, the less often
+	{
+		CInterestManager interest( 100.f );
+		interest.ClearUpdateRates();
+		interest.AddUpdateRate( 0.5f, 2 );
+		interest.AddUpdateRate( 0.8f, 4 );
+		interest.SetClient( a, 0, 0 );
+		interest.AddEntity( 1, 10, 0, 100 );
+		interest.AddEntity( 2, 60, 0, 100 );
+		interest.AddEntity( 3, 90, 0, 100 );
+
+		int near = 0, middle = 0, far = 0, reliable = 0;
+		std::vector< TransportAddress > receivers;
+		for( int tick = 0; tick < 8; ++tick )
+		{
+			interest.Update();
+			test_assert( interest.GetReceivers( 1, true, receivers ) );
+			near += (int)receivers.size();
+			test_assert( interest.GetReceivers( 2, true, receivers ) );
+			middle += (int)receivers.size();
+			test_assert( interest.GetReceivers( 3, true, receivers ) );
+			far += (int)receivers.size();
+			test_assert( interest.GetReceivers( 3, false, receivers ) );
+			reliable += (int)receivers.size();
+		}
+
+		test_assert( near == 8 );
+		test_assert( middle == 4 );
+		test_assert( far == 2 );
+		test_assert( reliable == 8 );
+		test_assert( interest.GetStats().copies_skipped == 4 + 6 );
+		test_assert( interest.GetReceivers( 4, true, receivers ) == false );
+
+		// closer, faster
+		interest.MoveEntity( 3, 0, 0 );
+		interest.Update();
+		test_assert( interest.GetReceivers( 3, true, receivers ) && receivers.size() == 1 );
+		interest.Update();
+		test_assert( interest.GetReceivers( 3, true, receivers ) && receivers.size() == 1 );
+	}
+
+	// through SendGameMessage() to the clients that care
+	{
+		CLoopbackNetwork network;
+		CLoopbackTransport* server_transport = network.CreateTransport();
+		CNetworkPeer* server = new CNetworkPeer( true, server_transport, new CEntityMessageFactory );
+
+		const int client_count = 3;
+		CLoopbackTransport* client_transports[ client_count ];
+		CNetworkPeer* clients[ client_count ];
+		std::vector< int > received[ client_count ];
+		for( int i = 0; i < client_count; ++i )
+		{
+			client_transports[ i ] = network.CreateTransport();
+			client_transports[ i ]->Connect( server_transport->GetLocalAddress() );
+			clients[ i ] = new CNetworkPeer( false, client_transports[ i ], new CEntityMessageFactory );
+			clients[ i ]->SetUserData( &received[ i ] );
+		}
+		server->Update();
+
+		CInterestManager interest( 100.f );
+		interest.SetClient( client_transports[ 0 ]->GetLocalAddress(), 0, 0 );
+		interest.SetClient( client_transports[ 1 ]->GetLocalAddress(), 1000, 0 );
+		interest.SetClient( client_transports[ 2 ]->GetLocalAddress(), 0, 50 );
+		interest.AddEntity( 7, 0, 0, 100 );
+		interest.Update();
+
+		CInterestPacketHandler packet_handler( server, &interest );
+		packet_handler.SendGameMessage( new CEntityMessage( 7 ) );
+		packet_handler.SendGameMessage( new CEntityMessage( -1 ) );
+		packet_handler.SendGameMessage( new CEntityMessage( 99 ) );
+
+		// no one sees it anymore
+		interest.MoveEntity( 7, 5000, 5000 );
+		interest.Update();
+		packet_handler.SendGameMessage( new CEntityMessage( 7 ) );
+
+		server->Update();
+		for( int i = 0; i < client_count; ++i )
+			clients[ i ]->Update();
+
+		test_assert( CountReceived( received[ 0 ], 7 ) == 1 );
+		test_assert( CountReceived( received[ 1 ], 7 ) == 0 );
+		test_assert( CountReceived( received[ 2 ], 7 ) == 1 );
+		for( int i = 0; i < client_count; ++i )
+		{
+			test_assert( CountReceived( received[ i ], -1 ) == 1 );
+			test_assert( CountReceived( received[ i ], 99 ) == 1 );
+		}
+
+		const InterestStats& stats = interest.GetStats();
+		test_assert( stats.messages == 4 );
+		test_assert( stats.messages_to_everyone == 2 );
+		test_assert( stats.copies == 2 + 3 + 3 );
+
+		for( int i = 0; i < client_count; ++i )
+		{
+			delete clients[ i ];
+			delete client_transports[ i ];
+		}
+		delete server;
+		delete server_transport;
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( InterestManagementTest );
+
+} // end of namespace test
+
+#endif
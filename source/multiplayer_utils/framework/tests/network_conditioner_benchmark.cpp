@@ -0,0 +1,202 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include <vector>
+
+#include "../../../utils/debug.h"
+#include "../../../tester/tester_benchmark.h"
+#include "../igamemessage.h"
+#include "../igamemessagefactory.h"
+#include "../network_conditioner.h"
+#include "../network_peer.h"
+#include "../transport_loopback.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	enum { BENCH_MESSAGE_ID = 100 };
+
+	const int bench_clients = 32;
+	const int bench_ticks = 600;
+	const int bench_tick_length = 16;
+	const int bench_messages_per_tick = 10;
+
+	unsigned int bench_time = 0;
+	unsigned int GetBenchTime() { return bench_time; }
+
+	struct BenchCounters
+	{
+		BenchCounters() : received( 0 ) { }
+		int received;
+	};
+
+	class CBenchMessage : public IGameMessage
+	{
+	public:
+		CBenchMessage() : mId( 1234 ), mX( 1.5f ), mY( -2.5f ) { }
+
+		int GetType() const { return BENCH_MESSAGE_ID; }
+		bool IsPooled() const { return true; }
+		TransportDelivery GetDelivery() const { return TRANSPORT_UNRELIABLE; }
+
+		void BitSerialize( network_utils::ISerializer* serializer )
+		{
+			serializer->IO( mId );
+			serializer->IO( mX );
+			serializer->IO( mY );
+		}
+
+		void HandleClient( IPacketHandler* packet_handler )
+		{
+			static_cast< BenchCounters* >( packet_handler->GetUserData() )->received++;
+		}
+
+		network_utils::uint32	mId;
+		network_utils::float32	mX;
+		network_utils::float32	mY;
+	};
+
+	class CBenchMessageFactory : public IGameMessageFactory
+	{
+	public:
+		IGameMessage* GetNewMessage( int type ) { return ( type == BENCH_MESSAGE_ID ) ? new CBenchMessage : NULL; }
+		int GetGameMessageID_First() const { return BENCH_MESSAGE_ID; }
+		int GetGameMessageID_Last() const { return BENCH_MESSAGE_ID; }
+	};
+
+	struct BenchResult
+	{
+		BenchResult() : seconds( 0 ), received( 0 ) { }
+
+		double					seconds;
+		int						received;
+		NetworkConditionerStats	stats;
+	};
+
+	// the server sends a bunch of unreliable updates to everyone every tick,
+	// ten simulated seconds at 60 Hz
+	BenchResult RunSoak( const NetworkConditions& conditions )
+	{
+		CLoopbackNetwork network;
+		CLoopbackTransport* server_transport = network.CreateTransport();
+		CNetworkConditioner* conditioner = new CNetworkConditioner( server_transport, 42 );
+		conditioner->SetClock( GetBenchTime );
+		CNetworkPeer* server = new CNetworkPeer( true, conditioner, new CBenchMessageFactory );
+
+		std::vector< CLoopbackTransport* > client_transports;
+		std::vector< CNetworkPeer* > clients;
+		std::vector< BenchCounters > counters( bench_clients );
+		for( int i = 0; i < bench_clients; ++i )
+		{
+			client_transports.push_back( network.CreateTransport() );
+			client_transports.back()->Connect( server_transport->GetLocalAddress() );
+			clients.push_back( new CNetworkPeer( false, client_transports.back(), new CBenchMessageFactory ) );
+			clients.back()->SetUserData( &counters[ i ] );
+		}
+
+		server->Update();
+		conditioner->SetConditions( NETWORK_OUTGOING, conditions );
+
+		BenchResult result;
+		poro::tester::CBenchmarkTimer timer;
+		for( int tick = 0; tick < bench_ticks; ++tick )
+		{
+			for( int m = 0; m < bench_messages_per_tick; ++m )
+				server->GetPacketHandler()->SendGameMessage( new CBenchMessage );
+
+			bench_time += bench_tick_length;
+			server->Update();
+			for( int i = 0; i < bench_clients; ++i )
+				clients[ i ]->Update();
+		}
+		result.seconds = timer.GetSeconds();
+		result.stats = conditioner->GetStats( NETWORK_OUTGOING );
+
+		for( int i = 0; i < bench_clients; ++i )
+		{
+			result.received += counters[ i ].received;
+			delete clients[ i ];
+			delete client_transports[ i ];
+		}
+
+		delete server;
+		delete conditioner;
+		delete server_transport;
+
+		return result;
+	}
+
+	void Report( const char* name, const BenchResult& result )
+	{
+		const int sent = bench_ticks * bench_messages_per_tick * bench_clients;
+		poro::tester::BenchmarkReport( name, result.seconds, bench_ticks );
+
+		const NetworkConditionerStats& stats = result.stats;
+		test_logger << "  " << result.received << " of " << sent << " messages"
+			<< ", datagrams: " << stats.packets
+			<< ", lost: " << stats.lost
+			<< ", in bursts: " << stats.lost_in_burst
+			<< ", queue drops: " << stats.queue_drops
+			<< ", duplicated: " << stats.duplicated
+			<< ", reordered: " << stats.reordered
+			<< ", delay: " << ( stats.delivered ? stats.total_delay / stats.delivered : 0 ) << " ms average, " << stats.max_delay << " ms max" << std::endl;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int NetworkConditionerBenchmark()
+{
+	test_logger << "Soak over loopback, " << bench_clients << " clients, " << bench_ticks << " ticks" << std::endl;
+
+	Report( "no conditions", RunSoak( NetworkConditions() ) );
+
+	NetworkConditions wifi;
+	wifi.latency = 40;
+	wifi.jitter = 15;
+	wifi.jitter_distribution = JITTER_EXPONENTIAL;
+	wifi.loss = 0.02f;
+	wifi.burst_chance = 0.005f;
+	wifi.burst_length = 8;
+	wifi.duplicate = 0.01f;
+	wifi.reorder = 0.01f;
+	wifi.reorder_delay = 30;
+	Report( "bad Wi-Fi", RunSoak( wifi ) );
+
+	// less than the 10 updates a tick need
+	NetworkConditions slow = wifi;
+	slow.bandwidth = 10000;
+	slow.queue_size = 2000;
+	Report( "bad Wi-Fi, 80 kbit/s", RunSoak( slow ) );
+
+	return 0;
+}
+
+BENCHMARK_REGISTER( NetworkConditionerBenchmark );
+
+} // end of namespace test
+
+#endif
@@ -0,0 +1,345 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include <vector>
+
+#include "../../../utils/debug.h"
+#include "../network_conditioner.h"
+#include "../transport_loopback.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	unsigned int fake_time = 1000;
+	unsigned int GetFakeTime() { return fake_time; }
+
+	bool SendValue( ITransport* transport, int value, const TransportAddress& address, TransportDelivery delivery = TRANSPORT_UNRELIABLE, unsigned int length = sizeof( int ) )
+	{
+		std::vector< unsigned char > data( length > sizeof( int ) ? length : sizeof( int ), 0 );
+		*(int*)&data[ 0 ] = value;
+		return transport->Send( &data[ 0 ], length, address, false, delivery, 0, TRANSPORT_PRIORITY_HIGH );
+	}
+
+	// the values of the data packets, the events are skipped
+	std::vector< int > ReceiveValues( ITransport* transport )
+	{
+		std::vector< int > result;
+		for( TransportPacket* packet = transport->Receive(); packet; packet = transport->Receive() )
+		{
+			if( packet->mEvent == TRANSPORT_DATA )
+				result.push_back( *(int*)packet->mData );
+			transport->DeallocatePacket( packet );
+		}
+		return result;
+	}
+
+	// how many times a value comes after a bigger one
+	int CountOutOfOrder( const std::vector< int >& values )
+	{
+		int result = 0;
+		for( std::size_t i = 1; i < values.size(); ++i )
+		{
+			if( values[ i ] < values[ i - 1 ] )
+				++result;
+		}
+		return result;
+	}
+
+	// sends count values, one every interval milliseconds, and lets them all
+	// arrive
+	std::vector< int > SendAndReceive( CNetworkConditioner& conditioner, ITransport* receiver, int count, TransportDelivery delivery, unsigned int interval = 1 )
+	{
+		std::vector< int > result;
+		const TransportAddress address = receiver->GetLocalAddress();
+		for( int i = 0; i < count; ++i )
+		{
+			SendValue( &conditioner, i, address, delivery );
+			fake_time += interval;
+			conditioner.Update();
+			std::vector< int > values = ReceiveValues( receiver );
+			result.insert( result.end(), values.begin(), values.end() );
+		}
+
+		for( int i = 0; i < 2000 && conditioner.GetPendingCount() > 0; ++i )
+		{
+			fake_time++;
+			conditioner.Update();
+		}
+
+		std::vector< int > values = ReceiveValues( receiver );
+		result.insert( result.end(), values.begin(), values.end() );
+		return result;
+	}
+
+	struct ConditionedPair
+	{
+		ConditionedPair( unsigned int seed = 1 ) :
+			a( network.CreateTransport() ),
+			b( network.CreateTransport() ),
+			conditioner( a, seed )
+		{
+			conditioner.SetClock( GetFakeTime );
+			a->Connect( b->GetLocalAddress() );
+			ReceiveValues( &conditioner );
+			ReceiveValues( b );
+		}
+
+		~ConditionedPair()
+		{
+			delete b;
+			delete a;
+		}
+
+		CLoopbackNetwork		network;
+		CLoopbackTransport*		a;
+		CLoopbackTransport*		b;
+		CNetworkConditioner		conditioner;
+	};
+
+}
+
+int NetworkConditionerTest()
+{
+	// turned off it's just the transport
+	{
+		ConditionedPair pair;
+		test_assert( SendValue( &pair.conditioner, 1, pair.b->GetLocalAddress() ) );
+		test_assert( ReceiveValues( pair.b ).size() == 1 );
+		test_assert( pair.conditioner.GetStats( NETWORK_OUTGOING ).packets == 0 );
+		test_assert( std::string( pair.conditioner.GetName() ) == "loopback" );
+	}
+
+	// latency
+	{
+		ConditionedPair pair;
+		NetworkConditions conditions;
+		conditions.latency = 50;
+		pair.conditioner.SetConditions( NETWORK_OUTGOING, conditions );
+
+		SendValue( &pair.conditioner, 1, pair.b->GetLocalAddress() );
+		test_assert( pair.conditioner.GetPendingCount() == 1 );
+		fake_time += 49;
+		pair.conditioner.Update();
+		test_assert( ReceiveValues( pair.b ).empty() );
+		fake_time += 1;
+		pair.conditioner.Update();
+		test_assert( ReceiveValues( pair.b ).size() == 1 );
+
+		const NetworkConditionerStats stats = pair.conditioner.GetStats( NETWORK_OUTGOING, pair.b->GetLocalAddress() );
+		test_assert( stats.packets == 1 && stats.delivered == 1 );
+		test_assert( stats.max_delay == 50 );
+	}
+
+	// the jitter is what it should be, and doesn't reorder anything
+	{
+		const JitterDistribution distributions[] = { JITTER_UNIFORM, JITTER_NORMAL, JITTER_EXPONENTIAL };
+		for( int d = 0; d < 3; ++d )
+		{
+			ConditionedPair pair;
+			NetworkConditions conditions;
+			conditions.latency = 100;
+			conditions.jitter = 20;
+			conditions.jitter_distribution = distributions[ d ];
+			pair.conditioner.SetConditions( NETWORK_OUTGOING, conditions );
+
+			const std::vector< int > values = SendAndReceive( pair.conditioner, pair.b, 1000, TRANSPORT_UNRELIABLE, 50 );
+			test_assert( values.size() == 1000 );
+			test_assert( CountOutOfOrder( values ) == 0 );
+
+			const NetworkConditionerStats stats = pair.conditioner.GetStats( NETWORK_OUTGOING );
+			const double average = stats.total_delay / stats.delivered;
+			if( distributions[ d ] == JITTER_UNIFORM )
+				test_assert( average > 95 && average < 105 && stats.max_delay <= 120 );
+			else if( distributions[ d ] == JITTER_NORMAL )
+				test_assert( average > 95 && average < 108 );
+			else
+				test_assert( average > 115 && average < 130 );
+		}
+	}
+
+	// random losses, the same with the same seed
+	{
+		NetworkConditions conditions;
+		conditions.loss = 0.3f;
+
+		ConditionedPair pair( 1234 );
+		pair.conditioner.SetConditions( NETWORK_OUTGOING, conditions );
+		const std::vector< int > values = SendAndReceive( pair.conditioner, pair.b, 1000, TRANSPORT_UNRELIABLE );
+		test_assert( values.size() > 620 && values.size() < 780 );
+		test_assert( pair.conditioner.GetStats( NETWORK_OUTGOING ).lost == 1000 - values.size() );
+
+		ConditionedPair same( 1234 );
+		same.conditioner.SetConditions( NETWORK_OUTGOING, conditions );
+		test_assert( SendAndReceive( same.conditioner, same.b, 1000, TRANSPORT_UNRELIABLE ) == values );
+
+		ConditionedPair other( 4321 );
+		other.conditioner.SetConditions( NETWORK_OUTGOING, conditions );
+		test_assert( SendAndReceive( other.conditioner, other.b, 1000, TRANSPORT_UNRELIABLE ) != values );
+
+		// the reliable ones are resent, in order
+		pair.conditioner.SetSeed( 1234 );
+		const std::vector< int > reliable = SendAndReceive( pair.conditioner, pair.b, 1000, TRANSPORT_RELIABLE_ORDERED );
+		test_assert( reliable.size() == 1000 );
+		test_assert( CountOutOfOrder( reliable ) == 0 );
+		test_assert( pair.conditioner.GetStats( NETWORK_OUTGOING ).resent == 1000 - values.size() );
+	}
+
+	// the losses come in bursts
+	{
+		ConditionedPair pair;
+		NetworkConditions conditions;
+		conditions.burst_chance = 0.02f;
+		conditions.burst_length = 5;
+		pair.conditioner.SetConditions( NETWORK_OUTGOING, conditions );
+
+		const std::vector< int > values = SendAndReceive( pair.conditioner, pair.b, 10000, TRANSPORT_UNRELIABLE );
+		int bursts = 0;
+		for( std::size_t i = 1; i < values.size(); ++i )
+		{
+			if( values[ i ] != values[ i - 1 ] + 1 )
+				++bursts;
+		}
+
+		const NetworkConditionerStats stats = pair.conditioner.GetStats( NETWORK_OUTGOING );
+		test_assert( stats.lost == 0 );
+		test_assert( stats.lost_in_burst == 10000 - values.size() );
+		test_assert( bursts > 50 );
+		const double average_length = (double)stats.lost_in_burst / bursts;
+		test_assert( average_length > 3.5 && average_length < 7 );
+	}
+
+	// duplicates and reordering, only the unreliable ones
+	{
+		ConditionedPair pair;
+		NetworkConditions conditions;
+		conditions.latency = 5;
+		conditions.duplicate = 0.25f;
+		conditions.reorder = 0.1f;
+		conditions.reorder_delay = 10;
+		pair.conditioner.SetConditions( NETWORK_OUTGOING, conditions );
+
+		const std::vector< int > values = SendAndReceive( pair.conditioner, pair.b, 1000, TRANSPORT_UNRELIABLE );
+		const NetworkConditionerStats stats = pair.conditioner.GetStats( NETWORK_OUTGOING );
+		test_assert( values.size() == 1000 + stats.duplicated );
+		test_assert( stats.duplicated > 180 && stats.duplicated < 320 );
+		test_assert( stats.reordered > 60 && stats.reordered < 140 );
+		test_assert( CountOutOfOrder( values ) > 60 );
+
+		const std::vector< int > ordered = SendAndReceive( pair.conditioner, pair.b, 1000, TRANSPORT_RELIABLE_ORDERED );
+		test_assert( ordered.size() == 1000 );
+		test_assert( CountOutOfOrder( ordered ) == 0 );
+	}
+
+	// bandwidth and the queue
+	{
+		ConditionedPair pair;
+		NetworkConditions conditions;
+		conditions.bandwidth = 10000;
+		conditions.queue_size = 500;
+		pair.conditioner.SetConditions( NETWORK_OUTGOING, conditions );
+
+		// 100 bytes take 10 ms, 5 of them fit in the queue
+		for( int i = 0; i < 10; ++i )
+			SendValue( &pair.conditioner, i, pair.b->GetLocalAddress(), TRANSPORT_UNRELIABLE, 100 );
+
+		NetworkConditionerStats stats = pair.conditioner.GetStats( NETWORK_OUTGOING );
+		test_assert( stats.queue_drops == 5 );
+		test_assert( stats.max_queue_bytes == 500 );
+
+		fake_time += 30;
+		pair.conditioner.Update();
+		test_assert( ReceiveValues( pair.b ).size() == 3 );
+		fake_time += 20;
+		pair.conditioner.Update();
+		test_assert( ReceiveValues( pair.b ).size() == 2 );
+
+		// the reliable ones wait in the queue
+		for( int i = 0; i < 10; ++i )
+			SendValue( &pair.conditioner, i, pair.b->GetLocalAddress(), TRANSPORT_RELIABLE, 100 );
+		fake_time += 100;
+		pair.conditioner.Update();
+		test_assert( ReceiveValues( pair.b ).size() == 10 );
+	}
+
+	// every peer can have its own conditions
+	{
+		ConditionedPair pair;
+		CLoopbackTransport* c = pair.network.CreateTransport();
+		pair.a->Connect( c->GetLocalAddress() );
+		ReceiveValues( &pair.conditioner );
+		ReceiveValues( c );
+
+		NetworkConditions conditions;
+		conditions.latency = 100;
+		pair.conditioner.SetConditions( NETWORK_OUTGOING, c->GetLocalAddress(), conditions );
+		test_assert( pair.conditioner.GetConditions( NETWORK_OUTGOING, c->GetLocalAddress() ).latency == 100 );
+		test_assert( pair.conditioner.GetConditions( NETWORK_OUTGOING, pair.b->GetLocalAddress() ).latency == 0 );
+
+		// to everyone
+		test_assert( pair.conditioner.Send( (const unsigned char*)"abcd", 4, UNASSIGNED_TRANSPORT_ADDRESS, true, TRANSPORT_RELIABLE, 0, TRANSPORT_PRIORITY_HIGH ) );
+		test_assert( ReceiveValues( pair.b ).size() == 1 );
+		test_assert( ReceiveValues( c ).empty() );
+		fake_time += 100;
+		pair.conditioner.Update();
+		test_assert( ReceiveValues( c ).size() == 1 );
+
+		pair.conditioner.ClearConditions( c->GetLocalAddress() );
+		test_assert( SendValue( &pair.conditioner, 1, c->GetLocalAddress() ) );
+		test_assert( ReceiveValues( c ).size() == 1 );
+
+		delete c;
+	}
+
+	// on the way in, what was held back is lost with the connection
+	{
+		ConditionedPair pair;
+		NetworkConditions conditions;
+		conditions.latency = 20;
+		pair.conditioner.SetConditions( NETWORK_INCOMING, conditions );
+
+		SendValue( pair.b, 1, pair.a->GetLocalAddress() );
+		test_assert( ReceiveValues( &pair.conditioner ).empty() );
+		fake_time += 20;
+		test_assert( ReceiveValues( &pair.conditioner ).size() == 1 );
+
+		SendValue( pair.b, 2, pair.a->GetLocalAddress() );
+		test_assert( ReceiveValues( &pair.conditioner ).empty() );
+		pair.b->Disconnect( pair.a->GetLocalAddress() );
+		test_assert( ReceiveValues( &pair.conditioner ).empty() );
+		fake_time += 20;
+		test_assert( ReceiveValues( &pair.conditioner ).empty() );
+		test_assert( pair.conditioner.GetPendingCount() == 0 );
+		test_assert( pair.conditioner.GetStats( NETWORK_INCOMING ).delivered == 1 );
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( NetworkConditionerTest );
+
+} // end of namespace test
+
+#endif
@@ -0,0 +1,417 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include <sstream>
+
+#include <SDL.h>
+
+#include "../../../utils/debug.h"
+#include "../../../tester/tester_benchmark.h"
+#include "../igamemessage.h"
+#include "../igamemessagefactory.h"
+#include "../multiplayer_config.h"
+#include "../network_peer.h"
+#include "../transport_loopback.h"
+#include "../transport_udp.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	enum { BENCH_MESSAGE_ID = 100 };
+
+	const int bench_clients = 4;
+	const int bench_messages_per_tick = 100;
+	const int bench_ticks = 200;
+	const int bench_round_trips = 2000;
+	const int bench_updates_per_tick = 200;
+	const int bench_decode_datagrams = 2000;
+
+	// so the udp runs can't hang if something gets lost
+	const double bench_timeout = 5.0;
+	const double bench_idle_timeout = 0.1;
+
+	struct BenchCounters
+	{
+		BenchCounters() : received( 0 ) { }
+		int received;
+	};
+
+	// about the size of a unit position update, the server answers the
+	// ones that ask for it
+	class CBenchMessage : public IGameMessage
+	{
+	public:
+		CBenchMessage( bool echo = false, TransportDelivery delivery = TRANSPORT_RELIABLE ) :
+			mId( 1234 ),
+			mX( 1.5f ),
+			mY( -2.5f ),
+			mEcho( echo ),
+			mDelivery( delivery )
+		{
+		}
+
+		int GetType() const { return BENCH_MESSAGE_ID; }
+		bool IsPooled() const { return true; }
+		TransportDelivery GetDelivery() const { return mDelivery; }
+
+		void BitSerialize( network_utils::ISerializer* serializer )
+		{
+			serializer->IO( mId );
+			serializer->IO( mX );
+			serializer->IO( mY );
+			serializer->IO( mEcho );
+		}
+
+		void HandleServer( IPacketHandler* packet_handler )
+		{
+			static_cast< BenchCounters* >( packet_handler->GetUserData() )->received++;
+			if( mEcho )
+				packet_handler->SendGameMessage( new CBenchMessage );
+		}
+
+		void HandleClient( IPacketHandler* packet_handler )
+		{
+			static_cast< BenchCounters* >( packet_handler->GetUserData() )->received++;
+		}
+
+		network_utils::uint32	mId;
+		network_utils::float32	mX;
+		network_utils::float32	mY;
+		bool					mEcho;
+		TransportDelivery		mDelivery;
+	};
+
+	class CBenchMessageFactory : public IGameMessageFactory
+	{
+	public:
+		IGameMessage* GetNewMessage( int type ) { return ( type == BENCH_MESSAGE_ID ) ? new CBenchMessage : NULL; }
+		int GetGameMessageID_First() const { return BENCH_MESSAGE_ID; }
+		int GetGameMessageID_Last() const { return BENCH_MESSAGE_ID; }
+	};
+
+	//-------------------------------------------------------------------------
+
+	// a server and its clients, all connected and updated from this thread
+	class CBenchSession
+	{
+	public:
+		CBenchSession( bool udp, int client_count ) :
+			mUdp( udp ),
+			mServerTransport( NULL ),
+			mServer( NULL ),
+			mClientCount( client_count )
+		{
+			mServerTransport = CreateTransport( SERVER_PORT );
+			mServer = new CNetworkPeer( true, mServerTransport, new CBenchMessageFactory );
+			mServer->SetUserData( &mServerCounters );
+
+			for( int i = 0; i < mClientCount; ++i )
+			{
+				mClientTransports[ i ] = CreateTransport( 0 );
+				mClients[ i ] = new CNetworkPeer( false, mClientTransports[ i ], new CBenchMessageFactory );
+				mClients[ i ]->SetUserData( &mClientCounters[ i ] );
+
+				if( mUdp )
+					static_cast< CUdpTransport* >( mClientTransports[ i ] )->Connect( mServerTransport->GetLocalAddress() );
+				else
+					static_cast< CLoopbackTransport* >( mClientTransports[ i ] )->Connect( mServerTransport->GetLocalAddress() );
+			}
+
+			poro::tester::CBenchmarkTimer timer;
+			while( IsConnected() == false && timer.GetSeconds() < bench_timeout )
+				UpdateAll();
+		}
+
+		~CBenchSession()
+		{
+			for( int i = 0; i < mClientCount; ++i )
+			{
+				delete mClients[ i ];
+				delete mClientTransports[ i ];
+			}
+			delete mServer;
+			delete mServerTransport;
+		}
+
+		bool IsConnected() const
+		{
+			for( int i = 0; i < mClientCount; ++i )
+			{
+				if( mClientTransports[ i ]->GetConnectionCount() == 0 )
+					return false;
+			}
+			return mServerTransport->GetConnectionCount() == mClientCount;
+		}
+
+		void UpdateAll()
+		{
+			for( int i = 0; i < mClientCount; ++i )
+				mClients[ i ]->Update();
+			mServer->Update();
+		}
+
+		// until the count gets there or nothing has come in for a while
+		void WaitFor( const int& count, int total )
+		{
+			poro::tester::CBenchmarkTimer idle;
+			int last = count;
+			while( count < total && idle.GetSeconds() < bench_idle_timeout )
+			{
+				UpdateAll();
+				if( count != last )
+				{
+					last = count;
+					idle.Reset();
+				}
+			}
+		}
+
+		void WaitForClients( int total )
+		{
+			poro::tester::CBenchmarkTimer idle;
+			int last = GetClientsReceived();
+			while( last < total && idle.GetSeconds() < bench_idle_timeout )
+			{
+				UpdateAll();
+				if( GetClientsReceived() != last )
+				{
+					last = GetClientsReceived();
+					idle.Reset();
+				}
+			}
+		}
+
+		int GetClientsReceived() const
+		{
+			int result = 0;
+			for( int i = 0; i < mClientCount; ++i )
+				result += mClientCounters[ i ].received;
+			return result;
+		}
+
+		bool						mUdp;
+		CLoopbackNetwork			mNetwork;
+		ITransport*					mServerTransport;
+		CNetworkPeer*				mServer;
+		BenchCounters				mServerCounters;
+		int							mClientCount;
+		ITransport*					mClientTransports[ bench_clients ];
+		CNetworkPeer*				mClients[ bench_clients ];
+		BenchCounters				mClientCounters[ bench_clients ];
+
+	private:
+		ITransport* CreateTransport( unsigned short port )
+		{
+			if( mUdp )
+				return new CUdpTransport( 0 );
+			return mNetwork.CreateTransport( port );
+		}
+	};
+
+	//-------------------------------------------------------------------------
+
+	void RunTransportBenchmark( bool udp )
+	{
+		const char* name = udp ? "udp" : "loopback";
+
+		// clients to the server
+		{
+			CBenchSession session( udp, bench_clients );
+			if( session.IsConnected() == false )
+			{
+				test_logger << "  " << name << ": couldn't connect, skipped" << std::endl;
+				return;
+			}
+
+			const int total = bench_clients * bench_messages_per_tick * bench_ticks;
+			poro::tester::CBenchmarkTimer timer;
+			for( int tick = 0; tick < bench_ticks; ++tick )
+			{
+				for( int i = 0; i < bench_clients; ++i )
+				{
+					for( int j = 0; j < bench_messages_per_tick; ++j )
+						session.mClients[ i ]->GetPacketHandlerForGame()->SendGameMessage( new CBenchMessage );
+				}
+				session.UpdateAll();
+			}
+			session.WaitFor( session.mServerCounters.received, total );
+
+			std::stringstream ss;
+			ss << name << ", " << bench_clients << " clients to server, " << session.mServerCounters.received << " / " << total << " messages";
+			poro::tester::BenchmarkReport( ss.str(), timer.GetSeconds(), session.mServerCounters.received );
+		}
+
+		// server broadcasting to the clients
+		{
+			CBenchSession session( udp, bench_clients );
+			if( session.IsConnected() == false )
+				return;
+
+			const int total = bench_clients * bench_messages_per_tick * bench_ticks;
+			poro::tester::CBenchmarkTimer timer;
+			for( int tick = 0; tick < bench_ticks; ++tick )
+			{
+				for( int j = 0; j < bench_messages_per_tick; ++j )
+					session.mServer->GetPacketHandlerForGame()->SendGameMessage( new CBenchMessage );
+				session.UpdateAll();
+			}
+			session.WaitForClients( total );
+
+			std::stringstream ss;
+			ss << name << ", server to " << bench_clients << " clients, " << session.GetClientsReceived() << " / " << total << " messages";
+			poro::tester::BenchmarkReport( ss.str(), timer.GetSeconds(), session.GetClientsReceived() );
+		}
+
+		// round trips, the time from the game sending the message to the
+		// answer being handled
+		{
+			CBenchSession session( udp, 1 );
+			if( session.IsConnected() == false )
+				return;
+
+			CNetworkPeer* client = session.mClients[ 0 ];
+			int round_trips = 0;
+			poro::tester::CBenchmarkTimer timer;
+			for( ; round_trips < bench_round_trips && timer.GetSeconds() < bench_timeout; ++round_trips )
+			{
+				const int received = session.mClientCounters[ 0 ].received;
+				client->GetPacketHandlerForGame()->SendGameMessage( new CBenchMessage( true ) );
+				while( session.mClientCounters[ 0 ].received == received && timer.GetSeconds() < bench_timeout )
+					session.UpdateAll();
+			}
+
+			std::stringstream ss;
+			ss << name << ", round trips";
+			poro::tester::BenchmarkReport( ss.str(), timer.GetSeconds(), round_trips );
+		}
+	}
+
+	// the server sending the position updates of a tick to everyone, one
+	// packet per message the way it used to be and packed in datagrams
+	void RunCoalescingBenchmark( bool coalesce )
+	{
+		CBenchSession session( false, bench_clients );
+		session.mServer->SetCoalescing( coalesce );
+
+		const TransportDelivery delivery = coalesce ? TRANSPORT_UNRELIABLE : TRANSPORT_RELIABLE;
+		const unsigned int packets_before = session.mNetwork.GetPacketsSent();
+		const unsigned int bytes_before = session.mNetwork.GetBytesSent();
+
+		poro::tester::CBenchmarkTimer timer;
+		for( int tick = 0; tick < bench_ticks; ++tick )
+		{
+			for( int j = 0; j < bench_updates_per_tick; ++j )
+				session.mServer->GetPacketHandlerForGame()->SendGameMessage( new CBenchMessage( false, delivery ) );
+			session.UpdateAll();
+		}
+		session.UpdateAll();
+
+		const int total = bench_clients * bench_updates_per_tick * bench_ticks;
+		const unsigned int packets = session.mNetwork.GetPacketsSent() - packets_before;
+		const unsigned int bytes = session.mNetwork.GetBytesSent() - bytes_before;
+
+		std::stringstream ss;
+		ss << ( coalesce ? "coalesced, unreliable" : "one packet per message, reliable" ) << ", " << session.GetClientsReceived() << " / " << total << " messages";
+		poro::tester::BenchmarkReport( ss.str(), timer.GetSeconds(), session.GetClientsReceived() );
+
+		// 28 bytes of IP and UDP headers for each packet, RakNet adds its own
+		test_logger << "    packets: " << packets << ", bytes: " << bytes << ", with IP/UDP headers: " << ( bytes + packets * 28 ) << std::endl;
+	}
+
+	// Only the receiving end: datagrams full of messages are waiting for the
+	// server and the time is its Update() handling them all.
+	void RunDecodeBenchmark( bool pooled )
+	{
+		CLoopbackNetwork network;
+		CLoopbackTransport* server_transport = network.CreateTransport( SERVER_PORT );
+		CLoopbackTransport* raw = network.CreateTransport();
+		raw->Connect( server_transport->GetLocalAddress() );
+
+		CNetworkPeer* server = new CNetworkPeer( true, server_transport, new CBenchMessageFactory );
+		BenchCounters counters;
+		server->SetUserData( &counters );
+		server->Update();
+		if( pooled == false )
+			server->GetMessageFactory()->SetMaxPooledMessages( 0 );
+
+		network_utils::types::ustring datagram;
+		datagram += (char)GAME_MESSAGE_BATCH_ID;
+		int messages_per_datagram = 0;
+		for( ; datagram.size() < 1200 - 20; ++messages_per_datagram )
+		{
+			CBenchMessage message;
+			network_utils::CSerialSaver saver;
+			message.BitSerialize( &saver );
+			datagram += (char)message.GetType();
+			datagram += network_utils::ConvertUint32ToHex( (network_utils::uint32)saver.GetData().size() );
+			datagram += saver.GetData();
+		}
+
+		for( int i = 0; i < bench_decode_datagrams; ++i )
+			raw->Send( (const unsigned char*)datagram.data(), (unsigned int)datagram.size(), UNASSIGNED_TRANSPORT_ADDRESS, false, TRANSPORT_UNRELIABLE, 0, TRANSPORT_PRIORITY_HIGH );
+
+		poro::tester::CBenchmarkTimer timer;
+		server->Update();
+		const double seconds = timer.GetSeconds();
+
+		std::stringstream ss;
+		ss << ( pooled ? "pooled messages" : "new messages" ) << ", " << counters.received << " / " << bench_decode_datagrams * messages_per_datagram;
+		poro::tester::BenchmarkReport( ss.str(), seconds, counters.received );
+		if( seconds > 0 )
+			test_logger << "    " << (int)( counters.received / seconds ) << " messages per second" << std::endl;
+
+		delete server;
+		delete raw;
+		delete server_transport;
+	}
+
+}
+
+//-----------------------------------------------------------------------------
+
+int NetworkPeerBenchmark()
+{
+	test_logger << "CNetworkPeer messages through SendMessageImpl and HandleGamePackets" << std::endl;
+
+	RunTransportBenchmark( false );
+	RunTransportBenchmark( true );
+
+	test_logger << bench_updates_per_tick << " position updates a tick from the server to " << bench_clients << " clients, loopback" << std::endl;
+	RunCoalescingBenchmark( false );
+	RunCoalescingBenchmark( true );
+
+	test_logger << "Decoding batched messages in HandleGamePackets, loopback" << std::endl;
+	RunDecodeBenchmark( false );
+	RunDecodeBenchmark( true );
+
+	return 0;
+}
+
+BENCHMARK_REGISTER( NetworkPeerBenchmark );
+
+} // end of namespace test
+
+#endif
@@ -0,0 +1,637 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include <algorithm>
+#include <vector>
+
+#include <SDL.h>
+
+#include "../../../utils/debug.h"
+#include "../igamemessage.h"
+#include "../igamemessagefactory.h"
+#include "../multiplayer_config.h"
+#include "../network_conditioner.h"
+#include "../network_peer.h"
+#include "../transport_loopback.h"
+#include "../transport_udp.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	enum { TEST_MESSAGE_ID = 100 };
+
+	struct TestLog
+	{
+		std::vector< int > values;
+		std::vector< int > teams;
+	};
+
+	// the server echoes every value + 1 to everyone
+	class CTestMessage : public IGameMessage
+	{
+	public:
+		CTestMessage( int value = 0, TransportDelivery delivery = TRANSPORT_RELIABLE, bool important = false ) :
+			mValue( value ),
+			mDelivery( delivery ),
+			mImportant( important )
+		{
+		}
+
+		int GetType() const { return TEST_MESSAGE_ID; }
+		bool IsPooled() const { return true; }
+		bool IsImportant() const { return mImportant; }
+		TransportDelivery GetDelivery() const { return mDelivery; }
+
+		void BitSerialize( network_utils::ISerializer* serializer )
+		{
+			serializer->IO( mValue );
+		}
+
+		void HandleServer( IPacketHandler* packet_handler )
+		{
+			TestLog* log = static_cast< TestLog* >( packet_handler->GetUserData() );
+			log->values.push_back( mValue );
+			log->teams.push_back( packet_handler->GetCurrentPacketAddress()->mTeam );
+
+			packet_handler->SendGameMessage( new CTestMessage( mValue + 1 ) );
+		}
+
+		void HandleClient( IPacketHandler* packet_handler )
+		{
+			TestLog* log = static_cast< TestLog* >( packet_handler->GetUserData() );
+			log->values.push_back( mValue );
+		}
+
+		network_utils::int32	mValue;
+		TransportDelivery		mDelivery;
+		bool					mImportant;
+	};
+
+	class CTestMessageFactory : public IGameMessageFactory
+	{
+	public:
+		IGameMessage* GetNewMessage( int type )
+		{
+			if( type == TEST_MESSAGE_ID )
+				return new CTestMessage;
+			return NULL;
+		}
+
+		int GetGameMessageID_First() const { return TEST_MESSAGE_ID; }
+		int GetGameMessageID_Last() const { return TEST_MESSAGE_ID; }
+	};
+
+	int SendBufferedFromThread( void* data )
+	{
+		CNetworkPeer* peer = (CNetworkPeer*)data;
+		peer->GetPacketHandler()->GetBufferedPacketHandler( 10 )->SendGameMessage( new CTestMessage( 22 ) );
+		return 0;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int NetworkPeerTest()
+{
+	const TransportAddress server_address = TransportAddress::FromIP( 127, 0, 0, 1, SERVER_PORT );
+
+	// addresses
+	{
+		test_assert( UNASSIGNED_TRANSPORT_ADDRESS.IsUnassigned() );
+		test_assert( server_address.IsUnassigned() == false );
+		test_assert( server_address.ToString() == "127.0.0.1:60123" );
+		test_assert( server_address != TransportAddress::FromIP( 127, 0, 0, 1, SERVER_PORT + 1 ) );
+	}
+
+	// the players, their slots and teams
+	{
+		CServerManagement players;
+		std::vector< TransportAddress > addresses;
+		for( int i = 0; i < 300; ++i )
+			addresses.push_back( TransportAddress::FromIP( 10, 0, (unsigned char)( i / 100 ), 1, (unsigned short)( 1000 + i ) ) );
+
+		for( int i = 0; i < 300; ++i )
+			players.GetPlayerForAddress( addresses[ i ] );
+
+		test_assert( players.GetPlayerCount() == 300 );
+		test_assert( players.GetPlayers().size() == 300 );
+		test_assert( players.mPlayers[ 3 ]->mTeam == TEAM_4 );
+		test_assert( players.mPlayers[ 4 ]->mTeam == TEAM_UNKNOWN );
+		test_assert( players.GetTeamSize( TEAM_UNKNOWN ) == 296 );
+		test_assert( players.GetPlayerForAddress( addresses[ 123 ] ) == players.mPlayers[ 123 ] );
+		test_assert( players.FindPlayer( TransportAddress::FromIP( 10, 0, 0, 2, 1000 ) ) == NULL );
+		test_assert( players.GetPlayerCount() == 300 );
+
+		// the lowest free slot is taken first
+		players.PlayerDroppedOut( addresses[ 200 ] );
+		players.PlayerDroppedOut( addresses[ 7 ] );
+		players.PlayerDroppedOut( addresses[ 2 ] );
+		players.PlayerDroppedOut( addresses[ 2 ] );
+		test_assert( players.GetPlayerCount() == 297 );
+		test_assert( players.mPlayers[ 7 ] == NULL );
+		test_assert( players.FindPlayer( addresses[ 7 ] ) == NULL );
+		test_assert( players.FindPlayer( addresses[ 299 ] ) == players.mPlayers[ 299 ] );
+
+		for( std::size_t i = 0; i < players.GetPlayers().size(); ++i )
+			test_assert( players.GetPlayers()[ i ] != NULL );
+
+		const TransportAddress newcomer = TransportAddress::FromIP( 10, 1, 0, 1, 5 );
+		test_assert( players.NewConnection( newcomer ) == players.mPlayers[ 2 ] );
+		test_assert( players.mPlayers[ 2 ]->mTeam == TEAM_3 );
+		players.NewConnection( addresses[ 7 ] );
+		players.NewConnection( addresses[ 200 ] );
+		test_assert( players.FindPlayer( addresses[ 200 ] ) == players.mPlayers[ 200 ] );
+		test_assert( players.GetPlayerCount() == 300 );
+		test_assert( players.mPlayers.size() == 300 );
+
+		// the other policies
+		CServerManagement round_robin;
+		round_robin.SetTeamPolicy( new CRoundRobinTeamPolicy( 3 ) );
+		for( int i = 0; i < 7; ++i )
+			round_robin.NewConnection( addresses[ i ] );
+		test_assert( round_robin.mPlayers[ 5 ]->mTeam == TEAM_3 );
+		test_assert( round_robin.mPlayers[ 6 ]->mTeam == TEAM_1 );
+		test_assert( round_robin.GetTeamSize( TEAM_1 ) == 3 );
+
+		CServerManagement balanced;
+		balanced.SetTeamPolicy( new CBalancedTeamPolicy( 2 ) );
+		for( int i = 0; i < 6; ++i )
+			balanced.NewConnection( addresses[ i ] );
+		test_assert( balanced.GetTeamSize( TEAM_1 ) == 3 && balanced.GetTeamSize( TEAM_2 ) == 3 );
+		balanced.PlayerDroppedOut( addresses[ 1 ] );
+		balanced.PlayerDroppedOut( addresses[ 3 ] );
+		test_assert( balanced.GetTeamSize( TEAM_2 ) == 1 );
+		test_assert( balanced.NewConnection( addresses[ 10 ] )->mTeam == TEAM_2 );
+		test_assert( balanced.NewConnection( addresses[ 11 ] )->mTeam == TEAM_2 );
+		test_assert( balanced.NewConnection( addresses[ 12 ] )->mTeam == TEAM_1 );
+	}
+
+	// the factory's free lists
+	{
+		CTestMessageFactory factory;
+		IGameMessage* message = factory.GetPooledMessage( TEST_MESSAGE_ID );
+		test_assert( message );
+		test_assert( factory.GetPooledMessage( TEST_MESSAGE_ID + 1 ) == NULL );
+
+		factory.ReleaseMessage( message );
+		test_assert( factory.GetPooledMessageCount() == 1 );
+		test_assert( factory.GetPooledMessage( TEST_MESSAGE_ID ) == message );
+		test_assert( factory.GetPooledMessageCount() == 0 );
+
+		factory.SetMaxPooledMessages( 2 );
+		factory.ReleaseMessage( message );
+		factory.ReleaseMessage( new CTestMessage );
+		factory.ReleaseMessage( new CTestMessage );
+		test_assert( factory.GetPooledMessageCount() == 2 );
+
+		factory.SetMaxPooledMessages( 0 );
+		test_assert( factory.GetPooledMessageCount() == 0 );
+	}
+
+	// the messages are still laid out the way RakNet's BitStream wrote them,
+	// but they're packed in batches
+	{
+		CLoopbackNetwork network;
+		CLoopbackTransport* server_transport = network.CreateTransport( SERVER_PORT );
+		CLoopbackTransport* raw = network.CreateTransport();
+		test_assert( network.CreateTransport( SERVER_PORT ) == NULL );
+		test_assert( raw->Connect( server_address ) );
+
+		{
+			CNetworkPeer server( true, server_transport, new CTestMessageFactory );
+			TestLog log;
+			server.SetUserData( &log );
+			server.GetPacketHandler()->SendGameMessage( new CTestMessage( 0x01020304 ) );
+
+			TransportPacket* packet = raw->Receive();
+			test_assert( packet && packet->mEvent == TRANSPORT_CONNECTED );
+			raw->DeallocatePacket( packet );
+
+			// queued until the end of the tick
+			test_assert( raw->Receive() == NULL );
+			server.FlushMessages();
+
+			packet = raw->Receive();
+			test_assert( packet && packet->mEvent == TRANSPORT_DATA );
+			test_assert( packet->mLength == 10 );
+			const unsigned char expected[] = { GAME_MESSAGE_BATCH_ID, TEST_MESSAGE_ID, 0, 0, 0, 4, 1, 2, 3, 4 };
+			for( int i = 0; i < 10; ++i )
+				test_assert( packet->mData[ i ] == expected[ i ] );
+
+			// and back, as a batch and as a message of its own
+			raw->Send( packet->mData, packet->mLength, server_address, false, TRANSPORT_RELIABLE, 0, TRANSPORT_PRIORITY_HIGH );
+			raw->Send( packet->mData + 1, packet->mLength - 1, server_address, false, TRANSPORT_RELIABLE, 0, TRANSPORT_PRIORITY_HIGH );
+			raw->DeallocatePacket( packet );
+
+			server.Update();
+			test_assert( log.values.size() == 2 && log.values[ 0 ] == 0x01020304 && log.values[ 1 ] == 0x01020304 );
+			test_assert( server.GetServerManagement().GetPlayerCount() == 1 );
+			test_assert( server.GetStats().messages_received == 2 );
+			test_assert( server.GetStats().packets_received == 2 );
+			test_assert( server.GetStats().bytes_received == 19 );
+
+			// the two echoes went out together
+			test_assert( server.GetStats().messages_sent == 3 );
+			test_assert( server.GetStats().packets_sent == 2 );
+		}
+
+		delete raw;
+		delete server_transport;
+
+		test_assert( network.GetPacketsSent() == 4 );
+	}
+
+	// broken packets from a remote peer are counted and dropped
+	{
+		CLoopbackNetwork network;
+		CLoopbackTransport* server_transport = network.CreateTransport( SERVER_PORT );
+		CLoopbackTransport* raw = network.CreateTransport();
+		test_assert( raw->Connect( server_address ) );
+
+		{
+			CNetworkPeer server( true, server_transport, new CTestMessageFactory );
+			TestLog log;
+			server.SetUserData( &log );
+
+			// says 4 bytes but has 2
+			const unsigned char short_packet[] = { TEST_MESSAGE_ID, 0, 0, 0, 4, 1, 2 };
+			raw->Send( short_packet, sizeof( short_packet ), server_address, false, TRANSPORT_RELIABLE, 0, TRANSPORT_PRIORITY_HIGH );
+
+			// the first message is fine, the second runs past the end
+			const unsigned char broken_batch[] = { GAME_MESSAGE_BATCH_ID, TEST_MESSAGE_ID, 0, 0, 0, 4, 0, 0, 0, 7, TEST_MESSAGE_ID, 0, 0, 0, 9, 1 };
+			raw->Send( broken_batch, sizeof( broken_batch ), server_address, false, TRANSPORT_RELIABLE, 0, TRANSPORT_PRIORITY_HIGH );
+
+			// and just a batch id with half a header
+			const unsigned char broken_header[] = { GAME_MESSAGE_BATCH_ID, TEST_MESSAGE_ID, 0 };
+			raw->Send( broken_header, sizeof( broken_header ), server_address, false, TRANSPORT_RELIABLE, 0, TRANSPORT_PRIORITY_HIGH );
+
+			server.Update();
+			test_assert( log.values.size() == 1 && log.values[ 0 ] == 7 );
+			test_assert( server.GetStats().packets_received == 3 );
+			test_assert( server.GetStats().broken_packets == 3 );
+			test_assert( server.GetServerManagement().GetPlayerCount() == 1 );
+
+			// still works
+			const unsigned char good_packet[] = { TEST_MESSAGE_ID, 0, 0, 0, 4, 0, 0, 0, 8 };
+			raw->Send( good_packet, sizeof( good_packet ), server_address, false, TRANSPORT_RELIABLE, 0, TRANSPORT_PRIORITY_HIGH );
+			server.Update();
+			test_assert( log.values.size() == 2 && log.values[ 1 ] == 8 );
+			test_assert( server.GetStats().broken_packets == 3 );
+		}
+
+		delete raw;
+		delete server_transport;
+	}
+
+	// packing the messages of a tick
+	{
+		CLoopbackNetwork network;
+		CLoopbackTransport* server_transport = network.CreateTransport( SERVER_PORT );
+		CLoopbackTransport* client_transport = network.CreateTransport();
+		client_transport->Connect( server_address );
+
+		CNetworkPeer* server = new CNetworkPeer( true, server_transport, new CTestMessageFactory );
+		CNetworkPeer* client = new CNetworkPeer( false, client_transport, new CTestMessageFactory );
+		TestLog server_log;
+		TestLog client_log;
+		server->SetUserData( &server_log );
+		client->SetUserData( &client_log );
+		server->Update();
+		client->Update();
+
+		// 9 bytes a message, 133 of them fit in 1200 bytes
+		unsigned int packets_before = network.GetPacketsSent();
+		for( int i = 0; i < 200; ++i )
+			server->GetPacketHandlerForGame()->SendGameMessage( new CTestMessage( i, TRANSPORT_UNRELIABLE ) );
+		server->Update();
+		test_assert( network.GetPacketsSent() - packets_before == 2 );
+
+		client->Update();
+		test_assert( client_log.values.size() == 200 );
+		for( int i = 0; i < 200; ++i )
+			test_assert( client_log.values[ i ] == i );
+
+		// all of them were handled by the same message object
+		test_assert( client->GetMessageFactory()->GetPooledMessageCount() == 1 );
+
+		// smaller datagrams
+		server->SetMaxDatagramSize( 100 );
+		packets_before = network.GetPacketsSent();
+		for( int i = 0; i < 22; ++i )
+			server->GetPacketHandlerForGame()->SendGameMessage( new CTestMessage( i ) );
+		server->Update();
+		test_assert( network.GetPacketsSent() - packets_before == 2 );
+
+		// the deliveries don't mix
+		packets_before = network.GetPacketsSent();
+		server->GetPacketHandlerForGame()->SendGameMessage( new CTestMessage( 1, TRANSPORT_UNRELIABLE ) );
+		server->GetPacketHandlerForGame()->SendGameMessage( new CTestMessage( 2, TRANSPORT_UNRELIABLE_SEQUENCED ) );
+		server->GetPacketHandlerForGame()->SendGameMessage( new CTestMessage( 3, TRANSPORT_RELIABLE_ORDERED ) );
+		server->GetPacketHandlerForGame()->SendGameMessage( new CTestMessage( 4, TRANSPORT_UNRELIABLE ) );
+		server->Update();
+		test_assert( network.GetPacketsSent() - packets_before == 3 );
+
+		// an important one goes right away
+		packets_before = network.GetPacketsSent();
+		server->GetPacketHandler()->SendGameMessage( new CTestMessage( 5 ) );
+		server->GetPacketHandler()->SendGameMessage( new CTestMessage( 6, TRANSPORT_RELIABLE, true ) );
+		test_assert( network.GetPacketsSent() - packets_before == 1 );
+
+		// and the old way, every message on its own
+		server->SetCoalescing( false );
+		packets_before = network.GetPacketsSent();
+		for( int i = 0; i < 200; ++i )
+			server->GetPacketHandlerForGame()->SendGameMessage( new CTestMessage( i ) );
+		server->Update();
+		test_assert( network.GetPacketsSent() - packets_before == 200 );
+
+		client_log.values.clear();
+		client->Update();
+		test_assert( client_log.values.size() == 22 + 4 + 2 + 200 );
+		test_assert( client_log.values[ 22 + 4 ] == 5 && client_log.values[ 22 + 4 + 1 ] == 6 );
+		test_assert( client_log.values.back() == 199 );
+
+		delete client;
+		delete server;
+		delete client_transport;
+		delete server_transport;
+	}
+
+	// a server and three clients in one process
+	{
+		CLoopbackNetwork network;
+		CLoopbackTransport* server_transport = network.CreateTransport( SERVER_PORT );
+		CNetworkConditioner* server_conditioner = new CNetworkConditioner( server_transport );
+		CNetworkPeer* server = new CNetworkPeer( true, server_conditioner, new CTestMessageFactory );
+		TestLog server_log;
+		server->SetUserData( &server_log );
+
+		const int client_count = 3;
+		CLoopbackTransport* client_transports[ client_count ];
+		CNetworkPeer* clients[ client_count ];
+		TestLog client_logs[ client_count ];
+		for( int i = 0; i < client_count; ++i )
+		{
+			client_transports[ i ] = network.CreateTransport();
+			test_assert( client_transports[ i ]->Connect( server_address ) );
+			clients[ i ] = new CNetworkPeer( false, client_transports[ i ], new CTestMessageFactory );
+			clients[ i ]->SetUserData( &client_logs[ i ] );
+		}
+
+		server->Update();
+		test_assert( server_transport->GetConnectionCount() == client_count );
+		test_assert( server->GetServerManagement().GetPlayerCount() == client_count );
+		test_assert( server->GetServerManagement().mPlayers[ 0 ]->mTeam == TEAM_1 );
+		test_assert( server->GetServerManagement().mPlayers[ 2 ]->mTeam == TEAM_3 );
+
+		// through the game's buffered handler, the server echoes to everyone
+		clients[ 1 ]->GetPacketHandlerForGame()->SendGameMessage( new CTestMessage( 10 ) );
+		test_assert( server_log.values.empty() );
+		clients[ 1 ]->Update();
+		server->Update();
+		test_assert( server_log.values.size() == 1 && server_log.values[ 0 ] == 10 );
+		test_assert( server_log.teams[ 0 ] == TEAM_2 );
+
+		for( int i = 0; i < client_count; ++i )
+		{
+			clients[ i ]->Update();
+			test_assert( client_logs[ i ].values.size() == 1 && client_logs[ i ].values[ 0 ] == 11 );
+		}
+
+		// the buffered handler waits
+		server->GetPacketHandler()->GetBufferedPacketHandler( 20 )->SendGameMessage( new CTestMessage( 20 ) );
+		server->Update();
+		clients[ 0 ]->Update();
+		test_assert( client_logs[ 0 ].values.size() == 1 );
+		SDL_Delay( 30 );
+		server->Update();
+		clients[ 0 ]->Update();
+		test_assert( client_logs[ 0 ].values.size() == 2 && client_logs[ 0 ].values[ 1 ] == 20 );
+
+		// the ones that are due go in the order of their times, the same
+		// times in the order they were sent, even from another thread
+		server->GetPacketHandler()->GetBufferedPacketHandler( 10 )->SendGameMessage( new CTestMessage( 21 ) );
+		SDL_WaitThread( SDL_CreateThread( SendBufferedFromThread, server ), NULL );
+		server->GetPacketHandler()->GetBufferedPacketHandler( 0 )->SendGameMessage( new CTestMessage( 23 ) );
+		SDL_Delay( 20 );
+		server->Update();
+		clients[ 0 ]->Update();
+		test_assert( client_logs[ 0 ].values.size() == 5 );
+		test_assert( client_logs[ 0 ].values[ 2 ] == 23 );
+		test_assert( client_logs[ 0 ].values[ 3 ] == 21 );
+		test_assert( client_logs[ 0 ].values[ 4 ] == 22 );
+
+		// the conditioner holds the packets back
+		NetworkConditions lag;
+		lag.latency = 20;
+		server_conditioner->SetConditions( NETWORK_INCOMING, lag );
+		clients[ 2 ]->GetPacketHandlerForGame()->SendGameMessage( new CTestMessage( 30 ) );
+		clients[ 2 ]->Update();
+		server->Update();
+		test_assert( server_log.values.size() == 1 );
+		SDL_Delay( 30 );
+		server->Update();
+		test_assert( server_log.values.size() == 2 && server_log.values[ 1 ] == 30 );
+		test_assert( server_log.teams[ 1 ] == TEAM_3 );
+		test_assert( server_conditioner->GetStats( NETWORK_INCOMING, client_transports[ 2 ]->GetLocalAddress() ).delivered == 1 );
+		server_conditioner->Reset();
+
+		// serialized once for a team or a bunch of players
+		{
+			server->SendGameMessageToTeam( new CTestMessage( 50 ), TEAM_3 );
+
+			std::vector< PlayerAddress* > players;
+			players.push_back( server->GetServerManagement().mPlayers[ 0 ] );
+			players.push_back( server->GetServerManagement().mPlayers[ 1 ] );
+			server->SendGameMessageToPlayers( new CTestMessage( 51 ), players );
+			server->Update();
+
+			for( int i = 0; i < client_count; ++i )
+				clients[ i ]->Update();
+
+			// the third one still has the ones held back by the lag simulation
+			// coming, so only what it got matters
+			for( int i = 0; i < client_count; ++i )
+			{
+				const std::vector< int >& values = client_logs[ i ].values;
+				const bool got_50 = std::find( values.begin(), values.end(), 50 ) != values.end();
+				const bool got_51 = std::find( values.begin(), values.end(), 51 ) != values.end();
+				test_assert( got_50 == ( i == 2 ) );
+				test_assert( got_51 == ( i != 2 ) );
+			}
+		}
+
+		// dropping out frees the slot for the next one
+		delete clients[ 1 ];
+		delete client_transports[ 1 ];
+		server->Update();
+		test_assert( server->GetServerManagement().GetPlayerCount() == client_count - 1 );
+		test_assert( server->GetServerManagement().mPlayers[ 1 ] == NULL );
+
+		client_transports[ 1 ] = network.CreateTransport();
+		client_transports[ 1 ]->Connect( server_address );
+		clients[ 1 ] = new CNetworkPeer( false, client_transports[ 1 ], new CTestMessageFactory );
+		server->Update();
+		test_assert( server->GetServerManagement().mPlayers[ 1 ]->mTeam == TEAM_2 );
+
+		for( int i = 0; i < client_count; ++i )
+		{
+			delete clients[ i ];
+			delete client_transports[ i ];
+		}
+		delete server;
+		delete server_conditioner;
+		delete server_transport;
+	}
+
+	// the same over udp on localhost, if the sandbox lets us have sockets
+	{
+		CUdpTransport* server_transport = new CUdpTransport;
+		CUdpTransport* client_transport = new CUdpTransport;
+
+		if( server_transport->IsOpen() && client_transport->IsOpen() )
+		{
+			CNetworkPeer server( true, server_transport, new CTestMessageFactory );
+			CNetworkPeer client( false, client_transport, new CTestMessageFactory );
+			TestLog server_log;
+			TestLog client_log;
+			server.SetUserData( &server_log );
+			client.SetUserData( &client_log );
+
+			client_transport->Connect( server_transport->GetLocalAddress() );
+			for( int i = 0; i < 1000 && client_transport->GetConnectionCount() == 0; ++i )
+			{
+				client.Update();
+				server.Update();
+				SDL_Delay( 1 );
+			}
+			test_assert( client_transport->GetConnectionCount() == 1 );
+
+			client.GetPacketHandlerForGame()->SendGameMessage( new CTestMessage( 40 ) );
+			for( int i = 0; i < 1000 && client_log.values.empty(); ++i )
+			{
+				client.Update();
+				server.Update();
+				SDL_Delay( 1 );
+			}
+
+			test_assert( server.GetServerManagement().GetPlayerCount() == 1 );
+			test_assert( server_log.values.size() == 1 && server_log.values[ 0 ] == 40 );
+			test_assert( client_log.values.size() == 1 && client_log.values[ 0 ] == 41 );
+		}
+
+		delete client_transport;
+		delete server_transport;
+	}
+
+	// the threaded mode, the server's network thread hands the messages to
+	// this thread
+	{
+		CLoopbackNetwork network;
+		CLoopbackTransport* server_transport = network.CreateTransport();
+		CLoopbackTransport* client_transport = network.CreateTransport();
+		CNetworkPeer* server = new CNetworkPeer( true, server_transport, new CTestMessageFactory );
+		CNetworkPeer* client = new CNetworkPeer( false, client_transport, new CTestMessageFactory );
+		TestLog server_log;
+		TestLog client_log;
+		server->SetUserData( &server_log );
+		client->SetUserData( &client_log );
+
+		test_assert( client_transport->Connect( server_transport->GetLocalAddress() ) );
+		server->Update();
+
+		// room for 8 in the queue to the game
+		test_assert( server->StartThread( 8 ) );
+		test_assert( server->IsThreaded() );
+
+		for( int i = 0; i < 40; ++i )
+			client->GetPacketHandlerForGame()->SendGameMessage( new CTestMessage( i ) );
+		client->Update();
+
+		// nothing is handled before the game says so, the rest wait
+		for( int i = 0; i < 1000 && server->GetThreadStats().to_game_waits < 32; ++i )
+			SDL_Delay( 1 );
+
+		test_assert( server_log.values.empty() );
+		test_assert( server->GetThreadStats().to_game == 8 );
+		test_assert( server->GetThreadStats().to_game_waits == 32 );
+		test_assert( server->GetThreadStats().max_to_game == 8 );
+
+		for( int i = 0; i < 1000 && client_log.values.size() < 40; ++i )
+		{
+			server->HandleMessages();
+			client->Update();
+			SDL_Delay( 1 );
+		}
+
+		test_assert( server_log.values.size() == 40 );
+		test_assert( client_log.values.size() == 40 );
+		for( int i = 0; i < 40; ++i )
+		{
+			test_assert( server_log.values[ i ] == i );
+			test_assert( server_log.teams[ i ] == TEAM_1 );
+			test_assert( client_log.values[ i ] == i + 1 );
+		}
+
+		const NetworkThreadStats thread_stats = server->GetThreadStats();
+		test_assert( thread_stats.updates > 0 );
+		test_assert( thread_stats.to_game == 40 );
+		test_assert( thread_stats.to_network + thread_stats.to_network_waits >= 80 );
+
+		// what the game doesn't get to is dropped
+		client->GetPacketHandlerForGame()->SendGameMessage( new CTestMessage( 100 ) );
+		client->Update();
+		for( int i = 0; i < 1000 && server->GetThreadStats().to_game < 41; ++i )
+			SDL_Delay( 1 );
+
+		server->StopThread();
+		test_assert( server->IsThreaded() == false );
+		test_assert( server_log.values.size() == 40 );
+
+		// and the peer goes on without the thread
+		client->GetPacketHandlerForGame()->SendGameMessage( new CTestMessage( 200 ) );
+		client->Update();
+		server->Update();
+		client->Update();
+		test_assert( server_log.values.back() == 200 );
+		test_assert( client_log.values.back() == 201 );
+
+		// the destructor stops the thread
+		test_assert( server->StartThread() );
+		delete client;
+		delete server;
+		delete client_transport;
+		delete server_transport;
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( NetworkPeerTest );
+
+} // end of namespace test
+
+#endif
@@ -0,0 +1,189 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include <sstream>
+#include <vector>
+
+#include "../../../utils/debug.h"
+#include "../../../tester/tester_benchmark.h"
+#include "../igamemessage.h"
+#include "../igamemessagefactory.h"
+#include "../network_peer.h"
+#include "../network_stats.h"
+#include "../transport_loopback.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	enum { BENCH_MESSAGE_ID = 100 };
+
+	const int bench_clients = 32;
+	const int bench_ticks = 600;
+	const int bench_messages_per_tick = 10;
+	const int bench_calls = 1000000;
+
+	class CBenchMessage : public IGameMessage
+	{
+	public:
+		CBenchMessage() : mId( 1234 ), mX( 1.5f ), mY( -2.5f ) { }
+
+		int GetType() const { return BENCH_MESSAGE_ID; }
+		bool IsPooled() const { return true; }
+		TransportDelivery GetDelivery() const { return TRANSPORT_UNRELIABLE; }
+
+		void BitSerialize( network_utils::ISerializer* serializer )
+		{
+			serializer->IO( mId );
+			serializer->IO( mX );
+			serializer->IO( mY );
+		}
+
+		void HandleClient( IPacketHandler* /*packet_handler*/ ) { }
+
+		network_utils::uint32	mId;
+		network_utils::float32	mX;
+		network_utils::float32	mY;
+	};
+
+	class CBenchMessageFactory : public IGameMessageFactory
+	{
+	public:
+		IGameMessage* GetNewMessage( int type ) { return ( type == BENCH_MESSAGE_ID ) ? new CBenchMessage : NULL; }
+		int GetGameMessageID_First() const { return BENCH_MESSAGE_ID; }
+		int GetGameMessageID_Last() const { return BENCH_MESSAGE_ID; }
+	};
+
+	void SetupStats( CNetworkPeer* peer, bool enabled, unsigned int timing_interval )
+	{
+		peer->GetNetworkStats().SetEnabled( enabled );
+		peer->GetNetworkStats().SetTimingInterval( timing_interval );
+	}
+
+	// the server sends a bunch of unreliable updates to everyone every tick,
+	// the same soak as the conditioner benchmark
+	double RunSoak( bool enabled, unsigned int timing_interval )
+	{
+		CLoopbackNetwork network;
+		CLoopbackTransport* server_transport = network.CreateTransport();
+		CNetworkPeer* server = new CNetworkPeer( true, server_transport, new CBenchMessageFactory );
+		SetupStats( server, enabled, timing_interval );
+
+		std::vector< CLoopbackTransport* > client_transports;
+		std::vector< CNetworkPeer* > clients;
+		for( int i = 0; i < bench_clients; ++i )
+		{
+			client_transports.push_back( network.CreateTransport() );
+			client_transports.back()->Connect( server_transport->GetLocalAddress() );
+			clients.push_back( new CNetworkPeer( false, client_transports.back(), new CBenchMessageFactory ) );
+			SetupStats( clients.back(), enabled, timing_interval );
+		}
+
+		server->Update();
+
+		poro::tester::CBenchmarkTimer timer;
+		for( int tick = 0; tick < bench_ticks; ++tick )
+		{
+			for( int m = 0; m < bench_messages_per_tick; ++m )
+				server->GetPacketHandler()->SendGameMessage( new CBenchMessage );
+
+			server->Update();
+			for( int i = 0; i < bench_clients; ++i )
+				clients[ i ]->Update();
+		}
+		const double seconds = timer.GetSeconds();
+
+		for( int i = 0; i < bench_clients; ++i )
+		{
+			delete clients[ i ];
+			delete client_transports[ i ];
+		}
+
+		delete server;
+		delete server_transport;
+
+		return seconds;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int NetworkStatsBenchmark()
+{
+	test_logger << "Soak over loopback, " << bench_clients << " clients, " << bench_ticks << " ticks" << std::endl;
+
+	poro::tester::BenchmarkReport( "stats off", RunSoak( false, 16 ), bench_ticks );
+	poro::tester::BenchmarkReport( "stats on", RunSoak( true, 16 ), bench_ticks );
+	poro::tester::BenchmarkReport( "stats on, every message timed", RunSoak( true, 1 ), bench_ticks );
+
+	test_logger << "CNetworkStats calls" << std::endl;
+
+	CNetworkStats stats;
+	std::vector< TransportAddress > addresses;
+	for( int i = 0; i < bench_clients; ++i )
+		addresses.push_back( TransportAddress( 0x7F000001, (unsigned short)( 1000 + i ) ) );
+
+	{
+		poro::tester::CBenchmarkTimer timer;
+		for( int i = 0; i < bench_calls; ++i )
+		{
+			stats.OnMessageSent( i & 0xFF, 20 );
+			stats.OnPacketSent( addresses[ ( i >> 4 ) % bench_clients ], 20, 1 );
+		}
+		poro::tester::BenchmarkReport( "OnMessageSent + OnPacketSent", timer.GetSeconds(), bench_calls );
+	}
+
+	{
+		poro::tester::CBenchmarkTimer timer;
+		for( int i = 0; i < bench_calls; ++i )
+		{
+			if( stats.ShouldTime() )
+				stats.OnSerialized( (float)( i & 15 ) );
+		}
+		poro::tester::BenchmarkReport( "ShouldTime", timer.GetSeconds(), bench_calls );
+	}
+
+	{
+		const int exports = 100;
+		std::size_t bytes = 0;
+		poro::tester::CBenchmarkTimer timer;
+		for( int i = 0; i < exports; ++i )
+		{
+			std::stringstream json;
+			stats.Export( json, NETWORK_STATS_JSON );
+			bytes = json.str().size();
+		}
+		poro::tester::BenchmarkReport( "Export JSON", timer.GetSeconds(), exports );
+		test_logger << "  " << bytes << " bytes" << std::endl;
+	}
+
+	return 0;
+}
+
+BENCHMARK_REGISTER( NetworkStatsBenchmark );
+
+} // end of namespace test
+
+#endif
@@ -0,0 +1,294 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../../utils/debug.h"
+#include "../igamemessage.h"
+#include "../igamemessagefactory.h"
+#include "../network_conditioner.h"
+#include "../network_peer.h"
+#include "../network_stats.h"
+#include "../transport_loopback.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	enum
+	{
+		SMALL_MESSAGE_ID = 100,
+		BIG_MESSAGE_ID = 101
+	};
+
+	// the small one is 4 bytes and the big one 44 bytes, plus the header
+	class CStatsTestMessage : public IGameMessage
+	{
+	public:
+		explicit CStatsTestMessage( int type = SMALL_MESSAGE_ID ) : mType( type ), mValues( type == BIG_MESSAGE_ID ? 10 : 0, 1.5f ) { }
+
+		int GetType() const { return mType; }
+		bool IsPooled() const { return true; }
+
+		void BitSerialize( network_utils::ISerializer* serializer )
+		{
+			network_utils::uint32 count = (network_utils::uint32)mValues.size();
+			serializer->IO( count );
+			mValues.resize( count );
+			for( std::size_t i = 0; i < mValues.size(); ++i )
+				serializer->IO( mValues[ i ] );
+		}
+
+		void HandleServer( IPacketHandler* /*packet_handler*/ ) { }
+		void HandleClient( IPacketHandler* /*packet_handler*/ ) { }
+
+		int								mType;
+		std::vector< network_utils::float32 >	mValues;
+	};
+
+	class CStatsTestMessageFactory : public IGameMessageFactory
+	{
+	public:
+		IGameMessage* GetNewMessage( int type )
+		{
+			if( type == SMALL_MESSAGE_ID || type == BIG_MESSAGE_ID )
+				return new CStatsTestMessage( type );
+			return NULL;
+		}
+
+		int GetGameMessageID_First() const { return SMALL_MESSAGE_ID; }
+		int GetGameMessageID_Last() const { return BIG_MESSAGE_ID; }
+	};
+
+	int CountOf( const std::string& text, const std::string& what )
+	{
+		int result = 0;
+		for( std::size_t i = text.find( what ); i != std::string::npos; i = text.find( what, i + 1 ) )
+			++result;
+		return result;
+	}
+
+}
+
+int NetworkStatsTest()
+{
+	// percentiles
+	{
+		CRollingWindow window( 128 );
+		test_assert( window.IsEmpty() );
+		test_assert( window.GetPercentile( 50 ) == 0 );
+
+		for( int i = 100; i >= 1; --i )
+			window.Add( (float)i );
+
+		test_assert( window.GetCount() == 100 );
+		test_assert( window.GetLast() == 1 );
+		test_assert( window.GetMin() == 1 && window.GetMax() == 100 );
+		test_assert( window.GetAverage() == 50.5f );
+		test_assert( window.GetPercentile( 50 ) == 50 );
+		test_assert( window.GetPercentile( 90 ) == 90 );
+		test_assert( window.GetPercentile( 99 ) == 99 );
+		test_assert( window.GetPercentile( 100 ) == 100 );
+		test_assert( window.GetPercentile( 0 ) == 1 );
+
+		// only the last ones count
+		for( int i = 101; i <= 300; ++i )
+			window.Add( (float)i );
+
+		test_assert( window.GetCount() == 128 );
+		test_assert( window.GetMin() == 173 && window.GetMax() == 300 );
+		test_assert( window.GetLast() == 300 );
+	}
+
+	// a server and two clients
+	{
+		CLoopbackNetwork network;
+		CLoopbackTransport* server_transport = network.CreateTransport();
+		CNetworkPeer* server = new CNetworkPeer( true, server_transport, new CStatsTestMessageFactory );
+		server->GetNetworkStats().SetTimingInterval( 1 );
+
+		CLoopbackTransport* client_transports[ 2 ];
+		CNetworkPeer* clients[ 2 ];
+		for( int i = 0; i < 2; ++i )
+		{
+			client_transports[ i ] = network.CreateTransport();
+			client_transports[ i ]->Connect( server_transport->GetLocalAddress() );
+			clients[ i ] = new CNetworkPeer( false, client_transports[ i ], new CStatsTestMessageFactory );
+		}
+		server->Update();
+
+		// 3 small ones to everyone, 2 big ones to the first client
+		for( int i = 0; i < 3; ++i )
+			server->GetPacketHandler()->SendGameMessage( new CStatsTestMessage( SMALL_MESSAGE_ID ) );
+		for( int i = 0; i < 2; ++i )
+			server->SendGameMessageTo( new CStatsTestMessage( BIG_MESSAGE_ID ), client_transports[ 0 ]->GetLocalAddress() );
+
+		// and the second client sends one of each
+		clients[ 1 ]->GetPacketHandler()->SendGameMessage( new CStatsTestMessage( SMALL_MESSAGE_ID ) );
+		clients[ 1 ]->GetPacketHandler()->SendGameMessage( new CStatsTestMessage( BIG_MESSAGE_ID ) );
+		clients[ 1 ]->Update();
+
+		server->Update();
+		clients[ 0 ]->Update();
+
+		const CNetworkStats& stats = server->GetNetworkStats();
+		const unsigned int small_size = 5 + 4;
+		const unsigned int big_size = 5 + 44;
+
+		test_assert( stats.GetMessageTypeStats( SMALL_MESSAGE_ID ).messages_sent == 3 );
+		test_assert( stats.GetMessageTypeStats( SMALL_MESSAGE_ID ).bytes_sent == 3 * small_size );
+		test_assert( stats.GetMessageTypeStats( BIG_MESSAGE_ID ).messages_sent == 2 );
+		test_assert( stats.GetMessageTypeStats( BIG_MESSAGE_ID ).bytes_sent == 2 * big_size );
+		test_assert( stats.GetMessageTypeStats( SMALL_MESSAGE_ID ).messages_received == 1 );
+		test_assert( stats.GetMessageTypeStats( SMALL_MESSAGE_ID ).bytes_received == small_size );
+		test_assert( stats.GetMessageTypeStats( BIG_MESSAGE_ID ).messages_received == 1 );
+		test_assert( stats.GetMessageTypeStats( BIG_MESSAGE_ID ).bytes_received == big_size );
+		test_assert( stats.GetMessageTypeStats( 0 ).messages_sent == 0 );
+
+		// one batch to everyone, one to the first client
+		test_assert( stats.GetTotals().messages_sent == 5 );
+		test_assert( stats.GetTotals().packets_sent == 2 );
+		test_assert( stats.GetTotals().bytes_sent == 2 + 3 * small_size + 2 * big_size );
+		test_assert( &stats.GetTotals() == &server->GetStats() );
+
+		const NetworkConnectionStats* everyone = stats.GetConnectionStats( UNASSIGNED_TRANSPORT_ADDRESS );
+		const NetworkConnectionStats* first = stats.GetConnectionStats( client_transports[ 0 ]->GetLocalAddress() );
+		const NetworkConnectionStats* second = stats.GetConnectionStats( client_transports[ 1 ]->GetLocalAddress() );
+		test_assert( everyone && first && second );
+		test_assert( everyone->counters.messages_sent == 3 && everyone->counters.packets_sent == 1 );
+		test_assert( first->counters.messages_sent == 2 && first->counters.bytes_sent == 1 + 2 * big_size );
+		test_assert( first->counters.messages_received == 0 );
+		test_assert( second->counters.messages_received == 2 );
+		test_assert( second->counters.packets_received == 1 );
+		test_assert( second->counters.bytes_received == 1 + small_size + big_size );
+
+		// every message was timed
+		test_assert( stats.GetSerializeTime().GetCount() == 5 );
+		test_assert( stats.GetDeserializeTime().GetCount() == 2 );
+		test_assert( stats.GetSendQueue().GetMax() == 5 );
+
+		// the client got all five
+		test_assert( clients[ 0 ]->GetNetworkStats().GetTotals().messages_received == 5 );
+		test_assert( clients[ 0 ]->GetNetworkStats().GetMessageTypeStats( BIG_MESSAGE_ID ).messages_received == 2 );
+
+		// once a second the connections and the bytes per second
+		{
+			CNetworkStats sampled = stats;
+			test_assert( sampled.Update( 10000, server_transport ) );
+			test_assert( sampled.Update( 10500, server_transport ) == false );
+			test_assert( sampled.Update( 11000, server_transport ) );
+			test_assert( sampled.GetBytesSentPerSecond().GetCount() == 2 );
+			test_assert( sampled.GetBytesSentPerSecond().GetLast() == 0 );
+			test_assert( sampled.GetConnectionStats( client_transports[ 0 ]->GetLocalAddress() )->rtt.GetCount() == 2 );
+			test_assert( sampled.GetConnectionStats( UNASSIGNED_TRANSPORT_ADDRESS )->rtt.IsEmpty() );
+		}
+
+		// exported
+		{
+			std::stringstream csv;
+			stats.Export( csv, NETWORK_STATS_CSV );
+			test_assert( CountOf( csv.str(), "message_type,100,3,27,0,1,9,0\n" ) == 1 );
+			test_assert( CountOf( csv.str(), "connection,broadcast," ) == 1 );
+			test_assert( CountOf( csv.str(), "serialize_us,5," ) == 1 );
+
+			std::stringstream json;
+			stats.Export( json, NETWORK_STATS_JSON );
+			test_assert( CountOf( json.str(), "\"type\": 101" ) == 1 );
+			test_assert( CountOf( json.str(), "\"address\": " ) == 3 );
+			test_assert( CountOf( json.str(), "{" ) == CountOf( json.str(), "}" ) );
+			test_assert( CountOf( json.str(), "[" ) == CountOf( json.str(), "]" ) );
+		}
+
+		// turned off nothing is counted
+		server->GetNetworkStats().SetEnabled( false );
+		server->GetPacketHandler()->SendGameMessage( new CStatsTestMessage( SMALL_MESSAGE_ID ) );
+		server->Update();
+		test_assert( stats.GetTotals().messages_sent == 5 );
+		server->GetNetworkStats().SetEnabled( true );
+
+		server->GetNetworkStats().Clear();
+		test_assert( stats.GetTotals().messages_sent == 0 );
+		test_assert( stats.GetConnectionCount() == 0 );
+
+		for( int i = 0; i < 2; ++i )
+		{
+			delete clients[ i ];
+			delete client_transports[ i ];
+		}
+		delete server;
+		delete server_transport;
+	}
+
+	// the round trip and the loss through the conditioner
+	{
+		CLoopbackNetwork network;
+		CLoopbackTransport* a = network.CreateTransport();
+		CLoopbackTransport* b = network.CreateTransport();
+		CNetworkConditioner conditioner( a );
+		a->Connect( b->GetLocalAddress() );
+		while( TransportPacket* packet = conditioner.Receive() )
+			conditioner.DeallocatePacket( packet );
+
+		TransportConnectionStats connection;
+		test_assert( conditioner.GetConnectionStats( b->GetLocalAddress(), connection ) );
+		test_assert( connection.rtt == 0 && connection.loss == 0 );
+
+		NetworkConditions conditions;
+		conditions.latency = 40;
+		conditions.loss = 0.5f;
+		conditioner.SetConditions( NETWORK_OUTGOING, conditions );
+		for( int i = 0; i < 100; ++i )
+			conditioner.Send( (const unsigned char*)"x", 1, b->GetLocalAddress(), false, i % 2 ? TRANSPORT_RELIABLE : TRANSPORT_UNRELIABLE, 0, TRANSPORT_PRIORITY_HIGH );
+
+		test_assert( conditioner.GetConnectionStats( b->GetLocalAddress(), connection ) );
+		test_assert( connection.send_queue > 0 );
+
+		const NetworkConditionerStats sent = conditioner.GetStats( NETWORK_OUTGOING );
+		test_assert( sent.lost > 0 );
+		test_assert( std::fabs( connection.loss - 100.f * ( sent.lost + sent.lost_in_burst ) / 100 ) < 0.01f );
+
+		CNetworkStats stats;
+		stats.OnPacketSent( b->GetLocalAddress(), 1, 1 );
+		stats.Update( 0, &conditioner );
+		stats.Update( 1000, &conditioner );
+		test_assert( stats.GetConnectionStats( b->GetLocalAddress() )->loss.GetLast() == connection.loss );
+		test_assert( stats.GetConnectionStats( b->GetLocalAddress() )->send_queue.GetLast() == connection.send_queue );
+
+		conditioner.Reset();
+		delete b;
+		delete a;
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( NetworkStatsTest );
+
+} // end of namespace test
+
+#endif
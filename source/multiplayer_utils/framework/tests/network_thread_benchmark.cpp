@@ -0,0 +1,248 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include <vector>
+
+#include <SDL.h>
+
+#include "../../../utils/debug.h"
+#include "../../../tester/tester_benchmark.h"
+#include "../igamemessage.h"
+#include "../igamemessagefactory.h"
+#include "../network_peer.h"
+#include "../network_stats.h"
+#include "../transport_loopback.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	enum
+	{
+		STATE_MESSAGE_ID = 100,
+		INPUT_MESSAGE_ID = 101
+	};
+
+	const int bench_clients = 8;
+	const int bench_frames = 100;
+
+	// half of the frame's work is done before the game sends its state and
+	// half after, every tenth frame has a 30 ms hitch after the send
+	const Uint32 bench_frame_work = 10;
+	const Uint32 bench_hitch = 30;
+	const int bench_hitch_every = 10;
+
+	double bench_start = 0;
+
+	network_utils::uint32 GetBenchMicroseconds() { return (network_utils::uint32)( GetNetworkStatsTime() - bench_start ); }
+
+	struct Latencies
+	{
+		Latencies() : state( 10000 ), input( 10000 ) { }
+
+		// from the server's game thread to the clients and from the clients
+		// to the server's handlers, in milliseconds
+		CRollingWindow state;
+		CRollingWindow input;
+	};
+
+	class CTimedMessage : public IGameMessage
+	{
+	public:
+		explicit CTimedMessage( int type = STATE_MESSAGE_ID ) : mType( type ), mSentAt( GetBenchMicroseconds() ) { }
+
+		int GetType() const { return mType; }
+		bool IsPooled() const { return true; }
+
+		void BitSerialize( network_utils::ISerializer* serializer )
+		{
+			serializer->IO( mSentAt );
+		}
+
+		void HandleServer( IPacketHandler* packet_handler )
+		{
+			static_cast< Latencies* >( packet_handler->GetUserData() )->input.Add( ( GetBenchMicroseconds() - mSentAt ) / 1000.f );
+		}
+
+		void HandleClient( IPacketHandler* packet_handler )
+		{
+			static_cast< Latencies* >( packet_handler->GetUserData() )->state.Add( ( GetBenchMicroseconds() - mSentAt ) / 1000.f );
+		}
+
+		int						mType;
+		network_utils::uint32	mSentAt;
+	};
+
+	class CTimedMessageFactory : public IGameMessageFactory
+	{
+	public:
+		IGameMessage* GetNewMessage( int type )
+		{
+			if( type == STATE_MESSAGE_ID || type == INPUT_MESSAGE_ID )
+				return new CTimedMessage( type );
+			return NULL;
+		}
+
+		int GetGameMessageID_First() const { return STATE_MESSAGE_ID; }
+		int GetGameMessageID_Last() const { return INPUT_MESSAGE_ID; }
+	};
+
+	// the clients are on machines of their own, here they share a thread
+	struct Clients
+	{
+		Clients() : mutex( SDL_CreateMutex() ), running( true ) { }
+		~Clients() { SDL_DestroyMutex( mutex ); }
+
+		bool IsRunning()
+		{
+			SDL_mutexP( mutex );
+			const bool result = running;
+			SDL_mutexV( mutex );
+			return result;
+		}
+
+		void Stop()
+		{
+			SDL_mutexP( mutex );
+			running = false;
+			SDL_mutexV( mutex );
+		}
+
+		std::vector< CNetworkPeer* >	peers;
+		Latencies						latencies;
+		SDL_mutex*						mutex;
+		bool							running;
+	};
+
+	int RunClients( void* data )
+	{
+		Clients* clients = static_cast< Clients* >( data );
+		for( int round = 0; clients->IsRunning(); ++round )
+		{
+			for( std::size_t i = 0; i < clients->peers.size(); ++i )
+			{
+				if( round % 8 == 0 )
+					clients->peers[ i ]->GetPacketHandler()->SendGameMessage( new CTimedMessage( INPUT_MESSAGE_ID ) );
+
+				clients->peers[ i ]->Update();
+			}
+
+			SDL_Delay( 1 );
+		}
+		return 0;
+	}
+
+	void RunFrames( bool threaded )
+	{
+		CLoopbackNetwork network;
+		CLoopbackTransport* server_transport = network.CreateTransport();
+		CNetworkPeer* server = new CNetworkPeer( true, server_transport, new CTimedMessageFactory );
+		Latencies server_latencies;
+		server->SetUserData( &server_latencies );
+
+		Clients clients;
+		std::vector< CLoopbackTransport* > client_transports;
+		for( int i = 0; i < bench_clients; ++i )
+		{
+			client_transports.push_back( network.CreateTransport() );
+			client_transports.back()->Connect( server_transport->GetLocalAddress() );
+			clients.peers.push_back( new CNetworkPeer( false, client_transports.back(), new CTimedMessageFactory ) );
+			clients.peers.back()->SetUserData( &clients.latencies );
+		}
+
+		server->Update();
+		if( threaded )
+			server->StartThread();
+
+		SDL_Thread* client_thread = SDL_CreateThread( RunClients, &clients );
+
+		// what the network costs the game thread
+		CRollingWindow network_time( bench_frames );
+		for( int frame = 0; frame < bench_frames; ++frame )
+		{
+			SDL_Delay( bench_frame_work / 2 );
+			server->GetPacketHandlerForGame()->SendGameMessage( new CTimedMessage( STATE_MESSAGE_ID ) );
+			SDL_Delay( bench_frame_work / 2 + ( frame % bench_hitch_every == bench_hitch_every - 1 ? bench_hitch : 0 ) );
+
+			const double start = GetNetworkStatsTime();
+			if( threaded )
+				server->HandleMessages();
+			else
+				server->Update();
+			network_time.Add( (float)( GetNetworkStatsTime() - start ) );
+		}
+
+		clients.Stop();
+		SDL_WaitThread( client_thread, NULL );
+
+		const NetworkThreadStats thread_stats = server->GetThreadStats();
+		server->StopThread();
+
+		const CRollingWindow& state = clients.latencies.state;
+		const CRollingWindow& input = server_latencies.input;
+		test_logger << "  state to the clients: " << state.GetAverage() << " ms average, p50 " << state.GetPercentile( 50 ) << ", p99 " << state.GetPercentile( 99 ) << ", max " << state.GetMax() << " (" << state.GetCount() << " messages)" << std::endl;
+		test_logger << "  input to the handlers: " << input.GetAverage() << " ms average, p50 " << input.GetPercentile( 50 ) << ", p99 " << input.GetPercentile( 99 ) << ", max " << input.GetMax() << " (" << input.GetCount() << " messages)" << std::endl;
+		test_logger << "  game thread network time: " << network_time.GetAverage() << " us average, max " << network_time.GetMax() << " us" << std::endl;
+
+		if( threaded )
+		{
+			test_logger << "  network thread: " << thread_stats.updates << " updates"
+				<< ", to the game: " << thread_stats.to_game << " (" << thread_stats.to_game_waits << " waited, " << thread_stats.max_to_game << " at most)"
+				<< ", to the network: " << thread_stats.to_network << " (" << thread_stats.to_network_waits << " waited, " << thread_stats.max_to_network << " at most)" << std::endl;
+		}
+
+		for( int i = 0; i < bench_clients; ++i )
+		{
+			delete clients.peers[ i ];
+			delete client_transports[ i ];
+		}
+
+		delete server;
+		delete server_transport;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int NetworkThreadBenchmark()
+{
+	bench_start = GetNetworkStatsTime();
+
+	test_logger << "Latency over loopback, " << bench_clients << " clients, " << bench_frames << " frames of " << bench_frame_work << " ms, a " << bench_hitch << " ms hitch every " << bench_hitch_every << " frames" << std::endl;
+
+	test_logger << "Update() on the game thread" << std::endl;
+	RunFrames( false );
+
+	test_logger << "network thread, HandleMessages() on the game thread" << std::endl;
+	RunFrames( true );
+
+	return 0;
+}
+
+BENCHMARK_REGISTER( NetworkThreadBenchmark );
+
+} // end of namespace test
+
+#endif
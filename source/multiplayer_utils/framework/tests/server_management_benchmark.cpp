@@ -0,0 +1,316 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include <vector>
+
+#include "../../../utils/debug.h"
+#include "../../../tester/tester_benchmark.h"
+#include "../igamemessage.h"
+#include "../igamemessagefactory.h"
+#include "../multiplayer_config.h"
+#include "../network_peer.h"
+#include "../transport_loopback.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	enum { BENCH_MESSAGE_ID = 100 };
+
+	const int bench_peers = 256;
+	const int bench_lookup_rounds = 1000;
+	const int bench_broadcast_ticks = 50;
+	const int bench_broadcasts_per_tick = 20;
+
+	struct BenchCounters
+	{
+		BenchCounters() : received( 0 ) { }
+		int received;
+	};
+
+	// a unit update, like in the other benchmarks
+	class CBenchMessage : public IGameMessage
+	{
+	public:
+		CBenchMessage() : mId( 1234 ), mX( 1.5f ), mY( -2.5f ), mAngle( 0.5f ) { }
+
+		int GetType() const { return BENCH_MESSAGE_ID; }
+		bool IsPooled() const { return true; }
+		TransportDelivery GetDelivery() const { return TRANSPORT_UNRELIABLE; }
+
+		void BitSerialize( network_utils::ISerializer* serializer )
+		{
+			serializer->IO( mId );
+			serializer->IO( mX );
+			serializer->IO( mY );
+			serializer->IO( mAngle );
+		}
+
+		void HandleClient( IPacketHandler* packet_handler )
+		{
+			static_cast< BenchCounters* >( packet_handler->GetUserData() )->received++;
+		}
+
+		network_utils::uint32	mId;
+		network_utils::float32	mX;
+		network_utils::float32	mY;
+		network_utils::float32	mAngle;
+	};
+
+	class CBenchMessageFactory : public IGameMessageFactory
+	{
+	public:
+		IGameMessage* GetNewMessage( int type ) { return ( type == BENCH_MESSAGE_ID ) ? new CBenchMessage : NULL; }
+		int GetGameMessageID_First() const { return BENCH_MESSAGE_ID; }
+		int GetGameMessageID_Last() const { return BENCH_MESSAGE_ID; }
+	};
+
+	// how CServerManagement used to find the players
+	struct LinearPlayers
+	{
+		~LinearPlayers()
+		{
+			for( std::size_t i = 0; i < players.size(); ++i )
+				delete players[ i ];
+		}
+
+		PlayerAddress* Get( const TransportAddress& address )
+		{
+			for( std::size_t i = 0; i < players.size(); ++i )
+			{
+				if( players[ i ] && players[ i ]->mAddress == address )
+					return players[ i ];
+			}
+
+			PlayerAddress* result = new PlayerAddress;
+			result->mAddress = address;
+			result->mTeam = TEAM_UNKNOWN;
+			for( std::size_t i = 0; i < players.size(); ++i )
+			{
+				if( players[ i ] == NULL )
+				{
+					players[ i ] = result;
+					return result;
+				}
+			}
+			players.push_back( result );
+			return result;
+		}
+
+		void Remove( const TransportAddress& address )
+		{
+			for( std::size_t i = 0; i < players.size(); ++i )
+			{
+				if( players[ i ] && players[ i ]->mAddress == address )
+				{
+					delete players[ i ];
+					players[ i ] = NULL;
+				}
+			}
+		}
+
+		std::vector< PlayerAddress* > players;
+	};
+
+	void RunRegistryBenchmark()
+	{
+		std::vector< TransportAddress > addresses;
+		for( int i = 0; i < bench_peers; ++i )
+			addresses.push_back( TransportAddress::FromIP( 127, 0, 0, 1, (unsigned short)( 50000 + i ) ) );
+
+		const int lookups = bench_peers * bench_lookup_rounds;
+		int check = 0;
+
+		{
+			LinearPlayers players;
+			for( int i = 0; i < bench_peers; ++i )
+				players.Get( addresses[ i ] );
+
+			poro::tester::CBenchmarkTimer timer;
+			for( int r = 0; r < bench_lookup_rounds; ++r )
+			{
+				for( int i = 0; i < bench_peers; ++i )
+					check += players.Get( addresses[ ( i * 37 ) % bench_peers ] )->mTeam;
+			}
+			poro::tester::BenchmarkReport( "lookups, linear walk", timer.GetSeconds(), lookups );
+		}
+
+		{
+			CServerManagement players;
+			for( int i = 0; i < bench_peers; ++i )
+				players.GetPlayerForAddress( addresses[ i ] );
+
+			poro::tester::CBenchmarkTimer timer;
+			for( int r = 0; r < bench_lookup_rounds; ++r )
+			{
+				for( int i = 0; i < bench_peers; ++i )
+					check += players.GetPlayerForAddress( addresses[ ( i * 37 ) % bench_peers ] )->mTeam;
+			}
+			poro::tester::BenchmarkReport( "lookups, hashed", timer.GetSeconds(), lookups );
+		}
+
+		test_assert( check > 0 );
+	}
+
+	//-------------------------------------------------------------------------
+
+	struct BenchSession
+	{
+		BenchSession() : server_transport( NULL ), server( NULL ) { }
+
+		~BenchSession()
+		{
+			for( std::size_t i = 0; i < clients.size(); ++i )
+			{
+				delete clients[ i ];
+				delete client_transports[ i ];
+			}
+			delete server;
+			delete server_transport;
+		}
+
+		void UpdateClients()
+		{
+			for( std::size_t i = 0; i < clients.size(); ++i )
+				clients[ i ]->Update();
+		}
+
+		int GetReceived() const
+		{
+			int result = 0;
+			for( std::size_t i = 0; i < counters.size(); ++i )
+				result += counters[ i ].received;
+			return result;
+		}
+
+		CLoopbackNetwork					network;
+		CLoopbackTransport*					server_transport;
+		CNetworkPeer*						server;
+		std::vector< CLoopbackTransport* >	client_transports;
+		std::vector< CNetworkPeer* >		clients;
+		std::vector< BenchCounters >		counters;
+	};
+
+	// everyone but the first player, the way a relayed update goes
+	enum BroadcastMode
+	{
+		BROADCAST_ONE_BY_ONE,
+		BROADCAST_TO_PLAYERS
+	};
+
+	void RunBroadcast( BenchSession& session, BroadcastMode mode, const char* name )
+	{
+		const std::vector< PlayerAddress* >& players = session.server->GetServerManagement().GetPlayers();
+		std::vector< PlayerAddress* > targets( players.begin() + 1, players.end() );
+
+		const int received_before = session.GetReceived();
+		double seconds = 0;
+
+		for( int tick = 0; tick < bench_broadcast_ticks; ++tick )
+		{
+			poro::tester::CBenchmarkTimer timer;
+			for( int m = 0; m < bench_broadcasts_per_tick; ++m )
+			{
+				if( mode == BROADCAST_ONE_BY_ONE )
+				{
+					for( std::size_t i = 0; i < targets.size(); ++i )
+						session.server->SendGameMessageTo( new CBenchMessage, targets[ i ]->mAddress );
+				}
+				else
+				{
+					session.server->SendGameMessageToPlayers( new CBenchMessage, targets );
+				}
+			}
+			session.server->Update();
+			seconds += timer.GetSeconds();
+
+			session.UpdateClients();
+		}
+
+		const int deliveries = bench_broadcast_ticks * bench_broadcasts_per_tick * (int)targets.size();
+		test_assert( session.GetReceived() - received_before == deliveries );
+		poro::tester::BenchmarkReport( name, seconds, deliveries );
+	}
+
+	void RunSessionBenchmark()
+	{
+		BenchSession session;
+		session.server_transport = session.network.CreateTransport();
+		session.server = new CNetworkPeer( true, session.server_transport, new CBenchMessageFactory );
+		session.server->GetServerManagement().SetTeamPolicy( new CRoundRobinTeamPolicy( 8 ) );
+		session.counters.resize( bench_peers );
+
+		// join
+		{
+			poro::tester::CBenchmarkTimer timer;
+			for( int i = 0; i < bench_peers; ++i )
+			{
+				CLoopbackTransport* transport = session.network.CreateTransport();
+				transport->Connect( session.server_transport->GetLocalAddress() );
+				session.client_transports.push_back( transport );
+				session.clients.push_back( new CNetworkPeer( false, transport, new CBenchMessageFactory ) );
+				session.clients.back()->SetUserData( &session.counters[ i ] );
+			}
+			session.server->Update();
+			poro::tester::BenchmarkReport( "join", timer.GetSeconds(), bench_peers );
+			test_assert( session.server->GetServerManagement().GetPlayerCount() == bench_peers );
+			test_assert( session.server->GetServerManagement().GetTeamSize( TEAM_1 ) == bench_peers / 8 );
+		}
+
+		session.UpdateClients();
+
+		RunBroadcast( session, BROADCAST_ONE_BY_ONE, "to 255 players, SendGameMessageTo each" );
+		RunBroadcast( session, BROADCAST_TO_PLAYERS, "to 255 players, SendGameMessageToPlayers" );
+
+		// half of them leave
+		{
+			poro::tester::CBenchmarkTimer timer;
+			for( int i = 0; i < bench_peers; i += 2 )
+				session.client_transports[ i ]->Disconnect( session.server_transport->GetLocalAddress() );
+			session.server->Update();
+			poro::tester::BenchmarkReport( "leave", timer.GetSeconds(), bench_peers / 2 );
+			test_assert( session.server->GetServerManagement().GetPlayerCount() == bench_peers / 2 );
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int ServerManagementBenchmark()
+{
+	test_logger << "CServerManagement, " << bench_peers << " players" << std::endl;
+	RunRegistryBenchmark();
+
+	test_logger << "Loopback session with " << bench_peers << " clients" << std::endl;
+	RunSessionBenchmark();
+
+	return 0;
+}
+
+BENCHMARK_REGISTER( ServerManagementBenchmark );
+
+} // end of namespace test
+
+#endif
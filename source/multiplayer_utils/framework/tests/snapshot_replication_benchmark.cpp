@@ -0,0 +1,303 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include <stdlib.h>
+#include <map>
+#include <sstream>
+
+#include "../../../utils/debug.h"
+#include "../../../tester/tester_benchmark.h"
+#include "../igamemessage.h"
+#include "../igamemessagefactory.h"
+#include "../network_peer.h"
+#include "../snapshot_replication.h"
+#include "../transport_loopback.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	enum
+	{
+		SNAPSHOT_MESSAGE_ID = 100,
+		SNAPSHOT_ACK_MESSAGE_ID = 101
+	};
+
+	const int bench_clients = 64;
+	const int bench_entities = 1000;
+	const int bench_ticks = 120;
+	const int bench_tick_rate = 60;
+
+	// every 20th snapshot is lost on the way
+	const int bench_loss = 20;
+
+	struct BenchEntity
+	{
+		BenchEntity() : x( 0 ), y( 0 ), angle( 0 ), health( 100 ), state( 0 ), alive( true ) { }
+
+		void BitSerialize( network_utils::ISerializer* serializer )
+		{
+			serializer->IO( x );
+			serializer->IO( y );
+			serializer->IO( angle );
+			serializer->IO( health );
+			serializer->IO( state );
+			serializer->IO( alive );
+		}
+
+		network_utils::float32	x;
+		network_utils::float32	y;
+		network_utils::float32	angle;
+		network_utils::int32	health;
+		network_utils::uint8	state;
+		bool					alive;
+	};
+
+	struct BenchServer
+	{
+		CSnapshotServer						snapshots;
+		std::map< TransportAddress, int >	clients;
+	};
+
+	struct BenchClient
+	{
+		BenchClient() : received( 0 ) { }
+
+		CSnapshotClient	snapshots;
+		int				received;
+	};
+
+	class CSnapshotAckMessage : public IGameMessage
+	{
+	public:
+		CSnapshotAckMessage( network_utils::uint32 sequence = 0 ) : mSequence( sequence ) { }
+
+		int GetType() const { return SNAPSHOT_ACK_MESSAGE_ID; }
+		bool IsPooled() const { return true; }
+		TransportDelivery GetDelivery() const { return TRANSPORT_UNRELIABLE; }
+
+		void BitSerialize( network_utils::ISerializer* serializer ) { serializer->IO( mSequence ); }
+
+		void HandleServer( IPacketHandler* packet_handler )
+		{
+			BenchServer* server = static_cast< BenchServer* >( packet_handler->GetUserData() );
+			std::map< TransportAddress, int >::iterator i = server->clients.find( packet_handler->GetCurrentPacketAddress()->mAddress );
+			if( i != server->clients.end() )
+				server->snapshots.Acknowledge( i->second, mSequence );
+		}
+
+		network_utils::uint32 mSequence;
+	};
+
+	class CSnapshotMessage : public IGameMessage
+	{
+	public:
+		CSnapshotMessage() { }
+		CSnapshotMessage( const network_utils::types::ustring& data ) : mData( data ) { }
+
+		int GetType() const { return SNAPSHOT_MESSAGE_ID; }
+		bool IsPooled() const { return true; }
+		TransportDelivery GetDelivery() const { return TRANSPORT_UNRELIABLE; }
+
+		void BitSerialize( network_utils::ISerializer* serializer ) { serializer->IO( mData ); }
+
+		void HandleClient( IPacketHandler* packet_handler )
+		{
+			BenchClient* client = static_cast< BenchClient* >( packet_handler->GetUserData() );
+			if( rand() % bench_loss == 0 )
+				return;
+
+			if( client->snapshots.ReadSnapshot( mData.data(), (unsigned int)mData.size() ) )
+			{
+				client->received++;
+				packet_handler->SendGameMessage( new CSnapshotAckMessage( client->snapshots.GetSequence() ) );
+			}
+		}
+
+		network_utils::types::ustring mData;
+	};
+
+	class CSnapshotMessageFactory : public IGameMessageFactory
+	{
+	public:
+		IGameMessage* GetNewMessage( int type )
+		{
+			if( type == SNAPSHOT_MESSAGE_ID )
+				return new CSnapshotMessage;
+			if( type == SNAPSHOT_ACK_MESSAGE_ID )
+				return new CSnapshotAckMessage;
+			return NULL;
+		}
+
+		int GetGameMessageID_First() const { return SNAPSHOT_MESSAGE_ID; }
+		int GetGameMessageID_Last() const { return SNAPSHOT_ACK_MESSAGE_ID; }
+	};
+
+	//-------------------------------------------------------------------------
+
+	// A third of the entities are moving and turning, now and then one gets
+	// hit or changes what it's doing. Same every run.
+	void UpdateWorld( std::vector< BenchEntity >& world, int tick )
+	{
+		for( std::size_t i = 0; i < world.size(); ++i )
+		{
+			BenchEntity& entity = world[ i ];
+			if( ( i + tick / 30 ) % 3 == 0 )
+			{
+				entity.x += 0.1f * (float)( i % 7 );
+				entity.y -= 0.05f * (float)( i % 5 );
+				entity.angle += 0.01f;
+			}
+
+			if( rand() % 100 == 0 )
+				entity.health -= 1 + rand() % 10;
+			if( rand() % 200 == 0 )
+				entity.state = (network_utils::uint8)( rand() % 8 );
+		}
+	}
+
+	struct BenchResult
+	{
+		BenchResult() : seconds( 0 ), bytes( 0 ), full_bytes( 0 ), full_snapshots( 0 ), received( 0 ) { }
+
+		double			seconds;
+		unsigned int	bytes;
+		unsigned int	full_bytes;
+		unsigned int	full_snapshots;
+		unsigned int	received;
+	};
+
+	BenchResult RunSnapshots( bool delta_compression )
+	{
+		srand( 1 );
+
+		CLoopbackNetwork network;
+		ITransport* server_transport = network.CreateTransport();
+		CNetworkPeer* server = new CNetworkPeer( true, server_transport, new CSnapshotMessageFactory );
+		BenchServer server_data;
+		server_data.snapshots.SetDeltaCompression( delta_compression );
+		server->SetUserData( &server_data );
+
+		std::vector< CLoopbackTransport* > client_transports;
+		std::vector< CNetworkPeer* > clients;
+		std::vector< BenchClient* > client_data;
+		std::vector< int > client_ids;
+
+		for( int i = 0; i < bench_clients; ++i )
+		{
+			CLoopbackTransport* transport = network.CreateTransport();
+			transport->Connect( server_transport->GetLocalAddress() );
+			client_transports.push_back( transport );
+
+			clients.push_back( new CNetworkPeer( false, transport, new CSnapshotMessageFactory ) );
+			client_data.push_back( new BenchClient );
+			clients.back()->SetUserData( client_data.back() );
+
+			client_ids.push_back( server_data.snapshots.AddClient() );
+			server_data.clients[ transport->GetLocalAddress() ] = client_ids.back();
+		}
+
+		std::vector< BenchEntity > world( bench_entities );
+		for( int i = 0; i < bench_entities; ++i )
+		{
+			world[ i ].x = (float)( i % 40 ) * 25.0f;
+			world[ i ].y = (float)( i / 40 ) * 25.0f;
+		}
+
+		server->Update();
+
+		poro::tester::CBenchmarkTimer timer;
+		for( int tick = 0; tick < bench_ticks; ++tick )
+		{
+			UpdateWorld( world, tick );
+
+			server_data.snapshots.BeginSnapshot();
+			for( int i = 0; i < bench_entities; ++i )
+				server_data.snapshots.AddEntity( i, world[ i ] );
+			server_data.snapshots.EndSnapshot();
+
+			for( int i = 0; i < bench_clients; ++i )
+			{
+				const network_utils::types::ustring& data = server_data.snapshots.WriteSnapshot( client_ids[ i ] );
+				server->SendGameMessageTo( new CSnapshotMessage( data ), client_transports[ i ]->GetLocalAddress() );
+			}
+
+			server->Update();
+			for( int i = 0; i < bench_clients; ++i )
+				clients[ i ]->Update();
+		}
+
+		BenchResult result;
+		result.seconds = timer.GetSeconds();
+
+		for( int i = 0; i < bench_clients; ++i )
+		{
+			const SnapshotClientStats& stats = server_data.snapshots.GetClientStats( client_ids[ i ] );
+			result.bytes += stats.bytes;
+			result.full_bytes += stats.full_bytes;
+			result.full_snapshots += stats.full_snapshots;
+			result.received += client_data[ i ]->received;
+
+			delete clients[ i ];
+			delete client_data[ i ];
+			delete client_transports[ i ];
+		}
+
+		delete server;
+		delete server_transport;
+
+		return result;
+	}
+
+	void Report( const std::string& name, const BenchResult& result )
+	{
+		const double seconds_simulated = (double)bench_ticks / bench_tick_rate;
+		const double per_client = (double)result.bytes / bench_clients / seconds_simulated;
+
+		poro::tester::BenchmarkReport( name + ", ticks", result.seconds, bench_ticks );
+		test_logger << "  " << (int)( per_client / 1024.0 ) << " kB per client per second at " << bench_tick_rate << " Hz"
+			<< ", " << (int)( 100.0 * result.bytes / result.full_bytes ) << "% of full"
+			<< ", " << result.full_snapshots << " full snapshots"
+			<< ", " << result.received << " of " << bench_clients * bench_ticks << " applied" << std::endl;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int SnapshotReplicationBenchmark()
+{
+	test_logger << "Snapshots over loopback, " << bench_clients << " clients, " << bench_entities << " entities, 1 in " << bench_loss << " lost" << std::endl;
+
+	Report( "full snapshots", RunSnapshots( false ) );
+	Report( "delta snapshots", RunSnapshots( true ) );
+
+	return 0;
+}
+
+BENCHMARK_REGISTER( SnapshotReplicationBenchmark );
+
+} // end of namespace test
+
+#endif
@@ -0,0 +1,241 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include <vector>
+
+#include "../../../utils/debug.h"
+#include "../snapshot_replication.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	struct TestEntity
+	{
+		TestEntity( int id = 0 ) : x( (float)id ), y( 0 ), health( 100 ), alive( true ) { }
+
+		void BitSerialize( network_utils::ISerializer* serializer )
+		{
+			serializer->IO( x );
+			serializer->IO( y );
+			serializer->IO( health );
+			serializer->IO( alive );
+		}
+
+		bool operator==( const TestEntity& other ) const
+		{
+			return x == other.x && y == other.y && health == other.health && alive == other.alive;
+		}
+
+		network_utils::float32	x;
+		network_utils::float32	y;
+		network_utils::int32	health;
+		bool					alive;
+	};
+
+	typedef std::vector< TestEntity > TestWorld;
+
+	void AddWorld( CSnapshotServer& server, TestWorld& world, const std::vector< bool >& exists )
+	{
+		server.BeginSnapshot();
+		// backwards, the server sorts them
+		for( int i = (int)world.size() - 1; i >= 0; --i )
+		{
+			if( exists[ i ] )
+				server.AddEntity( i * 3, world[ i ] );
+		}
+		server.EndSnapshot();
+	}
+
+	bool ClientMatches( const CSnapshotClient& client, TestWorld& world, const std::vector< bool >& exists )
+	{
+		const WorldSnapshot* snapshot = client.GetSnapshot();
+		if( snapshot == NULL )
+			return false;
+
+		int count = 0;
+		for( std::size_t i = 0; i < world.size(); ++i )
+		{
+			TestEntity entity( -1 );
+			const bool found = client.ReadEntity( (unsigned int)i * 3, entity );
+			if( found != exists[ i ] )
+				return false;
+			if( found && !( entity == world[ i ] ) )
+				return false;
+			if( found )
+				++count;
+		}
+
+		return count == snapshot->GetCount();
+	}
+
+	bool Deliver( CSnapshotServer& server, int server_client, CSnapshotClient& client )
+	{
+		const network_utils::types::ustring& data = server.WriteSnapshot( server_client );
+		return client.ReadSnapshot( data.data(), (unsigned int)data.size() );
+	}
+}
+
+int SnapshotReplicationTest()
+{
+	const int entity_count = 50;
+	TestWorld world;
+	std::vector< bool > exists( entity_count, true );
+	for( int i = 0; i < entity_count; ++i )
+		world.push_back( TestEntity( i ) );
+
+	CSnapshotServer server( 8 );
+	const int a = server.AddClient();
+	const int b = server.AddClient();
+	CSnapshotClient client_a( 8 );
+	CSnapshotClient client_b( 8 );
+
+	// nothing acked, so the first one is full
+	AddWorld( server, world, exists );
+	test_assert( Deliver( server, a, client_a ) );
+	test_assert( ClientMatches( client_a, world, exists ) );
+	test_assert( client_a.GetStats().full_snapshots == 1 );
+	server.Acknowledge( a, client_a.GetSequence() );
+
+	const unsigned int full_size = server.GetClientStats( a ).last_snapshot_bytes;
+
+	// one entity moves, only that goes out
+	world[ 10 ].x += 1.0f;
+	AddWorld( server, world, exists );
+	test_assert( Deliver( server, a, client_a ) );
+	test_assert( ClientMatches( client_a, world, exists ) );
+	test_assert( server.GetClientStats( a ).last_snapshot_bytes < full_size / 10 );
+	test_assert( client_a.GetStats().full_snapshots == 1 );
+
+	// b hasn't acked anything yet
+	test_assert( Deliver( server, b, client_b ) );
+	test_assert( ClientMatches( client_b, world, exists ) );
+	test_assert( server.GetClientStats( b ).full_snapshots == 1 );
+	server.Acknowledge( b, client_b.GetSequence() );
+
+	// lost snapshots and lost acks, the deltas are still against what the
+	// client has
+	for( int tick = 0; tick < 5; ++tick )
+	{
+		world[ tick ].health -= 10;
+		world[ 20 + tick ].y += 0.5f;
+		AddWorld( server, world, exists );
+
+		if( tick % 2 == 0 )
+		{
+			server.WriteSnapshot( a );
+			continue;
+		}
+
+		test_assert( Deliver( server, a, client_a ) );
+		test_assert( ClientMatches( client_a, world, exists ) );
+		if( tick != 3 )
+			server.Acknowledge( a, client_a.GetSequence() );
+	}
+	test_assert( server.GetClientStats( a ).full_snapshots == 1 );
+
+	// entities come and go
+	exists[ 5 ] = false;
+	exists[ 49 ] = false;
+	world.push_back( TestEntity( 50 ) );
+	exists.push_back( true );
+	AddWorld( server, world, exists );
+	test_assert( Deliver( server, a, client_a ) );
+	test_assert( ClientMatches( client_a, world, exists ) );
+	server.Acknowledge( a, client_a.GetSequence() );
+
+	// the ones with the same baseline get the same bytes, written once
+	{
+		const int c = server.AddClient();
+		const int d = server.AddClient();
+		AddWorld( server, world, exists );
+		const network_utils::types::ustring& data_c = server.WriteSnapshot( c );
+		const network_utils::types::ustring& data_d = server.WriteSnapshot( d );
+		test_assert( &data_c == &data_d );
+
+		CSnapshotClient client_c( 8 );
+		test_assert( client_c.ReadSnapshot( data_c.data(), (unsigned int)data_c.size() ) );
+		test_assert( ClientMatches( client_c, world, exists ) );
+
+		server.RemoveClient( c );
+		server.RemoveClient( d );
+		test_assert( server.AddClient() == c );
+		server.RemoveClient( c );
+	}
+
+	// b's baseline is older than the history by now, so it gets a full one
+	test_assert( server.GetClientStats( b ).full_snapshots == 1 );
+	for( int tick = 0; tick < 10; ++tick )
+	{
+		world[ 30 ].x += 1.0f;
+		AddWorld( server, world, exists );
+	}
+	test_assert( Deliver( server, b, client_b ) );
+	test_assert( ClientMatches( client_b, world, exists ) );
+	test_assert( server.GetClientStats( b ).full_snapshots == 2 );
+
+	// a missed all of those, its baseline is gone too
+	test_assert( Deliver( server, a, client_a ) );
+	test_assert( ClientMatches( client_a, world, exists ) );
+	test_assert( server.GetClientStats( a ).full_snapshots == 2 );
+
+	// an old one doesn't go over a newer one, a broken one doesn't either
+	{
+		network_utils::types::ustring old_data = server.WriteSnapshot( a );
+		test_assert( client_a.ReadSnapshot( old_data.data(), (unsigned int)old_data.size() ) == false );
+		test_assert( client_a.GetStats().old_snapshots == 1 );
+
+		server.Acknowledge( a, client_a.GetSequence() );
+		world[ 1 ].x += 1.0f;
+		AddWorld( server, world, exists );
+		network_utils::types::ustring data = server.WriteSnapshot( a );
+		data.resize( data.size() - 1 );
+		test_assert( client_a.ReadSnapshot( data.data(), (unsigned int)data.size() ) == false );
+		test_assert( client_a.GetStats().broken_snapshots == 1 );
+		world[ 1 ].x -= 1.0f;
+		test_assert( ClientMatches( client_a, world, exists ) );
+	}
+
+	// with the compression off everything is full
+	{
+		server.SetDeltaCompression( false );
+		AddWorld( server, world, exists );
+		const unsigned int before = server.GetClientStats( a ).full_snapshots;
+		test_assert( Deliver( server, a, client_a ) );
+		test_assert( server.GetClientStats( a ).full_snapshots == before + 1 );
+		test_assert( ClientMatches( client_a, world, exists ) );
+	}
+
+	const SnapshotClientStats& stats = server.GetClientStats( a );
+	test_assert( stats.bytes < stats.full_bytes );
+
+	return 0;
+}
+
+TEST_REGISTER( SnapshotReplicationTest );
+
+} // end of namespace test
+
+#endif
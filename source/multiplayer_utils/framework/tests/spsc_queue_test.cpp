@@ -0,0 +1,116 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include <SDL.h>
+
+#include "../../../utils/debug.h"
+#include "../spsc_queue.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	const unsigned int thread_test_count = 200000;
+
+	// pushes 1, 2, 3 ... and spins when the queue is full
+	int PushNumbers( void* data )
+	{
+		CSpscQueue< unsigned int >* queue = static_cast< CSpscQueue< unsigned int >* >( data );
+		for( unsigned int i = 1; i <= thread_test_count; )
+		{
+			if( queue->Push( i ) )
+				++i;
+		}
+		return 0;
+	}
+
+}
+
+int SpscQueueTest()
+{
+	// one thread
+	{
+		CSpscQueue< int > queue( 5 );
+		test_assert( queue.GetCapacity() == 8 );
+		test_assert( queue.IsEmpty() );
+
+		int value = -1;
+		test_assert( queue.Pop( value ) == false );
+		test_assert( value == -1 );
+
+		for( int i = 0; i < 8; ++i )
+			test_assert( queue.Push( i ) );
+		test_assert( queue.Push( 8 ) == false );
+		test_assert( queue.GetSize() == 8 );
+
+		test_assert( queue.Pop( value ) && value == 0 );
+		test_assert( queue.Push( 8 ) );
+		test_assert( queue.Push( 9 ) == false );
+
+		for( int i = 1; i <= 8; ++i )
+			test_assert( queue.Pop( value ) && value == i );
+		test_assert( queue.Pop( value ) == false );
+		test_assert( queue.IsEmpty() );
+
+		// around the ring a good number of times
+		for( int i = 0; i < 1000; ++i )
+		{
+			test_assert( queue.Push( i ) );
+			test_assert( queue.Push( -i ) );
+			test_assert( queue.Pop( value ) && value == i );
+			test_assert( queue.Pop( value ) && value == -i );
+		}
+		test_assert( queue.IsEmpty() );
+	}
+
+	// the numbers come out in order from the other thread
+	{
+		CSpscQueue< unsigned int > queue( 64 );
+		SDL_Thread* thread = SDL_CreateThread( PushNumbers, &queue );
+		test_assert( thread );
+
+		unsigned int expected = 1;
+		unsigned int value = 0;
+		while( expected <= thread_test_count )
+		{
+			if( queue.Pop( value ) )
+			{
+				test_assert( value == expected );
+				++expected;
+			}
+		}
+
+		SDL_WaitThread( thread, NULL );
+		test_assert( queue.IsEmpty() );
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( SpscQueueTest );
+
+} // end of namespace test
+
+#endif
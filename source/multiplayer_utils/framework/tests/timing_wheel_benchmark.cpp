@@ -0,0 +1,206 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include <stdlib.h>
+#include <list>
+#include <queue>
+#include <sstream>
+#include <vector>
+
+#include "../../../utils/debug.h"
+#include "../../../tester/tester_benchmark.h"
+#include "../timing_wheel.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	const int bench_pending = 100000;
+	const int bench_ticks = 2000;
+
+	// the old list is sorted on every push, it can't be run with the full
+	// amount in any sensible time
+	const int bench_list_pending = 1000;
+
+	// mostly the short delays of the buffered handler and the lag simulation,
+	// now and then something a lot longer
+	unsigned int BenchDelay()
+	{
+		if( rand() % 20 == 0 )
+			return 1000 + rand() % 30000;
+		return 1 + rand() % 200;
+	}
+
+	struct BenchMessage
+	{
+		BenchMessage() : time_to_fire( 0 ), value( 0 ) { }
+		BenchMessage( unsigned int t, int value ) : time_to_fire( t ), value( value ) { }
+
+		bool operator< ( const BenchMessage& other ) const { return time_to_fire < other.time_to_fire; }
+
+		unsigned int	time_to_fire;
+		int				value;
+	};
+
+	struct LaterFirst
+	{
+		bool operator()( const BenchMessage& a, const BenchMessage& b ) const { return b < a; }
+	};
+
+	// Each round keeps the given amount of messages waiting: the wheel gets
+	// filled first, then every tick fires what's due and adds as many new
+	// ones. Returns the operations, an add and a fire for each message.
+
+	int RunSortedList( int pending, double& seconds )
+	{
+		srand( 1 );
+		std::list< BenchMessage > buffer;
+		unsigned int now = 0;
+		int operations = 0;
+
+		poro::tester::CBenchmarkTimer timer;
+		for( int i = 0; i < pending; ++i )
+		{
+			buffer.push_back( BenchMessage( now + BenchDelay(), i ) );
+			buffer.sort();
+		}
+
+		for( int tick = 0; tick < bench_ticks; ++tick )
+		{
+			++now;
+			int fired = 0;
+			while( buffer.empty() == false && buffer.front().time_to_fire < now )
+			{
+				buffer.pop_front();
+				++fired;
+			}
+
+			for( int i = 0; i < fired; ++i )
+			{
+				buffer.push_back( BenchMessage( now + BenchDelay(), i ) );
+				buffer.sort();
+			}
+			operations += fired * 2;
+		}
+
+		seconds = timer.GetSeconds();
+		return operations + pending;
+	}
+
+	int RunBinaryHeap( int pending, double& seconds )
+	{
+		srand( 1 );
+		std::priority_queue< BenchMessage, std::vector< BenchMessage >, LaterFirst > buffer;
+		unsigned int now = 0;
+		int operations = 0;
+
+		poro::tester::CBenchmarkTimer timer;
+		for( int i = 0; i < pending; ++i )
+			buffer.push( BenchMessage( now + BenchDelay(), i ) );
+
+		for( int tick = 0; tick < bench_ticks; ++tick )
+		{
+			++now;
+			int fired = 0;
+			while( buffer.empty() == false && buffer.top().time_to_fire < now )
+			{
+				buffer.pop();
+				++fired;
+			}
+
+			for( int i = 0; i < fired; ++i )
+				buffer.push( BenchMessage( now + BenchDelay(), i ) );
+			operations += fired * 2;
+		}
+
+		seconds = timer.GetSeconds();
+		return operations + pending;
+	}
+
+	int RunTimingWheel( int pending, double& seconds )
+	{
+		srand( 1 );
+		CTimingWheel< BenchMessage > wheel( 0 );
+		std::vector< BenchMessage > fired;
+		unsigned int now = 0;
+		int operations = 0;
+
+		poro::tester::CBenchmarkTimer timer;
+		for( int i = 0; i < pending; ++i )
+		{
+			const unsigned int t = now + BenchDelay();
+			wheel.Add( BenchMessage( t, i ), t );
+		}
+
+		for( int tick = 0; tick < bench_ticks; ++tick )
+		{
+			++now;
+			fired.clear();
+			wheel.Advance( now - 1, fired );
+
+			for( std::size_t i = 0; i < fired.size(); ++i )
+			{
+				const unsigned int t = now + BenchDelay();
+				wheel.Add( BenchMessage( t, (int)i ), t );
+			}
+			operations += (int)fired.size() * 2;
+		}
+
+		seconds = timer.GetSeconds();
+		return operations + pending;
+	}
+
+	void Report( const std::string& name, int pending, int (*func)( int, double& ) )
+	{
+		double seconds = 0;
+		const int operations = func( pending, seconds );
+
+		std::stringstream ss;
+		ss << name << ", " << pending << " pending";
+		poro::tester::BenchmarkReport( ss.str(), seconds, operations );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int TimingWheelBenchmark()
+{
+	test_logger << "Scheduled messages, adds and fires over " << bench_ticks << " ticks" << std::endl;
+
+	Report( "sorted std::list", bench_list_pending, RunSortedList );
+	Report( "binary heap", bench_list_pending, RunBinaryHeap );
+	Report( "timing wheel", bench_list_pending, RunTimingWheel );
+
+	Report( "binary heap", bench_pending, RunBinaryHeap );
+	Report( "timing wheel", bench_pending, RunTimingWheel );
+
+	return 0;
+}
+
+BENCHMARK_REGISTER( TimingWheelBenchmark );
+
+} // end of namespace test
+
+#endif
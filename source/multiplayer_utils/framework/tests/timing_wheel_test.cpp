@@ -0,0 +1,145 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include <stdlib.h>
+#include <vector>
+
+#include "../../../utils/debug.h"
+#include "../timing_wheel.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace test {
+
+namespace {
+
+	struct WheelItem
+	{
+		WheelItem() : time( 0 ), sequence( 0 ) { }
+		WheelItem( unsigned int time, int sequence ) : time( time ), sequence( sequence ) { }
+
+		unsigned int	time;
+		int				sequence;
+	};
+
+}
+
+int TimingWheelTest()
+{
+	// the short ones fire on their tick, in the order they were added
+	{
+		CTimingWheel< int > wheel( 1000 );
+		wheel.Add( 1, 1005 );
+		wheel.Add( 2, 1002 );
+		wheel.Add( 3, 1005 );
+		wheel.Add( 4, 900 );
+		test_assert( wheel.GetSize() == 4 );
+
+		std::vector< int > fired;
+		wheel.Advance( 1001, fired );
+		test_assert( fired.size() == 1 && fired[ 0 ] == 4 );
+
+		wheel.Advance( 1004, fired );
+		test_assert( fired.size() == 2 && fired[ 1 ] == 2 );
+
+		wheel.Advance( 1005, fired );
+		test_assert( fired.size() == 4 && fired[ 2 ] == 1 && fired[ 3 ] == 3 );
+		test_assert( wheel.IsEmpty() );
+	}
+
+	// long delays go through the upper levels and come down on time, also
+	// when the clock wraps around
+	{
+		const unsigned int start = 0xFFFFFF00;
+		const unsigned int delays[] = { 0, 1, 255, 256, 257, 1000, 16383, 16384, 16385, 100000, 1048576, 5000000 };
+		const int delay_count = sizeof( delays ) / sizeof( delays[ 0 ] );
+
+		CTimingWheel< int > wheel( start );
+		for( int i = 0; i < delay_count; ++i )
+			wheel.Add( i, start + delays[ i ] );
+
+		std::vector< int > fired;
+		for( int i = 0; i < delay_count; ++i )
+		{
+			if( delays[ i ] > 0 )
+				wheel.Advance( start + delays[ i ] - 1, fired );
+			test_assert( (int)fired.size() == i );
+
+			wheel.Advance( start + delays[ i ], fired );
+			test_assert( (int)fired.size() == i + 1 && fired[ i ] == i );
+		}
+		test_assert( wheel.IsEmpty() );
+	}
+
+	// random times and random steps, everything fires on the first advance
+	// that reaches it, in the order of times and then the order of adding
+	{
+		srand( 1234 );
+		CTimingWheel< WheelItem > wheel( 0 );
+		unsigned int now = 0;
+		int sequence = 0;
+		std::vector< WheelItem > fired;
+
+		for( int round = 0; round < 2000; ++round )
+		{
+			const int adds = rand() % 20;
+			for( int i = 0; i < adds; ++i )
+			{
+				const unsigned int delay = ( rand() % 4 == 0 ) ? rand() % 70000 : rand() % 300;
+				wheel.Add( WheelItem( now + delay, sequence++ ), now + delay );
+			}
+
+			now += rand() % 600;
+			fired.clear();
+			wheel.Advance( now, fired );
+
+			for( std::size_t i = 0; i < fired.size(); ++i )
+			{
+				test_assert( (int)( fired[ i ].time - now ) <= 0 );
+				if( i > 0 )
+				{
+					test_assert( (int)( fired[ i - 1 ].time - fired[ i ].time ) <= 0 );
+					if( fired[ i - 1 ].time == fired[ i ].time )
+						test_assert( fired[ i - 1 ].sequence < fired[ i ].sequence );
+				}
+			}
+		}
+
+		// the rest come out with Clear()
+		const std::size_t left = wheel.GetSize();
+		fired.clear();
+		wheel.Clear( fired );
+		test_assert( fired.size() == left );
+		test_assert( wheel.IsEmpty() );
+		for( std::size_t i = 0; i < fired.size(); ++i )
+			test_assert( (int)( fired[ i ].time - now ) > 0 );
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( TimingWheelTest );
+
+} // end of namespace test
+
+#endif
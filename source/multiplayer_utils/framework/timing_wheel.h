@@ -0,0 +1,324 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#ifndef INC_TIMING_WHEEL_H
+#define INC_TIMING_WHEEL_H
+
+#include <algorithm>
+#include <vector>
+
+#include "../../utils/debug.h"
+
+//-----------------------------------------------------------------------------
+// Hierarchical timing wheel for things that have to happen at some tick
+// (milliseconds from SDL_GetTicks() for example). The first level has a slot
+// for each of the next 256 ticks, so adding and firing the short delays is
+// O(1). The longer ones sit in the coarser levels and are moved down a level
+// every time the level below has gone around. Delays longer than what the
+// levels cover (about 18 hours of milliseconds) are clamped to it.
+//
+// Items with the same time fire in the order they were added. Not thread
+// safe, the owner has to hand the items over to the thread that runs it.
+//-----------------------------------------------------------------------------
+
+template< class T >
+class CTimingWheel
+{
+public:
+	explicit CTimingWheel( unsigned int time_now = 0 ) :
+		mCurrent( time_now ),
+		mSize( 0 ),
+		mLevel0Size( 0 ),
+		mNextSequence( 0 )
+	{
+		for( int i = 0; i < SLOT_COUNT; ++i )
+			mSlots[ i ].head = mSlots[ i ].tail = NULL;
+	}
+
+	~CTimingWheel()
+	{
+		for( int i = 0; i < SLOT_COUNT; ++i )
+		{
+			for( Node* node = mSlots[ i ].head; node; )
+			{
+				Node* next = node->next;
+				delete node;
+				node = next;
+			}
+		}
+
+		for( std::size_t i = 0; i < mFreeNodes.size(); ++i )
+			delete mFreeNodes[ i ];
+	}
+
+	// fires on the first Advance() with a time at or past time_to_fire,
+	// times that have already gone fire on the next Advance()
+	void Add( const T& item, unsigned int time_to_fire )
+	{
+		Node* node = NewNode();
+		node->item = item;
+		node->time = time_to_fire;
+		node->sequence = mNextSequence++;
+		Insert( node );
+		++mSize;
+	}
+
+	// Processes every tick up to and including time_now. What fired is
+	// appended to the vector in the order of the times.
+	void Advance( unsigned int time_now, std::vector< T >& fired )
+	{
+		if( mSize == 0 )
+		{
+			if( (int)( time_now - mCurrent ) >= 0 )
+				mCurrent = time_now + 1;
+			return;
+		}
+
+		mFired.clear();
+
+		while( (int)( time_now - mCurrent ) >= 0 && mSize > 0 )
+		{
+			unsigned int index = mCurrent & LEVEL0_MASK;
+
+			// nothing in the first level, skips to where it goes around
+			if( mLevel0Size == 0 && index != 0 )
+			{
+				const unsigned int next_round = mCurrent + ( LEVEL0_SIZE - index );
+				if( (int)( time_now - next_round ) < 0 )
+				{
+					mCurrent = time_now + 1;
+					break;
+				}
+
+				mCurrent = next_round;
+				index = 0;
+			}
+
+			// the lower level has gone around, the next slot of the level
+			// above comes down
+			if( index == 0 )
+			{
+				const unsigned int level1 = ( mCurrent >> LEVEL0_BITS ) & LEVELN_MASK;
+				Cascade( 1, level1 );
+				if( level1 == 0 )
+				{
+					const unsigned int level2 = ( mCurrent >> ( LEVEL0_BITS + LEVELN_BITS ) ) & LEVELN_MASK;
+					Cascade( 2, level2 );
+					if( level2 == 0 )
+						Cascade( 3, ( mCurrent >> ( LEVEL0_BITS + 2 * LEVELN_BITS ) ) & LEVELN_MASK );
+				}
+			}
+
+			Slot& slot = mSlots[ index ];
+			for( Node* node = slot.head; node; )
+			{
+				Node* next = node->next;
+				mFired.push_back( node );
+				--mLevel0Size;
+				node = next;
+			}
+			slot.head = slot.tail = NULL;
+
+			++mCurrent;
+		}
+
+		// with nothing left, the rest of the ticks don't matter
+		if( mSize == 0 && (int)( time_now - mCurrent ) >= 0 )
+			mCurrent = time_now + 1;
+
+		// the cascaded and the late ones can land after the ones that were
+		// added to the slot directly, usually they're in order already
+		if( IsSorted( mFired ) == false )
+			std::sort( mFired.begin(), mFired.end(), CompareNodes );
+
+		MoveFired( fired );
+	}
+
+	// empties the wheel without waiting for the times, in the order of the
+	// times
+	void Clear( std::vector< T >& items )
+	{
+		mFired.clear();
+		for( int i = 0; i < SLOT_COUNT; ++i )
+		{
+			for( Node* node = mSlots[ i ].head; node; node = node->next )
+				mFired.push_back( node );
+			mSlots[ i ].head = mSlots[ i ].tail = NULL;
+		}
+
+		std::sort( mFired.begin(), mFired.end(), CompareNodes );
+		mLevel0Size = 0;
+		MoveFired( items );
+	}
+
+	std::size_t		GetSize() const { return mSize; }
+	bool			IsEmpty() const { return mSize == 0; }
+
+	// the next tick Advance() will process
+	unsigned int	GetCurrentTime() const { return mCurrent; }
+
+private:
+	enum
+	{
+		LEVEL0_BITS = 8,
+		LEVELN_BITS = 6,
+		LEVEL0_SIZE = 1 << LEVEL0_BITS,
+		LEVELN_SIZE = 1 << LEVELN_BITS,
+		LEVEL0_MASK = LEVEL0_SIZE - 1,
+		LEVELN_MASK = LEVELN_SIZE - 1,
+		LEVEL_COUNT = 4,
+		SLOT_COUNT = LEVEL0_SIZE + ( LEVEL_COUNT - 1 ) * LEVELN_SIZE,
+		MAX_DELAY = ( 1 << ( LEVEL0_BITS + ( LEVEL_COUNT - 1 ) * LEVELN_BITS ) ) - 1
+	};
+
+	struct Node
+	{
+		T				item;
+		unsigned int	time;
+		unsigned int	sequence;
+		Node*			next;
+	};
+
+	struct Slot
+	{
+		Node* head;
+		Node* tail;
+	};
+
+	static bool CompareNodes( const Node* a, const Node* b )
+	{
+		const int time_difference = (int)( a->time - b->time );
+		if( time_difference != 0 )
+			return time_difference < 0;
+		return (int)( a->sequence - b->sequence ) < 0;
+	}
+
+	static bool IsSorted( const std::vector< Node* >& nodes )
+	{
+		for( std::size_t i = 1; i < nodes.size(); ++i )
+		{
+			if( CompareNodes( nodes[ i ], nodes[ i - 1 ] ) )
+				return false;
+		}
+		return true;
+	}
+
+	void MoveFired( std::vector< T >& fired )
+	{
+		for( std::size_t i = 0; i < mFired.size(); ++i )
+		{
+			fired.push_back( mFired[ i ]->item );
+			mFired[ i ]->item = T();
+			mFreeNodes.push_back( mFired[ i ] );
+		}
+		mSize -= mFired.size();
+		mFired.clear();
+	}
+
+	Node* NewNode()
+	{
+		if( mFreeNodes.empty() )
+			return new Node;
+
+		Node* result = mFreeNodes.back();
+		mFreeNodes.pop_back();
+		return result;
+	}
+
+	void Insert( Node* node )
+	{
+		int delay = (int)( node->time - mCurrent );
+
+		if( delay > MAX_DELAY )
+		{
+			node->time = mCurrent + MAX_DELAY;
+			delay = MAX_DELAY;
+		}
+
+		// already late, goes to the next tick but keeps its time so it's
+		// still sorted before the ones that weren't late
+		unsigned int time = node->time;
+		if( delay < 0 )
+		{
+			time = mCurrent;
+			delay = 0;
+		}
+
+		int slot = 0;
+		if( delay < LEVEL0_SIZE )
+		{
+			slot = time & LEVEL0_MASK;
+			++mLevel0Size;
+		}
+		else if( delay < ( 1 << ( LEVEL0_BITS + LEVELN_BITS ) ) )
+			slot = LEVEL0_SIZE + ( ( time >> LEVEL0_BITS ) & LEVELN_MASK );
+		else if( delay < ( 1 << ( LEVEL0_BITS + 2 * LEVELN_BITS ) ) )
+			slot = LEVEL0_SIZE + LEVELN_SIZE + ( ( time >> ( LEVEL0_BITS + LEVELN_BITS ) ) & LEVELN_MASK );
+		else
+			slot = LEVEL0_SIZE + 2 * LEVELN_SIZE + ( ( time >> ( LEVEL0_BITS + 2 * LEVELN_BITS ) ) & LEVELN_MASK );
+
+		Append( mSlots[ slot ], node );
+	}
+
+	void Append( Slot& slot, Node* node )
+	{
+		node->next = NULL;
+		if( slot.tail )
+			slot.tail->next = node;
+		else
+			slot.head = node;
+		slot.tail = node;
+	}
+
+	void Cascade( int level, unsigned int index )
+	{
+		cassert( level > 0 && level < LEVEL_COUNT );
+		Slot& slot = mSlots[ LEVEL0_SIZE + ( level - 1 ) * LEVELN_SIZE + index ];
+
+		Node* node = slot.head;
+		slot.head = slot.tail = NULL;
+
+		while( node )
+		{
+			Node* next = node->next;
+			Insert( node );
+			node = next;
+		}
+	}
+
+	Slot					mSlots[ SLOT_COUNT ];
+	unsigned int			mCurrent;
+	std::size_t				mSize;
+	std::size_t				mLevel0Size;
+	unsigned int			mNextSequence;
+	std::vector< Node* >	mFreeNodes;
+	std::vector< Node* >	mFired;
+
+	// can't be copied
+	CTimingWheel( const CTimingWheel& );
+	CTimingWheel& operator=( const CTimingWheel& );
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,250 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include "transport_loopback.h"
+
+#include <algorithm>
+
+#include <SDL.h>
+
+#include "../../utils/debug.h"
+
+namespace {
+
+	class CNetworkLock
+	{
+	public:
+		CNetworkLock( SDL_mutex* mutex ) : mMutex( mutex ) { SDL_mutexP( mMutex ); }
+		~CNetworkLock() { SDL_mutexV( mMutex ); }
+
+	private:
+		SDL_mutex* mMutex;
+	};
+
+	// the first free port if the caller doesn't care
+	const unsigned short LOOPBACK_FIRST_PORT = 50000;
+
+}
+
+//=============================================================================
+
+CLoopbackNetwork::CLoopbackNetwork() :
+	mMutex( SDL_CreateMutex() ),
+	mNextPort( LOOPBACK_FIRST_PORT ),
+	mPacketsSent( 0 ),
+	mBytesSent( 0 )
+{
+}
+
+CLoopbackNetwork::~CLoopbackNetwork()
+{
+	cassert( mEndPoints.empty() && "All the transports have to be deleted before the network" );
+	SDL_DestroyMutex( mMutex );
+	mMutex = NULL;
+}
+
+CLoopbackTransport* CLoopbackNetwork::CreateTransport( unsigned short port )
+{
+	CNetworkLock lock( mMutex );
+
+	if( port == 0 )
+	{
+		while( mEndPoints.find( TransportAddress::FromIP( 127, 0, 0, 1, mNextPort ) ) != mEndPoints.end() )
+			++mNextPort;
+		port = mNextPort++;
+	}
+
+	const TransportAddress address = TransportAddress::FromIP( 127, 0, 0, 1, port );
+	if( mEndPoints.find( address ) != mEndPoints.end() )
+		return NULL;
+
+	CLoopbackTransport* result = new CLoopbackTransport( this, address );
+	mEndPoints[ address ] = result;
+	return result;
+}
+
+void CLoopbackNetwork::Remove( CLoopbackTransport* transport )
+{
+	CNetworkLock lock( mMutex );
+
+	for( std::size_t i = 0; i < transport->mConnections.size(); ++i )
+	{
+		CLoopbackTransport* other = Find( transport->mConnections[ i ] );
+		if( other )
+		{
+			other->RemoveConnection( transport->mAddress );
+			other->Push( transport->mAddress, TRANSPORT_DISCONNECTED, NULL, 0 );
+		}
+	}
+	transport->mConnections.clear();
+
+	mEndPoints.erase( transport->mAddress );
+}
+
+CLoopbackTransport* CLoopbackNetwork::Find( const TransportAddress& address )
+{
+	std::map< TransportAddress, CLoopbackTransport* >::iterator i = mEndPoints.find( address );
+	return ( i == mEndPoints.end() ) ? NULL : i->second;
+}
+
+//=============================================================================
+
+CLoopbackTransport::CLoopbackTransport( CLoopbackNetwork* network, const TransportAddress& address ) :
+	mNetwork( network ),
+	mAddress( address )
+{
+}
+
+CLoopbackTransport::~CLoopbackTransport()
+{
+	mNetwork->Remove( this );
+
+	while( mIncoming.empty() == false )
+	{
+		DeleteTransportPacket( mIncoming.front() );
+		mIncoming.pop_front();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+bool CLoopbackTransport::Connect( const TransportAddress& address )
+{
+	CNetworkLock lock( mNetwork->mMutex );
+
+	CLoopbackTransport* other = mNetwork->Find( address );
+	if( other == NULL || other == this )
+		return false;
+
+	if( IsConnectedTo( address ) )
+		return true;
+
+	mConnections.push_back( address );
+	other->mConnections.push_back( mAddress );
+
+	Push( address, TRANSPORT_CONNECTED, NULL, 0 );
+	other->Push( mAddress, TRANSPORT_CONNECTED, NULL, 0 );
+	return true;
+}
+
+void CLoopbackTransport::Disconnect( const TransportAddress& address )
+{
+	CNetworkLock lock( mNetwork->mMutex );
+
+	if( IsConnectedTo( address ) == false )
+		return;
+
+	RemoveConnection( address );
+	Push( address, TRANSPORT_DISCONNECTED, NULL, 0 );
+
+	CLoopbackTransport* other = mNetwork->Find( address );
+	if( other )
+	{
+		other->RemoveConnection( mAddress );
+		other->Push( mAddress, TRANSPORT_DISCONNECTED, NULL, 0 );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+bool CLoopbackTransport::Send( const unsigned char* data, unsigned int length, const TransportAddress& address, bool broadcast, TransportDelivery /*delivery*/, int /*channel*/, TransportPriority /*priority*/ )
+{
+	CNetworkLock lock( mNetwork->mMutex );
+
+	int sent = 0;
+	for( std::size_t i = 0; i < mConnections.size(); ++i )
+	{
+		const bool send_to = broadcast ?
+			( address.IsUnassigned() || mConnections[ i ] != address ) :
+			( address.IsUnassigned() || mConnections[ i ] == address );
+
+		if( send_to == false )
+			continue;
+
+		CLoopbackTransport* other = mNetwork->Find( mConnections[ i ] );
+		cassert( other );
+		if( other == NULL )
+			continue;
+
+		other->Push( mAddress, TRANSPORT_DATA, data, length );
+		++sent;
+	}
+
+	mNetwork->mPacketsSent += sent;
+	mNetwork->mBytesSent += sent * length;
+	return sent > 0;
+}
+
+TransportPacket* CLoopbackTransport::Receive()
+{
+	CNetworkLock lock( mNetwork->mMutex );
+
+	if( mIncoming.empty() )
+		return NULL;
+
+	TransportPacket* result = mIncoming.front();
+	mIncoming.pop_front();
+	return result;
+}
+
+void CLoopbackTransport::DeallocatePacket( TransportPacket* packet )
+{
+	DeleteTransportPacket( packet );
+}
+
+int CLoopbackTransport::GetConnectionCount() const
+{
+	CNetworkLock lock( mNetwork->mMutex );
+	return (int)mConnections.size();
+}
+
+bool CLoopbackTransport::GetConnectionStats( const TransportAddress& address, TransportConnectionStats& stats ) const
+{
+	CNetworkLock lock( mNetwork->mMutex );
+	if( IsConnectedTo( address ) == false )
+		return false;
+
+	stats.rtt = 0;
+	stats.loss = 0;
+	stats.send_queue = 0;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool CLoopbackTransport::IsConnectedTo( const TransportAddress& address ) const
+{
+	return std::find( mConnections.begin(), mConnections.end(), address ) != mConnections.end();
+}
+
+void CLoopbackTransport::RemoveConnection( const TransportAddress& address )
+{
+	mConnections.erase( std::remove( mConnections.begin(), mConnections.end(), address ), mConnections.end() );
+}
+
+void CLoopbackTransport::Push( const TransportAddress& from, TransportEvent event, const unsigned char* data, unsigned int length )
+{
+	mIncoming.push_back( NewTransportPacket( from, event, data, length ) );
+}
+
+//-----------------------------------------------------------------------------
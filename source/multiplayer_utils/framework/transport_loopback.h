@@ -0,0 +1,120 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#ifndef INC_TRANSPORT_LOOPBACK_H
+#define INC_TRANSPORT_LOOPBACK_H
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "itransport.h"
+
+struct SDL_mutex;
+
+class CLoopbackTransport;
+
+//-----------------------------------------------------------------------------
+// An in-process network. Every transport created from it gets an address
+// 127.0.0.1:port and can connect to the others. Sending copies the data
+// straight to the receiver's queue, nothing is lost or reordered. The
+// network is thread safe, so the peers can also run in threads of their own.
+//-----------------------------------------------------------------------------
+
+class CLoopbackNetwork
+{
+public:
+	CLoopbackNetwork();
+	~CLoopbackNetwork();
+
+	// The caller owns the transport and has to delete it before the network.
+	// With port 0 the next free port is used. Returns NULL if the port is
+	// already taken.
+	CLoopbackTransport* CreateTransport( unsigned short port = 0 );
+
+	// totals of everything sent through the network
+	unsigned int GetPacketsSent() const { return mPacketsSent; }
+	unsigned int GetBytesSent() const { return mBytesSent; }
+
+private:
+	friend class CLoopbackTransport;
+
+	void					Remove( CLoopbackTransport* transport );
+	CLoopbackTransport*		Find( const TransportAddress& address );
+
+	SDL_mutex*											mMutex;
+	std::map< TransportAddress, CLoopbackTransport* >	mEndPoints;
+	unsigned short										mNextPort;
+	unsigned int										mPacketsSent;
+	unsigned int										mBytesSent;
+
+	// can't be copied
+	CLoopbackNetwork( const CLoopbackNetwork& );
+	CLoopbackNetwork& operator=( const CLoopbackNetwork& );
+};
+
+//-----------------------------------------------------------------------------
+
+class CLoopbackTransport : public ITransport
+{
+public:
+	// disconnects from everyone, they get a TRANSPORT_DISCONNECTED
+	~CLoopbackTransport();
+
+	// Connects right away, both ends get a TRANSPORT_CONNECTED on their next
+	// Receive(). Returns false if there's no one at the address.
+	bool Connect( const TransportAddress& address );
+	void Disconnect( const TransportAddress& address );
+
+	virtual const char* GetName() const { return "loopback"; }
+
+	virtual bool Send( const unsigned char* data, unsigned int length, const TransportAddress& address, bool broadcast, TransportDelivery delivery, int channel, TransportPriority priority );
+
+	virtual TransportPacket*	Receive();
+	virtual void				DeallocatePacket( TransportPacket* packet );
+
+	virtual TransportAddress	GetLocalAddress() const { return mAddress; }
+	virtual int					GetConnectionCount() const;
+
+	// nothing is ever late or lost
+	virtual bool GetConnectionStats( const TransportAddress& address, TransportConnectionStats& stats ) const;
+
+private:
+	friend class CLoopbackNetwork;
+
+	CLoopbackTransport( CLoopbackNetwork* network, const TransportAddress& address );
+
+	// these are called with the network mutex locked
+	bool IsConnectedTo( const TransportAddress& address ) const;
+	void RemoveConnection( const TransportAddress& address );
+	void Push( const TransportAddress& from, TransportEvent event, const unsigned char* data, unsigned int length );
+
+	CLoopbackNetwork*				mNetwork;
+	TransportAddress				mAddress;
+	std::vector< TransportAddress >	mConnections;
+	std::deque< TransportPacket* >	mIncoming;
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,171 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include "transport_raknet.h"
+
+#include "RakNetStatistics.h"
+
+#include "../natpunch/raknet_natpunch.h"
+#include "../../utils/debug.h"
+
+//-----------------------------------------------------------------------------
+
+CRakNetTransport::CRakNetTransport( RakNet::RakPeerInterface* peer ) :
+	mRakPeer( peer ),
+	mNatFramework( NULL )
+{
+	cassert( mRakPeer );
+}
+
+CRakNetTransport::~CRakNetTransport()
+{
+	if( mNatFramework )
+		mNatFramework->Shutdown( mRakPeer );
+
+	delete mNatFramework;
+	mNatFramework = NULL;
+}
+
+void CRakNetTransport::EnableNatPunchthrough( bool is_server )
+{
+	if( mNatFramework )
+		return;
+
+	mNatFramework = new NatPunchthoughClientFramework( is_server );
+	mNatFramework->Init( mRakPeer );
+}
+
+//-----------------------------------------------------------------------------
+
+bool CRakNetTransport::Send( const unsigned char* data, unsigned int length, const TransportAddress& address, bool broadcast, TransportDelivery delivery, int channel, TransportPriority priority )
+{
+	cassert( delivery >= 0 && delivery < TRANSPORT_DELIVERY_COUNT );
+	cassert( channel >= 0 && channel < TRANSPORT_CHANNEL_COUNT );
+
+	const PacketReliability reliabilities[ TRANSPORT_DELIVERY_COUNT ] = { UNRELIABLE, UNRELIABLE_SEQUENCED, RELIABLE, RELIABLE_ORDERED };
+	const PacketPriority raknet_priority = ( priority == TRANSPORT_PRIORITY_IMMEDIATE ) ? IMMEDIATE_PRIORITY : HIGH_PRIORITY;
+
+	return mRakPeer->Send( (const char*)data, (int)length, raknet_priority, reliabilities[ delivery ], (char)channel, ToSystemAddress( address ), broadcast ) != 0;
+}
+
+TransportPacket* CRakNetTransport::Receive()
+{
+	RakNet::Packet* packet = mRakPeer->Receive();
+	if( packet == NULL )
+		return NULL;
+
+	if( mNatFramework )
+		mNatFramework->ProcessPacket( packet );
+
+	TransportPacket* result = new TransportPacket;
+	result->mAddress = ToTransportAddress( packet->systemAddress );
+	result->mData = packet->data;
+	result->mLength = packet->length;
+	result->mImpl = packet;
+
+	switch( packet->data[ 0 ] )
+	{
+	case ID_NEW_INCOMING_CONNECTION:
+	case ID_CONNECTION_REQUEST_ACCEPTED:
+		result->mEvent = TRANSPORT_CONNECTED;
+		break;
+
+	case ID_DISCONNECTION_NOTIFICATION:
+	case ID_CONNECTION_LOST:
+		result->mEvent = TRANSPORT_DISCONNECTED;
+		break;
+
+	default:
+		result->mEvent = TRANSPORT_DATA;
+		break;
+	}
+
+	return result;
+}
+
+void CRakNetTransport::DeallocatePacket( TransportPacket* packet )
+{
+	if( packet == NULL )
+		return;
+
+	mRakPeer->DeallocatePacket( static_cast< RakNet::Packet* >( packet->mImpl ) );
+	delete packet;
+}
+
+void CRakNetTransport::Update()
+{
+	if( mNatFramework )
+		mNatFramework->Update( mRakPeer );
+}
+
+TransportAddress CRakNetTransport::GetLocalAddress() const
+{
+	return ToTransportAddress( mRakPeer->GetInternalID() );
+}
+
+int CRakNetTransport::GetConnectionCount() const
+{
+	return (int)mRakPeer->NumberOfConnections();
+}
+
+bool CRakNetTransport::GetConnectionStats( const TransportAddress& address, TransportConnectionStats& stats ) const
+{
+	const RakNet::SystemAddress system_address = ToSystemAddress( address );
+
+	RakNet::RakNetStatistics raknet_stats;
+	if( mRakPeer->GetStatistics( system_address, &raknet_stats ) == NULL )
+		return false;
+
+	const int ping = mRakPeer->GetAveragePing( system_address );
+	stats.rtt = ( ping >= 0 ) ? (float)ping : -1.f;
+	stats.loss = raknet_stats.packetlossLastSecond * 100.f;
+
+	stats.send_queue = 0;
+	for( int i = 0; i < NUMBER_OF_PRIORITIES; ++i )
+		stats.send_queue += (int)raknet_stats.messageInSendBuffer[ i ];
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+TransportAddress CRakNetTransport::ToTransportAddress( const RakNet::SystemAddress& address )
+{
+	if( address == RakNet::UNASSIGNED_SYSTEM_ADDRESS )
+		return UNASSIGNED_TRANSPORT_ADDRESS;
+
+	return TransportAddress( address.binaryAddress, address.port );
+}
+
+RakNet::SystemAddress CRakNetTransport::ToSystemAddress( const TransportAddress& address )
+{
+	if( address.IsUnassigned() )
+		return RakNet::UNASSIGNED_SYSTEM_ADDRESS;
+
+	RakNet::SystemAddress result;
+	result.binaryAddress = address.mHost;
+	result.port = address.mPort;
+	return result;
+}
+
+//-----------------------------------------------------------------------------
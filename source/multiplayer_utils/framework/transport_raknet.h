@@ -0,0 +1,75 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#ifndef INC_TRANSPORT_RAKNET_H
+#define INC_TRANSPORT_RAKNET_H
+
+#include "multiplayer_utils.h"
+#include "itransport.h"
+
+struct SampleFramework;
+
+//-----------------------------------------------------------------------------
+// The real thing. The deliveries map straight to RakNet's reliabilities and
+// all the packets RakNet gives are passed on as they are, so the game message
+// factories still see RakNet's own message ids.
+//-----------------------------------------------------------------------------
+
+class CRakNetTransport : public ITransport
+{
+public:
+	// doesn't own the peer
+	explicit CRakNetTransport( RakNet::RakPeerInterface* peer );
+	~CRakNetTransport();
+
+	// runs the NAT punchthrough client on the packets of this peer
+	void EnableNatPunchthrough( bool is_server );
+
+	RakNet::RakPeerInterface* GetRakPeer() { return mRakPeer; }
+
+	virtual const char* GetName() const { return "raknet"; }
+
+	virtual bool Send( const unsigned char* data, unsigned int length, const TransportAddress& address, bool broadcast, TransportDelivery delivery, int channel, TransportPriority priority );
+
+	virtual TransportPacket*	Receive();
+	virtual void				DeallocatePacket( TransportPacket* packet );
+
+	virtual void Update();
+
+	virtual TransportAddress	GetLocalAddress() const;
+	virtual int					GetConnectionCount() const;
+
+	// the average ping and the packet loss of the last second
+	virtual bool GetConnectionStats( const TransportAddress& address, TransportConnectionStats& stats ) const;
+
+	static TransportAddress			ToTransportAddress( const RakNet::SystemAddress& address );
+	static RakNet::SystemAddress	ToSystemAddress( const TransportAddress& address );
+
+private:
+	RakNet::RakPeerInterface*	mRakPeer;
+	SampleFramework*			mNatFramework;
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,297 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#include "transport_udp.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <SDL.h>
+
+#ifdef _WIN32
+#	include <winsock2.h>
+	typedef int socklen_t;
+#else
+#	include <sys/types.h>
+#	include <sys/socket.h>
+#	include <netinet/in.h>
+#	include <arpa/inet.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+#include "../../utils/debug.h"
+
+namespace {
+
+	// the first byte of every datagram
+	enum UdpHeader
+	{
+		UDP_CONNECT = 1,
+		UDP_ACCEPT,
+		UDP_DATA,
+		UDP_DISCONNECT
+	};
+
+	const std::size_t	UDP_INVALID_SOCKET = (std::size_t)-1;
+	const unsigned int	UDP_MAX_DATAGRAM = 65536;
+	const unsigned int	UDP_CONNECT_RESEND_MS = 100;
+
+	// a whole tick of small datagrams has to fit in, the default is too
+	// small for that on some systems
+	const int			UDP_RECEIVE_BUFFER_SIZE = 1024 * 1024;
+
+#ifdef _WIN32
+	int winsock_users = 0;
+
+	void CloseSocket( std::size_t s ) { closesocket( (SOCKET)s ); }
+#else
+	void CloseSocket( std::size_t s ) { close( (int)s ); }
+#endif
+
+	sockaddr_in ToSockAddr( const TransportAddress& address )
+	{
+		sockaddr_in result;
+		std::memset( &result, 0, sizeof( result ) );
+		result.sin_family = AF_INET;
+		result.sin_addr.s_addr = address.mHost;
+		result.sin_port = htons( address.mPort );
+		return result;
+	}
+
+	TransportAddress FromSockAddr( const sockaddr_in& address )
+	{
+		return TransportAddress( (unsigned int)address.sin_addr.s_addr, ntohs( address.sin_port ) );
+	}
+
+}
+
+//=============================================================================
+
+CUdpTransport::CUdpTransport( unsigned short port ) :
+	mSocket( UDP_INVALID_SOCKET ),
+	mLastConnectTime( 0 ),
+	mReceiveBuffer( UDP_MAX_DATAGRAM )
+{
+#ifdef _WIN32
+	if( winsock_users++ == 0 )
+	{
+		WSADATA wsa_data;
+		WSAStartup( MAKEWORD( 2, 2 ), &wsa_data );
+	}
+	SOCKET s = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+	if( s == INVALID_SOCKET )
+		return;
+	u_long non_blocking = 1;
+	ioctlsocket( s, FIONBIO, &non_blocking );
+#else
+	int s = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+	if( s < 0 )
+		return;
+	fcntl( s, F_SETFL, fcntl( s, F_GETFL, 0 ) | O_NONBLOCK );
+#endif
+
+	const int receive_buffer_size = UDP_RECEIVE_BUFFER_SIZE;
+	setsockopt( s, SOL_SOCKET, SO_RCVBUF, (const char*)&receive_buffer_size, sizeof( receive_buffer_size ) );
+
+	sockaddr_in local = ToSockAddr( TransportAddress::FromIP( 127, 0, 0, 1, port ) );
+	socklen_t local_size = sizeof( local );
+	if( bind( s, (sockaddr*)&local, sizeof( local ) ) != 0 ||
+		getsockname( s, (sockaddr*)&local, &local_size ) != 0 )
+	{
+		CloseSocket( (std::size_t)s );
+		return;
+	}
+
+	mSocket = (std::size_t)s;
+	mAddress = FromSockAddr( local );
+}
+
+CUdpTransport::~CUdpTransport()
+{
+	if( IsOpen() )
+	{
+		for( std::size_t i = 0; i < mConnections.size(); ++i )
+			SendDatagram( UDP_DISCONNECT, NULL, 0, mConnections[ i ] );
+
+		CloseSocket( mSocket );
+		mSocket = UDP_INVALID_SOCKET;
+	}
+
+#ifdef _WIN32
+	if( --winsock_users == 0 )
+		WSACleanup();
+#endif
+}
+
+bool CUdpTransport::IsOpen() const
+{
+	return mSocket != UDP_INVALID_SOCKET;
+}
+
+//-----------------------------------------------------------------------------
+
+void CUdpTransport::Connect( const TransportAddress& address )
+{
+	if( IsConnectedTo( address ) ||
+		std::find( mPendingConnects.begin(), mPendingConnects.end(), address ) != mPendingConnects.end() )
+		return;
+
+	mPendingConnects.push_back( address );
+	SendDatagram( UDP_CONNECT, NULL, 0, address );
+	mLastConnectTime = SDL_GetTicks();
+}
+
+void CUdpTransport::Disconnect( const TransportAddress& address )
+{
+	if( IsConnectedTo( address ) == false )
+		return;
+
+	SendDatagram( UDP_DISCONNECT, NULL, 0, address );
+	RemoveConnection( address );
+}
+
+void CUdpTransport::Update()
+{
+	if( mPendingConnects.empty() )
+		return;
+
+	const unsigned int time_now = SDL_GetTicks();
+	if( time_now - mLastConnectTime < UDP_CONNECT_RESEND_MS )
+		return;
+
+	mLastConnectTime = time_now;
+	for( std::size_t i = 0; i < mPendingConnects.size(); ++i )
+		SendDatagram( UDP_CONNECT, NULL, 0, mPendingConnects[ i ] );
+}
+
+//-----------------------------------------------------------------------------
+
+bool CUdpTransport::Send( const unsigned char* data, unsigned int length, const TransportAddress& address, bool broadcast, TransportDelivery /*delivery*/, int /*channel*/, TransportPriority /*priority*/ )
+{
+	bool result = false;
+	for( std::size_t i = 0; i < mConnections.size(); ++i )
+	{
+		const bool send_to = broadcast ?
+			( address.IsUnassigned() || mConnections[ i ] != address ) :
+			( address.IsUnassigned() || mConnections[ i ] == address );
+
+		if( send_to && SendDatagram( UDP_DATA, data, length, mConnections[ i ] ) )
+			result = true;
+	}
+	return result;
+}
+
+TransportPacket* CUdpTransport::Receive()
+{
+	if( IsOpen() == false )
+		return NULL;
+
+	for( ;; )
+	{
+		sockaddr_in from;
+		socklen_t from_size = sizeof( from );
+		const int received = (int)recvfrom( mSocket, (char*)&mReceiveBuffer[ 0 ], (int)mReceiveBuffer.size(), 0, (sockaddr*)&from, &from_size );
+
+		// would block or some other error, either way there's nothing to give
+		if( received <= 0 )
+			return NULL;
+
+		const TransportAddress address = FromSockAddr( from );
+		const unsigned char* data = &mReceiveBuffer[ 0 ] + 1;
+		const unsigned int length = (unsigned int)received - 1;
+
+		switch( mReceiveBuffer[ 0 ] )
+		{
+		case UDP_CONNECT:
+			// the accept can get lost too, so it's always sent
+			SendDatagram( UDP_ACCEPT, NULL, 0, address );
+			if( IsConnectedTo( address ) == false )
+			{
+				mConnections.push_back( address );
+				return NewTransportPacket( address, TRANSPORT_CONNECTED, NULL, 0 );
+			}
+			break;
+
+		case UDP_ACCEPT:
+			if( std::find( mPendingConnects.begin(), mPendingConnects.end(), address ) != mPendingConnects.end() )
+			{
+				mPendingConnects.erase( std::remove( mPendingConnects.begin(), mPendingConnects.end(), address ), mPendingConnects.end() );
+				mConnections.push_back( address );
+				return NewTransportPacket( address, TRANSPORT_CONNECTED, NULL, 0 );
+			}
+			break;
+
+		case UDP_DATA:
+			if( IsConnectedTo( address ) && length > 0 )
+				return NewTransportPacket( address, TRANSPORT_DATA, data, length );
+			break;
+
+		case UDP_DISCONNECT:
+			if( IsConnectedTo( address ) )
+			{
+				RemoveConnection( address );
+				return NewTransportPacket( address, TRANSPORT_DISCONNECTED, NULL, 0 );
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+void CUdpTransport::DeallocatePacket( TransportPacket* packet )
+{
+	DeleteTransportPacket( packet );
+}
+
+//-----------------------------------------------------------------------------
+
+bool CUdpTransport::SendDatagram( unsigned char header, const unsigned char* data, unsigned int length, const TransportAddress& address )
+{
+	if( IsOpen() == false )
+		return false;
+
+	cassert( length + 1 <= UDP_MAX_DATAGRAM );
+	mSendBuffer.resize( length + 1 );
+	mSendBuffer[ 0 ] = header;
+	if( length > 0 )
+		std::memcpy( &mSendBuffer[ 1 ], data, length );
+
+	const sockaddr_in to = ToSockAddr( address );
+	const int sent = (int)sendto( mSocket, (const char*)&mSendBuffer[ 0 ], (int)mSendBuffer.size(), 0, (const sockaddr*)&to, sizeof( to ) );
+	return sent == (int)mSendBuffer.size();
+}
+
+bool CUdpTransport::IsConnectedTo( const TransportAddress& address ) const
+{
+	return std::find( mConnections.begin(), mConnections.end(), address ) != mConnections.end();
+}
+
+void CUdpTransport::RemoveConnection( const TransportAddress& address )
+{
+	mConnections.erase( std::remove( mConnections.begin(), mConnections.end(), address ), mConnections.end() );
+}
+
+//-----------------------------------------------------------------------------
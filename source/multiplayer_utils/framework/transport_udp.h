@@ -0,0 +1,86 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 - 2011 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+
+#ifndef INC_TRANSPORT_UDP_H
+#define INC_TRANSPORT_UDP_H
+
+#include <cstddef>
+#include <vector>
+
+#include "itransport.h"
+
+//-----------------------------------------------------------------------------
+// Plain UDP sockets on 127.0.0.1. It's here so the benchmarks can compare the
+// loopback with real sockets without RakNet. There's no reliability, only
+// the connection requests are resent until they're answered, which is
+// enough on localhost but not for anything else.
+//-----------------------------------------------------------------------------
+
+class CUdpTransport : public ITransport
+{
+public:
+	// binds to 127.0.0.1:port, with port 0 the OS picks one
+	explicit CUdpTransport( unsigned short port = 0 );
+	~CUdpTransport();
+
+	bool IsOpen() const;
+
+	// the TRANSPORT_CONNECTED comes when the other end has answered
+	void Connect( const TransportAddress& address );
+	void Disconnect( const TransportAddress& address );
+
+	virtual const char* GetName() const { return "udp"; }
+
+	virtual bool Send( const unsigned char* data, unsigned int length, const TransportAddress& address, bool broadcast, TransportDelivery delivery, int channel, TransportPriority priority );
+
+	virtual TransportPacket*	Receive();
+	virtual void				DeallocatePacket( TransportPacket* packet );
+
+	// resends the pending connection requests
+	virtual void Update();
+
+	virtual TransportAddress	GetLocalAddress() const { return mAddress; }
+	virtual int					GetConnectionCount() const { return (int)mConnections.size(); }
+
+private:
+	bool SendDatagram( unsigned char header, const unsigned char* data, unsigned int length, const TransportAddress& address );
+	bool IsConnectedTo( const TransportAddress& address ) const;
+	void RemoveConnection( const TransportAddress& address );
+
+	// a SOCKET on windows, a file descriptor on everything else
+	std::size_t						mSocket;
+	TransportAddress				mAddress;
+	std::vector< TransportAddress >	mConnections;
+	std::vector< TransportAddress >	mPendingConnects;
+	unsigned int					mLastConnectTime;
+	std::vector< unsigned char >	mSendBuffer;
+	std::vector< unsigned char >	mReceiveBuffer;
+
+	// can't be copied
+	CUdpTransport( const CUdpTransport& );
+	CUdpTransport& operator=( const CUdpTransport& );
+};
+
+//-----------------------------------------------------------------------------
+
+#endif
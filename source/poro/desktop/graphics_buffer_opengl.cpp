@@ -23,6 +23,8 @@
 #include "graphics_buffer_opengl.h"
 #include "texture_opengl.h"
 
+#include <cmath>
+
 namespace poro {
 namespace {
 Uint32 GetNextPowerOfTwo(Uint32 input)
@@ -93,15 +95,28 @@ void GraphicsBufferOpenGL::DrawTexture( ITexture* texture, types::vec2* vertices
 	GraphicsOpenGL::DrawTexture( texture, vertices, tex_coords, count, color );
 }
 
+void GraphicsBufferOpenGL::DrawTextureQuads( ITexture* texture, types::vec2* vertices, types::vec2* tex_coords, int count, const types::fcolor& color )
+{
+	//Flip cords for buffer
+	for (int i=0; i<count; ++i) {
+		vertices[i].x *= mBufferScale.x;
+		vertices[i].y *= mBufferScale.y;
+		vertices[i].y = poro::IPlatform::Instance()->GetInternalHeight() - vertices[i].y;
+	}
+	GraphicsOpenGL::DrawTextureQuads( texture, vertices, tex_coords, count, color );
+}
+
 void GraphicsBufferOpenGL::BeginRendering()
 {
 	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, mBufferId);
-	glPushAttrib(GL_VIEWPORT_BIT);
+	glPushAttrib(GL_VIEWPORT_BIT | GL_SCISSOR_BIT);
 	// glViewport(0,0,mTexture.GetWidth(),mTexture.GetHeight());
 	glViewport(0,0,mTexture.GetWidth(),mTexture.GetHeight());
 
-	glClearColor(0, 0, 0, 0);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	// with SetClearBackground( false ) the old content stays, so only the
+	// changed parts need to be redrawn
+	if( IGraphicsBuffer::mClearBackground )
+		Clear();
 }
 
 void GraphicsBufferOpenGL::EndRendering()
@@ -110,4 +125,31 @@ void GraphicsBufferOpenGL::EndRendering()
 	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
 }
 
+void GraphicsBufferOpenGL::SetClipRect( types::Float32 x, types::Float32 y, types::Float32 w, types::Float32 h )
+{
+	// same mapping as DrawTexture(), the flip and the projection cancel out so
+	// y grows up from the bottom of the texture
+	const float scale_x = mBufferScale.x * (float)mTexture.GetWidth() / (float)IPlatform::Instance()->GetInternalWidth();
+	const float scale_y = mBufferScale.y * (float)mTexture.GetHeight() / (float)IPlatform::Instance()->GetInternalHeight();
+
+	const GLint left = (GLint)floor( x * scale_x );
+	const GLint right = (GLint)ceil( ( x + w ) * scale_x );
+	const GLint bottom = (GLint)floor( y * scale_y );
+	const GLint top = (GLint)ceil( ( y + h ) * scale_y );
+
+	glEnable( GL_SCISSOR_TEST );
+	glScissor( left, bottom, right - left, top - bottom );
+}
+
+void GraphicsBufferOpenGL::ResetClipRect()
+{
+	glDisable( GL_SCISSOR_TEST );
+}
+
+void GraphicsBufferOpenGL::Clear()
+{
+	glClearColor(0, 0, 0, 0);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
 }
@@ -56,8 +56,14 @@ public:
 									int count, 
 									const types::fcolor& color );
 
+	virtual void		DrawTextureQuads( ITexture* texture, types::vec2* vertices, types::vec2* tex_coords, int count, const types::fcolor& color );
+
 	virtual void		BeginRendering();
 	virtual void		EndRendering();
+
+	virtual void		SetClipRect( types::Float32 x, types::Float32 y, types::Float32 w, types::Float32 h );
+	virtual void		ResetClipRect();
+	virtual void		Clear();
 	
 private:
 	void InitTexture(int width, int height);
@@ -0,0 +1,72 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#include "graphics_null.h"
+
+#include "../poro_macros.h"
+
+#define STBI_HEADER_FILE_ONLY
+#include "../external/stb_image.h"
+
+namespace poro {
+
+ITexture* GraphicsNull::CreateTexture( int width, int height )
+{
+	return new TextureNull( width, height );
+}
+
+ITexture* GraphicsNull::CloneTexture( ITexture* other )
+{
+	poro_assert( other );
+	return new TextureNull( other->GetWidth(), other->GetHeight(), other->GetFilename() );
+}
+
+//-----------------------------------------------------------------------------
+
+ITexture* GraphicsNull::LoadTexture( const types::string& filename )
+{
+	// only reads the header
+	int x = 0, y = 0, bpp = 0;
+	if( stbi_info( filename.c_str(), &x, &y, &bpp ) == 0 )
+	{
+		poro_logger << "Couldn't load image: " << filename << std::endl;
+		return NULL;
+	}
+
+	return new TextureNull( x, y, filename );
+}
+
+//-----------------------------------------------------------------------------
+
+IGraphicsBuffer* GraphicsNull::CreateGraphicsBuffer( int width, int height )
+{
+	GraphicsBufferNull* buffer = new GraphicsBufferNull;
+	buffer->Init( width, height );
+	return buffer;
+}
+
+void GraphicsNull::DestroyGraphicsBuffer( IGraphicsBuffer* buffer )
+{
+	delete buffer;
+}
+
+//-----------------------------------------------------------------------------
+
+} // end o namespace poro
@@ -0,0 +1,112 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#ifndef INC_GRAPHICS_NULL_H
+#define INC_GRAPHICS_NULL_H
+
+#include "../poro_types.h"
+#include "../igraphics.h"
+#include "../igraphics_buffer.h"
+#include "../itexture.h"
+
+namespace poro {
+
+// Texture that only knows its size, for running without a window.
+class TextureNull : public ITexture
+{
+public:
+	TextureNull( int width, int height, const types::string& filename = "" ) : 
+		mWidth( width ), 
+		mHeight( height ), 
+		mFilename( filename ) 
+	{ 
+	}
+
+	virtual int GetWidth() const	{ return mWidth; }
+	virtual int GetHeight() const	{ return mHeight; }
+
+	virtual void SetUVCoords( float x1, float y1, float x2, float y2 ) { }
+	virtual void SetExternalSize( int width, int height ) { mWidth = width; mHeight = height; }
+
+	virtual types::string GetFilename() const { return mFilename; }
+
+private:
+	int				mWidth;
+	int				mHeight;
+	types::string	mFilename;
+};
+
+//-----------------------------------------------------------------------------
+
+// Graphics that don't draw anything. Used when an input recording is played 
+// back without a window, the textures are loaded only far enough to know 
+// their size, so the layout of the game stays the same.
+class GraphicsNull : public IGraphics
+{
+public:
+	virtual bool		Init( int width, int height, bool fullscreen, const types::string& caption ) { return true; }
+	virtual void		SetInternalSize( types::Float32 width, types::Float32 height ) { }
+	virtual void		SetWindowSize( int width, int height ) { }
+	virtual void		SetFullscreen( bool fullscreen ) { }
+	virtual bool		GetFullscreen() { return false; }
+
+	virtual ITexture*	CreateTexture( int width, int height );
+	virtual ITexture*	CloneTexture( ITexture* other );
+	virtual void		SetTextureData( ITexture* texture, void* data ) { }
+	virtual ITexture*	LoadTexture( const types::string& filename );
+	virtual void		ReleaseTexture( ITexture* texture ) { }
+
+	virtual void		BeginRendering() { }
+	virtual void		EndRendering() { }
+
+	virtual void		DrawTexture(	ITexture* texture,
+										types::Float32 x, types::Float32 y, types::Float32 w, types::Float32 h,
+										const types::fcolor& color, types::Float32 rotation ) { }
+	virtual void		DrawTexture( ITexture* texture, types::vec2* vertices, types::vec2* tex_coords, int count, const types::fcolor& color ) { }
+	virtual void		DrawTextureQuads( ITexture* texture, types::vec2* vertices, types::vec2* tex_coords, int count, const types::fcolor& color ) { }
+	virtual void		DrawTextureWithAlpha( ITexture* texture, types::vec2* vertices, types::vec2* tex_coords, int count, const types::fcolor& color,
+		ITexture* alpha_texture, types::vec2* alpha_vertices, types::vec2* alpha_tex_coords, const types::fcolor& alpha_color ) { }
+	virtual void		DrawLineSegments( const std::vector< poro::types::vec2 >& vertices, const types::fcolor& color, bool smooth, float width ) { }
+
+	virtual IGraphicsBuffer* CreateGraphicsBuffer( int width, int height );
+	virtual void		DestroyGraphicsBuffer( IGraphicsBuffer* buffer );
+};
+
+//-----------------------------------------------------------------------------
+
+class GraphicsBufferNull : public IGraphicsBuffer
+{
+public:
+	GraphicsBufferNull() : mTexture( 0, 0 ) { }
+
+	virtual bool		Init( int width, int height, bool fullscreen = false, const types::string& caption = "" ) { mTexture.SetExternalSize( width, height ); return true; }
+	virtual ITexture*	GetTexture() { return &mTexture; }
+
+	virtual void		SetInternalSize( types::Float32 width, types::Float32 height ) { }
+	virtual void		BeginRendering() { }
+	virtual void		EndRendering() { }
+
+private:
+	TextureNull mTexture;
+};
+
+} // end o namespace poro
+
+#endif
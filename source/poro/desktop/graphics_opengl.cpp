@@ -736,6 +736,44 @@ void GraphicsOpenGL::DrawTexture( ITexture* itexture, types::vec2* vertices, typ
 
 //-----------------------------------------------------------------------------
 
+void GraphicsOpenGL::DrawTextureQuads( ITexture* itexture, types::vec2* vertices, types::vec2* tex_coords, int count, const types::fcolor& color )
+{
+	if( itexture == NULL || count < 4 )
+		return;
+
+	if( color[3] <= 0 )
+		return;
+
+	TextureOpenGL* texture = (TextureOpenGL*)itexture;
+
+	// two triangles for every quad
+	static std::vector< Vertex > vert;
+	const int quad_count = count / 4;
+	if( (int)vert.size() < quad_count * 6 )
+		vert.resize( quad_count * 6 );
+
+	static const int quad_order[ 6 ] = { 0, 1, 2, 0, 2, 3 };
+
+	float x_text_conv = ( 1.f / texture->mWidth ) * ( texture->mUv[ 2 ] - texture->mUv[ 0 ] ) * texture->mExternalSizeX;
+	float y_text_conv = ( 1.f / texture->mHeight ) * ( texture->mUv[ 3 ] - texture->mUv[ 1 ] ) * texture->mExternalSizeY;
+	for( int q = 0; q < quad_count; ++q )
+	{
+		for( int i = 0; i < 6; ++i )
+		{
+			const int j = q * 4 + quad_order[ i ];
+			Vertex& v = vert[ q * 6 + i ];
+			v.x = vertices[ j ].x;
+			v.y = vertices[ j ].y;
+			v.tx = texture->mUv[ 0 ] + ( tex_coords[ j ].x * x_text_conv );
+			v.ty = texture->mUv[ 1 ] + ( tex_coords[ j ].y * y_text_conv );
+		}
+	}
+
+	drawsprite( texture, &vert[ 0 ], color, quad_count * 6, GL_TRIANGLES, mBlendMode );
+}
+
+//-----------------------------------------------------------------------------
+
 void GraphicsOpenGL::DrawTextureWithAlpha(
 		ITexture* itexture, types::vec2* vertices, types::vec2* tex_coords, int count, const types::fcolor& color,
 		ITexture* ialpha_texture, types::vec2* alpha_vertices, types::vec2* alpha_tex_coords, const types::fcolor& alpha_color )
@@ -807,6 +845,29 @@ void GraphicsOpenGL::EndRendering()
 	SDL_GL_SwapBuffers();
 }
 
+void GraphicsOpenGL::SetClipRect( types::Float32 x, types::Float32 y, types::Float32 w, types::Float32 h )
+{
+	// the internal coordinates go down from the top of the letterboxed viewport,
+	// glScissor() wants window pixels from the bottom. Rounded outwards so the
+	// edge pixels the sprites touch are inside.
+	const float internal_h = (float)IPlatform::Instance()->GetInternalHeight();
+	const float scale_x = mViewportSize.x / (float)IPlatform::Instance()->GetInternalWidth();
+	const float scale_y = mViewportSize.y / internal_h;
+
+	const GLint left = (GLint)floor( mViewportOffset.x + x * scale_x );
+	const GLint right = (GLint)ceil( mViewportOffset.x + ( x + w ) * scale_x );
+	const GLint bottom = (GLint)floor( mViewportOffset.y + ( internal_h - y - h ) * scale_y );
+	const GLint top = (GLint)ceil( mViewportOffset.y + ( internal_h - y ) * scale_y );
+
+	glEnable( GL_SCISSOR_TEST );
+	glScissor( left, bottom, right - left, top - bottom );
+}
+
+void GraphicsOpenGL::ResetClipRect()
+{
+	glDisable( GL_SCISSOR_TEST );
+}
+
 //=============================================================================
 
 void GraphicsOpenGL::DrawLines( const std::vector< poro::types::vec2 >& vertices, const types::fcolor& color, bool smooth, float width, bool loop )
@@ -841,6 +902,36 @@ void GraphicsOpenGL::DrawLines( const std::vector< poro::types::vec2 >& vertices
 
 //-----------------------------------------------------------------------------
 
+void GraphicsOpenGL::DrawLineSegments( const std::vector< poro::types::vec2 >& vertices, const types::fcolor& color, bool smooth, float width )
+{
+	if( vertices.size() < 2 )
+		return;
+
+	glEnable(GL_BLEND);
+
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glLineWidth( width );
+
+	if( smooth ) {
+		glEnable(GL_LINE_SMOOTH);
+		glHint(GL_LINE_SMOOTH_HINT, GL_NICEST); 
+	}
+	glColor4f( color[ 0 ], color[ 1 ], color[ 2 ], color[ 3 ] );
+
+	// vec2 is two floats, so the vector can be handed to GL as it is
+	glVertexPointer(2, GL_FLOAT, sizeof( poro::types::vec2 ), &vertices[ 0 ].x);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glDrawArrays(GL_LINES, 0, (GLsizei)( vertices.size() & ~1 ) );
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	if( smooth ) 
+		glDisable( GL_LINE_SMOOTH );
+
+	glDisable(GL_BLEND);
+}
+
+//-----------------------------------------------------------------------------
+
 void GraphicsOpenGL::DrawFill( const std::vector< poro::types::vec2 >& vertices, const types::fcolor& color )
 {
 	int vertCount = vertices.size();
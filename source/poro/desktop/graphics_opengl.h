@@ -68,6 +68,7 @@ public:
 										int count, 
 										const types::fcolor& color );
 	
+	virtual void		DrawTextureQuads( ITexture* texture, types::vec2* vertices, types::vec2* tex_coords, int count, const types::fcolor& color );
 	virtual void		DrawTextureWithAlpha( 
 		ITexture* texture, 
 		types::vec2* vertices, 
@@ -82,8 +83,12 @@ public:
 
 	virtual void		BeginRendering();
 	virtual void		EndRendering();
+
+	virtual void		SetClipRect( types::Float32 x, types::Float32 y, types::Float32 w, types::Float32 h );
+	virtual void		ResetClipRect();
 	
 	virtual void		DrawLines( const std::vector< poro::types::vec2 >& vertices, const types::fcolor& color, bool smooth, float width, bool loop );
+	virtual void		DrawLineSegments( const std::vector< poro::types::vec2 >& vertices, const types::fcolor& color, bool smooth, float width );
 	virtual void		DrawFill( const std::vector< poro::types::vec2 >& vertices, const types::fcolor& color );
 	virtual void		DrawTexturedRect( const poro::types::vec2& position, const poro::types::vec2& size, ITexture* itexture );
 	
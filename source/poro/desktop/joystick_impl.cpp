@@ -36,7 +36,8 @@ namespace {
 }
 
 JoystickImpl::JoystickImpl( int id ) :
-	Joystick( id )
+	Joystick( id ),
+	mNextConnectionCheck( 0 )
 {
 }
 
@@ -34,6 +34,15 @@ public:
 	// values are between [0 and 1]
 	// can be implemented on the platform is available
 	void Vibrate( const types::vec2& motor_forces );
+
+	// asking a controller that isn't there is slow (with XInput it goes 
+	// through the usb devices every time), so the missing ones are only
+	// checked every now and then
+	bool NeedsPolling( types::Float32 time ) const { return GetConnected() || time >= mNextConnectionCheck; }
+	void SetNextConnectionCheck( types::Float32 time ) { mNextConnectionCheck = time; }
+
+private:
+	types::Float32 mNextConnectionCheck;
 };
 
 void HandleJoystickImpl( JoystickImpl* joystick );
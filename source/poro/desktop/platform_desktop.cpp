@@ -24,17 +24,74 @@
 #include "../libraries.h"
 
 #include "graphics_opengl.h"
+#include "graphics_null.h"
 #include "soundplayer_sdl.h"
 #include "joystick_impl.h"
 
+#ifdef CENG_ALLOCATION_TRACKER_ENABLED
+#	include "../../utils/memorypool/callocationtracker.h"
+#endif
+
+#ifndef PORO_PLAT_WINDOWS
+#	include <sys/time.h>
+#endif
+
 namespace poro {
 
 const int PORO_WINDOWS_JOYSTICK_COUNT = 4;
 
+// seconds between the checks for a joystick that isn't connected
+const types::Float32 PORO_JOYSTICK_CONNECTION_CHECK_INTERVAL = 1.f;
+
+namespace {
+
+	// SDL 1.2 events don't have timestamps and SDL_GetTicks() is in 
+	// milliseconds, so the events get this when they're taken out of SDL
+	double GetPreciseTime()
+	{
+#ifdef PORO_PLAT_WINDOWS
+		LARGE_INTEGER frequency;
+		LARGE_INTEGER counter;
+		QueryPerformanceFrequency( &frequency );
+		QueryPerformanceCounter( &counter );
+		return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+		timeval time;
+		gettimeofday( &time, NULL );
+		return (double)time.tv_sec + (double)time.tv_usec * 0.000001;
+#endif
+	}
+
+	int ConvertMouseButton( Uint8 button )
+	{
+		switch( button )
+		{
+			case SDL_BUTTON_LEFT:		return Mouse::MOUSE_BUTTON_LEFT;
+			case SDL_BUTTON_RIGHT:		return Mouse::MOUSE_BUTTON_RIGHT;
+			case SDL_BUTTON_MIDDLE:		return Mouse::MOUSE_BUTTON_MIDDLE;
+			case SDL_BUTTON_WHEELUP:	return Mouse::MOUSE_BUTTON_WHEEL_UP;
+			case SDL_BUTTON_WHEELDOWN:	return Mouse::MOUSE_BUTTON_WHEEL_DOWN;
+		}
+		return 0;
+	}
+
+	InputEvent MakeInputEvent( int type, int id, int button, types::charset unicode, const types::vec2& value )
+	{
+		InputEvent result;
+		result.type = type;
+		result.id = id;
+		result.button = button;
+		result.unicode = unicode;
+		result.value = value;
+		return result;
+	}
+}
+
 //-----------------------------------------------------------------------------
 
 PlatformDesktop::PlatformDesktop() :
 	mGraphics( NULL ),
+	mWindowGraphics( NULL ),
 	mFrameCount( 0 ),
 	mFrameRate( 0 ),
 	mOneFrameShouldLast( 1.f / 60.f ),
@@ -48,7 +105,13 @@ PlatformDesktop::PlatformDesktop() :
 	mSoundPlayer( NULL ),
 	mRunning( 0 ),
 	mMousePos(),
-	mSleepingMode( PORO_MAXIMIZE_SLEEP )
+	mSleepingMode( PORO_MAXIMIZE_SLEEP ),
+	mInputQueue(),
+	mInputRecorder(),
+	mInputReplayer(),
+	mReplayingInput( false ),
+	mFrameTimingFile(),
+	mFrameTimings()
 {
 
 }
@@ -68,7 +131,17 @@ void PlatformDesktop::Init( IApplication* application, int w, int h, bool fullsc
 	mHeight = h;
 	mApplication = application;
 
-	mGraphics = new GraphicsOpenGL;
+	if( mReplayingInput ) 
+	{
+		// no window, SDL is only needed for the timer
+		SDL_Init( SDL_INIT_TIMER | SDL_INIT_NOPARACHUTE );
+		mGraphics = new GraphicsNull;
+	}
+	else
+	{
+		mWindowGraphics = new GraphicsOpenGL;
+		mGraphics = mWindowGraphics;
+	}
 	mGraphics->Init(w, h, fullscreen, title);
 
 	mSoundPlayer = new SoundPlayerSDL;
@@ -83,7 +156,8 @@ void PlatformDesktop::Init( IApplication* application, int w, int h, bool fullsc
 		mJoysticks[ i ] = new JoystickImpl( i );
 	}
 
-	SDL_EnableUNICODE(1);
+	if( mReplayingInput == false )
+		SDL_EnableUNICODE(1);
 }
 //-----------------------------------------------------------------------------
 
@@ -91,6 +165,7 @@ void PlatformDesktop::Destroy()
 {
 	delete mGraphics;
 	mGraphics = NULL;
+	mWindowGraphics = NULL;
 
 	delete mSoundPlayer;
 	mSoundPlayer = NULL;
@@ -131,12 +206,16 @@ void PlatformDesktop::StartMainLoop()
 			mRunning = false;
 
 
-        const types::Float32 time_after = GetUpTime();
-        const types::Float32 elapsed_time = ( time_after - time_before );
-        if( elapsed_time < mOneFrameShouldLast )
-            Sleep( mOneFrameShouldLast - elapsed_time );
+		// replays go as fast as they can
+		if( mReplayingInput == false )
+		{
+			const types::Float32 time_after = GetUpTime();
+			const types::Float32 elapsed_time = ( time_after - time_before );
+			if( elapsed_time < mOneFrameShouldLast )
+				Sleep( mOneFrameShouldLast - elapsed_time );
 
-		while( ( GetUpTime() - time_before ) < mOneFrameShouldLast ) { Sleep( 0 ); }
+			while( ( GetUpTime() - time_before ) < mOneFrameShouldLast ) { Sleep( 0 ); }
+		}
 
         // frame-rate check
         mFrameCount++;
@@ -154,29 +233,82 @@ void PlatformDesktop::StartMainLoop()
 
 	if( mApplication )
 		mApplication->Exit();
+
+	mInputRecorder.Close();
+
+	if( mFrameTimingFile.empty() == false )
+	{
+		if( mFrameTimings.Save( mFrameTimingFile ) == false )
+			poro_logger << "Couldn't write frame timings: " << mFrameTimingFile << std::endl;
+
+		poro_logger << "Frames: " << mFrameTimings.GetFrames().size() 
+			<< ", average: " << mFrameTimings.GetAverage() << " ms" 
+			<< ", 95%: " << mFrameTimings.GetPercentile( 95 ) << " ms" 
+			<< ", max: " << mFrameTimings.GetPercentile( 100 ) << " ms" << std::endl;
+	}
 }
 //-----------------------------------------------------------------------------
 
 void PlatformDesktop::SingleLoop() 
 {
+	const double time_start = GetPreciseTime();
+
 	HandleEvents();
 
+	// the recording ran out
+	if( mReplayingInput && mRunning == false )
+		return;
+
 	poro_assert( GetApplication() );
 
 	float dt = mOneFrameShouldLast;
-	if( mFixedTimeStep == false )
+	if( mReplayingInput )
+	{
+		dt = mInputReplayer.GetDt();
+	}
+	else if( mFixedTimeStep == false )
 	{
 		static types::Float32 last_time_update_called = 0;
 		dt = ( GetUpTime() - last_time_update_called );
 		last_time_update_called = GetUpTime();
 	}
 
+	if( mInputRecorder.IsOpen() )
+		mInputRecorder.EndFrame( dt );
+
+	const double time_events = GetPreciseTime();
+
 	GetApplication()->Update( dt );
 
+	const double time_update = GetPreciseTime();
+
+	if( mSoundPlayer )
+		mSoundPlayer->Update();
+
+	const double time_sound = GetPreciseTime();
+
 	mGraphics->BeginRendering();
 	GetApplication ()->Draw(mGraphics);
 	mGraphics->EndRendering();
 
+	if( mFrameTimingFile.empty() == false )
+	{
+		const double time_end = GetPreciseTime();
+
+		FrameTimingLog::Frame frame;
+		frame.frame = mFrameCount;
+		frame.dt = dt;
+		frame.events = ( time_events - time_start ) * 1000.0;
+		frame.update = ( time_update - time_events ) * 1000.0;
+		frame.sound = ( time_sound - time_update ) * 1000.0;
+		frame.draw = ( time_end - time_sound ) * 1000.0;
+		frame.total = ( time_end - time_start ) * 1000.0;
+		mFrameTimings.Add( frame );
+	}
+
+#ifdef CENG_ALLOCATION_TRACKER_ENABLED
+	ceng::CAllocationTracker::EndFrame();
+#endif
 }
 //-----------------------------------------------------------------------------
 
@@ -196,34 +328,44 @@ void PlatformDesktop::Sleep( types::Float32 seconds )
 
 void PlatformDesktop::HandleEvents() 
 {
+	if( mReplayingInput ) 
+	{
+		DispatchReplayEvents();
+		return;
+	}
+
 	//---------
+	const types::Float32 now = GetUpTime();
 	for( std::size_t i = 0; i < mJoysticks.size(); ++i ) {
+		if( mJoysticks[ i ]->NeedsPolling( now ) == false )
+			continue;
+
 		HandleJoystickImpl( mJoysticks[ i ] );
+		if( mJoysticks[ i ]->GetConnected() == false )
+			mJoysticks[ i ]->SetNextConnectionCheck( now + PORO_JOYSTICK_CONNECTION_CHECK_INTERVAL );
+
+		if( mInputRecorder.IsOpen() )
+			mInputRecorder.AddJoystick( mJoysticks[ i ] );
 	}
 
 	//---------
 
+	mInputQueue.BeginFrame();
+
+	InputQueue::Event input;
 	SDL_Event event;
 	while( SDL_PollEvent( &event ) )
 	{
+		input.time = GetPreciseTime();
+
 		switch( event.type )
 		{
 			case SDL_KEYDOWN:
-			{
-				if( mKeyboard )
-					mKeyboard->FireKeyDownEvent(
-						static_cast< int >( event.key.keysym.sym ),
-						static_cast< types::charset >( event.key.keysym.unicode ) );
-			}
-			break;
-
 			case SDL_KEYUP:
-			{
-				if( mKeyboard )
-					mKeyboard->FireKeyUpEvent(
-						static_cast< int >( event.key.keysym.sym ),
-						static_cast< types::charset >( event.key.keysym.unicode )  );
-			}
+				input.type = ( event.type == SDL_KEYDOWN ) ? InputQueue::Event::KEY_DOWN : InputQueue::Event::KEY_UP;
+				input.button = static_cast< int >( event.key.keysym.sym );
+				input.unicode = static_cast< types::charset >( event.key.keysym.unicode );
+				mInputQueue.Push( input );
 			break;
 
 			case SDL_QUIT:
@@ -231,60 +373,203 @@ void PlatformDesktop::HandleEvents()
 			break;
 
 			case SDL_MOUSEBUTTONDOWN:
-				poro_assert( mMouse );
-				if( event.button.button == SDL_BUTTON_LEFT )
-				{
-					mMouse->FireMouseDownEvent( mMousePos, Mouse::MOUSE_BUTTON_LEFT );
-					if( mTouch ) 
-						mTouch->FireTouchDownEvent( mMousePos, 0 );
-				}
-				else if( event.button.button == SDL_BUTTON_RIGHT )
-				{
-					mMouse->FireMouseDownEvent( mMousePos, Mouse::MOUSE_BUTTON_RIGHT );
-				}
-				else if( event.button.button == SDL_BUTTON_MIDDLE )
-				{
-					mMouse->FireMouseDownEvent( mMousePos, Mouse::MOUSE_BUTTON_MIDDLE );
-				}
-				else if( event.button.button == SDL_BUTTON_WHEELUP )
-				{
-					mMouse->FireMouseDownEvent( mMousePos, Mouse::MOUSE_BUTTON_WHEEL_UP );
-				}
-				else if( event.button.button == SDL_BUTTON_WHEELDOWN )
-				{
-					mMouse->FireMouseDownEvent( mMousePos, Mouse::MOUSE_BUTTON_WHEEL_DOWN );
-				}
-				break;
-
 			case SDL_MOUSEBUTTONUP:
-				poro_assert( mMouse );
-				if( event.button.button == SDL_BUTTON_LEFT )
-				{
-					mMouse->FireMouseUpEvent( mMousePos, Mouse::MOUSE_BUTTON_LEFT );
-					if( mTouch ) 
-						mTouch->FireTouchUpEvent( mMousePos, 0 );
-				}
-				else if( event.button.button == SDL_BUTTON_RIGHT )
-				{
-					mMouse->FireMouseUpEvent( mMousePos, Mouse::MOUSE_BUTTON_RIGHT );
-				}
-				else if( event.button.button == SDL_BUTTON_MIDDLE )
-				{
-					mMouse->FireMouseUpEvent( mMousePos, Mouse::MOUSE_BUTTON_MIDDLE );
-				}
-				break;
+				input.type = ( event.type == SDL_MOUSEBUTTONDOWN ) ? InputQueue::Event::MOUSE_DOWN : InputQueue::Event::MOUSE_UP;
+				input.button = ConvertMouseButton( event.button.button );
+				input.x = event.button.x;
+				input.y = event.button.y;
+				// the wheel only sends the downs
+				if( input.button != 0 && ( input.type == InputQueue::Event::MOUSE_DOWN || input.button < Mouse::MOUSE_BUTTON_WHEEL_UP ) )
+					mInputQueue.Push( input );
+			break;
 
 			case SDL_MOUSEMOTION:
-				poro_assert( mMouse );
-				{
-				    mMousePos = mGraphics->ConvertToInternalPos( event.motion.x, event.motion.y );
-					mMouse->FireMouseMoveEvent( mMousePos );
-					if( mTouch && mTouch->IsTouchIdDown( 0 ) ) 
-						mTouch->FireTouchMoveEvent( mMousePos, 0 );
-				}
-				break;
+				input.type = InputQueue::Event::MOUSE_MOVE;
+				input.x = event.motion.x;
+				input.y = event.motion.y;
+				mInputQueue.Push( input );
+			break;
 		}
 	}
+
+	DispatchInputEvents();
+}
+//-----------------------------------------------------------------------------
+
+void PlatformDesktop::DispatchInputEvents()
+{
+	const types::vec2 no_position;
+	const std::vector< InputQueue::Event >& events = mInputQueue.GetEvents();
+	for( std::size_t i = 0; i < events.size(); ++i )
+	{
+		const InputQueue::Event& input = events[ i ];
+		switch( input.type )
+		{
+			case InputQueue::Event::KEY_DOWN:
+				FireInputEvent( MakeInputEvent( InputEvent::KEY_DOWN, 0, input.button, input.unicode, no_position ) );
+			break;
+
+			case InputQueue::Event::KEY_UP:
+				FireInputEvent( MakeInputEvent( InputEvent::KEY_UP, 0, input.button, input.unicode, no_position ) );
+			break;
+
+			case InputQueue::Event::MOUSE_DOWN:
+				FireInputEvent( MakeInputEvent( InputEvent::MOUSE_DOWN, 0, input.button, 0, mMousePos ) );
+				if( mTouch && input.button == Mouse::MOUSE_BUTTON_LEFT ) 
+					FireInputEvent( MakeInputEvent( InputEvent::TOUCH_DOWN, 0, 0, 0, mMousePos ) );
+			break;
+
+			case InputQueue::Event::MOUSE_UP:
+				FireInputEvent( MakeInputEvent( InputEvent::MOUSE_UP, 0, input.button, 0, mMousePos ) );
+				if( mTouch && input.button == Mouse::MOUSE_BUTTON_LEFT ) 
+					FireInputEvent( MakeInputEvent( InputEvent::TOUCH_UP, 0, 0, 0, mMousePos ) );
+			break;
+
+			case InputQueue::Event::MOUSE_MOVE:
+				FireInputEvent( MakeInputEvent( InputEvent::MOUSE_MOVE, 0, 0, 0, ConvertMouseToInternalSize( input.x, input.y ) ) );
+				if( mTouch && mTouch->IsTouchIdDown( 0 ) ) 
+					FireInputEvent( MakeInputEvent( InputEvent::TOUCH_MOVE, 0, 0, 0, mMousePos ) );
+			break;
+		}
+	}
+}
+//-----------------------------------------------------------------------------
+
+void PlatformDesktop::DispatchReplayEvents()
+{
+	if( mInputReplayer.NextFrame() == false )
+	{
+		mRunning = false;
+		return;
+	}
+
+	const std::vector< InputEvent >& events = mInputReplayer.GetEvents();
+	for( std::size_t i = 0; i < events.size(); ++i )
+		FireInputEvent( events[ i ] );
+
+	if( mInputRecorder.IsOpen() )
+	{
+		for( std::size_t i = 0; i < mJoysticks.size(); ++i )
+			mInputRecorder.AddJoystick( mJoysticks[ i ] );
+	}
+}
+//-----------------------------------------------------------------------------
+
+// The joystick events aren't recorded here, the recorder picks up the changes
+// with AddJoystick()
+void PlatformDesktop::FireInputEvent( const InputEvent& event )
+{
+	if( event.type < InputEvent::JOY_CONNECTED && mInputRecorder.IsOpen() )
+		mInputRecorder.Add( event );
+
+	Joystick* joystick = NULL;
+	if( event.type >= InputEvent::JOY_CONNECTED )
+	{
+		if( event.id < 0 || event.id >= (int)mJoysticks.size() )
+			return;
+		joystick = mJoysticks[ event.id ];
+	}
+
+	switch( event.type )
+	{
+		case InputEvent::MOUSE_MOVE:
+			poro_assert( mMouse );
+			mMousePos = event.value;
+			mMouse->FireMouseMoveEvent( mMousePos );
+		break;
+
+		case InputEvent::MOUSE_DOWN:
+			poro_assert( mMouse );
+			mMouse->FireMouseDownEvent( event.value, event.button );
+		break;
+
+		case InputEvent::MOUSE_UP:
+			poro_assert( mMouse );
+			mMouse->FireMouseUpEvent( event.value, event.button );
+		break;
+
+		case InputEvent::KEY_DOWN:
+			if( mKeyboard )
+				mKeyboard->FireKeyDownEvent( event.button, event.unicode );
+		break;
+
+		case InputEvent::KEY_UP:
+			if( mKeyboard )
+				mKeyboard->FireKeyUpEvent( event.button, event.unicode );
+		break;
+
+		case InputEvent::TOUCH_MOVE:
+			if( mTouch )
+				mTouch->FireTouchMoveEvent( event.value, event.id );
+		break;
+
+		case InputEvent::TOUCH_DOWN:
+			if( mTouch )
+				mTouch->FireTouchDownEvent( event.value, event.id );
+		break;
+
+		case InputEvent::TOUCH_UP:
+			if( mTouch )
+				mTouch->FireTouchUpEvent( event.value, event.id );
+		break;
+
+		case InputEvent::JOY_CONNECTED:
+		case InputEvent::JOY_DISCONNECTED:
+			joystick->SetConnected( event.type == InputEvent::JOY_CONNECTED );
+		break;
+
+		case InputEvent::JOY_BUTTON_DOWN:
+		case InputEvent::JOY_BUTTON_UP:
+			if( event.button < Joystick::JOY_BUTTON_COUNT )
+				joystick->SetButtonState( event.button, event.type == InputEvent::JOY_BUTTON_DOWN );
+		break;
+
+		case InputEvent::JOY_LEFT_STICK:
+			joystick->SetLeftStick( event.value );
+		break;
+
+		case InputEvent::JOY_RIGHT_STICK:
+			joystick->SetRightStick( event.value );
+		break;
+
+		case InputEvent::JOY_ANALOG:
+			if( event.button <= Joystick::JOY_BUTTON_ANALOG_09_MOVED - Joystick::JOY_BUTTON_ANALOG_00_MOVED )
+				joystick->SetAnalogButton( event.button, event.value.x );
+		break;
+	}
+}
+//-----------------------------------------------------------------------------
+
+bool PlatformDesktop::SetInputRecording( const types::string& filename )
+{
+	if( mInputRecorder.Open( filename ) )
+		return true;
+
+	poro_logger << "Couldn't open the input recording: " << filename << std::endl;
+	return false;
+}
+
+bool PlatformDesktop::SetInputReplay( const types::string& filename )
+{
+	// the window is already open
+	poro_assert( mGraphics == NULL );
+
+	mReplayingInput = mInputReplayer.Open( filename );
+	if( mReplayingInput == false )
+		poro_logger << "Couldn't load the input recording: " << filename << std::endl;
+
+	return mReplayingInput;
+}
+//-----------------------------------------------------------------------------
+
+types::vec2 PlatformDesktop::ConvertMouseToInternalSize( int x, int y )
+{
+	// only the window has pixels to convert, replays are in the internal size
+	poro_assert( mWindowGraphics );
+	if( mWindowGraphics == NULL )
+		return types::vec2( (types::Float32)x, (types::Float32)y );
+
+	return mWindowGraphics->ConvertToInternalPos( x, y );
 }
 //-----------------------------------------------------------------------------
 
@@ -27,6 +27,9 @@
 #include "../mouse.h"
 #include "../keyboard.h"
 #include "../touch.h"
+#include "../input_queue.h"
+#include "../input_recording.h"
+#include "../frame_timing_log.h"
 #include "graphics_opengl.h"
 #include "soundplayer_sdl.h"
 
@@ -83,11 +86,33 @@ public:
 
 	void			HandleEvents();
 
+	// the mouse and keyboard events of the frame, before and after coalescing
+	InputQueue&		GetInputQueue();
+
+	// records the input of every frame and its dt to the file
+	bool			SetInputRecording( const types::string& filename );
+
+	// plays a recording back instead of the real input, with the recorded 
+	// dt and as fast as it goes, without a window. Has to be called before
+	// Init(), the main loop ends when the recording does.
+	bool			SetInputReplay( const types::string& filename );
+	bool			IsReplayingInput() const;
+
+	// the timings of every frame are written to the .csv file when the main 
+	// loop ends
+	void			SetFrameTimingDump( const types::string& filename );
+	const FrameTimingLog& GetFrameTimings() const;
+
 protected:
+	void			DispatchInputEvents();
+	void			DispatchReplayEvents();
+	void			FireInputEvent( const InputEvent& event );
 
 	types::vec2		ConvertMouseToInternalSize( int x, int y );
 
-	GraphicsOpenGL*				    mGraphics;
+	IGraphics*					    mGraphics;
+	// the same as mGraphics when there's a window, NULL when replaying
+	GraphicsOpenGL*					mWindowGraphics;
 	bool							mFixedTimeStep;
 	int							    mFrameCount;
 	int				                mFrameRate;
@@ -102,6 +127,12 @@ protected:
 	bool						    mRunning;
 	types::vec2					    mMousePos;
 	int								mSleepingMode;
+	InputQueue						mInputQueue;
+	InputRecorder					mInputRecorder;
+	InputReplayer					mInputReplayer;
+	bool							mReplayingInput;
+	types::string					mFrameTimingFile;
+	FrameTimingLog					mFrameTimings;
 
 private:
 };
@@ -153,6 +184,22 @@ inline int	PlatformDesktop::GetJoystickCount() const  {
 	return (int)mJoysticks.size();
 }
 
+inline InputQueue& PlatformDesktop::GetInputQueue() {
+	return mInputQueue;
+}
+
+inline bool PlatformDesktop::IsReplayingInput() const {
+	return mReplayingInput;
+}
+
+inline void PlatformDesktop::SetFrameTimingDump( const types::string& filename ) {
+	mFrameTimingFile = filename;
+}
+
+inline const FrameTimingLog& PlatformDesktop::GetFrameTimings() const {
+	return mFrameTimings;
+}
+
 // ---
 inline void PlatformDesktop::SetFrameRate( int targetRate, bool fixed_time_step ) {
 	mFrameRate = targetRate;
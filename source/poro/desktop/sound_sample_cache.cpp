@@ -0,0 +1,381 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#include "sound_sample_cache.h"
+#include "../libraries.h"
+#include "../poro_macros.h"
+
+namespace poro {
+
+struct SoundSampleCache::Entry
+{
+	enum State
+	{
+		LOADING,
+		READY,
+		FAILED
+	};
+
+	Entry( const types::string& filename ) :
+		filename( filename ),
+		samples( NULL ),
+		bytes( 0 ),
+		references( 0 ),
+		state( LOADING ),
+		idle( false ),
+		idle_position()
+	{ }
+
+	types::string					filename;
+	void*							samples;
+	std::size_t						bytes;
+	int								references;
+	State							state;
+	bool							idle;
+	std::list< Entry* >::iterator	idle_position;
+};
+
+//-----------------------------------------------------------------------------
+
+SoundSampleCache::SoundSampleCache( LoadFunc load_func, FreeFunc free_func, std::size_t budget_bytes ) :
+	mLoadFunc( load_func ),
+	mFreeFunc( free_func ),
+	mBudget( budget_bytes ),
+	mEntries(),
+	mIdle(),
+	mStats(),
+	mDestroyed( false ),
+	mFailedEntries( 0 ),
+	mMutex( SDL_CreateMutex() ),
+	mLoaded( SDL_CreateCond() ),
+	mWork( SDL_CreateCond() ),
+	mThread( NULL ),
+	mQueue(),
+	mQuit( false )
+{
+	poro_assert( mLoadFunc );
+	poro_assert( mFreeFunc );
+}
+
+SoundSampleCache::~SoundSampleCache()
+{
+	poro_assert( mEntries.empty() );
+	poro_assert( mFailedEntries == 0 );
+	SDL_DestroyCond( mWork );
+	SDL_DestroyCond( mLoaded );
+	SDL_DestroyMutex( mMutex );
+}
+
+void SoundSampleCache::Destroy()
+{
+	if( mThread )
+	{
+		SDL_LockMutex( mMutex );
+		mQuit = true;
+		SDL_CondSignal( mWork );
+		SDL_UnlockMutex( mMutex );
+
+		SDL_WaitThread( mThread, NULL );
+		mThread = NULL;
+	}
+
+	SDL_LockMutex( mMutex );
+
+	// the ones that didn't get loaded
+	for( std::size_t i = 0; i < mQueue.size(); ++i )
+		Cancel( mQueue[ i ] );
+	mQueue.clear();
+
+	mDestroyed = true;
+	mBudget = 0;
+	Trim();
+
+	const bool empty = mEntries.empty() && mFailedEntries == 0;
+	SDL_UnlockMutex( mMutex );
+
+	if( empty )
+		delete this;
+}
+
+//-----------------------------------------------------------------------------
+
+SoundSampleCache::Entry* SoundSampleCache::Load( const types::string& filename )
+{
+	SDL_LockMutex( mMutex );
+	poro_assert( mDestroyed == false );
+
+	bool created = false;
+	Entry* entry = Acquire( filename, created );
+
+	if( created )
+	{
+		SDL_UnlockMutex( mMutex );
+		std::size_t bytes = 0;
+		void* samples = mLoadFunc( filename, bytes );
+		SDL_LockMutex( mMutex );
+
+		Finish( entry, samples, bytes );
+	}
+	else
+	{
+		while( entry->state == Entry::LOADING )
+			SDL_CondWait( mLoaded, mMutex );
+	}
+
+	SDL_UnlockMutex( mMutex );
+	return entry;
+}
+
+SoundSampleCache::Entry* SoundSampleCache::LoadAsync( const types::string& filename )
+{
+	SDL_LockMutex( mMutex );
+	poro_assert( mDestroyed == false );
+
+	bool created = false;
+	Entry* entry = Acquire( filename, created );
+
+	if( created )
+	{
+		mQueue.push_back( entry );
+		if( mThread == NULL )
+			mThread = SDL_CreateThread( ThreadFunc, this );
+
+		SDL_CondSignal( mWork );
+	}
+
+	SDL_UnlockMutex( mMutex );
+	return entry;
+}
+
+void SoundSampleCache::Release( Entry* entry )
+{
+	poro_assert( entry );
+	if( entry == NULL ) return;
+
+	SDL_LockMutex( mMutex );
+	poro_assert( entry->references > 0 );
+
+	entry->references--;
+	if( entry->references == 0 )
+	{
+		if( entry->state == Entry::FAILED )
+		{
+			mFailedEntries--;
+			delete entry;
+		}
+		else if( entry->state == Entry::READY )
+		{
+			AddIdle( entry );
+			Trim();
+		}
+	}
+
+	const bool delete_me = mDestroyed && mEntries.empty() && mFailedEntries == 0;
+	SDL_UnlockMutex( mMutex );
+
+	if( delete_me )
+		delete this;
+}
+
+//-----------------------------------------------------------------------------
+
+void* SoundSampleCache::GetSamples( Entry* entry )
+{
+	poro_assert( entry );
+	SDL_LockMutex( mMutex );
+	void* result = entry->state == Entry::READY ? entry->samples : NULL;
+	SDL_UnlockMutex( mMutex );
+	return result;
+}
+
+bool SoundSampleCache::IsLoading( Entry* entry )
+{
+	poro_assert( entry );
+	SDL_LockMutex( mMutex );
+	const bool result = entry->state == Entry::LOADING;
+	SDL_UnlockMutex( mMutex );
+	return result;
+}
+
+void SoundSampleCache::WaitForLoads()
+{
+	SDL_LockMutex( mMutex );
+	while( mStats.loading > 0 )
+		SDL_CondWait( mLoaded, mMutex );
+	SDL_UnlockMutex( mMutex );
+}
+
+void SoundSampleCache::SetBudget( std::size_t budget_bytes )
+{
+	SDL_LockMutex( mMutex );
+	mBudget = budget_bytes;
+	Trim();
+	SDL_UnlockMutex( mMutex );
+}
+
+SoundSampleCache::Stats SoundSampleCache::GetStats()
+{
+	SDL_LockMutex( mMutex );
+	Stats result = mStats;
+	result.entries = (int)mEntries.size();
+	SDL_UnlockMutex( mMutex );
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// these expect the mutex to be locked
+
+SoundSampleCache::Entry* SoundSampleCache::Acquire( const types::string& filename, bool& created )
+{
+	Entry* entry = NULL;
+	EntryMap::iterator i = mEntries.find( filename );
+	if( i != mEntries.end() )
+	{
+		entry = i->second;
+		created = false;
+		mStats.hits++;
+		RemoveIdle( entry );
+	}
+	else
+	{
+		entry = new Entry( filename );
+		mEntries[ filename ] = entry;
+		created = true;
+		mStats.misses++;
+		mStats.loading++;
+	}
+
+	entry->references++;
+	return entry;
+}
+
+void SoundSampleCache::AddIdle( Entry* entry )
+{
+	poro_assert( entry->idle == false );
+	entry->idle_position = mIdle.insert( mIdle.end(), entry );
+	entry->idle = true;
+}
+
+void SoundSampleCache::RemoveIdle( Entry* entry )
+{
+	if( entry->idle == false )
+		return;
+
+	mIdle.erase( entry->idle_position );
+	entry->idle = false;
+}
+
+void SoundSampleCache::Trim()
+{
+	while( mStats.resident_bytes > mBudget && mIdle.empty() == false )
+	{
+		Entry* entry = mIdle.front();
+		mIdle.pop_front();
+
+		mEntries.erase( entry->filename );
+		mStats.resident_bytes -= entry->bytes;
+		mStats.evictions++;
+
+		if( entry->samples )
+			mFreeFunc( entry->samples );
+		delete entry;
+	}
+}
+
+void SoundSampleCache::Finish( Entry* entry, void* samples, std::size_t bytes )
+{
+	poro_assert( entry->state == Entry::LOADING );
+	mStats.loading--;
+
+	if( samples == NULL )
+	{
+		mStats.failed++;
+		poro_logger << "Error couldn't load sound file: " << entry->filename << std::endl;
+		MarkFailed( entry );
+	}
+	else
+	{
+		entry->state = Entry::READY;
+		entry->samples = samples;
+		entry->bytes = bytes;
+		mStats.resident_bytes += bytes;
+
+		if( entry->references == 0 )
+			AddIdle( entry );
+
+		Trim();
+	}
+
+	SDL_CondBroadcast( mLoaded );
+}
+
+void SoundSampleCache::Cancel( Entry* entry )
+{
+	poro_assert( entry->state == Entry::LOADING );
+	mStats.loading--;
+	MarkFailed( entry );
+	SDL_CondBroadcast( mLoaded );
+}
+
+void SoundSampleCache::MarkFailed( Entry* entry )
+{
+	entry->state = Entry::FAILED;
+
+	// out of the map right away so the next request loads it again
+	mEntries.erase( entry->filename );
+	if( entry->references == 0 )
+		delete entry;
+	else
+		mFailedEntries++;
+}
+
+//-----------------------------------------------------------------------------
+
+int SoundSampleCache::ThreadFunc( void* data )
+{
+	static_cast< SoundSampleCache* >( data )->RunThread();
+	return 0;
+}
+
+void SoundSampleCache::RunThread()
+{
+	SDL_LockMutex( mMutex );
+	while( true )
+	{
+		while( mQueue.empty() && mQuit == false )
+			SDL_CondWait( mWork, mMutex );
+
+		if( mQuit )
+			break;
+
+		Entry* entry = mQueue.front();
+		mQueue.pop_front();
+		SDL_UnlockMutex( mMutex );
+
+		std::size_t bytes = 0;
+		void* samples = mLoadFunc( entry->filename, bytes );
+
+		SDL_LockMutex( mMutex );
+		Finish( entry, samples, bytes );
+	}
+	SDL_UnlockMutex( mMutex );
+}
+
+} // end o namespace poro
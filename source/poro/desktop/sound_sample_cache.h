@@ -0,0 +1,139 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#ifndef INC_SOUND_SAMPLE_CACHE_H
+#define INC_SOUND_SAMPLE_CACHE_H
+
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <map>
+#include "../poro_types.h"
+
+struct SDL_mutex;
+struct SDL_cond;
+struct SDL_Thread;
+
+namespace poro {
+
+// Decoded samples shared by filename. Every sound holds a reference to its
+// entry, and entries nobody references are kept around until the resident
+// bytes go over the budget, the least recently used ones go first. Entries
+// that are in use are never dropped, even if that means going over.
+//
+// LoadAsync() hands the decoding to a background thread that is started on
+// the first call. The same file is never decoded twice at the same time.
+// Failed loads aren't cached, the next request of the file tries again.
+//
+// The load and free functions do the actual decoding, so the cache doesn't
+// know what the samples are. The load function is called from the
+// background thread, the free function from whichever thread trims the cache.
+class SoundSampleCache
+{
+public:
+	typedef void*	(*LoadFunc)( const types::string& filename, std::size_t& bytes );
+	typedef void	(*FreeFunc)( void* samples );
+
+	struct Stats
+	{
+		Stats() : hits( 0 ), misses( 0 ), evictions( 0 ), failed( 0 ), entries( 0 ), loading( 0 ), resident_bytes( 0 ) { }
+
+		int hits;
+		int misses;
+		int evictions;
+		int failed;
+		int entries;
+		int loading;
+		std::size_t resident_bytes;
+	};
+
+	struct Entry;
+
+	SoundSampleCache( LoadFunc load_func, FreeFunc free_func, std::size_t budget_bytes );
+
+	// use this instead of delete. If there still are references the cache
+	// is deleted when the last one is released
+	void Destroy();
+
+	// a reference to the samples of the file. Decodes them right away if they
+	// aren't cached, or waits for the background thread if it's on it
+	Entry*	Load( const types::string& filename );
+
+	// a reference that gets its samples from the background thread
+	Entry*	LoadAsync( const types::string& filename );
+
+	void	Release( Entry* entry );
+
+	// NULL while loading or if the loading failed
+	void*	GetSamples( Entry* entry );
+	bool	IsLoading( Entry* entry );
+
+	// waits for all the background loads to finish
+	void	WaitForLoads();
+
+	void		SetBudget( std::size_t budget_bytes );
+	std::size_t	GetBudget() const { return mBudget; }
+
+	Stats	GetStats();
+
+private:
+	~SoundSampleCache();
+
+	Entry*	Acquire( const types::string& filename, bool& created );
+	void	AddIdle( Entry* entry );
+	void	RemoveIdle( Entry* entry );
+	void	Trim();
+	void	Finish( Entry* entry, void* samples, std::size_t bytes );
+	// a queued load that won't be done, not an error
+	void	Cancel( Entry* entry );
+	void	MarkFailed( Entry* entry );
+
+	static int	ThreadFunc( void* data );
+	void		RunThread();
+
+	typedef std::map< types::string, Entry* > EntryMap;
+
+	LoadFunc				mLoadFunc;
+	FreeFunc				mFreeFunc;
+	std::size_t				mBudget;
+
+	EntryMap				mEntries;
+	// entries nobody references, the least recently used in front
+	std::list< Entry* >		mIdle;
+	Stats					mStats;
+	bool					mDestroyed;
+	// failed entries that are out of mEntries but still referenced
+	int						mFailedEntries;
+
+	SDL_mutex*				mMutex;
+	SDL_cond*				mLoaded;
+	SDL_cond*				mWork;
+	SDL_Thread*				mThread;
+	std::deque< Entry* >	mQueue;
+	bool					mQuit;
+
+	// can't be copied
+	SoundSampleCache( const SoundSampleCache& );
+	SoundSampleCache& operator=( const SoundSampleCache& );
+};
+
+} // end o namespace poro
+
+#endif
@@ -24,10 +24,12 @@
 #include "../isound.h"
 #include "../poro_types.h"
 #include "../libraries.h"
+#include "sound_sample_cache.h"
 
 namespace poro {
 
-// SDL_Mixer implementation for sound
+// SDL_Mixer implementation for sound. If the sound came from the cache the
+// chunk belongs to the cache
 class SoundSDL : public ISound 
 {
 public:
@@ -35,20 +37,40 @@ public:
 		mMixChunk( NULL ),
 		mChannel( 0 ),
 		mFilename(),
-		mType( 0 )
+		mType( 0 ),
+		mCache( NULL ),
+		mCacheEntry( NULL )
 	{ }
 	
 	~SoundSDL() 
 	{
-		if( mMixChunk )
+		if( mCacheEntry )
+			mCache->Release( mCacheEntry );
+		else if( mMixChunk )
 			Mix_FreeChunk( mMixChunk );
 	}
 
+	bool IsLoaded() { return GetMixChunk() != NULL; }
+
+	// NULL while loading in the background
+	Mix_Chunk* GetMixChunk()
+	{
+		if( mMixChunk == NULL && mCacheEntry )
+			mMixChunk = (Mix_Chunk*)mCache->GetSamples( mCacheEntry );
+
+		return mMixChunk;
+	}
+
+	bool IsLoading() { return mCacheEntry && mCache->IsLoading( mCacheEntry ); }
+
 
 	Mix_Chunk*		mMixChunk;
 	int				mChannel;
 	types::string	mFilename;
 	int				mType;
+
+	SoundSampleCache*			mCache;
+	SoundSampleCache::Entry*	mCacheEntry;
 };
 
 } // end o namespace poro
@@ -24,6 +24,51 @@
 
 namespace poro {
 
+namespace {
+
+	// the sounds that aren't used are kept decoded up to this
+	const std::size_t sample_cache_budget = 64 * 1024 * 1024;
+
+	void* LoadMixChunk( const types::string& filename, std::size_t& bytes )
+	{
+		Mix_Chunk* chunk = Mix_LoadWAV( filename.c_str() );
+		bytes = chunk ? sizeof( Mix_Chunk ) + chunk->alen : 0;
+		return chunk;
+	}
+
+	void FreeMixChunk( void* chunk )
+	{
+		Mix_FreeChunk( (Mix_Chunk*)chunk );
+	}
+
+	bool IsChannelPlaying( int channel ) { return Mix_Playing( channel ) != 0; }
+
+	void LockAudio() { SDL_LockAudio(); }
+	void UnlockAudio() { SDL_UnlockAudio(); }
+
+	// called by SDL_mixer from the audio thread with the audio locked
+	void MixStreams( void* udata, Uint8* stream, int len )
+	{
+		( (SoundStreamMixer*)udata )->Mix( (types::Int16*)stream, len / ( 2 * sizeof( types::Int16 ) ) );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+SoundPlayerSDL::~SoundPlayerSDL()
+{
+	if( mStreamMixer )
+	{
+		Mix_SetPostMix( NULL, NULL );
+		delete mStreamMixer;
+		mStreamMixer = NULL;
+	}
+
+	// sounds that are still around keep the cache alive
+	if( mSampleCache )
+		mSampleCache->Destroy();
+	mSampleCache = NULL;
+}
 
 bool SoundPlayerSDL::Init()
 {
@@ -44,13 +89,40 @@ bool SoundPlayerSDL::Init()
 		poro_logger << s << std::endl;
 	}
 
-	// allocate 16 mixing channels
-	Mix_AllocateChannels(16);
+	// a channel for every voice of the mixer
+	Mix_AllocateChannels( mMixer.GetVoiceCount() );
+	mMixer.SetVoicePlayingFunc( IsChannelPlaying );
+
+	if( mSampleCache == NULL )
+		mSampleCache = new SoundSampleCache( LoadMixChunk, FreeMixChunk, sample_cache_budget );
+
+	if( mStreamMixer == NULL )
+	{
+		int frequency = 0;
+		Uint16 format = 0;
+		int channels = 0;
+		Mix_QuerySpec( &frequency, &format, &channels );
+		poro_assert( format == AUDIO_S16SYS && channels == 2 );
+
+		mStreamMixer = new SoundStreamMixer( frequency, LockAudio, UnlockAudio );
+		Mix_SetPostMix( MixStreams, mStreamMixer );
+	}
 	
 	mInitSDLMixer = true;
 	return true;
 }
 
+void SoundPlayerSDL::SetVoiceCount( int voice_count )
+{
+	if( mInitSDLMixer )
+	{
+		// the channels that go away are halted by SDL_mixer
+		Mix_AllocateChannels( voice_count );
+	}
+
+	mMixer.SetVoiceCount( voice_count );
+}
+
 ISound* SoundPlayerSDL::LoadSound( const types::string& filename )
 {
 	poro_assert( mInitSDLMixer );
@@ -59,13 +131,47 @@ ISound* SoundPlayerSDL::LoadSound( const types::string& filename )
 
 	SoundSDL* sound = new SoundSDL;
 	sound->mFilename = filename;
-	sound->mMixChunk = Mix_LoadWAV( filename.c_str() );
-	if( sound->mMixChunk == NULL )
-		poro_logger << "Error couldn't load sound file: " << filename << std::endl;
+	sound->mCache = mSampleCache;
+	sound->mCacheEntry = mSampleCache->Load( filename );
+	sound->GetMixChunk();
+
+	return sound;
+}
+
+ISound* SoundPlayerSDL::LoadSoundAsync( const types::string& filename )
+{
+	poro_assert( mInitSDLMixer );
+	if( filename.empty() )
+		return NULL;
+
+	SoundSDL* sound = new SoundSDL;
+	sound->mFilename = filename;
+	sound->mCache = mSampleCache;
+	sound->mCacheEntry = mSampleCache->LoadAsync( filename );
 
 	return sound;
 }
 
+ISound* SoundPlayerSDL::LoadStream( const types::string& filename )
+{
+	poro_assert( mInitSDLMixer );
+	if( filename.empty() )
+		return NULL;
+
+	SoundStream* stream = CreateWavStream( filename );
+
+	// there's no resampling, so anything else is loaded the old way
+	if( stream == NULL || stream->GetDecoder()->GetSampleRate() != mStreamMixer->GetSampleRate() )
+	{
+		if( stream )
+			poro_logger << "SoundPlayerSDL::LoadStream() - sample rate doesn't match, loading it whole: " << filename << std::endl;
+		delete stream;
+		return LoadSound( filename );
+	}
+
+	return stream;
+}
+
 void SoundPlayerSDL::Play( ISound* sound, float volume ) { Play( sound, volume, false ); }
 
 void SoundPlayerSDL::Play( ISound* isound, float volume, bool loop )
@@ -74,6 +180,13 @@ void SoundPlayerSDL::Play( ISound* isound, float volume, bool loop )
 	poro_assert( isound );
 	if( isound == NULL ) return;
 	
+	SoundStream* stream = dynamic_cast< SoundStream* >( isound );
+	if( stream )
+	{
+		mStreamMixer->Play( stream, volume, loop );
+		return;
+	}
+
 	int loops = 0;
 	if( loop ) loops = -1;
 
@@ -83,10 +196,27 @@ void SoundPlayerSDL::Play( ISound* isound, float volume, bool loop )
 
 	SoundSDL* sound = (SoundSDL*)isound;
 
-	poro_assert( sound->mMixChunk );
-	if( sound->mMixChunk == NULL ) return;
+	// still loading, nothing to play yet
+	Mix_Chunk* chunk = sound->GetMixChunk();
+	if( chunk == NULL && sound->IsLoading() ) return;
+
+	poro_assert( chunk );
+	if( chunk == NULL ) return;
+
+	bool stolen = false;
+	const int channel = mMixer.Allocate( sound, volume, stolen );
+	if( channel == -1 )
+		return;
+
+	if( stolen )
+		Mix_HaltChannel( channel );
+
+	if( Mix_PlayChannel( channel, chunk, loops ) == -1 )
+	{
+		mMixer.Cancel( channel );
+		return;
+	}
 
-	int channel = Mix_PlayChannel( -1, sound->mMixChunk, loops );
 	Mix_Volume( channel, vol );
 	sound->mChannel = channel;
 }
@@ -97,12 +227,52 @@ void SoundPlayerSDL::Stop( ISound* isound )
 	poro_assert( isound );
 	if( isound == NULL ) return;
 
+	SoundStream* stream = dynamic_cast< SoundStream* >( isound );
+	if( stream )
+	{
+		mStreamMixer->Stop( stream );
+		return;
+	}
+
 	SoundSDL* sound = (SoundSDL*)isound;
 
-	poro_assert( sound->mMixChunk );
-	if( sound->mMixChunk == NULL ) return;
+	mMixer.ReleaseSound( sound, mStoppedVoices );
+	for( std::size_t i = 0; i < mStoppedVoices.size(); ++i )
+		Mix_HaltChannel( mStoppedVoices[ i ] );
+}
+
+void SoundPlayerSDL::Seek( ISound* sound, float seconds )
+{
+	poro_assert( mInitSDLMixer );
+
+	SoundStream* stream = dynamic_cast< SoundStream* >( sound );
+	if( stream )
+		mStreamMixer->Seek( stream, seconds );
+}
+
+void SoundPlayerSDL::Crossfade( ISound* from, ISound* to, float seconds, float volume, bool loop )
+{
+	poro_assert( mInitSDLMixer );
+
+	SoundStream* from_stream = dynamic_cast< SoundStream* >( from );
+	SoundStream* to_stream = dynamic_cast< SoundStream* >( to );
+
+	// the plain sounds just stop and start
+	if( from && from_stream == NULL ) 
+		Stop( from );
+	if( to && to_stream == NULL ) 
+		Play( to, volume, loop );
+
+	if( from_stream || to_stream )
+		mStreamMixer->Crossfade( from_stream, to_stream, seconds, volume, loop );
+}
+
+void SoundPlayerSDL::Update()
+{
+	if( mInitSDLMixer == false ) return;
 
-	Mix_HaltChannel( sound->mChannel );
+	mMixer.RefreshVoices();
+	mMixer.NextFrame();
 }
 
 } // end o namespace poro
\ No newline at end of file
@@ -21,29 +21,56 @@
 #ifndef INC_SOUNDPLAYER_SDL_H
 #define INC_SOUNDPLAYER_SDL_H
 
+#include <vector>
 #include "../isoundplayer.h"
+#include "../sound_mixer.h"
+#include "../sound_stream.h"
 #include "../libraries.h"
+#include "sound_sample_cache.h"
 
 namespace poro {
 
+// The voices of the SoundMixer are the channels of SDL_mixer. The decoded
+// sounds are shared through a SoundSampleCache, so loading the same file
+// again doesn't decode it again. Streams are mixed in by a
+// SoundStreamMixer hooked to the post mix of SDL_mixer
 class SoundPlayerSDL : public ISoundPlayer
 {
 public:
-	SoundPlayerSDL() : mInitSDLMixer( false ) { }
-	~SoundPlayerSDL() { }
+	SoundPlayerSDL() : mInitSDLMixer( false ), mMixer( 16 ), mStoppedVoices(), mSampleCache( NULL ), mStreamMixer( NULL ) { }
+	~SoundPlayerSDL();
 
 	bool Init();
 
 	ISound* LoadSound( const types::string& filename );
+	ISound* LoadSoundAsync( const types::string& filename );
+	ISound* LoadStream( const types::string& filename );
 
 	void Play( ISound* sound, float volume );
 	void Play( ISound* sound, float volume, bool loop );
 
 	void Stop( ISound* sound );
 
+	void Seek( ISound* sound, float seconds );
+	void Crossfade( ISound* from, ISound* to, float seconds, float volume, bool loop );
+
+	void Update();
+
+	SoundMixer* GetMixer() { return &mMixer; }
+
+	// allocates the channels of SDL_mixer as well
+	void SetVoiceCount( int voice_count );
+
+	// NULL before Init()
+	SoundSampleCache* GetSampleCache() { return mSampleCache; }
+	SoundStreamMixer* GetStreamMixer() { return mStreamMixer; }
+
 private:
 	bool mInitSDLMixer;
-	
+	SoundMixer mMixer;
+	std::vector< int > mStoppedVoices;
+	SoundSampleCache* mSampleCache;
+	SoundStreamMixer* mStreamMixer;
 };
 
 } // end o namespace poro
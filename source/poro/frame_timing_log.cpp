@@ -0,0 +1,85 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#include "frame_timing_log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace poro {
+
+double FrameTimingLog::GetAverage() const
+{
+	if( mFrames.empty() )
+		return 0;
+
+	double sum = 0;
+	for( std::size_t i = 0; i < mFrames.size(); ++i )
+		sum += mFrames[ i ].total;
+
+	return sum / (double)mFrames.size();
+}
+
+//-----------------------------------------------------------------------------
+
+double FrameTimingLog::GetPercentile( double percentile ) const
+{
+	if( mFrames.empty() )
+		return 0;
+
+	std::vector< double > totals( mFrames.size() );
+	for( std::size_t i = 0; i < mFrames.size(); ++i )
+		totals[ i ] = mFrames[ i ].total;
+
+	// nearest rank
+	std::size_t rank = (std::size_t)ceil( percentile * 0.01 * (double)totals.size() );
+	if( rank > 0 ) 
+		rank--;
+	if( rank >= totals.size() ) 
+		rank = totals.size() - 1;
+
+	std::nth_element( totals.begin(), totals.begin() + rank, totals.end() );
+	return totals[ rank ];
+}
+
+//-----------------------------------------------------------------------------
+
+bool FrameTimingLog::Save( const types::string& filename ) const
+{
+	std::ofstream file( filename.c_str(), std::ios::out | std::ios::trunc );
+	if( file.is_open() == false )
+		return false;
+
+	file << "frame,dt,events_ms,update_ms,sound_ms,draw_ms,total_ms\n";
+	for( std::size_t i = 0; i < mFrames.size(); ++i )
+	{
+		const Frame& frame = mFrames[ i ];
+		file << frame.frame << "," << frame.dt << "," 
+			<< frame.events << "," << frame.update << "," << frame.sound << "," 
+			<< frame.draw << "," << frame.total << "\n";
+	}
+
+	return file.good();
+}
+
+//-----------------------------------------------------------------------------
+
+} // end o namespace poro
@@ -0,0 +1,64 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#ifndef INC_FRAME_TIMING_LOG_H
+#define INC_FRAME_TIMING_LOG_H
+
+#include <vector>
+#include "poro_types.h"
+
+namespace poro {
+
+// How long the parts of each frame took, written out as .csv so that the runs
+// of the same input recording can be compared.
+class FrameTimingLog
+{
+public:
+	// the times are in milliseconds
+	struct Frame
+	{
+		Frame() : frame( 0 ), dt( 0 ), events( 0 ), update( 0 ), sound( 0 ), draw( 0 ), total( 0 ) { }
+
+		int				frame;
+		types::Float32	dt;
+		double			events;
+		double			update;
+		double			sound;
+		double			draw;
+		double			total;
+	};
+
+	void	Add( const Frame& frame )				{ mFrames.push_back( frame ); }
+	void	Clear()									{ mFrames.clear(); }
+	const std::vector< Frame >& GetFrames() const	{ return mFrames; }
+
+	// of the frame totals, percentile is from 0 to 100
+	double	GetAverage() const;
+	double	GetPercentile( double percentile ) const;
+
+	bool	Save( const types::string& filename ) const;
+
+private:
+	std::vector< Frame > mFrames;
+};
+
+} // end o namespace poro
+
+#endif
@@ -97,6 +97,13 @@ public:
 
 	//-------------------------------------------------------------------------
 
+	// Everything drawn after SetClipRect() is cut to the rect (in the internal
+	// coordinates) until ResetClipRect() is called.
+	virtual void		SetClipRect( types::Float32 x, types::Float32 y, types::Float32 w, types::Float32 h ) { }
+	virtual void		ResetClipRect() { }
+
+	//-------------------------------------------------------------------------
+
 	enum BLEND_MODES {
 		BLEND_MODE_NORMAL = 0,
 		BLEND_MODE_MULTIPLY = 1,
@@ -123,6 +130,9 @@ public:
 
 	virtual void		DrawTexture( ITexture* texture, types::vec2* vertices, types::vec2* tex_coords, int count, const types::fcolor& color ) = 0;
 
+	// count / 4 quads with one call, the four vertices of each quad go around it like with VERTEX_MODE_TRIANGLE_FAN
+	virtual void		DrawTextureQuads( ITexture* texture, types::vec2* vertices, types::vec2* tex_coords, int count, const types::fcolor& color );
+
 	virtual void		DrawTextureWithAlpha( ITexture* texture, types::vec2* vertices, types::vec2* tex_coords, int count, const types::fcolor& color,
 		ITexture* alpha_texture, types::vec2* alpha_vertices, types::vec2* alpha_tex_coords, const types::fcolor& alpha_color ) { poro_assert( false && "Needs to be implemented" ); }
 
@@ -130,6 +140,9 @@ public:
 
 	virtual void		DrawLines( const std::vector< poro::types::vec2 >& vertices, const types::fcolor& color, bool smooth, float width, bool loop = false ) { }
 	virtual void		DrawLines( const std::vector< poro::types::vec2 >& vertices, const types::fcolor& color ) { DrawLines( vertices, color, false, 1.f, true ); }
+
+	// every two vertices are a separate line, so any number of lines can be drawn with one call
+	virtual void		DrawLineSegments( const std::vector< poro::types::vec2 >& vertices, const types::fcolor& color, bool smooth, float width );
 	virtual void		DrawFill( const std::vector< poro::types::vec2 >& vertices, const types::fcolor& color ) { }
 	virtual void		DrawTexturedRect( const poro::types::vec2& position, const poro::types::vec2& size, ITexture* itexture ) { }
 
@@ -154,6 +167,22 @@ protected:
 
 ///////////////////////////////////////////////////////////////////////////////
 
+inline void IGraphics::DrawTextureQuads( ITexture* texture, types::vec2* vertices, types::vec2* tex_coords, int count, const types::fcolor& color ) {
+	PushVertexMode( VERTEX_MODE_TRIANGLE_FAN );
+	for( int i = 0; i + 3 < count; i += 4 )
+		DrawTexture( texture, vertices + i, tex_coords + i, 4, color );
+	PopVertexMode();
+}
+
+inline void IGraphics::DrawLineSegments( const std::vector< poro::types::vec2 >& vertices, const types::fcolor& color, bool smooth, float width ) {
+	static std::vector< poro::types::vec2 > line( 2 );
+	for( std::size_t i = 0; i + 1 < vertices.size(); i += 2 ) {
+		line[ 0 ] = vertices[ i ];
+		line[ 1 ] = vertices[ i + 1 ];
+		DrawLines( line, color, smooth, width, false );
+	}
+}
+
 inline void	IGraphics::PushBlendMode(int blend_mode) {
 	mBlendModes.push(mBlendMode);
 	mBlendMode=blend_mode;
@@ -40,6 +40,9 @@ namespace poro {
 		
 		virtual void		SetGraphicsBufferScale( float x, float y ) { }
 
+		// clears the buffer to transparent, only inside the clip rect if one is set
+		virtual void		Clear() { }
+
 		void		DrawTexture( ITexture* texture, types::vec2* vertices, types::vec2* tex_coords, int count, const types::fcolor& color ) { }
 
 		void		DrawTexture( ITexture* texture,
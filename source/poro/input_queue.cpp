@@ -0,0 +1,69 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#include "input_queue.h"
+
+namespace poro {
+
+InputQueue::InputQueue() :
+	mCoalesceMouseMotion( true ),
+	mEvents(),
+	mRawEvents(),
+	mFrameStats(),
+	mTotalStats()
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void InputQueue::BeginFrame()
+{
+	mEvents.clear();
+	mRawEvents.clear();
+	mFrameStats = Stats();
+}
+
+//-----------------------------------------------------------------------------
+
+void InputQueue::Push( const Event& event )
+{
+	mRawEvents.push_back( event );
+	mFrameStats.received++;
+	mTotalStats.received++;
+
+	if( mCoalesceMouseMotion && 
+		event.type == Event::MOUSE_MOVE && 
+		mEvents.empty() == false && 
+		mEvents.back().type == Event::MOUSE_MOVE )
+	{
+		mEvents.back() = event;
+		mFrameStats.coalesced++;
+		mTotalStats.coalesced++;
+		return;
+	}
+
+	mEvents.push_back( event );
+	mFrameStats.dispatched++;
+	mTotalStats.dispatched++;
+}
+
+//-----------------------------------------------------------------------------
+
+} // end o namespace poro
@@ -0,0 +1,99 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#ifndef INC_INPUT_QUEUE_H
+#define INC_INPUT_QUEUE_H
+
+#include <vector>
+#include "poro_types.h"
+
+namespace poro {
+
+// Holds the input events of one frame before they're sent to the listeners.
+// Every event gets the time it was pushed. Runs of mouse motion can be
+// coalesced so the listeners get one move per run instead of one per report
+// of the mouse, the events between them keep their order. The raw events of
+// the frame are kept for the ones that want the whole path of the mouse.
+class InputQueue
+{
+public:
+	struct Event
+	{
+		enum Type
+		{
+			MOUSE_MOVE = 0,
+			MOUSE_DOWN = 1,
+			MOUSE_UP = 2,
+			KEY_DOWN = 3,
+			KEY_UP = 4
+		};
+
+		Event() : type( MOUSE_MOVE ), time( 0 ), x( 0 ), y( 0 ), button( 0 ), unicode( 0 ) { }
+
+		int				type;
+		// seconds, from the same clock for all events
+		double			time;
+		// the mouse position in window pixels
+		int				x;
+		int				y;
+		// Mouse::MOUSE_BUTTON_XXX or the key
+		int				button;
+		types::charset	unicode;
+	};
+
+	struct Stats
+	{
+		Stats() : received( 0 ), dispatched( 0 ), coalesced( 0 ) { }
+
+		int received;
+		int dispatched;
+		// motion events that were merged into the one after them
+		int coalesced;
+	};
+
+	InputQueue();
+
+	void	SetCoalesceMouseMotion( bool value )	{ mCoalesceMouseMotion = value; }
+	bool	GetCoalesceMouseMotion() const			{ return mCoalesceMouseMotion; }
+
+	// clears the events of the last frame
+	void	BeginFrame();
+	void	Push( const Event& event );
+
+	// what gets sent to the listeners this frame
+	const std::vector< Event >&	GetEvents() const		{ return mEvents; }
+	// everything that came in this frame
+	const std::vector< Event >&	GetRawEvents() const	{ return mRawEvents; }
+
+	const Stats&	GetFrameStats() const	{ return mFrameStats; }
+	const Stats&	GetTotalStats() const	{ return mTotalStats; }
+	void			ResetStats()			{ mTotalStats = Stats(); }
+
+private:
+	bool				mCoalesceMouseMotion;
+	std::vector< Event > mEvents;
+	std::vector< Event > mRawEvents;
+	Stats				mFrameStats;
+	Stats				mTotalStats;
+};
+
+} // end o namespace poro
+
+#endif
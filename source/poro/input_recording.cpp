@@ -0,0 +1,461 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#include "input_recording.h"
+
+#include <string.h>
+
+#include "joystick.h"
+#include "poro_macros.h"
+
+namespace poro {
+
+namespace {
+
+	// "PORI" and the version, the numbers are little endian
+	const unsigned char RECORDING_MAGIC[ 4 ] = { 'P', 'O', 'R', 'I' };
+	const unsigned int RECORDING_VERSION = 1;
+
+	void WriteUInt( std::vector< unsigned char >& buffer, unsigned int value, int bytes )
+	{
+		for( int i = 0; i < bytes; ++i )
+			buffer.push_back( (unsigned char)( ( value >> ( i * 8 ) ) & 0xFF ) );
+	}
+
+	// 7 bits at a time, the small numbers take one byte
+	void WriteVarUInt( std::vector< unsigned char >& buffer, unsigned int value )
+	{
+		while( value >= 0x80 )
+		{
+			buffer.push_back( (unsigned char)( ( value & 0x7F ) | 0x80 ) );
+			value >>= 7;
+		}
+		buffer.push_back( (unsigned char)value );
+	}
+
+	void WriteFloat( std::vector< unsigned char >& buffer, types::Float32 value )
+	{
+		unsigned int bits = 0;
+		memcpy( &bits, &value, 4 );
+		WriteUInt( buffer, bits, 4 );
+	}
+
+	//-------------------------------------------------------------------------
+
+	class Reader
+	{
+	public:
+		Reader( const std::vector< unsigned char >& data, std::size_t position ) : 
+			mData( data ), 
+			mPosition( position ), 
+			mFailed( false ) 
+		{ 
+		}
+
+		unsigned int ReadUInt( int bytes )
+		{
+			if( mPosition + bytes > mData.size() ) {
+				mFailed = true;
+				return 0;
+			}
+
+			unsigned int result = 0;
+			for( int i = 0; i < bytes; ++i )
+				result |= ( (unsigned int)mData[ mPosition + i ] ) << ( i * 8 );
+			mPosition += bytes;
+			return result;
+		}
+
+		unsigned int ReadVarUInt()
+		{
+			unsigned int result = 0;
+			for( int shift = 0; shift < 35; shift += 7 )
+			{
+				const unsigned int byte = ReadUInt( 1 );
+				result |= ( byte & 0x7F ) << shift;
+				if( ( byte & 0x80 ) == 0 )
+					return result;
+			}
+			mFailed = true;
+			return 0;
+		}
+
+		types::Float32 ReadFloat()
+		{
+			const unsigned int bits = ReadUInt( 4 );
+			types::Float32 result = 0;
+			memcpy( &result, &bits, 4 );
+			return result;
+		}
+
+		bool		GetFailed() const	{ return mFailed; }
+		std::size_t	GetPosition() const { return mPosition; }
+
+	private:
+		const std::vector< unsigned char >& mData;
+		std::size_t mPosition;
+		bool mFailed;
+	};
+
+	//-------------------------------------------------------------------------
+
+	// what comes after the type and the id
+	enum Payload
+	{
+		PAYLOAD_NONE,
+		PAYLOAD_POSITION,
+		PAYLOAD_BUTTON_AND_POSITION,
+		PAYLOAD_KEY,
+		PAYLOAD_BUTTON,
+		PAYLOAD_BUTTON_AND_VALUE
+	};
+
+	Payload GetPayload( int type )
+	{
+		switch( type )
+		{
+			case InputEvent::MOUSE_MOVE:
+			case InputEvent::TOUCH_MOVE:
+			case InputEvent::TOUCH_DOWN:
+			case InputEvent::TOUCH_UP:
+			case InputEvent::JOY_LEFT_STICK:
+			case InputEvent::JOY_RIGHT_STICK:
+				return PAYLOAD_POSITION;
+
+			case InputEvent::MOUSE_DOWN:
+			case InputEvent::MOUSE_UP:
+				return PAYLOAD_BUTTON_AND_POSITION;
+
+			case InputEvent::KEY_DOWN:
+			case InputEvent::KEY_UP:
+				return PAYLOAD_KEY;
+
+			case InputEvent::JOY_BUTTON_DOWN:
+			case InputEvent::JOY_BUTTON_UP:
+				return PAYLOAD_BUTTON;
+
+			case InputEvent::JOY_ANALOG:
+				return PAYLOAD_BUTTON_AND_VALUE;
+		}
+		return PAYLOAD_NONE;
+	}
+
+	InputEvent MakeJoystickEvent( int type, int id, int button = 0, const types::vec2& value = types::vec2() )
+	{
+		InputEvent result;
+		result.type = type;
+		result.id = id;
+		result.button = button;
+		result.value = value;
+		return result;
+	}
+}
+
+//=============================================================================
+
+InputRecorder::JoystickState::JoystickState() :
+	connected( false ),
+	buttons( 0 ),
+	left_stick(),
+	right_stick()
+{
+	for( int i = 0; i < ANALOG_BUTTON_COUNT; ++i )
+		analog[ i ] = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+InputRecorder::InputRecorder() :
+	mFile( NULL ),
+	mEvents(),
+	mJoysticks(),
+	mBuffer(),
+	mFrameCount( 0 ),
+	mBytesWritten( 0 )
+{
+}
+
+InputRecorder::~InputRecorder()
+{
+	Close();
+}
+
+//-----------------------------------------------------------------------------
+
+bool InputRecorder::Open( const types::string& filename )
+{
+	Close();
+
+	mFile = fopen( filename.c_str(), "wb" );
+	if( mFile == NULL )
+		return false;
+
+	mEvents.clear();
+	mJoysticks.clear();
+	mFrameCount = 0;
+
+	mBuffer.clear();
+	mBuffer.insert( mBuffer.end(), RECORDING_MAGIC, RECORDING_MAGIC + 4 );
+	WriteUInt( mBuffer, RECORDING_VERSION, 2 );
+	mBytesWritten = fwrite( &mBuffer[ 0 ], 1, mBuffer.size(), mFile );
+
+	return true;
+}
+
+void InputRecorder::Close()
+{
+	if( mFile )
+		fclose( mFile );
+	mFile = NULL;
+}
+
+//-----------------------------------------------------------------------------
+
+void InputRecorder::Add( const InputEvent& event )
+{
+	poro_assert( event.type >= 0 && event.type < InputEvent::TYPE_COUNT );
+	if( mFile )
+		mEvents.push_back( event );
+}
+
+//-----------------------------------------------------------------------------
+
+void InputRecorder::AddJoystick( const Joystick* joystick )
+{
+	poro_assert( joystick );
+	if( mFile == NULL )
+		return;
+
+	const int id = joystick->GetId();
+	poro_assert( id >= 0 );
+	if( id >= (int)mJoysticks.size() )
+		mJoysticks.resize( id + 1 );
+
+	JoystickState& state = mJoysticks[ id ];
+
+	if( joystick->GetConnected() != state.connected )
+	{
+		state.connected = joystick->GetConnected();
+		mEvents.push_back( MakeJoystickEvent( state.connected ? InputEvent::JOY_CONNECTED : InputEvent::JOY_DISCONNECTED, id ) );
+	}
+
+	const types::vec2 left_stick = joystick->GetLeftStick();
+	if( left_stick.x != state.left_stick.x || left_stick.y != state.left_stick.y )
+	{
+		state.left_stick = left_stick;
+		mEvents.push_back( MakeJoystickEvent( InputEvent::JOY_LEFT_STICK, id, 0, left_stick ) );
+	}
+
+	const types::vec2 right_stick = joystick->GetRightStick();
+	if( right_stick.x != state.right_stick.x || right_stick.y != state.right_stick.y )
+	{
+		state.right_stick = right_stick;
+		mEvents.push_back( MakeJoystickEvent( InputEvent::JOY_RIGHT_STICK, id, 0, right_stick ) );
+	}
+
+	for( int i = 0; i < Joystick::JOY_BUTTON_COUNT; ++i )
+	{
+		const unsigned int bit = 1u << i;
+		const bool is_down = joystick->IsButtonDown( i );
+		if( is_down != ( ( state.buttons & bit ) != 0 ) )
+		{
+			state.buttons ^= bit;
+			mEvents.push_back( MakeJoystickEvent( is_down ? InputEvent::JOY_BUTTON_DOWN : InputEvent::JOY_BUTTON_UP, id, i ) );
+		}
+	}
+
+	for( int i = 0; i < ANALOG_BUTTON_COUNT; ++i )
+	{
+		const types::Float32 value = joystick->GetAnalogButton( i );
+		if( value != state.analog[ i ] )
+		{
+			state.analog[ i ] = value;
+			mEvents.push_back( MakeJoystickEvent( InputEvent::JOY_ANALOG, id, i, types::vec2( value, 0 ) ) );
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void InputRecorder::EndFrame( types::Float32 dt )
+{
+	if( mFile == NULL )
+		return;
+
+	mBuffer.clear();
+	WriteFloat( mBuffer, dt );
+	WriteVarUInt( mBuffer, (unsigned int)mEvents.size() );
+
+	for( std::size_t i = 0; i < mEvents.size(); ++i )
+	{
+		const InputEvent& event = mEvents[ i ];
+		WriteUInt( mBuffer, event.type, 1 );
+		WriteUInt( mBuffer, event.id, 1 );
+
+		switch( GetPayload( event.type ) )
+		{
+			case PAYLOAD_NONE:
+			break;
+
+			case PAYLOAD_BUTTON_AND_POSITION:
+				WriteUInt( mBuffer, event.button, 1 );
+				// fall through
+			case PAYLOAD_POSITION:
+				WriteFloat( mBuffer, event.value.x );
+				WriteFloat( mBuffer, event.value.y );
+			break;
+
+			case PAYLOAD_KEY:
+				WriteUInt( mBuffer, event.button, 2 );
+				WriteUInt( mBuffer, event.unicode, 2 );
+			break;
+
+			case PAYLOAD_BUTTON:
+				WriteUInt( mBuffer, event.button, 1 );
+			break;
+
+			case PAYLOAD_BUTTON_AND_VALUE:
+				WriteUInt( mBuffer, event.button, 1 );
+				WriteFloat( mBuffer, event.value.x );
+			break;
+		}
+	}
+
+	mBytesWritten += fwrite( &mBuffer[ 0 ], 1, mBuffer.size(), mFile );
+	mEvents.clear();
+	mFrameCount++;
+}
+
+//=============================================================================
+
+InputReplayer::InputReplayer() :
+	mData(),
+	mPosition( 0 ),
+	mDt( 0 ),
+	mEvents(),
+	mFrameCount( 0 )
+{
+}
+
+//-----------------------------------------------------------------------------
+
+bool InputReplayer::Open( const types::string& filename )
+{
+	mData.clear();
+	mPosition = 0;
+	mDt = 0;
+	mEvents.clear();
+	mFrameCount = 0;
+
+	FILE* file = fopen( filename.c_str(), "rb" );
+	if( file == NULL )
+		return false;
+
+	unsigned char chunk[ 4096 ];
+	std::size_t count = 0;
+	while( ( count = fread( chunk, 1, sizeof( chunk ), file ) ) > 0 )
+		mData.insert( mData.end(), chunk, chunk + count );
+	fclose( file );
+
+	Reader reader( mData, 0 );
+	const bool magic_ok = mData.size() >= 4 && memcmp( &mData[ 0 ], RECORDING_MAGIC, 4 ) == 0;
+	reader.ReadUInt( 4 );
+	const unsigned int version = reader.ReadUInt( 2 );
+
+	if( magic_ok == false || reader.GetFailed() || version != RECORDING_VERSION )
+	{
+		mData.clear();
+		return false;
+	}
+
+	mPosition = reader.GetPosition();
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool InputReplayer::NextFrame()
+{
+	mEvents.clear();
+	mDt = 0;
+	if( IsDone() )
+		return false;
+
+	Reader reader( mData, mPosition );
+	const types::Float32 dt = reader.ReadFloat();
+	const unsigned int count = reader.ReadVarUInt();
+
+	for( unsigned int i = 0; i < count && reader.GetFailed() == false; ++i )
+	{
+		InputEvent event;
+		event.type = reader.ReadUInt( 1 );
+		event.id = reader.ReadUInt( 1 );
+
+		switch( GetPayload( event.type ) )
+		{
+			case PAYLOAD_NONE:
+			break;
+
+			case PAYLOAD_BUTTON_AND_POSITION:
+				event.button = reader.ReadUInt( 1 );
+				// fall through
+			case PAYLOAD_POSITION:
+				event.value.x = reader.ReadFloat();
+				event.value.y = reader.ReadFloat();
+			break;
+
+			case PAYLOAD_KEY:
+				event.button = reader.ReadUInt( 2 );
+				event.unicode = (types::charset)reader.ReadUInt( 2 );
+			break;
+
+			case PAYLOAD_BUTTON:
+				event.button = reader.ReadUInt( 1 );
+			break;
+
+			case PAYLOAD_BUTTON_AND_VALUE:
+				event.button = reader.ReadUInt( 1 );
+				event.value.x = reader.ReadFloat();
+			break;
+		}
+
+		if( event.type >= InputEvent::TYPE_COUNT )
+			break;
+
+		mEvents.push_back( event );
+	}
+
+	// a cut off or broken frame ends the recording
+	if( reader.GetFailed() || mEvents.size() != count )
+	{
+		mEvents.clear();
+		mPosition = mData.size();
+		return false;
+	}
+
+	mDt = dt;
+	mPosition = reader.GetPosition();
+	mFrameCount++;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+} // end o namespace poro
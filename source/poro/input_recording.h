@@ -0,0 +1,148 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#ifndef INC_INPUT_RECORDING_H
+#define INC_INPUT_RECORDING_H
+
+#include <stdio.h>
+#include <vector>
+#include "poro_types.h"
+
+namespace poro {
+
+class Joystick;
+
+// One input event as it was sent to the devices. Mouse and touch positions
+// are in the internal size, so playing them back doesn't need a window.
+struct InputEvent
+{
+	enum Type
+	{
+		MOUSE_MOVE = 0,
+		MOUSE_DOWN,
+		MOUSE_UP,
+		KEY_DOWN,
+		KEY_UP,
+		TOUCH_MOVE,
+		TOUCH_DOWN,
+		TOUCH_UP,
+		JOY_CONNECTED,
+		JOY_DISCONNECTED,
+		JOY_BUTTON_DOWN,
+		JOY_BUTTON_UP,
+		JOY_LEFT_STICK,
+		JOY_RIGHT_STICK,
+		JOY_ANALOG,
+
+		TYPE_COUNT
+	};
+
+	InputEvent() : type( MOUSE_MOVE ), id( 0 ), button( 0 ), unicode( 0 ), value() { }
+
+	int				type;
+	// the touch or the joystick
+	int				id;
+	// mouse, joystick or analog button or the key
+	int				button;
+	types::charset	unicode;
+	// position, stick or ( analog value, 0 )
+	types::vec2		value;
+};
+
+//-----------------------------------------------------------------------------
+
+// Writes the input of every frame and the dt of the frame to a binary file.
+// The events of a frame are gathered with Add() and written out with
+// EndFrame(), joysticks are compared to what they were at the last call to
+// AddJoystick() and only the changes get written.
+class InputRecorder
+{
+public:
+	InputRecorder();
+	~InputRecorder();
+
+	bool	Open( const types::string& filename );
+	void	Close();
+	bool	IsOpen() const				{ return mFile != NULL; }
+
+	void	Add( const InputEvent& event );
+	void	AddJoystick( const Joystick* joystick );
+	void	EndFrame( types::Float32 dt );
+
+	int			GetFrameCount() const	{ return mFrameCount; }
+	std::size_t	GetBytesWritten() const	{ return mBytesWritten; }
+
+private:
+	enum { ANALOG_BUTTON_COUNT = 10 };
+
+	struct JoystickState
+	{
+		JoystickState();
+
+		bool			connected;
+		unsigned int	buttons;
+		types::vec2		left_stick;
+		types::vec2		right_stick;
+		types::Float32	analog[ ANALOG_BUTTON_COUNT ];
+	};
+
+	FILE*							mFile;
+	std::vector< InputEvent >		mEvents;
+	std::vector< JoystickState >	mJoysticks;
+	std::vector< unsigned char >	mBuffer;
+	int								mFrameCount;
+	std::size_t						mBytesWritten;
+
+	// can't be copied
+	InputRecorder( const InputRecorder& );
+	InputRecorder& operator=( const InputRecorder& );
+};
+
+//-----------------------------------------------------------------------------
+
+// Reads a file written by InputRecorder and gives it back a frame at a time.
+class InputReplayer
+{
+public:
+	InputReplayer();
+
+	// reads the whole file, returns false if it isn't a recording
+	bool	Open( const types::string& filename );
+
+	// moves to the next frame, false when there are no more
+	bool	NextFrame();
+	bool	IsDone() const							{ return mPosition >= mData.size(); }
+
+	types::Float32						GetDt() const			{ return mDt; }
+	const std::vector< InputEvent >&	GetEvents() const		{ return mEvents; }
+	// the frames read so far
+	int									GetFrameCount() const	{ return mFrameCount; }
+
+private:
+	std::vector< unsigned char >	mData;
+	std::size_t						mPosition;
+	types::Float32					mDt;
+	std::vector< InputEvent >		mEvents;
+	int								mFrameCount;
+};
+
+} // end o namespace poro
+
+#endif
@@ -26,9 +26,24 @@ namespace poro {
 class ISound 
 {
 public:
-
+	ISound() : mPriority( 0 ), mMaxInstances( 0 ) { }
 	virtual ~ISound() { }
 
+	// false while the sound is still being loaded in the background
+	virtual bool IsLoaded() { return true; }
+
+	// used by the SoundMixer when all the voices are taken, sounds with
+	// higher priority can steal the voices of the lower ones
+	void	SetPriority( int priority )			{ mPriority = priority; }
+	int		GetPriority() const					{ return mPriority; }
+
+	// how many of this sound can play at the same time, 0 is no limit
+	void	SetMaxInstances( int max_instances )	{ mMaxInstances = max_instances; }
+	int		GetMaxInstances() const					{ return mMaxInstances; }
+
+private:
+	int mPriority;
+	int mMaxInstances;
 };
 
 }
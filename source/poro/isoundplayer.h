@@ -26,6 +26,8 @@
 
 namespace poro {
 
+class SoundMixer;
+
 class ISoundPlayer
 {
 public:
@@ -34,11 +36,34 @@ public:
 	virtual bool Init() { return false; }
 	virtual ISound* LoadSound( const types::string& filename ) = 0;
 
+	// returns right away and loads the sound in the background. Playing it
+	// before ISound::IsLoaded() does nothing
+	virtual ISound* LoadSoundAsync( const types::string& filename ) { return LoadSound( filename ); }
+
+	// for music and other long sounds, decoded bit by bit while playing
+	// instead of all at once. Only one instance of a stream plays at a time
+	virtual ISound* LoadStream( const types::string& filename ) { return LoadSound( filename ); }
+
 	// plays the sound once
 	virtual void Play( ISound* sound, float volume ) = 0;
 	virtual void Play( ISound* sound, float volume, bool loop ) = 0;
 
 	virtual void Stop( ISound* sound ) = 0;
+
+	// only streams can be seeked and crossfaded, the rest of the sounds
+	// just stop and start
+	virtual void Seek( ISound* sound, float seconds ) { }
+	virtual void Crossfade( ISound* from, ISound* to, float seconds, float volume, bool loop ) 
+	{
+		if( from ) Stop( from );
+		if( to ) Play( to, volume, loop );
+	}
+
+	// called once a frame by the platform
+	virtual void Update() { }
+
+	// the voice allocation, NULL if the player doesn't have one
+	virtual SoundMixer* GetMixer() { return NULL; }
 };
 
 }
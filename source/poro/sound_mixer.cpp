@@ -0,0 +1,267 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#include "sound_mixer.h"
+#include "poro_macros.h"
+
+namespace poro {
+
+SoundMixer::SoundMixer( int voice_count ) :
+	mVoices( voice_count ),
+	mVoicesInUse( 0 ),
+	mPlayCounter( 0 ),
+	mStealPolicy( STEAL_OLDEST ),
+	mMaxPlaysPerFrame( 0 ),
+	mPlaysThisFrame(),
+	mVoicePlayingFunc( NULL ),
+	mStats()
+{
+	poro_assert( voice_count >= 0 );
+}
+
+//-----------------------------------------------------------------------------
+
+void SoundMixer::SetVoiceCount( int voice_count )
+{
+	poro_assert( voice_count >= 0 );
+	for( int i = voice_count; i < GetVoiceCount(); ++i )
+		Release( i );
+
+	mVoices.resize( voice_count );
+}
+
+//-----------------------------------------------------------------------------
+
+int SoundMixer::Allocate( ISound* sound, float volume, bool& stolen )
+{
+	poro_assert( sound );
+	stolen = false;
+
+	int plays = -1;
+	if( mMaxPlaysPerFrame > 0 )
+	{
+		plays = FindPlaysThisFrame( sound );
+		if( plays != -1 && mPlaysThisFrame[ plays ].second >= mMaxPlaysPerFrame )
+		{
+			mStats.rate_limited++;
+			return -1;
+		}
+	}
+
+	RefreshVoices();
+
+	int voice = -1;
+	if( sound->GetMaxInstances() > 0 && CountInstances( sound ) >= sound->GetMaxInstances() )
+	{
+		voice = FindVictim( sound, sound->GetPriority() );
+	}
+	else
+	{
+		voice = FindFreeVoice();
+		if( voice == -1 )
+			voice = FindVictim( NULL, sound->GetPriority() );
+	}
+
+	if( voice == -1 )
+	{
+		mStats.dropped++;
+		return -1;
+	}
+
+	Voice& v = mVoices[ voice ];
+	if( v.sound )
+	{
+		stolen = true;
+		mStats.stolen++;
+	}
+	else
+	{
+		mVoicesInUse++;
+	}
+
+	v.sound = sound;
+	v.volume = volume;
+	v.priority = sound->GetPriority();
+	v.started = ++mPlayCounter;
+
+	// only the plays that got a voice count against the limit
+	if( mMaxPlaysPerFrame > 0 )
+	{
+		if( plays == -1 )
+			mPlaysThisFrame.push_back( std::make_pair( sound, 1 ) );
+		else
+			mPlaysThisFrame[ plays ].second++;
+	}
+
+	mStats.played++;
+	return voice;
+}
+
+void SoundMixer::Release( int voice )
+{
+	poro_assert( voice >= 0 && voice < GetVoiceCount() );
+	if( voice < 0 || voice >= GetVoiceCount() || mVoices[ voice ].sound == NULL )
+		return;
+
+	mVoices[ voice ] = Voice();
+	mVoicesInUse--;
+}
+
+void SoundMixer::Cancel( int voice )
+{
+	ISound* sound = GetVoiceSound( voice );
+	poro_assert( sound );
+	if( sound == NULL )
+		return;
+
+	const int plays = FindPlaysThisFrame( sound );
+	if( plays != -1 && mPlaysThisFrame[ plays ].second > 0 )
+		mPlaysThisFrame[ plays ].second--;
+
+	mStats.played--;
+	Release( voice );
+}
+
+void SoundMixer::RefreshVoices()
+{
+	if( mVoicePlayingFunc == NULL )
+		return;
+
+	for( int i = 0; i < GetVoiceCount(); ++i )
+	{
+		if( mVoices[ i ].sound && mVoicePlayingFunc( i ) == false )
+			Release( i );
+	}
+}
+
+void SoundMixer::ReleaseSound( ISound* sound, std::vector< int >& voices )
+{
+	voices.clear();
+	for( int i = 0; i < GetVoiceCount(); ++i )
+	{
+		if( mVoices[ i ].sound == sound )
+		{
+			voices.push_back( i );
+			Release( i );
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+bool SoundMixer::IsVoiceInUse( int voice ) const
+{
+	return GetVoiceSound( voice ) != NULL;
+}
+
+ISound* SoundMixer::GetVoiceSound( int voice ) const
+{
+	if( voice < 0 || voice >= GetVoiceCount() )
+		return NULL;
+
+	return mVoices[ voice ].sound;
+}
+
+void SoundMixer::NextFrame()
+{
+	mPlaysThisFrame.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+int SoundMixer::FindVictim( ISound* sound, int max_priority ) const
+{
+	if( mStealPolicy == STEAL_NONE )
+		return -1;
+
+	int result = -1;
+	for( int i = 0; i < GetVoiceCount(); ++i )
+	{
+		const Voice& v = mVoices[ i ];
+		if( v.sound == NULL || v.priority > max_priority )
+			continue;
+
+		if( sound && v.sound != sound )
+			continue;
+
+		if( result == -1 ) 
+		{
+			result = i;
+			continue;
+		}
+
+		const Voice& best = mVoices[ result ];
+		if( v.priority != best.priority )
+		{
+			if( v.priority < best.priority )
+				result = i;
+		}
+		else if( mStealPolicy == STEAL_QUIETEST && v.volume != best.volume )
+		{
+			if( v.volume < best.volume )
+				result = i;
+		}
+		else if( v.started < best.started )
+		{
+			result = i;
+		}
+	}
+
+	return result;
+}
+
+int SoundMixer::FindFreeVoice() const
+{
+	if( mVoicesInUse >= GetVoiceCount() )
+		return -1;
+
+	for( int i = 0; i < GetVoiceCount(); ++i )
+	{
+		if( mVoices[ i ].sound == NULL )
+			return i;
+	}
+
+	return -1;
+}
+
+int SoundMixer::CountInstances( ISound* sound ) const
+{
+	int result = 0;
+	for( int i = 0; i < GetVoiceCount(); ++i )
+	{
+		if( mVoices[ i ].sound == sound )
+			result++;
+	}
+
+	return result;
+}
+
+int SoundMixer::FindPlaysThisFrame( ISound* sound ) const
+{
+	for( std::size_t i = 0; i < mPlaysThisFrame.size(); ++i )
+	{
+		if( mPlaysThisFrame[ i ].first == sound )
+			return (int)i;
+	}
+
+	return -1;
+}
+
+} // end o namespace poro
@@ -0,0 +1,141 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#ifndef INC_SOUND_MIXER_H
+#define INC_SOUND_MIXER_H
+
+#include <cstddef>
+#include <vector>
+#include "isound.h"
+
+namespace poro {
+
+// Decides which voice a sound gets played on. It doesn't play anything
+// itself, the sound player asks for a voice, stops the old sound on it if
+// it was stolen and tells when a voice has finished playing.
+//
+// When all the voices are taken a sound can steal a voice that plays
+// something with the same or a lower priority. The lowest priority goes
+// first, among those the oldest or the quietest one depending on the policy.
+// Sounds that are already playing their max instances steal from
+// themselves. Playing the same sound more than the limit in one frame is
+// dropped right away.
+class SoundMixer
+{
+public:
+	enum StealPolicy
+	{
+		STEAL_NONE = 0,
+		STEAL_OLDEST = 1,
+		STEAL_QUIETEST = 2
+	};
+
+	// tells if the sound on the voice is still playing
+	typedef bool (*VoicePlayingFunc)( int voice );
+
+	struct Stats
+	{
+		Stats() : played( 0 ), stolen( 0 ), dropped( 0 ), rate_limited( 0 ) { }
+
+		int played;
+		int stolen;
+		// no voice could be found
+		int dropped;
+		// too many plays of the same sound in one frame
+		int rate_limited;
+	};
+
+	SoundMixer( int voice_count = 16 );
+
+	// voices that are cut off are released
+	void	SetVoiceCount( int voice_count );
+	int		GetVoiceCount() const		{ return (int)mVoices.size(); }
+	int		GetVoicesInUse() const		{ return mVoicesInUse; }
+
+	void		SetStealPolicy( StealPolicy policy )	{ mStealPolicy = policy; }
+	StealPolicy	GetStealPolicy() const					{ return mStealPolicy; }
+
+	// how many times the same sound can be started in one frame, 0 is no limit
+	void	SetMaxPlaysPerFrame( int max_plays )	{ mMaxPlaysPerFrame = max_plays; }
+	int		GetMaxPlaysPerFrame() const				{ return mMaxPlaysPerFrame; }
+
+	// if set, the voices that have finished are released before a sound is
+	// given a voice, so they aren't counted as instances or stolen
+	void	SetVoicePlayingFunc( VoicePlayingFunc func )	{ mVoicePlayingFunc = func; }
+
+	// returns the voice to play the sound on, or -1 if the sound should be
+	// dropped. If stolen is set the voice was playing something that has to
+	// be stopped first
+	int		Allocate( ISound* sound, float volume, bool& stolen );
+	void	Release( int voice );
+
+	// gives back a voice from Allocate() when the sound couldn't be started
+	// after all, the play doesn't count against the per frame limit
+	void	Cancel( int voice );
+
+	// releases the voices the VoicePlayingFunc says have finished
+	void	RefreshVoices();
+
+	// releases all the voices playing the sound, returns them in voices
+	void	ReleaseSound( ISound* sound, std::vector< int >& voices );
+
+	bool	IsVoiceInUse( int voice ) const;
+	ISound*	GetVoiceSound( int voice ) const;
+
+	// resets the per frame limits
+	void	NextFrame();
+
+	const Stats&	GetStats() const	{ return mStats; }
+	void			ResetStats()		{ mStats = Stats(); }
+
+private:
+	struct Voice
+	{
+		Voice() : sound( NULL ), volume( 0 ), priority( 0 ), started( 0 ) { }
+
+		ISound*			sound;
+		float			volume;
+		int				priority;
+		unsigned int	started;
+	};
+
+	// the best voice to steal among the ones playing sound (or any sound if
+	// it's NULL) with priority of at most max_priority. -1 if there isn't one
+	int		FindVictim( ISound* sound, int max_priority ) const;
+	int		FindFreeVoice() const;
+	int		CountInstances( ISound* sound ) const;
+	// index to mPlaysThisFrame, -1 if the sound hasn't been played this frame
+	int		FindPlaysThisFrame( ISound* sound ) const;
+
+	std::vector< Voice >	mVoices;
+	int						mVoicesInUse;
+	unsigned int			mPlayCounter;
+
+	StealPolicy				mStealPolicy;
+	int						mMaxPlaysPerFrame;
+	std::vector< std::pair< ISound*, int > > mPlaysThisFrame;
+	VoicePlayingFunc		mVoicePlayingFunc;
+
+	Stats					mStats;
+};
+
+} // end o namespace poro
+
+#endif
@@ -0,0 +1,545 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#include "sound_stream.h"
+#include <cstring>
+#include "poro_macros.h"
+
+namespace poro {
+
+namespace {
+
+	// the wav files are little endian
+	bool IsBigEndian()
+	{
+		const unsigned short probe = 1;
+		return *(const unsigned char*)&probe == 0;
+	}
+
+	unsigned int ReadLE( const unsigned char* bytes, int count )
+	{
+		unsigned int result = 0;
+		for( int i = count - 1; i >= 0; --i )
+			result = ( result << 8 ) | bytes[ i ];
+		return result;
+	}
+
+	inline types::Int16 Clip( int sample )
+	{
+		if( sample > 32767 ) return 32767;
+		if( sample < -32768 ) return -32768;
+		return (types::Int16)sample;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+WavStreamDecoder::WavStreamDecoder() :
+	mFile( NULL ),
+	mDataStart( 0 ),
+	mChannels( 0 ),
+	mSampleRate( 0 ),
+	mFrameCount( 0 ),
+	mPosition( 0 )
+{
+}
+
+WavStreamDecoder::~WavStreamDecoder()
+{
+	if( mFile )
+		fclose( mFile );
+	mFile = NULL;
+}
+
+bool WavStreamDecoder::Open( const types::string& filename )
+{
+	poro_assert( mFile == NULL );
+
+	mFile = fopen( filename.c_str(), "rb" );
+	if( mFile == NULL )
+		return false;
+
+	unsigned char header[ 16 ];
+	if( fread( header, 1, 12, mFile ) != 12 ||
+		memcmp( header, "RIFF", 4 ) != 0 ||
+		memcmp( header + 8, "WAVE", 4 ) != 0 )
+	{
+		fclose( mFile );
+		mFile = NULL;
+		return false;
+	}
+
+	int bits = 0;
+	int format = 0;
+	while( fread( header, 1, 8, mFile ) == 8 )
+	{
+		const unsigned int size = ReadLE( header + 4, 4 );
+
+		if( memcmp( header, "fmt ", 4 ) == 0 && size >= 16 )
+		{
+			if( fread( header, 1, 16, mFile ) != 16 )
+				break;
+
+			format = ReadLE( header, 2 );
+			mChannels = ReadLE( header + 2, 2 );
+			mSampleRate = ReadLE( header + 4, 4 );
+			bits = ReadLE( header + 14, 2 );
+			fseek( mFile, ( size - 16 ) + ( size & 1 ), SEEK_CUR );
+		}
+		else if( memcmp( header, "data", 4 ) == 0 )
+		{
+			if( format != 1 || bits != 16 || mChannels < 1 || mChannels > 2 )
+				break;
+
+			mDataStart = ftell( mFile );
+			mFrameCount = size / ( mChannels * 2 );
+			mPosition = 0;
+			return true;
+		}
+		else
+		{
+			fseek( mFile, size + ( size & 1 ), SEEK_CUR );
+		}
+	}
+
+	fclose( mFile );
+	mFile = NULL;
+	return false;
+}
+
+std::size_t WavStreamDecoder::GetMemoryUsage() const
+{
+	return sizeof( *this ) + BUFSIZ;
+}
+
+int WavStreamDecoder::Read( types::Int16* buffer, int frames )
+{
+	if( mFile == NULL )
+		return 0;
+
+	if( frames > mFrameCount - mPosition )
+		frames = mFrameCount - mPosition;
+	if( frames <= 0 )
+		return 0;
+
+	const int read = (int)fread( buffer, mChannels * sizeof( types::Int16 ), frames, mFile );
+	mPosition += read;
+
+	if( IsBigEndian() )
+	{
+		unsigned char* bytes = (unsigned char*)buffer;
+		for( int i = 0; i < read * mChannels * 2; i += 2 )
+		{
+			const unsigned char t = bytes[ i ];
+			bytes[ i ] = bytes[ i + 1 ];
+			bytes[ i + 1 ] = t;
+		}
+	}
+
+	return read;
+}
+
+bool WavStreamDecoder::Seek( int frame )
+{
+	if( mFile == NULL )
+		return false;
+
+	if( frame < 0 ) frame = 0;
+	if( frame > mFrameCount ) frame = mFrameCount;
+
+	if( fseek( mFile, mDataStart + (long)frame * mChannels * 2, SEEK_SET ) != 0 )
+		return false;
+
+	mPosition = frame;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+SoundStream* CreateWavStream( const types::string& filename, int ring_frames )
+{
+	WavStreamDecoder* decoder = new WavStreamDecoder;
+	if( decoder->Open( filename ) == false )
+	{
+		delete decoder;
+		return NULL;
+	}
+
+	return new SoundStream( decoder, ring_frames );
+}
+
+//-----------------------------------------------------------------------------
+
+SoundStream::SoundStream( ISoundStreamDecoder* decoder, int ring_frames ) :
+	mDecoder( decoder ),
+	mMixer( NULL ),
+	mRing( ring_frames * 2 ),
+	mRingFrames( ring_frames ),
+	mRingRead( 0 ),
+	mRingSize( 0 ),
+	mPlaying( false ),
+	mLoop( false ),
+	mEndOfStream( false ),
+	mSeekFrame( -1 ),
+	mPosition( 0 ),
+	mGain( 1.f ),
+	mFadeTarget( 1.f ),
+	mFadeStep( 0 ),
+	mFadeFrames( 0 ),
+	mStopAfterFade( false ),
+	mStats()
+{
+	poro_assert( decoder );
+	poro_assert( ring_frames >= DecodeBlockFrames );
+	poro_assert( decoder->GetChannels() == 1 || decoder->GetChannels() == 2 );
+}
+
+SoundStream::~SoundStream()
+{
+	SoundStreamMixer* mixer = mMixer;
+	if( mixer )
+	{
+		mixer->Lock();
+		mixer->Remove( this );
+		mixer->Unlock();
+	}
+
+	delete mDecoder;
+	mDecoder = NULL;
+}
+
+float SoundStream::GetPosition() const
+{
+	return (float)mPosition / (float)mDecoder->GetSampleRate();
+}
+
+float SoundStream::GetDuration() const
+{
+	return (float)mDecoder->GetFrameCount() / (float)mDecoder->GetSampleRate();
+}
+
+std::size_t SoundStream::GetMemoryUsage() const
+{
+	return sizeof( *this ) + mRing.size() * sizeof( types::Int16 ) + mDecoder->GetMemoryUsage();
+}
+
+//-----------------------------------------------------------------------------
+
+void SoundStream::Start( float volume, bool loop )
+{
+	mPlaying = true;
+	mLoop = loop;
+	mGain = volume;
+	mFadeTarget = volume;
+	mFadeStep = 0;
+	mFadeFrames = 0;
+	mStopAfterFade = false;
+	mSeekFrame = 0;
+}
+
+void SoundStream::Stop()
+{
+	mPlaying = false;
+	mFadeFrames = 0;
+	mStopAfterFade = false;
+}
+
+void SoundStream::Seek( float seconds )
+{
+	int frame = (int)( seconds * (float)mDecoder->GetSampleRate() + 0.5f );
+	if( frame < 0 ) frame = 0;
+	mSeekFrame = frame;
+}
+
+void SoundStream::FadeTo( float volume, float seconds, bool stop_at_end )
+{
+	const int frames = (int)( seconds * (float)mDecoder->GetSampleRate() );
+
+	mFadeTarget = volume;
+	mStopAfterFade = stop_at_end;
+
+	if( frames <= 0 )
+	{
+		mGain = volume;
+		mFadeFrames = 0;
+		if( stop_at_end ) 
+			Stop();
+		return;
+	}
+
+	mFadeFrames = frames;
+	mFadeStep = ( volume - mGain ) / (float)frames;
+}
+
+//-----------------------------------------------------------------------------
+
+void SoundStream::ApplySeek()
+{
+	int frame = mSeekFrame;
+	mSeekFrame = -1;
+
+	if( frame > mDecoder->GetFrameCount() )
+		frame = mDecoder->GetFrameCount();
+
+	mDecoder->Seek( frame );
+	mRingRead = 0;
+	mRingSize = 0;
+	mPosition = frame;
+	mEndOfStream = false;
+}
+
+int SoundStream::Decode( types::Int16* output, int frames )
+{
+	const int channels = mDecoder->GetChannels();
+
+	int done = 0;
+	bool rewound = false;
+	while( done < frames )
+	{
+		const int read = mDecoder->Read( output + done * 2, frames - done );
+		mStats.decode_calls++;
+
+		// mono is read into the start and spread out from the back
+		if( channels == 1 )
+		{
+			types::Int16* p = output + done * 2;
+			for( int i = read - 1; i >= 0; --i )
+			{
+				p[ i * 2 + 1 ] = p[ i ];
+				p[ i * 2 ] = p[ i ];
+			}
+		}
+
+		done += read;
+		if( read > 0 )
+			rewound = false;
+
+		if( done < frames )
+		{
+			// rewinding right here is what makes the loop gapless. An empty
+			// stream would rewind forever
+			if( mLoop && rewound == false && mDecoder->Seek( 0 ) )
+			{
+				rewound = true;
+				mStats.loops++;
+			}
+			else
+			{
+				mEndOfStream = true;
+				break;
+			}
+		}
+	}
+
+	mStats.frames_decoded += done;
+	return done;
+}
+
+void SoundStream::Fill( int frames_needed )
+{
+	// decodes whole blocks while there's room, or less if the mixing needs
+	// it right now
+	while( mEndOfStream == false )
+	{
+		const int space = mRingFrames - mRingSize;
+		if( space < DecodeBlockFrames && mRingSize >= frames_needed )
+			break;
+		if( space == 0 )
+			break;
+
+		const int write = ( mRingRead + mRingSize ) % mRingFrames;
+		int frames = space < DecodeBlockFrames ? space : DecodeBlockFrames;
+		if( frames > mRingFrames - write )
+			frames = mRingFrames - write;
+
+		mRingSize += Decode( &mRing[ write * 2 ], frames );
+	}
+}
+
+bool SoundStream::Mix( types::Int16* output, int frames )
+{
+	if( mPlaying == false )
+		return false;
+
+	if( mSeekFrame >= 0 )
+		ApplySeek();
+
+	Fill( frames );
+
+	int available = mRingSize < frames ? mRingSize : frames;
+	if( available < frames && mEndOfStream == false )
+		mStats.underruns++;
+
+	const int frame_count = mDecoder->GetFrameCount();
+	for( int i = 0; i < available; ++i )
+	{
+		if( mFadeFrames > 0 )
+		{
+			mGain += mFadeStep;
+			if( --mFadeFrames == 0 )
+			{
+				mGain = mFadeTarget;
+				if( mStopAfterFade )
+				{
+					// the rest of the buffer is left for the others
+					Stop();
+					available = i + 1;
+				}
+			}
+		}
+
+		const types::Int16* in = &mRing[ mRingRead * 2 ];
+		output[ i * 2 ] = Clip( output[ i * 2 ] + (int)( in[ 0 ] * mGain ) );
+		output[ i * 2 + 1 ] = Clip( output[ i * 2 + 1 ] + (int)( in[ 1 ] * mGain ) );
+
+		if( ++mRingRead == mRingFrames )
+			mRingRead = 0;
+	}
+
+	mRingSize -= available;
+	mStats.frames_played += available;
+
+	mPosition += available;
+	if( frame_count > 0 && mPosition >= frame_count )
+		mPosition = mLoop ? mPosition % frame_count : frame_count;
+
+	if( mEndOfStream && mRingSize == 0 )
+		Stop();
+
+	return mPlaying;
+}
+
+//-----------------------------------------------------------------------------
+
+SoundStreamMixer::SoundStreamMixer( int sample_rate, LockFunc lock, LockFunc unlock ) :
+	mSampleRate( sample_rate ),
+	mLock( lock ),
+	mUnlock( unlock ),
+	mStreams()
+{
+}
+
+SoundStreamMixer::~SoundStreamMixer()
+{
+	Lock();
+	for( std::size_t i = 0; i < mStreams.size(); ++i )
+		mStreams[ i ]->mMixer = NULL;
+	mStreams.clear();
+	Unlock();
+}
+
+void SoundStreamMixer::Add( SoundStream* stream )
+{
+	if( stream->mMixer == this )
+		return;
+
+	// only one mixer per stream
+	poro_assert( stream->mMixer == NULL );
+	stream->mMixer = this;
+	mStreams.push_back( stream );
+}
+
+void SoundStreamMixer::Remove( SoundStream* stream )
+{
+	for( std::size_t i = 0; i < mStreams.size(); ++i )
+	{
+		if( mStreams[ i ] == stream )
+		{
+			mStreams[ i ] = mStreams.back();
+			mStreams.pop_back();
+			break;
+		}
+	}
+
+	stream->mMixer = NULL;
+}
+
+//-----------------------------------------------------------------------------
+
+void SoundStreamMixer::Play( SoundStream* stream, float volume, bool loop )
+{
+	poro_assert( stream );
+	poro_assert( stream->GetDecoder()->GetSampleRate() == mSampleRate );
+
+	Lock();
+	Add( stream );
+	stream->Start( volume, loop );
+	Unlock();
+}
+
+void SoundStreamMixer::Stop( SoundStream* stream )
+{
+	poro_assert( stream );
+
+	Lock();
+	stream->Stop();
+	Unlock();
+}
+
+void SoundStreamMixer::Seek( SoundStream* stream, float seconds )
+{
+	poro_assert( stream );
+
+	Lock();
+	stream->Seek( seconds );
+	Unlock();
+}
+
+void SoundStreamMixer::Crossfade( SoundStream* from, SoundStream* to, float seconds, float volume, bool loop )
+{
+	Lock();
+
+	if( from && from->IsPlaying() )
+		from->FadeTo( 0, seconds, true );
+
+	if( to )
+	{
+		poro_assert( to->GetDecoder()->GetSampleRate() == mSampleRate );
+		Add( to );
+		to->Start( 0, loop );
+		to->FadeTo( volume, seconds, false );
+	}
+
+	Unlock();
+}
+
+int SoundStreamMixer::GetPlayingCount()
+{
+	Lock();
+	int result = 0;
+	for( std::size_t i = 0; i < mStreams.size(); ++i )
+	{
+		if( mStreams[ i ]->IsPlaying() )
+			result++;
+	}
+	Unlock();
+	return result;
+}
+
+void SoundStreamMixer::Mix( types::Int16* output, int frames )
+{
+	for( std::size_t i = 0; i < mStreams.size(); ++i )
+	{
+		if( mStreams[ i ]->IsPlaying() )
+			mStreams[ i ]->Mix( output, frames );
+	}
+}
+
+} // end o namespace poro
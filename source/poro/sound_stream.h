@@ -0,0 +1,212 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#ifndef INC_SOUND_STREAM_H
+#define INC_SOUND_STREAM_H
+
+#include <cstdio>
+#include <vector>
+#include "isound.h"
+#include "poro_types.h"
+
+namespace poro {
+
+class SoundStreamMixer;
+
+//-----------------------------------------------------------------------------
+
+// Where a SoundStream gets its samples from, 16-bit interleaved
+class ISoundStreamDecoder
+{
+public:
+	virtual ~ISoundStreamDecoder() { }
+
+	virtual int		GetChannels() const = 0;
+	virtual int		GetSampleRate() const = 0;
+	virtual int		GetFrameCount() const = 0;
+
+	// returns the number of frames read, less than asked only at the end
+	virtual int		Read( types::Int16* buffer, int frames ) = 0;
+	virtual bool	Seek( int frame ) = 0;
+
+	// what the decoder keeps in memory
+	virtual std::size_t GetMemoryUsage() const { return 0; }
+};
+
+//-----------------------------------------------------------------------------
+
+// 16-bit PCM wav files, mono or stereo, read straight from the disk
+class WavStreamDecoder : public ISoundStreamDecoder
+{
+public:
+	WavStreamDecoder();
+	~WavStreamDecoder();
+
+	bool	Open( const types::string& filename );
+
+	// the stdio buffer, the samples aren't kept around
+	std::size_t GetMemoryUsage() const;
+
+	int		GetChannels() const		{ return mChannels; }
+	int		GetSampleRate() const	{ return mSampleRate; }
+	int		GetFrameCount() const	{ return mFrameCount; }
+
+	int		Read( types::Int16* buffer, int frames );
+	bool	Seek( int frame );
+
+private:
+	FILE*	mFile;
+	long	mDataStart;
+	int		mChannels;
+	int		mSampleRate;
+	int		mFrameCount;
+	int		mPosition;
+};
+
+//-----------------------------------------------------------------------------
+
+// A sound that is decoded bit by bit while it plays instead of all at once.
+// The mixing (called from the audio thread) keeps a ring buffer of stereo
+// frames topped up from the decoder. When a looping stream runs out the
+// decoder is rewound in the middle of the same fill, so there's no gap.
+//
+// Streams are played through a SoundStreamMixer, which takes care of the
+// locking. A stream can be deleted while it's playing.
+class SoundStream : public ISound
+{
+public:
+	enum
+	{
+		DefaultRingFrames = 16384,
+		DecodeBlockFrames = 2048
+	};
+
+	struct Stats
+	{
+		Stats() : frames_decoded( 0 ), frames_played( 0 ), decode_calls( 0 ), loops( 0 ), underruns( 0 ) { }
+
+		int frames_decoded;
+		int frames_played;
+		int decode_calls;
+		int loops;
+		// the decoder couldn't keep up with the mixing
+		int underruns;
+	};
+
+	// takes the ownership of the decoder
+	SoundStream( ISoundStreamDecoder* decoder, int ring_frames = DefaultRingFrames );
+	~SoundStream();
+
+	ISoundStreamDecoder*	GetDecoder()		{ return mDecoder; }
+	bool					IsPlaying() const	{ return mPlaying; }
+	float					GetPosition() const;
+	float					GetDuration() const;
+
+	// the ring buffer and the decoder
+	std::size_t				GetMemoryUsage() const;
+	const Stats&			GetStats() const	{ return mStats; }
+
+	// adds the stream to the stereo 16-bit output. Returns false when the
+	// stream has finished. Called by the SoundStreamMixer
+	bool Mix( types::Int16* output, int frames );
+
+private:
+	friend class SoundStreamMixer;
+
+	void	Start( float volume, bool loop );
+	void	Stop();
+	void	Seek( float seconds );
+	void	FadeTo( float volume, float seconds, bool stop_at_end );
+	void	ApplySeek();
+	void	Fill( int frames_needed );
+	int		Decode( types::Int16* output, int frames );
+
+	ISoundStreamDecoder*		mDecoder;
+	SoundStreamMixer*			mMixer;
+
+	// stereo frames, mRingSize of them starting from mRingRead
+	std::vector< types::Int16 >	mRing;
+	int							mRingFrames;
+	int							mRingRead;
+	int							mRingSize;
+
+	bool	mPlaying;
+	bool	mLoop;
+	bool	mEndOfStream;
+	int		mSeekFrame;
+	int		mPosition;
+
+	float	mGain;
+	float	mFadeTarget;
+	float	mFadeStep;
+	int		mFadeFrames;
+	bool	mStopAfterFade;
+
+	Stats	mStats;
+};
+
+// NULL if the file can't be opened or isn't a 16-bit PCM wav
+SoundStream* CreateWavStream( const types::string& filename, int ring_frames = SoundStream::DefaultRingFrames );
+
+//-----------------------------------------------------------------------------
+
+// Plays the streams. Mix() is called from the audio callback, the rest from
+// the main thread with the lock functions keeping the two apart. A stream
+// stays attached to the mixer it was first played with until it's deleted
+class SoundStreamMixer
+{
+public:
+	typedef void (*LockFunc)();
+
+	SoundStreamMixer( int sample_rate, LockFunc lock = NULL, LockFunc unlock = NULL );
+	~SoundStreamMixer();
+
+	int		GetSampleRate() const { return mSampleRate; }
+
+	void	Play( SoundStream* stream, float volume, bool loop );
+	void	Stop( SoundStream* stream );
+	void	Seek( SoundStream* stream, float seconds );
+
+	// fades the from stream out and the to stream in over the same time, from
+	// is stopped once it's silent. Either one can be NULL
+	void	Crossfade( SoundStream* from, SoundStream* to, float seconds, float volume, bool loop );
+
+	int		GetPlayingCount();
+
+	// adds all the playing streams to the stereo 16-bit output
+	void	Mix( types::Int16* output, int frames );
+
+private:
+	friend class SoundStream;
+
+	void	Lock()		{ if( mLock ) mLock(); }
+	void	Unlock()	{ if( mUnlock ) mUnlock(); }
+	void	Add( SoundStream* stream );
+	void	Remove( SoundStream* stream );
+
+	int							mSampleRate;
+	LockFunc					mLock;
+	LockFunc					mUnlock;
+	std::vector< SoundStream* >	mStreams;
+};
+
+} // end o namespace poro
+
+#endif
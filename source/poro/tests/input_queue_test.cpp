@@ -0,0 +1,143 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#include "../input_queue.h"
+#include "../poro_libraries.h"
+
+#ifdef PORO_TESTER_ENABLED
+
+namespace poro {
+namespace test {
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+
+	InputQueue::Event MakeEvent( int type, double time, int x = 0, int y = 0, int button = 0 )
+	{
+		InputQueue::Event result;
+		result.type = type;
+		result.time = time;
+		result.x = x;
+		result.y = y;
+		result.button = button;
+		return result;
+	}
+
+} // end of anonymous namespace
+///////////////////////////////////////////////////////////////////////////////
+
+int InputQueue_Test()
+{
+	// a run of motion becomes the last one of the run
+	{
+		InputQueue queue;
+		queue.BeginFrame();
+		for( int i = 0; i < 10; ++i )
+			queue.Push( MakeEvent( InputQueue::Event::MOUSE_MOVE, i * 0.001, i, i * 2 ) );
+
+		test_assert( queue.GetEvents().size() == 1 );
+		test_assert( queue.GetEvents()[ 0 ].x == 9 );
+		test_assert( queue.GetEvents()[ 0 ].y == 18 );
+		test_assert( queue.GetEvents()[ 0 ].time == 9 * 0.001 );
+		test_assert( queue.GetRawEvents().size() == 10 );
+
+		test_assert( queue.GetFrameStats().received == 10 );
+		test_assert( queue.GetFrameStats().dispatched == 1 );
+		test_assert( queue.GetFrameStats().coalesced == 9 );
+	}
+
+	// the order stays the same around the buttons and keys
+	{
+		InputQueue queue;
+		queue.BeginFrame();
+		queue.Push( MakeEvent( InputQueue::Event::MOUSE_MOVE, 0.0, 1, 1 ) );
+		queue.Push( MakeEvent( InputQueue::Event::MOUSE_MOVE, 0.1, 2, 2 ) );
+		queue.Push( MakeEvent( InputQueue::Event::MOUSE_DOWN, 0.2, 2, 2, 1 ) );
+		queue.Push( MakeEvent( InputQueue::Event::MOUSE_MOVE, 0.3, 3, 3 ) );
+		queue.Push( MakeEvent( InputQueue::Event::MOUSE_MOVE, 0.4, 4, 4 ) );
+		queue.Push( MakeEvent( InputQueue::Event::KEY_DOWN, 0.5, 0, 0, 32 ) );
+		queue.Push( MakeEvent( InputQueue::Event::MOUSE_UP, 0.6, 4, 4, 1 ) );
+		queue.Push( MakeEvent( InputQueue::Event::MOUSE_MOVE, 0.7, 5, 5 ) );
+
+		const std::vector< InputQueue::Event >& events = queue.GetEvents();
+		test_assert( events.size() == 6 );
+		test_assert( events[ 0 ].type == InputQueue::Event::MOUSE_MOVE && events[ 0 ].x == 2 );
+		test_assert( events[ 1 ].type == InputQueue::Event::MOUSE_DOWN );
+		test_assert( events[ 2 ].type == InputQueue::Event::MOUSE_MOVE && events[ 2 ].x == 4 );
+		test_assert( events[ 3 ].type == InputQueue::Event::KEY_DOWN && events[ 3 ].button == 32 );
+		test_assert( events[ 4 ].type == InputQueue::Event::MOUSE_UP );
+		test_assert( events[ 5 ].type == InputQueue::Event::MOUSE_MOVE && events[ 5 ].x == 5 );
+
+		for( std::size_t i = 1; i < events.size(); ++i )
+			test_assert( events[ i - 1 ].time < events[ i ].time );
+
+		test_assert( queue.GetRawEvents().size() == 8 );
+		test_assert( queue.GetFrameStats().coalesced == 2 );
+	}
+
+	// without coalescing everything goes through
+	{
+		InputQueue queue;
+		queue.SetCoalesceMouseMotion( false );
+		test_assert( queue.GetCoalesceMouseMotion() == false );
+
+		queue.BeginFrame();
+		for( int i = 0; i < 5; ++i )
+			queue.Push( MakeEvent( InputQueue::Event::MOUSE_MOVE, i * 0.001, i, i ) );
+
+		test_assert( queue.GetEvents().size() == 5 );
+		test_assert( queue.GetFrameStats().dispatched == 5 );
+		test_assert( queue.GetFrameStats().coalesced == 0 );
+	}
+
+	// frames don't leak into each other, the totals add up
+	{
+		InputQueue queue;
+		queue.BeginFrame();
+		queue.Push( MakeEvent( InputQueue::Event::MOUSE_MOVE, 0.0 ) );
+		queue.Push( MakeEvent( InputQueue::Event::MOUSE_MOVE, 0.1 ) );
+
+		queue.BeginFrame();
+		test_assert( queue.GetEvents().empty() );
+		test_assert( queue.GetRawEvents().empty() );
+		test_assert( queue.GetFrameStats().received == 0 );
+
+		// the motion of the last frame doesn't swallow this one
+		queue.Push( MakeEvent( InputQueue::Event::MOUSE_MOVE, 0.2, 7, 7 ) );
+		test_assert( queue.GetEvents().size() == 1 );
+		test_assert( queue.GetEvents()[ 0 ].x == 7 );
+
+		test_assert( queue.GetTotalStats().received == 3 );
+		test_assert( queue.GetTotalStats().dispatched == 2 );
+		test_assert( queue.GetTotalStats().coalesced == 1 );
+
+		queue.ResetStats();
+		test_assert( queue.GetTotalStats().received == 0 );
+		test_assert( queue.GetFrameStats().received == 1 );
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( InputQueue_Test );
+
+} // end of namespace test
+} // end of namespace poro
+
+#endif
@@ -0,0 +1,191 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#include "../input_recording.h"
+#include "../frame_timing_log.h"
+#include "../joystick.h"
+#include "../poro_libraries.h"
+
+#include <stdio.h>
+
+#ifdef PORO_TESTER_ENABLED
+
+namespace poro {
+namespace test {
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+
+	const char* test_recording = "poro_input_recording_test.bin";
+
+	InputEvent MakeEvent( int type, int id, int button, const types::vec2& value, types::charset unicode = 0 )
+	{
+		InputEvent result;
+		result.type = type;
+		result.id = id;
+		result.button = button;
+		result.value = value;
+		result.unicode = unicode;
+		return result;
+	}
+
+	bool SameEvent( const InputEvent& a, const InputEvent& b )
+	{
+		return a.type == b.type && a.id == b.id && a.button == b.button && 
+			a.unicode == b.unicode && a.value.x == b.value.x && a.value.y == b.value.y;
+	}
+
+} // end of anonymous namespace
+///////////////////////////////////////////////////////////////////////////////
+
+int InputRecording_Test()
+{
+	std::vector< InputEvent > frame0;
+	frame0.push_back( MakeEvent( InputEvent::MOUSE_MOVE, 0, 0, types::vec2( 10.5f, 20.25f ) ) );
+	frame0.push_back( MakeEvent( InputEvent::MOUSE_DOWN, 0, 1, types::vec2( 10.5f, 20.25f ) ) );
+	frame0.push_back( MakeEvent( InputEvent::TOUCH_DOWN, 0, 0, types::vec2( 10.5f, 20.25f ) ) );
+	frame0.push_back( MakeEvent( InputEvent::KEY_DOWN, 0, 273, types::vec2(), 'a' ) );
+
+	// what gets written comes back the same
+	{
+		InputRecorder recorder;
+		test_assert( recorder.Open( test_recording ) );
+
+		for( std::size_t i = 0; i < frame0.size(); ++i )
+			recorder.Add( frame0[ i ] );
+		recorder.EndFrame( 1.f / 60.f );
+
+		// empty frames keep their dt
+		recorder.EndFrame( 0.02f );
+
+		Joystick joystick( 2 );
+		joystick.SetConnected( true );
+		joystick.SetButtonState( Joystick::JOY_BUTTON_START, true );
+		joystick.SetLeftStick( types::vec2( 0.5f, -1.f ) );
+		joystick.SetAnalogButton( 3, 0.75f );
+		recorder.AddJoystick( &joystick );
+		recorder.EndFrame( 0.03f );
+
+		// nothing changed, nothing written
+		recorder.AddJoystick( &joystick );
+		recorder.EndFrame( 0.04f );
+
+		joystick.SetButtonState( Joystick::JOY_BUTTON_START, false );
+		recorder.AddJoystick( &joystick );
+		recorder.EndFrame( 0.05f );
+
+		test_assert( recorder.GetFrameCount() == 5 );
+		recorder.Close();
+
+		InputReplayer replayer;
+		test_assert( replayer.Open( test_recording ) );
+
+		test_assert( replayer.NextFrame() );
+		test_assert( replayer.GetDt() == 1.f / 60.f );
+		test_assert( replayer.GetEvents().size() == frame0.size() );
+		for( std::size_t i = 0; i < frame0.size(); ++i )
+			test_assert( SameEvent( replayer.GetEvents()[ i ], frame0[ i ] ) );
+
+		test_assert( replayer.NextFrame() );
+		test_assert( replayer.GetDt() == 0.02f );
+		test_assert( replayer.GetEvents().empty() );
+
+		test_assert( replayer.NextFrame() );
+		test_assert( replayer.GetDt() == 0.03f );
+		const std::vector< InputEvent >& events = replayer.GetEvents();
+		test_assert( events.size() == 4 );
+		test_assert( events[ 0 ].type == InputEvent::JOY_CONNECTED && events[ 0 ].id == 2 );
+		test_assert( events[ 1 ].type == InputEvent::JOY_LEFT_STICK && events[ 1 ].value.x == 0.5f && events[ 1 ].value.y == -1.f );
+		test_assert( events[ 2 ].type == InputEvent::JOY_BUTTON_DOWN && events[ 2 ].button == Joystick::JOY_BUTTON_START );
+		test_assert( events[ 3 ].type == InputEvent::JOY_ANALOG && events[ 3 ].button == 3 && events[ 3 ].value.x == 0.75f );
+
+		test_assert( replayer.NextFrame() );
+		test_assert( replayer.GetEvents().empty() );
+
+		test_assert( replayer.NextFrame() );
+		test_assert( replayer.GetEvents().size() == 1 );
+		test_assert( replayer.GetEvents()[ 0 ].type == InputEvent::JOY_BUTTON_UP );
+
+		test_assert( replayer.IsDone() );
+		test_assert( replayer.NextFrame() == false );
+		test_assert( replayer.GetFrameCount() == 5 );
+	}
+
+	// a recording that was cut off ends at the last whole frame
+	{
+		FILE* file = fopen( test_recording, "rb" );
+		test_assert( file );
+		std::vector< unsigned char > data( 4096 );
+		data.resize( fread( &data[ 0 ], 1, data.size(), file ) );
+		fclose( file );
+
+		file = fopen( test_recording, "wb" );
+		fwrite( &data[ 0 ], 1, data.size() - 2, file );
+		fclose( file );
+
+		InputReplayer replayer;
+		test_assert( replayer.Open( test_recording ) );
+		int frames = 0;
+		while( replayer.NextFrame() )
+			frames++;
+		test_assert( frames == 4 );
+	}
+
+	// not a recording
+	{
+		FILE* file = fopen( test_recording, "wb" );
+		fputs( "hello world", file );
+		fclose( file );
+
+		InputReplayer replayer;
+		test_assert( replayer.Open( test_recording ) == false );
+		test_assert( replayer.Open( "this_file_does_not_exist.bin" ) == false );
+	}
+
+	remove( test_recording );
+
+	// frame timings
+	{
+		FrameTimingLog log;
+		test_assert( log.GetAverage() == 0 );
+
+		for( int i = 1; i <= 100; ++i )
+		{
+			FrameTimingLog::Frame frame;
+			frame.frame = i;
+			frame.total = (double)( 101 - i );
+			log.Add( frame );
+		}
+
+		test_assert( log.GetAverage() == 50.5 );
+		test_assert( log.GetPercentile( 50 ) == 50 );
+		test_assert( log.GetPercentile( 95 ) == 95 );
+		test_assert( log.GetPercentile( 100 ) == 100 );
+		test_assert( log.GetPercentile( 0 ) == 1 );
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( InputRecording_Test );
+
+} // end of namespace test
+} // end of namespace poro
+
+#endif
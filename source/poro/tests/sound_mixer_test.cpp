@@ -0,0 +1,241 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#include "../sound_mixer.h"
+#include "../poro_libraries.h"
+
+#ifdef PORO_TESTER_ENABLED
+
+namespace poro {
+namespace test {
+
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+
+	class TestSound : public ISound
+	{
+	public:
+		TestSound( int priority = 0, int max_instances = 0 )
+		{
+			SetPriority( priority );
+			SetMaxInstances( max_instances );
+		}
+	};
+
+	// the voices below this are still playing
+	int playing_voices = 0;
+	bool IsVoicePlaying( int voice ) { return voice < playing_voices; }
+
+} // end of anonymous namespace
+///////////////////////////////////////////////////////////////////////////////
+
+int SoundMixer_Test()
+{
+	// voices get used up and dropped without stealing
+	{
+		SoundMixer mixer( 4 );
+		mixer.SetStealPolicy( SoundMixer::STEAL_NONE );
+		TestSound sound;
+		bool stolen = false;
+
+		for( int i = 0; i < 4; ++i )
+		{
+			test_assert( mixer.Allocate( &sound, 1.f, stolen ) == i );
+			test_assert( stolen == false );
+		}
+
+		test_assert( mixer.GetVoicesInUse() == 4 );
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) == -1 );
+		test_assert( mixer.GetStats().dropped == 1 );
+		test_assert( mixer.GetStats().played == 4 );
+
+		mixer.Release( 2 );
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) == 2 );
+	}
+
+	// steal the oldest
+	{
+		SoundMixer mixer( 3 );
+		mixer.SetStealPolicy( SoundMixer::STEAL_OLDEST );
+		TestSound sound;
+		bool stolen = false;
+
+		mixer.Allocate( &sound, 1.f, stolen );
+		mixer.Allocate( &sound, 1.f, stolen );
+		mixer.Allocate( &sound, 1.f, stolen );
+
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) == 0 );
+		test_assert( stolen );
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) == 1 );
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) == 2 );
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) == 0 );
+		test_assert( mixer.GetStats().stolen == 4 );
+		test_assert( mixer.GetVoicesInUse() == 3 );
+	}
+
+	// steal the quietest
+	{
+		SoundMixer mixer( 3 );
+		mixer.SetStealPolicy( SoundMixer::STEAL_QUIETEST );
+		TestSound sound;
+		bool stolen = false;
+
+		mixer.Allocate( &sound, 0.5f, stolen );
+		mixer.Allocate( &sound, 0.1f, stolen );
+		mixer.Allocate( &sound, 0.9f, stolen );
+
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) == 1 );
+		test_assert( stolen );
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) == 0 );
+	}
+
+	// priorities
+	{
+		SoundMixer mixer( 2 );
+		TestSound low( 0 );
+		TestSound high( 10 );
+		bool stolen = false;
+
+		test_assert( mixer.Allocate( &high, 1.f, stolen ) == 0 );
+		test_assert( mixer.Allocate( &low, 1.f, stolen ) == 1 );
+
+		// low can't steal from high, but can from itself
+		test_assert( mixer.Allocate( &low, 1.f, stolen ) == 1 );
+		test_assert( stolen );
+
+		// high takes the low one even though high is older
+		test_assert( mixer.Allocate( &high, 1.f, stolen ) == 1 );
+		test_assert( mixer.GetVoiceSound( 1 ) == &high );
+
+		test_assert( mixer.Allocate( &low, 1.f, stolen ) == -1 );
+		test_assert( mixer.GetStats().dropped == 1 );
+	}
+
+	// max instances
+	{
+		SoundMixer mixer( 8 );
+		TestSound limited( 0, 2 );
+		TestSound other;
+		bool stolen = false;
+
+		test_assert( mixer.Allocate( &limited, 1.f, stolen ) == 0 );
+		test_assert( mixer.Allocate( &other, 1.f, stolen ) == 1 );
+		test_assert( mixer.Allocate( &limited, 1.f, stolen ) == 2 );
+
+		// steals its own oldest even though there are free voices
+		test_assert( mixer.Allocate( &limited, 1.f, stolen ) == 0 );
+		test_assert( stolen );
+		test_assert( mixer.GetVoicesInUse() == 3 );
+
+		mixer.SetStealPolicy( SoundMixer::STEAL_NONE );
+		test_assert( mixer.Allocate( &limited, 1.f, stolen ) == -1 );
+
+		std::vector< int > voices;
+		mixer.ReleaseSound( &limited, voices );
+		test_assert( voices.size() == 2 );
+		test_assert( mixer.GetVoicesInUse() == 1 );
+	}
+
+	// rate limiting
+	{
+		SoundMixer mixer( 8 );
+		mixer.SetMaxPlaysPerFrame( 2 );
+		TestSound sound;
+		TestSound other;
+		bool stolen = false;
+
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) != -1 );
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) != -1 );
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) == -1 );
+		test_assert( mixer.Allocate( &other, 1.f, stolen ) != -1 );
+		test_assert( mixer.GetStats().rate_limited == 1 );
+		test_assert( mixer.GetStats().dropped == 0 );
+
+		mixer.NextFrame();
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) != -1 );
+	}
+
+	// dropped and cancelled plays don't use up the frame
+	{
+		SoundMixer mixer( 1 );
+		mixer.SetMaxPlaysPerFrame( 1 );
+		mixer.SetStealPolicy( SoundMixer::STEAL_NONE );
+		TestSound sound;
+		TestSound other;
+		bool stolen = false;
+
+		test_assert( mixer.Allocate( &other, 1.f, stolen ) == 0 );
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) == -1 );
+		test_assert( mixer.GetStats().dropped == 1 );
+
+		mixer.Release( 0 );
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) == 0 );
+		mixer.Cancel( 0 );
+		test_assert( mixer.GetVoicesInUse() == 0 );
+		test_assert( mixer.GetStats().played == 1 );
+
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) == 0 );
+		test_assert( mixer.GetStats().rate_limited == 0 );
+	}
+
+	// finished voices aren't counted as instances or stolen
+	{
+		SoundMixer mixer( 2 );
+		mixer.SetVoicePlayingFunc( IsVoicePlaying );
+		TestSound limited( 0, 1 );
+		TestSound other;
+		bool stolen = false;
+
+		playing_voices = 2;
+		test_assert( mixer.Allocate( &limited, 1.f, stolen ) == 0 );
+		test_assert( mixer.Allocate( &other, 1.f, stolen ) == 1 );
+
+		playing_voices = 0;
+		test_assert( mixer.Allocate( &limited, 1.f, stolen ) == 0 );
+		test_assert( stolen == false );
+		test_assert( mixer.GetStats().stolen == 0 );
+		test_assert( mixer.GetVoicesInUse() == 1 );
+	}
+
+	// shrinking releases the voices that go away
+	{
+		SoundMixer mixer( 4 );
+		TestSound sound;
+		bool stolen = false;
+
+		for( int i = 0; i < 4; ++i )
+			mixer.Allocate( &sound, 1.f, stolen );
+
+		mixer.SetVoiceCount( 2 );
+		test_assert( mixer.GetVoicesInUse() == 2 );
+		mixer.SetVoiceCount( 6 );
+		test_assert( mixer.Allocate( &sound, 1.f, stolen ) == 2 );
+		test_assert( stolen == false );
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( SoundMixer_Test );
+
+} // end of namespace test
+} // end of namespace poro
+
+#endif
@@ -0,0 +1,243 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#include "../platform_defs.h"
+#include "../poro_libraries.h"
+
+#if defined( PORO_TESTER_ENABLED ) && !defined( PORO_PLAT_IPHONE )
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "../desktop/sound_sample_cache.h"
+#include "../libraries.h"
+
+namespace poro {
+namespace test {
+
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+
+	int loads = 0;
+	int frees = 0;
+
+	// the size of the samples is the name of the file, "missing" fails
+	void* TestLoad( const types::string& filename, std::size_t& bytes )
+	{
+		loads++;
+		SDL_Delay( 10 );
+
+		if( filename == "missing" )
+			return NULL;
+
+		bytes = (std::size_t)atoi( filename.c_str() );
+		return new char[ bytes ];
+	}
+
+	void TestFree( void* samples )
+	{
+		frees++;
+		delete [] (char*)samples;
+	}
+
+} // end of anonymous namespace
+///////////////////////////////////////////////////////////////////////////////
+
+int SoundSampleCache_Test()
+{
+	// sharing and reference counting
+	{
+		loads = 0;
+		frees = 0;
+		SoundSampleCache* cache = new SoundSampleCache( TestLoad, TestFree, 1000 );
+
+		SoundSampleCache::Entry* a = cache->Load( "100" );
+		SoundSampleCache::Entry* b = cache->Load( "100" );
+		test_assert( a == b );
+		test_assert( cache->GetSamples( a ) != NULL );
+		test_assert( loads == 1 );
+
+		SoundSampleCache::Stats stats = cache->GetStats();
+		test_assert( stats.hits == 1 );
+		test_assert( stats.misses == 1 );
+		test_assert( stats.resident_bytes == 100 );
+		test_assert( stats.entries == 1 );
+
+		// kept around after the last reference
+		cache->Release( a );
+		cache->Release( b );
+		test_assert( frees == 0 );
+		test_assert( cache->GetStats().resident_bytes == 100 );
+
+		a = cache->Load( "100" );
+		test_assert( loads == 1 );
+		test_assert( cache->GetStats().hits == 2 );
+		cache->Release( a );
+
+		cache->Destroy();
+		test_assert( frees == 1 );
+	}
+
+	// least recently used go first, the ones in use never
+	{
+		loads = 0;
+		frees = 0;
+		SoundSampleCache* cache = new SoundSampleCache( TestLoad, TestFree, 1000 );
+
+		SoundSampleCache::Entry* a = cache->Load( "400" );
+		SoundSampleCache::Entry* b = cache->Load( "401" );
+		SoundSampleCache::Entry* c = cache->Load( "402" );
+		test_assert( cache->GetStats().resident_bytes == 1203 );
+		test_assert( cache->GetStats().evictions == 0 );
+
+		cache->Release( b );
+		cache->Release( a );
+		test_assert( cache->GetStats().evictions == 1 );
+		test_assert( cache->GetStats().resident_bytes == 802 );
+
+		// b was the older one, it's gone
+		SoundSampleCache::Entry* b2 = cache->Load( "401" );
+		test_assert( loads == 4 );
+		test_assert( cache->GetStats().evictions == 2 );
+		test_assert( cache->GetStats().resident_bytes == 803 );
+
+		a = cache->Load( "400" );
+		test_assert( loads == 5 );
+
+		// going over is fine while everything is in use
+		test_assert( cache->GetStats().resident_bytes == 1203 );
+
+		cache->SetBudget( 0 );
+		test_assert( cache->GetStats().resident_bytes == 1203 );
+		cache->Release( c );
+		test_assert( cache->GetStats().resident_bytes == 801 );
+
+		cache->Release( a );
+		cache->Release( b2 );
+		test_assert( cache->GetStats().entries == 0 );
+		test_assert( frees == 5 );
+
+		cache->Destroy();
+	}
+
+	// background loading
+	{
+		loads = 0;
+		frees = 0;
+		SoundSampleCache* cache = new SoundSampleCache( TestLoad, TestFree, 100000 );
+
+		std::vector< SoundSampleCache::Entry* > entries;
+		for( int i = 0; i < 10; ++i )
+		{
+			entries.push_back( cache->LoadAsync( "1000" ) );
+			entries.push_back( cache->LoadAsync( "2000" ) );
+		}
+
+		test_assert( cache->GetStats().misses == 2 );
+		test_assert( cache->GetStats().hits == 18 );
+
+		// waits for the background thread
+		SoundSampleCache::Entry* sync = cache->Load( "2000" );
+		test_assert( cache->GetSamples( sync ) != NULL );
+		test_assert( cache->IsLoading( sync ) == false );
+
+		cache->WaitForLoads();
+		test_assert( loads == 2 );
+		test_assert( cache->GetStats().loading == 0 );
+		test_assert( cache->GetStats().resident_bytes == 3000 );
+		for( std::size_t i = 0; i < entries.size(); ++i )
+			test_assert( cache->GetSamples( entries[ i ] ) == cache->GetSamples( entries[ i % 2 ] ) );
+
+		// failing
+		SoundSampleCache::Entry* missing = cache->LoadAsync( "missing" );
+		cache->WaitForLoads();
+		test_assert( cache->IsLoading( missing ) == false );
+		test_assert( cache->GetSamples( missing ) == NULL );
+		test_assert( cache->GetStats().failed == 1 );
+		test_assert( cache->GetStats().entries == 2 );
+
+		// isn't cached, tried again even while the failed one is referenced
+		const int misses = cache->GetStats().misses;
+		SoundSampleCache::Entry* retry = cache->Load( "missing" );
+		test_assert( retry != missing );
+		test_assert( loads == 4 );
+		test_assert( cache->GetStats().misses == misses + 1 );
+		test_assert( cache->GetStats().failed == 2 );
+		cache->Release( missing );
+		test_assert( cache->GetStats().entries == 2 );
+
+		// outlives Destroy() while there are references
+		cache->Destroy();
+		test_assert( frees == 0 );
+		for( std::size_t i = 0; i < entries.size(); ++i )
+			cache->Release( entries[ i ] );
+
+		test_assert( frees == 1 );
+		cache->Release( sync );
+		test_assert( frees == 2 );
+
+		// the failed ones keep the cache alive too
+		cache->Release( retry );
+	}
+
+	// Destroy() cancels the queued loads, they aren't failures
+	{
+		loads = 0;
+		frees = 0;
+		SoundSampleCache* cache = new SoundSampleCache( TestLoad, TestFree, 100000 );
+
+		std::vector< SoundSampleCache::Entry* > entries;
+		for( int i = 1; i <= 10; ++i )
+		{
+			char name[ 8 ];
+			sprintf( name, "%d", i );
+			entries.push_back( cache->LoadAsync( name ) );
+		}
+
+		cache->Destroy();
+		test_assert( loads < 10 );
+
+		SoundSampleCache::Stats stats = cache->GetStats();
+		test_assert( stats.loading == 0 );
+		test_assert( stats.failed == 0 );
+
+		int cancelled = 0;
+		for( std::size_t i = 0; i < entries.size(); ++i )
+		{
+			test_assert( cache->IsLoading( entries[ i ] ) == false );
+			if( cache->GetSamples( entries[ i ] ) == NULL )
+				cancelled++;
+		}
+		test_assert( cancelled == 10 - loads );
+
+		for( std::size_t i = 0; i < entries.size(); ++i )
+			cache->Release( entries[ i ] );
+		test_assert( frees == loads );
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( SoundSampleCache_Test );
+
+} // end of namespace test
+} // end of namespace poro
+
+#endif
@@ -0,0 +1,181 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+#include "../sound_stream.h"
+#include "../poro_libraries.h"
+#include "../../tester/tester_benchmark.h"
+#include "test_wav.h"
+
+#ifdef CENG_ALLOCATION_TRACKER_ENABLED
+#	include "../../utils/memorypool/callocationtracker.h"
+#endif
+
+#ifdef PORO_TESTER_ENABLED
+
+namespace poro {
+namespace test {
+
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+
+	const int bench_rate = 44100;
+	const int bench_file_seconds = 30;
+	const int bench_play_seconds = 10;
+	const int bench_callback_frames = 1024;
+
+	void WriteBenchWav( const std::string& filename, int frames )
+	{
+		std::vector< types::Int16 > samples( frames * 2 );
+		for( int i = 0; i < frames * 2; ++i )
+			samples[ i ] = (types::Int16)( ( i * 13 ) % 8000 - 4000 );
+
+		WriteTestWav( filename, samples, 2, bench_rate );
+	}
+
+	// times the decoding that SoundStream::Decode() asks for, so it can be
+	// told apart from the mixing
+	class TimedDecoder : public ISoundStreamDecoder
+	{
+	public:
+		TimedDecoder( ISoundStreamDecoder* decoder, double& seconds ) : mDecoder( decoder ), mSeconds( seconds ) { }
+		~TimedDecoder() { delete mDecoder; }
+
+		int		GetChannels() const		{ return mDecoder->GetChannels(); }
+		int		GetSampleRate() const	{ return mDecoder->GetSampleRate(); }
+		int		GetFrameCount() const	{ return mDecoder->GetFrameCount(); }
+
+		int Read( types::Int16* buffer, int frames )
+		{
+			poro::tester::CBenchmarkTimer timer;
+			const int result = mDecoder->Read( buffer, frames );
+			mSeconds += timer.GetSeconds();
+			return result;
+		}
+
+		bool Seek( int frame )
+		{
+			poro::tester::CBenchmarkTimer timer;
+			const bool result = mDecoder->Seek( frame );
+			mSeconds += timer.GetSeconds();
+			return result;
+		}
+
+		std::size_t GetMemoryUsage() const { return mDecoder->GetMemoryUsage(); }
+
+	private:
+		ISoundStreamDecoder*	mDecoder;
+		double&					mSeconds;
+	};
+
+	SoundStream* CreateBenchStream( const std::string& filename, double& decode_seconds )
+	{
+		WavStreamDecoder* decoder = new WavStreamDecoder;
+		if( decoder->Open( filename ) == false )
+		{
+			delete decoder;
+			return NULL;
+		}
+
+		return new SoundStream( new TimedDecoder( decoder, decode_seconds ) );
+	}
+
+} // end of anonymous namespace
+///////////////////////////////////////////////////////////////////////////////
+
+// drives the mixer the way the audio callback would, without any sound
+// hardware
+int SoundStream_Benchmark()
+{
+	const std::string filename = "temp/sound_stream_benchmark.wav";
+	WriteBenchWav( filename, bench_rate * bench_file_seconds );
+
+	const int play_frames = bench_rate * bench_play_seconds;
+	std::vector< types::Int16 > output( bench_callback_frames * 2 );
+
+	test_logger << "SoundStream, " << bench_play_seconds << " s of audio in " << bench_callback_frames << " frame callbacks" << std::endl;
+
+	for( int stream_count = 1; stream_count <= 8; stream_count *= 2 )
+	{
+#ifdef CENG_ALLOCATION_TRACKER_ENABLED
+		ceng::CAllocationTracker::ResetPeaks();
+		const std::size_t live_before = ceng::CAllocationTracker::GetTotalStats().live_bytes;
+#endif
+
+		double decode_seconds = 0;
+		SoundStreamMixer mixer( bench_rate );
+		std::vector< SoundStream* > streams;
+		for( int i = 0; i < stream_count; ++i )
+		{
+			streams.push_back( CreateBenchStream( filename, decode_seconds ) );
+			mixer.Play( streams.back(), 0.5f, true );
+		}
+
+		poro::tester::CBenchmarkTimer timer;
+		for( int frame = 0; frame < play_frames; frame += bench_callback_frames )
+		{
+			std::fill( output.begin(), output.end(), 0 );
+			mixer.Mix( &output[ 0 ], bench_callback_frames );
+		}
+		const double seconds = timer.GetSeconds();
+
+		std::size_t memory = 0;
+		int underruns = 0;
+		for( int i = 0; i < stream_count; ++i )
+		{
+			memory += streams[ i ]->GetMemoryUsage();
+			underruns += streams[ i ]->GetStats().underruns;
+		}
+
+		std::stringstream name;
+		name << stream_count << " streams";
+		poro::tester::BenchmarkReport( name.str(), seconds, play_frames * stream_count );
+
+		const double real_time = (double)bench_play_seconds * stream_count / 100.0;
+		test_logger << "    per stream, % of real time: decode " << decode_seconds / real_time
+			<< ", mix " << ( seconds - decode_seconds ) / real_time
+			<< ", total " << seconds / real_time << std::endl;
+
+		// GetMemoryUsage() adds up the ring and the stdio buffer, the tracker
+		// sees what actually went through new
+		const std::size_t decoded_bytes = (std::size_t)bench_rate * bench_file_seconds * 4;
+		test_logger << "    memory per stream: " << memory / stream_count / 1024 << " kb estimated";
+#ifdef CENG_ALLOCATION_TRACKER_ENABLED
+		const std::size_t peak = ceng::CAllocationTracker::GetTotalStats().peak_bytes - live_before;
+		test_logger << ", " << peak / stream_count / 1024 << " kb peak allocated";
+#endif
+		test_logger << " (decoded whole: " << decoded_bytes / 1024 << " kb)"
+			<< ", underruns: " << underruns << std::endl;
+
+		for( int i = 0; i < stream_count; ++i )
+			delete streams[ i ];
+	}
+
+	return 0;
+}
+
+BENCHMARK_REGISTER( SoundStream_Benchmark );
+
+} // end of namespace test
+} // end of namespace poro
+
+#endif
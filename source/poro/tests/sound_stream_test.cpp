@@ -0,0 +1,228 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#include <vector>
+#include "../sound_stream.h"
+#include "../poro_libraries.h"
+#include "test_wav.h"
+
+#ifdef PORO_TESTER_ENABLED
+
+namespace poro {
+namespace test {
+
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+
+	const int test_rate = 44100;
+
+	types::Int16 TestSample( int frame ) { return (types::Int16)( ( frame * 7 ) % 20000 - 10000 ); }
+
+	// the left channel is TestSample() and the right one is the negative of
+	// it. If constant isn't 0 every sample is that
+	void WriteStreamWav( const std::string& filename, int frames, int channels, int constant = 0 )
+	{
+		std::vector< types::Int16 > samples;
+		samples.reserve( frames * channels );
+		for( int i = 0; i < frames; ++i )
+		{
+			const int sample = constant ? constant : TestSample( i );
+			samples.push_back( (types::Int16)sample );
+			if( channels == 2 )
+				samples.push_back( (types::Int16)( constant ? constant : -sample ) );
+		}
+
+		WriteTestWav( filename, samples, channels, test_rate );
+	}
+
+	// mixes the way the audio callback would, a chunk at a time
+	std::vector< types::Int16 > MixFrames( SoundStreamMixer& mixer, int frames, int chunk = 1024 )
+	{
+		std::vector< types::Int16 > result( frames * 2, 0 );
+		for( int i = 0; i < frames; i += chunk )
+			mixer.Mix( &result[ i * 2 ], ( frames - i ) < chunk ? ( frames - i ) : chunk );
+		return result;
+	}
+
+} // end of anonymous namespace
+///////////////////////////////////////////////////////////////////////////////
+
+int SoundStream_Test()
+{
+	const std::string stereo_file = "temp/sound_stream_test_stereo.wav";
+	const std::string mono_file = "temp/sound_stream_test_mono.wav";
+	const std::string constant_file = "temp/sound_stream_test_constant.wav";
+	WriteStreamWav( stereo_file, 5000, 2 );
+	WriteStreamWav( mono_file, 3000, 1 );
+	WriteStreamWav( constant_file, 4000, 2, 10000 );
+
+	// the decoder
+	{
+		WavStreamDecoder decoder;
+		test_assert( decoder.Open( stereo_file ) );
+		test_assert( decoder.GetChannels() == 2 );
+		test_assert( decoder.GetSampleRate() == test_rate );
+		test_assert( decoder.GetFrameCount() == 5000 );
+
+		types::Int16 buffer[ 20 ];
+		test_assert( decoder.Seek( 4995 ) );
+		test_assert( decoder.Read( buffer, 10 ) == 5 );
+		test_assert( buffer[ 0 ] == TestSample( 4995 ) );
+		test_assert( buffer[ 1 ] == -TestSample( 4995 ) );
+
+		test_assert( CreateWavStream( "temp/this_file_does_not_exist.wav" ) == NULL );
+	}
+
+	// plays through once and stops
+	{
+		SoundStreamMixer mixer( test_rate );
+		SoundStream* stream = CreateWavStream( stereo_file, 4096 );
+		test_assert( stream );
+
+		mixer.Play( stream, 1.f, false );
+		test_assert( mixer.GetPlayingCount() == 1 );
+
+		std::vector< types::Int16 > output = MixFrames( mixer, 6000, 700 );
+		for( int i = 0; i < 5000; ++i )
+		{
+			test_assert( output[ i * 2 ] == TestSample( i ) );
+			test_assert( output[ i * 2 + 1 ] == -TestSample( i ) );
+		}
+		for( int i = 5000; i < 6000; ++i )
+			test_assert( output[ i * 2 ] == 0 );
+
+		test_assert( stream->IsPlaying() == false );
+		test_assert( mixer.GetPlayingCount() == 0 );
+		test_assert( stream->GetStats().frames_played == 5000 );
+		test_assert( stream->GetStats().underruns == 0 );
+
+		delete stream;
+	}
+
+	// looping doesn't leave a gap or repeat anything
+	{
+		SoundStreamMixer mixer( test_rate );
+		SoundStream* stream = CreateWavStream( stereo_file, 4096 );
+		mixer.Play( stream, 1.f, true );
+
+		std::vector< types::Int16 > output = MixFrames( mixer, 12000, 1000 );
+		for( int i = 0; i < 12000; ++i )
+			test_assert( output[ i * 2 ] == TestSample( i % 5000 ) );
+
+		test_assert( stream->IsPlaying() );
+		test_assert( stream->GetStats().loops >= 2 );
+		test_assert( stream->GetPosition() == (float)( 12000 % 5000 ) / (float)test_rate );
+
+		// deleting a playing stream takes it out of the mixer
+		delete stream;
+		test_assert( mixer.GetPlayingCount() == 0 );
+		MixFrames( mixer, 100 );
+	}
+
+	// seeking and playing again starts from the beginning
+	{
+		SoundStreamMixer mixer( test_rate );
+		SoundStream* stream = CreateWavStream( stereo_file );
+		mixer.Play( stream, 1.f, false );
+		MixFrames( mixer, 1000 );
+
+		mixer.Seek( stream, 2000.f / (float)test_rate );
+		std::vector< types::Int16 > output = MixFrames( mixer, 100 );
+		test_assert( output[ 0 ] == TestSample( 2000 ) );
+		test_assert( output[ 99 * 2 ] == TestSample( 2099 ) );
+
+		mixer.Play( stream, 1.f, false );
+		output = MixFrames( mixer, 100 );
+		test_assert( output[ 0 ] == TestSample( 0 ) );
+
+		delete stream;
+	}
+
+	// mono goes to both channels
+	{
+		SoundStreamMixer mixer( test_rate );
+		SoundStream* stream = CreateWavStream( mono_file );
+		mixer.Play( stream, 1.f, false );
+
+		std::vector< types::Int16 > output = MixFrames( mixer, 3000 );
+		for( int i = 0; i < 3000; ++i )
+		{
+			test_assert( output[ i * 2 ] == TestSample( i ) );
+			test_assert( output[ i * 2 + 1 ] == TestSample( i ) );
+		}
+
+		delete stream;
+	}
+
+	// crossfading keeps the sum steady and stops the one faded out
+	{
+		SoundStreamMixer mixer( test_rate );
+		SoundStream* from = CreateWavStream( constant_file );
+		SoundStream* to = CreateWavStream( constant_file );
+
+		mixer.Play( from, 1.f, true );
+		MixFrames( mixer, 500 );
+
+		mixer.Crossfade( from, to, 1000.f / (float)test_rate, 1.f, true );
+		test_assert( mixer.GetPlayingCount() == 2 );
+
+		std::vector< types::Int16 > output = MixFrames( mixer, 3000, 256 );
+		for( int i = 0; i < 3000; ++i )
+			test_assert( output[ i * 2 ] >= 9990 && output[ i * 2 ] <= 10010 );
+
+		test_assert( from->IsPlaying() == false );
+		test_assert( to->IsPlaying() );
+		test_assert( mixer.GetPlayingCount() == 1 );
+
+		// and the sum is clipped
+		mixer.Play( from, 3.f, true );
+		output = MixFrames( mixer, 10 );
+		test_assert( output[ 0 ] == 32767 );
+
+		delete from;
+		delete to;
+	}
+
+	// the memory doesn't grow with the length of the file
+	{
+		const std::string long_file = "temp/sound_stream_test_long.wav";
+		WriteStreamWav( long_file, test_rate * 10, 2 );
+
+		SoundStreamMixer mixer( test_rate );
+		SoundStream* stream = CreateWavStream( long_file );
+		const std::size_t memory = stream->GetMemoryUsage();
+
+		mixer.Play( stream, 1.f, false );
+		MixFrames( mixer, test_rate * 5 );
+		test_assert( stream->GetMemoryUsage() == memory );
+		test_assert( memory < test_rate * 4 );
+
+		delete stream;
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( SoundStream_Test );
+
+} // end of namespace test
+} // end of namespace poro
+
+#endif
@@ -0,0 +1,141 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+#include "../platform_defs.h"
+#include "../poro_libraries.h"
+
+#if defined( PORO_TESTER_ENABLED ) && !defined( PORO_PLAT_IPHONE )
+
+#include "../desktop/soundplayer_sdl.h"
+#include "../desktop/sound_sdl.h"
+#include "test_wav.h"
+
+namespace poro {
+namespace test {
+
+// runs on the dummy driver, so it doesn't need any sound hardware
+int SoundPlayerSDL_Test()
+{
+	SDL_putenv( (char*)"SDL_AUDIODRIVER=dummy" );
+
+	const std::string filename = "temp/soundplayer_sdl_test.wav";
+	// a short stereo wav of silence
+	WriteTestWav( filename, std::vector< types::Int16 >( 2205 * 2, 0 ), 2 );
+
+	{
+		SoundPlayerSDL player;
+		test_assert( player.Init() );
+
+		player.SetVoiceCount( 4 );
+		test_assert( Mix_AllocateChannels( -1 ) == 4 );
+
+		SoundMixer* mixer = player.GetMixer();
+		test_assert( mixer );
+		mixer->SetStealPolicy( SoundMixer::STEAL_OLDEST );
+
+		ISound* sound = player.LoadSound( filename );
+		test_assert( sound );
+
+		// looping so they're still playing when the voices run out
+		for( int i = 0; i < 6; ++i )
+			player.Play( sound, 1.f, true );
+
+		test_assert( mixer->GetVoicesInUse() == 4 );
+		test_assert( mixer->GetStats().stolen == 2 );
+		test_assert( Mix_Playing( -1 ) == 4 );
+
+		player.Stop( sound );
+		test_assert( mixer->GetVoicesInUse() == 0 );
+		test_assert( Mix_Playing( -1 ) == 0 );
+
+		// the ones that finish are noticed by Update()
+		player.Play( sound, 1.f );
+		test_assert( mixer->GetVoicesInUse() == 1 );
+		SDL_Delay( 500 );
+		player.Update();
+		test_assert( mixer->GetVoicesInUse() == 0 );
+
+		// rate limiting
+		mixer->ResetStats();
+		mixer->SetMaxPlaysPerFrame( 1 );
+		player.Play( sound, 1.f );
+		player.Play( sound, 1.f );
+		test_assert( mixer->GetStats().played == 1 );
+		test_assert( mixer->GetStats().rate_limited == 1 );
+
+		player.Stop( sound );
+		delete sound;
+		Mix_CloseAudio();
+	}
+
+	// the decoded samples are shared
+	{
+		SoundPlayerSDL player;
+		test_assert( player.Init() );
+
+		ISound* sound1 = player.LoadSoundAsync( filename );
+		ISound* sound2 = player.LoadSoundAsync( filename );
+		ISound* sound3 = player.LoadSound( filename );
+		test_assert( sound3->IsLoaded() );
+
+		player.GetSampleCache()->WaitForLoads();
+		test_assert( sound1->IsLoaded() );
+		test_assert( sound2->IsLoaded() );
+		test_assert( ((SoundSDL*)sound1)->GetMixChunk() == ((SoundSDL*)sound3)->GetMixChunk() );
+
+		const SoundSampleCache::Stats stats = player.GetSampleCache()->GetStats();
+		test_assert( stats.misses == 1 );
+		test_assert( stats.hits == 2 );
+		test_assert( stats.resident_bytes > 2205 * 4 );
+
+		delete sound1;
+		delete sound2;
+		delete sound3;
+	}
+
+	// streams go through the stream mixer
+	{
+		SoundPlayerSDL player;
+		test_assert( player.Init() );
+
+		ISound* stream = player.LoadStream( filename );
+		test_assert( dynamic_cast< SoundStream* >( stream ) );
+
+		player.Play( stream, 1.f, true );
+		test_assert( player.GetStreamMixer()->GetPlayingCount() == 1 );
+		test_assert( player.GetMixer()->GetVoicesInUse() == 0 );
+
+		player.Stop( stream );
+		test_assert( player.GetStreamMixer()->GetPlayingCount() == 0 );
+
+		delete stream;
+	}
+
+	Mix_CloseAudio();
+	SDL_QuitSubSystem( SDL_INIT_AUDIO );
+	return 0;
+}
+
+TEST_REGISTER( SoundPlayerSDL_Test );
+
+} // end of namespace test
+} // end of namespace poro
+
+#endif
@@ -0,0 +1,68 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include "test_wav.h"
+#include "../poro_libraries.h"
+
+#ifdef PORO_TESTER_ENABLED
+
+#include <fstream>
+
+namespace poro {
+namespace test {
+
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+
+	void WriteInt( std::ofstream& file, unsigned int value, int bytes )
+	{
+		for( int i = 0; i < bytes; ++i )
+			file.put( (char)( ( value >> ( i * 8 ) ) & 0xFF ) );
+	}
+
+} // end of anonymous namespace
+///////////////////////////////////////////////////////////////////////////////
+
+void WriteTestWav( const std::string& filename, const std::vector< types::Int16 >& samples, int channels, int sample_rate )
+{
+	const unsigned int data_size = (unsigned int)samples.size() * 2;
+	std::ofstream file( filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+	file.write( "RIFF", 4 );
+	WriteInt( file, 36 + data_size, 4 );
+	file.write( "WAVEfmt ", 8 );
+	WriteInt( file, 16, 4 );
+	WriteInt( file, 1, 2 );							// pcm
+	WriteInt( file, channels, 2 );
+	WriteInt( file, sample_rate, 4 );
+	WriteInt( file, sample_rate * channels * 2, 4 );	// bytes per second
+	WriteInt( file, channels * 2, 2 );				// block align
+	WriteInt( file, 16, 2 );						// bits
+	file.write( "data", 4 );
+	WriteInt( file, data_size, 4 );
+	for( std::size_t i = 0; i < samples.size(); ++i )
+		WriteInt( file, (unsigned short)samples[ i ], 2 );
+}
+
+} // end of namespace test
+} // end of namespace poro
+
+#endif
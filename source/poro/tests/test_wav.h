@@ -0,0 +1,40 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2010 Petri Purho, Dennis Belfrage
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#ifndef INC_PORO_TEST_WAV_H
+#define INC_PORO_TEST_WAV_H
+
+#include <string>
+#include <vector>
+#include "../poro_types.h"
+
+namespace poro {
+namespace test {
+
+// Writes a 16-bit PCM wav for the sound tests. The samples are interleaved,
+// so there are frames * channels of them.
+void WriteTestWav( const std::string& filename, const std::vector< types::Int16 >& samples, int channels, int sample_rate = 44100 );
+
+} // end of namespace test
+} // end of namespace poro
+
+#endif
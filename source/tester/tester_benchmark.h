@@ -0,0 +1,107 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Benchmarks
+// ==========
+//
+// Benchmarks are written like tests, but they are registered with
+// BENCHMARK_REGISTER and only run when PORO_BENCHMARKS_ENABLED is defined,
+// so the normal test run stays fast.
+//
+// CBenchmarkTimer is a high resolution wall clock timer, CTimer only has
+// millisecond resolution.
+//
+//.............................................................................
+//=============================================================================
+#ifndef INC_TESTER_BENCHMARK_H
+#define INC_TESTER_BENCHMARK_H
+
+#include <string>
+#include <iostream>
+
+#include "ctester.h"
+
+#ifdef PORO_PLAT_WINDOWS
+#	include <windows.h>
+#else
+#	include <sys/time.h>
+#endif
+
+namespace poro {
+namespace tester {
+
+///////////////////////////////////////////////////////////////////////////////
+
+class CBenchmarkTimer
+{
+public:
+	CBenchmarkTimer() : myStart( Now() ) { }
+
+	void Reset() { myStart = Now(); }
+
+	//! seconds since the creation or the last Reset()
+	double GetSeconds() const { return Now() - myStart; }
+
+	//! current time in seconds from some arbitrary point
+	static double Now()
+	{
+#ifdef PORO_PLAT_WINDOWS
+		LARGE_INTEGER frequency;
+		LARGE_INTEGER counter;
+		QueryPerformanceFrequency( &frequency );
+		QueryPerformanceCounter( &counter );
+		return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+		timeval time;
+		gettimeofday( &time, NULL );
+		return (double)time.tv_sec + (double)time.tv_usec * 0.000001;
+#endif
+	}
+
+private:
+	double myStart;
+};
+
+//-----------------------------------------------------------------------------
+
+//! prints "name: x ms (y ns per op)" to the test_logger
+inline void BenchmarkReport( const std::string& name, double seconds, int operations )
+{
+	test_logger << "  " << name << ": " << seconds * 1000.0 << " ms";
+	if( operations > 0 )
+		test_logger << " (" << ( seconds * 1000000000.0 / (double)operations ) << " ns per op)";
+	test_logger << std::endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // end of namespace tester
+} // end of namespace poro
+
+#ifdef PORO_BENCHMARKS_ENABLED
+#	define BENCHMARK_REGISTER( x ) TEST_REGISTER( x )
+#else
+#	define BENCHMARK_REGISTER( x )
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include "cmemorymappedfile.h"
+
+#include "../../poro/platform_defs.h"
+
+#ifdef PORO_PLAT_WINDOWS
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+namespace ceng {
+
+CMemoryMappedFile::CMemoryMappedFile() :
+	myData( NULL ),
+	mySize( 0 ),
+	myFile( NULL ),
+	myMapping( NULL )
+{
+}
+
+CMemoryMappedFile::~CMemoryMappedFile()
+{
+	Close();
+}
+
+//=============================================================================
+
+bool CMemoryMappedFile::Open( const std::string& filename )
+{
+	Close();
+
+#ifdef PORO_PLAT_WINDOWS
+	HANDLE file = CreateFileA( filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if( file == INVALID_HANDLE_VALUE )
+		return false;
+
+	const DWORD size = GetFileSize( file, NULL );
+	if( size == 0 || size == INVALID_FILE_SIZE )
+	{
+		CloseHandle( file );
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	if( mapping == NULL )
+	{
+		CloseHandle( file );
+		return false;
+	}
+
+	void* data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	if( data == NULL )
+	{
+		CloseHandle( mapping );
+		CloseHandle( file );
+		return false;
+	}
+
+	myFile = file;
+	myMapping = mapping;
+	myData = (const char*)data;
+	mySize = (std::size_t)size;
+#else
+	const int file = open( filename.c_str(), O_RDONLY );
+	if( file < 0 )
+		return false;
+
+	struct stat st;
+	if( fstat( file, &st ) != 0 || st.st_size <= 0 )
+	{
+		close( file );
+		return false;
+	}
+
+	void* data = mmap( NULL, (std::size_t)st.st_size, PROT_READ, MAP_PRIVATE, file, 0 );
+
+	// the mapping keeps its own reference to the file
+	close( file );
+
+	if( data == MAP_FAILED )
+		return false;
+
+	myData = (const char*)data;
+	mySize = (std::size_t)st.st_size;
+#endif
+
+	return true;
+}
+
+void CMemoryMappedFile::Close()
+{
+	if( myData == NULL )
+		return;
+
+#ifdef PORO_PLAT_WINDOWS
+	UnmapViewOfFile( myData );
+	CloseHandle( (HANDLE)myMapping );
+	CloseHandle( (HANDLE)myFile );
+#else
+	munmap( (void*)myData, mySize );
+#endif
+
+	myData = NULL;
+	mySize = 0;
+	myFile = NULL;
+	myMapping = NULL;
+}
+
+//=============================================================================
+
+} // end o namespace ceng
@@ -0,0 +1,71 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CMemoryMappedFile
+// =================
+//
+// Read only view of a whole file. On Windows it's MapViewOfFile, elsewhere
+// mmap. The data stays valid until Close() or the destructor, so anything
+// that should outlive the file has to be copied out.
+//
+//.............................................................................
+//=============================================================================
+#ifndef INC_CMEMORYMAPPEDFILE_H
+#define INC_CMEMORYMAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+namespace ceng {
+
+class CMemoryMappedFile
+{
+public:
+	CMemoryMappedFile();
+	~CMemoryMappedFile();
+
+	//! returns false if the file doesn't exist, is empty or can't be mapped
+	bool Open( const std::string& filename );
+	void Close();
+
+	bool		IsOpen() const	{ return myData != NULL; }
+	const char*	GetData() const { return myData; }
+	std::size_t	GetSize() const { return mySize; }
+
+private:
+	const char*	myData;
+	std::size_t	mySize;
+
+	// the windows file and mapping handles
+	void*		myFile;
+	void*		myMapping;
+
+	// can't be copied
+	CMemoryMappedFile( const CMemoryMappedFile& );
+	CMemoryMappedFile& operator=( const CMemoryMappedFile& );
+};
+
+} // end o namespace ceng
+
+#endif
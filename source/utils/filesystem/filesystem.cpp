@@ -29,6 +29,9 @@
 #include <fcntl.h>
 #endif
 
+#include <sys/types.h>
+#include <sys/stat.h>
+
 
 #include <algorithm>
 #include <fstream>
@@ -83,6 +86,21 @@ bool DoesExist( const std::string& filename )
 	return true;
 }
 
+unsigned int GetFileModificationTime( const std::string& filename )
+{
+	#ifdef CENG_PLATFORM_WINDOWS
+		struct _stat st;
+		if( _stat( filename.c_str(), &st ) != 0 )
+			return 0;
+	#else
+		struct stat st;
+		if( stat( filename.c_str(), &st ) != 0 )
+			return 0;
+	#endif
+
+	return (unsigned int)st.st_mtime;
+}
+
 std::string GetDateForFile( const std::string& filename )
 {
 	std::string result;
@@ -13,6 +13,9 @@ namespace ceng
 	std::string GetDateForFile( const std::string& file );
 	bool		DoesExist( const std::string& file );
 
+	// seconds since epoch of the last write, 0 if the file doesn't exist
+	unsigned int GetFileModificationTime( const std::string& file );
+
 	long ReadFileSize( std::fstream& file );
 	long ReadFileSize( const std::string& file );
 
@@ -136,6 +136,9 @@ public:
 
 	bool operator!=( const CFunctionPtr& other ) const { return !operator==(other);	}
 
+	//! the object the method is called on, NULL if there isn't one
+	void* GetPointer() const { return myFunc ? myFunc->GetPointer() : NULL; }
+
 	ReturnValue operator()() { return AnyCast< ReturnValue >( myFunc->Call() ); }
 	
 	template< class Arg1 >
@@ -0,0 +1,457 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CFlatHashMap
+// ============
+//
+// Open addressing hash map with robin hood probing and backward shift
+// deletion. All the key/value pairs live in one flat array, so a lookup is
+// usually one or two cache lines instead of the pointer chase of std::map.
+//
+// The table grows to the next power of two at 7/8 load. Insert and Erase
+// move elements around, so iterators, pointers and references into the map
+// are invalidated by them.
+//
+// CHash< T > has specializations for the integer types, pointers and
+// std::string. For other key types give your own hash functor.
+//
+//.............................................................................
+//=============================================================================
+#ifndef INC_CFLATHASHMAP_H
+#define INC_CFLATHASHMAP_H
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+
+#include "../debug.h"
+
+namespace ceng {
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace impl {
+
+	//! FNV-1a over a block of memory
+	inline unsigned int HashBytes( const char* data, unsigned int length )
+	{
+		unsigned int result = 2166136261u;
+		for( unsigned int i = 0; i < length; ++i )
+		{
+			result ^= (unsigned char)data[ i ];
+			result *= 16777619u;
+		}
+		return result;
+	}
+
+	//! murmur3 finalizer, spreads integer keys over the whole range
+	inline unsigned int HashInteger( unsigned int x )
+	{
+		x ^= x >> 16;
+		x *= 0x85ebca6bu;
+		x ^= x >> 13;
+		x *= 0xc2b2ae35u;
+		x ^= x >> 16;
+		return x;
+	}
+
+} // end of namespace impl
+
+//-----------------------------------------------------------------------------
+
+//! No generic hash on purpose, give one for your own types
+template< class T > struct CHash;
+
+template< class T >
+struct CHash< T* >
+{
+	unsigned int operator()( const T* p ) const
+	{
+		const size_t address = (size_t)p;
+		return impl::HashInteger( (unsigned int)( address ^ ( address >> 16 >> 16 ) ) );
+	}
+};
+
+template<> struct CHash< std::string >
+{
+	unsigned int operator()( const std::string& s ) const { return impl::HashBytes( s.c_str(), (unsigned int)s.size() ); }
+};
+
+#define CENG_FLATHASH_INTEGER( type ) \
+	template<> struct CHash< type > \
+	{ unsigned int operator()( type x ) const { return impl::HashInteger( (unsigned int)x ); } };
+
+CENG_FLATHASH_INTEGER( char )
+CENG_FLATHASH_INTEGER( signed char )
+CENG_FLATHASH_INTEGER( unsigned char )
+CENG_FLATHASH_INTEGER( short )
+CENG_FLATHASH_INTEGER( unsigned short )
+CENG_FLATHASH_INTEGER( int )
+CENG_FLATHASH_INTEGER( unsigned int )
+CENG_FLATHASH_INTEGER( long )
+CENG_FLATHASH_INTEGER( unsigned long )
+
+#undef CENG_FLATHASH_INTEGER
+
+template< class T >
+struct CEqualTo
+{
+	bool operator()( const T& a, const T& b ) const { return a == b; }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+template< class Key, class Value, class Hash = CHash< Key >, class Equal = CEqualTo< Key > >
+class CFlatHashMap
+{
+public:
+	typedef std::pair< Key, Value > Pair;
+
+	CFlatHashMap() : mySlots(), mySize( 0 ), myMask( 0 ) { }
+	~CFlatHashMap() { }
+
+private:
+	struct Slot
+	{
+		Slot() : hash( 0 ), data() { }
+
+		// 0 means an empty slot, the top bit is always set on used ones
+		unsigned int	hash;
+		Pair			data;
+	};
+
+public:
+
+	//-------------------------------------------------------------------------
+
+	class Iterator
+	{
+	public:
+		Iterator() : mySlot( NULL ), myEnd( NULL ) { }
+
+		Pair& operator*() const		{ return mySlot->data; }
+		Pair* operator->() const	{ return &mySlot->data; }
+
+		Iterator& operator++()		{ ++mySlot; SkipEmpty(); return *this; }
+		Iterator operator++( int )	{ Iterator result( *this ); ++( *this ); return result; }
+
+		bool operator==( const Iterator& other ) const { return mySlot == other.mySlot; }
+		bool operator!=( const Iterator& other ) const { return mySlot != other.mySlot; }
+
+	private:
+		Iterator( Slot* slot, Slot* end ) : mySlot( slot ), myEnd( end ) { SkipEmpty(); }
+		void SkipEmpty() { while( mySlot != myEnd && mySlot->hash == 0 ) ++mySlot; }
+
+		Slot* mySlot;
+		Slot* myEnd;
+
+		friend class CFlatHashMap;
+	};
+
+	class ConstIterator
+	{
+	public:
+		ConstIterator() : mySlot( NULL ), myEnd( NULL ) { }
+		ConstIterator( const Iterator& other ) : mySlot( other.mySlot ), myEnd( other.myEnd ) { }
+
+		const Pair& operator*() const	{ return mySlot->data; }
+		const Pair* operator->() const	{ return &mySlot->data; }
+
+		ConstIterator& operator++()		{ ++mySlot; SkipEmpty(); return *this; }
+		ConstIterator operator++( int )	{ ConstIterator result( *this ); ++( *this ); return result; }
+
+		bool operator==( const ConstIterator& other ) const { return mySlot == other.mySlot; }
+		bool operator!=( const ConstIterator& other ) const { return mySlot != other.mySlot; }
+
+	private:
+		ConstIterator( const Slot* slot, const Slot* end ) : mySlot( slot ), myEnd( end ) { SkipEmpty(); }
+		void SkipEmpty() { while( mySlot != myEnd && mySlot->hash == 0 ) ++mySlot; }
+
+		const Slot* mySlot;
+		const Slot* myEnd;
+
+		friend class CFlatHashMap;
+	};
+
+	friend class Iterator;
+	friend class ConstIterator;
+
+	//-------------------------------------------------------------------------
+
+	Iterator Begin()
+	{
+		if( mySlots.empty() ) return Iterator();
+		return Iterator( &mySlots[ 0 ], &mySlots[ 0 ] + mySlots.size() );
+	}
+
+	Iterator End()
+	{
+		if( mySlots.empty() ) return Iterator();
+		return Iterator( &mySlots[ 0 ] + mySlots.size(), &mySlots[ 0 ] + mySlots.size() );
+	}
+
+	ConstIterator Begin() const
+	{
+		if( mySlots.empty() ) return ConstIterator();
+		return ConstIterator( &mySlots[ 0 ], &mySlots[ 0 ] + mySlots.size() );
+	}
+
+	ConstIterator End() const
+	{
+		if( mySlots.empty() ) return ConstIterator();
+		return ConstIterator( &mySlots[ 0 ] + mySlots.size(), &mySlots[ 0 ] + mySlots.size() );
+	}
+
+	//-------------------------------------------------------------------------
+
+	unsigned int	Size() const		{ return mySize; }
+	unsigned int	Capacity() const	{ return (unsigned int)mySlots.size(); }
+	bool			Empty() const		{ return mySize == 0; }
+
+	void Clear()
+	{
+		std::vector< Slot > empty;
+		mySlots.swap( empty );
+		mySize = 0;
+		myMask = 0;
+	}
+
+	//! makes sure count elements fit in without a rehash
+	void Reserve( unsigned int count )
+	{
+		unsigned int capacity = 8;
+		while( capacity * 7 < count * 8 )
+			capacity *= 2;
+
+		if( capacity > mySlots.size() )
+			Rehash( capacity );
+	}
+
+	//-------------------------------------------------------------------------
+
+	Iterator Find( const Key& key )
+	{
+		const int pos = FindSlot( key );
+		if( pos < 0 ) return End();
+		return Iterator( &mySlots[ pos ], &mySlots[ 0 ] + mySlots.size() );
+	}
+
+	ConstIterator Find( const Key& key ) const
+	{
+		const int pos = FindSlot( key );
+		if( pos < 0 ) return End();
+		return ConstIterator( &mySlots[ pos ], &mySlots[ 0 ] + mySlots.size() );
+	}
+
+	//! returns NULL if the key isn't in the map
+	Value* FindValue( const Key& key )
+	{
+		const int pos = FindSlot( key );
+		return ( pos < 0 ) ? NULL : &mySlots[ pos ].data.second;
+	}
+
+	const Value* FindValue( const Key& key ) const
+	{
+		const int pos = FindSlot( key );
+		return ( pos < 0 ) ? NULL : &mySlots[ pos ].data.second;
+	}
+
+	bool HasKey( const Key& key ) const
+	{
+		return FindSlot( key ) >= 0;
+	}
+
+	//! Works like the std::map::operator[], inserts a default value if needed
+	Value& operator[]( const Key& key )
+	{
+		const unsigned int hash = HashOf( key );
+		const int pos = FindSlot( key, hash );
+		if( pos >= 0 )
+			return mySlots[ pos ].data.second;
+
+		return mySlots[ InsertNew( key, Value(), hash ) ].data.second;
+	}
+
+	//! returns false and doesn't touch the old value if the key was there
+	bool Insert( const Key& key, const Value& value )
+	{
+		const unsigned int hash = HashOf( key );
+		if( FindSlot( key, hash ) >= 0 )
+			return false;
+
+		InsertNew( key, value, hash );
+		return true;
+	}
+
+	bool Erase( const Key& key )
+	{
+		const int pos = FindSlot( key );
+		if( pos < 0 )
+			return false;
+
+		EraseSlot( (unsigned int)pos );
+		return true;
+	}
+
+	//-------------------------------------------------------------------------
+
+private:
+
+	static unsigned int HashOf( const Key& key )
+	{
+		return Hash()( key ) | 0x80000000u;
+	}
+
+	unsigned int Distance( unsigned int hash, unsigned int pos ) const
+	{
+		return ( pos - ( hash & myMask ) ) & myMask;
+	}
+
+	static void SwapSlots( Slot& a, Slot& b )
+	{
+		using std::swap;
+		swap( a.hash, b.hash );
+		swap( a.data.first, b.data.first );
+		swap( a.data.second, b.data.second );
+	}
+
+	int FindSlot( const Key& key ) const
+	{
+		if( mySize == 0 )
+			return -1;
+
+		return FindSlot( key, HashOf( key ) );
+	}
+
+	int FindSlot( const Key& key, unsigned int hash ) const
+	{
+		if( mySize == 0 )
+			return -1;
+
+		unsigned int pos = hash & myMask;
+		for( unsigned int dist = 0; ; ++dist )
+		{
+			const Slot& slot = mySlots[ pos ];
+
+			// robin hood invariant: we would have been placed before this one
+			if( slot.hash == 0 || Distance( slot.hash, pos ) < dist )
+				return -1;
+
+			if( slot.hash == hash && Equal()( slot.data.first, key ) )
+				return (int)pos;
+
+			pos = ( pos + 1 ) & myMask;
+		}
+	}
+
+	unsigned int InsertNew( const Key& key, const Value& value, unsigned int hash )
+	{
+		if( ( mySize + 1 ) * 8 > mySlots.size() * 7 )
+			Rehash( mySlots.empty() ? 8 : (unsigned int)mySlots.size() * 2 );
+
+		Slot carry;
+		carry.hash = hash;
+		carry.data.first = key;
+		carry.data.second = value;
+		return InsertSlot( carry );
+	}
+
+	// swaps the contents of carry into the table, returns the position where
+	// the original carry ended up
+	unsigned int InsertSlot( Slot& carry )
+	{
+		unsigned int result = 0;
+		bool placed = false;
+		unsigned int pos = carry.hash & myMask;
+		unsigned int dist = 0;
+
+		for( ;; )
+		{
+			Slot& slot = mySlots[ pos ];
+			if( slot.hash == 0 )
+			{
+				SwapSlots( slot, carry );
+				++mySize;
+				return placed ? result : pos;
+			}
+
+			const unsigned int slot_dist = Distance( slot.hash, pos );
+			if( slot_dist < dist )
+			{
+				// take from the rich, the evicted one continues the search
+				SwapSlots( slot, carry );
+				if( !placed )
+				{
+					placed = true;
+					result = pos;
+				}
+				dist = slot_dist;
+			}
+
+			pos = ( pos + 1 ) & myMask;
+			++dist;
+		}
+	}
+
+	void EraseSlot( unsigned int pos )
+	{
+		unsigned int next = ( pos + 1 ) & myMask;
+		while( mySlots[ next ].hash != 0 && Distance( mySlots[ next ].hash, next ) != 0 )
+		{
+			SwapSlots( mySlots[ pos ], mySlots[ next ] );
+			pos = next;
+			next = ( next + 1 ) & myMask;
+		}
+
+		mySlots[ pos ] = Slot();
+		--mySize;
+	}
+
+	void Rehash( unsigned int capacity )
+	{
+		cassert( ( capacity & ( capacity - 1 ) ) == 0 );
+
+		std::vector< Slot > old;
+		old.swap( mySlots );
+		mySlots.resize( capacity );
+		myMask = capacity - 1;
+		mySize = 0;
+
+		for( unsigned int i = 0; i < old.size(); ++i )
+		{
+			if( old[ i ].hash != 0 )
+				InsertSlot( old[ i ] );
+		}
+	}
+
+	std::vector< Slot >	mySlots;
+	unsigned int		mySize;
+	unsigned int		myMask;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // end of namespace ceng
+
+#endif
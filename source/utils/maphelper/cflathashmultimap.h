@@ -0,0 +1,243 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CFlatHashMultiMap
+// =================
+//
+// A CFlatHashMap that holds a CSmallVector of values under each key. The
+// first N values of a key are stored inline in the table.
+//
+// With REVERSE_INDEX set the map also keeps a value -> keys table, so
+// RemoveValue() doesn't have to walk every key. The index is only kept up to
+// date by the methods of this class, so don't modify the lists returned by
+// Get() or Find() yourself when it's on. The values need a CHash for it.
+//
+//.............................................................................
+//=============================================================================
+#ifndef INC_CFLATHASHMULTIMAP_H
+#define INC_CFLATHASHMULTIMAP_H
+
+#include "cflathashmap.h"
+#include "csmallvector.h"
+
+namespace ceng {
+
+namespace impl {
+
+//! the disabled reverse index, does nothing
+template< class Key, class Value, class ValueHash, bool ENABLED >
+class CFlatHashReverseIndex
+{
+public:
+	void Add( const Key& /*key*/, const Value& /*value*/ ) { }
+	void Remove( const Key& /*key*/, const Value& /*value*/, unsigned int /*count*/ ) { }
+	void Clear() { }
+	bool Enabled() const { return false; }
+	const CSmallVector< Key, 1 >* GetKeys( const Value& /*value*/ ) const { return NULL; }
+	void RemoveValue( const Value& /*value*/ ) { }
+};
+
+template< class Key, class Value, class ValueHash >
+class CFlatHashReverseIndex< Key, Value, ValueHash, true >
+{
+public:
+	void Add( const Key& key, const Value& value )
+	{
+		myIndex[ value ].push_back( key );
+	}
+
+	void Remove( const Key& key, const Value& value, unsigned int count )
+	{
+		CSmallVector< Key, 1 >* keys = myIndex.FindValue( value );
+		cassert( keys );
+		if( keys == NULL )
+			return;
+
+		for( unsigned int i = 0; i < count; ++i )
+			keys->remove_one_unordered( key );
+
+		if( keys->empty() )
+			myIndex.Erase( value );
+	}
+
+	void Clear() { myIndex.Clear(); }
+	bool Enabled() const { return true; }
+
+	const CSmallVector< Key, 1 >* GetKeys( const Value& value ) const
+	{
+		return myIndex.FindValue( value );
+	}
+
+	void RemoveValue( const Value& value ) { myIndex.Erase( value ); }
+
+private:
+	CFlatHashMap< Value, CSmallVector< Key, 1 >, ValueHash > myIndex;
+};
+
+} // end of namespace impl
+
+///////////////////////////////////////////////////////////////////////////////
+
+template< class Key,
+	class Value,
+	int N = 4,
+	bool REVERSE_INDEX = false,
+	class Hash = CHash< Key >,
+	class Equal = CEqualTo< Key >,
+	class ValueHash = CHash< Value > >
+class CFlatHashMultiMap
+{
+public:
+	typedef CSmallVector< Value, N >					List;
+	typedef CFlatHashMap< Key, List, Hash, Equal >		Map;
+	typedef typename Map::Iterator						Iterator;
+	typedef typename Map::ConstIterator					ConstIterator;
+
+	CFlatHashMultiMap() { }
+	~CFlatHashMultiMap() { }
+
+	Iterator		Begin()			{ return myMap.Begin(); }
+	Iterator		End()			{ return myMap.End(); }
+	ConstIterator	Begin() const	{ return myMap.Begin(); }
+	ConstIterator	End() const		{ return myMap.End(); }
+
+	//! number of keys
+	unsigned int	Size() const	{ return myMap.Size(); }
+	bool			Empty() const	{ return myMap.Empty(); }
+
+	void Clear()
+	{
+		myMap.Clear();
+		myReverse.Clear();
+	}
+
+	void Reserve( unsigned int key_count ) { myMap.Reserve( key_count ); }
+
+	//-------------------------------------------------------------------------
+
+	//! returns NULL if there's nothing under the key
+	List*		Find( const Key& key )			{ return myMap.FindValue( key ); }
+	const List*	Find( const Key& key ) const	{ return myMap.FindValue( key ); }
+
+	bool HasKey( const Key& key ) const { return myMap.HasKey( key ); }
+
+	//! creates an empty list for the key if it isn't there
+	List& Get( const Key& key ) { return myMap[ key ]; }
+
+	void Insert( const Key& key, const Value& value )
+	{
+		myMap[ key ].push_back( value );
+		myReverse.Add( key, value );
+	}
+
+	//-------------------------------------------------------------------------
+
+	//! removes the key and all the values under it
+	bool Remove( const Key& key )
+	{
+		if( myReverse.Enabled() )
+		{
+			List* list = myMap.FindValue( key );
+			if( list == NULL )
+				return false;
+
+			for( typename List::iterator i = list->begin(); i != list->end(); ++i )
+				myReverse.Remove( key, *i, 1 );
+		}
+
+		return myMap.Erase( key );
+	}
+
+	//! removes every copy of value under key, and the key if it goes empty.
+	//! Returns the number of values removed
+	unsigned int Remove( const Key& key, const Value& value )
+	{
+		List* list = myMap.FindValue( key );
+		if( list == NULL )
+			return 0;
+
+		const unsigned int removed = list->remove( value );
+		if( removed )
+			myReverse.Remove( key, value, removed );
+
+		if( list->empty() )
+			myMap.Erase( key );
+
+		return removed;
+	}
+
+	//! removes value from under every key. Returns the number of values removed
+	unsigned int RemoveValue( const Value& value )
+	{
+		unsigned int removed = 0;
+
+		if( myReverse.Enabled() )
+		{
+			const CSmallVector< Key, 1 >* keys_ptr = myReverse.GetKeys( value );
+			if( keys_ptr == NULL )
+				return 0;
+
+			// copy because the list can have the same key many times
+			const CSmallVector< Key, 1 > keys( *keys_ptr );
+			myReverse.RemoveValue( value );
+
+			for( unsigned int i = 0; i < keys.size(); ++i )
+			{
+				List* list = myMap.FindValue( keys[ i ] );
+				if( list == NULL )
+					continue;
+
+				removed += list->remove( value );
+				if( list->empty() )
+					myMap.Erase( keys[ i ] );
+			}
+
+			return removed;
+		}
+
+		// no index, have to go through everything. The erase shuffles the
+		// table so the empty keys are collected first
+		std::vector< Key > empty_keys;
+		for( Iterator i = myMap.Begin(); i != myMap.End(); ++i )
+		{
+			removed += i->second.remove( value );
+			if( i->second.empty() )
+				empty_keys.push_back( i->first );
+		}
+
+		for( unsigned int i = 0; i < empty_keys.size(); ++i )
+			myMap.Erase( empty_keys[ i ] );
+
+		return removed;
+	}
+
+private:
+	Map myMap;
+	impl::CFlatHashReverseIndex< Key, Value, ValueHash, REVERSE_INDEX > myReverse;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // end of namespace ceng
+
+#endif
@@ -76,30 +76,64 @@ int main()
 #ifndef INC_CMAPHELPER_H
 #define INC_CMAPHELPER_H
 
-#include <map>
-#include <list>
+#include <functional>
 
 #include "../debug.h"
+#include "cflathashmultimap.h"
 
 namespace ceng {
 
+//! Turns the ordering predicate of CMapHelper into an equality test for the
+//! hash table. Only called when the hashes already match.
+template< class T, class PR >
+struct CMapHelperEquivalent
+{
+	bool operator()( const T& a, const T& b ) const
+	{
+		PR pr;
+		return !pr( a, b ) && !pr( b, a );
+	}
+};
+
+//! The keys are found by CHash< T >, so the keys PR says are equivalent must
+//! hash the same. That holds for std::less, any other predicate has to say
+//! so by specializing this, otherwise CMapHelper doesn't compile.
+template< class T, class PR >
+struct CMapHelperHashAgrees;
+
+template< class T >
+struct CMapHelperHashAgrees< T, std::less< T > > { };
+
 //! This is a map that can contain multiple elements under one key
-template < class T1, class T2, class PR = std::less< T1 > >
+/*!
+	Implemented on top of CFlatHashMultiMap, so the keys need a CHash and the
+	iteration order is no longer sorted. Lists returned by Get() are moved
+	when new keys are inserted, so don't hold on to them over an Insert().
+
+	REVERSE_INDEX keeps a value -> key index that makes RemoveSecond() cheap.
+	When it's on, the lists from Get() must not be modified directly.
+*/
+template < class T1, class T2, class PR = std::less< T1 >, bool REVERSE_INDEX = false >
 class CMapHelper
 {
 public:
 
-	typedef typename std::map<  T1, std::list< T2 >, PR >::iterator	Iterator;
-	typedef std::list< T2 >											List;
-	typedef typename std::list< T2 >::iterator						ListIterator;
+	typedef CFlatHashMultiMap< T1, T2, 4, REVERSE_INDEX, CHash< T1 >, CMapHelperEquivalent< T1, PR > > Container;
+
+	// see CMapHelperHashAgrees
+	typedef char PredicateCheck[ sizeof( CMapHelperHashAgrees< T1, PR > ) ];
+
+	typedef typename Container::Iterator	Iterator;
+	typedef typename Container::List		List;
+	typedef typename List::iterator			ListIterator;
 
 	List*			HelperList;
 	ListIterator	i;
 
-	Iterator Begin() { return myMap.begin(); }
-	Iterator End() { return myMap.end(); }
+	Iterator Begin() { return myMap.Begin(); }
+	Iterator End() { return myMap.End(); }
 
-	void Clear() { myMap.clear(); }
+	void Clear() { myMap.Clear(); }
 
 	void HelperGet( const T1& me )
 	{
@@ -107,81 +141,35 @@ public:
 		HelperList = &Get( me );
 	}
 
-	CMapHelper() { }
+	CMapHelper() : HelperList( NULL ), i() { }
 	~CMapHelper() { }
 
 	bool Find( const T1& me )
 	{
-		// if ( myIterator != myMap.end() && myIterator->first == me ) return true;
-
-
-		Iterator myIterator = myMap.find( me );
-
-		return ( myIterator != myMap.end() );
+		return myMap.HasKey( me );
 	}
 
 
-	std::list< T2 >& Get( const T1& me )
+	List& Get( const T1& me )
 	{
-		// if ( myIterator != myMap.end() && myIterator->first == me ) return myIterator->second;
-
-		return myMap[ me ];
+		return myMap.Get( me );
 	}
 
 	void Insert( const T1& first, const T2& second )
 	{
-
-		if ( myMap.find( first ) != myMap.end() )
-		{
-			myMap[ first ].push_back( second );
-			return;
-		}
-
-		List tmp_list;
-		tmp_list.push_back( second );
-
-		myMap.insert( std::pair< T1, std::list< T2 > >( first, tmp_list ) );
-
+		myMap.Insert( first, second );
 	}
 
 	void RemoveFirst( const T1& me )
 	{
-		myMap.erase( me );
+		myMap.Remove( me );
 	}
 
 	void RemoveSecond( const T2& me )
 	{
-		typename std::map< T1, std::list< T2 >, PR >::iterator i = myMap.begin();
-
-		while( i != myMap.end() )
-		{
-			ListIterator j = i->second.begin();
-			while( j != i->second.end() )
-			{
-				if( (*j) == me )
-				{
-					ListIterator remove = j;
-					++j;
-					i->second.erase( remove );
-				}
-				else
-				{
-					++j;
-				}
-			}
-
-			if( i->second.empty() )
-			{
-				typename std::map< T1, std::list< T2 >, PR >::iterator remove = i;
-				++i;
-				myMap.erase( remove );
-			}
-			else
-			{
-				++i;
-			}
-		}
+		myMap.RemoveValue( me );
 	}
+
 	void Remove( const T1& me )
 	{
 		RemoveFirst( me );
@@ -189,56 +177,17 @@ public:
 
 	void Remove( const T1& first, const T2& second )
 	{
-		typename std::map< T1, std::list< T2 >, PR >::iterator i;
-
-		i = myMap.find( first );
-		if ( i == myMap.end() ) return;
-
-		ListIterator j = i->second.begin();
-		int safty_count = 0;
-		while( j != i->second.end() && safty_count < 10000 )
-		{
-			if( (*j) == second )
-			{
-				ListIterator remove = j;
-				++j;
-				i->second.erase( remove );
-			}
-			else
-			{
-				++j;
-			}
-
-			safty_count++;
-		}
-
-		cassert( safty_count < 10000 );
-
-		/*
-		for ( j = i->second.begin(); j != i->second.end(); ++j )
-		{
-			if ( (*j) == second )
-			{
-				j = i->second.erase( j );
-			}
-		}
-		*/
-		if( i->second.empty() )
-		{
-			myMap.erase( i );
-		}
+		myMap.Remove( first, second );
 	}
 
 	bool Empty() const
 	{
-		return myMap.empty();
+		return myMap.Empty();
 	}
 
 
 private:
-	std::map< T1, std::list< T2 >, PR >						myMap;
-	//typename std::map< T1, std::list< T2 >, PR >::iterator	myIterator;
-	typename std::list< T2 >::iterator						myListIterator;
+	Container myMap;
 
 };
 
@@ -252,4 +201,3 @@ private:
 }
 
 #endif
-
@@ -0,0 +1,290 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CSmallVector
+// ============
+//
+// A vector that stores the first N elements inside itself and only goes to
+// the heap when it grows past that. Used as the value list of the flat hash
+// containers, where almost every key has only one or two values.
+//
+// The interface mimics the parts of std::list that CMapHelper users touch
+// (begin, end, push_back, erase, remove, empty...) so it can be used as a
+// drop-in List type. Unlike std::list, push_back and erase invalidate
+// iterators.
+//
+//.............................................................................
+//=============================================================================
+#ifndef INC_CSMALLVECTOR_H
+#define INC_CSMALLVECTOR_H
+
+#include <new>
+#include <algorithm>
+#include "../debug.h"
+
+namespace ceng {
+
+template< class T, int N >
+class CSmallVector
+{
+public:
+	typedef T				value_type;
+	typedef T*				iterator;
+	typedef const T*		const_iterator;
+	typedef unsigned int	size_type;
+
+	CSmallVector() :
+		myData( InlineData() ),
+		mySize( 0 ),
+		myCapacity( N )
+	{
+	}
+
+	CSmallVector( const CSmallVector< T, N >& other ) :
+		myData( InlineData() ),
+		mySize( 0 ),
+		myCapacity( N )
+	{
+		reserve( other.mySize );
+		for( size_type i = 0; i < other.mySize; ++i )
+			new( myData + i ) T( other.myData[ i ] );
+		mySize = other.mySize;
+	}
+
+	~CSmallVector()
+	{
+		clear();
+		FreeHeap();
+	}
+
+	CSmallVector& operator=( const CSmallVector< T, N >& other )
+	{
+		if( this == &other )
+			return *this;
+
+		clear();
+		reserve( other.mySize );
+		for( size_type i = 0; i < other.mySize; ++i )
+			new( myData + i ) T( other.myData[ i ] );
+		mySize = other.mySize;
+
+		return *this;
+	}
+
+	//-------------------------------------------------------------------------
+
+	iterator		begin()			{ return myData; }
+	iterator		end()			{ return myData + mySize; }
+	const_iterator	begin() const	{ return myData; }
+	const_iterator	end() const		{ return myData + mySize; }
+
+	size_type	size() const		{ return mySize; }
+	size_type	capacity() const	{ return myCapacity; }
+	bool		empty() const		{ return mySize == 0; }
+
+	T&			operator[]( size_type i )		{ cassert( i < mySize ); return myData[ i ]; }
+	const T&	operator[]( size_type i ) const	{ cassert( i < mySize ); return myData[ i ]; }
+
+	T&			front()			{ cassert( mySize ); return myData[ 0 ]; }
+	const T&	front() const	{ cassert( mySize ); return myData[ 0 ]; }
+	T&			back()			{ cassert( mySize ); return myData[ mySize - 1 ]; }
+	const T&	back() const	{ cassert( mySize ); return myData[ mySize - 1 ]; }
+
+	//-------------------------------------------------------------------------
+
+	void push_back( const T& value )
+	{
+		if( mySize == myCapacity )
+		{
+			// value might live inside us, copy it before we reallocate
+			T tmp( value );
+			reserve( myCapacity * 2 );
+			new( myData + mySize ) T( tmp );
+		}
+		else
+		{
+			new( myData + mySize ) T( value );
+		}
+		++mySize;
+	}
+
+	void pop_back()
+	{
+		cassert( mySize );
+		--mySize;
+		myData[ mySize ].~T();
+	}
+
+	//! keeps the order of the remaining elements, returns the next element
+	iterator erase( iterator where )
+	{
+		cassert( where >= begin() && where < end() );
+		for( iterator i = where; i + 1 != end(); ++i )
+			*i = *( i + 1 );
+
+		pop_back();
+		return where;
+	}
+
+	//! removes all the elements equal to value, returns how many went
+	size_type remove( const T& value )
+	{
+		size_type write = 0;
+		for( size_type read = 0; read < mySize; ++read )
+		{
+			if( myData[ read ] == value )
+				continue;
+
+			if( write != read )
+				myData[ write ] = myData[ read ];
+			++write;
+		}
+
+		const size_type removed = mySize - write;
+		while( mySize > write )
+			pop_back();
+
+		return removed;
+	}
+
+	//! removes the first element equal to value, doesn't keep the order
+	bool remove_one_unordered( const T& value )
+	{
+		for( size_type i = 0; i < mySize; ++i )
+		{
+			if( myData[ i ] == value )
+			{
+				if( i + 1 != mySize )
+					myData[ i ] = myData[ mySize - 1 ];
+				pop_back();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void clear()
+	{
+		while( mySize )
+			pop_back();
+	}
+
+	void reserve( size_type count )
+	{
+		if( count <= myCapacity )
+			return;
+
+		T* data = static_cast< T* >( ::operator new( sizeof( T ) * count ) );
+		for( size_type i = 0; i < mySize; ++i )
+		{
+			new( data + i ) T( myData[ i ] );
+			myData[ i ].~T();
+		}
+
+		FreeHeap();
+		myData = data;
+		myCapacity = count;
+	}
+
+	void swap( CSmallVector< T, N >& other )
+	{
+		// only heap buffers can be swapped by pointer, inline ones are swapped
+		// element by element and the extra ones moved over
+		if( IsInline() || other.IsInline() )
+		{
+			CSmallVector< T, N >& bigger = ( mySize >= other.mySize ) ? *this : other;
+			CSmallVector< T, N >& smaller = ( mySize >= other.mySize ) ? other : *this;
+			const size_type common = smaller.mySize;
+
+			using std::swap;
+			for( size_type i = 0; i < common; ++i )
+				swap( myData[ i ], other.myData[ i ] );
+
+			smaller.reserve( bigger.mySize );
+			for( size_type i = common; i < bigger.mySize; ++i )
+				smaller.push_back( bigger.myData[ i ] );
+
+			while( bigger.mySize > common )
+				bigger.pop_back();
+			return;
+		}
+
+		T* data = myData;
+		myData = other.myData;
+		other.myData = data;
+
+		size_type size = mySize;
+		mySize = other.mySize;
+		other.mySize = size;
+
+		size_type capacity = myCapacity;
+		myCapacity = other.myCapacity;
+		other.myCapacity = capacity;
+	}
+
+	bool operator==( const CSmallVector< T, N >& other ) const
+	{
+		if( mySize != other.mySize )
+			return false;
+
+		for( size_type i = 0; i < mySize; ++i )
+		{
+			if( !( myData[ i ] == other.myData[ i ] ) )
+				return false;
+		}
+		return true;
+	}
+
+	bool operator!=( const CSmallVector< T, N >& other ) const { return !operator==( other ); }
+
+private:
+	T*		InlineData()		{ return reinterpret_cast< T* >( myInline.buffer ); }
+	bool	IsInline() const	{ return myData == reinterpret_cast< const T* >( myInline.buffer ); }
+
+	void FreeHeap()
+	{
+		if( !IsInline() )
+			::operator delete( myData );
+	}
+
+	T*			myData;
+	size_type	mySize;
+	size_type	myCapacity;
+
+	union
+	{
+		char	buffer[ sizeof( T ) * N ];
+		double	align_double;
+		void*	align_pointer;
+	} myInline;
+};
+
+template< class T, int N >
+inline void swap( CSmallVector< T, N >& a, CSmallVector< T, N >& b )
+{
+	a.swap( b );
+}
+
+} // end of namespace ceng
+
+#endif
@@ -0,0 +1,226 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+#include <map>
+#include <sstream>
+
+#include "../../debug.h"
+#include "../cflathashmap.h"
+#include "../cflathashmultimap.h"
+#include "../../xml/cmultikeyvector.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace ceng {
+namespace test {
+
+namespace {
+	std::string FlatHashTestName( int i )
+	{
+		std::stringstream ss;
+		ss << "name_" << i;
+		return ss.str();
+	}
+}
+
+int CFlatHashMapTest()
+{
+	// basic insert, find and erase
+	{
+		CFlatHashMap< int, int > test;
+		test_assert( test.Empty() );
+		test_assert( test.Find( 1 ) == test.End() );
+		test_assert( test.FindValue( 1 ) == NULL );
+		test_assert( test.Begin() == test.End() );
+
+		test_assert( test.Insert( 1, 10 ) );
+		test_assert( test.Insert( 2, 20 ) );
+		test_assert( test.Insert( 1, 30 ) == false );
+
+		test_assert( test.Size() == 2 );
+		test_assert( test.Find( 1 )->second == 10 );
+		test_assert( *test.FindValue( 2 ) == 20 );
+		test_assert( test.HasKey( 3 ) == false );
+
+		test[ 3 ] = 30;
+		test_assert( test.Size() == 3 );
+		test_assert( test[ 3 ] == 30 );
+
+		test_assert( test.Erase( 2 ) );
+		test_assert( test.Erase( 2 ) == false );
+		test_assert( test.HasKey( 2 ) == false );
+		test_assert( test.HasKey( 1 ) );
+		test_assert( test.HasKey( 3 ) );
+
+		test.Clear();
+		test_assert( test.Empty() );
+		test_assert( test.HasKey( 1 ) == false );
+	}
+
+	// growing and erasing lots of things, compared against std::map
+	{
+		CFlatHashMap< std::string, int > test;
+		std::map< std::string, int > reference;
+
+		for( int i = 0; i < 2000; ++i )
+		{
+			test.Insert( FlatHashTestName( i ), i );
+			reference[ FlatHashTestName( i ) ] = i;
+		}
+
+		for( int i = 0; i < 2000; i += 3 )
+		{
+			test_assert( test.Erase( FlatHashTestName( i ) ) );
+			reference.erase( FlatHashTestName( i ) );
+		}
+
+		test_assert( test.Size() == reference.size() );
+
+		for( int i = 0; i < 2000; ++i )
+		{
+			const int* value = test.FindValue( FlatHashTestName( i ) );
+			if( i % 3 == 0 )
+			{
+				test_assert( value == NULL );
+			}
+			else
+			{
+				test_assert( value && *value == i );
+			}
+		}
+
+		int count = 0;
+		for( CFlatHashMap< std::string, int >::Iterator i = test.Begin(); i != test.End(); ++i )
+		{
+			test_assert( reference[ i->first ] == i->second );
+			++count;
+		}
+		test_assert( count == (int)reference.size() );
+	}
+
+	// pointers as keys
+	{
+		int a, b, c;
+		CFlatHashMap< int*, int > test;
+		test.Insert( &a, 1 );
+		test.Insert( &b, 2 );
+		test_assert( test.HasKey( &a ) );
+		test_assert( test.HasKey( &b ) );
+		test_assert( test.HasKey( &c ) == false );
+	}
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int CFlatHashMultiMapTest()
+{
+	// small vector going over the inline size
+	{
+		CSmallVector< int, 2 > test;
+		for( int i = 0; i < 10; ++i )
+			test.push_back( i );
+
+		test_assert( test.size() == 10 );
+		test_assert( test[ 9 ] == 9 );
+
+		CSmallVector< int, 2 > copy( test );
+		test_assert( copy == test );
+
+		test.erase( test.begin() );
+		test_assert( test.front() == 1 );
+		test_assert( test.size() == 9 );
+		test_assert( test.remove( 5 ) == 1 );
+		test_assert( test.size() == 8 );
+		test_assert( copy.size() == 10 );
+	}
+
+	// with the reverse index
+	{
+		CFlatHashMultiMap< int, int, 2, true > test;
+		test.Insert( 1, 100 );
+		test.Insert( 1, 200 );
+		test.Insert( 2, 100 );
+		test.Insert( 3, 100 );
+		test.Insert( 3, 100 );
+		test.Insert( 3, 300 );
+
+		test_assert( test.Size() == 3 );
+		test_assert( test.Find( 3 )->size() == 3 );
+
+		test_assert( test.RemoveValue( 100 ) == 4 );
+		test_assert( test.Size() == 2 );
+		test_assert( test.HasKey( 2 ) == false );
+		test_assert( test.Find( 1 )->size() == 1 );
+		test_assert( test.Find( 3 )->size() == 1 );
+		test_assert( test.RemoveValue( 100 ) == 0 );
+
+		test_assert( test.Remove( 3, 300 ) == 1 );
+		test_assert( test.HasKey( 3 ) == false );
+
+		test.Insert( 4, 200 );
+		test_assert( test.Remove( 1 ) );
+		test_assert( test.RemoveValue( 200 ) == 1 );
+		test_assert( test.Empty() );
+	}
+
+	// the same thing without it
+	{
+		CFlatHashMultiMap< int, int, 2, false > test;
+		test.Insert( 1, 100 );
+		test.Insert( 1, 200 );
+		test.Insert( 2, 100 );
+		test.Insert( 3, 100 );
+		test.Insert( 3, 100 );
+
+		test_assert( test.RemoveValue( 100 ) == 4 );
+		test_assert( test.Size() == 1 );
+		test_assert( test.Find( 1 )->size() == 1 );
+	}
+
+	// multi key vector
+	{
+		CMultiKeyVector< std::string, int > test;
+		test.Insert( "b", 1 );
+		test.Insert( "a", 2 );
+		test.Insert( "b", 3 );
+
+		test_assert( test.Size() == 3 );
+		test_assert( test[ "b" ] == 1 );
+		test_assert( test[ "a" ] == 2 );
+		test_assert( test[ 2u ] == 3 );
+		test_assert( test.GetKey( 1 ) == "a" );
+		test_assert( test.GetKey( 2 ) == "" );
+		test_assert( test.GetKeys().size() == 2 );
+		test_assert( test.GetKeys()[ 0 ] == "a" );
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( CFlatHashMapTest );
+TEST_REGISTER( CFlatHashMultiMapTest );
+
+} // end of namespace test
+} // end of namespace ceng
+
+#endif
@@ -0,0 +1,225 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+#include <map>
+#include <list>
+#include <vector>
+#include <sstream>
+
+#include "../../debug.h"
+#include "../../../tester/tester_benchmark.h"
+#include "../cmaphelper.h"
+#include "../../xml/cmultikeyvector.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace ceng {
+namespace test {
+
+namespace {
+
+	// The std::map based implementations these replaced, kept here to have
+	// something to compare against
+
+	template< class T1, class T2 >
+	struct OldMapHelper
+	{
+		void Insert( const T1& first, const T2& second ) { myMap[ first ].push_back( second ); }
+		bool Find( const T1& me ) { return myMap.find( me ) != myMap.end(); }
+		std::list< T2 >& Get( const T1& me ) { return myMap[ me ]; }
+
+		void RemoveSecond( const T2& me )
+		{
+			typename std::map< T1, std::list< T2 > >::iterator i = myMap.begin();
+			while( i != myMap.end() )
+			{
+				i->second.remove( me );
+				if( i->second.empty() )
+					myMap.erase( i++ );
+				else
+					++i;
+			}
+		}
+
+		std::map< T1, std::list< T2 > > myMap;
+	};
+
+	template< class Key, class Cont >
+	struct OldMultiKeyVector
+	{
+		void Insert( const Key& key, const Cont& data )
+		{
+			myKeys.insert( std::pair< Key, unsigned int >( key, myData.size() ) );
+			myData.push_back( data );
+		}
+
+		Cont& operator[]( const Key& i ) { return myData[ myKeys.find( i )->second ]; }
+		bool HasKey( const Key& key ) const { return myKeys.find( key ) != myKeys.end(); }
+
+		std::vector< Cont >				myData;
+		std::map< Key, unsigned int >	myKeys;
+	};
+
+	std::vector< std::string > BenchmarkNames( int count )
+	{
+		std::vector< std::string > result;
+		for( int i = 0; i < count; ++i )
+		{
+			std::stringstream ss;
+			ss << "event_type_name_" << i;
+			result.push_back( ss.str() );
+		}
+		return result;
+	}
+
+	const int bench_keys = 1000;
+	const int bench_rounds = 200;
+}
+
+//-----------------------------------------------------------------------------
+
+int CMapHelperBenchmark()
+{
+	using poro::tester::CBenchmarkTimer;
+	using poro::tester::BenchmarkReport;
+
+	const std::vector< std::string > names = BenchmarkNames( bench_keys );
+	int checksum = 0;
+
+	test_logger << "CMapHelper vs. std::map< T1, std::list< T2 > >" << std::endl;
+
+	// insert
+	{
+		CBenchmarkTimer timer;
+		for( int r = 0; r < bench_rounds; ++r )
+		{
+			OldMapHelper< std::string, int > old_map;
+			for( int i = 0; i < bench_keys; ++i )
+				old_map.Insert( names[ i ], i );
+			checksum += (int)old_map.myMap.size();
+		}
+		BenchmarkReport( "insert, old", timer.GetSeconds(), bench_keys * bench_rounds );
+
+		timer.Reset();
+		for( int r = 0; r < bench_rounds; ++r )
+		{
+			CMapHelper< std::string, int > new_map;
+			for( int i = 0; i < bench_keys; ++i )
+				new_map.Insert( names[ i ], i );
+			checksum += new_map.Empty() ? 0 : 1;
+		}
+		BenchmarkReport( "insert, new", timer.GetSeconds(), bench_keys * bench_rounds );
+	}
+
+	// lookup
+	{
+		OldMapHelper< std::string, int > old_map;
+		CMapHelper< std::string, int > new_map;
+		for( int i = 0; i < bench_keys; ++i )
+		{
+			old_map.Insert( names[ i ], i );
+			new_map.Insert( names[ i ], i );
+		}
+
+		CBenchmarkTimer timer;
+		for( int r = 0; r < bench_rounds; ++r )
+			for( int i = 0; i < bench_keys; ++i )
+				if( old_map.Find( names[ i ] ) ) checksum += old_map.Get( names[ i ] ).front();
+		BenchmarkReport( "lookup, old", timer.GetSeconds(), bench_keys * bench_rounds );
+
+		timer.Reset();
+		for( int r = 0; r < bench_rounds; ++r )
+			for( int i = 0; i < bench_keys; ++i )
+				if( new_map.Find( names[ i ] ) ) checksum += new_map.Get( names[ i ] ).front();
+		BenchmarkReport( "lookup, new", timer.GetSeconds(), bench_keys * bench_rounds );
+	}
+
+	// RemoveSecond, the old one walks every key
+	{
+		OldMapHelper< int*, int > old_map;
+		CMapHelper< int*, int > new_map;
+		CMapHelper< int*, int, std::less< int* >, true > indexed_map;
+		std::vector< int > storage( bench_keys );
+		for( int i = 0; i < bench_keys; ++i )
+		{
+			old_map.Insert( &storage[ i ], i );
+			new_map.Insert( &storage[ i ], i );
+			indexed_map.Insert( &storage[ i ], i );
+		}
+
+		CBenchmarkTimer timer;
+		for( int i = 0; i < bench_keys; ++i )
+			old_map.RemoveSecond( i );
+		BenchmarkReport( "RemoveSecond, old", timer.GetSeconds(), bench_keys );
+
+		timer.Reset();
+		for( int i = 0; i < bench_keys; ++i )
+			new_map.RemoveSecond( i );
+		BenchmarkReport( "RemoveSecond, new", timer.GetSeconds(), bench_keys );
+
+		timer.Reset();
+		for( int i = 0; i < bench_keys; ++i )
+			indexed_map.RemoveSecond( i );
+		BenchmarkReport( "RemoveSecond, reverse index", timer.GetSeconds(), bench_keys );
+
+		test_assert( new_map.Empty() && indexed_map.Empty() && old_map.myMap.empty() );
+	}
+
+	test_logger << "CMultiKeyVector vs. std::map + std::vector" << std::endl;
+
+	// attribute style usage, a handful of keys per node
+	{
+		const int attributes = 8;
+		const int nodes = 20000;
+
+		CBenchmarkTimer timer;
+		for( int n = 0; n < nodes; ++n )
+		{
+			OldMultiKeyVector< std::string, int > old_vector;
+			for( int i = 0; i < attributes; ++i )
+				old_vector.Insert( names[ i ], i );
+			for( int i = 0; i < attributes; ++i )
+				if( old_vector.HasKey( names[ i ] ) ) checksum += old_vector[ names[ i ] ];
+		}
+		BenchmarkReport( "insert + lookup, old", timer.GetSeconds(), nodes * attributes );
+
+		timer.Reset();
+		for( int n = 0; n < nodes; ++n )
+		{
+			CMultiKeyVector< std::string, int > new_vector;
+			for( int i = 0; i < attributes; ++i )
+				new_vector.Insert( names[ i ], i );
+			for( int i = 0; i < attributes; ++i )
+				if( new_vector.HasKey( names[ i ] ) ) checksum += new_vector[ names[ i ] ];
+		}
+		BenchmarkReport( "insert + lookup, new", timer.GetSeconds(), nodes * attributes );
+	}
+
+	test_logger << "  (checksum " << checksum << ")" << std::endl;
+	return 0;
+}
+
+BENCHMARK_REGISTER( CMapHelperBenchmark );
+
+} // end of namespace test
+} // end of namespace ceng
+
+#endif
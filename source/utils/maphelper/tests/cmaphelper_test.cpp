@@ -156,6 +156,26 @@ int CMapHelperExample()
 		test_assert( test.Find( 1 ) == false );
 	}
 
+	// RemoveSecond with the reverse index
+	{
+		CMapHelper< int, int, std::less< int >, true > test;
+		test.Insert( 1, 1 );
+		test.Insert( 1, 2 );
+		test.Insert( 2, 1 );
+		test.Insert( 3, 3 );
+
+		test.RemoveSecond( 1 );
+
+		test_assert( test.Find( 1 ) == true );
+		test_assert( test.Find( 2 ) == false );
+		test_assert( test.Get( 1 ).size() == 1 );
+
+		test.RemoveSecond( 2 );
+		test.RemoveSecond( 3 );
+
+		test_assert( test.Empty() == true );
+	}
+
 	return 0;
 }
 
@@ -0,0 +1,492 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include "callocationtracker.h"
+
+#include <stdlib.h>
+#include <new>
+
+#include "../debug.h"
+
+#if defined(_MSC_VER)
+#	include <intrin.h>
+#	define CENG_THREAD_LOCAL __declspec( thread )
+#else
+#	define CENG_THREAD_LOCAL __thread
+#endif
+
+// the exception specifications of the replaced new and delete have to match
+// <new>, throw( std::bad_alloc ) is gone from C++17 on. MSVC only tells the
+// real version in _MSVC_LANG
+#if __cplusplus >= 201103L || ( defined(_MSVC_LANG) && _MSVC_LANG >= 201103L )
+#	define CENG_NEW_THROWS noexcept( false )
+#	define CENG_NEW_NOTHROW noexcept
+#else
+#	define CENG_NEW_THROWS
+#	define CENG_NEW_NOTHROW throw()
+#endif
+
+namespace ceng {
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+	// everything in here has to work before the static constructors have run,
+	// so it's all plain data that starts as zero
+
+	struct Counters
+	{
+		volatile std::size_t allocations;
+		volatile std::size_t frees;
+		volatile std::size_t bytes_allocated;
+		volatile std::size_t bytes_freed;
+		volatile std::size_t live_bytes;
+		volatile std::size_t peak_bytes;
+		volatile std::size_t frame_peak_bytes;
+	};
+
+	Counters tag_counters[ ALLOCATION_TAG_COUNT ];
+	Counters total_counters;
+
+	CENG_THREAD_LOCAL int current_tag;
+	CENG_THREAD_LOCAL std::size_t thread_allocations;
+
+	CAllocationStats frame_start[ ALLOCATION_TAG_COUNT + 1 ];
+	CAllocationFrameReport last_report;
+	CAllocationTracker::FrameReportCallback report_callback;
+	void* report_userdata;
+
+	// in front of every block, keeps the 16 byte alignment of malloc
+	struct BlockHeader
+	{
+		std::size_t		size;
+		unsigned int	tag;
+		unsigned int	magic;
+	};
+
+	enum { header_size = 16 };
+	const unsigned int block_magic = 0xA110CA7E;
+	// has the offset back to the start of the malloc'd block in front of the
+	// header
+	const unsigned int aligned_block_magic = 0xA110CA7F;
+
+	const char* tag_names[ ALLOCATION_TAG_COUNT ] = 
+	{
+		"other",
+		"render",
+		"ui",
+		"tween",
+		"network",
+		"xml"
+	};
+
+	//-------------------------------------------------------------------------
+
+	inline std::size_t AtomicAdd( volatile std::size_t* value, std::size_t amount )
+	{
+#if defined(_MSC_VER) && defined(_WIN64)
+		return (std::size_t)_InterlockedExchangeAdd64( (volatile __int64*)value, (__int64)amount ) + amount;
+#elif defined(_MSC_VER)
+		return (std::size_t)_InterlockedExchangeAdd( (volatile long*)value, (long)amount ) + amount;
+#else
+		return __sync_add_and_fetch( value, amount );
+#endif
+	}
+
+	inline void AtomicMax( volatile std::size_t* value, std::size_t candidate )
+	{
+		std::size_t current = *value;
+		while( candidate > current )
+		{
+#if defined(_MSC_VER) && defined(_WIN64)
+			const std::size_t before = (std::size_t)_InterlockedCompareExchange64( (volatile __int64*)value, (__int64)candidate, (__int64)current );
+#elif defined(_MSC_VER)
+			const std::size_t before = (std::size_t)_InterlockedCompareExchange( (volatile long*)value, (long)candidate, (long)current );
+#else
+			const std::size_t before = __sync_val_compare_and_swap( value, current, candidate );
+#endif
+			if( before == current )
+				break;
+			current = before;
+		}
+	}
+
+	void CountAllocation( Counters& counters, std::size_t size )
+	{
+		AtomicAdd( &counters.allocations, 1 );
+		AtomicAdd( &counters.bytes_allocated, size );
+		const std::size_t live = AtomicAdd( &counters.live_bytes, size );
+		AtomicMax( &counters.peak_bytes, live );
+		AtomicMax( &counters.frame_peak_bytes, live );
+	}
+
+	void CountFree( Counters& counters, std::size_t size )
+	{
+		AtomicAdd( &counters.frees, 1 );
+		AtomicAdd( &counters.bytes_freed, size );
+		AtomicAdd( &counters.live_bytes, (std::size_t)0 - size );
+	}
+
+	// fills in the header in front of the memory and counts it
+	void* StartBlock( char* memory, std::size_t size, unsigned int magic )
+	{
+		const unsigned int tag = (unsigned int)current_tag;
+
+		BlockHeader* header = (BlockHeader*)( memory - header_size );
+		header->size = size;
+		header->tag = tag;
+		header->magic = magic;
+
+		thread_allocations++;
+		CountAllocation( tag_counters[ tag ], size );
+		CountAllocation( total_counters, size );
+
+		return memory;
+	}
+
+	CAllocationStats ReadCounters( const Counters& counters )
+	{
+		CAllocationStats result;
+		result.allocations = counters.allocations;
+		result.frees = counters.frees;
+		result.bytes_allocated = counters.bytes_allocated;
+		result.bytes_freed = counters.bytes_freed;
+		result.live_bytes = counters.live_bytes;
+		result.live_allocations = result.allocations - result.frees;
+		result.peak_bytes = counters.peak_bytes;
+		return result;
+	}
+
+	CAllocationStats FrameDelta( Counters& counters, CAllocationStats& start )
+	{
+		const CAllocationStats now = ReadCounters( counters );
+
+		CAllocationStats result = now;
+		result.allocations -= start.allocations;
+		result.frees -= start.frees;
+		result.bytes_allocated -= start.bytes_allocated;
+		result.bytes_freed -= start.bytes_freed;
+		result.peak_bytes = counters.frame_peak_bytes;
+
+		counters.frame_peak_bytes = now.live_bytes;
+		start = now;
+		return result;
+	}
+
+} // end of anonymous namespace
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool CAllocationTracker::IsHooked()
+{
+#ifdef CENG_ALLOCATION_TRACKER_ENABLED
+	return true;
+#else
+	return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void* CAllocationTracker::Allocate( std::size_t size )
+{
+	char* memory = (char*)malloc( size + header_size );
+	if( memory == NULL )
+		return NULL;
+
+	return StartBlock( memory + header_size, size, block_magic );
+}
+
+void* CAllocationTracker::Allocate( std::size_t size, std::size_t alignment )
+{
+	cassert( alignment > 0 && ( alignment & ( alignment - 1 ) ) == 0 );
+
+	// malloc already gives this much
+	if( alignment <= header_size )
+		return Allocate( size );
+
+	const std::size_t extra = header_size + sizeof( std::size_t ) + alignment - 1;
+	char* memory = (char*)malloc( size + extra );
+	if( memory == NULL )
+		return NULL;
+
+	const std::size_t start = (std::size_t)memory + header_size + sizeof( std::size_t );
+	char* result = (char*)( ( start + alignment - 1 ) & ~( alignment - 1 ) );
+
+	std::size_t* offset = (std::size_t*)( result - header_size ) - 1;
+	*offset = (std::size_t)( result - memory );
+
+	return StartBlock( result, size, aligned_block_magic );
+}
+
+void CAllocationTracker::Free( void* pointer )
+{
+	if( pointer == NULL )
+		return;
+
+	BlockHeader* header = (BlockHeader*)( (char*)pointer - header_size );
+
+	// wasn't allocated through here, or was freed twice
+	cassert( header->magic == block_magic || header->magic == aligned_block_magic );
+	const bool aligned = header->magic == aligned_block_magic;
+	header->magic = 0;
+
+	CountFree( tag_counters[ header->tag ], header->size );
+	CountFree( total_counters, header->size );
+
+	if( aligned )
+		free( (char*)pointer - *( (std::size_t*)header - 1 ) );
+	else
+		free( header );
+}
+
+//-----------------------------------------------------------------------------
+
+int CAllocationTracker::GetCurrentTag()
+{
+	return current_tag;
+}
+
+void CAllocationTracker::SetCurrentTag( int tag )
+{
+	cassert( tag >= 0 && tag < ALLOCATION_TAG_COUNT );
+	current_tag = tag;
+}
+
+const char* CAllocationTracker::GetTagName( int tag )
+{
+	cassert( tag >= 0 && tag < ALLOCATION_TAG_COUNT );
+	return tag_names[ tag ];
+}
+
+//-----------------------------------------------------------------------------
+
+CAllocationStats CAllocationTracker::GetStats( int tag )
+{
+	cassert( tag >= 0 && tag < ALLOCATION_TAG_COUNT );
+	return ReadCounters( tag_counters[ tag ] );
+}
+
+CAllocationStats CAllocationTracker::GetTotalStats()
+{
+	return ReadCounters( total_counters );
+}
+
+std::size_t CAllocationTracker::GetThreadAllocations()
+{
+	return thread_allocations;
+}
+
+void CAllocationTracker::ResetPeaks()
+{
+	for( int i = 0; i < ALLOCATION_TAG_COUNT; ++i )
+		tag_counters[ i ].peak_bytes = tag_counters[ i ].live_bytes;
+
+	total_counters.peak_bytes = total_counters.live_bytes;
+}
+
+//-----------------------------------------------------------------------------
+
+void CAllocationTracker::SetFrameReportCallback( FrameReportCallback callback, void* userdata )
+{
+	report_callback = callback;
+	report_userdata = userdata;
+}
+
+void CAllocationTracker::EndFrame()
+{
+	last_report.frame++;
+	for( int i = 0; i < ALLOCATION_TAG_COUNT; ++i )
+		last_report.tags[ i ] = FrameDelta( tag_counters[ i ], frame_start[ i ] );
+	last_report.total = FrameDelta( total_counters, frame_start[ ALLOCATION_TAG_COUNT ] );
+
+	if( report_callback )
+		report_callback( last_report, report_userdata );
+}
+
+const CAllocationFrameReport& CAllocationTracker::GetLastFrameReport()
+{
+	return last_report;
+}
+
+//-----------------------------------------------------------------------------
+
+void CAllocationTracker::LogFrameReport( const CAllocationFrameReport& report, void* /*userdata*/ )
+{
+	if( report.total.allocations == 0 && report.total.frees == 0 )
+		return;
+
+	logger << "Frame " << report.frame << " allocations: " << report.total.allocations 
+		<< " (" << report.total.bytes_allocated << " bytes), frees: " << report.total.frees 
+		<< ", live: " << report.total.live_bytes << " bytes" << std::endl;
+
+	for( int i = 0; i < ALLOCATION_TAG_COUNT; ++i )
+	{
+		const CAllocationStats& stats = report.tags[ i ];
+		if( stats.allocations == 0 && stats.frees == 0 )
+			continue;
+
+		logger << "  " << tag_names[ i ] << ": " << stats.allocations 
+			<< " (" << stats.bytes_allocated << " bytes), frees: " << stats.frees
+			<< ", live: " << stats.live_bytes << ", peak: " << stats.peak_bytes << std::endl;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+CNoAllocationsScope::~CNoAllocationsScope()
+{
+	cassert( GetAllocations() == 0 );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // end o namespace ceng
+
+//=============================================================================
+
+#ifdef CENG_ALLOCATION_TRACKER_ENABLED
+
+void* operator new( std::size_t size ) CENG_NEW_THROWS
+{
+	void* result = ceng::CAllocationTracker::Allocate( size );
+	if( result == NULL )
+		throw std::bad_alloc();
+	return result;
+}
+
+void* operator new[]( std::size_t size ) CENG_NEW_THROWS
+{
+	void* result = ceng::CAllocationTracker::Allocate( size );
+	if( result == NULL )
+		throw std::bad_alloc();
+	return result;
+}
+
+void* operator new( std::size_t size, const std::nothrow_t& ) CENG_NEW_NOTHROW
+{
+	return ceng::CAllocationTracker::Allocate( size );
+}
+
+void* operator new[]( std::size_t size, const std::nothrow_t& ) CENG_NEW_NOTHROW
+{
+	return ceng::CAllocationTracker::Allocate( size );
+}
+
+void operator delete( void* pointer ) CENG_NEW_NOTHROW
+{
+	ceng::CAllocationTracker::Free( pointer );
+}
+
+void operator delete[]( void* pointer ) CENG_NEW_NOTHROW
+{
+	ceng::CAllocationTracker::Free( pointer );
+}
+
+void operator delete( void* pointer, const std::nothrow_t& ) CENG_NEW_NOTHROW
+{
+	ceng::CAllocationTracker::Free( pointer );
+}
+
+void operator delete[]( void* pointer, const std::nothrow_t& ) CENG_NEW_NOTHROW
+{
+	ceng::CAllocationTracker::Free( pointer );
+}
+
+// the sized versions would call the ones above anyway, but gcc wants them
+#ifdef __cpp_sized_deallocation
+
+void operator delete( void* pointer, std::size_t ) CENG_NEW_NOTHROW
+{
+	ceng::CAllocationTracker::Free( pointer );
+}
+
+void operator delete[]( void* pointer, std::size_t ) CENG_NEW_NOTHROW
+{
+	ceng::CAllocationTracker::Free( pointer );
+}
+
+#endif
+
+// C++17 types with alignas bigger than 16 get these
+#ifdef __cpp_aligned_new
+
+void* operator new( std::size_t size, std::align_val_t alignment ) CENG_NEW_THROWS
+{
+	void* result = ceng::CAllocationTracker::Allocate( size, (std::size_t)alignment );
+	if( result == NULL )
+		throw std::bad_alloc();
+	return result;
+}
+
+void* operator new[]( std::size_t size, std::align_val_t alignment ) CENG_NEW_THROWS
+{
+	void* result = ceng::CAllocationTracker::Allocate( size, (std::size_t)alignment );
+	if( result == NULL )
+		throw std::bad_alloc();
+	return result;
+}
+
+void* operator new( std::size_t size, std::align_val_t alignment, const std::nothrow_t& ) CENG_NEW_NOTHROW
+{
+	return ceng::CAllocationTracker::Allocate( size, (std::size_t)alignment );
+}
+
+void* operator new[]( std::size_t size, std::align_val_t alignment, const std::nothrow_t& ) CENG_NEW_NOTHROW
+{
+	return ceng::CAllocationTracker::Allocate( size, (std::size_t)alignment );
+}
+
+void operator delete( void* pointer, std::align_val_t ) CENG_NEW_NOTHROW
+{
+	ceng::CAllocationTracker::Free( pointer );
+}
+
+void operator delete[]( void* pointer, std::align_val_t ) CENG_NEW_NOTHROW
+{
+	ceng::CAllocationTracker::Free( pointer );
+}
+
+void operator delete( void* pointer, std::size_t, std::align_val_t ) CENG_NEW_NOTHROW
+{
+	ceng::CAllocationTracker::Free( pointer );
+}
+
+void operator delete[]( void* pointer, std::size_t, std::align_val_t ) CENG_NEW_NOTHROW
+{
+	ceng::CAllocationTracker::Free( pointer );
+}
+
+void operator delete( void* pointer, std::align_val_t, const std::nothrow_t& ) CENG_NEW_NOTHROW
+{
+	ceng::CAllocationTracker::Free( pointer );
+}
+
+void operator delete[]( void* pointer, std::align_val_t, const std::nothrow_t& ) CENG_NEW_NOTHROW
+{
+	ceng::CAllocationTracker::Free( pointer );
+}
+
+#endif
+
+#endif
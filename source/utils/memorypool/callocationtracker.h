@@ -0,0 +1,191 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CAllocationTracker
+// ==================
+//
+// Counts the allocations and the bytes of every subsystem. Opt in by 
+// defining CENG_ALLOCATION_TRACKER_ENABLED, which replaces the global new and
+// delete with ones that go through the tracker. Without it the tag and check
+// macros compile to nothing and only the memory given out by Allocate() 
+// directly is counted.
+//
+// The allocations are counted for the tag that's current on the allocating
+// thread, set with CENG_ALLOCATION_TAG( ALLOCATION_TAG_XXX ) for the rest of
+// the scope. Frees are counted for the tag the memory was allocated with.
+//
+// EndFrame() should be called once a frame from the main loop (the desktop 
+// platform does it), it works out what happened during the frame and gives
+// it to the callback set with SetFrameReportCallback().
+//
+// CENG_ASSERT_NO_ALLOCATIONS() asserts that the rest of the scope doesn't 
+// allocate anything on this thread. Tests can use CAllocationCounter to get
+// the count instead.
+//
+// Objects with their own operator new (CMemoryPoolObject and the like) don't
+// go through the global one, so they aren't counted. From C++17 on the
+// aligned new and delete are replaced as well.
+//
+//.............................................................................
+//=============================================================================
+#ifndef INC_CALLOCATIONTRACKER_H
+#define INC_CALLOCATIONTRACKER_H
+
+#include <cstddef>
+
+#include "../ceng_macro.h"
+
+namespace ceng {
+
+enum AllocationTag
+{
+	ALLOCATION_TAG_OTHER = 0,
+	ALLOCATION_TAG_RENDER,
+	ALLOCATION_TAG_UI,
+	ALLOCATION_TAG_TWEEN,
+	ALLOCATION_TAG_NETWORK,
+	ALLOCATION_TAG_XML,
+
+	ALLOCATION_TAG_COUNT
+};
+
+//-----------------------------------------------------------------------------
+
+struct CAllocationStats
+{
+	CAllocationStats() :
+		allocations( 0 ),
+		frees( 0 ),
+		bytes_allocated( 0 ),
+		bytes_freed( 0 ),
+		live_allocations( 0 ),
+		live_bytes( 0 ),
+		peak_bytes( 0 )
+	{
+	}
+
+	std::size_t allocations;
+	std::size_t frees;
+	std::size_t bytes_allocated;
+	std::size_t bytes_freed;
+
+	std::size_t live_allocations;
+	std::size_t live_bytes;
+	std::size_t peak_bytes;
+};
+
+//! What happened during one frame. The allocations, frees and the bytes are
+//! for the frame, the live numbers are at the end of it and the peak is the
+//! highest the live bytes went during the frame.
+struct CAllocationFrameReport
+{
+	CAllocationFrameReport() : frame( 0 ) { }
+
+	int					frame;
+	CAllocationStats	tags[ ALLOCATION_TAG_COUNT ];
+	CAllocationStats	total;
+};
+
+//-----------------------------------------------------------------------------
+
+class CAllocationTracker
+{
+public:
+	//! true if the global new and delete go through the tracker
+	static bool			IsHooked();
+
+	//! malloc with the bookkeeping, returns NULL if malloc does
+	static void*		Allocate( std::size_t size );
+	//! alignment has to be a power of two, the memory is freed with Free()
+	static void*		Allocate( std::size_t size, std::size_t alignment );
+	static void			Free( void* pointer );
+
+	static int			GetCurrentTag();
+	static void			SetCurrentTag( int tag );
+	static const char*	GetTagName( int tag );
+
+	static CAllocationStats	GetStats( int tag );
+	static CAllocationStats	GetTotalStats();
+
+	//! how many allocations the calling thread has done
+	static std::size_t	GetThreadAllocations();
+
+	//! starts the peaks from the current live bytes
+	static void			ResetPeaks();
+
+	//.........................................................................
+
+	typedef void (*FrameReportCallback)( const CAllocationFrameReport& report, void* userdata );
+
+	static void			SetFrameReportCallback( FrameReportCallback callback, void* userdata );
+	static void			EndFrame();
+	static const CAllocationFrameReport& GetLastFrameReport();
+
+	//! a FrameReportCallback that logs the tags that did something
+	static void			LogFrameReport( const CAllocationFrameReport& report, void* userdata );
+};
+
+//-----------------------------------------------------------------------------
+
+class CAllocationTagScope
+{
+public:
+	explicit CAllocationTagScope( int tag ) : myPrevious( CAllocationTracker::GetCurrentTag() ) { CAllocationTracker::SetCurrentTag( tag ); }
+	~CAllocationTagScope() { CAllocationTracker::SetCurrentTag( myPrevious ); }
+
+private:
+	int myPrevious;
+};
+
+//! counts the allocations this thread makes while it's around
+class CAllocationCounter
+{
+public:
+	CAllocationCounter() : myStart( CAllocationTracker::GetThreadAllocations() ) { }
+
+	std::size_t GetAllocations() const { return CAllocationTracker::GetThreadAllocations() - myStart; }
+
+private:
+	std::size_t myStart;
+};
+
+class CNoAllocationsScope : public CAllocationCounter
+{
+public:
+	~CNoAllocationsScope();
+};
+
+} // end o namespace ceng
+
+//-----------------------------------------------------------------------------
+
+#ifdef CENG_ALLOCATION_TRACKER_ENABLED
+#	define CENG_ALLOCATION_TAG( tag ) ceng::CAllocationTagScope CENG_Join( ceng_allocation_tag_, __LINE__ )( tag )
+#	define CENG_ASSERT_NO_ALLOCATIONS() ceng::CNoAllocationsScope CENG_Join( ceng_no_allocations_, __LINE__ )
+#else
+#	define CENG_ALLOCATION_TAG( tag )
+#	define CENG_ASSERT_NO_ALLOCATIONS()
+#endif
+
+#endif
@@ -35,6 +35,7 @@
 //#include <malloc.h>
 #include <vector>
 #include "../singleton/csingletonptr.h"
+#include "csizeclassallocator.h"
 
 namespace ceng {
 
@@ -307,7 +308,41 @@ public:
 
 //----------------------------------------------------------------------------------
 
-template< class T, size_type size_o_pool = 50 >
+namespace impl {
+
+	template< class T, size_type size_o_pool, bool thread_safe >
+	struct CMemoryPoolObjectAllocator
+	{
+		static void* GetMem( size_type sizeo )
+		{
+			return ceng::GetSingletonPtr< ceng::CMemoryPoolForObjects< T, size_o_pool > >()->GetMem( sizeo );
+		}
+
+		static void Free( void* pointer, size_type /*sizeo*/ )
+		{
+			ceng::GetSingletonPtr< ceng::CMemoryPoolForObjects< T, size_o_pool > >()->Free( pointer );
+		}
+	};
+
+	template< class T, size_type size_o_pool >
+	struct CMemoryPoolObjectAllocator< T, size_o_pool, true >
+	{
+		static void* GetMem( size_type sizeo )
+		{
+			return ceng::CSizeClassAllocator::GetInstance().Allocate( sizeo );
+		}
+
+		static void Free( void* pointer, size_type sizeo )
+		{
+			ceng::CSizeClassAllocator::GetInstance().Free( pointer, sizeo );
+		}
+	};
+
+} // end o namespace impl
+
+//! Give thread_safe = true to allocate from the CSizeClassAllocator instead
+//! of the per type pools, size_o_pool is ignored then.
+template< class T, size_type size_o_pool = 50, bool thread_safe = false >
 class CMemoryPoolObject
 {
 public:
@@ -315,12 +350,12 @@ public:
 
 	void* operator new( size_type sizeo )
 	{
-		return ceng::GetSingletonPtr< ceng::CMemoryPoolForObjects< T, size_o_pool > >()->GetMem( sizeo );
+		return impl::CMemoryPoolObjectAllocator< T, size_o_pool, thread_safe >::GetMem( sizeo );
 	}
 
-	void operator delete( void* pointer )
+	void operator delete( void* pointer, size_type sizeo )
 	{
-		ceng::GetSingletonPtr< ceng::CMemoryPoolForObjects< T, size_o_pool > >()->Free( pointer );
+		impl::CMemoryPoolObjectAllocator< T, size_o_pool, thread_safe >::Free( pointer, sizeo );
 	}
 };
 
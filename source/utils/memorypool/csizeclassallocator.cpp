@@ -0,0 +1,599 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+#include "csizeclassallocator.h"
+
+#include <stdlib.h>
+#include <SDL.h>
+
+#include "../../poro/platform_defs.h"
+#include "../debug.h"
+
+#ifdef PORO_PLAT_WINDOWS
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#endif
+
+#if defined(_MSC_VER)
+#	include <intrin.h>
+#	define CENG_THREAD_LOCAL __declspec( thread )
+#else
+#	define CENG_THREAD_LOCAL __thread
+#endif
+
+namespace ceng {
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+	// how many empty slabs a size class can hold on to before they're
+	// given back to the OS
+	const unsigned int max_empty_slabs = 2;
+
+	// marks a slab that is being released
+	const unsigned int slab_releasing = 0xFFFFFFFF;
+
+	void* AllocatePages( std::size_t size )
+	{
+#ifdef PORO_PLAT_WINDOWS
+		// VirtualAlloc is aligned to the 64k allocation granularity already
+		return VirtualAlloc( NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+#else
+		// map twice the size and cut off the parts that aren't aligned
+		char* mem = (char*)mmap( NULL, size * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0 );
+		if( mem == MAP_FAILED )
+			return NULL;
+
+		char* aligned = (char*)( ( (std::size_t)mem + size - 1 ) & ~( size - 1 ) );
+		if( aligned != mem )
+			munmap( mem, aligned - mem );
+
+		char* tail = aligned + size;
+		char* mem_end = mem + size * 2;
+		if( tail != mem_end )
+			munmap( tail, mem_end - tail );
+
+		return aligned;
+#endif
+	}
+
+	void FreePages( void* pointer, std::size_t size )
+	{
+#ifdef PORO_PLAT_WINDOWS
+		VirtualFree( pointer, 0, MEM_RELEASE );
+#else
+		munmap( pointer, size );
+#endif
+	}
+
+	unsigned int GetBatchCount( int size_class )
+	{
+		unsigned int result = (unsigned int)( 8192 / CSizeClassAllocator::GetSizeOfClass( size_class ) );
+		if( result < 4 ) result = 4;
+		if( result > 64 ) result = 64;
+		return result;
+	}
+
+	struct CMutexLock
+	{
+		CMutexLock( SDL_mutex* mutex ) : mutex( mutex ) { SDL_mutexP( mutex ); }
+		~CMutexLock() { SDL_mutexV( mutex ); }
+		SDL_mutex* mutex;
+	};
+
+	// the counters of a thread cache are only written by its thread, but
+	// GetStats() reads them from any thread
+	inline void AtomicAdd( volatile std::size_t* value, std::size_t amount )
+	{
+#if defined(_MSC_VER) && defined(_WIN64)
+		_InterlockedExchangeAdd64( (volatile __int64*)value, (__int64)amount );
+#elif defined(_MSC_VER)
+		_InterlockedExchangeAdd( (volatile long*)value, (long)amount );
+#else
+		__sync_add_and_fetch( value, amount );
+#endif
+	}
+
+	inline std::size_t AtomicLoad( volatile std::size_t* value )
+	{
+#if defined(_MSC_VER) && defined(_WIN64)
+		return (std::size_t)_InterlockedCompareExchange64( (volatile __int64*)value, 0, 0 );
+#elif defined(_MSC_VER)
+		return (std::size_t)_InterlockedCompareExchange( (volatile long*)value, 0, 0 );
+#else
+		return __sync_fetch_and_add( value, 0 );
+#endif
+	}
+
+} // end of anonymous namespace
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct CSizeClassAllocator::Block
+{
+	Block* next;
+};
+
+// sits at the start of every slab, the slabs are aligned to SlabSize so the
+// header of a block is found by masking the address
+struct CSizeClassAllocator::Slab
+{
+	Slab*			next;
+	int				size_class;
+
+	// blocks that are out of the central list (in use or in a thread cache)
+	unsigned int	used;
+};
+
+struct CSizeClassAllocator::FreeList
+{
+	FreeList() : head( NULL ), count( 0 ) { }
+
+	void Push( Block* block )
+	{
+		block->next = head;
+		head = block;
+		++count;
+	}
+
+	Block* Pop()
+	{
+		Block* result = head;
+		head = result->next;
+		--count;
+		return result;
+	}
+
+	Block*			head;
+	unsigned int	count;
+};
+
+struct CSizeClassAllocator::ThreadCache
+{
+	ThreadCache() :
+		next( NULL ),
+		in_use( true ),
+		allocations( 0 ),
+		frees( 0 ),
+		large_allocations( 0 ),
+		large_frees( 0 ),
+		refills( 0 ),
+		returns( 0 )
+	{
+	}
+
+	FreeList		lists[ NumSizeClasses ];
+	ThreadCache*	next;
+	bool			in_use;
+
+	// only changed with AtomicAdd() and read with AtomicLoad()
+	volatile std::size_t	allocations;
+	volatile std::size_t	frees;
+	volatile std::size_t	large_allocations;
+	volatile std::size_t	large_frees;
+	volatile std::size_t	refills;
+	volatile std::size_t	returns;
+};
+
+struct CSizeClassAllocator::CentralList
+{
+	CentralList() :
+		mutex( NULL ),
+		free_list(),
+		slabs( NULL ),
+		slab_count( 0 ),
+		empty_slabs( 0 ),
+		blocks_out( 0 ),
+		slabs_allocated( 0 ),
+		slabs_released( 0 )
+	{
+	}
+
+	SDL_mutex*		mutex;
+	FreeList		free_list;
+	Slab*			slabs;
+	unsigned int	slab_count;
+	unsigned int	empty_slabs;
+
+	// blocks in use or in the thread caches
+	std::size_t		blocks_out;
+	std::size_t		slabs_allocated;
+	std::size_t		slabs_released;
+};
+
+namespace {
+	CENG_THREAD_LOCAL void* this_thread_cache = NULL;
+
+	const std::size_t slab_header_size = 32;
+
+	inline std::size_t SlabAddress( void* block )
+	{
+		return (std::size_t)block & ~(std::size_t)( CSizeClassAllocator::SlabSize - 1 );
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+	// leaked on purpose, see the header
+	CSizeClassAllocator* instance = NULL;
+
+	// creates the instance during the static initialization, before any
+	// threads are started
+	struct CreateInstance
+	{
+		CreateInstance() { CSizeClassAllocator::GetInstance(); }
+	} create_instance;
+}
+
+CSizeClassAllocator& CSizeClassAllocator::GetInstance()
+{
+	if( instance == NULL )
+		instance = new CSizeClassAllocator;
+	return *instance;
+}
+
+CSizeClassAllocator::CSizeClassAllocator() :
+	myCentral( NULL ),
+	myThreadCaches( NULL ),
+	myRegistryMutex( NULL )
+{
+	cassert( sizeof( Slab ) <= slab_header_size );
+
+	myCentral = new CentralList[ NumSizeClasses ];
+	for( int i = 0; i < NumSizeClasses; ++i )
+		myCentral[ i ].mutex = SDL_CreateMutex();
+
+	myRegistryMutex = SDL_CreateMutex();
+}
+
+CSizeClassAllocator::~CSizeClassAllocator()
+{
+	for( int i = 0; i < NumSizeClasses; ++i )
+		SDL_DestroyMutex( myCentral[ i ].mutex );
+
+	delete [] myCentral;
+	SDL_DestroyMutex( myRegistryMutex );
+}
+
+//-----------------------------------------------------------------------------
+
+std::size_t CSizeClassAllocator::GetSizeOfClass( int size_class )
+{
+	cassert( size_class >= 0 && size_class < NumSizeClasses );
+
+	// 16 byte steps up to 256, then 64 bytes up to 512 and 128 up to 1024
+	if( size_class < 16 ) return ( size_class + 1 ) * 16;
+	if( size_class < 20 ) return 256 + ( size_class - 15 ) * 64;
+	return 512 + ( size_class - 19 ) * 128;
+}
+
+int CSizeClassAllocator::GetSizeClass( std::size_t size )
+{
+	if( size == 0 ) size = 1;
+
+	if( size <= 256 ) return (int)( ( size + 15 ) / 16 ) - 1;
+	if( size <= 512 ) return 15 + (int)( ( size - 256 + 63 ) / 64 );
+	if( size <= MaxSize ) return 19 + (int)( ( size - 512 + 127 ) / 128 );
+
+	return -1;
+}
+
+//-----------------------------------------------------------------------------
+
+void* CSizeClassAllocator::Allocate( std::size_t size )
+{
+	ThreadCache* cache = GetThreadCache();
+
+	const int size_class = GetSizeClass( size );
+	if( size_class < 0 )
+	{
+		AtomicAdd( &cache->large_allocations, 1 );
+		return malloc( size );
+	}
+
+	FreeList& list = cache->lists[ size_class ];
+	if( list.head == NULL )
+	{
+		Refill( size_class, list );
+		cassert( list.head );
+		if( list.head == NULL )
+			return NULL;
+	}
+
+	AtomicAdd( &cache->allocations, 1 );
+	return list.Pop();
+}
+
+void CSizeClassAllocator::Free( void* pointer, std::size_t size )
+{
+	if( pointer == NULL )
+		return;
+
+	ThreadCache* cache = GetThreadCache();
+
+	const int size_class = GetSizeClass( size );
+	if( size_class < 0 )
+	{
+		AtomicAdd( &cache->large_frees, 1 );
+		free( pointer );
+		return;
+	}
+
+	cassert( ( (Slab*)SlabAddress( pointer ) )->size_class == size_class );
+
+	AtomicAdd( &cache->frees, 1 );
+	FreeList& list = cache->lists[ size_class ];
+	list.Push( (Block*)pointer );
+
+	const unsigned int batch = GetBatchCount( size_class );
+	if( list.count > batch * 2 )
+		Return( size_class, list, batch );
+}
+
+//-----------------------------------------------------------------------------
+
+void CSizeClassAllocator::FlushThreadCache()
+{
+	ThreadCache* cache = (ThreadCache*)this_thread_cache;
+	if( cache == NULL )
+		return;
+
+	for( int i = 0; i < NumSizeClasses; ++i )
+	{
+		if( cache->lists[ i ].count )
+			Return( i, cache->lists[ i ], cache->lists[ i ].count );
+	}
+}
+
+void CSizeClassAllocator::ReleaseThreadCache()
+{
+	ThreadCache* cache = (ThreadCache*)this_thread_cache;
+	if( cache == NULL )
+		return;
+
+	FlushThreadCache();
+
+	CMutexLock lock( myRegistryMutex );
+	cache->in_use = false;
+	this_thread_cache = NULL;
+}
+
+void CSizeClassAllocator::ReleaseFreeMemory()
+{
+	for( int i = 0; i < NumSizeClasses; ++i )
+	{
+		CMutexLock lock( myCentral[ i ].mutex );
+		ReleaseEmptySlabs( i, 0 );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+CSizeClassAllocatorStats CSizeClassAllocator::GetStats() const
+{
+	CSizeClassAllocatorStats result;
+
+	// the free lists of the thread caches belong to their threads, so
+	// they're not looked at, the cached blocks are the ones that are out of
+	// the central lists but not allocated
+	{
+		CMutexLock lock( myRegistryMutex );
+		for( ThreadCache* cache = myThreadCaches; cache; cache = cache->next )
+		{
+			result.allocations			+= AtomicLoad( &cache->allocations );
+			result.frees				+= AtomicLoad( &cache->frees );
+			result.large_allocations	+= AtomicLoad( &cache->large_allocations );
+			result.large_frees			+= AtomicLoad( &cache->large_frees );
+			result.refills				+= AtomicLoad( &cache->refills );
+			result.returns				+= AtomicLoad( &cache->returns );
+
+			if( cache->in_use )
+				result.thread_caches++;
+		}
+	}
+
+	std::size_t blocks_out = 0;
+	for( int i = 0; i < NumSizeClasses; ++i )
+	{
+		CMutexLock lock( myCentral[ i ].mutex );
+		result.slabs_allocated		+= myCentral[ i ].slabs_allocated;
+		result.slabs_released		+= myCentral[ i ].slabs_released;
+		result.slabs_in_use			+= myCentral[ i ].slab_count;
+		result.central_free_blocks	+= myCentral[ i ].free_list.count;
+		blocks_out					+= myCentral[ i ].blocks_out;
+	}
+
+	const std::size_t in_use = result.allocations - result.frees;
+	if( blocks_out > in_use )
+		result.thread_cached_blocks = blocks_out - in_use;
+
+	result.bytes_reserved = result.slabs_in_use * SlabSize;
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+CSizeClassAllocator::ThreadCache* CSizeClassAllocator::GetThreadCache()
+{
+	if( this_thread_cache )
+		return (ThreadCache*)this_thread_cache;
+
+	CMutexLock lock( myRegistryMutex );
+
+	// reuse the cache of a thread that has released its cache
+	ThreadCache* cache = NULL;
+	for( ThreadCache* i = myThreadCaches; i; i = i->next )
+	{
+		if( i->in_use == false )
+		{
+			cache = i;
+			cache->in_use = true;
+			break;
+		}
+	}
+
+	if( cache == NULL )
+	{
+		cache = new ThreadCache;
+		cache->next = myThreadCaches;
+		myThreadCaches = cache;
+	}
+
+	this_thread_cache = cache;
+	return cache;
+}
+
+void CSizeClassAllocator::Refill( int size_class, FreeList& list )
+{
+	const unsigned int batch = GetBatchCount( size_class );
+	CentralList& central = myCentral[ size_class ];
+
+	CMutexLock lock( central.mutex );
+
+	while( list.count < batch )
+	{
+		if( central.free_list.head == NULL && CarveSlab( size_class ) == false )
+			break;
+
+		Block* block = central.free_list.Pop();
+		Slab* slab = (Slab*)SlabAddress( block );
+		if( slab->used == 0 )
+			central.empty_slabs--;
+		slab->used++;
+		central.blocks_out++;
+
+		list.Push( block );
+	}
+
+	AtomicAdd( &( (ThreadCache*)this_thread_cache )->refills, 1 );
+}
+
+void CSizeClassAllocator::Return( int size_class, FreeList& list, unsigned int count )
+{
+	CentralList& central = myCentral[ size_class ];
+
+	CMutexLock lock( central.mutex );
+
+	for( unsigned int i = 0; i < count && list.head; ++i )
+	{
+		Block* block = list.Pop();
+		Slab* slab = (Slab*)SlabAddress( block );
+		cassert( slab->used > 0 );
+		slab->used--;
+		if( slab->used == 0 )
+			central.empty_slabs++;
+		central.blocks_out--;
+
+		central.free_list.Push( block );
+	}
+
+	AtomicAdd( &( (ThreadCache*)this_thread_cache )->returns, 1 );
+
+	if( central.empty_slabs > max_empty_slabs )
+		ReleaseEmptySlabs( size_class, 1 );
+}
+
+// needs the lock of the central list
+bool CSizeClassAllocator::CarveSlab( int size_class )
+{
+	void* memory = AllocatePages( SlabSize );
+	if( memory == NULL )
+		return false;
+
+	CentralList& central = myCentral[ size_class ];
+
+	Slab* slab = (Slab*)memory;
+	slab->size_class = size_class;
+	slab->used = 0;
+	slab->next = central.slabs;
+	central.slabs = slab;
+	central.slab_count++;
+	central.empty_slabs++;
+	central.slabs_allocated++;
+
+	const std::size_t block_size = GetSizeOfClass( size_class );
+	const std::size_t block_count = ( SlabSize - slab_header_size ) / block_size;
+
+	// pushed in reverse so the blocks are handed out in address order
+	char* first = (char*)memory + slab_header_size;
+	for( std::size_t i = block_count; i > 0; --i )
+		central.free_list.Push( (Block*)( first + ( i - 1 ) * block_size ) );
+
+	return true;
+}
+
+// needs the lock of the central list
+void CSizeClassAllocator::ReleaseEmptySlabs( int size_class, unsigned int keep )
+{
+	CentralList& central = myCentral[ size_class ];
+	if( central.empty_slabs <= keep )
+		return;
+
+	unsigned int to_release = central.empty_slabs - keep;
+	for( Slab* slab = central.slabs; slab && to_release; slab = slab->next )
+	{
+		if( slab->used == 0 )
+		{
+			slab->used = slab_releasing;
+			to_release--;
+		}
+	}
+
+	// drop the blocks of those slabs from the free list
+	Block** link = &central.free_list.head;
+	while( *link )
+	{
+		if( ( (Slab*)SlabAddress( *link ) )->used == slab_releasing )
+		{
+			*link = (*link)->next;
+			central.free_list.count--;
+		}
+		else
+		{
+			link = &(*link)->next;
+		}
+	}
+
+	Slab** slab_link = &central.slabs;
+	while( *slab_link )
+	{
+		Slab* slab = *slab_link;
+		if( slab->used == slab_releasing )
+		{
+			*slab_link = slab->next;
+			FreePages( slab, SlabSize );
+			central.slab_count--;
+			central.empty_slabs--;
+			central.slabs_released++;
+		}
+		else
+		{
+			slab_link = &slab->next;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // end o namespace ceng
@@ -0,0 +1,161 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CSizeClassAllocator
+// ===================
+//
+// Thread safe small object allocator. Sizes up to MaxSize are rounded up to
+// one of the size classes, bigger ones go straight to malloc.
+//
+// Every thread has its own cache of free blocks per size class, so the
+// common Allocate / Free doesn't take any locks. When a thread cache runs
+// dry it grabs a batch of blocks from the central free list of that class,
+// and when it has too many it gives a batch back. The central lists are
+// filled by carving 64k slabs that come straight from the OS. Once all the
+// blocks of a slab are back in the central list the slab can be given back
+// to the OS, which happens automatically when too many slabs sit empty, or
+// when ReleaseFreeMemory() is called.
+//
+// Free() needs the size that was passed to Allocate(). Threads that are done
+// with the allocator (loader threads for example) should call
+// ReleaseThreadCache() before they exit, so their blocks and their cache go
+// back to be reused.
+//
+// The instance is never deleted, so objects can be freed from static
+// destructors without worrying about the order.
+//
+//.............................................................................
+//=============================================================================
+#ifndef INC_CSIZECLASSALLOCATOR_H
+#define INC_CSIZECLASSALLOCATOR_H
+
+#include <cstddef>
+
+struct SDL_mutex;
+
+namespace ceng {
+
+//! Numbers for the whole allocator. The counters of the other threads are
+//! read one by one while they keep changing, so the numbers only add up
+//! exactly when the other threads are quiet.
+struct CSizeClassAllocatorStats
+{
+	CSizeClassAllocatorStats() :
+		allocations( 0 ),
+		frees( 0 ),
+		large_allocations( 0 ),
+		large_frees( 0 ),
+		refills( 0 ),
+		returns( 0 ),
+		slabs_allocated( 0 ),
+		slabs_released( 0 ),
+		slabs_in_use( 0 ),
+		bytes_reserved( 0 ),
+		central_free_blocks( 0 ),
+		thread_cached_blocks( 0 ),
+		thread_caches( 0 )
+	{
+	}
+
+	std::size_t allocations;
+	std::size_t frees;
+	std::size_t large_allocations;
+	std::size_t large_frees;
+
+	//! batches moved from the central lists to the thread caches and back
+	std::size_t refills;
+	std::size_t returns;
+
+	std::size_t slabs_allocated;
+	std::size_t slabs_released;
+	std::size_t slabs_in_use;
+	std::size_t bytes_reserved;
+
+	std::size_t central_free_blocks;
+	std::size_t thread_cached_blocks;
+	std::size_t thread_caches;
+};
+
+//-----------------------------------------------------------------------------
+
+class CSizeClassAllocator
+{
+public:
+	enum
+	{
+		MaxSize = 1024,
+		NumSizeClasses = 24,
+		SlabSize = 64 * 1024
+	};
+
+	//! The one and only, created during the static initialization, or by
+	//! the first call if that comes from an earlier static constructor.
+	static CSizeClassAllocator& GetInstance();
+
+	void*	Allocate( std::size_t size );
+	void	Free( void* pointer, std::size_t size );
+
+	//! gives the blocks cached by the calling thread back to the central lists
+	void	FlushThreadCache();
+
+	//! flush and let the next new thread reuse this thread's cache
+	void	ReleaseThreadCache();
+
+	//! returns all the completely free slabs to the OS
+	void	ReleaseFreeMemory();
+
+	CSizeClassAllocatorStats GetStats() const;
+
+	//.........................................................................
+
+	static std::size_t	GetSizeOfClass( int size_class );
+	static int			GetSizeClass( std::size_t size );
+
+private:
+	CSizeClassAllocator();
+	~CSizeClassAllocator();
+
+	struct Block;
+	struct Slab;
+	struct FreeList;
+	struct ThreadCache;
+	struct CentralList;
+
+	ThreadCache*	GetThreadCache();
+	void			Refill( int size_class, FreeList& list );
+	void			Return( int size_class, FreeList& list, unsigned int count );
+	bool			CarveSlab( int size_class );
+	void			ReleaseEmptySlabs( int size_class, unsigned int keep );
+
+	CentralList*	myCentral;
+	ThreadCache*	myThreadCaches;
+	SDL_mutex*		myRegistryMutex;
+
+	// can't be copied
+	CSizeClassAllocator( const CSizeClassAllocator& );
+	CSizeClassAllocator& operator=( const CSizeClassAllocator& );
+};
+
+} // end o namespace ceng
+
+#endif
@@ -0,0 +1,222 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include <vector>
+#include <string.h>
+
+#include "../../debug.h"
+#include "../callocationtracker.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace ceng {
+namespace test {
+
+namespace {
+
+#ifdef __cpp_aligned_new
+	struct alignas( 64 ) AlignedThing
+	{
+		char data[ 100 ];
+	};
+#endif
+
+	int report_calls = 0;
+	CAllocationFrameReport reported;
+
+	void TestReportCallback( const CAllocationFrameReport& report, void* userdata )
+	{
+		report_calls++;
+		reported = report;
+		test_assert( userdata == &report_calls );
+	}
+
+}
+
+int CAllocationTrackerTest()
+{
+	// allocations are counted for the tag that's current, frees for the tag
+	// they were allocated with
+	{
+		const CAllocationStats before_other = CAllocationTracker::GetStats( ALLOCATION_TAG_OTHER );
+		const CAllocationStats before_xml = CAllocationTracker::GetStats( ALLOCATION_TAG_XML );
+		const CAllocationStats before_total = CAllocationTracker::GetTotalStats();
+
+		CAllocationCounter counter;
+
+		void* a = CAllocationTracker::Allocate( 100 );
+		test_assert( a );
+		test_assert( ( (std::size_t)a & 15 ) == 0 );
+		memset( a, 0xAB, 100 );
+
+		void* b = NULL;
+		{
+			CAllocationTagScope scope( ALLOCATION_TAG_XML );
+			test_assert( CAllocationTracker::GetCurrentTag() == ALLOCATION_TAG_XML );
+			b = CAllocationTracker::Allocate( 30 );
+
+			{
+				CAllocationTagScope inner( ALLOCATION_TAG_RENDER );
+				test_assert( CAllocationTracker::GetCurrentTag() == ALLOCATION_TAG_RENDER );
+			}
+			test_assert( CAllocationTracker::GetCurrentTag() == ALLOCATION_TAG_XML );
+
+			// freed under another tag, still counted for "other"
+			CAllocationTracker::Free( a );
+		}
+		test_assert( CAllocationTracker::GetCurrentTag() == ALLOCATION_TAG_OTHER );
+
+		test_assert( counter.GetAllocations() == 2 );
+
+		const CAllocationStats other = CAllocationTracker::GetStats( ALLOCATION_TAG_OTHER );
+		const CAllocationStats xml = CAllocationTracker::GetStats( ALLOCATION_TAG_XML );
+		test_assert( xml.allocations - before_xml.allocations == 1 );
+		test_assert( xml.bytes_allocated - before_xml.bytes_allocated == 30 );
+		test_assert( xml.live_bytes - before_xml.live_bytes == 30 );
+		test_assert( xml.frees == before_xml.frees );
+
+		// with the global new hooked, the test framework allocates too
+		if( CAllocationTracker::IsHooked() == false )
+		{
+			test_assert( other.allocations - before_other.allocations == 1 );
+			test_assert( other.frees - before_other.frees == 1 );
+			test_assert( other.live_bytes == before_other.live_bytes );
+			test_assert( other.peak_bytes >= before_other.live_bytes + 100 );
+		}
+
+		CAllocationTracker::Free( b );
+		test_assert( CAllocationTracker::GetStats( ALLOCATION_TAG_XML ).live_bytes == before_xml.live_bytes );
+		test_assert( CAllocationTracker::GetTotalStats().allocations - before_total.allocations >= 2 );
+
+		CAllocationTracker::Free( NULL );
+
+		// aligned, freed the same way
+		const CAllocationStats before_aligned = CAllocationTracker::GetStats( ALLOCATION_TAG_XML );
+		{
+			CAllocationTagScope scope( ALLOCATION_TAG_XML );
+			void* aligned[ 8 ];
+			for( int i = 0; i < 8; ++i )
+			{
+				aligned[ i ] = CAllocationTracker::Allocate( 10 + i, (std::size_t)32 << ( i % 3 ) );
+				test_assert( aligned[ i ] );
+				test_assert( ( (std::size_t)aligned[ i ] & ( ( (std::size_t)32 << ( i % 3 ) ) - 1 ) ) == 0 );
+				memset( aligned[ i ], 0xAB, 10 + i );
+			}
+			test_assert( CAllocationTracker::GetStats( ALLOCATION_TAG_XML ).live_bytes - before_aligned.live_bytes == 8 * 10 + 28 );
+
+			for( int i = 0; i < 8; ++i )
+				CAllocationTracker::Free( aligned[ i ] );
+
+			CAllocationTracker::Free( CAllocationTracker::Allocate( 10, 8 ) );
+		}
+		test_assert( CAllocationTracker::GetStats( ALLOCATION_TAG_XML ).live_bytes == before_aligned.live_bytes );
+		test_assert( CAllocationTracker::GetStats( ALLOCATION_TAG_XML ).allocations - before_aligned.allocations == 9 );
+
+		test_assert( strcmp( CAllocationTracker::GetTagName( ALLOCATION_TAG_NETWORK ), "network" ) == 0 );
+	}
+
+	// frames
+	{
+		CAllocationTracker::SetFrameReportCallback( TestReportCallback, &report_calls );
+		CAllocationTracker::EndFrame();
+		test_assert( report_calls == 1 );
+
+		void* kept = NULL;
+		{
+			CAllocationTagScope scope( ALLOCATION_TAG_TWEEN );
+			for( int i = 0; i < 10; ++i )
+				CAllocationTracker::Free( CAllocationTracker::Allocate( 64 ) );
+			kept = CAllocationTracker::Allocate( 16 );
+		}
+
+		CAllocationTracker::EndFrame();
+		test_assert( report_calls == 2 );
+		test_assert( reported.frame == CAllocationTracker::GetLastFrameReport().frame );
+
+		const CAllocationStats& tween = reported.tags[ ALLOCATION_TAG_TWEEN ];
+		test_assert( tween.allocations == 11 );
+		test_assert( tween.frees == 10 );
+		test_assert( tween.bytes_allocated == 10 * 64 + 16 );
+		test_assert( tween.peak_bytes >= tween.live_bytes + 48 );
+		test_assert( reported.total.allocations >= 11 );
+
+		// nothing happened in the next one
+		CAllocationTracker::EndFrame();
+		test_assert( reported.tags[ ALLOCATION_TAG_TWEEN ].allocations == 0 );
+		test_assert( reported.tags[ ALLOCATION_TAG_TWEEN ].live_bytes == tween.live_bytes );
+		test_assert( reported.tags[ ALLOCATION_TAG_TWEEN ].peak_bytes == tween.live_bytes );
+
+		CAllocationTracker::Free( kept );
+		CAllocationTracker::SetFrameReportCallback( NULL, NULL );
+		CAllocationTracker::EndFrame();
+		test_assert( report_calls == 3 );
+	}
+
+	// the global new goes through the tracker when it's on
+	if( CAllocationTracker::IsHooked() )
+	{
+		const CAllocationStats before = CAllocationTracker::GetStats( ALLOCATION_TAG_UI );
+		{
+			CENG_ALLOCATION_TAG( ALLOCATION_TAG_UI );
+			std::vector< float > colors( 4, 1.f );
+			int* value = new int( 5 );
+			delete value;
+		}
+		const CAllocationStats after = CAllocationTracker::GetStats( ALLOCATION_TAG_UI );
+		test_assert( after.allocations - before.allocations == 2 );
+		test_assert( after.frees - before.frees == 2 );
+		test_assert( after.live_bytes == before.live_bytes );
+
+		std::vector< float > colors;
+		colors.reserve( 16 );
+		{
+			CAllocationCounter counter;
+			CENG_ASSERT_NO_ALLOCATIONS();
+			for( int i = 0; i < 16; ++i )
+				colors.push_back( (float)i );
+			test_assert( counter.GetAllocations() == 0 );
+		}
+
+		CAllocationCounter counter;
+		colors.push_back( 1.f );
+		test_assert( counter.GetAllocations() == 1 );
+
+#ifdef __cpp_aligned_new
+		{
+			CAllocationCounter aligned_counter;
+			AlignedThing* thing = new AlignedThing;
+			test_assert( ( (std::size_t)thing & 63 ) == 0 );
+			delete thing;
+			test_assert( aligned_counter.GetAllocations() == 1 );
+		}
+#endif
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( CAllocationTrackerTest );
+
+} // end of namespace test
+} // end of namespace ceng
+
+#endif
@@ -0,0 +1,151 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+#include <stdlib.h>
+#include <vector>
+#include <sstream>
+#include <SDL.h>
+
+#include "../../debug.h"
+#include "../../../tester/tester_benchmark.h"
+#include "../cmemorypool.h"
+#include "../csizeclassallocator.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace ceng {
+namespace test {
+
+namespace {
+
+	const int bench_rounds = 2000;
+	const int bench_live_objects = 256;
+
+	// the same made up pattern for every allocator: a bunch of small
+	// objects of mixed sizes, freed in a different order than allocated
+	std::size_t BenchmarkSize( int i ) { return 8 + ( i * 37 ) % 200; }
+
+	int RunMalloc( void* )
+	{
+		void* live[ bench_live_objects ];
+		for( int r = 0; r < bench_rounds; ++r )
+		{
+			for( int i = 0; i < bench_live_objects; ++i )
+				live[ i ] = malloc( BenchmarkSize( i ) );
+			for( int i = 0; i < bench_live_objects; ++i )
+				free( live[ ( i * 7 ) % bench_live_objects ] );
+		}
+		return 0;
+	}
+
+	int RunSizeClass( void* )
+	{
+		CSizeClassAllocator& allocator = CSizeClassAllocator::GetInstance();
+		void* live[ bench_live_objects ];
+		for( int r = 0; r < bench_rounds; ++r )
+		{
+			for( int i = 0; i < bench_live_objects; ++i )
+				live[ i ] = allocator.Allocate( BenchmarkSize( i ) );
+			for( int i = 0; i < bench_live_objects; ++i )
+			{
+				const int j = ( i * 7 ) % bench_live_objects;
+				allocator.Free( live[ j ], BenchmarkSize( j ) );
+			}
+		}
+		allocator.ReleaseThreadCache();
+		return 0;
+	}
+
+	double RunThreads( int (*func)( void* ), int thread_count )
+	{
+		poro::tester::CBenchmarkTimer timer;
+
+		std::vector< SDL_Thread* > threads;
+		for( int i = 0; i < thread_count; ++i )
+			threads.push_back( SDL_CreateThread( func, NULL ) );
+
+		for( int i = 0; i < thread_count; ++i )
+			SDL_WaitThread( threads[ i ], NULL );
+
+		return timer.GetSeconds();
+	}
+
+	// the old pool only works from one thread
+	struct OldPoolObject : public CMemoryPoolObject< OldPoolObject, 1000 > { char data[ 64 ]; };
+	struct NewPoolObject : public CMemoryPoolObject< NewPoolObject, 1000, true > { char data[ 64 ]; };
+
+	template< class T >
+	double RunPoolObjects()
+	{
+		poro::tester::CBenchmarkTimer timer;
+		T* live[ bench_live_objects ];
+		for( int r = 0; r < bench_rounds; ++r )
+		{
+			for( int i = 0; i < bench_live_objects; ++i )
+				live[ i ] = new T;
+			for( int i = 0; i < bench_live_objects; ++i )
+				delete live[ ( i * 7 ) % bench_live_objects ];
+		}
+		return timer.GetSeconds();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int CSizeClassAllocatorBenchmark()
+{
+	const int ops_per_thread = bench_rounds * bench_live_objects;
+
+	// the first call creates the instance, has to be done before the threads
+	CSizeClassAllocator::GetInstance();
+
+	test_logger << "CSizeClassAllocator vs. malloc, alloc + free pairs" << std::endl;
+
+	for( int threads = 1; threads <= 8; threads *= 2 )
+	{
+		std::stringstream name;
+		name << threads << " threads";
+		poro::tester::BenchmarkReport( name.str() + ", malloc", RunThreads( RunMalloc, threads ), ops_per_thread * threads );
+		poro::tester::BenchmarkReport( name.str() + ", size class", RunThreads( RunSizeClass, threads ), ops_per_thread * threads );
+	}
+
+	test_logger << "CMemoryPoolObject, single thread" << std::endl;
+	poro::tester::BenchmarkReport( "CMemoryPoolForObjects", RunPoolObjects< OldPoolObject >(), ops_per_thread );
+	poro::tester::BenchmarkReport( "CSizeClassAllocator", RunPoolObjects< NewPoolObject >(), ops_per_thread );
+
+	CSizeClassAllocator::GetInstance().ReleaseFreeMemory();
+	const CSizeClassAllocatorStats stats = CSizeClassAllocator::GetInstance().GetStats();
+	test_logger << "  allocations: " << stats.allocations
+		<< ", refills: " << stats.refills
+		<< ", returns: " << stats.returns
+		<< ", slabs allocated: " << stats.slabs_allocated
+		<< ", slabs released: " << stats.slabs_released
+		<< ", bytes reserved: " << stats.bytes_reserved << std::endl;
+
+	return 0;
+}
+
+BENCHMARK_REGISTER( CSizeClassAllocatorBenchmark );
+
+} // end of namespace test
+} // end of namespace ceng
+
+#endif
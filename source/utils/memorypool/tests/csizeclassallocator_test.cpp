@@ -0,0 +1,132 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+#include <vector>
+#include <string.h>
+
+#include "../../debug.h"
+#include "../cmemorypool.h"
+#include "../csizeclassallocator.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace ceng {
+namespace test {
+
+namespace {
+
+	class ThreadSafePoolTest : public CMemoryPoolObject< ThreadSafePoolTest, 50, true >
+	{
+	public:
+		ThreadSafePoolTest() : value( 42 ) { memset( data, 0xAB, sizeof( data ) ); }
+		int value;
+		char data[ 100 ];
+	};
+
+}
+
+int CSizeClassAllocatorTest()
+{
+	// size classes
+	{
+		test_assert( CSizeClassAllocator::GetSizeClass( 0 ) == 0 );
+		test_assert( CSizeClassAllocator::GetSizeClass( 1 ) == 0 );
+		test_assert( CSizeClassAllocator::GetSizeClass( 16 ) == 0 );
+		test_assert( CSizeClassAllocator::GetSizeClass( 17 ) == 1 );
+		test_assert( CSizeClassAllocator::GetSizeClass( CSizeClassAllocator::MaxSize + 1 ) == -1 );
+
+		for( std::size_t size = 1; size <= CSizeClassAllocator::MaxSize; ++size )
+		{
+			const int size_class = CSizeClassAllocator::GetSizeClass( size );
+			test_assert( size_class >= 0 && size_class < CSizeClassAllocator::NumSizeClasses );
+			test_assert( CSizeClassAllocator::GetSizeOfClass( size_class ) >= size );
+			if( size_class > 0 )
+				test_assert( CSizeClassAllocator::GetSizeOfClass( size_class - 1 ) < size );
+		}
+
+		test_assert( CSizeClassAllocator::GetSizeOfClass( CSizeClassAllocator::NumSizeClasses - 1 ) == CSizeClassAllocator::MaxSize );
+	}
+
+	// allocations don't overlap and survive going through the central list
+	{
+		CSizeClassAllocator& allocator = CSizeClassAllocator::GetInstance();
+		const CSizeClassAllocatorStats before = allocator.GetStats();
+
+		std::vector< unsigned char* > pointers;
+		for( int i = 0; i < 5000; ++i )
+		{
+			const std::size_t size = 1 + ( i * 7 ) % 300;
+			unsigned char* p = (unsigned char*)allocator.Allocate( size );
+			test_assert( p );
+			test_assert( ( (std::size_t)p & 15 ) == 0 );
+			memset( p, i & 0xFF, size );
+			pointers.push_back( p );
+		}
+
+		for( int i = 0; i < 5000; ++i )
+		{
+			const std::size_t size = 1 + ( i * 7 ) % 300;
+			test_assert( pointers[ i ][ 0 ] == ( i & 0xFF ) );
+			test_assert( pointers[ i ][ size - 1 ] == ( i & 0xFF ) );
+			allocator.Free( pointers[ i ], size );
+		}
+
+		// the big ones go to malloc
+		void* big = allocator.Allocate( 5000 );
+		test_assert( big );
+		allocator.Free( big, 5000 );
+
+		const CSizeClassAllocatorStats after = allocator.GetStats();
+		test_assert( after.allocations - before.allocations == 5000 );
+		test_assert( after.frees - before.frees == 5000 );
+		test_assert( after.large_allocations - before.large_allocations == 1 );
+		test_assert( after.large_frees - before.large_frees == 1 );
+		test_assert( after.thread_cached_blocks > 0 );
+
+		allocator.FlushThreadCache();
+		test_assert( allocator.GetStats().thread_cached_blocks == 0 );
+
+		allocator.ReleaseFreeMemory();
+		test_assert( allocator.GetStats().slabs_released > before.slabs_released );
+	}
+
+	// opting in from CMemoryPoolObject
+	{
+		std::vector< ThreadSafePoolTest* > objects;
+		for( int i = 0; i < 1000; ++i )
+			objects.push_back( new ThreadSafePoolTest );
+
+		for( int i = 0; i < 1000; ++i )
+		{
+			test_assert( objects[ i ]->value == 42 );
+			delete objects[ i ];
+		}
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( CSizeClassAllocatorTest );
+
+} // end of namespace test
+} // end of namespace ceng
+
+#endif
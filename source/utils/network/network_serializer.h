@@ -235,6 +235,92 @@ namespace network_utils
 	};
 
 	//-------------------------------------------------------------------------
+	// Reads straight from memory it doesn't own, like the data of a received
+	// packet, so nothing is copied but the strings. The memory has to stay
+	// around as long as the view is used.
+
+	class CSerialLoaderView : virtual public ISerializer
+	{
+	protected:
+		const char* mData;
+		uint32 mBytesUsed;
+		uint32 mLength;
+		bool mHasOverflowed;
+	public:
+
+		CSerialLoaderView( const char* data, uint32 length ) :
+			mData( data ),
+			mBytesUsed( 0 ),
+			mLength( length ),
+			mHasOverflowed( false )
+		{
+			cassert( mData || mLength == 0 );
+		}
+
+		void Reset()
+		{
+			mBytesUsed = 0;
+			mHasOverflowed = false;
+		}
+
+		void IO( uint8& value )
+		{
+			if( mHasOverflowed ) return; 
+			if( mBytesUsed+1 > mLength ) { mHasOverflowed = true; return; }
+			value = (uint8)mData[ mBytesUsed ];
+			++mBytesUsed;
+		}
+
+		void IO( uint32& value )
+		{
+			if( mHasOverflowed ) return; 
+			if( mBytesUsed + 4 > mLength ) { mHasOverflowed = true; return; }
+			value = ReadUint32( mData + mBytesUsed );
+			mBytesUsed += 4;
+		}
+
+		virtual void IO( int32&	value )
+		{
+			if( mHasOverflowed ) return; 
+			if( mBytesUsed + 4 > mLength ) { mHasOverflowed = true; return; }
+			value = ReadInt32( mData + mBytesUsed );
+			mBytesUsed += 4;
+		}
+
+		void IO( float32& value )
+		{
+			if( mHasOverflowed ) return; 
+			if( mBytesUsed + 4 > mLength ) { mHasOverflowed = true; return; }
+			value = ConvertBits< float32, uint32 >( ReadUint32( mData + mBytesUsed ) );
+			mBytesUsed += 4;
+		}
+			
+		void IO( bool& value )
+		{
+			uint8 v = 0;
+			IO( v );
+			if( mHasOverflowed ) 
+				return; 
+			value = (v != 0)?1:0;
+		}
+
+		void IO( types::ustring& str )
+		{
+			uint32 len = 0;
+			IO( len );
+			if( mHasOverflowed ) return;
+			if( mBytesUsed + len > mLength ) { mHasOverflowed = true; return; }
+			str.assign( mData + mBytesUsed, len );
+			mBytesUsed += len;
+		}
+
+		uint32 GetBytesUsed() const { return mBytesUsed; }
+
+		bool HasOverflowed() const { return mHasOverflowed; }
+		bool IsSaving() const { return false; }
+	};
+
+	//-------------------------------------------------------------------------
 
 
 } // end o namespace network utils
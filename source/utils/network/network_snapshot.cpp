@@ -0,0 +1,460 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+#include "network_snapshot.h"
+
+namespace network_utils
+{
+
+	namespace {
+
+		uint32 ZigZag( int32 value ) { return ( (uint32)value << 1 ) ^ (uint32)( value >> 31 ); }
+		int32 UnZigZag( uint32 value ) { return (int32)( value >> 1 ) ^ -(int32)( value & 1 ); }
+
+		bool ReadByte( const char* data, uint32 length, uint32& position, uint8& value )
+		{
+			if( position + 1 > length )
+				return false;
+			value = (uint8)data[ position ];
+			++position;
+			return true;
+		}
+
+		bool ReadString( const char* data, uint32 length, uint32& position, types::ustring& str )
+		{
+			uint32 size = 0;
+			if( ReadVarUint32( data, length, position, size ) == false )
+				return false;
+			if( size > length - position )
+				return false;
+			str.assign( data + position, size );
+			position += size;
+			return true;
+		}
+
+		void WriteString( const types::ustring& str, types::ustring& out )
+		{
+			WriteVarUint32( (uint32)str.size(), out );
+			out += str;
+		}
+	}
+
+	//-------------------------------------------------------------------------
+
+	void SnapshotFields::Clear()
+	{
+		field_types.clear();
+		values.clear();
+		strings.clear();
+	}
+
+	bool SnapshotFields::operator==( const SnapshotFields& other ) const
+	{
+		return field_types == other.field_types &&
+			values == other.values &&
+			strings == other.strings;
+	}
+
+	//-------------------------------------------------------------------------
+
+	CSnapshotWriter::CSnapshotWriter( SnapshotFields& fields ) :
+		mFields( fields )
+	{
+		mFields.Clear();
+	}
+
+	void CSnapshotWriter::Add( SnapshotFieldType type, uint32 value )
+	{
+		mFields.field_types.push_back( (uint8)type );
+		mFields.values.push_back( value );
+	}
+
+	void CSnapshotWriter::IO( uint8& value )	{ Add( SNAPSHOT_FIELD_UINT8, value ); }
+	void CSnapshotWriter::IO( uint32& value )	{ Add( SNAPSHOT_FIELD_UINT32, value ); }
+	void CSnapshotWriter::IO( int32& value )	{ Add( SNAPSHOT_FIELD_INT32, (uint32)value ); }
+	void CSnapshotWriter::IO( float32& value )	{ Add( SNAPSHOT_FIELD_FLOAT32, ConvertBits< uint32, float32 >( value ) ); }
+	void CSnapshotWriter::IO( bool& value )		{ Add( SNAPSHOT_FIELD_BOOL, value ? 1 : 0 ); }
+
+	void CSnapshotWriter::IO( types::ustring& str )
+	{
+		Add( SNAPSHOT_FIELD_STRING, (uint32)mFields.strings.size() );
+		mFields.strings.push_back( str );
+	}
+
+	//-------------------------------------------------------------------------
+
+	CSnapshotReader::CSnapshotReader( const SnapshotFields& fields ) :
+		mFields( fields ),
+		mPosition( 0 ),
+		mHasOverflowed( false )
+	{
+	}
+
+	bool CSnapshotReader::Next( SnapshotFieldType type, uint32& value )
+	{
+		if( mHasOverflowed )
+			return false;
+
+		if( mPosition >= mFields.GetCount() ||
+			mFields.field_types[ mPosition ] != type )
+		{
+			mHasOverflowed = true;
+			return false;
+		}
+
+		value = mFields.values[ mPosition ];
+		++mPosition;
+		return true;
+	}
+
+	void CSnapshotReader::IO( uint8& value )
+	{
+		uint32 v = 0;
+		if( Next( SNAPSHOT_FIELD_UINT8, v ) )
+			value = (uint8)v;
+	}
+
+	void CSnapshotReader::IO( uint32& value )
+	{
+		uint32 v = 0;
+		if( Next( SNAPSHOT_FIELD_UINT32, v ) )
+			value = v;
+	}
+
+	void CSnapshotReader::IO( int32& value )
+	{
+		uint32 v = 0;
+		if( Next( SNAPSHOT_FIELD_INT32, v ) )
+			value = (int32)v;
+	}
+
+	void CSnapshotReader::IO( float32& value )
+	{
+		uint32 v = 0;
+		if( Next( SNAPSHOT_FIELD_FLOAT32, v ) )
+			value = ConvertBits< float32, uint32 >( v );
+	}
+
+	void CSnapshotReader::IO( bool& value )
+	{
+		uint32 v = 0;
+		if( Next( SNAPSHOT_FIELD_BOOL, v ) )
+			value = ( v != 0 );
+	}
+
+	void CSnapshotReader::IO( types::ustring& str )
+	{
+		uint32 v = 0;
+		if( Next( SNAPSHOT_FIELD_STRING, v ) )
+		{
+			if( v < mFields.strings.size() )
+				str = mFields.strings[ v ];
+			else
+				mHasOverflowed = true;
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// The full fields: the count, the types two to a byte and the values. The
+	// bytes and the bools are a byte, the ints are variable length and the
+	// floats are the four bytes as they are.
+
+	void WriteSnapshotFields( const SnapshotFields& fields, types::ustring& out )
+	{
+		const uint32 count = fields.GetCount();
+		WriteVarUint32( count, out );
+
+		for( uint32 i = 0; i < count; i += 2 )
+		{
+			uint8 packed = fields.field_types[ i ];
+			if( i + 1 < count )
+				packed |= fields.field_types[ i + 1 ] << 4;
+			out += (char)packed;
+		}
+
+		for( uint32 i = 0; i < count; ++i )
+		{
+			const uint32 value = fields.values[ i ];
+			switch( fields.field_types[ i ] )
+			{
+			case SNAPSHOT_FIELD_UINT8:
+			case SNAPSHOT_FIELD_BOOL:
+				out += (char)value;
+				break;
+
+			case SNAPSHOT_FIELD_UINT32:
+				WriteVarUint32( value, out );
+				break;
+
+			case SNAPSHOT_FIELD_INT32:
+				WriteVarUint32( ZigZag( (int32)value ), out );
+				break;
+
+			case SNAPSHOT_FIELD_FLOAT32:
+				out += ConvertUint32ToHex( value );
+				break;
+
+			case SNAPSHOT_FIELD_STRING:
+				WriteString( fields.strings[ value ], out );
+				break;
+
+			default:
+				cassert( false && "Unknown snapshot field type" );
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// The bitmask of the changed fields and the changed values: the ints as
+	// the difference to the baseline and the floats XORed with it. Close
+	// floats share the sign, the exponent and the high bits of the mantissa,
+	// so what's left is a small number.
+
+	bool WriteSnapshotDelta( const SnapshotFields& baseline, const SnapshotFields& fields, types::ustring& out, bool* unchanged )
+	{
+		if( unchanged )
+			*unchanged = false;
+
+		if( fields.HasSameLayout( baseline ) == false )
+			return false;
+
+		const uint32 count = fields.GetCount();
+		const std::size_t mask_start = out.size();
+		out.append( ( count + 7 ) / 8, (char)0 );
+
+		bool changed = false;
+		for( uint32 i = 0; i < count; ++i )
+		{
+			const uint32 value = fields.values[ i ];
+			const uint32 base = baseline.values[ i ];
+			const uint8 type = fields.field_types[ i ];
+
+			if( type == SNAPSHOT_FIELD_STRING )
+			{
+				if( fields.strings[ value ] == baseline.strings[ base ] )
+					continue;
+			}
+			else if( value == base )
+			{
+				continue;
+			}
+
+			changed = true;
+			out[ mask_start + i / 8 ] |= (char)( 1 << ( i % 8 ) );
+
+			switch( type )
+			{
+			case SNAPSHOT_FIELD_UINT8:
+			case SNAPSHOT_FIELD_BOOL:
+				out += (char)value;
+				break;
+
+			case SNAPSHOT_FIELD_UINT32:
+			case SNAPSHOT_FIELD_INT32:
+				WriteVarUint32( ZigZag( (int32)( value - base ) ), out );
+				break;
+
+			case SNAPSHOT_FIELD_FLOAT32:
+				WriteVarUint32( value ^ base, out );
+				break;
+
+			case SNAPSHOT_FIELD_STRING:
+				WriteString( fields.strings[ value ], out );
+				break;
+
+			default:
+				cassert( false && "Unknown snapshot field type" );
+			}
+		}
+
+		if( changed == false )
+		{
+			out.resize( mask_start );
+			if( unchanged )
+				*unchanged = true;
+			return false;
+		}
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------
+
+	bool ReadSnapshotFields( const char* data, uint32 length, uint32& position, SnapshotFields& result )
+	{
+		result.Clear();
+
+		uint32 count = 0;
+		if( ReadVarUint32( data, length, position, count ) == false )
+			return false;
+
+		// every field takes at least half a byte for the type and a byte for
+		// the value, the broken counts don't get to allocate anything
+		if( count > length - position )
+			return false;
+
+		result.field_types.resize( count );
+		for( uint32 i = 0; i < count; i += 2 )
+		{
+			uint8 packed = 0;
+			if( ReadByte( data, length, position, packed ) == false )
+				return false;
+
+			result.field_types[ i ] = packed & 0x0F;
+			if( i + 1 < count )
+				result.field_types[ i + 1 ] = packed >> 4;
+		}
+
+		result.values.resize( count );
+		for( uint32 i = 0; i < count; ++i )
+		{
+			uint32& value = result.values[ i ];
+			uint8 byte = 0;
+			switch( result.field_types[ i ] )
+			{
+			case SNAPSHOT_FIELD_UINT8:
+			case SNAPSHOT_FIELD_BOOL:
+				if( ReadByte( data, length, position, byte ) == false )
+					return false;
+				value = byte;
+				break;
+
+			case SNAPSHOT_FIELD_UINT32:
+				if( ReadVarUint32( data, length, position, value ) == false )
+					return false;
+				break;
+
+			case SNAPSHOT_FIELD_INT32:
+				if( ReadVarUint32( data, length, position, value ) == false )
+					return false;
+				value = (uint32)UnZigZag( value );
+				break;
+
+			case SNAPSHOT_FIELD_FLOAT32:
+				if( position + 4 > length )
+					return false;
+				value = ReadUint32( data + position );
+				position += 4;
+				break;
+
+			case SNAPSHOT_FIELD_STRING:
+				value = (uint32)result.strings.size();
+				result.strings.push_back( types::ustring() );
+				if( ReadString( data, length, position, result.strings.back() ) == false )
+					return false;
+				break;
+
+			default:
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------
+
+	bool ReadSnapshotDelta( const SnapshotFields& baseline, const char* data, uint32 length, uint32& position, SnapshotFields& result )
+	{
+		result = baseline;
+
+		const uint32 count = baseline.GetCount();
+		const uint32 mask_size = ( count + 7 ) / 8;
+		if( position + mask_size > length )
+			return false;
+
+		const char* mask = data + position;
+		position += mask_size;
+
+		for( uint32 i = 0; i < count; ++i )
+		{
+			if( ( mask[ i / 8 ] & ( 1 << ( i % 8 ) ) ) == 0 )
+				continue;
+
+			uint32& value = result.values[ i ];
+			uint32 delta = 0;
+			uint8 byte = 0;
+			switch( result.field_types[ i ] )
+			{
+			case SNAPSHOT_FIELD_UINT8:
+			case SNAPSHOT_FIELD_BOOL:
+				if( ReadByte( data, length, position, byte ) == false )
+					return false;
+				value = byte;
+				break;
+
+			case SNAPSHOT_FIELD_UINT32:
+			case SNAPSHOT_FIELD_INT32:
+				if( ReadVarUint32( data, length, position, delta ) == false )
+					return false;
+				value += (uint32)UnZigZag( delta );
+				break;
+
+			case SNAPSHOT_FIELD_FLOAT32:
+				if( ReadVarUint32( data, length, position, delta ) == false )
+					return false;
+				value ^= delta;
+				break;
+
+			case SNAPSHOT_FIELD_STRING:
+				if( ReadString( data, length, position, result.strings[ value ] ) == false )
+					return false;
+				break;
+
+			default:
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------
+
+	void WriteVarUint32( uint32 value, types::ustring& out )
+	{
+		while( value >= 0x80 )
+		{
+			out += (char)( ( value & 0x7F ) | 0x80 );
+			value >>= 7;
+		}
+		out += (char)value;
+	}
+
+	bool ReadVarUint32( const char* data, uint32 length, uint32& position, uint32& value )
+	{
+		value = 0;
+		for( int shift = 0; shift < 35; shift += 7 )
+		{
+			if( position >= length )
+				return false;
+
+			const uint8 byte = (uint8)data[ position++ ];
+			value |= (uint32)( byte & 0x7F ) << shift;
+			if( ( byte & 0x80 ) == 0 )
+				return true;
+		}
+		return false;
+	}
+
+	//-------------------------------------------------------------------------
+
+} // end o namespace network_utils
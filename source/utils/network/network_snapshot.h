@@ -0,0 +1,146 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+#ifndef INC_NETWORK_SNAPSHOT_H
+#define INC_NETWORK_SNAPSHOT_H
+
+#include "network_serializer.h"
+
+#include <vector>
+
+namespace network_utils
+{
+
+	//-------------------------------------------------------------------------
+	// Snapshots of replicated objects. The object writes itself through the
+	// same BitSerialize( ISerializer* ) as always, but into a CSnapshotWriter
+	// that keeps every field apart, so two versions of the object can be
+	// compared field by field. The versions the other end already has are
+	// the baselines, and against one of those only the fields that changed
+	// are written: a bitmask of the changed fields, then the ints as the
+	// difference to the baseline and the floats XORed with it, both as
+	// variable length ints so small changes take a byte or two.
+	//
+	// The object has to write the same fields in the same order every time
+	// for the deltas to work. When it doesn't (a vector changed its size for
+	// example) the delta can't be written and it goes out in full.
+
+	enum SnapshotFieldType
+	{
+		SNAPSHOT_FIELD_UINT8 = 0,
+		SNAPSHOT_FIELD_UINT32,
+		SNAPSHOT_FIELD_INT32,
+		SNAPSHOT_FIELD_FLOAT32,
+		SNAPSHOT_FIELD_BOOL,
+		SNAPSHOT_FIELD_STRING
+	};
+
+	struct SnapshotFields
+	{
+		void Clear();
+
+		uint32 GetCount() const { return (uint32)field_types.size(); }
+		bool HasSameLayout( const SnapshotFields& other ) const { return field_types == other.field_types; }
+
+		bool operator==( const SnapshotFields& other ) const;
+		bool operator!=( const SnapshotFields& other ) const { return !operator==( other ); }
+
+		// the strings are in their own vector, their value is the index to it
+		std::vector< uint8 >			field_types;
+		std::vector< uint32 >			values;
+		std::vector< types::ustring >	strings;
+	};
+
+	//-------------------------------------------------------------------------
+
+	class CSnapshotWriter : virtual public ISerializer
+	{
+	public:
+		// writes over what's in the fields
+		explicit CSnapshotWriter( SnapshotFields& fields );
+
+		void IO( uint8&		value );
+		void IO( uint32&	value );
+		void IO( int32&		value );
+		void IO( float32&	value );
+		void IO( bool&		value );
+		void IO( types::ustring& str );
+
+		bool HasOverflowed() const { return false; }
+		bool IsSaving() const { return true; }
+
+	private:
+		void Add( SnapshotFieldType type, uint32 value );
+
+		SnapshotFields& mFields;
+	};
+
+	//-------------------------------------------------------------------------
+	// Gives the fields back to the object. Overflows if the object asks for
+	// a field the snapshot doesn't have.
+
+	class CSnapshotReader : virtual public ISerializer
+	{
+	public:
+		explicit CSnapshotReader( const SnapshotFields& fields );
+
+		void IO( uint8&		value );
+		void IO( uint32&	value );
+		void IO( int32&		value );
+		void IO( float32&	value );
+		void IO( bool&		value );
+		void IO( types::ustring& str );
+
+		bool HasOverflowed() const { return mHasOverflowed; }
+		bool IsSaving() const { return false; }
+
+	private:
+		bool Next( SnapshotFieldType type, uint32& value );
+
+		const SnapshotFields&	mFields;
+		uint32					mPosition;
+		bool					mHasOverflowed;
+	};
+
+	//-------------------------------------------------------------------------
+
+	// all of the fields with their types
+	void WriteSnapshotFields( const SnapshotFields& fields, types::ustring& out );
+
+	// The fields that differ from the baseline. Returns false and writes
+	// nothing if the layout isn't the same as the baseline's or if nothing
+	// changed, unchanged is then true for the latter.
+	bool WriteSnapshotDelta( const SnapshotFields& baseline, const SnapshotFields& fields, types::ustring& out, bool* unchanged = NULL );
+
+	// These read from position onwards and move it past what was read. They
+	// return false if the data is broken.
+	bool ReadSnapshotFields( const char* data, uint32 length, uint32& position, SnapshotFields& result );
+	bool ReadSnapshotDelta( const SnapshotFields& baseline, const char* data, uint32 length, uint32& position, SnapshotFields& result );
+
+	// 7 bits a byte, the small ones take a byte
+	void WriteVarUint32( uint32 value, types::ustring& out );
+	bool ReadVarUint32( const char* data, uint32 length, uint32& position, uint32& value );
+
+	//-------------------------------------------------------------------------
+
+} // end o namespace network utils
+
+#endif
@@ -86,6 +86,24 @@ namespace network_utils
 
 	//-------------------------------------------------------------------------
 
+	uint32 ReadUint32( const char* bytes )
+	{
+		cassert( bytes );
+
+		return
+			( (uint32(bytes[ 0 ]) & 0xFF) << 24 ) |
+			( (uint32(bytes[ 1 ]) & 0xFF) << 16 ) |
+			( (uint32(bytes[ 2 ]) & 0xFF) << 8 ) |
+			( (uint32(bytes[ 3 ]) & 0xFF) );
+	}
+
+	int32 ReadInt32( const char* bytes )
+	{
+		return (int32)ReadUint32( bytes );
+	}
+
+	//-------------------------------------------------------------------------
+
 	types::ustring FloatToHexString( float32 value )
 	{
 		return ConvertUint32ToHex( ConvertBits< uint32, float32 >( value ) );
@@ -47,6 +47,10 @@ namespace network_utils
 	types::ustring	FloatToHexString( float32 value );
 	float32			HexStringToFloat( const types::ustring& value );
 
+	// the same big endian layout, read straight from memory
+	uint32			ReadUint32( const char* bytes );
+	int32			ReadInt32( const char* bytes );
+
 	//-------------------------------------------------------------------------
 
 
@@ -0,0 +1,121 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+#include "../network_serializer.h"
+#include "../network_libs.h"
+#include "../../../tester/tester_benchmark.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace network_utils
+{
+namespace test
+{
+//-----------------------------------------------------------------------------
+
+namespace {
+
+	const int bench_messages = 200000;
+
+	// about what a unit update has in it
+	struct BenchMessage
+	{
+		BenchMessage() : id( 0 ), x( 0 ), y( 0 ), angle( 0 ), health( 0 ), alive( false ) { }
+
+		void BitSerialize( ISerializer* serializer )
+		{
+			serializer->IO( id );
+			serializer->IO( x );
+			serializer->IO( y );
+			serializer->IO( angle );
+			serializer->IO( health );
+			serializer->IO( alive );
+		}
+
+		uint32	id;
+		float32	x;
+		float32	y;
+		float32	angle;
+		int32	health;
+		bool	alive;
+	};
+
+}
+
+int NetworkSerializerBenchmark()
+{
+	BenchMessage message;
+	message.id = 1234;
+	message.x = 10.5f;
+	message.y = -3.25f;
+	message.angle = 1.f;
+	message.health = 100;
+	message.alive = true;
+
+	CSerialSaver saver;
+	message.BitSerialize( &saver );
+
+	// the packet as it comes from the transport
+	const types::ustring packet = saver.GetData();
+
+	test_logger << "Decoding a " << packet.size() << " byte message" << std::endl;
+
+	uint32 check = 0;
+
+	// the old way: a string copy of the packet, CSerialLoader copies it
+	// again and every field is a substr
+	{
+		poro::tester::CBenchmarkTimer timer;
+		for( int i = 0; i < bench_messages; ++i )
+		{
+			const types::ustring string_data( packet.data(), packet.size() );
+			CSerialLoader loader( string_data );
+			BenchMessage result;
+			result.BitSerialize( &loader );
+			check += result.id;
+		}
+		poro::tester::BenchmarkReport( "CSerialLoader", timer.GetSeconds(), bench_messages );
+	}
+
+	{
+		poro::tester::CBenchmarkTimer timer;
+		for( int i = 0; i < bench_messages; ++i )
+		{
+			CSerialLoaderView loader( packet.data(), (uint32)packet.size() );
+			BenchMessage result;
+			result.BitSerialize( &loader );
+			check += result.id;
+		}
+		poro::tester::BenchmarkReport( "CSerialLoaderView", timer.GetSeconds(), bench_messages );
+	}
+
+	test_assert( check == 2 * bench_messages * message.id );
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+BENCHMARK_REGISTER( NetworkSerializerBenchmark );
+
+} // end o namespace test
+} // end o namespace network_utils
+
+#endif
@@ -118,6 +118,62 @@ int NetworkSerializerTest()
 
 	}
 
+	// the view reads in place from the middle of a packet
+	{
+		bool			test_bool = true;
+		uint8			test_uint8 = 56;
+		uint32			test_uint32 = 0x12345678;
+		int32			test_int32 = -12345;
+		float32			test_float32 = 12465.4356f;
+		types::ustring	test_ustring( "noob" );
+
+		CSerialSaver saver;
+		saver.IO( test_bool );
+		saver.IO( test_uint8 );
+		saver.IO( test_uint32 );
+		saver.IO( test_int32 );
+		saver.IO( test_float32 );
+		saver.IO( test_ustring );
+
+		types::ustring packet( "xyz" );
+		packet += saver.GetData();
+		packet += "trailing";
+
+		bool			load_bool = false;
+		uint8			load_uint8 = 0;
+		uint32			load_uint32 = 0;
+		int32			load_int32 = 0;
+		float32			load_float32 = 0;
+		types::ustring	load_ustring;
+
+		CSerialLoaderView loader( packet.data() + 3, (uint32)saver.GetData().size() );
+		loader.IO( load_bool );
+		loader.IO( load_uint8 );
+		loader.IO( load_uint32 );
+		loader.IO( load_int32 );
+		loader.IO( load_float32 );
+		loader.IO( load_ustring );
+
+		test_assert( loader.HasOverflowed() == false );
+		test_assert( loader.GetBytesUsed() == saver.GetData().size() );
+		test_assert( test_bool == load_bool );
+		test_assert( test_uint8 == load_uint8 );
+		test_assert( test_uint32 == load_uint32 );
+		test_assert( test_int32 == load_int32 );
+		test_float( test_float32 == load_float32 );
+		test_assert( test_ustring == load_ustring );
+
+		// doesn't read past the end it was given
+		uint32 past_end = 7;
+		loader.IO( past_end );
+		test_assert( loader.HasOverflowed() );
+		test_assert( past_end == 7 );
+
+		loader.Reset();
+		loader.IO( load_bool );
+		test_assert( loader.HasOverflowed() == false && load_bool );
+	}
+
 	return 0;
 }
 
@@ -0,0 +1,219 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+#include "../network_snapshot.h"
+#include "../network_libs.h"
+
+namespace network_utils
+{
+namespace test
+{
+//-----------------------------------------------------------------------------
+
+namespace {
+
+	struct SnapshotTestObject
+	{
+		SnapshotTestObject() : id( 7 ), x( 100.25f ), y( -3.5f ), health( 100 ), state( 2 ), alive( true ), name( "noob" ) { }
+
+		void BitSerialize( ISerializer* serializer )
+		{
+			serializer->IO( id );
+			serializer->IO( x );
+			serializer->IO( y );
+			serializer->IO( health );
+			serializer->IO( state );
+			serializer->IO( alive );
+			serializer->IO( name );
+			serializer->IO( path );
+		}
+
+		uint32					id;
+		float32					x;
+		float32					y;
+		int32					health;
+		uint8					state;
+		bool					alive;
+		types::ustring			name;
+		std::vector< int32 >	path;
+	};
+
+	bool operator==( const SnapshotTestObject& a, const SnapshotTestObject& b )
+	{
+		return a.id == b.id && a.x == b.x && a.y == b.y && a.health == b.health &&
+			a.state == b.state && a.alive == b.alive && a.name == b.name && a.path == b.path;
+	}
+
+	SnapshotFields Capture( SnapshotTestObject& object )
+	{
+		SnapshotFields result;
+		CSnapshotWriter writer( result );
+		object.BitSerialize( &writer );
+		return result;
+	}
+
+}
+
+int NetworkSnapshotTest()
+{
+	// the writer and the reader
+	{
+		SnapshotTestObject object;
+		object.path.push_back( 1 );
+		object.path.push_back( -2 );
+		SnapshotFields fields = Capture( object );
+		test_assert( fields.GetCount() == 10 );
+		test_assert( fields.strings.size() == 1 );
+
+		SnapshotTestObject loaded;
+		loaded.id = 0;
+		loaded.name = "";
+		CSnapshotReader reader( fields );
+		loaded.BitSerialize( &reader );
+		test_assert( reader.HasOverflowed() == false );
+		test_assert( loaded == object );
+
+		// asking for something else than what's there
+		uint8 wrong = 0;
+		CSnapshotReader wrong_reader( fields );
+		wrong_reader.IO( wrong );
+		test_assert( wrong_reader.HasOverflowed() );
+	}
+
+	// variable length ints
+	{
+		const uint32 values[] = { 0, 1, 127, 128, 16383, 16384, 0x7FFFFFFF, 0xFFFFFFFF };
+		types::ustring data;
+		for( int i = 0; i < 8; ++i )
+			WriteVarUint32( values[ i ], data );
+		test_assert( data.size() == 1 + 1 + 1 + 2 + 2 + 3 + 5 + 5 );
+
+		uint32 position = 0;
+		for( int i = 0; i < 8; ++i )
+		{
+			uint32 value = 0;
+			test_assert( ReadVarUint32( data.data(), (uint32)data.size(), position, value ) );
+			test_assert( value == values[ i ] );
+		}
+
+		uint32 value = 0;
+		test_assert( ReadVarUint32( data.data(), (uint32)data.size(), position, value ) == false );
+	}
+
+	// in full
+	{
+		SnapshotTestObject object;
+		object.health = -50;
+		SnapshotFields fields = Capture( object );
+
+		types::ustring data;
+		WriteSnapshotFields( fields, data );
+
+		SnapshotFields loaded;
+		uint32 position = 0;
+		test_assert( ReadSnapshotFields( data.data(), (uint32)data.size(), position, loaded ) );
+		test_assert( position == data.size() );
+		test_assert( loaded == fields );
+
+		// cut short
+		for( uint32 length = 0; length < data.size(); ++length )
+		{
+			position = 0;
+			test_assert( ReadSnapshotFields( data.data(), length, position, loaded ) == false );
+		}
+	}
+
+	// only the changes
+	{
+		SnapshotTestObject object;
+		object.path.push_back( 5 );
+		SnapshotFields baseline = Capture( object );
+
+		object.x += 0.25f;
+		object.health -= 3;
+		object.alive = false;
+		object.name = "pro";
+		object.path[ 0 ] = 4;
+		SnapshotFields fields = Capture( object );
+
+		types::ustring full;
+		WriteSnapshotFields( fields, full );
+
+		types::ustring delta;
+		test_assert( WriteSnapshotDelta( baseline, fields, delta ) );
+		test_assert( delta.size() < full.size() );
+
+		SnapshotFields loaded;
+		uint32 position = 0;
+		test_assert( ReadSnapshotDelta( baseline, delta.data(), (uint32)delta.size(), position, loaded ) );
+		test_assert( position == delta.size() );
+		test_assert( loaded == fields );
+
+		SnapshotTestObject result;
+		CSnapshotReader reader( loaded );
+		result.BitSerialize( &reader );
+		test_assert( result == object );
+
+		// nothing changed, nothing written
+		bool unchanged = false;
+		types::ustring nothing;
+		test_assert( WriteSnapshotDelta( fields, fields, nothing, &unchanged ) == false );
+		test_assert( unchanged );
+		test_assert( nothing.empty() );
+
+		// the vector grew, the delta can't be written
+		object.path.push_back( 6 );
+		SnapshotFields longer = Capture( object );
+		test_assert( WriteSnapshotDelta( fields, longer, nothing, &unchanged ) == false );
+		test_assert( unchanged == false );
+		test_assert( nothing.empty() );
+	}
+
+	// the ints wrap around and the floats can change sign
+	{
+		SnapshotTestObject object;
+		object.id = 0xFFFFFFF0;
+		object.health = 0x7FFFFFFF;
+		object.x = 1.0f;
+		SnapshotFields baseline = Capture( object );
+
+		object.id = 5;
+		object.health = -0x7FFFFFFF;
+		object.x = -1.0e20f;
+		SnapshotFields fields = Capture( object );
+
+		types::ustring delta;
+		test_assert( WriteSnapshotDelta( baseline, fields, delta ) );
+
+		SnapshotFields loaded;
+		uint32 position = 0;
+		test_assert( ReadSnapshotDelta( baseline, delta.data(), (uint32)delta.size(), position, loaded ) );
+		test_assert( loaded == fields );
+	}
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+TEST_REGISTER( NetworkSnapshotTest );
+
+} // end o namespace test
+} // end o namespace network_utils
@@ -19,6 +19,8 @@
  ***************************************************************************/
 
 
+#include <list>
+
 #include "../../debug.h"
 #include "../csmartptr.h"
 #include "../../array2d/carray2d.h"
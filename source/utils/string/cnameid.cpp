@@ -0,0 +1,82 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include "cnameid.h"
+
+namespace ceng {
+
+namespace {
+
+	typedef CFlatHashMap< std::string, CNameId::Entry* > NameTable;
+
+	// never deleted, so names can be used from static destructors
+	NameTable& GetNameTable()
+	{
+		static NameTable* table = new NameTable;
+		return *table;
+	}
+
+} // end of anonymous namespace
+
+//=============================================================================
+
+const CNameId::Entry* CNameId::Intern( const std::string& name )
+{
+	if( name.empty() )
+		return NULL;
+
+	NameTable& table = GetNameTable();
+	Entry** entry = table.FindValue( name );
+	if( entry )
+		return *entry;
+
+	Entry* result = new Entry;
+	result->name = name;
+	result->hash = CHash< std::string >()( name );
+
+	table.Insert( name, result );
+	return result;
+}
+
+CNameId CNameId::Find( const std::string& name )
+{
+	if( name.empty() )
+		return CNameId();
+
+	Entry** entry = GetNameTable().FindValue( name );
+	return entry ? CNameId( *entry ) : CNameId();
+}
+
+unsigned int CNameId::GetInternedCount()
+{
+	return (unsigned int)GetNameTable().Size();
+}
+
+const std::string& CNameId::GetEmptyString()
+{
+	static const std::string empty;
+	return empty;
+}
+
+//=============================================================================
+
+} // end o namespace ceng
@@ -0,0 +1,102 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CNameId
+// =======
+//
+// Interned name. Every different string gets one entry in a global table
+// that also holds its hash, and CNameId is just a pointer to that entry. So
+// comparing two names is comparing two pointers and hashing one is reading
+// the precomputed hash. operator< is there for std::map and orders by the
+// pointer, not alphabetically.
+//
+// The entries are never freed, so this is meant for names that come from
+// data (sprites, animations, sheets), not for arbitrary text.
+//
+// The table is not thread safe. Create the names on the main thread, or
+// before the other threads start.
+//
+// Constructors are explicit, so functions that have both std::string and
+// CNameId overloads can still be called with a string literal.
+//
+//.............................................................................
+//=============================================================================
+#ifndef INC_CNAMEID_H
+#define INC_CNAMEID_H
+
+#include <string>
+
+#include "../maphelper/cflathashmap.h"
+
+namespace ceng {
+
+class CNameId
+{
+public:
+	struct Entry
+	{
+		std::string		name;
+		unsigned int	hash;
+	};
+
+	//! the empty name
+	CNameId() : myEntry( NULL ) { }
+
+	//! interns the name
+	explicit CNameId( const std::string& name ) : myEntry( Intern( name ) ) { }
+	explicit CNameId( const char* name ) : myEntry( Intern( name ) ) { }
+
+	const std::string&	GetString() const	{ return myEntry ? myEntry->name : GetEmptyString(); }
+	unsigned int		GetHash() const		{ return myEntry ? myEntry->hash : 0; }
+	bool				Empty() const		{ return myEntry == NULL; }
+
+	bool operator==( const CNameId& other ) const	{ return myEntry == other.myEntry; }
+	bool operator!=( const CNameId& other ) const	{ return myEntry != other.myEntry; }
+	bool operator<( const CNameId& other ) const	{ return myEntry < other.myEntry; }
+
+	//! returns the empty name if the string hasn't been interned, doesn't add it
+	static CNameId Find( const std::string& name );
+
+	//! how many different names there are
+	static unsigned int GetInternedCount();
+
+private:
+	explicit CNameId( const Entry* entry ) : myEntry( entry ) { }
+
+	static const Entry*			Intern( const std::string& name );
+	static const std::string&	GetEmptyString();
+
+	const Entry* myEntry;
+};
+
+//-----------------------------------------------------------------------------
+
+template<> struct CHash< CNameId >
+{
+	unsigned int operator()( const CNameId& name ) const { return name.GetHash(); }
+};
+
+} // end o namespace ceng
+
+#endif
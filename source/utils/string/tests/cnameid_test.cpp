@@ -0,0 +1,93 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2003 - 2011 Petri Purho
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ***************************************************************************/
+
+
+
+#include <map>
+
+#include "../../debug.h"
+#include "../cnameid.h"
+
+#ifdef CENG_TESTER_ENABLED
+
+namespace ceng {
+namespace test {
+
+int CNameIdTest()
+{
+	// interning
+	{
+		const unsigned int count = CNameId::GetInternedCount();
+
+		CNameId a( "name_id_test_a" );
+		CNameId b( std::string( "name_id_test_" ) + "a" );
+		CNameId c( "name_id_test_c" );
+
+		test_assert( a == b );
+		test_assert( a != c );
+		test_assert( a.GetString() == "name_id_test_a" );
+		test_assert( a.GetHash() == b.GetHash() );
+		test_assert( a.GetHash() == CHash< std::string >()( "name_id_test_a" ) );
+		test_assert( CNameId::GetInternedCount() == count + 2 );
+	}
+
+	// the empty name
+	{
+		CNameId empty;
+		test_assert( empty.Empty() );
+		test_assert( empty.GetString().empty() );
+		test_assert( empty == CNameId( "" ) );
+		test_assert( CNameId( "name_id_test_a" ).Empty() == false );
+	}
+
+	// finding doesn't add
+	{
+		const unsigned int count = CNameId::GetInternedCount();
+		test_assert( CNameId::Find( "name_id_test_never_interned" ).Empty() );
+		test_assert( CNameId::GetInternedCount() == count );
+		test_assert( CNameId::Find( "name_id_test_a" ) == CNameId( "name_id_test_a" ) );
+	}
+
+	// as keys
+	{
+		CFlatHashMap< CNameId, int > hash_map;
+		std::map< CNameId, int > tree_map;
+		for( int i = 0; i < 100; ++i )
+		{
+			CNameId name( "name_id_test_" + std::string( 1, (char)( 'A' + i % 26 ) ) + std::string( 1, (char)( 'A' + i / 26 ) ) );
+			hash_map.Insert( name, i );
+			tree_map[ name ] = i;
+		}
+
+		test_assert( hash_map.Size() == 100 );
+		test_assert( tree_map.size() == 100 );
+		test_assert( *hash_map.FindValue( CNameId( "name_id_test_BA" ) ) == 1 );
+		test_assert( tree_map[ CNameId( "name_id_test_BA" ) ] == 1 );
+	}
+
+	return 0;
+}
+
+TEST_REGISTER( CNameIdTest );
+
+} // end of namespace test
+} // end of namespace ceng
+
+#endif
@@ -38,13 +38,20 @@
 #define INC_CMULTIKEYVECTOR_H
 
 #include <vector>
-#include <map>
+#include <algorithm>
+
+#include "../debug.h"
+#include "../maphelper/cflathashmap.h"
 
 
 namespace ceng {
 
 //! This is a hybrid between a map and vector so you have random access but
 //! you also have to ability to call it with aprourpiate key
+/*!
+	The keys are in a CFlatHashMap that points to the index in the vector, and
+	a parallel vector keeps the key of each index so GetKey() is O(1).
+*/
 template< class Key, class Cont >
 class CMultiKeyVector
 {
@@ -59,9 +66,9 @@ public:
 
 	const Cont& operator[]( const Key& i ) const
 	{
-		typename std::map< Key, unsigned int >::const_iterator j;
-		j = myKeys.find( i );
-		return myData[ j->second ];
+		const unsigned int* j = myKeys.FindValue( i );
+		cassert( j );
+		return myData[ *j ];
 	}
 
 	Cont& operator[] ( unsigned int i )
@@ -71,9 +78,9 @@ public:
 
 	Cont& operator[]( const Key& i )
 	{
-		typename std::map< Key, unsigned int >::const_iterator j;
-		j = myKeys.find( i );
-		return myData[ j->second ];
+		const unsigned int* j = myKeys.FindValue( i );
+		cassert( j );
+		return myData[ *j ];
 	}
 
 	///////////////////////////////////////////////////////////////////////////
@@ -84,22 +91,31 @@ public:
 
 	void Insert( const Key& key, const Cont& data )
 	{
-		myKeys.insert( std::pair< Key, unsigned int >( key, myData.size() ) );
+		// like the std::map this used to be, a duplicate key keeps pointing
+		// to the first one and the new index has no key
+		if( myKeys.Insert( key, (unsigned int)myData.size() ) )
+			myIndexKeys.push_back( key );
+		else
+			myIndexKeys.push_back( Key() );
+
 		myData.push_back( data );
 	}
 
 	///////////////////////////////////////////////////////////////////////////
 
+	//! returns the keys in sorted order
 	std::vector< Key > GetKeys() const
 	{
 		typename std::vector< Key > return_vector;
+		return_vector.reserve( myKeys.Size() );
 
-		typename std::map< Key, unsigned int >::const_iterator i;
-		for ( i = myKeys.begin(); i != myKeys.end(); ++i )
+		typename CFlatHashMap< Key, unsigned int >::ConstIterator i;
+		for ( i = myKeys.Begin(); i != myKeys.End(); ++i )
 		{
 			return_vector.push_back( i->first );
 		}
 
+		std::sort( return_vector.begin(), return_vector.end() );
 		return return_vector;
 	}
 
@@ -107,25 +123,22 @@ public:
 
 	Key GetKey( unsigned int i ) const
 	{
-		typename std::map< Key, unsigned int >::const_iterator j;
-
-		for ( j = myKeys.begin(); j != myKeys.end(); ++j )
-		{
-			if ( j->second == i ) return j->first;
-		}
+		if( i < myIndexKeys.size() )
+			return myIndexKeys[ i ];
 
 		return Key();
 	}
 
 	bool HasKey( const Key& key ) const
 	{
-		return ( myKeys.find( key ) != myKeys.end() );
+		return myKeys.HasKey( key );
 	}
 
 	void Clear()
 	{
 		myData.clear();
-		myKeys.clear();
+		myIndexKeys.clear();
+		myKeys.Clear();
 	}
 
 	///////////////////////////////////////////////////////////////////////////
@@ -133,8 +146,9 @@ public:
 
 private:
 
-	std::vector< Cont >				myData;
-	std::map< Key, unsigned int >	myKeys;
+	std::vector< Cont >						myData;
+	std::vector< Key >						myIndexKeys;
+	CFlatHashMap< Key, unsigned int >		myKeys;
 
 };
 
@@ -139,6 +139,7 @@
 #include "cxmlfilesys.h"
 #include "cxmlnode.h"
 #include "cxmlparser.h"
+#include "../memorypool/callocationtracker.h"
 
 //#define PORO_XCODE_ERROR_HACK_TOGGLE
 
@@ -187,6 +188,8 @@ namespace ceng {
 	inline void XmlSaveToFile( T& mesh, const std::string& file, const std::string& rootnodename  )
 	//void XmlSaveToFile( CPegManager& mesh, const std::string& file, const std::string& rootnodename  )
 	{
+		CENG_ALLOCATION_TAG( ALLOCATION_TAG_XML );
+
 		CXmlNode* node;
 		node = XmlConvertFrom( mesh, rootnodename );
 
@@ -215,6 +218,8 @@ namespace ceng {
 	template< class T >
 	inline void XmlLoadFromFile( T& mesh, const std::string& file, const std::string& rootnodename)
 	{
+		CENG_ALLOCATION_TAG( ALLOCATION_TAG_XML );
+
 		CXmlParser	parser;
 		CXmlHandler handler;
 